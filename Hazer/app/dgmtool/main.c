@@ -22,14 +22,34 @@
  * Although dgmtool is agnostic as to how many sources and sinks are conneected
  * to it, best results are achieved when there is one of each.
  *
+ * Each sink has its own bounded queue and a non-blocking socket, and is
+ * written to as it becomes writable, so that a slow or stalled sink never
+ * holds up the other sinks. The sockets are serviced by an epoll(7) event
+ * loop, so that there can be hundreds of sinks without the cost of each
+ * wakeup growing with their number. When a sink's queue is
+ * full, its oldest datagram is dropped, or, with -L, everything queued
+ * is dropped in favor of the latest datagram.
+ *
+ * A batched datagram from gpstool (-g MASK:BYTES) is unpacked and each of
+ * its frames forwarded as the ordinary datagram it would otherwise have
+ * been; the buffer (-B) must be at least as large as the batches.
+ *
+ * The latest datagram is also saved in an observation file, which is
+ * replaced atomically. Since each replacement is several file system
+ * operations, with -C the file is committed at most once every so many
+ * milliseconds, the latest datagram being held until then, and with -S
+ * the file is synchronized to the storage device only every so many
+ * commits rather than on every commit as it is by default; this spares
+ * the flash storage of small systems.
+ *
  * USAGE
  *
- * dgmtool [ -? ] [ -m ] [ -B BYTES ] [ -F FILE ] [ -M MODE ] [ -T :PORT ] [ -V ] [ -U :PORT ]
+ * dgmtool [ -? ] [ -m ] [ -B BYTES ] [ -C MILLISECONDS ] [ -F FILE ] [ -L ] [ -M MODE ] [ -Q DATAGRAMS ] [ -S COMMITS ] [ -T :PORT ] [ -V ] [ -U :PORT ]
  *
  * EXAMPLES
  *
  * export COM_DIAG_DIMINUTO_LOG_MASK=0xff
- * dgmtool -U :tesoro -T :tesoro -F Observation.txt  &
+ * dgmtool -U :tesoro -T :tesoro -F Observation.txt -C 1000 -S 60 &
  * csvmeter < ./dat/yodel/20200903/vehicle.csv | csv2dgm -j -U localhost:tesoro &
  * socat TCP:localhost:tesoro -
  */
@@ -43,10 +63,10 @@
 #include "com/diag/diminuto/diminuto_ipc4.h"
 #include "com/diag/diminuto/diminuto_ipc6.h"
 #include "com/diag/diminuto/diminuto_log.h"
-#include "com/diag/diminuto/diminuto_mux.h"
 #include "com/diag/diminuto/diminuto_observation.h"
 #include "com/diag/diminuto/diminuto_pipe.h"
 #include "com/diag/diminuto/diminuto_terminator.h"
+#include "com/diag/diminuto/diminuto_time.h"
 #include "com/diag/hazer/hazer_release.h"
 #include "com/diag/hazer/hazer_revision.h"
 #include "com/diag/hazer/hazer_vintage.h"
@@ -62,6 +82,10 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include "com/diag/hazer/datagram.h"
+#include "com/diag/hazer/loop.h"
+#include "com/diag/hazer/observer.h"
+#include "sink.h"
 
 /*******************************************************************************
  * GLOBALS
@@ -72,6 +96,280 @@
  */
 static const char * Program = (const char *)0;
 
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * This is the state the event loop callbacks share.
+ */
+typedef struct Forwarder {
+    loop_t loop;                    /* Must be first. */
+    sink_t ** sink;                 /* Dense array of sinks. */
+    unsigned int sinks;             /* Number of sinks. */
+    unsigned int capacity;          /* Size of the sink array. */
+    unsigned int slots;             /* Datagrams queued per sink. */
+    policy_t policy;                /* Drop policy of each sink. */
+    char * buffer;                  /* Datagram buffer. */
+    ssize_t total;                  /* Size of the datagram buffer. */
+    FILE * fp;                      /* Standard output or NULL. */
+    observer_t * observer;          /* Observation file or NULL. */
+    const char * filename;          /* Observation file name. */
+    diminuto_sticks_t frequency;    /* Ticks per second. */
+    datagram_unpacker_t unpacker;   /* Frames of a batched datagram. */
+} forwarder_t;
+
+/*******************************************************************************
+ * HELPERS
+ ******************************************************************************/
+
+/**
+ * Log the counters and the lag of a sink.
+ * @param sp points to the sink.
+ * @param frequency is the number of ticks per second.
+ * @param now is the current time in ticks.
+ */
+static void report(const sink_t * sp, diminuto_sticks_t frequency, diminuto_sticks_t now)
+{
+    DIMINUTO_LOG_INFORMATION("Sink %d Queued=%llu Written=%llu Dropped=%llu Bytes=%llu Stalls=%llu Deepest=%u/%u\n", sp->fd, (unsigned long long)sp->queued, (unsigned long long)sp->written, (unsigned long long)sp->dropped, (unsigned long long)sp->bytes, (unsigned long long)sp->stalls, sp->deepest, sp->slots);
+    if (sp->written > 0) {
+        DIMINUTO_LOG_INFORMATION("Sink %d Lag Current=%lldus Latest=%lldus Average=%lldus Maximum=%lldus\n", sp->fd, (long long)((sink_lag(sp, now) * 1000000LL) / frequency), (long long)((sp->latest * 1000000LL) / frequency), (long long)(((sp->total / (diminuto_sticks_t)sp->written) * 1000000LL) / frequency), (long long)((sp->longest * 1000000LL) / frequency));
+    }
+}
+
+/**
+ * Close a sink, log its counters, and release it.
+ * @param fwp points to the forwarder.
+ * @param sp points to the sink.
+ * @param now is the current time in ticks.
+ */
+static void dismiss(forwarder_t * fwp, sink_t * sp, diminuto_sticks_t now)
+{
+    unsigned int ii = 0;
+
+    DIMINUTO_LOG_NOTICE("Close %d", sp->fd);
+    report(sp, fwp->frequency, now);
+
+    (void)loop_unregister(&(fwp->loop), sp->fd);
+    (void)diminuto_ipc_close(sp->fd);
+
+    for (ii = 0; ii < fwp->sinks; ++ii) {
+        if (fwp->sink[ii] == sp) {
+            fwp->sink[ii] = fwp->sink[--fwp->sinks];
+            break;
+        }
+    }
+
+    sink_fini(sp);
+    free(sp);
+}
+
+/**
+ * Forward a datagram: write it to standard output, queue it for every
+ * sink, and offer it to the observation file.
+ * @param fwp points to the forwarder.
+ * @param datagram points to the datagram.
+ * @param length is the length of the datagram in bytes.
+ * @param now is the current time in ticks.
+ */
+static void forward(forwarder_t * fwp, const void * datagram, size_t length, diminuto_sticks_t now)
+{
+    sink_t * sp = (sink_t *)0;
+    ssize_t sent = 0;
+    size_t written = 0;
+    unsigned int dropped = 0;
+    unsigned int ii = 0;
+    int committed = 0;
+    int pending = 0;
+
+    if (fwp->fp == (FILE *)0) {
+        /* Do nothing. */
+    } else if ((written = fwrite(datagram, length, 1, fwp->fp)) == 1) {
+        DIMINUTO_LOG_DEBUG("Written %d %zu \"%s\"\n", fileno(fwp->fp), written, fwp->filename);
+    } else {
+        errno = EIO;
+        diminuto_perror(feof(fwp->fp) ? "EOF" : ferror(fwp->fp) ? "ERROR" : "UNEXPECTED");
+        fclose(fwp->fp);
+        fwp->fp = (FILE *)0;
+    }
+
+    /*
+     * A sink may be dismissed, which moves the last sink into its
+     * place in the array, so the index only advances past a sink
+     * that is still there.
+     */
+
+    ii = 0;
+    while (ii < fwp->sinks) {
+        sp = fwp->sink[ii];
+        pending = sink_pending(sp);
+        if ((dropped = sink_enqueue(sp, datagram, length, now)) > 0) {
+            DIMINUTO_LOG_DEBUG("Dropped %d %u %lldus\n", sp->fd, dropped, (long long)((sink_lag(sp, now) * 1000000LL) / fwp->frequency));
+        }
+        if (!pending) {
+            if ((sent = sink_flush(sp, now)) < 0) {
+                diminuto_perror("sink_flush");
+                dismiss(fwp, sp, now);
+                continue;
+            }
+            DIMINUTO_LOG_DEBUG("Sent %d %zd\n", sp->fd, sent);
+        }
+        ii += 1;
+    }
+
+    if (fwp->observer == (observer_t *)0) {
+        /* Do nothing. */
+    } else if ((committed = observer_offer(fwp->observer, datagram, length, now)) < 0) {
+        diminuto_perror(fwp->filename);
+    } else if (committed > 0) {
+        DIMINUTO_LOG_DEBUG("Committed \"%s\" %zu\n", fwp->filename, length);
+    } else {
+        /* Do nothing. */
+    }
+}
+
+/*******************************************************************************
+ * CALLBACKS
+ ******************************************************************************/
+
+/**
+ * Service a sink: flush its queue when it becomes writable, and notice
+ * when it closes its end of the connection. Sinks aren't expected to send
+ * anything, so anything they do send is discarded.
+ * @param lp points to the event loop.
+ * @param fd is the socket of the sink.
+ * @param events is the set of events that occurred.
+ * @param context points to the sink.
+ */
+static void sink_ready(loop_t * lp, int fd, uint32_t events, void * context)
+{
+    sink_t * sp = (sink_t *)context;
+    forwarder_t * fwp = (forwarder_t *)lp;
+    diminuto_sticks_t now = 0;
+    char scratch[64] = { '\0', };
+    ssize_t received = 0;
+    ssize_t sent = 0;
+
+    now = diminuto_time_elapsed();
+
+    if ((events & LOOP_READ) != 0) {
+        while ((received = read(fd, scratch, sizeof(scratch))) > 0) {
+            DIMINUTO_LOG_DEBUG("Ignored %d %zd\n", fd, received);
+        }
+        if ((received == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR))) {
+            dismiss(fwp, sp, now);
+            return;
+        }
+    }
+
+    if ((events & LOOP_ERROR) != 0) {
+        dismiss(fwp, sp, now);
+        return;
+    }
+
+    if ((events & LOOP_WRITE) != 0) {
+        if ((sent = sink_flush(sp, now)) < 0) {
+            diminuto_perror("sink_flush");
+            dismiss(fwp, sp, now);
+            return;
+        }
+        DIMINUTO_LOG_DEBUG("Flushed %d %zd %u\n", fd, sent, sp->count);
+    }
+}
+
+/**
+ * Accept every sink waiting on the provider socket.
+ * @param lp points to the event loop.
+ * @param fd is the provider socket.
+ * @param events is the set of events that occurred.
+ * @param context is unused.
+ */
+static void provider_ready(loop_t * lp, int fd, uint32_t events, void * context)
+{
+    forwarder_t * fwp = (forwarder_t *)lp;
+    diminuto_ipv6_t address6 = { 0, };
+    diminuto_port_t port = 0;
+    diminuto_ipv6_buffer_t buffer6 = { 0, };
+    sink_t ** temporary = (sink_t **)0;
+    sink_t * sp = (sink_t *)0;
+    int sock = -1;
+    int rc = 0;
+
+    while ((sock = diminuto_ipc6_stream_accept_generic(fd, &address6, &port)) >= 0) {
+
+        DIMINUTO_LOG_NOTICE("Accept %d [%s]:%d\n", sock, diminuto_ipc6_address2string(address6, buffer6, sizeof(buffer6)), port);
+
+        if (fwp->sinks >= fwp->capacity) {
+            fwp->capacity = (fwp->capacity > 0) ? (fwp->capacity * 2) : 16;
+            temporary = (sink_t **)realloc(fwp->sink, fwp->capacity * sizeof(sink_t *));
+            diminuto_contract(temporary != (sink_t **)0);
+            fwp->sink = temporary;
+        }
+
+        rc = diminuto_ipc_set_nonblocking(sock, !0);
+        diminuto_contract(rc >= 0);
+        sp = (sink_t *)malloc(sizeof(sink_t));
+        diminuto_contract(sp != (sink_t *)0);
+        sp = sink_init(sp, sock, fwp->slots, fwp->total, fwp->policy);
+        diminuto_contract(sp != (sink_t *)0);
+        rc = loop_register(lp, sock, LOOP_READ | LOOP_WRITE, sink_ready, sp);
+        diminuto_contract(rc >= 0);
+
+        fwp->sink[fwp->sinks++] = sp;
+
+    }
+}
+
+/**
+ * Receive every datagram waiting on the source socket and queue each for
+ * every sink. A datagram is written to a sink right away if nothing is
+ * already queued for it; otherwise the sink will become writable as its
+ * queue drains, and the rest is written then.
+ * @param lp points to the event loop.
+ * @param fd is the source socket.
+ * @param events is the set of events that occurred.
+ * @param context is unused.
+ */
+static void source_ready(loop_t * lp, int fd, uint32_t events, void * context)
+{
+    forwarder_t * fwp = (forwarder_t *)lp;
+    diminuto_ipv6_t address6 = { 0, };
+    diminuto_port_t port = 0;
+    diminuto_ipv6_buffer_t buffer6 = { 0, };
+    diminuto_sticks_t now = 0;
+    datagram_buffer_t * bufferp = (datagram_buffer_t *)0;
+    ssize_t received = 0;
+    ssize_t length = 0;
+
+    while ((received = diminuto_ipc6_datagram_receive_generic(fd, fwp->buffer, fwp->total, &address6, &port, MSG_DONTWAIT)) >= 0) {
+
+        DIMINUTO_LOG_DEBUG("Received %d %zd [%s]:%d\n", fd, received, diminuto_ipc6_address2string(address6, buffer6, sizeof(buffer6)), port);
+
+        if (received == 0) {
+            continue;
+        }
+
+        now = diminuto_time_elapsed();
+
+        /*
+         * A batched datagram from gpstool is forwarded as the ordinary
+         * datagrams it replaces, one per frame, so sinks see the same
+         * stream whether the sender batches or not. Anything else is
+         * forwarded as is.
+         */
+
+        if (datagram_unpacker_start(&(fwp->unpacker), (const datagram_header_t *)fwp->buffer, received) > 0) {
+            DIMINUTO_LOG_DEBUG("Unpacked %d %zd %u\n", fd, received, datagram_unpacker_pending(&(fwp->unpacker)));
+            while ((bufferp = datagram_unpacker_next(&(fwp->unpacker), &length)) != (datagram_buffer_t *)0) {
+                forward(fwp, bufferp, sizeof(bufferp->header) + length, now);
+            }
+        } else {
+            forward(fwp, fwp->buffer, received, now);
+        }
+
+    }
+}
+
 /*******************************************************************************
  * MAIN
  ******************************************************************************/
@@ -91,27 +389,27 @@ int main(int argc, char * argv[])
     int error = 0;
     int ready = 0;
     int rc = 0;
-    int fd = -1;
     mode_t mode = COM_DIAG_DIMINUTO_OBSERVATION_MODE;
+    long milliseconds = 0;
+    unsigned long every = 1;
+    int timeout = 0;
     FILE * fp = (FILE *)0;
     const char * udprendezvous = (char *)0;
     const char * tcprendezvous = (char *)0;
     const char * filename = (char *)0;
-    char * temp = (char *)0;
-    char * buffer = (char *)0;
     char * here = (char *)0;
     diminuto_ipc_endpoint_t udpendpoint = { 0, };
     diminuto_ipc_endpoint_t tcpendpoint = { 0, };
-    diminuto_ipv6_t address6 = { 0, };
-    diminuto_port_t port = 0;
     diminuto_ipv6_buffer_t buffer6 = { 0, };
-    diminuto_ticks_t frequency = 0;
     ssize_t total = 512;
-    ssize_t received = 0;
-    ssize_t sent = 0;
-    size_t written = 0;
-    diminuto_mux_t mux = { 0 };
-    static const char OPTIONS[] = "B:F:M:T:U:Vm?";
+    unsigned long slots = SINK_SLOTS;
+    policy_t policy = OLDEST;
+    diminuto_sticks_t now = 0;
+    diminuto_sticks_t then = 0;
+    diminuto_sticks_t remaining = 0;
+    static forwarder_t forwarder;
+    static observer_t observer;
+    static const char OPTIONS[] = "B:C:F:LM:Q:S:T:U:Vm?";
     extern char * optarg;
     extern int optind;
     extern int opterr;
@@ -146,6 +444,15 @@ int main(int argc, char * argv[])
                 error = !0;
             }
             break;
+        case 'C':
+            here = (char *)0;
+            milliseconds = strtol(optarg, &here, 0);
+            if ((here == (char *)0) || (*here != '\0') || (milliseconds < 0)) {
+                errno = EINVAL;
+                diminuto_perror(optarg);
+                error = !0;
+            }
+            break;
         case 'M':
             here = (char *)0;
             mode = strtoul(optarg, &here, 0);
@@ -159,6 +466,27 @@ int main(int argc, char * argv[])
         case 'F':
             filename = optarg;
             break;
+        case 'L':
+            policy = LATEST;
+            break;
+        case 'Q':
+            here = (char *)0;
+            slots = strtoul(optarg, &here, 0);
+            if ((here == (char *)0) || (*here != '\0') || (slots < 2) || (slots > 65536)) {
+                errno = EINVAL;
+                diminuto_perror(optarg);
+                error = !0;
+            }
+            break;
+        case 'S':
+            here = (char *)0;
+            every = strtoul(optarg, &here, 0);
+            if ((here == (char *)0) || (*here != '\0') || (every > 0xffffffffUL)) {
+                errno = EINVAL;
+                diminuto_perror(optarg);
+                error = !0;
+            }
+            break;
         case 'T':
             tcprendezvous = optarg;
             break;
@@ -170,11 +498,15 @@ int main(int argc, char * argv[])
             break;
         case '?':
         default:
-            fprintf(stderr, "usage: %s [ -? ] [ -m ] [ -V ] [ -B BYTES ] [ -T :PORT ] [ -U :PORT ] [ -F FILE ] [ -M MODE ]\n", Program);
+            fprintf(stderr, "usage: %s [ -? ] [ -m ] [ -V ] [ -B BYTES ] [ -T :PORT ] [ -U :PORT ] [ -F FILE ] [ -M MODE ] [ -C MILLISECONDS ] [ -S COMMITS ] [ -Q DATAGRAMS ] [ -L ]\n", Program);
             fprintf(stderr, "       -m          Run in the background as a daeMon.\n");
             fprintf(stderr, "       -B BYTES    Allocate a buffer of size BYTES.\n");
+            fprintf(stderr, "       -C MILLISECONDS Commit FILE at most once every MILLISECONDS.\n");
             fprintf(stderr, "       -F FILE     Save latest datagram in FILE.\n");
+            fprintf(stderr, "       -L          Drop all but the Latest datagram when a sink falls behind.\n");
             fprintf(stderr, "       -M MODE     Set FILE mode to MODE.\n");
+            fprintf(stderr, "       -Q DATAGRAMS Queue at most DATAGRAMS datagrams per sink.\n");
+            fprintf(stderr, "       -S COMMITS  Sync FILE to storage every COMMITS commits (default 1, 0 for never).\n");
             fprintf(stderr, "       -T :PORT    Use PORT as the TCP source port.\n");
             fprintf(stderr, "       -U :PORT    Use PORT as the UDP sink port.\n");
             fprintf(stderr, "       -V          Log Version in the form of release, vintage, and revision.\n");
@@ -195,10 +527,6 @@ int main(int argc, char * argv[])
         /* Do nothing. */
     } else if (strcmp(filename, "-") == 0) {
         fp = stdout;
-    } else if ((fp = diminuto_observation_create_generic(filename, &temp, mode)) == (FILE *)0) {
-        errno = EINVAL;
-        diminuto_perror(filename);
-        error = !0;
     } else {
         /* Do nothing. */
     }
@@ -262,17 +590,44 @@ int main(int argc, char * argv[])
     rc = diminuto_pipe_install(!0);
     diminuto_contract(rc >= 0);
 
-    diminuto_mux_init(&mux);
+    (void)memset(&forwarder, 0, sizeof(forwarder));
+
+    forwarder.frequency = diminuto_frequency();
+    DIMINUTO_LOG_INFORMATION("Frequency %llu\n", (unsigned long long)forwarder.frequency);
+    diminuto_contract(forwarder.frequency > 0);
+
+    DIMINUTO_LOG_INFORMATION("Buffer %zd\n", total);
+    forwarder.buffer = (char *)malloc(total);
+    diminuto_contract(forwarder.buffer != (char *)0);
+    forwarder.total = total;
+
+    DIMINUTO_LOG_INFORMATION("Queue %lu %c\n", slots, policy);
+    forwarder.slots = slots;
+    forwarder.policy = policy;
+
+    datagram_unpacker_init(&(forwarder.unpacker));
 
     if (fp != (FILE *)0) {
-        DIMINUTO_LOG_INFORMATION("Observation (%d) \"%s\" 0%03o", fileno(fp), filename, mode);
+        DIMINUTO_LOG_INFORMATION("Observation (%d) \"%s\"", fileno(fp), filename);
+    } else if (filename != (const char *)0) {
+        DIMINUTO_LOG_INFORMATION("Observation \"%s\" 0%03o %ldms %lu", filename, mode, milliseconds, every);
+        forwarder.observer = observer_init(&observer, filename, mode, total, (milliseconds * forwarder.frequency) / 1000, every);
+        diminuto_contract(forwarder.observer != (observer_t *)0);
+    } else {
+        /* Do nothing. */
     }
+    forwarder.fp = fp;
+    forwarder.filename = filename;
+
+    diminuto_contract(loop_init(&(forwarder.loop), 64) == &(forwarder.loop));
 
     if (udprendezvous != (char *)0) {
         udpsock = diminuto_ipc6_datagram_peer(udpendpoint.udp);
         diminuto_contract(udpsock >= 0);
         DIMINUTO_LOG_INFORMATION("Source (%d) \"%s\" [%s]:%d", udpsock, udprendezvous, diminuto_ipc6_address2string(udpendpoint.ipv6, buffer6, sizeof(buffer6)), udpendpoint.udp);
-        rc = diminuto_mux_register_read(&mux, udpsock);
+        rc = diminuto_ipc_set_nonblocking(udpsock, !0);
+        diminuto_contract(rc >= 0);
+        rc = loop_register(&(forwarder.loop), udpsock, LOOP_READ, source_ready, (void *)0);
         diminuto_contract(rc >= 0);
     }
 
@@ -280,24 +635,20 @@ int main(int argc, char * argv[])
         tcpsock = diminuto_ipc6_stream_provider(tcpendpoint.tcp);
         diminuto_contract(tcpsock >= 0);
         DIMINUTO_LOG_INFORMATION("Sink (%d) \"%s\" [%s]:%d", tcpsock, tcprendezvous, diminuto_ipc6_address2string(tcpendpoint.ipv6, buffer6, sizeof(buffer6)), tcpendpoint.udp);
-        rc = diminuto_mux_register_accept(&mux, tcpsock);
+        rc = diminuto_ipc_set_nonblocking(tcpsock, !0);
+        diminuto_contract(rc >= 0);
+        rc = loop_register(&(forwarder.loop), tcpsock, LOOP_READ, provider_ready, (void *)0);
         diminuto_contract(rc >= 0);
     }
 
-    frequency = diminuto_frequency();
-    DIMINUTO_LOG_INFORMATION("Frequency %llu\n", (unsigned long long)frequency);
-    diminuto_contract(frequency > 0);
-
-    DIMINUTO_LOG_INFORMATION("Buffer %zd\n", total);
-    buffer = (char *)malloc(total);
-    diminuto_contract(buffer != (char *)0);
-
     /***************************************************************************
      * WORK
      **************************************************************************/
 
     DIMINUTO_LOG_INFORMATION("Start");
 
+    then = diminuto_time_elapsed();
+
     while (!0) {
 
         /*
@@ -315,102 +666,38 @@ int main(int argc, char * argv[])
         }
 
         /*
-         * Wait until a socket needs to be serviced... or we time out.
+         * Wait until a socket needs to be serviced... or we time out, which
+         * is no later than when a held datagram can be committed to the
+         * observation file. The callbacks for the sockets that are ready
+         * do all of the work.
          */
 
-        if ((fd = diminuto_mux_ready_read(&mux)) >= 0) {
-            /* Fall out. */
-        } else if ((fd = diminuto_mux_ready_accept(&mux)) >= 0) {
-            /* Fall out. */
-        } else if (diminuto_mux_ready_write(&mux) >= 0) {
-            while (diminuto_mux_ready_write(&mux) >= 0) { }
-            continue;
-        } else if ((ready = diminuto_mux_wait(&mux, frequency)) == 0) {
-            continue;
-        } else if (ready > 0) {
-            if ((fd = diminuto_mux_ready_read(&mux)) >= 0) {
-                /* Fall out. */
-            } else if ((fd = diminuto_mux_ready_accept(&mux)) >= 0) {
-                /* Fall out. */
-            } else if (diminuto_mux_ready_write(&mux) >= 0) {
-                while (diminuto_mux_ready_write(&mux) >= 0) { }
-                continue;
-            } else {
-                DIMINUTO_LOG_WARNING("Unexpected %d\n", ready);
-                continue;
-            }
+        timeout = 1000;
+
+        if (forwarder.observer == (observer_t *)0) {
+            /* Do nothing. */
+        } else if ((remaining = observer_remaining(forwarder.observer, diminuto_time_elapsed())) < 0) {
+            /* Do nothing. */
+        } else if ((remaining = ((remaining * 1000) + forwarder.frequency - 1) / forwarder.frequency) < timeout) {
+            timeout = remaining;
+        } else {
+            /* Do nothing. */
+        }
+
+        if ((ready = loop_wait(&(forwarder.loop), timeout)) >= 0) {
+            /* Do nothing. */
         } else if (errno == EINTR) {
-            continue;
+            /* Do nothing. */
         } else {
             diminuto_panic();
         }
 
-        /*
-         * Service the socket. Note that if the UDP or TCP sockets aren't
-         * open, the checks below will never be true.
-         */
-
-        if (fd == udpsock) {
-
-            received = diminuto_ipc6_datagram_receive_generic(udpsock, buffer, total, &address6, &port, 0);
-            DIMINUTO_LOG_DEBUG("Received %d %zd [%s]:%d\n", udpsock, received, diminuto_ipc6_address2string(address6, buffer6, sizeof(buffer6)), port);
-
-            if (received <= 0) {
-                continue;
-            }
-
-            if (fp == (FILE *)0) {
-                /* Do nothing. */
-            } else if ((written = fwrite(buffer, received, 1, fp)) == 1) {
-                DIMINUTO_LOG_DEBUG("Written %d %zu \"%s\"\n", fileno(fp), written, filename);
-            } else {
-                errno = EIO;
-                diminuto_perror(feof(fp) ? "EOF" : ferror(fp) ? "ERROR" : "UNEXPECTED");
-                fclose(fp);
-                fp = (FILE *)0;
-            }
-
-            for (fd = mux.write.min; fd <= mux.write.max; ++fd) {
-                if (FD_ISSET(fd, &mux.write.active)) {
-                    sent = diminuto_ipc6_stream_write(fd, buffer, received);
-                    if (diminuto_pipe_check()) {
-                        DIMINUTO_LOG_INFORMATION("SIGPIPE");
-                    }
-                    DIMINUTO_LOG_DEBUG("Sent %d %zd\n", fd, sent);
-                    if (sent <= 0) {
-                        DIMINUTO_LOG_NOTICE("Close %d", fd);
-                        rc = diminuto_mux_close(&mux, fd);
-                        diminuto_contract(rc >= 0);
-                    }
-                }
-            }
-
-            if (fp == (FILE *)0) {
-                /* Do nothing. */
-            } else if (fp == stdout) {
-                /* Do nothing. */
-            } else if ((fp = diminuto_observation_commit(fp, &temp)) != (FILE *)0) {
-                fclose(fp);
-                fp = (FILE *)0;
-            } else if ((fp = diminuto_observation_create_generic(filename, &temp, mode)) == (FILE *)0) {
-                /* Do nothing. */
-            } else {
-                /* Do nothing. */
-            }
-
-        } else if (fd == tcpsock) {
-
-            fd = diminuto_ipc6_stream_accept_generic(tcpsock, &address6, &port);
-            if (fd >= 0) {
-                DIMINUTO_LOG_NOTICE("Accept %d [%s]:%d\n", fd, diminuto_ipc6_address2string(address6, buffer6, sizeof(buffer6)), port);
-                rc = diminuto_mux_register_write(&mux, fd);
-                diminuto_contract(rc >= 0);
-            }
-
+        if (forwarder.observer == (observer_t *)0) {
+            /* Do nothing. */
+        } else if (observer_poll(forwarder.observer, diminuto_time_elapsed()) < 0) {
+            diminuto_perror(filename);
         } else {
-
-            DIMINUTO_LOG_WARNING("Invalid %d\n", fd);
-
+            /* Do nothing. */
         }
 
     }
@@ -421,30 +708,44 @@ int main(int argc, char * argv[])
 
     DIMINUTO_LOG_INFORMATION("Stop");
 
+    DIMINUTO_LOG_INFORMATION("Loop Wakeups=%llu Dispatches=%llu", (unsigned long long)forwarder.loop.wakeups, (unsigned long long)forwarder.loop.dispatches);
+
+    if (forwarder.unpacker.datagrams > 0) {
+        DIMINUTO_LOG_INFORMATION("Unpacked Frames=%llu Datagrams=%llu", (unsigned long long)forwarder.unpacker.frames, (unsigned long long)forwarder.unpacker.datagrams);
+    }
+
     if (udpsock >= 0) {
-        (void)diminuto_mux_close(&mux, udpsock);
+        (void)loop_unregister(&(forwarder.loop), udpsock);
+        (void)diminuto_ipc_close(udpsock);
     }
 
     if (tcpsock >= 0) {
-        (void)diminuto_mux_close(&mux, tcpsock);
+        (void)loop_unregister(&(forwarder.loop), tcpsock);
+        (void)diminuto_ipc_close(tcpsock);
     }
 
-    for (fd = mux.write.min; fd <= mux.write.max; ++fd) {
-        if (FD_ISSET(fd, &mux.write.active)) {
-            (void)diminuto_mux_close(&mux, fd);
-        }
+    now = diminuto_time_elapsed();
+
+    while (forwarder.sinks > 0) {
+        dismiss(&forwarder, forwarder.sink[0], now);
     }
 
-    diminuto_mux_fini(&mux);
+    free(forwarder.sink);
 
-    if (fp == (FILE *)0) {
-        /* Do nothing. */
-    } else if (fp == stdout) {
-        /* Do nothing. */
-    } else {
-        fp = diminuto_observation_discard(fp, &temp);
+    loop_fini(&(forwarder.loop));
+
+    if (forwarder.observer != (observer_t *)0) {
+        if (observer_flush(forwarder.observer) < 0) {
+            diminuto_perror(filename);
+        }
+        now = diminuto_time_elapsed();
+        DIMINUTO_LOG_INFORMATION("Observer Offered=%llu Commits=%llu Syncs=%llu Errors=%llu Operations=%llu Rate=%.3f/s", (unsigned long long)observer.offered, (unsigned long long)observer.commits, (unsigned long long)observer.syncs, (unsigned long long)observer.errors, (unsigned long long)observer.operations, (now > then) ? ((double)observer.operations * forwarder.frequency) / (now - then) : 0.0);
+        observer_fini(forwarder.observer);
+        forwarder.observer = (observer_t *)0;
     }
 
+    free(forwarder.buffer);
+
     DIMINUTO_LOG_NOTICE("Exit");
 
     return 0;
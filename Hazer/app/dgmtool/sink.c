@@ -0,0 +1,176 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This implements the dgmtool sink queues.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include "sink.h"
+
+sink_t * sink_init(sink_t * sp, int fd, unsigned int slots, size_t size, policy_t policy)
+{
+    sink_t * result = (sink_t *)0;
+    unsigned int ii = 0;
+
+    memset(sp, 0, sizeof(*sp));
+
+    /*
+     * There have to be at least two slots, one for a datagram that has
+     * been partly written, and one for a datagram waiting behind it.
+     */
+
+    if (slots < 2) {
+        slots = 2;
+    }
+
+    sp->fd = fd;
+    sp->slots = slots;
+    sp->size = size;
+    sp->policy = policy;
+
+    if ((sp->slot = (sink_slot_t *)calloc(slots, sizeof(sink_slot_t))) == (sink_slot_t *)0) {
+        /* Do nothing. */
+    } else if ((sp->storage = (char *)malloc(slots * size)) == (char *)0) {
+        free(sp->slot);
+        sp->slot = (sink_slot_t *)0;
+    } else {
+        for (ii = 0; ii < slots; ++ii) {
+            sp->slot[ii].data = &(sp->storage[ii * size]);
+        }
+        result = sp;
+    }
+
+    return result;
+}
+
+void sink_fini(sink_t * sp)
+{
+    free(sp->storage);
+    sp->storage = (char *)0;
+    free(sp->slot);
+    sp->slot = (sink_slot_t *)0;
+    sp->count = 0;
+}
+
+unsigned int sink_enqueue(sink_t * sp, const void * buffer, size_t length, diminuto_sticks_t now)
+{
+    unsigned int dropped = 0;
+    unsigned int keep = 0;
+    unsigned int next = 0;
+    sink_slot_t temporary = { 0, };
+    sink_slot_t * tp = (sink_slot_t *)0;
+
+    /*
+     * When coalescing, everything that is queued is dropped, except for a
+     * datagram that has already been partly written.
+     */
+
+    if (sp->policy == LATEST) {
+        keep = (sp->offset > 0) ? 1 : 0;
+        if (sp->count > keep) {
+            dropped += sp->count - keep;
+            sp->count = keep;
+        }
+    }
+
+    /*
+     * If the queue is still full, the oldest datagram is dropped. If the
+     * oldest has been partly written, the one behind it is dropped instead
+     * by exchanging the two slots and advancing past the one behind.
+     */
+
+    if (sp->count >= sp->slots) {
+        next = (sp->head + 1) % sp->slots;
+        if (sp->offset > 0) {
+            temporary = sp->slot[sp->head];
+            sp->slot[sp->head] = sp->slot[next];
+            sp->slot[next] = temporary;
+        }
+        sp->head = next;
+        sp->count -= 1;
+        dropped += 1;
+    }
+
+    if (length > sp->size) {
+        length = sp->size;
+    }
+
+    tp = &(sp->slot[(sp->head + sp->count) % sp->slots]);
+    memcpy(tp->data, buffer, length);
+    tp->length = length;
+    tp->stamp = now;
+
+    sp->count += 1;
+    if (sp->count > sp->deepest) {
+        sp->deepest = sp->count;
+    }
+
+    sp->queued += 1;
+    sp->dropped += dropped;
+
+    return dropped;
+}
+
+ssize_t sink_flush(sink_t * sp, diminuto_sticks_t now)
+{
+    ssize_t result = 0;
+    ssize_t sent = 0;
+    sink_slot_t * tp = (sink_slot_t *)0;
+    diminuto_sticks_t lag = 0;
+
+    while (sp->count > 0) {
+
+        tp = &(sp->slot[sp->head]);
+
+        sent = send(sp->fd, tp->data + sp->offset, tp->length - sp->offset, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (sent > 0) {
+            /* Do nothing. */
+        } else if (sent == 0) {
+            break;
+        } else if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            sp->stalls += 1;
+            break;
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            result = -1;
+            break;
+        }
+
+        result += sent;
+        sp->bytes += sent;
+        sp->offset += sent;
+
+        if (sp->offset < tp->length) {
+            continue;
+        }
+
+        lag = now - tp->stamp;
+        sp->latest = lag;
+        if (lag > sp->longest) {
+            sp->longest = lag;
+        }
+        sp->total += lag;
+        sp->written += 1;
+
+        sp->offset = 0;
+        sp->head = (sp->head + 1) % sp->slots;
+        sp->count -= 1;
+
+    }
+
+    return result;
+}
+
+diminuto_sticks_t sink_lag(const sink_t * sp, diminuto_sticks_t now)
+{
+    return (sp->count > 0) ? (now - sp->slot[sp->head].stamp) : 0;
+}
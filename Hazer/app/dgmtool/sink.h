@@ -0,0 +1,128 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_DGMTOOL_SINK_
+#define _H_COM_DIAG_HAZER_DGMTOOL_SINK_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This declares and defines the dgmtool sink queues.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * Each sink has a bounded queue of datagrams waiting to be written to its
+ * stream socket, which is non-blocking, so that a sink that is slow or
+ * stalled only falls behind itself instead of holding up the forwarder
+ * and every other sink. When a queue is full, either the oldest datagram
+ * is dropped to make room, or (when coalescing) everything queued is
+ * dropped in favor of the latest datagram, since a moving map only cares
+ * about the latest fix. A datagram that has been partly written is never
+ * dropped, since that would corrupt the stream. Each sink keeps counters
+ * and the lag, from when a datagram was queued until it was completely
+ * written, so that a sink that can't keep up can be identified.
+ */
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "com/diag/diminuto/diminuto_types.h"
+
+/**
+ * This is the default number of datagrams queued for each sink.
+ */
+#define SINK_SLOTS (16)
+
+/**
+ * This is what a sink does when its queue is full.
+ */
+typedef enum Policy {
+    OLDEST  = 'O',      /* Drop the oldest queued datagram. */
+    LATEST  = 'L',      /* Drop everything but the latest datagram. */
+} policy_t;
+
+/**
+ * This is one datagram waiting in a queue.
+ */
+typedef struct SinkSlot {
+    char * data;                    /* Storage for the datagram. */
+    size_t length;                  /* Length of the datagram in bytes. */
+    diminuto_sticks_t stamp;        /* When the datagram was queued. */
+} sink_slot_t;
+
+/**
+ * This is a sink and its queue.
+ */
+typedef struct Sink {
+    sink_slot_t * slot;             /* Ring of queued datagrams. */
+    char * storage;                 /* Storage for all of the slots. */
+    size_t size;                    /* Bytes of storage per slot. */
+    size_t offset;                  /* Bytes of the head already written. */
+    unsigned int slots;             /* Number of slots in the ring. */
+    unsigned int head;              /* Index of the oldest datagram. */
+    unsigned int count;             /* Number of datagrams queued. */
+    unsigned int deepest;           /* Most datagrams ever queued. */
+    policy_t policy;
+    int fd;                         /* Non-blocking stream socket. */
+    uint64_t queued;                /* Datagrams queued. */
+    uint64_t written;               /* Datagrams completely written. */
+    uint64_t dropped;               /* Datagrams dropped. */
+    uint64_t bytes;                 /* Bytes written. */
+    uint64_t stalls;                /* Writes that would have blocked. */
+    diminuto_sticks_t latest;       /* Lag of the latest datagram written. */
+    diminuto_sticks_t longest;      /* Longest lag. */
+    diminuto_sticks_t total;        /* Total lag. */
+} sink_t;
+
+/**
+ * Allocate and initialize a sink.
+ * @param sp points to the sink.
+ * @param fd is the non-blocking stream socket of the sink.
+ * @param slots is the number of datagrams that may be queued.
+ * @param size is the largest datagram in bytes.
+ * @param policy is what to do when the queue is full.
+ * @return a pointer to the sink or NULL if allocation failed.
+ */
+extern sink_t * sink_init(sink_t * sp, int fd, unsigned int slots, size_t size, policy_t policy);
+
+/**
+ * Release the storage held by a sink. The socket is not closed.
+ * @param sp points to the sink.
+ */
+extern void sink_fini(sink_t * sp);
+
+/**
+ * Queue a copy of a datagram for a sink, dropping queued datagrams
+ * according to the policy of the sink if necessary.
+ * @param sp points to the sink.
+ * @param buffer points to the datagram.
+ * @param length is the length of the datagram in bytes.
+ * @param now is the current time in ticks.
+ * @return the number of datagrams dropped.
+ */
+extern unsigned int sink_enqueue(sink_t * sp, const void * buffer, size_t length, diminuto_sticks_t now);
+
+/**
+ * Write as much of the queue as the socket will take without blocking.
+ * @param sp points to the sink.
+ * @param now is the current time in ticks.
+ * @return the number of bytes written or <0 if the socket failed.
+ */
+extern ssize_t sink_flush(sink_t * sp, diminuto_sticks_t now);
+
+/**
+ * Return how long the oldest queued datagram has been waiting.
+ * @param sp points to the sink.
+ * @param now is the current time in ticks.
+ * @return the lag in ticks, or zero if the queue is empty.
+ */
+extern diminuto_sticks_t sink_lag(const sink_t * sp, diminuto_sticks_t now);
+
+/**
+ * Return true if there are datagrams waiting to be written.
+ * @param sp points to the sink.
+ * @return !0 if the queue is not empty, 0 otherwise.
+ */
+static inline int sink_pending(const sink_t * sp) {
+    return (sp->count > 0);
+}
+
+#endif
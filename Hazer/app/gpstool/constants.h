@@ -30,40 +30,6 @@ static const char FIXES[] = {
     '?',    /* error */
 };
 
-/**
- * Headings for CSV columns.
- */
-static const char * const HEADINGS[] = {
-    "NAM",
-    "NUM",
-    "FIX",
-    "SYS",
-    "SAT",
-    "CLK",
-    "TIM",
-    "LAT",
-    "LON",
-    "HAC",
-    "MSL",
-    "GEO",
-    "VAC",
-    "SOG",
-    "COG",
-    "ROL",
-    "PIT",
-    "YAW",
-    "RAC",
-    "PAC",
-    "YAC",
-    "OBS",
-    "MAC",
-};
-
-/**
- * Encoding for empty CSV field.
- */
-static const char EMPTY[] = ", 0.";
-
 /**
  * If we're displaying in real-time using full screen control, we try to limit
  * our output lines to this many bytes.
@@ -76,6 +42,12 @@ static const size_t LIMIT = 80 - (sizeof("OUT ") - 1) - (sizeof("[123] ") - 1) -
  */
 static const size_t UNLIMITED = ~(size_t)0;
 
+/**
+ * Display lines that are rendered into a buffer before being written are
+ * shorter than this many bytes, including multibyte characters.
+ */
+enum Line { LINE = 256, };
+
 /**
  * Characters that can be displayed as the synchronization status.
  */
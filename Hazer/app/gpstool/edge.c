@@ -0,0 +1,163 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This implements the gpstool 1PPS edge capture functions.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include <linux/pps.h>
+#include "com/diag/diminuto/diminuto_log.h"
+#include "edge.h"
+
+/**
+ * This is the POSIX time of the GPS epoch, 1980-01-06T00:00:00Z.
+ */
+static const pulse_nanoseconds_t GPSEPOCH = 315964800LL;
+
+/**
+ * This is the number of seconds in a GPS week.
+ */
+static const pulse_nanoseconds_t GPSWEEK = 604800LL;
+
+static pulse_nanoseconds_t edge_clock(clockid_t clock)
+{
+    struct timespec ts = { 0, };
+
+    (void)clock_gettime(clock, &ts);
+
+    return ((pulse_nanoseconds_t)ts.tv_sec * PULSE_SECOND) + ts.tv_nsec;
+}
+
+void edge_stamp(pulse_nanoseconds_t * realtimep, pulse_nanoseconds_t * monotonicp)
+{
+    *monotonicp = edge_clock(CLOCK_MONOTONIC);
+    *realtimep = edge_clock(CLOCK_REALTIME);
+}
+
+int edge_gpio(int fd, pulse_nanoseconds_t * realtimep, pulse_nanoseconds_t * monotonicp)
+{
+    int result = -1;
+    struct gpio_v2_line_event event = { 0, };
+    ssize_t rc = -1;
+
+    /*
+     * By default the kernel stamps line events with CLOCK_MONOTONIC.
+     */
+
+    if ((rc = read(fd, &event, sizeof(event))) < 0) {
+        diminuto_perror("edge_gpio: read");
+    } else if (rc != sizeof(event)) {
+        errno = EIO;
+        diminuto_perror("edge_gpio: read");
+    } else {
+        edge_stamp(realtimep, monotonicp);
+        *realtimep -= (*monotonicp - (pulse_nanoseconds_t)event.timestamp_ns);
+        *monotonicp = (pulse_nanoseconds_t)event.timestamp_ns;
+        result = (event.id == GPIO_V2_LINE_EVENT_RISING_EDGE) ? 1 : 0;
+    }
+
+    return result;
+}
+
+int edge_pps_open(const char * path)
+{
+    int fd = -1;
+
+    if ((fd = open(path, O_RDWR)) < 0) {
+        diminuto_perror(path);
+    }
+
+    return fd;
+}
+
+int edge_pps_fetch(int fd, unsigned long * assertp, unsigned long * clearp, pulse_nanoseconds_t * realtimep, pulse_nanoseconds_t * monotonicp)
+{
+    int result = -1;
+    struct pps_fdata data = { { 0, }, };
+    pulse_nanoseconds_t realtime = 0;
+    pulse_nanoseconds_t monotonic = 0;
+
+    data.timeout.sec = 1;
+    data.timeout.nsec = 0;
+    data.timeout.flags = 0;
+
+    /*
+     * The PPS API stamps events with CLOCK_REALTIME.
+     */
+
+    if (ioctl(fd, PPS_FETCH, &data) < 0) {
+        if (errno == ETIMEDOUT) {
+            result = 0;
+        } else if (errno == EINTR) {
+            result = 0;
+        } else {
+            diminuto_perror("edge_pps_fetch: ioctl");
+        }
+    } else if (data.info.assert_sequence != *assertp) {
+        *assertp = data.info.assert_sequence;
+        *clearp = data.info.clear_sequence;
+        edge_stamp(&realtime, &monotonic);
+        *realtimep = ((pulse_nanoseconds_t)data.info.assert_tu.sec * PULSE_SECOND) + data.info.assert_tu.nsec;
+        *monotonicp = monotonic - (realtime - *realtimep);
+        result = 1;
+    } else if (data.info.clear_sequence != *clearp) {
+        *clearp = data.info.clear_sequence;
+        result = 2;
+    } else {
+        result = 0;
+    }
+
+    return result;
+}
+
+int edge_timtp2utc(const yodel_ubx_tim_tp_t * tp, pulse_nanoseconds_t * utcp)
+{
+    int rc = -1;
+
+    if (((tp->flags >> YODEL_UBX_TIM_TP_flags_timeBase_SHIFT) & YODEL_UBX_TIM_TP_flags_timeBase_MASK) != YODEL_UBX_TIM_TP_flags_timeBase_UTC) {
+        /* Do nothing. */
+    } else {
+        *utcp = (GPSEPOCH + (GPSWEEK * tp->week)) * PULSE_SECOND;
+        *utcp += (pulse_nanoseconds_t)tp->towMS * 1000000LL;
+        *utcp += ((pulse_nanoseconds_t)tp->towSubMS * 1000000LL) >> 32;
+        rc = 0;
+    }
+
+    return rc;
+}
+
+int edge_timeutc2utc(const yodel_ubx_nav_timeutc_t * tp, pulse_nanoseconds_t * utcp)
+{
+    int rc = -1;
+    struct tm datetime = { 0, };
+    time_t seconds = 0;
+
+    if (((tp->valid >> YODEL_UBX_NAV_TIMEUTC_valid_validUTC_SHIFT) & YODEL_UBX_NAV_TIMEUTC_valid_validUTC_MASK) == 0) {
+        /* Do nothing. */
+    } else {
+        datetime.tm_year = tp->year - 1900;
+        datetime.tm_mon = tp->month - 1;
+        datetime.tm_mday = tp->day;
+        datetime.tm_hour = tp->hour;
+        datetime.tm_min = tp->min;
+        datetime.tm_sec = tp->second;
+        if ((seconds = timegm(&datetime)) == (time_t)-1) {
+            /* Do nothing. */
+        } else {
+            *utcp = ((pulse_nanoseconds_t)seconds * PULSE_SECOND) + tp->nano;
+            rc = 0;
+        }
+    }
+
+    return rc;
+}
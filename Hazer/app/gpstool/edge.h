@@ -0,0 +1,80 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_GPSTOOL_EDGE_
+#define _H_COM_DIAG_HAZER_GPSTOOL_EDGE_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This declares the gpstool 1PPS edge capture functions.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * These functions timestamp 1PPS edges as close to the edge as the
+ * capture mechanism allows. The kernel PPS API and GPIO character device
+ * events carry a timestamp taken in the interrupt handler; the DCD wait
+ * can only be timestamped when it returns. Every edge is stamped with
+ * both the real-time and the monotonic clocks; when the kernel only
+ * provides one, the other is derived from the current difference between
+ * the two clocks.
+ */
+
+#include "com/diag/hazer/pulse.h"
+#include "com/diag/hazer/yodel.h"
+
+/**
+ * Timestamp an edge that has just been detected.
+ * @param realtimep points to where the CLOCK_REALTIME time is stored.
+ * @param monotonicp points to where the CLOCK_MONOTONIC time is stored.
+ */
+extern void edge_stamp(pulse_nanoseconds_t * realtimep, pulse_nanoseconds_t * monotonicp);
+
+/**
+ * Read a GPIO character device edge event and its kernel timestamp.
+ * @param fd is the line request file descriptor.
+ * @param realtimep points to where the CLOCK_REALTIME time is stored.
+ * @param monotonicp points to where the CLOCK_MONOTONIC time is stored.
+ * @return 1 for a rising edge, 0 for a falling edge, <0 for error.
+ */
+extern int edge_gpio(int fd, pulse_nanoseconds_t * realtimep, pulse_nanoseconds_t * monotonicp);
+
+/**
+ * Open a kernel PPS API device (e.g. /dev/pps0).
+ * @param path is the device path.
+ * @return a file descriptor or <0 for error.
+ */
+extern int edge_pps_open(const char * path);
+
+/**
+ * Wait up to a second for the kernel PPS API to report a new assert or
+ * clear event, and return the timestamp of a new assert.
+ * @param fd is the PPS device file descriptor.
+ * @param assertp points to the last assert sequence number seen, updated.
+ * @param clearp points to the last clear sequence number seen, updated.
+ * @param realtimep points to where the CLOCK_REALTIME time is stored.
+ * @param monotonicp points to where the CLOCK_MONOTONIC time is stored.
+ * @return 1 for a new assert, 2 for a new clear, 0 for neither, <0 for error.
+ */
+extern int edge_pps_fetch(int fd, unsigned long * assertp, unsigned long * clearp, pulse_nanoseconds_t * realtimep, pulse_nanoseconds_t * monotonicp);
+
+/**
+ * Convert the time of the next time pulse reported by UBX-TIM-TP into UTC.
+ * This is only possible if the receiver is using UTC as its time base.
+ * @param tp points to the UBX-TIM-TP payload.
+ * @param utcp points to where the UTC nanoseconds since the POSIX epoch
+ * are stored.
+ * @return 0 for success, <0 if the time base is not UTC.
+ */
+extern int edge_timtp2utc(const yodel_ubx_tim_tp_t * tp, pulse_nanoseconds_t * utcp);
+
+/**
+ * Convert the navigation epoch time reported by UBX-NAV-TIMEUTC into UTC.
+ * This is only possible if the receiver says its UTC time is valid.
+ * @param tp points to the UBX-NAV-TIMEUTC payload.
+ * @param utcp points to where the UTC nanoseconds since the POSIX epoch
+ * are stored.
+ * @return 0 for success, <0 if the UTC time is not valid.
+ */
+extern int edge_timeutc2utc(const yodel_ubx_nav_timeutc_t * tp, pulse_nanoseconds_t * utcp);
+
+#endif
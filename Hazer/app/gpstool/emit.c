@@ -11,13 +11,16 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "com/diag/diminuto/diminuto_countof.h"
 #include "com/diag/diminuto/diminuto_absolute.h"
 #include "com/diag/diminuto/diminuto_log.h"
 #include "com/diag/diminuto/diminuto_frequency.h"
 #include "com/diag/diminuto/diminuto_time.h"
 #include "com/diag/diminuto/diminuto_observation.h"
-#include "com/diag/diminuto/diminuto_countof.h"
+#include "com/diag/hazer/trace.h"
 #include "types.h"
 #include "globals.h"
 #include "constants.h"
@@ -104,42 +107,28 @@ ssize_t emit_data(FILE * fp, const void * data, size_t size)
     return rc;
 }
 
-void emit_trace(FILE * fp, const hazer_position_t pa[], const yodel_solution_t * sp, const yodel_attitude_t * ap, const yodel_posveltim_t * pp, const yodel_base_t * bp, int hangup)
+/**
+ * This is the sequence number of the next trace record.
+ */
+static uint64_t sequence = 0;
+
+/**
+ * Collect the current PVT solution into a trace record.
+ * @param rp points to the trace record.
+ * @param pa is the positions (NMEA) array.
+ * @param sp points to the solution (UBX HPPOSLLH) structure.
+ * @param ap points to the attitude (UBX UBXNAVATT) structure.
+ * @param pp points to the PVT (UBX UBXPOSVELTIM) structure
+ * @param bp points the DGNSS base (UBX UBXNAVSVIN) structure.
+ * @param hangup is true if a SIGHUP was received, false otherwise.
+ */
+static void emit_collect(trace_record_t * rp, const hazer_position_t pa[], const yodel_solution_t * sp, const yodel_attitude_t * ap, const yodel_posveltim_t * pp, const yodel_base_t * bp, int hangup)
 {
-    static uint64_t sn = 0;
-    diminuto_ticks_t ticks = 0;
     int system = HAZER_SYSTEM_GNSS;
-    uint64_t seconds = 0;
-    uint64_t nanoseconds = 0;
-    int32_t degrees = 0;
-    uint64_t nanodegrees = 0; /* UBX */
-    uint64_t decimicrodegrees = 0; /* NMEA */
-    uint32_t centimillidegrees = 0; /* IMU */
-    int32_t meters = 0;
-    uint32_t decimillimeters = 0; /* UBX */
-    uint32_t millimeters = 0; /* NMEA */
-    int32_t totalmillimeters = 0;
-    int32_t knots = 0;
-    uint32_t microknots = 0;
+    int64_t totalmillimeters = 0;
     int fix = YODEL_UBX_NAV_PVT_fixType_noFix;
     int ii = 0;
     static const int64_t NANO = 1000000000;
-    static const int64_t MICRO = 1000000;
-    static const int64_t MILLI = 1000;
-    static const int32_t CENTIMILLI = 100000;
-
-    /*
-     * HEADINGS
-     */
-
-    if (sn == 0) {
-        for (ii = 0; ii < countof(HEADINGS); ++ii) {
-            if (ii > 0) { fputc(' ', fp); }
-            fputs(HEADINGS[ii], fp);
-            if (ii < (countof(HEADINGS) - 1)) { fputc(',', fp); } else { fputc('\n', fp); }
-        }
-        sn++;
-    }
 
     /*
      * Find a GNSS solution.
@@ -160,13 +149,17 @@ void emit_trace(FILE * fp, const hazer_position_t pa[], const yodel_solution_t *
         }
     }
 
+    /*
+     * Every column starts out missing.
+     */
+
     /* NAM+flags */
 
-    fprintf(fp, "\"%s%s\"", Hostname, hangup ? "!" : "");
+    trace_record_init(rp, Hostname, hangup ? TRACE_FLAG_HANGUP : 0);
 
     /* NUM */
 
-    fprintf(fp, ", %llu", (diminuto_llu_t)(sn++));
+    trace_record_set(rp, TRACE_NUM, sequence++, TRACE_INTEGER);
 
     /* FIX */
 
@@ -180,135 +173,73 @@ void emit_trace(FILE * fp, const hazer_position_t pa[], const yodel_solution_t *
         fix = YODEL_UBX_NAV_PVT_fixType_3D;
     }
 
-    fprintf(fp, ", %d", fix);
+    trace_record_set(rp, TRACE_FIX, fix, TRACE_INTEGER);
 
     /* SYS */
 
-    fprintf(fp, ", %d", system);
+    trace_record_set(rp, TRACE_SYS, system, TRACE_INTEGER);
 
     /* SAT */
 
     if (pa[system].timeout > 0) {
-
-        fprintf(fp, ", %d", pa[system].sat_used);
-
-    } else {
-
-        fputs(", 0", fp); /* missing sat used */
-
+        trace_record_set(rp, TRACE_SAT, pa[system].sat_used, TRACE_INTEGER);
     }
 
     /* CLK */
 
-    ticks = diminuto_frequency_ticks2units(Clock, NANO);
-    seconds = ticks / NANO;
-    nanoseconds = ticks % NANO;
-    fprintf(fp, ", %llu.%09llu", (diminuto_llu_t)seconds, (diminuto_llu_t)nanoseconds);
+    trace_record_set(rp, TRACE_CLK, diminuto_frequency_ticks2units(Clock, NANO), 9);
 
     /* TIM */
 
     if ((pa[system].timeout > 0) && (hazer_is_valid_time(&(pa[system])))) {
-
-        seconds = pa[system].tot_nanoseconds / NANO;
-        nanoseconds = pa[system].tot_nanoseconds % NANO;
-        fprintf(fp, ", %llu.%09llu", (diminuto_llu_t)seconds, (diminuto_llu_t)nanoseconds);
-
-    } else {
-
-        fputs(EMPTY, fp); /* missing GNSS time */
-
+        trace_record_set(rp, TRACE_TIM, pa[system].tot_nanoseconds, 9);
     }
 
     /* LAT, LON, HAC, MSL, GEO, VAC */
 
     /*
-     * We use the high precision fix if it is available.
+     * We use the high precision fix if it is available. Its positions
+     * are in 10^-7 degrees plus a high precision part in 10^-9 degrees,
+     * its altitudes in millimeters plus a high precision part in 10^-4
+     * meters, and its accuracies in 10^-4 meters.
      */
 
     if (sp->timeout > 0) {
 
-        yodel_format_hppos2degrees(sp->payload.lat, sp->payload.latHp, &degrees, &nanodegrees);
-        fprintf(fp, ", %d.%09llu", degrees, (diminuto_llu_t)nanodegrees);
-
-        yodel_format_hppos2degrees(sp->payload.lon, sp->payload.lonHp, &degrees, &nanodegrees);
-        fprintf(fp, ", %d.%09llu", degrees, (diminuto_llu_t)nanodegrees);
-
-        yodel_format_hpacc2accuracy(sp->payload.hAcc, &meters, &decimillimeters);
-        fprintf(fp, ", %lld.%04llu", (diminuto_lld_t)meters, (diminuto_llu_t)decimillimeters);
-
-        yodel_format_hpalt2aaltitude(sp->payload.hMSL, sp->payload.hMSLHp, &meters, &decimillimeters);
-        fprintf(fp, ", %lld.%04llu", (diminuto_lld_t)meters, (diminuto_llu_t)decimillimeters);
-
-        yodel_format_hpalt2aaltitude(sp->payload.height, sp->payload.heightHp, &meters, &decimillimeters);
-        fprintf(fp, ", %lld.%04llu", (diminuto_lld_t)meters, (diminuto_llu_t)decimillimeters);
-
-        yodel_format_hpacc2accuracy(sp->payload.vAcc, &meters, &decimillimeters);
-        fprintf(fp, ", %lld.%04llu", (diminuto_lld_t)meters, (diminuto_llu_t)decimillimeters);
+        trace_record_set(rp, TRACE_LAT, ((int64_t)sp->payload.lat * 100) + sp->payload.latHp, 9);
+        trace_record_set(rp, TRACE_LON, ((int64_t)sp->payload.lon * 100) + sp->payload.lonHp, 9);
+        trace_record_set(rp, TRACE_HAC, sp->payload.hAcc, 4);
+        trace_record_set(rp, TRACE_MSL, ((int64_t)sp->payload.hMSL * 10) + sp->payload.hMSLHp, 4);
+        trace_record_set(rp, TRACE_GEO, ((int64_t)sp->payload.height * 10) + sp->payload.heightHp, 4);
+        trace_record_set(rp, TRACE_VAC, sp->payload.vAcc, 4);
 
     } else if (pa[system].timeout > 0) {
 
-        if (pa[system].lat_digits > 0) {
-
-            hazer_format_nanominutes2degrees(pa[system].lat_nanominutes, &degrees, &decimicrodegrees);
-            fprintf(fp, ", %d.%07llu", degrees, (diminuto_llu_t)decimicrodegrees);
-
-        } else {
-
-            fputs(EMPTY, fp); /* missing latitude */
+        /*
+         * NMEA positions are in nanominutes, of which there are
+         * 6000 in a ten millionth of a degree.
+         */
 
+        if (pa[system].lat_digits > 0) {
+            trace_record_set(rp, TRACE_LAT, pa[system].lat_nanominutes / 6000, 7);
         }
 
         if (pa[system].lon_digits > 0) {
-
-            hazer_format_nanominutes2degrees(pa[system].lon_nanominutes, &degrees, &decimicrodegrees);
-            fprintf(fp, ", %d.%07llu", degrees, (diminuto_llu_t)decimicrodegrees);
-
-        } else {
-
-            fputs(EMPTY, fp); /* missing longitude */
+            trace_record_set(rp, TRACE_LON, pa[system].lon_nanominutes / 6000, 7);
         }
 
-        fputs(EMPTY, fp); /* missing horizontal accuracy */
-
         if (pa[system].alt_digits > 0) {
-
             totalmillimeters = pa[system].alt_millimeters; /* MSL */
-
-            meters = totalmillimeters / MILLI;
-            millimeters = abs64(totalmillimeters) % MILLI;
-            fprintf(fp, ", %lld.%03llu", (diminuto_lld_t)meters, (diminuto_llu_t)millimeters);
-
-        } else {
-
-            fputs(EMPTY, fp); /* missing MSL */
-
+            trace_record_set(rp, TRACE_MSL, totalmillimeters, 3);
         }
 
         if (pa[system].sep_digits > 0) {
-
             totalmillimeters += pa[system].sep_millimeters; /* SEP */
-
-            meters = totalmillimeters / MILLI;
-            millimeters = abs64(totalmillimeters) % MILLI;
-            fprintf(fp, ", %lld.%03llu", (diminuto_lld_t)meters, (diminuto_llu_t)millimeters);
-
-        } else {
-
-            fputs(EMPTY, fp); /* missing SEP */
-
+            trace_record_set(rp, TRACE_GEO, totalmillimeters, 3);
         }
 
-        fputs(EMPTY, fp); /* missing vertical accuracy */
-
     } else {
-
-        fputs(EMPTY, fp); /* missing latitude */
-        fputs(EMPTY, fp); /* missing longitude */
-        fputs(EMPTY, fp); /* missing horizontal accuracy */
-        fputs(EMPTY, fp); /* missing MSL */
-        fputs(EMPTY, fp); /* missing SEP */
-        fputs(EMPTY, fp); /* missing vertical accuracy */
-
+        /* Do nothing. */
     }
 
     /* SOG, COG */
@@ -324,94 +255,149 @@ void emit_trace(FILE * fp, const hazer_position_t pa[], const yodel_solution_t *
     if (pa[system].timeout > 0) {
 
         if (pa[system].sog_digits > 0) {
-
-            knots = pa[system].sog_microknots / MICRO;
-            microknots = abs64(pa[system].sog_microknots) % MICRO;
-            fprintf(fp, ", %ld.%06lu", (long signed int)knots, (long unsigned int)microknots);
-
-        } else {
-
-            fputs(EMPTY, fp); /* missing SOG */
-
+            trace_record_set(rp, TRACE_SOG, pa[system].sog_microknots, 6);
         }
 
         if (pa[system].cog_digits > 0) {
-
-            degrees = pa[system].cog_nanodegrees / NANO;
-            nanodegrees = abs64(pa[system].cog_nanodegrees) % NANO;
-            fprintf(fp, ", %ld.%09llu", (long signed int)degrees, (diminuto_llu_t)nanodegrees);
-
-        } else {
-
-            fputs(EMPTY, fp); /* missing COG */
-
+            trace_record_set(rp, TRACE_COG, pa[system].cog_nanodegrees, 9);
         }
 
-    } else {
-
-        fputs(EMPTY, fp); /* missing SOG */
-        fputs(EMPTY, fp); /* missing COG */
-
     }
 
     /* ROL, PIT, YAW, RAC, PAC, YAC */
 
+    /*
+     * Attitudes and their accuracies are in 10^-5 degrees.
+     */
+
     if (ap->timeout > 0) {
 
-        degrees = ap->payload.roll / CENTIMILLI;
-        centimillidegrees = abs32(ap->payload.roll) % CENTIMILLI;
-        fprintf(fp, ", %ld.%05lu", (long signed int)degrees, (long unsigned int)centimillidegrees);
+        trace_record_set(rp, TRACE_ROL, ap->payload.roll, 5);
+        trace_record_set(rp, TRACE_PIT, ap->payload.pitch, 5);
+        trace_record_set(rp, TRACE_YAW, ap->payload.heading, 5);
+        trace_record_set(rp, TRACE_RAC, ap->payload.accRoll, 5);
+        trace_record_set(rp, TRACE_PAC, ap->payload.accPitch, 5);
+        trace_record_set(rp, TRACE_YAC, ap->payload.accHeading, 5);
 
-        degrees = ap->payload.pitch / CENTIMILLI;
-        centimillidegrees = abs32(ap->payload.pitch) % CENTIMILLI;
-        fprintf(fp, ", %ld.%05lu", (long signed int)degrees, (long unsigned int)centimillidegrees);
+    }
 
-        degrees = ap->payload.heading / CENTIMILLI;
-        centimillidegrees = abs32(ap->payload.heading) % CENTIMILLI;
-        fprintf(fp, ", %ld.%05lu", (long signed int)degrees, (long unsigned int)centimillidegrees);
+    /* OBS, MAC */
 
-        degrees = ap->payload.accRoll / CENTIMILLI;
-        centimillidegrees = ap->payload.accRoll % CENTIMILLI;
-        fprintf(fp, ", %lu.%05lu", (long unsigned int)degrees, (long unsigned int)centimillidegrees);
+    if (bp->timeout > 0) {
 
-        degrees = ap->payload.accPitch / CENTIMILLI;
-        centimillidegrees = ap->payload.accPitch % CENTIMILLI;
-        fprintf(fp, ", %lu.%05lu", (long unsigned int)degrees, (long unsigned int)centimillidegrees);
+        trace_record_set(rp, TRACE_OBS, bp->payload.obs, TRACE_INTEGER);
+        trace_record_set(rp, TRACE_MAC, bp->payload.meanAcc, 4);
 
-        degrees = ap->payload.accHeading / CENTIMILLI;
-        centimillidegrees = ap->payload.accHeading % CENTIMILLI;
-        fprintf(fp, ", %lu.%05lu", (long unsigned int)degrees, (long unsigned int)centimillidegrees);
+    }
+}
 
-    } else {
+void emit_trace(FILE * fp, const hazer_position_t pa[], const yodel_solution_t * sp, const yodel_attitude_t * ap, const yodel_posveltim_t * pp, const yodel_base_t * bp, int hangup)
+{
+    trace_record_t record;
+    char buffer[TRACE_LINE];
+    ssize_t length = 0;
+    int ii = 0;
 
-        fputs(EMPTY, fp); /* missing roll */
-        fputs(EMPTY, fp); /* missing pitch */
-        fputs(EMPTY, fp); /* missing heading */
-        fputs(EMPTY, fp); /* missing roll accuracy */
-        fputs(EMPTY, fp); /* missing pitch accurady */
-        fputs(EMPTY, fp); /* missing heading accuracy */
+    /*
+     * HEADINGS
+     */
 
+    if (sequence == 0) {
+        for (ii = 0; ii < TRACE_COLUMNS; ++ii) {
+            if (ii > 0) { fputc(' ', fp); }
+            fputs(trace_heading(ii), fp);
+            if (ii < (TRACE_COLUMNS - 1)) { fputc(',', fp); } else { fputc('\n', fp); }
+        }
+        sequence++;
     }
 
-    /* OBS, MAC */
+    emit_collect(&record, pa, sp, ap, pp, bp, hangup);
 
-    if (bp->timeout > 0) {
+    if ((length = trace_format(&record, buffer, sizeof(buffer))) < 0) {
+        diminuto_perror("emit_trace: trace_format");
+    } else if (fwrite(buffer, length, 1, fp) < 1) {
+        errno = EIO;
+        diminuto_perror("emit_trace: fwrite");
+    } else {
+        /* Do nothing. */
+    }
 
-        fprintf(fp, ", %d", bp->payload.obs);
+    fflush(fp);
+}
 
-        yodel_format_hpacc2accuracy(bp->payload.meanAcc, &meters, &decimillimeters);
-        fprintf(fp, ", %lld.%04llu", (diminuto_lld_t)meters, (diminuto_llu_t)decimillimeters);
+int emit_header(FILE * fp, int binary)
+{
+    int rc = -1;
+    trace_header_t header;
+    struct stat status;
+    ssize_t length = 0;
 
+    /*
+     * Since the trace file is opened for appending, the header is only
+     * written if the file is empty (or isn't a file at all), so that a
+     * trace file that is appended to is still a valid trace file. A file
+     * that already has something in it must be a trace of the same kind,
+     * a binary trace with a header this code can read, or CSV. A file that
+     * can't be read back, like standard output appended to by the shell,
+     * is taken on faith.
+     */
+
+    if (fstat(fileno(fp), &status) < 0) {
+        diminuto_perror("emit_header: fstat");
+    } else if (!S_ISREG(status.st_mode) || (status.st_size == 0)) {
+        if (!binary) {
+            rc = 0;
+        } else if (fwrite(trace_header_init(&header), sizeof(header), 1, fp) < 1) {
+            errno = EIO;
+            diminuto_perror("emit_header: fwrite");
+        } else {
+            fflush(fp);
+            rc = 0;
+        }
+    } else if ((length = pread(fileno(fp), &header, sizeof(header), 0)) < 0) {
+        if (errno == EBADF) {
+            rc = 0;
+        } else {
+            diminuto_perror("emit_header: pread");
+        }
+    } else if (!binary) {
+        if ((length >= (ssize_t)sizeof(header.magic)) && (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) == 0)) {
+            errno = EINVAL;
+            diminuto_perror("emit_header: binary trace");
+        } else {
+            rc = 0;
+        }
+    } else if (length < (ssize_t)sizeof(header)) {
+        errno = EINVAL;
+        diminuto_perror("emit_header: CSV trace");
+    } else if (trace_header_check(&header) < 0) {
+        diminuto_perror("emit_header: trace_header_check");
     } else {
+        rc = 0;
+    }
 
-        fputs(", 0", fp); /* missing survey observations */
-        fputs(EMPTY, fp); /* missing survey mean accuracy */
+    return rc;
+}
 
+void emit_record(FILE * fp, const hazer_position_t pa[], const yodel_solution_t * sp, const yodel_attitude_t * ap, const yodel_posveltim_t * pp, const yodel_base_t * bp, int hangup)
+{
+    trace_record_t record;
+
+    /*
+     * The header was written by emit_header() when the trace file was
+     * opened. Records are numbered from one, as they are in the CSV.
+     */
+
+    if (sequence == 0) {
+        sequence++;
     }
 
-    /* END */
+    emit_collect(&record, pa, sp, ap, pp, bp, hangup);
 
-    fputs("\n", fp);
+    if (fwrite(&record, sizeof(record), 1, fp) < 1) {
+        errno = EIO;
+        diminuto_perror("emit_record: fwrite");
+    }
 
     fflush(fp);
 }
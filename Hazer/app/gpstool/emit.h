@@ -57,6 +57,31 @@ extern ssize_t emit_data(FILE * fp, const void * data, size_t size);
  */
 extern void emit_trace(FILE * fp, const hazer_position_t pa[], const yodel_solution_t * sp, const yodel_attitude_t * ap, const yodel_posveltim_t * pp, const yodel_base_t * bp, int hangup);
 
+/**
+ * Write the binary trace file header to the trace file if it is empty or
+ * isn't a file at all. If it is a file that isn't empty, check that it is
+ * already a trace of the same kind: a binary trace with a header that this
+ * code can read, or CSV. This is called when the trace file is opened,
+ * before any records are saved.
+ * @param fp points to the FILE stream.
+ * @param binary is true for a binary trace, false for CSV.
+ * @return 0 for success, <0 with errno set if the file can't be used.
+ */
+extern int emit_header(FILE * fp, int binary);
+
+/**
+ * Save the current PVT solution to the trace file in binary trace format,
+ * with the same columns as the CSV format.
+ * @param fp points to the FILE stream.
+ * @param pa is the positions (NMEA) array.
+ * @param sp points to the solution (UBX HPPOSLLH) structure.
+ * @param ap points to the attitude (UBX UBXNAVATT) structure.
+ * @param pp points to the PVT (UBX UBXPOSVELTIM) structure
+ * @param bp points the DGNSS base (UBX UBXNAVSVIN) structure.
+ * @param hangup is true if a SIGHUP was received, false otherwise.
+ */
+extern void emit_record(FILE * fp, const hazer_position_t pa[], const yodel_solution_t * sp, const yodel_attitude_t * ap, const yodel_posveltim_t * pp, const yodel_base_t * bp, int hangup);
+
 /**
  * If the caller has passed a valid file name, and the solution is not active
  * yet valid, emit the appropriate UBX messages minus checksums for feeding
@@ -80,20 +80,11 @@ ssize_t endpoint_send_datagram(int fd, protocol_t protocol, const diminuto_ipv4_
     return length;
 }
 
-ssize_t endpoint_receive_datagram(int fd, void * buffer, size_t size) {
-    ssize_t length = 0;
-    diminuto_ipv6_t address = { 0, };
-    diminuto_port_t port = 0;
+ssize_t endpoint_send_packer(int fd, protocol_t protocol, const diminuto_ipv4_t * ipv4p, const diminuto_ipv6_t * ipv6p, diminuto_port_t port, datagram_packer_t * pp, datagram_sequence_t * sequencep)
+{
+    size_t size = 0;
 
-    if (size <= 1) {
-        /* Do nothing. */
-    } else if ((length = diminuto_ipc6_datagram_receive_generic(fd, buffer, size - 1, &address, &port, 0)) <= 0) {
-        /* Do nothing. */
-    } else if (length >= size) {
-        /* Should be impossible. */
-    } else {
-        ((uint8_t *)buffer)[length++] = '\0';
-    }
+    size = datagram_packer_finish(pp, sequencep);
 
-    return length;
+    return endpoint_send_datagram(fd, protocol, ipv4p, ipv6p, port, &(pp->buffer), size);
 }
@@ -15,6 +15,7 @@
 #include "com/diag/diminuto/diminuto_ipc4.h"
 #include "com/diag/diminuto/diminuto_ipc6.h"
 #include "com/diag/diminuto/diminuto_ipc.h"
+#include "com/diag/hazer/datagram.h"
 #include "types.h"
 
 /**
@@ -54,13 +55,18 @@ extern void endpoint_show_connection(const char * label, const char * option, in
 extern ssize_t endpoint_send_datagram(int fd, protocol_t protocol, const diminuto_ipv4_t * ipv4p, const diminuto_ipv6_t * ipv6p, diminuto_port_t port, const void * buffer, size_t size);
 
 /**
- * Receive a datagram from a UDP port. The datagram will be NUL terminated.
- * The provided buffer must be sized one more byte than the received datagram.
+ * Finish the batched datagram in a packer, if there is one, and send it
+ * to a remote IPv4 or IPv6 host and UDP port.
  * @param fd is an open socket.
- * @param buffer points to the buffer.
- * @param size is the size of the buffer in bytes.
- * @return the size of the received datagram in bytes or <0 if an error occurred.
+ * @param protocol indicates either IPv4 or IPv6.
+ * @param ipv4p points to an IPv4 address (if IPv4).
+ * @param ipv6p points to an IPv6 address (if IPv6).
+ * @param port is an IP UDP port.
+ * @param pp points to the packer.
+ * @param sequencep points to the sequence number.
+ * @return the size of the sent datagram in bytes, 0 if the packer was
+ * empty, or <0 if an error occurred.
  */
-extern ssize_t endpoint_receive_datagram(int fd, void * buffer, size_t size);
+extern ssize_t endpoint_send_packer(int fd, protocol_t protocol, const diminuto_ipv4_t * ipv4p, const diminuto_ipv6_t * ipv6p, diminuto_port_t port, datagram_packer_t * pp, datagram_sequence_t * sequencep);
 
 #endif
@@ -0,0 +1,113 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2023 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This implements the gpstool expiry timer wheel.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include "expiry.h"
+
+static inline expiry_entry_t * expiry_slot(expiry_wheel_t * wp, seconds_t deadline)
+{
+    return &(wp->slot[deadline & (EXPIRY_SLOTS - 1)]);
+}
+
+static inline void expiry_unlink(expiry_wheel_t * wp, expiry_entry_t * ep)
+{
+    ep->prev->next = ep->next;
+    ep->next->prev = ep->prev;
+    ep->next = ep->prev = (expiry_entry_t *)0;
+    wp->armed -= 1;
+}
+
+void expiry_init(expiry_wheel_t * wp, seconds_t now)
+{
+    int ii = 0;
+
+    for (ii = 0; ii < EXPIRY_SLOTS; ++ii) {
+        wp->slot[ii].next = wp->slot[ii].prev = &(wp->slot[ii]);
+        wp->slot[ii].timeoutp = (hazer_expiry_t *)0;
+        wp->slot[ii].deadline = 0;
+    }
+
+    wp->now = now;
+    wp->armed = 0;
+}
+
+void expiry_disarm(expiry_wheel_t * wp, expiry_entry_t * ep)
+{
+    if (ep->next != (expiry_entry_t *)0) {
+        expiry_unlink(wp, ep);
+    }
+}
+
+void expiry_arm(expiry_wheel_t * wp, expiry_entry_t * ep, hazer_expiry_t * timeoutp, seconds_t seconds)
+{
+    expiry_entry_t * sp = (expiry_entry_t *)0;
+
+    expiry_disarm(wp, ep);
+
+    ep->timeoutp = timeoutp;
+
+    if (seconds <= 0) {
+        *timeoutp = 0;
+    } else {
+        if (seconds >= EXPIRY_SLOTS) {
+            seconds = EXPIRY_SLOTS - 1;
+        }
+        *timeoutp = seconds;
+        ep->deadline = wp->now + seconds;
+        sp = expiry_slot(wp, ep->deadline);
+        ep->next = sp;
+        ep->prev = sp->prev;
+        sp->prev->next = ep;
+        sp->prev = ep;
+        wp->armed += 1;
+    }
+}
+
+unsigned int expiry_advance(expiry_wheel_t * wp, seconds_t now)
+{
+    unsigned int expired = 0;
+    seconds_t when = 0;
+    seconds_t last = 0;
+    expiry_entry_t * sp = (expiry_entry_t *)0;
+    expiry_entry_t * ep = (expiry_entry_t *)0;
+    expiry_entry_t * np = (expiry_entry_t *)0;
+
+    if (now <= wp->now) {
+        return expired;
+    }
+
+    /*
+     * If we fell more than a full revolution behind (e.g. the process was
+     * stopped), every slot gets visited exactly once.
+     */
+
+    last = now;
+    if ((now - wp->now) > EXPIRY_SLOTS) {
+        last = wp->now + EXPIRY_SLOTS;
+    }
+
+    for (when = wp->now + 1; (when <= last) && (wp->armed > 0); ++when) {
+        sp = expiry_slot(wp, when);
+        for (ep = sp->next; ep != sp; ep = np) {
+            np = ep->next;
+            if (ep->deadline > now) {
+                /* Do nothing. */
+            } else {
+                *(ep->timeoutp) = 0;
+                expiry_unlink(wp, ep);
+                expired += 1;
+            }
+        }
+    }
+
+    wp->now = now;
+
+    return expired;
+}
@@ -0,0 +1,103 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_GPSTOOL_EXPIRY_
+#define _H_COM_DIAG_HAZER_GPSTOOL_EXPIRY_
+
+/**
+ * @file
+ * @copyright Copyright 2023 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This declares and defines the gpstool expiry timer wheel.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * Every database structure (positions, actives, views, solution, etc.)
+ * carries a hazer_expiry_t timeout field that the print and emit functions
+ * interrogate: zero means the data is stale, non-zero means it is live.
+ * Rather than count every one of those fields down once a second, each
+ * structure registers an entry in a timer wheel when it is updated, and
+ * only the entries that come due in a particular second are touched.
+ * Since a timeout can never exceed the range of a hazer_expiry_t, a single
+ * wheel with more slots than that range is sufficient: every entry in a
+ * slot has the same deadline.
+ */
+
+#include "com/diag/hazer/hazer.h"
+#include "types.h"
+
+/**
+ * This is the number of slots in the wheel. It must be a power of two
+ * and greater than the largest value a hazer_expiry_t can hold.
+ */
+#define EXPIRY_SLOTS (256)
+
+/**
+ * An expiry entry links a timeout field in the database into the wheel.
+ * An entry that is not armed has null links.
+ */
+typedef struct ExpiryEntry {
+    struct ExpiryEntry * next;
+    struct ExpiryEntry * prev;
+    hazer_expiry_t * timeoutp;
+    seconds_t deadline;
+} expiry_entry_t;
+
+/**
+ * @define EXPIRY_ENTRY_INITIALIZER
+ * Initialize an ExpiryEntry structure.
+ */
+#define EXPIRY_ENTRY_INITIALIZER \
+    { \
+        (struct ExpiryEntry *)0, \
+        (struct ExpiryEntry *)0, \
+        (hazer_expiry_t *)0, \
+        0, \
+    }
+
+/**
+ * The wheel is an array of circular doubly-linked lists whose heads are
+ * sentinel entries, plus the last second to which the wheel was advanced.
+ */
+typedef struct ExpiryWheel {
+    expiry_entry_t slot[EXPIRY_SLOTS];
+    seconds_t now;
+    unsigned long armed;
+} expiry_wheel_t;
+
+/**
+ * Initialize a wheel so that it is empty and its notion of the current
+ * second is the one specified.
+ * @param wp points to the wheel.
+ * @param now is the current elapsed time in seconds.
+ */
+extern void expiry_init(expiry_wheel_t * wp, seconds_t now);
+
+/**
+ * Arm (or rearm) an entry so that the timeout field it refers to is set
+ * to the specified number of seconds and is zeroed when that many seconds
+ * have elapsed. A timeout of zero or less marks the field as stale
+ * immediately and disarms the entry.
+ * @param wp points to the wheel.
+ * @param ep points to the entry.
+ * @param timeoutp points to the timeout field in the database.
+ * @param seconds is the timeout in seconds.
+ */
+extern void expiry_arm(expiry_wheel_t * wp, expiry_entry_t * ep, hazer_expiry_t * timeoutp, seconds_t seconds);
+
+/**
+ * Disarm an entry if it is armed. The timeout field it refers to is left
+ * as it is.
+ * @param wp points to the wheel.
+ * @param ep points to the entry.
+ */
+extern void expiry_disarm(expiry_wheel_t * wp, expiry_entry_t * ep);
+
+/**
+ * Advance the wheel to the specified second, zeroing the timeout field of
+ * and disarming every entry whose deadline has been reached.
+ * @param wp points to the wheel.
+ * @param now is the current elapsed time in seconds.
+ * @return the number of entries that expired.
+ */
+extern unsigned int expiry_advance(expiry_wheel_t * wp, seconds_t now);
+
+#endif
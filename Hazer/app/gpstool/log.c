@@ -18,6 +18,7 @@
 #include "com/diag/diminuto/diminuto_types.h"
 #include "com/diag/hazer/common.h"
 #include "com/diag/hazer/hazer_version.h"
+#include "com/diag/hazer/writer.h"
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -147,6 +148,21 @@ void main(void) {
 
 */
 
+void log_writer(const char * name, const writer_t * wp)
+{
+    /*
+     * The writer stream reports dropped data as written, so that a stall
+     * doesn't put it in an error state, which makes this the only place a
+     * drop shows up. So it is a warning if anything was lost.
+     */
+
+    if ((wp->drops > 0) || (wp->errors > 0)) {
+        DIMINUTO_LOG_WARNING("Writer %s Lost Dropped=%llu/%llu Errors=%llu\n", name, (unsigned long long)wp->dropped, (unsigned long long)wp->drops, (unsigned long long)wp->errors);
+    }
+
+    DIMINUTO_LOG_INFORMATION("Writer %s Appended=%llu Dropped=%llu/%llu Handoffs=%llu Deepest=%llu Written=%llu Stalled=%llums Longest=%llums Errors=%llu\n", name, (unsigned long long)wp->appended, (unsigned long long)wp->dropped, (unsigned long long)wp->drops, (unsigned long long)wp->handoffs, (unsigned long long)wp->deepest, (unsigned long long)wp->written, (unsigned long long)(wp->stalled / 1000000ULL), (unsigned long long)(wp->longest / 1000000ULL), (unsigned long long)wp->errors);
+}
+
 #if defined(TEST_ERROR)
 #   warning TEST_ERROR enabled!
 
@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include "com/diag/diminuto/diminuto_types.h"
+#include "com/diag/hazer/writer.h"
 #include "types.h"
 
 #ifndef LOG_MASK_PATH_DEFAULT
@@ -38,6 +39,14 @@ static const char LOG_MASK_PATH[] = LOG_MASK_PATH_DEFAULT;
  */
 extern void log_fault(const hazer_fault_t * tp);
 
+/**
+ * Log the counters of a background writer, and warn if it dropped data or
+ * got errors.
+ * @param name is the name of the file being written.
+ * @param wp points to the writer.
+ */
+extern void log_writer(const char * name, const writer_t * wp);
+
 /**
  * Log an errno error message using data in a buffer minus the CR and LF
  * end matter.
@@ -92,13 +92,15 @@
 #include "com/diag/diminuto/diminuto_serial.h"
 #include "com/diag/diminuto/diminuto_terminator.h"
 #include "com/diag/diminuto/diminuto_time.h"
-#include "com/diag/diminuto/diminuto_timer.h"
 #include "com/diag/diminuto/diminuto_thread.h"
 #include "com/diag/diminuto/diminuto_types.h"
 #include "com/diag/diminuto/diminuto_version.h"
+#include "com/diag/hazer/capture.h"
 #include "com/diag/hazer/common.h"
 #include "com/diag/hazer/machine.h"
 #include "com/diag/hazer/hazer_version.h"
+#include "com/diag/hazer/snapshot.h"
+#include "com/diag/hazer/writer.h"
 #include <ctype.h>
 #include <errno.h>
 #include <fcntl.h>
@@ -115,14 +117,18 @@
 #include "buffer.h"
 #include "constants.h"
 #include "defaults.h"
+#include "edge.h"
 #include "emit.h"
 #include "endpoint.h"
+#include "expiry.h"
 #include "fix.h"
 #include "globals.h"
 #include "helper.h"
 #include "log.h"
+#include "periodic.h"
 #include "print.h"
 #include "process.h"
+#include "refclock.h"
 #include "sync.h"
 #include "test.h"
 #include "threads.h"
@@ -149,6 +155,7 @@ int main(int argc, char * argv[])
     const char * headless = (const char *)0;
     const char * arp = (const char *)0;
     const char * tracing = (const char *)0;
+    int binary = 0;
     const char * identity = (const char *)0;
     int opt = -1;
     int debug = 0;
@@ -164,6 +171,7 @@ int main(int argc, char * argv[])
     const char * ppsdevice = (const char *)0;
     diminuto_line_offset_t ppsline = maximumof(diminuto_line_offset_t);
     int ppsinverted = 0;
+    const char * ppsapi = (const char *)0;
     int test = 0;
     int serial = 0;
     int daemon = 0;
@@ -201,6 +209,17 @@ int main(int argc, char * argv[])
     FILE * queue_fp = (FILE *)0;
     FILE * sink_fp = (FILE *)0;
     FILE * trace_fp = (FILE *)0;
+    /*
+     * Writer variables.
+     */
+    unsigned long writer_slots = 0;
+    long writer_milliseconds = WRITER_LATENCY / 1000000LL;
+    static writer_t queue_writer;
+    static writer_t sink_writer;
+    static writer_t trace_writer;
+    writer_t * queue_writerp = (writer_t *)0;
+    writer_t * sink_writerp = (writer_t *)0;
+    writer_t * trace_writerp = (writer_t *)0;
     /*
      * Serial device variables.
      */
@@ -220,7 +239,8 @@ int main(int argc, char * argv[])
      * Remote variables.
      */
     protocol_t remote_protocol = PROTOCOL;
-    datagram_buffer_t remote_buffer = DATAGRAM_BUFFER_INITIALIZER;
+    datagram_batch_t remote_batch;
+    datagram_buffer_t * remote_bufferp = (datagram_buffer_t *)0;
     ssize_t remote_total = 0;
     ssize_t remote_size = 0;
     ssize_t remote_length = 0;
@@ -228,6 +248,19 @@ int main(int argc, char * argv[])
     const char * remote_option = (const char *)0;
     diminuto_ipc_endpoint_t remote_endpoint = { 0, };
     long remote_mask = ANY;
+    datagram_packer_t remote_packer;
+    datagram_unpacker_t remote_unpacker;
+    size_t remote_budget = 0;
+    long remote_milliseconds = DATAGRAM_FRAMES_WINDOW;
+    diminuto_sticks_t remote_window = 0;
+    diminuto_sticks_t remote_packed = 0;
+    static datagram_reorder_t remote_reorder;
+    /*
+     * Reorder variables.
+     */
+    unsigned long reorder_slots = 0;
+    long reorder_milliseconds = 0;
+    diminuto_sticks_t reorder_remaining = 0;
     role_t role = ROLE;
     /*
      * Queue variables.
@@ -235,13 +268,23 @@ int main(int argc, char * argv[])
     const char * queue_option = (const char *)0;
     long queue_mask = ANY;
     size_t queued = 0;
+    /*
+     * Capture variables.
+     */
+    const char * capture_option = (const char *)0;
+    FILE * capture_fp = (FILE *)0;
+    static capture_t capture;
+    capture_t * capturep = (capture_t *)0;
+    capture_protocol_t capture_protocol = CAPTURE_OTHER;
     /*
      * Surveyor variables.
      */
     protocol_t surveyor_protocol = PROTOCOL;
-    datagram_buffer_t surveyor_buffer = DATAGRAM_BUFFER_INITIALIZER;
+    datagram_batch_t surveyor_batch;
+    datagram_buffer_t * surveyor_bufferp = (datagram_buffer_t *)0;
     ssize_t surveyor_total = 0;
     datagram_sequence_t surveyor_sequence = 0;
+    static datagram_reorder_t surveyor_reorder;
     const char * surveyor_option = (const char *)0;
     diminuto_ipc_endpoint_t surveyor_endpoint = { 0, };
     ssize_t surveyor_size = 0;
@@ -264,6 +307,7 @@ int main(int argc, char * argv[])
     int surveyor_fd = -1;
     int source_fd = -1;
     int pps_fd = -1;
+    int ppsapi_fd = -1;
     int strobe_fd = -1;
     /*
      * 1PPS poller thread variables.
@@ -276,11 +320,29 @@ int main(int argc, char * argv[])
     int onepps = 0;
     bool pulsing = false;
     /*
-     * 1Hz timer service variables.
+     * 1PPS measurement variables.
+     */
+    pulse_ring_t edges = PULSE_RING_INITIALIZER;
+    pulse_statistics_t pulses = PULSE_STATISTICS_INITIALIZER;
+    const pulse_edge_t * edgep = (const pulse_edge_t *)0;
+    yodel_ubx_tim_tp_t timepulse = YODEL_UBX_TIM_TP_INITIALIZER;
+    pulse_nanoseconds_t timepulse_utc = 0;
+    pulse_nanoseconds_t reference = 0;
+    hazer_expiry_t timepulse_timeout = 0;
+    /*
+     * NTP reference clock variables.
      */
-    diminuto_timer_t timer = DIMINUTO_TIMER_INITIALIZER((diminuto_timer_function_t *)0);
-    diminuto_timer_t * timerp = (diminuto_timer_t *)0;
-    diminuto_sticks_t timerticks = (diminuto_sticks_t)-1;
+    int refclock_unit = -1;
+    refclock_t refclock = REFCLOCK_INITIALIZER;
+    yodel_ubx_nav_timeutc_t timeutc = YODEL_UBX_NAV_TIMEUTC_INITIALIZER;
+    pulse_nanoseconds_t timeutc_utc = 0;
+    pulse_nanoseconds_t received = 0;
+    pulse_nanoseconds_t receivedmonotonic = 0;
+    /*
+     * Shared memory snapshot variables.
+     */
+    const char * snapshot_name = (const char *)0;
+    snapshot_region_t * snapshotp = (snapshot_region_t *)0;
     int onehz = 0;
     /*
      * NMEA parser state variables.
@@ -344,18 +406,40 @@ int main(int argc, char * argv[])
      */
     tumbleweed_message_t kinematics = TUMBLEWEED_MESSAGE_INITIALIZER;
     tumbleweed_updates_t updates = TUMBLEWEED_UPDATES_INITIALIZER;
+    /*
+     * Expiry variables.
+     */
+    expiry_wheel_t wheel;
+    expiry_entry_t positions_expiry[HAZER_SYSTEM_TOTAL] = { EXPIRY_ENTRY_INITIALIZER, };
+    expiry_entry_t actives_expiry[HAZER_SYSTEM_TOTAL] = { EXPIRY_ENTRY_INITIALIZER, };
+    expiry_entry_t views_expiry[HAZER_SYSTEM_TOTAL][HAZER_GNSS_SIGNALS] = { { EXPIRY_ENTRY_INITIALIZER, }, };
+    expiry_entry_t solution_expiry = EXPIRY_ENTRY_INITIALIZER;
+    expiry_entry_t hardware_expiry = EXPIRY_ENTRY_INITIALIZER;
+    expiry_entry_t status_expiry = EXPIRY_ENTRY_INITIALIZER;
+    expiry_entry_t base_expiry = EXPIRY_ENTRY_INITIALIZER;
+    expiry_entry_t rover_expiry = EXPIRY_ENTRY_INITIALIZER;
+    expiry_entry_t attitude_expiry = EXPIRY_ENTRY_INITIALIZER;
+    expiry_entry_t odometer_expiry = EXPIRY_ENTRY_INITIALIZER;
+    expiry_entry_t posveltim_expiry = EXPIRY_ENTRY_INITIALIZER;
+    expiry_entry_t kinematics_expiry = EXPIRY_ENTRY_INITIALIZER;
+    expiry_entry_t timepulse_expiry = EXPIRY_ENTRY_INITIALIZER;
     /*
      * Time keeping variables.
      */
     diminuto_sticks_t delay = 0;
-    diminuto_sticks_t elapsed = 0;
-    seconds_t expiration_was = 0;
-    seconds_t expiration_now = 0;
-    seconds_t slow_last = 0;
-    seconds_t keepalive_last = 0;
-    seconds_t frequency_last = 0;
-    seconds_t postpone_last = 0;
-    seconds_t bypass_last = 0;
+    diminuto_sticks_t wait = 0;
+    /*
+     * Periodic timer variables.
+     */
+    periodic_t onehz_timer = PERIODIC_INITIALIZER;
+    periodic_t slow_timer = PERIODIC_INITIALIZER;
+    periodic_t keepalive_timer = PERIODIC_INITIALIZER;
+    periodic_t frequency_timer = PERIODIC_INITIALIZER;
+    periodic_t postpone_timer = PERIODIC_INITIALIZER;
+    periodic_t bypass_timer = PERIODIC_INITIALIZER;
+    periodic_t * const timers[] = { &onehz_timer, &slow_timer, &keepalive_timer, &frequency_timer, &postpone_timer, &bypass_timer, };
+    diminuto_sticks_t polled = 0;
+    int timer_fd = -1;
     /*
      * I/O buffer variables.
      */
@@ -418,7 +502,6 @@ int main(int argc, char * argv[])
     int rc = 0;
     char * locale = (char *)0;
     int ii = 0;
-    int jj = 0;
     /*
      * External symbols.
      */
@@ -429,7 +512,7 @@ int main(int argc, char * argv[])
     /*
      * Command line options.
      */
-    static const char OPTIONS[] = "124678A:B:C:D:EF:G:H:I:KL:MN:O:PQ:RS:T:U:VW:X:Y:Z:ab:cdef:g:hi:k:lmnop:q:rst:u:vxw:y:z?";
+    static const char OPTIONS[] = "012345:6789:A:B:C:D:EF:G:H:I:J:KL:MN:O:PQ:RS:T:U:VW:X:Y:Z:ab:cdef:g:hi:j:k:lmnop:q:rst:u:vxw:y:z?";
 
     /**
      ** INITIALIZATION
@@ -451,6 +534,10 @@ int main(int argc, char * argv[])
 
     while ((opt = getopt(argc, argv, OPTIONS)) >= 0) {
         switch (opt) {
+        case '0':
+            DIMINUTO_LOG_INFORMATION("Option -%c \"%s\"\n", opt, optarg);
+            capture_option = optarg;
+            break;
         case '1':
             DIMINUTO_LOG_INFORMATION("Option -%c\n", opt);
             stopbits = 1;
@@ -459,10 +546,26 @@ int main(int argc, char * argv[])
             DIMINUTO_LOG_INFORMATION("Option -%c\n", opt);
             stopbits = 2;
             break;
+        case '3':
+            DIMINUTO_LOG_INFORMATION("Option -%c\n", opt);
+            binary = !0;
+            break;
         case '4':
             DIMINUTO_LOG_INFORMATION("Option -%c\n", opt);
             preference = IPV4;
             break;
+        case '5':
+            DIMINUTO_LOG_INFORMATION("Option -%c \"%s\"\n", opt, optarg);
+            writer_slots = strtoul(optarg, &end, 0);
+            if ((end != (char *)0) && (*end == ':')) {
+                writer_milliseconds = strtol(end + 1, &end, 0);
+            }
+            if ((end == (char *)0) || (*end != '\0') || (writer_slots < 2) || (writer_milliseconds < 0)) {
+                errno = EINVAL;
+                diminuto_perror(optarg);
+                error = !0;
+            }
+            break;
         case '6':
             DIMINUTO_LOG_INFORMATION("Option -%c\n", opt);
             preference = IPV6;
@@ -471,6 +574,18 @@ int main(int argc, char * argv[])
             DIMINUTO_LOG_INFORMATION("Option -%c\n", opt);
             databits = 8;
             break;
+        case '9':
+            DIMINUTO_LOG_INFORMATION("Option -%c \"%s\"\n", opt, optarg);
+            reorder_slots = strtoul(optarg, &end, 0);
+            if ((end != (char *)0) && (*end == ':')) {
+                reorder_milliseconds = strtol(end + 1, &end, 0);
+            }
+            if ((end == (char *)0) || (*end != '\0') || (reorder_slots > DATAGRAM_REORDER) || (reorder_milliseconds < 0)) {
+                errno = EINVAL;
+                diminuto_perror(optarg);
+                error = !0;
+            }
+            break;
         case 'A':
             DIMINUTO_LOG_INFORMATION("Option -%c \"%s\"\n", opt, optarg);
             readonly = 0;
@@ -535,8 +650,21 @@ int main(int argc, char * argv[])
             process = !0;
             headless = optarg;
             break;
+        case 'J':
+            DIMINUTO_LOG_INFORMATION("Option -%c \"%s\"\n", opt, optarg);
+            refclock_unit = strtol(optarg, &end, 0);
+            if ((end == (char *)0) || (*end != '\0') || (refclock_unit < 0)) {
+                errno = EINVAL;
+                diminuto_perror(optarg);
+                error = !0;
+            }
+            break;
         case 'I':
             DIMINUTO_LOG_INFORMATION("Option -%c \"%s\"\n", opt, optarg);
+            if (strncmp(optarg, "/dev/pps", sizeof("/dev/pps") - 1) == 0) {
+                ppsapi = optarg;
+                break;
+            }
             pps = optarg;
             ppspath = (char *)malloc(sizeof(diminuto_path_t));
             diminuto_contract(ppspath != (char *)0);
@@ -682,7 +810,13 @@ int main(int argc, char * argv[])
         case 'g':
             DIMINUTO_LOG_INFORMATION("Option -%c \"%s\"\n", opt, optarg);
             remote_mask = strtol(optarg, &end, 0);
-            if ((end == (char *)0) || (*end != '\0')) {
+            if ((end != (char *)0) && (*end == ':')) {
+                remote_budget = strtoul(end + 1, &end, 0);
+                if ((end != (char *)0) && (*end == ':')) {
+                    remote_milliseconds = strtol(end + 1, &end, 0);
+                }
+            }
+            if ((end == (char *)0) || (*end != '\0') || (remote_milliseconds < 0)) {
                 errno = EINVAL;
                 diminuto_perror(optarg);
                 error = !0;
@@ -701,6 +835,10 @@ int main(int argc, char * argv[])
                 error = !0;
             }
             break;
+        case 'j':
+            DIMINUTO_LOG_INFORMATION("Option -%c \"%s\"\n", opt, optarg);
+            snapshot_name = (*optarg == '\0') ? SNAPSHOT_NAME : optarg;
+            break;
         case 'k':
             DIMINUTO_LOG_INFORMATION("Option -%c \"%s\"\n", opt, optarg);
             device_mask = strtol(optarg, &end, 0);
@@ -811,24 +949,31 @@ int main(int argc, char * argv[])
                             "               [ -C FILE ]\n"
                             "               [ -O FILE ]\n"
                             "               [ -L FILE ]\n"
-                            "               [ -T FILE [ -f SECONDS ] ]\n"
+                            "               [ -T FILE [ -f SECONDS ] [ -3 ] ]\n"
                             "               [ -N FILE ]\n"
                             "               [ -Q FILE [ -q MASK ] ]\n"
+                            "               [ -0 FILE ]\n"
+                            "               [ -5 SLOTS[:MILLISECONDS] ]\n"
                             "               [ -K [ -k MASK ] ]\n"
                             "               [ -A STRING ... ] [ -U STRING ... ] [ -W STRING ... ] [ -Z STRING ... ] [ -w SECONDS ] [ -x ]\n"
-                            "               [ -4 | -6 ]\n"
-                            "               [ -G :PORT | -G HOST:PORT [ -g MASK ] ]\n"
+                            "               [ -4 | -6 ] [ -9 SLOTS[:MILLISECONDS] ]\n"
+                            "               [ -G :PORT | -G HOST:PORT [ -g MASK[:BYTES[:MILLISECONDS]] ] ]\n"
                             "               [ -Y :PORT | -Y HOST:PORT [ -y SECONDS ] ]\n"
-                            "               [ -I CHIP:LINE | -I NAME | -c ]\n"
+                            "               [ -I CHIP:LINE | -I NAME | -I /dev/ppsN | -c ]\n"
+                            "               [ -J UNIT ] [ -j NAME ]\n"
                             "               [ -p CHIP:LINE | -p NAME ]\n"
                             "               [ -M ] [ -X MASK ] [ -V ]\n"
                             , Program);
+            fprintf(stderr, "       -0 FILE         Capture validated input with receive times to indexed FILE.\n");
             fprintf(stderr, "       -1              Use one stop bit for DEVICE.\n");
             fprintf(stderr, "       -2              Use two stop bits for DEVICE.\n");
+            fprintf(stderr, "       -3              Save the PVT Trace in binary instead of CSV.\n");
             fprintf(stderr, "       -4              Prefer IPv4 for HOST.\n");
+            fprintf(stderr, "       -5 SLOTS[:MILLISECONDS] Write the -C, -Q, and -T FILEs in the background through SLOTS buffers held at most MILLISECONDS.\n");
             fprintf(stderr, "       -6              Prefer IPv6 for HOST.\n");
             fprintf(stderr, "       -7              Use seven data bits for DEVICE.\n");
             fprintf(stderr, "       -8              Use eight data bits for DEVICE.\n");
+            fprintf(stderr, "       -9 SLOTS[:MILLISECONDS] Reorder up to SLOTS (max %u) received dataGrams held at most MILLISECONDS.\n", DATAGRAM_REORDER);
             fprintf(stderr, "       -A STRING       Collapse STRING, append Ubx end matter, write to DEVICE, expect ACK/NAK.\n");
             fprintf(stderr, "       -A ''           Exit when this empty STRING is processed.\n");
             fprintf(stderr, "       -B BYTES        Set the input Buffer size to BYTES bytes.\n");
@@ -841,6 +986,8 @@ int main(int argc, char * argv[])
             fprintf(stderr, "       -H HEADLESS     Like -R but writes each iteration to HEADLESS file.\n");
             fprintf(stderr, "       -I CHIP:LINE    Take 1PPS from GPIO CHIP LINE (requires -D) (LINE<0 active low).\n");
             fprintf(stderr, "       -I NAME         Take 1PPS from GPIO NAME (requires -D) (-NAME active low).\n");
+            fprintf(stderr, "       -I /dev/ppsN    Take 1PPS from kernel PPS API device /dev/ppsN.\n");
+            fprintf(stderr, "       -J UNIT         Feed NTP SHM UNIT with GNSS time and UNIT+1 with 1PPS.\n");
             fprintf(stderr, "       -K              Write input to DEVICE sinK from datagram source.\n");
             fprintf(stderr, "       -L FILE         Write pretty-printed input to Listing FILE.\n");
             fprintf(stderr, "       -M              Run in the background as a daeMon.\n");
@@ -863,13 +1010,15 @@ int main(int argc, char * argv[])
             fprintf(stderr, "       -Z ''           Exit when this empty STRING is processed.\n");
             fprintf(stderr, "       -a              Display Active satellite views first.\n");
             fprintf(stderr, "       -b BPS          Use BPS bits per second for DEVICE.\n");
-            fprintf(stderr, "       -c              Take 1PPS from DCD (requires -D and implies -m).\n");
+            fprintf(stderr, "       -c              Take 1PPS from DCD (requires -D and implies -m) (not with -I).\n");
             fprintf(stderr, "       -d              Display Debug output on standard error.\n");
             fprintf(stderr, "       -e              Use Even parity for DEVICE.\n");
             fprintf(stderr, "       -f SECONDS      Set trace Frequency to 1/SECONDS.\n");
             fprintf(stderr, "       -g MASK         Set dataGram sink mask (NMEA=%u, UBX=%u, RTCM=%u, CPO=%u, default=%lu).\n", NMEA, UBX, RTCM, CPO, remote_mask);
+            fprintf(stderr, "       -g MASK:BYTES[:MILLISECONDS] Batch dataGrams up to BYTES (e.g. %u) held at most MILLISECONDS (default=%u).\n", DATAGRAM_FRAMES_MTU, DATAGRAM_FRAMES_WINDOW);
             fprintf(stderr, "       -h              Use RTS/CTS Hardware flow control for DEVICE.\n");
             fprintf(stderr, "       -i SECONDS      Bypass input check every SECONDS seconds, 0 always, <0 never.\n");
+            fprintf(stderr, "       -j NAME         Publish the fix in shared memory NAME ('' for %s).\n", SNAPSHOT_NAME);
             fprintf(stderr, "       -k MASK         Set device sinK mask (NMEA=%u, UBX=%u, RTCM=%u, CPO=%u, default=%lu).\n", NMEA, UBX, RTCM, CPO, device_mask);
             fprintf(stderr, "       -l              Use Local control for DEVICE.\n");
             fprintf(stderr, "       -m              Use Modem control for DEVICE.\n");
@@ -892,6 +1041,22 @@ int main(int argc, char * argv[])
         }
     }
 
+    /*
+     * There is only one 1PPS poller thread, so only one source of 1PPS.
+     */
+
+    if ((pps != (const char *)0) && (ppsapi != (const char *)0)) {
+        errno = EINVAL;
+        diminuto_perror(ppsapi);
+        error = !0;
+    } else if (carrierdetect && ((pps != (const char *)0) || (ppsapi != (const char *)0))) {
+        errno = EINVAL;
+        diminuto_perror((pps != (const char *)0) ? pps : ppsapi);
+        error = !0;
+    } else {
+        /* Do nothing. */
+    }
+
     if (error) {
         return 1;
     }
@@ -1020,12 +1185,77 @@ int main(int argc, char * argv[])
         DIMINUTO_LOG_INFORMATION("Queue Mask 0x%lx\n", queue_mask);
     }
 
+    /*
+     * If we are writing in the background, the queue file is written by a
+     * writer thread, through a writer stream that replaces its stream.
+     */
+
+    if (queue_fp == (FILE *)0) {
+        /* Do nothing. */
+    } else if (queue_fp == stdout) {
+        /* Do nothing. */
+    } else if (writer_slots == 0) {
+        /* Do nothing. */
+    } else if ((queue_writerp = writer_init(&queue_writer, queue_fp, writer_slots, WRITER_SIZE, writer_milliseconds * 1000000LL)) == (writer_t *)0) {
+        diminuto_perror("writer_init");
+        diminuto_contract(queue_writerp != (writer_t *)0);
+    } else if ((queue_fp = writer_stream(queue_writerp)) == (FILE *)0) {
+        diminuto_perror("writer_stream");
+        diminuto_contract(queue_fp != (FILE *)0);
+    } else {
+        DIMINUTO_LOG_INFORMATION("Queue Writer %lu %ldms\n", writer_slots, writer_milliseconds);
+    }
+
+    /*
+     * Are we capturing every valid sentence or packet, along with when it
+     * was received, to an indexed capture file? The capture file isn't
+     * written in the background, since an append dropped by a writer could
+     * leave part of a record; it is instead left to stdio to buffer, and
+     * flushed once a second.
+     */
+
+    if (capture_option == (const char *)0) {
+        /* Do nothing. */
+    } else if (strcmp(capture_option, "-") == 0) {
+        capture_fp = stdout;
+    } else if ((capture_fp = fopen(capture_option, "wb")) != (FILE *)0) {
+        /* Do nothing. */
+    } else {
+        diminuto_perror(capture_option);
+        diminuto_contract(capture_fp != (FILE *)0);
+    }
+
+    if (capture_fp == (FILE *)0) {
+        /* Do nothing. */
+    } else if ((capturep = capture_init(&capture, capture_fp, CAPTURE_INTERVAL)) == (capture_t *)0) {
+        diminuto_perror("capture_init");
+        diminuto_contract(capturep != (capture_t *)0);
+    } else {
+        DIMINUTO_LOG_INFORMATION("Capture File (%d) \"%s\"\n", fileno(capture_fp), capture_option);
+    }
+
     /*
      * Initialize the multiplexer.
      */
 
     diminuto_mux_init(&mux);
 
+    /*
+     * Initialize the batches into which datagrams are received.
+     */
+
+    datagram_batch_init(&remote_batch);
+    datagram_batch_init(&surveyor_batch);
+
+    /*
+     * Initialize the packer into which frames are batched before they are
+     * forwarded, if we do that, and the unpacker from which frames are
+     * extracted from batched datagrams, whether the sender does that or not.
+     */
+
+    datagram_packer_init(&remote_packer, remote_budget);
+    datagram_unpacker_init(&remote_unpacker);
+
     /*
      * Are we consuming GPS data from an IP port, or producing GPS data to an
      * IP host and port? This feature is useful for forwarding data from a
@@ -1099,6 +1329,9 @@ int main(int argc, char * argv[])
         DIMINUTO_LOG_INFORMATION("Remote Protocol '%c'\n", remote_protocol);
         DIMINUTO_LOG_INFORMATION("Remote Role '%c'\n", role);
         DIMINUTO_LOG_INFORMATION("Remote Mask 0x%lx\n", remote_mask);
+        if (remote_budget > 0) {
+            DIMINUTO_LOG_INFORMATION("Remote Batch %zuB %ldms\n", remote_packer.budget, remote_milliseconds);
+        }
     }
 
     /*
@@ -1257,6 +1490,60 @@ int main(int argc, char * argv[])
         diminuto_contract(threadrc == 0);
     }
 
+    /*
+     * Are we monitoring 1PPS from the kernel PPS API? The kernel timestamps
+     * each edge in its interrupt handler, which is as good as it gets without
+     * special hardware. A thread waits for the assert events.
+     */
+
+    if (ppsapi != (const char *)0) {
+
+        ppsapi_fd = edge_pps_open(ppsapi);
+        diminuto_contract(ppsapi_fd >= 0);
+
+        DIMINUTO_LOG_INFORMATION("1PPS API (%d) \"%s\"\n", ppsapi_fd, ppsapi);
+
+        poller.ppsfd = ppsapi_fd;
+        poller.strobefd = strobe_fd;
+        poller.onepps = 0;
+        poller.onehz = TOLERANCE;
+        poller.done = 0;
+
+        threadp = diminuto_thread_init_base(&thread, ppspoller, scheduler, priority);
+        diminuto_contract(threadp == &thread);
+
+        threadrc = diminuto_thread_start(threadp, &poller);
+        diminuto_contract(threadrc == 0);
+    }
+
+    /*
+     * Are we feeding time to an NTP daemon? We use the same shared memory
+     * segments as gpsd, so ntpd or chronyd can be configured the same way.
+     */
+
+    if (refclock_unit >= 0) {
+
+        rc = refclock_init(&refclock, refclock_unit);
+        diminuto_contract(rc == 0);
+
+        DIMINUTO_LOG_INFORMATION("NTP SHM %d %d\n", refclock_unit, refclock_unit + 1);
+
+    }
+
+    /*
+     * Are we publishing the fix in shared memory for local consumers?
+     */
+
+    if (snapshot_name != (const char *)0) {
+
+        snapshotp = snapshot_create(snapshot_name);
+        if (snapshotp == (snapshot_region_t *)0) { diminuto_perror(snapshot_name); }
+        diminuto_contract(snapshotp != (snapshot_region_t *)0);
+
+        DIMINUTO_LOG_INFORMATION("Snapshot \"%s\" [%zu]\n", snapshot_name, sizeof(snapshot_region_t));
+
+    }
+
     /*
      * Are we using a GPS receiver with a serial port instead of a IP datagram
      * or standard input? If this is the case, it turns out to be a good idea
@@ -1434,6 +1721,27 @@ int main(int argc, char * argv[])
         DIMINUTO_LOG_INFORMATION("Sink File (%d) \"%s\"\n", fileno(sink_fp), sink);
     }
 
+    /*
+     * If we are writing in the background, the sink file is written by a
+     * writer thread, through a writer stream that replaces its stream.
+     */
+
+    if (sink_fp == (FILE *)0) {
+        /* Do nothing. */
+    } else if (sink_fp == stdout) {
+        /* Do nothing. */
+    } else if (writer_slots == 0) {
+        /* Do nothing. */
+    } else if ((sink_writerp = writer_init(&sink_writer, sink_fp, writer_slots, WRITER_SIZE, writer_milliseconds * 1000000LL)) == (writer_t *)0) {
+        diminuto_perror("writer_init");
+        diminuto_contract(sink_writerp != (writer_t *)0);
+    } else if ((sink_fp = writer_stream(sink_writerp)) == (FILE *)0) {
+        diminuto_perror("writer_stream");
+        diminuto_contract(sink_fp != (FILE *)0);
+    } else {
+        DIMINUTO_LOG_INFORMATION("Sink Writer %lu %ldms\n", writer_slots, writer_milliseconds);
+    }
+
     /*
      * If we are running headless, create our temporary output file using the
      * provided prefix.
@@ -1479,20 +1787,47 @@ int main(int argc, char * argv[])
     }
 
     /*
-     * If we are handling the 1PPS signal, either via a GPIO pin
-     * or via the serial DCD signal, start a one hertz periodic timer.
+     * Start the periodic timers and register them with the multiplexor
+     * alongside the device and the sockets. All periodic work in the
+     * work loop is driven by these timers. The one hertz timer always
+     * runs: if we are handling the 1PPS signal, either via a GPIO pin or
+     * via the serial DCD signal, it lets us determine if we have lost the
+     * signal; and it guarantees that the multiplexor wakes up at least
+     * once a second even if all of our inputs go quiet. For some time
+     * intervals (e.g. display) we want to delay initially; for others
+     * (e.g. keepalive) we do not.
      */
 
-    if (threadp != (diminuto_thread_t *)0) {
+    rc = periodic_init(&onehz_timer, 1, 0);
+    diminuto_contract(rc >= 0);
+    rc = diminuto_mux_register_read(&mux, onehz_timer.fd);
+    diminuto_contract(rc >= 0);
 
-        timerp = diminuto_timer_init_periodic(&timer, timerservice);
-        diminuto_contract(timerp == &timer);
+    if ((rc = periodic_init(&slow_timer, slow, 0)) >= 0) {
+        rc = diminuto_mux_register_read(&mux, slow_timer.fd);
+        diminuto_contract(rc >= 0);
+    }
 
-        timerticks = diminuto_frequency();
-        diminuto_contract(timerticks > 0);
+    if (surveyor_fd < 0) {
+        /* Do nothing. */
+    } else if ((rc = periodic_init(&keepalive_timer, keepalive, !0)) >= 0) {
+        rc = diminuto_mux_register_read(&mux, keepalive_timer.fd);
+        diminuto_contract(rc >= 0);
+    }
 
-        timerticks = diminuto_timer_start(timerp, timerticks, &poller);
-        diminuto_contract(timerticks >= (diminuto_sticks_t)0);
+    if ((rc = periodic_init(&frequency_timer, frequency, 0)) >= 0) {
+        rc = diminuto_mux_register_read(&mux, frequency_timer.fd);
+        diminuto_contract(rc >= 0);
+    }
+
+    if ((rc = periodic_init(&postpone_timer, postpone, 0)) >= 0) {
+        rc = diminuto_mux_register_read(&mux, postpone_timer.fd);
+        diminuto_contract(rc >= 0);
+    }
+
+    if ((rc = periodic_init(&bypass_timer, bypass, 0)) >= 0) {
+        rc = diminuto_mux_register_read(&mux, bypass_timer.fd);
+        diminuto_contract(rc >= 0);
     }
 
     /*
@@ -1503,7 +1838,7 @@ int main(int argc, char * argv[])
         /* Do nothing. */
     } else if (strcmp(tracing, "-") == 0) {
         trace_fp = stdout;
-    } else if ((trace_fp = fopen(tracing, "a")) != (FILE *)0) {
+    } else if ((trace_fp = fopen(tracing, "a+")) != (FILE *)0) {
         /* Do nothing. */
     } else {
         diminuto_perror(tracing);
@@ -1511,7 +1846,36 @@ int main(int argc, char * argv[])
     }
 
     if (trace_fp != (FILE *)0) {
-        DIMINUTO_LOG_INFORMATION("Trace File (%d) \"%s\"\n", fileno(trace_fp), tracing);
+        DIMINUTO_LOG_INFORMATION("Trace File (%d) \"%s\" %s\n", fileno(trace_fp), tracing, binary ? "binary" : "CSV");
+    }
+
+    if (trace_fp == (FILE *)0) {
+        /* Do nothing. */
+    } else if ((rc = emit_header(trace_fp, binary)) < 0) {
+        diminuto_contract(rc >= 0);
+    } else {
+        /* Do nothing. */
+    }
+
+    /*
+     * If we are writing in the background, the trace file is written by a
+     * writer thread, through a writer stream that replaces its stream.
+     */
+
+    if (trace_fp == (FILE *)0) {
+        /* Do nothing. */
+    } else if (trace_fp == stdout) {
+        /* Do nothing. */
+    } else if (writer_slots == 0) {
+        /* Do nothing. */
+    } else if ((trace_writerp = writer_init(&trace_writer, trace_fp, writer_slots, WRITER_SIZE, writer_milliseconds * 1000000LL)) == (writer_t *)0) {
+        diminuto_perror("writer_init");
+        diminuto_contract(trace_writerp != (writer_t *)0);
+    } else if ((trace_fp = writer_stream(trace_writerp)) == (FILE *)0) {
+        diminuto_perror("writer_stream");
+        diminuto_contract(trace_fp != (FILE *)0);
+    } else {
+        DIMINUTO_LOG_INFORMATION("Trace Writer %lu %ldms\n", writer_slots, writer_milliseconds);
     }
 
     /*
@@ -1605,20 +1969,33 @@ int main(int argc, char * argv[])
 
     Event = Epoch;
 
-    delay = Frequency;
+    /*
+     * The one hertz periodic timer guarantees that the multiplexor wakes
+     * up, so there is no reason for it to time out.
+     */
+
+    delay = -1;
+
+    /*
+     * The window in which frames may be held in a batch.
+     */
+
+    remote_window = (remote_milliseconds * Frequency) / 1000;
 
     /*
-     * For some time intervals (e.g. display) we want to
-     * delay initially; for others (e.g. keepalive) we do not.
+     * The reorder buffers for received datagrams, which are disabled (and
+     * datagrams that arrive out of order are discarded) if there are no
+     * slots.
      */
 
-    expiration_now = expiration_was =
-        slow_last =
-            frequency_last =
-                bypass_last =
-                    postpone_last = Now / Frequency;
+    datagram_reorder_init(&remote_reorder, reorder_slots, (reorder_milliseconds * Frequency) / 1000);
+    datagram_reorder_init(&surveyor_reorder, reorder_slots, (reorder_milliseconds * Frequency) / 1000);
+
+    if (reorder_slots > 0) {
+        DIMINUTO_LOG_INFORMATION("Reorder %lu %ldms\n", reorder_slots, reorder_milliseconds);
+    }
 
-    keepalive_last = (Now / Frequency) - keepalive;
+    expiry_init(&wheel, Now / Frequency);
 
     /*
      * Initialize all state machines to attempt synchronization with the
@@ -1733,7 +2110,64 @@ int main(int argc, char * argv[])
         ready = 0;
         fd = -1;
 
-        if ((in_fp != (FILE *)0) && ((available = diminuto_file_ready(in_fp)) > 0)) {
+        /*
+         * If frames are being held in a batch to be forwarded, we wait no
+         * longer than the remainder of their window; if the input is quiet
+         * for that long (or at all, if there is no window), the batch is
+         * forwarded.
+         */
+
+        wait = delay;
+
+        if (datagram_packer_pending(&remote_packer) == 0) {
+            /* Do nothing. */
+        } else if ((wait = remote_window - (diminuto_time_elapsed() - remote_packed)) < 0) {
+            wait = 0;
+        } else {
+            /* Do nothing. */
+        }
+
+        /*
+         * Likewise, if received datagrams are being held until a gap in
+         * their sequence fills, we wait no longer than until the gap is
+         * given up on.
+         */
+
+        if ((reorder_remaining = datagram_reorder_remaining(&remote_reorder, diminuto_time_elapsed())) < 0) {
+            /* Do nothing. */
+        } else if ((wait < 0) || (reorder_remaining < wait)) {
+            wait = reorder_remaining;
+        } else {
+            /* Do nothing. */
+        }
+
+        if ((reorder_remaining = datagram_reorder_remaining(&surveyor_reorder, diminuto_time_elapsed())) < 0) {
+            /* Do nothing. */
+        } else if ((wait < 0) || (reorder_remaining < wait)) {
+            wait = reorder_remaining;
+        } else {
+            /* Do nothing. */
+        }
+
+        /*
+         * Buffered input keeps us from reaching the multiplexor below, and
+         * so from servicing the timers registered with it; with saturated
+         * input neither the bypass nor the one hertz work would happen until
+         * the input paused. So a few times a second we ask the timers
+         * directly, without blocking, ahead of any buffered input.
+         */
+
+        timer_fd = -1;
+        if ((Now - polled) >= (Frequency / PERIODIC_POLLS)) {
+            polled = Now;
+            timer_fd = periodic_ready(timers, countof(timers));
+        }
+
+        if (timer_fd >= 0) {
+
+            fd = timer_fd;
+
+        } else if ((in_fp != (FILE *)0) && ((available = diminuto_file_ready(in_fp)) > 0)) {
 
             fd = in_fd;
             if (available > io_maximum) {
@@ -1747,13 +2181,27 @@ int main(int argc, char * argv[])
                 io_maximum = available;
             }
 
+        } else if ((datagram_batch_pending(&remote_batch) > 0) || (datagram_unpacker_pending(&remote_unpacker) > 0) || datagram_reorder_ready(&remote_reorder, remote_sequence, diminuto_time_elapsed())) {
+
+            fd = remote_fd;
+
+        } else if (datagram_reorder_ready(&surveyor_reorder, surveyor_sequence, diminuto_time_elapsed())) {
+
+            fd = surveyor_fd;
+
         } else if ((fd = diminuto_mux_ready_read(&mux)) >= 0) {
 
             /* Do nothing. */
 
-        } else if ((ready = diminuto_mux_wait(&mux, delay /* BLOCK */)) == 0) {
+        } else if ((ready = diminuto_mux_wait(&mux, wait /* BLOCK */)) == 0) {
 
-            /* Do nothing. */
+            if (datagram_packer_pending(&remote_packer) > 0) {
+                remote_total = endpoint_send_packer(remote_fd, remote_protocol, &remote_endpoint.ipv4, &remote_endpoint.ipv6, remote_endpoint.udp, &remote_packer, &remote_sequence);
+                if (remote_total > 0) {
+                    network_total += remote_total;
+                    DIMINUTO_LOG_DEBUG("Datagram Batch Sent [%zd] [%zd]", remote_total, network_total);
+                }
+            }
 
         } else if (ready > 0) {
 
@@ -1791,6 +2239,94 @@ consume:
              * if our device or remote stopped producing data.
              */
 
+        } else if (periodic_service(&onehz_timer, fd)) {
+
+            /*
+             * One second has passed. If we are monitoring 1PPS, count
+             * towards declaring it lost; the poller resets the count on
+             * every pulse.
+             */
+
+            if (threadp != (diminuto_thread_t *)0) {
+
+                pollertick(&poller);
+
+                DIMINUTO_CRITICAL_SECTION_BEGIN(&Mutex);
+                    edges = poller.edges;
+                DIMINUTO_CRITICAL_SECTION_END;
+
+                /*
+                 * Measure every edge that arrived since the last tick
+                 * against the UTC second it marks, preferring the time
+                 * pulse time from UBX-TIM-TP and falling back to the NMEA
+                 * (or UBX-NAV-PVT derived) time of the most recent fix once
+                 * that has aged out. Each edge is posted to the reference
+                 * clock as soon as it is measured.
+                 */
+
+                reference = 0;
+                if (timepulse_timeout > 0) {
+                    reference = timepulse_utc;
+                } else {
+                    for (ii = HAZER_SYSTEM_GNSS; ii <= maximum; ++ii) {
+                        if (positions[ii].timeout == 0) { continue; }
+                        if (!hazer_is_valid_time(&positions[ii])) { continue; }
+                        reference = (pulse_nanoseconds_t)positions[ii].tot_nanoseconds;
+                        break;
+                    }
+                }
+
+                if (reference != 0) {
+                    while (pulse_measure_next(&pulses, &edges, reference) == 0) {
+                        if (refclock_unit >= 0) {
+                            (void)refclock_pulse(&refclock, &pulses, &edges);
+                        }
+                    }
+                }
+
+            }
+
+            /*
+             * Hand off any data that the background writers have held for
+             * longer than their latency.
+             */
+
+            if (queue_writerp != (writer_t *)0) {
+                (void)writer_service(queue_writerp);
+            }
+
+            if (sink_writerp != (writer_t *)0) {
+                (void)writer_service(sink_writerp);
+            }
+
+            if (trace_writerp != (writer_t *)0) {
+                (void)writer_service(trace_writerp);
+            }
+
+            if (capture_fp != (FILE *)0) {
+                (void)fflush(capture_fp);
+            }
+
+        } else if (periodic_service(&slow_timer, fd)) {
+
+            /* Do nothing. */
+
+        } else if (periodic_service(&keepalive_timer, fd)) {
+
+            /* Do nothing. */
+
+        } else if (periodic_service(&frequency_timer, fd)) {
+
+            /* Do nothing. */
+
+        } else if (periodic_service(&postpone_timer, fd)) {
+
+            /* Do nothing. */
+
+        } else if (periodic_service(&bypass_timer, fd)) {
+
+            /* Do nothing. */
+
         } else if (fd == in_fd) {
 
             /*
@@ -2187,69 +2723,170 @@ consume:
              * is a serious bug either in this software or in the transport.
              */
 
-            remote_total = endpoint_receive_datagram(remote_fd, &remote_buffer, sizeof(remote_buffer));
-            if (remote_total > 0) {
-                network_total += remote_total;
-            }
+            /*
+             * All of the datagrams waiting on the socket are received with
+             * one system call, then consumed one per iteration (like
+             * characters from the device's standard I/O buffer) before we
+             * go back to the socket. Likewise, the frames in a batched
+             * datagram are consumed one per iteration, as if each had
+             * arrived in a datagram of its own, before we go back to the
+             * batch.
+             */
+
+            if (datagram_unpacker_pending(&remote_unpacker) > 0) {
 
-            if (remote_total < sizeof(remote_buffer.header)) {
+                remote_bufferp = datagram_unpacker_next(&remote_unpacker, &remote_size);
+                diminuto_contract(remote_bufferp != (datagram_buffer_t *)0);
+                remote_size += 1; /* Plus trailing NUL. */
+                remote_total = sizeof(remote_bufferp->header) + remote_size;
+
+            } else {
 
                 /*
-                 * Too short.
+                 * If we are reordering, a datagram is released from the
+                 * reorder buffer when it's next in sequence (or the gap
+                 * in front of it is given up on); only when none can be
+                 * released is a received datagram inserted into the
+                 * reorder buffer. Otherwise a received datagram that
+                 * arrives out of order is discarded.
                  */
 
-                DIMINUTO_LOG_WARNING("Datagram Length [%zd]\n", remote_total);
+                remote_bufferp = (datagram_buffer_t *)0;
+
+                if (remote_reorder.slots == 0) {
+                    /* Do nothing. */
+                } else if ((remote_bufferp = datagram_reorder_next(&remote_reorder, &remote_total, diminuto_time_elapsed(), &remote_sequence, &missing_counter)) == (datagram_buffer_t *)0) {
+                    /* Do nothing. */
+                } else {
+                    remote_total += 1; /* Plus trailing NUL. */
+                    remote_size = remote_total - sizeof(remote_bufferp->header);
+                }
+
+                if (remote_bufferp == (datagram_buffer_t *)0) {
+
+                    if (datagram_batch_pending(&remote_batch) == 0) {
+                        (void)datagram_batch_receive(&remote_batch, remote_fd);
+                    }
+
+                    remote_bufferp = datagram_batch_next(&remote_batch, &remote_total, (const struct sockaddr_storage **)0);
+                    if (remote_bufferp == (datagram_buffer_t *)0) {
+                        remote_total = -1;
+                    } else {
+                        remote_total += 1; /* Plus trailing NUL. */
+                        network_total += remote_total;
+                    }
+
+                    if ((remote_bufferp == (datagram_buffer_t *)0) || (remote_total < sizeof(remote_bufferp->header))) {
+
+                        /*
+                         * Too short.
+                         */
+
+                        DIMINUTO_LOG_WARNING("Datagram Length [%zd]\n", remote_total);
+                        remote_bufferp = (datagram_buffer_t *)0;
+
+                    } else if (remote_reorder.slots > 0) {
+
+                        if (datagram_reorder_insert(&remote_reorder, &(remote_bufferp->header), remote_total - 1 /* Minus trailing NUL. */, diminuto_time_elapsed(), &remote_sequence, &outoforder_counter) < 0) {
+                            DIMINUTO_LOG_NOTICE("Datagram Order [%zd] {%lu} {%lu}\n", remote_total, (unsigned long)remote_sequence, (unsigned long)ntohl(remote_bufferp->header.sequence));
+                        }
+
+                        remote_bufferp = datagram_reorder_next(&remote_reorder, &remote_total, diminuto_time_elapsed(), &remote_sequence, &missing_counter);
+                        if (remote_bufferp != (datagram_buffer_t *)0) {
+                            remote_total += 1; /* Plus trailing NUL. */
+                            remote_size = remote_total - sizeof(remote_bufferp->header);
+                        }
+
+                    } else if ((remote_size = datagram_validate(&remote_sequence, &(remote_bufferp->header), remote_total, &outoforder_counter, &missing_counter)) < 0) {
+
+                        DIMINUTO_LOG_NOTICE("Datagram Order [%zd] {%lu} {%lu}\n", remote_total, (unsigned long)remote_sequence, (unsigned long)ntohl(remote_bufferp->header.sequence));
+                        remote_bufferp = (datagram_buffer_t *)0;
+
+                    } else {
+
+                        /* Do nothing. */
+
+                    }
+
+                }
+
+                if (remote_bufferp == (datagram_buffer_t *)0) {
+
+                    /* Do nothing. */
+
+                } else if (datagram_unpacker_start(&remote_unpacker, &(remote_bufferp->header), remote_total - 1 /* Minus trailing NUL. */) > 0) {
+
+                    /*
+                     * Batch.
+                     */
+
+                    DIMINUTO_LOG_DEBUG("Datagram Batch [%zd] [%u]", remote_total, datagram_unpacker_pending(&remote_unpacker));
+
+                    remote_bufferp = datagram_unpacker_next(&remote_unpacker, &remote_size);
+                    diminuto_contract(remote_bufferp != (datagram_buffer_t *)0);
+                    remote_size += 1; /* Plus trailing NUL. */
+                    remote_total = sizeof(remote_bufferp->header) + remote_size;
+
+                } else {
+
+                    /* Do nothing. */
+
+                }
+
+            }
 
-            } else if ((remote_size = datagram_validate(&remote_sequence, &remote_buffer.header, remote_total, &outoforder_counter, &missing_counter)) < 0) {
+            if (remote_bufferp == (datagram_buffer_t *)0) {
 
-                DIMINUTO_LOG_NOTICE("Datagram Order [%zd] {%lu} {%lu}\n", remote_total, (unsigned long)remote_sequence, (unsigned long)ntohl(remote_buffer.header.sequence));
+                /*
+                 * Too short or out of order.
+                 */
 
-            } else if (hazer_is_nmea(remote_buffer.payload.buffers.nmea[0]) && ((remote_length = hazer_validate(remote_buffer.payload.buffers.nmea, remote_size)) > 0)) {
+            } else if (hazer_is_nmea(remote_bufferp->payload.buffers.nmea[0]) && ((remote_length = hazer_validate(remote_bufferp->payload.buffers.nmea, remote_size)) > 0)) {
 
                 /*
                  * NMEA sentence.
                  */
 
-                buffer = remote_buffer.payload.buffers.nmea;
+                buffer = remote_bufferp->payload.buffers.nmea;
                 size = remote_size;
                 length = remote_length;
                 format = NMEA;
 
                 DIMINUTO_LOG_DEBUG("Datagram NMEA [%zd] [%zd] [%zd]", remote_total, remote_size, remote_length);
 
-            } else if (yodel_is_ubx(remote_buffer.payload.buffers.ubx[0]) && ((remote_length = yodel_validate(remote_buffer.payload.buffers.ubx, remote_size)) > 0)) {
+            } else if (yodel_is_ubx(remote_bufferp->payload.buffers.ubx[0]) && ((remote_length = yodel_validate(remote_bufferp->payload.buffers.ubx, remote_size)) > 0)) {
 
                 /*
                  * UBX packet.
                  */
 
-                buffer = remote_buffer.payload.buffers.ubx;
+                buffer = remote_bufferp->payload.buffers.ubx;
                 size = remote_size;
                 length = remote_length;
                 format = UBX;
 
                 DIMINUTO_LOG_DEBUG("Datagram UBX [%zd] [%zd] [%zd]", remote_total, remote_size, remote_length);
 
-            } else if (tumbleweed_is_rtcm(remote_buffer.payload.buffers.rtcm[0]) && ((remote_length = tumbleweed_validate(remote_buffer.payload.buffers.rtcm, remote_size)) > 0)) {
+            } else if (tumbleweed_is_rtcm(remote_bufferp->payload.buffers.rtcm[0]) && ((remote_length = tumbleweed_validate(remote_bufferp->payload.buffers.rtcm, remote_size)) > 0)) {
 
                 /*
                  * RTCM message.
                  */
 
-                buffer = remote_buffer.payload.buffers.rtcm;
+                buffer = remote_bufferp->payload.buffers.rtcm;
                 size = remote_size;
                 length = remote_length;
                 format = RTCM;
 
                 DIMINUTO_LOG_DEBUG("Datagram RTCM [%zd] [%zd] [%zd]", remote_total, remote_size, remote_length);
 
-            } else if (calico_is_cpo(remote_buffer.payload.buffers.cpo[0]) && ((remote_length = calico_validate(remote_buffer.payload.buffers.cpo, remote_size)) > 0)) {
+            } else if (calico_is_cpo(remote_bufferp->payload.buffers.cpo[0]) && ((remote_length = calico_validate(remote_bufferp->payload.buffers.cpo, remote_size)) > 0)) {
 
                 /*
                  * CPO packet.
                  */
 
-                buffer = remote_buffer.payload.buffers.cpo;
+                buffer = remote_bufferp->payload.buffers.cpo;
                 size = remote_size;
                 length = remote_length;
                 format = CPO;
@@ -2262,7 +2899,7 @@ consume:
                  * Other.
                  */
 
-                DIMINUTO_LOG_ERROR("Datagram Other [%zd] [%zd] [%zd] 0x%02x\n", remote_total, remote_size, remote_length, remote_buffer.payload.data[0]);
+                DIMINUTO_LOG_ERROR("Datagram Other [%zd] [%zd] [%zd] 0x%02x\n", remote_total, remote_size, remote_length, remote_bufferp->payload.data[0]);
 
             }
 
@@ -2278,56 +2915,89 @@ consume:
         } else if (fd == surveyor_fd) {
 
             /*
-             * Receive an RTCM datagram from a remote gpstool doing a survey.
+             * Receive RTCM datagrams from a remote gpstool doing a survey.
+             * All of the datagrams waiting on the socket are received with
+             * one system call and forwarded to the device here.
              */
 
-            surveyor_total = endpoint_receive_datagram(surveyor_fd, &surveyor_buffer, sizeof(surveyor_buffer));
-            if (surveyor_total > 0) {
-                network_total += surveyor_total;
-            }
+            /*
+             * If we are reordering, each received datagram is inserted
+             * into the reorder buffer, and every datagram that can be
+             * released from it, in sequence order, is forwarded, including
+             * those whose gaps have been given up on since the last time.
+             */
 
-            if (surveyor_total < sizeof(surveyor_buffer.header)) {
+            (void)datagram_batch_receive(&surveyor_batch, surveyor_fd);
 
-                DIMINUTO_LOG_WARNING("Surveyor Length [%zd]\n", surveyor_total);
+            while (!0) {
 
-            } else if ((surveyor_size = datagram_validate(&surveyor_sequence, &surveyor_buffer.header, surveyor_total, &outoforder_counter, &missing_counter)) < 0) {
+                if (surveyor_reorder.slots == 0) {
+                    if ((surveyor_bufferp = datagram_batch_next(&surveyor_batch, &surveyor_total, (const struct sockaddr_storage **)0)) == (datagram_buffer_t *)0) {
+                        break;
+                    }
+                    surveyor_total += 1; /* Plus trailing NUL. */
+                    network_total += surveyor_total;
+                } else if ((surveyor_bufferp = datagram_reorder_next(&surveyor_reorder, &surveyor_total, diminuto_time_elapsed(), &surveyor_sequence, &missing_counter)) != (datagram_buffer_t *)0) {
+                    surveyor_total += 1; /* Plus trailing NUL. */
+                    surveyor_size = surveyor_total - sizeof(surveyor_bufferp->header);
+                } else if ((surveyor_bufferp = datagram_batch_next(&surveyor_batch, &surveyor_total, (const struct sockaddr_storage **)0)) == (datagram_buffer_t *)0) {
+                    break;
+                } else {
+                    network_total += surveyor_total + 1 /* Plus trailing NUL. */;
+                    if (surveyor_total < sizeof(surveyor_bufferp->header)) {
+                        DIMINUTO_LOG_WARNING("Surveyor Length [%zd]\n", surveyor_total + 1);
+                    } else if (datagram_reorder_insert(&surveyor_reorder, &(surveyor_bufferp->header), surveyor_total, diminuto_time_elapsed(), &surveyor_sequence, &outoforder_counter) < 0) {
+                        DIMINUTO_LOG_NOTICE("Surveyor Order [%zd] {%lu} {%lu}\n", surveyor_total + 1, (unsigned long)surveyor_sequence, (unsigned long)ntohl(surveyor_bufferp->header.sequence));
+                    } else {
+                        /* Do nothing. */
+                    }
+                    continue;
+                }
 
-                DIMINUTO_LOG_NOTICE("Surveyor Order [%zd] {%lu} {%lu}\n", surveyor_total, (unsigned long)surveyor_sequence, (unsigned long)ntohl(surveyor_buffer.header.sequence));
+                if (surveyor_total < sizeof(surveyor_bufferp->header)) {
 
-            } else if ((surveyor_length = tumbleweed_validate(surveyor_buffer.payload.buffers.rtcm, surveyor_size)) < TUMBLEWEED_RTCM_SHORTEST) {
+                    DIMINUTO_LOG_WARNING("Surveyor Length [%zd]\n", surveyor_total);
 
-                DIMINUTO_LOG_ERROR("Surveyor Data [%zd] [%zd] [%zd] 0x%02x\n", surveyor_total, surveyor_size, surveyor_length, surveyor_buffer.payload.data[0]);
+                } else if ((surveyor_reorder.slots == 0) && ((surveyor_size = datagram_validate(&surveyor_sequence, &(surveyor_bufferp->header), surveyor_total, &outoforder_counter, &missing_counter)) < 0)) {
 
-            } else if (surveyor_length == TUMBLEWEED_RTCM_SHORTEST) {
+                    DIMINUTO_LOG_NOTICE("Surveyor Order [%zd] {%lu} {%lu}\n", surveyor_total, (unsigned long)surveyor_sequence, (unsigned long)ntohl(surveyor_bufferp->header.sequence));
 
-                DIMINUTO_LOG_DEBUG("Surveyor Keepalive received");
+                } else if ((surveyor_length = tumbleweed_validate(surveyor_bufferp->payload.buffers.rtcm, surveyor_size)) < TUMBLEWEED_RTCM_SHORTEST) {
 
-            } else if (dev_fp == (FILE *)0) {
+                    DIMINUTO_LOG_ERROR("Surveyor Data [%zd] [%zd] [%zd] 0x%02x\n", surveyor_total, surveyor_size, surveyor_length, surveyor_bufferp->payload.data[0]);
 
-                /* Do nothing. */
+                } else if (surveyor_length == TUMBLEWEED_RTCM_SHORTEST) {
 
-            } else {
+                    DIMINUTO_LOG_DEBUG("Surveyor Keepalive received");
 
-                kinematics.source = NETWORK;
+                } else if (dev_fp == (FILE *)0) {
 
-                kinematics.number = tumbleweed_message(surveyor_buffer.payload.buffers.rtcm, surveyor_length);
-                if (kinematics.number < 0) {
-                    kinematics.number = 9999;
-                }
-                helper_collect(kinematics.number, &updates);
+                    /* Do nothing. */
 
-                kinematics.length = surveyor_length;
+                } else {
 
-                kinematics.timeout = timeout;
-                refresh = !0;
+                    kinematics.source = NETWORK;
 
-                DIMINUTO_LOG_DEBUG("Surveyor RTCM [%zd] [%zd] [%zd] <%d>\n", surveyor_total, surveyor_size, surveyor_length, kinematics.number);
+                    kinematics.number = tumbleweed_message(surveyor_bufferp->payload.buffers.rtcm, surveyor_length);
+                    if (kinematics.number < 0) {
+                        kinematics.number = 9999;
+                    }
+                    helper_collect(kinematics.number, &updates);
+
+                    kinematics.length = surveyor_length;
+
+                    expiry_arm(&wheel, &kinematics_expiry, &kinematics.timeout, timeout);
+                    refresh = !0;
+
+                    DIMINUTO_LOG_DEBUG("Surveyor RTCM [%zd] [%zd] [%zd] <%d>\n", surveyor_total, surveyor_size, surveyor_length, kinematics.number);
+
+                    if (verbose) {
+                        fputs("Datagram:\n", stderr);
+                        diminuto_dump(stderr, surveyor_bufferp, surveyor_total);
+                    }
+                    buffer_write(dev_fp, surveyor_bufferp->payload.buffers.rtcm, surveyor_length);
 
-                if (verbose) {
-                    fputs("Datagram:\n", stderr);
-                    diminuto_dump(stderr, &surveyor_buffer, surveyor_total);
                 }
-                buffer_write(dev_fp, surveyor_buffer.payload.buffers.rtcm, surveyor_length);
 
             }
 
@@ -2367,6 +3037,10 @@ consume:
         Now = diminuto_time_elapsed();
         diminuto_contract(Now >= 0);
 
+        if (refclock_unit >= 0) {
+            edge_stamp(&received, &receivedmonotonic);
+        }
+
         /**
          ** KEEPALIVE
          **/
@@ -2394,7 +3068,7 @@ consume:
             /* Do nothing. */
         } else if (!diminuto_list_isempty(&command_list)) {
             /* Do nothing. */
-        } else if (!time_expired(&keepalive_last, keepalive)) {
+        } else if (!periodic_expired(&keepalive_timer)) {
             /* Do nothing. */
         } else {
 
@@ -2434,7 +3108,7 @@ consume:
             /* Do nothing. */
         } else if (diminuto_list_isempty(&command_list)) {
             /* Do nothing. */
-        } else if (!time_expired(&postpone_last, postpone)) {
+        } else if (!periodic_expired(&postpone_timer)) {
             /* Do nothing. */
         } else {
 
@@ -2588,6 +3262,29 @@ consume:
             fflush(queue_fp);
         }
 
+        /*
+         * CAPTURE
+         */
+
+        /*
+         * We capture everything, whatever the queueing mask, so that the
+         * capture can be filtered later. The receive time is when the frame
+         * is complete.
+         */
+
+        if (capturep != (capture_t *)0) {
+            switch (format) {
+            case NMEA:  capture_protocol = CAPTURE_NMEA;    break;
+            case UBX:   capture_protocol = CAPTURE_UBX;     break;
+            case RTCM:  capture_protocol = CAPTURE_RTCM;    break;
+            case CPO:   capture_protocol = CAPTURE_CPO;     break;
+            default:    capture_protocol = CAPTURE_OTHER;   break;
+            }
+            if (capture_write(capturep, capture_now(), capture_protocol, buffer, size - 1 /* Minus trailing NUL. */) < 0) {
+                diminuto_perror("capture_write");
+            }
+        }
+
         /**
          ** FORWARD
          **/
@@ -2607,6 +3304,56 @@ consume:
             /* Do nothing. */
         } else if ((remote_mask & format) == 0) {
             /* Do nothing. */
+        } else if ((remote_budget > 0) && (datagram_packer_append(&remote_packer, buffer, length) == 0)) {
+
+            /*
+             * Batched with the other frames of this epoch. The batch is
+             * forwarded when the next frame doesn't fit, when the window
+             * has expired, or when the input goes quiet (see TOP).
+             */
+
+            if (datagram_packer_pending(&remote_packer) == 1) {
+                remote_packed = Now;
+            }
+
+            if (remote_window <= 0) {
+                /* Do nothing. */
+            } else if ((Now - remote_packed) < remote_window) {
+                /* Do nothing. */
+            } else if ((remote_total = endpoint_send_packer(remote_fd, remote_protocol, &remote_endpoint.ipv4, &remote_endpoint.ipv6, remote_endpoint.udp, &remote_packer, &remote_sequence)) > 0) {
+                network_total += remote_total;
+                DIMINUTO_LOG_DEBUG("Datagram Batch Sent [%zd] [%zd]", remote_total, network_total);
+            } else {
+                /* Do nothing. */
+            }
+
+        } else if ((remote_budget > 0) && (datagram_packer_pending(&remote_packer) > 0)) {
+
+            /*
+             * The frame doesn't fit in the batch, so the batch is forwarded
+             * and the frame starts a new one (or, if it's too big for any
+             * batch, is forwarded by itself).
+             */
+
+            remote_total = endpoint_send_packer(remote_fd, remote_protocol, &remote_endpoint.ipv4, &remote_endpoint.ipv6, remote_endpoint.udp, &remote_packer, &remote_sequence);
+            if (remote_total > 0) {
+                network_total += remote_total;
+                DIMINUTO_LOG_DEBUG("Datagram Batch Sent [%zd] [%zd]", remote_total, network_total);
+            }
+
+            if (datagram_packer_append(&remote_packer, buffer, length) == 0) {
+                remote_packed = Now;
+            } else {
+                datagram_buffer_t * dp;
+                dp = diminuto_containerof(datagram_buffer_t, payload, buffer);
+                datagram_stamp(&(dp->header), &remote_sequence);
+                remote_total = endpoint_send_datagram(remote_fd, remote_protocol, &remote_endpoint.ipv4, &remote_endpoint.ipv6, remote_endpoint.udp, dp, sizeof(dp->header) + length);
+                if (remote_total > 0) {
+                    network_total += remote_total;
+                    DIMINUTO_LOG_DEBUG("Datagram Sent 0x%x [%zd] [%zd]", format, remote_total, network_total);
+                }
+            }
+
         } else {
             datagram_buffer_t * dp;
             dp = diminuto_containerof(datagram_buffer_t, payload, buffer);
@@ -2674,45 +3421,21 @@ consume:
          **/
 
         /*
-         *
-         * See how many seconds have elapsed since the last time we received
-         * a valid message from any system we recognize. (Might be zero.)
-         * Subtract that number from all the lifetimes of all the systems we
-         * care about to figure out if there's a system from which we've
-         * stopped hearing. This implements an expiration for each entry in our
-         * database, because NMEA isn't kind enough to remind us that we
-         * haven't heard from a system lately (and UBX isn't kind enough to
-         * remind us when a device has stopped transmitting entirely); hence
-         * data can get stale and needs to be aged out. (We subtract one to
-         * eliminate what is almost certainly a partial second.)
+         * Advance the expiry wheel to the current second. Every structure
+         * in our database armed an entry in the wheel with its lifetime
+         * when it was last updated; the entries whose lifetimes have run out
+         * have their timeout fields zeroed so that the print functions know
+         * we've stopped hearing about them. This implements an expiration for
+         * each entry in our database, because NMEA isn't kind enough to
+         * remind us that we haven't heard from a system lately (and UBX isn't
+         * kind enough to remind us when a device has stopped transmitting
+         * entirely); hence data can get stale and needs to be aged out. Only
+         * the entries that are due are touched, and any expiration forces a
+         * redraw so that stale data disappears from the display.
          */
 
-        expiration_was = expiration_now;
-        expiration_now = Now / Frequency;
-        elapsed = (expiration_now > expiration_was) ? expiration_now - expiration_was : 0;
-
-        if (elapsed > 0) {
-
-            for (ii = 0; ii < HAZER_SYSTEM_TOTAL; ++ii) {
-                if (ii > maximum) { break; }
-                time_countdown(&positions[ii].timeout, elapsed);
-                time_countdown(&actives[ii].timeout, elapsed);
-                for (jj = 0; jj < HAZER_GNSS_SIGNALS; ++jj) {
-                    if (jj >= views[ii].signals) { break; }
-                    time_countdown(&views[ii].sig[jj].timeout, elapsed);
-                }
-            }
-
-            time_countdown(&solution.timeout, elapsed);
-            time_countdown(&hardware.timeout, elapsed);
-            time_countdown(&status.timeout, elapsed);
-            time_countdown(&base.timeout, elapsed);
-            time_countdown(&rover.timeout, elapsed);
-            time_countdown(&attitude.timeout, elapsed);
-            time_countdown(&odometer.timeout, elapsed);
-            time_countdown(&posveltim.timeout, elapsed);
-            time_countdown(&kinematics.timeout, elapsed);
-
+        if (expiry_advance(&wheel, Now / Frequency) > 0) {
+            refresh = !0;
         }
 
         /**
@@ -2809,7 +3532,7 @@ consume:
                 rc = hazer_parse_gga(&positions[system], vector, count);
                 if (rc == 0) {
 
-                    positions[system].timeout = timeout;
+                    expiry_arm(&wheel, &positions_expiry[system], &positions[system].timeout, timeout);
                     refresh = !0;
                     trace = !0;
 
@@ -2836,12 +3559,21 @@ consume:
                 rc = hazer_parse_rmc(&positions[system], vector, count);
                 if (rc == 0) {
 
-                    positions[system].timeout = timeout;
+                    expiry_arm(&wheel, &positions_expiry[system], &positions[system].timeout, timeout);
                     refresh = !0;
                     trace = !0;
 
                     fix_acquired("NMEA RMC");
 
+                    /*
+                     * RMC is only valid when the receiver has a fix, so
+                     * unlike ZDA its time can be trusted by NTP.
+                     */
+
+                    if ((refclock_unit >= 0) && hazer_is_valid_time(&positions[system])) {
+                        (void)refclock_time(&refclock, (pulse_nanoseconds_t)positions[system].tot_nanoseconds, received);
+                    }
+
                 } else if (errno == 0) {
 
                     fix_relinquished("NMEA RMC");
@@ -2863,7 +3595,7 @@ consume:
                 rc = hazer_parse_gll(&positions[system], vector, count);
                 if (rc == 0) {
 
-                    positions[system].timeout = timeout;
+                    expiry_arm(&wheel, &positions_expiry[system], &positions[system].timeout, timeout);
                     refresh = !0;
                     trace = !0;
 
@@ -2890,7 +3622,7 @@ consume:
                 rc = hazer_parse_vtg(&positions[system], vector, count);
                 if (rc == 0) {
 
-                    positions[system].timeout = timeout;
+                    expiry_arm(&wheel, &positions_expiry[system], &positions[system].timeout, timeout);
                     refresh = !0;
 
                 } else if (errno == 0) {
@@ -2947,7 +3679,7 @@ consume:
                     }
 
                     actives[system] = active_cache;
-                    actives[system].timeout = timeout;
+                    expiry_arm(&wheel, &actives_expiry[system], &actives[system].timeout, timeout);
                     refresh = !0;
 
                 } else {
@@ -2967,7 +3699,7 @@ consume:
                 rc = hazer_parse_gsv(&views[system], vector, count);
                 if  (rc >= 0) {
 
-                    views[system].sig[rc].timeout = timeout;
+                    expiry_arm(&wheel, &views_expiry[system][rc], &views[system].sig[rc].timeout, timeout);
 
                     if (views[system].pending == 0) {
                         refresh = !0;
@@ -2993,7 +3725,7 @@ consume:
                 rc = hazer_parse_zda(&positions[system], vector, count);
                 if (rc == 0) {
 
-                    positions[system].timeout = timeout;
+                    expiry_arm(&wheel, &positions_expiry[system], &positions[system].timeout, timeout);
                     refresh = !0;
 
                     /*
@@ -3070,8 +3802,8 @@ consume:
                 rc = hazer_parse_pubx_position(&positions[system], &actives[system], vector, count);
                 if  (rc == 0) {
 
-                    positions[system].timeout = timeout;
-                    actives[system].timeout = timeout;
+                    expiry_arm(&wheel, &positions_expiry[system], &positions[system].timeout, timeout);
+                    expiry_arm(&wheel, &actives_expiry[system], &actives[system].timeout, timeout);
                     refresh = !0;
                     trace = !0;
 
@@ -3110,7 +3842,7 @@ consume:
                                 systems[system] = true;
                             }
 
-                            views[system].sig[0].timeout = timeout;
+                            expiry_arm(&wheel, &views_expiry[system][0], &views[system].sig[0].timeout, timeout);
 
                             if (system == HAZER_SYSTEM_GNSS) {
 
@@ -3130,7 +3862,7 @@ consume:
 
                             }
 
-                            actives[system].timeout = timeout;
+                            expiry_arm(&wheel, &actives_expiry[system], &actives[system].timeout, timeout);
                             refresh = !0;
                             DIMINUTO_LOG_DEBUG("Received PUBX SVSTATUS (%s)\n", HAZER_SYSTEM_NAME[system]);
                         }
@@ -3202,7 +3934,7 @@ consume:
                 rc = yodel_ubx_nav_hpposllh(&(solution.payload), buffer, length);
                 if (rc == 0) {
 
-                    solution.timeout = timeout;
+                    expiry_arm(&wheel, &solution_expiry, &solution.timeout, timeout);
                     refresh = !0;
                     trace = !0;
 
@@ -3247,7 +3979,7 @@ consume:
                 rc = yodel_ubx_mon_hw(&(hardware.payload), buffer, length);
                 if (rc == 0) {
 
-                    hardware.timeout = timeout;
+                    expiry_arm(&wheel, &hardware_expiry, &hardware.timeout, timeout);
                     refresh = !0;
 
                 } else {
@@ -3267,7 +3999,7 @@ consume:
                 rc = yodel_ubx_nav_status(&(status.payload), buffer, length);
                 if (rc == 0) {
 
-                    status.timeout = timeout;
+                    expiry_arm(&wheel, &status_expiry, &status.timeout, timeout);
                     refresh = !0;
 
                 } else {
@@ -3347,7 +4079,7 @@ consume:
                 rc = yodel_ubx_nav_svin(&base.payload, buffer, length);
                 if (rc == 0) {
 
-                    base.timeout = timeout;
+                    expiry_arm(&wheel, &base_expiry, &base.timeout, timeout);
                     refresh = !0;
 
                 } else {
@@ -3367,7 +4099,7 @@ consume:
                 rc = yodel_ubx_nav_att(&(attitude.payload), buffer, length);
                 if (rc == 0) {
 
-                    attitude.timeout = timeout;
+                    expiry_arm(&wheel, &attitude_expiry, &attitude.timeout, timeout);
                     refresh = !0;
 
                 } else {
@@ -3387,7 +4119,7 @@ consume:
                 rc = yodel_ubx_nav_odo(&(odometer.payload), buffer, length);
                 if (rc == 0) {
 
-                    odometer.timeout = timeout;
+                    expiry_arm(&wheel, &odometer_expiry, &odometer.timeout, timeout);
                     refresh = !0;
 
                 } else {
@@ -3407,7 +4139,7 @@ consume:
                 rc = yodel_ubx_nav_pvt(&(posveltim.payload), buffer, length);
                 if (rc == 0) {
 
-                    posveltim.timeout = timeout;
+                    expiry_arm(&wheel, &posveltim_expiry, &posveltim.timeout, timeout);
                     refresh = !0;
 
                 } else {
@@ -3427,7 +4159,7 @@ consume:
                 rc = yodel_ubx_rxm_rtcm(&rover.payload, buffer, length);
                 if (rc == 0) {
 
-                    rover.timeout = timeout;
+                    expiry_arm(&wheel, &rover_expiry, &rover.timeout, timeout);
                     refresh = !0;
 
                 } else {
@@ -3487,7 +4219,15 @@ consume:
 
                 DIMINUTO_LOG_DEBUG("Parse UBX UBX-NAV-TIMEUTC\n");
 
-                /* TODO */
+                if (yodel_ubx_nav_timeutc(&timeutc, buffer, length) < 0) {
+                    /* Do nothing. */
+                } else if (edge_timeutc2utc(&timeutc, &timeutc_utc) < 0) {
+                    /* Do nothing. */
+                } else if (refclock_unit >= 0) {
+                    (void)refclock_time(&refclock, timeutc_utc, received);
+                } else {
+                    /* Do nothing. */
+                }
 
             } else if (yodel_is_ubx_class_id(buffer, length, YODEL_UBX_NAV_CLOCK_Class, YODEL_UBX_NAV_CLOCK_Id)) {
 
@@ -3507,7 +4247,18 @@ consume:
 
                 DIMINUTO_LOG_DEBUG("Parse UBX UBX-TIM-TP\n");
 
-                /* TODO */
+                /*
+                 * UBX-TIM-TP tells us the time of the *next* time pulse;
+                 * that edge is measured against it once it arrives.
+                 */
+
+                if (yodel_ubx_tim_tp(&timepulse, buffer, length) < 0) {
+                    /* Do nothing. */
+                } else if (edge_timtp2utc(&timepulse, &timepulse_utc) < 0) {
+                    /* Do nothing. */
+                } else {
+                    expiry_arm(&wheel, &timepulse_expiry, &timepulse_timeout, timeout);
+                }
 
             } else if (yodel_is_ubx_class_id(buffer, length, YODEL_UBX_RXM_RAWX_Class , YODEL_UBX_RXM_RAWX_Id)) {
 
@@ -3567,7 +4318,7 @@ consume:
 
             kinematics.length = length;
 
-            kinematics.timeout = timeout;
+            expiry_arm(&wheel, &kinematics_expiry, &kinematics.timeout, timeout);
             refresh = !0;
 
             DIMINUTO_LOG_DEBUG("Received RTCM (%d) [%lld]\n", kinematics.number, (long long int)kinematics.length);
@@ -3602,7 +4353,7 @@ consume:
                         systems[system] = true;
                     }
 
-                    positions[system].timeout = timeout;
+                    expiry_arm(&wheel, &positions_expiry[system], &positions[system].timeout, timeout);
                     refresh = !0;
                     trace = !0;
 
@@ -3648,8 +4399,8 @@ consume:
                                 systems[system] = true;
                             }
 
-                            views[system].sig[HAZER_SIGNAL_ANY].timeout = timeout;
-                            actives[system].timeout = timeout;
+                            expiry_arm(&wheel, &views_expiry[system][HAZER_SIGNAL_ANY], &views[system].sig[HAZER_SIGNAL_ANY].timeout, timeout);
+                            expiry_arm(&wheel, &actives_expiry[system], &actives[system].timeout, timeout);
                             refresh = !0;
                             trace = !0;
 
@@ -3745,10 +4496,14 @@ consume:
             /* Do nothing. */
         } else if (!trace) {
             /* Do nothing. */
-        } else if (!time_expired(&frequency_last, frequency)) {
+        } else if (!periodic_expired(&frequency_timer)) {
             /* Do nothing. */
         } else {
-            emit_trace(trace_fp, positions, &solution, &attitude, &posveltim, &base, hangup);
+            if (binary) {
+                emit_record(trace_fp, positions, &solution, &attitude, &posveltim, &base, hangup);
+            } else {
+                emit_trace(trace_fp, positions, &solution, &attitude, &posveltim, &base, hangup);
+            }
             trace = 0;
             hangup = 0;
         }
@@ -3795,16 +4550,32 @@ consume:
          * is all about. Note that the code below is non-blocking.
          */
 
-        DIMINUTO_LOG_DEBUG("Bottom %d\n", ((Now / Frequency) >= (bypass_last + bypass)));
+        DIMINUTO_LOG_DEBUG("Bottom %d\n", bypass_timer.pending);
 
         available = 0;
         ready = 0;
         fd = -1;
 
-        if (time_expired(&bypass_last, bypass)) {
+        /*
+         * As at the top of the loop, ask the timers directly now and then,
+         * so that saturated input cannot keep the bypass from expiring.
+         */
+
+        timer_fd = -1;
+        if ((Now - polled) >= (Frequency / PERIODIC_POLLS)) {
+            polled = Now;
+            timer_fd = periodic_ready(timers, countof(timers));
+        }
+
+        if (periodic_expired(&bypass_timer)) {
 
             /* Do nothing. */
 
+        } else if (timer_fd >= 0) {
+
+            fd = timer_fd;
+            goto consume;
+
         } else if (hazer_has_pending_gsv(views, maximum)) {
 
             fd = in_fd;
@@ -3826,6 +4597,16 @@ consume:
             }
             goto consume;
 
+        } else if ((datagram_batch_pending(&remote_batch) > 0) || (datagram_unpacker_pending(&remote_unpacker) > 0) || datagram_reorder_ready(&remote_reorder, remote_sequence, Now)) {
+
+            fd = remote_fd;
+            goto consume;
+
+        } else if (datagram_reorder_ready(&surveyor_reorder, surveyor_sequence, Now)) {
+
+            fd = surveyor_fd;
+            goto consume;
+
         } else if ((fd = diminuto_mux_ready_read(&mux)) >= 0) {
 
             goto consume;
@@ -3856,12 +4637,30 @@ consume:
 
 render:
 
-        DIMINUTO_LOG_DEBUG("Render %d %d %d\n", ((Now / Frequency) >= (slow_last + slow)), refresh, report);
+        DIMINUTO_LOG_DEBUG("Render %d %d %d\n", slow_timer.pending, refresh, report);
 
         if (sink_fp != (FILE *)0) {
             fflush(sink_fp);
         }
 
+        /*
+         * We render after we've consumed a burst of input, which for a
+         * GNSS receiver is the end of an epoch, so this is where the
+         * background writers hand off what they've accumulated.
+         */
+
+        if (queue_writerp != (writer_t *)0) {
+            (void)writer_flush(queue_writerp);
+        }
+
+        if (sink_writerp != (writer_t *)0) {
+            (void)writer_flush(sink_writerp);
+        }
+
+        if (trace_writerp != (writer_t *)0) {
+            (void)writer_flush(trace_writerp);
+        }
+
 #if defined(TEST_EXPIRATION)
 #   warning TEST_EXPIRATION enabled!
 
@@ -3886,6 +4685,7 @@ render:
 
         } else {
             static int crowbar = 1000;
+            int jj = 0;
 
             if (crowbar <= 0) {
                 for (ii = 0; ii < HAZER_SYSTEM_TOTAL; ++ii) {
@@ -3934,11 +4734,48 @@ render:
 
 #endif
 
+        /*
+         * Publish the fix in shared memory if it has changed. This isn't
+         * slowed down like the display is: it's just a copy, and readers
+         * get whatever is the latest without ever blocking us.
+         */
+
+        if (snapshotp == (snapshot_region_t *)0) {
+
+            /* Do nothing. */
+
+        } else if (!refresh) {
+
+            /* Do nothing. */
+
+        } else {
+            int jj = 0;
+
+            snapshot_begin(snapshotp);
+                memcpy(snapshotp->fix.positions, positions, sizeof(snapshotp->fix.positions));
+                memcpy(snapshotp->fix.actives, actives, sizeof(snapshotp->fix.actives));
+                for (ii = 0; ii < HAZER_SYSTEM_TOTAL; ++ii) {
+                    for (jj = 0; jj < HAZER_GNSS_SIGNALS; ++jj) {
+                        snapshotp->fix.views[ii][jj].visible = views[ii].sig[jj].visible;
+                        snapshotp->fix.views[ii][jj].channels = views[ii].sig[jj].channels;
+                        snapshotp->fix.views[ii][jj].timeout = views[ii].sig[jj].timeout;
+                    }
+                }
+                snapshotp->fix.solution = solution.payload;
+                snapshotp->fix.solution_timeout = solution.timeout;
+                snapshotp->fix.posveltim = posveltim.payload;
+                snapshotp->fix.posveltim_timeout = posveltim.timeout;
+                snapshotp->fix.attitude = attitude.payload;
+                snapshotp->fix.attitude_timeout = attitude.timeout;
+            snapshot_end(snapshotp);
+
+        }
+
         /*
          * Generate the display if necessary and sufficient reasons exist.
          */
 
-        if (!time_expired(&slow_last, slow)) {
+        if (!periodic_expired(&slow_timer)) {
 
             /* Do nothing. */
 
@@ -3954,6 +4791,7 @@ render:
                 DIMINUTO_CRITICAL_SECTION_BEGIN(&Mutex);
                     onepps = poller.onepps;
                     onehz = poller.onehz;
+                    edges = poller.edges;
                 DIMINUTO_CRITICAL_SECTION_END;
 
                 if ((pulsing) && (onehz >= TOLERANCE)) {
@@ -3979,6 +4817,9 @@ render:
             if (report) {
                 print_local(out_fp);
                 print_positions(out_fp, positions, maximum, onepps, pulsing, network_total);
+                if ((edgep = pulse_ring_get(&edges, 0)) != (const pulse_edge_t *)0) {
+                    print_pulse(out_fp, &pulses, edgep->source);
+                }
                 print_hardware(out_fp, &hardware);
                 print_status(out_fp, &status);
                 print_solution(out_fp, &solution);
@@ -4060,8 +4901,32 @@ stop:
         sync_end();
     }
 
+    if (pulses.count > 0) {
+        DIMINUTO_LOG_INFORMATION("Pulse Count=%llu Offset=%lldns Minimum=%lldns Maximum=%lldns Mean=%.0lfns Jitter=%.0lfns\n", (unsigned long long)pulses.count, (long long)pulses.offset, (long long)pulses.minimum, (long long)pulses.maximum, pulses.mean, pulse_jitter(&pulses));
+    }
+
+    if (snapshotp != (snapshot_region_t *)0) {
+        snapshotp = snapshot_destroy(snapshotp, snapshot_name);
+        diminuto_contract(snapshotp == (snapshot_region_t *)0);
+    }
+
+    if (refclock_unit >= 0) {
+        DIMINUTO_LOG_INFORMATION("NTP SHM Times=%llu Pulses=%llu\n", (unsigned long long)refclock.times, (unsigned long long)refclock.pulses);
+        refclock_fini(&refclock);
+    }
+
+    DIMINUTO_LOG_INFORMATION("Batches Remote=%llu/%llu/%u Surveyor=%llu/%llu/%u", (unsigned long long)remote_batch.packets, (unsigned long long)remote_batch.wakeups, remote_batch.maximum, (unsigned long long)surveyor_batch.packets, (unsigned long long)surveyor_batch.wakeups, surveyor_batch.maximum);
+
     DIMINUTO_LOG_INFORMATION("Counters Remote=%lu Surveyor=%lu Keepalive=%lu OutOfOrder=%u Missing=%u", (unsigned long)remote_sequence, (unsigned long)surveyor_sequence, (unsigned long)keepalive_sequence, outoforder_counter, missing_counter);
 
+    if (remote_reorder.slots > 0) {
+        DIMINUTO_LOG_INFORMATION("Reorder Remote Reordered=%llu Expired=%llu Depth=%llu/%llu/%llu/%llu/%llu/%llu/%llu/%llu+", (unsigned long long)remote_reorder.reordered, (unsigned long long)remote_reorder.expired, (unsigned long long)remote_reorder.histogram[0], (unsigned long long)remote_reorder.histogram[1], (unsigned long long)remote_reorder.histogram[2], (unsigned long long)remote_reorder.histogram[3], (unsigned long long)remote_reorder.histogram[4], (unsigned long long)remote_reorder.histogram[5], (unsigned long long)remote_reorder.histogram[6], (unsigned long long)remote_reorder.histogram[7]);
+    }
+
+    if (surveyor_reorder.slots > 0) {
+        DIMINUTO_LOG_INFORMATION("Reorder Surveyor Reordered=%llu Expired=%llu Depth=%llu/%llu/%llu/%llu/%llu/%llu/%llu/%llu+", (unsigned long long)surveyor_reorder.reordered, (unsigned long long)surveyor_reorder.expired, (unsigned long long)surveyor_reorder.histogram[0], (unsigned long long)surveyor_reorder.histogram[1], (unsigned long long)surveyor_reorder.histogram[2], (unsigned long long)surveyor_reorder.histogram[3], (unsigned long long)surveyor_reorder.histogram[4], (unsigned long long)surveyor_reorder.histogram[5], (unsigned long long)surveyor_reorder.histogram[6], (unsigned long long)surveyor_reorder.histogram[7]);
+    }
+
     rc = calico_finalize();
     diminuto_contract(rc == 0);
 
@@ -4076,12 +4941,12 @@ stop:
 
     diminuto_mux_fini(&mux);
 
-    if (timerp != (diminuto_timer_t *)0) {
-        timerticks = diminuto_timer_stop(timerp);
-        diminuto_contract(timerticks >= 0);
-        timerp = diminuto_timer_fini(timerp);
-        diminuto_contract(timerp == (diminuto_timer_t *)0);
-    }
+    periodic_fini(&onehz_timer);
+    periodic_fini(&slow_timer);
+    periodic_fini(&keepalive_timer);
+    periodic_fini(&frequency_timer);
+    periodic_fini(&postpone_timer);
+    periodic_fini(&bypass_timer);
 
     if (threadp != (diminuto_thread_t *)0) {
         DIMINUTO_COHERENT_SECTION_BEGIN;
@@ -4102,12 +4967,27 @@ stop:
         diminuto_contract(pps_fd < 0);
     }
 
+    if (ppsapi_fd >= 0) {
+        rc = close(ppsapi_fd);
+        diminuto_contract(rc >= 0);
+        ppsapi_fd = -1;
+    }
+
     if (strobe_fd >= 0) {
         strobe_fd = diminuto_line_close(strobe_fd);
         diminuto_contract(strobe_fd < 0);
     }
 
     if (remote_fd >= 0) {
+        if (datagram_packer_pending(&remote_packer) > 0) {
+            (void)endpoint_send_packer(remote_fd, remote_protocol, &remote_endpoint.ipv4, &remote_endpoint.ipv6, remote_endpoint.udp, &remote_packer, &remote_sequence);
+        }
+        if (remote_packer.datagrams > 0) {
+            DIMINUTO_LOG_INFORMATION("Remote Packed Frames=%llu Datagrams=%llu\n", (unsigned long long)remote_packer.frames, (unsigned long long)remote_packer.datagrams);
+        }
+        if (remote_unpacker.datagrams > 0) {
+            DIMINUTO_LOG_INFORMATION("Remote Unpacked Frames=%llu Datagrams=%llu\n", (unsigned long long)remote_unpacker.frames, (unsigned long long)remote_unpacker.datagrams);
+        }
         rc = diminuto_ipc_close(remote_fd);
         diminuto_contract(rc >= 0);
     }
@@ -4132,6 +5012,24 @@ stop:
         diminuto_perror("fclose(queue_fp)");
     }
 
+    if (capturep == (capture_t *)0) {
+        /* Do nothing. */
+    } else if (capture_fini(capturep) < 0) {
+        diminuto_perror("capture_fini");
+    } else {
+        DIMINUTO_LOG_INFORMATION("Capture Records=%llu Bytes=%llu\n", (unsigned long long)capturep->records, (unsigned long long)capturep->offset);
+    }
+
+    if (capture_fp == (FILE *)0) {
+        /* Do nothing. */
+    } else if (capture_fp == stdout) {
+        /* Do nothing. */
+    } else if ((rc = fclose(capture_fp)) != EOF) {
+        /* Do nothing. */
+    } else {
+        diminuto_perror("fclose(capture_fp)");
+    }
+
     if (listing_fp == (FILE *)0) {
         /* Do nothing. */
     } else if (listing_fp == stderr) {
@@ -4171,6 +5069,18 @@ stop:
         diminuto_perror("fclose(sink_fp)");
     }
 
+    if (queue_writerp != (writer_t *)0) {
+        log_writer("Queue", queue_writerp);
+    }
+
+    if (sink_writerp != (writer_t *)0) {
+        log_writer("Sink", sink_writerp);
+    }
+
+    if (trace_writerp != (writer_t *)0) {
+        log_writer("Trace", trace_writerp);
+    }
+
     if (in_fp == (FILE *)0) {
         /* Do nothing. */
     } else if (in_fp == dev_fp) {
@@ -0,0 +1,144 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This implements the gpstool periodic timers.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+#include "com/diag/diminuto/diminuto_log.h"
+#include "periodic.h"
+
+int periodic_init(periodic_t * pp, seconds_t seconds, int immediate)
+{
+    struct itimerspec its = { { 0, }, };
+    int fd = -1;
+
+    pp->fd = -1;
+    pp->seconds = seconds;
+    pp->expirations = 0;
+    pp->pending = 0;
+
+    if (seconds <= 0) {
+        /* Do nothing. */
+    } else if ((fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+        diminuto_perror("periodic_init: timerfd_create");
+    } else {
+        its.it_interval.tv_sec = seconds;
+        its.it_interval.tv_nsec = 0;
+        if (immediate) {
+            its.it_value.tv_sec = 0;
+            its.it_value.tv_nsec = 1;
+        } else {
+            its.it_value = its.it_interval;
+        }
+        if (timerfd_settime(fd, 0, &its, (struct itimerspec *)0) < 0) {
+            diminuto_perror("periodic_init: timerfd_settime");
+            (void)close(fd);
+        } else {
+            pp->fd = fd;
+        }
+    }
+
+    return pp->fd;
+}
+
+int periodic_service(periodic_t * pp, int fd)
+{
+    int result = 0;
+    uint64_t count = 0;
+    ssize_t rc = -1;
+
+    if (pp->fd < 0) {
+        /* Do nothing. */
+    } else if (fd != pp->fd) {
+        /* Do nothing. */
+    } else if ((rc = read(fd, &count, sizeof(count))) == sizeof(count)) {
+        pp->expirations += count;
+        pp->pending = !0;
+        result = !0;
+    } else if ((rc < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+        result = !0;
+    } else {
+        diminuto_perror("periodic_service: read");
+        result = !0;
+    }
+
+    return result;
+}
+
+int periodic_expired(periodic_t * pp)
+{
+    int result = 0;
+
+    if (pp->seconds < 0) {
+        /* Do nothing. */
+    } else if (pp->seconds == 0) {
+        result = !0;
+    } else if (pp->pending) {
+        pp->pending = 0;
+        result = !0;
+    } else {
+        /* Do nothing. */
+    }
+
+    return result;
+}
+
+int periodic_ready(periodic_t * const timers[], size_t count)
+{
+    int fd = -1;
+    struct pollfd pfd[PERIODIC_TIMERS];
+    nfds_t nfds = 0;
+    size_t ii = 0;
+    int rc = -1;
+
+    for (ii = 0; (ii < count) && (nfds < PERIODIC_TIMERS); ++ii) {
+        if (timers[ii]->fd >= 0) {
+            pfd[nfds].fd = timers[ii]->fd;
+            pfd[nfds].events = POLLIN;
+            pfd[nfds].revents = 0;
+            nfds += 1;
+        }
+    }
+
+    if (nfds == 0) {
+        /* Do nothing. */
+    } else if ((rc = poll(pfd, nfds, 0 /* POLL */)) < 0) {
+        if (errno != EINTR) {
+            diminuto_perror("periodic_ready: poll");
+        }
+    } else if (rc == 0) {
+        /* Do nothing. */
+    } else {
+        for (ii = 0; ii < nfds; ++ii) {
+            if ((pfd[ii].revents & POLLIN) != 0) {
+                fd = pfd[ii].fd;
+                break;
+            }
+        }
+    }
+
+    return fd;
+}
+
+void periodic_fini(periodic_t * pp)
+{
+    if (pp->fd < 0) {
+        /* Do nothing. */
+    } else if (close(pp->fd) < 0) {
+        diminuto_perror("periodic_fini: close");
+    } else {
+        /* Do nothing. */
+    }
+
+    pp->fd = -1;
+}
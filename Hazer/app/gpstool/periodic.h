@@ -0,0 +1,107 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_GPSTOOL_PERIODIC_
+#define _H_COM_DIAG_HAZER_GPSTOOL_PERIODIC_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This declares and defines the gpstool periodic timers.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A periodic timer is a Linux timerfd whose file descriptor is registered
+ * in the same multiplexor as the device and the sockets, so that all of
+ * the periodic work in the main loop (the one hertz 1PPS tolerance count,
+ * keepalives, command postponement, trace frequency, display slowdown,
+ * and the input bypass) is driven by deterministic wakeups in the main
+ * thread, instead of by a separate timer thread and by multiplexor
+ * timeouts. An expiration is latched when the timer's file descriptor is
+ * serviced, and consumed when the main loop asks if the timer has expired.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "types.h"
+
+/**
+ * This is how many times a second the main loop asks its timers directly
+ * if buffered input keeps it from reaching the multiplexor.
+ */
+#define PERIODIC_POLLS (10)
+
+/**
+ * This is the most timers that can be asked at once.
+ */
+#define PERIODIC_TIMERS (8)
+
+/**
+ * This structure describes a periodic timer.
+ */
+typedef struct Periodic {
+    int fd;                 /* timerfd or <0 if none. */
+    seconds_t seconds;      /* <0 for never, 0 for always, >0 period. */
+    uint64_t expirations;   /* Total expirations serviced. */
+    int pending;            /* True if an expiration is latched. */
+} periodic_t;
+
+/**
+ * @define PERIODIC_INITIALIZER
+ * Initialize a Periodic structure.
+ */
+#define PERIODIC_INITIALIZER \
+    { \
+        -1, \
+        -1, \
+        0, \
+        0, \
+    }
+
+/**
+ * Initialize a periodic timer. A timerfd is only created if the period is
+ * greater than zero; the caller registers the resulting file descriptor,
+ * if any, with its multiplexor.
+ * @param pp points to the periodic timer.
+ * @param seconds is the period in seconds, <0 for never, 0 for always.
+ * @param immediate if true causes the first expiration to be immediate.
+ * @return the timerfd, or <0 if there is none or an error occurred.
+ */
+extern int periodic_init(periodic_t * pp, seconds_t seconds, int immediate);
+
+/**
+ * If the file descriptor returned by the multiplexor belongs to this
+ * periodic timer, read the timerfd and latch the expiration.
+ * @param pp points to the periodic timer.
+ * @param fd is the ready file descriptor.
+ * @return true if the file descriptor belongs to this periodic timer.
+ */
+extern int periodic_service(periodic_t * pp, int fd);
+
+/**
+ * Return true if the periodic timer has expired since the last time this
+ * function returned true, and consume the expiration.
+ * @param pp points to the periodic timer.
+ * @return true if the period has expired.
+ */
+extern int periodic_expired(periodic_t * pp);
+
+/**
+ * Return the file descriptor of a periodic timer that has expired, without
+ * blocking and without reading the timerfd, so that the caller can service
+ * it just as if the multiplexor had returned it. The main loop uses this
+ * when buffered input keeps it from reaching the multiplexor, which would
+ * otherwise starve the timers for as long as the input is saturated.
+ * @param timers points to an array of pointers to periodic timers.
+ * @param count is the number of timers in the array.
+ * @return the file descriptor of an expired timer or <0 if there is none.
+ */
+extern int periodic_ready(periodic_t * const timers[], size_t count);
+
+/**
+ * Release the timerfd of a periodic timer if it has one. The caller is
+ * responsible for unregistering it from its multiplexor first.
+ * @param pp points to the periodic timer.
+ */
+extern void periodic_fini(periodic_t * pp);
+
+#endif
@@ -19,6 +19,7 @@
 #include "com/diag/diminuto/diminuto_unicode.h"
 #include "com/diag/hazer/common.h"
 #include "com/diag/hazer/hazer_version.h"
+#include "com/diag/hazer/render.h"
 #include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -540,13 +541,20 @@ void print_positions(FILE * fp, const hazer_positions_t pa, hazer_system_t ss, i
         }
     }
 
+    /*
+     * The lines with fixed point fields are rendered into a buffer and
+     * written all at once, rather than formatted by stdio field by field.
+     */
+
     {
         int degrees = 0;
         int minutes = 0;
         int seconds = 0;
         int thousandths = 0;
         int direction = 0;
-        uint64_t tenmillionths = 0;
+        char line[LINE];
+        char * bp = (char *)0;
+        char * here = (char *)0;
 
         for (system = 0; system < HAZER_SYSTEM_TOTAL; ++system) {
 
@@ -554,51 +562,89 @@ void print_positions(FILE * fp, const hazer_positions_t pa, hazer_system_t ss, i
             if (pa[system].timeout == 0) { continue; }
             if (pa[system].utc_nanoseconds == HAZER_NANOSECONDS_UNSET) { continue; }
 
-            fputs("POS", fp);
+            bp = render_string(line, "POS");
 
             hazer_format_nanominutes2position(pa[system].lat_nanominutes, &degrees, &minutes, &seconds, &thousandths, &direction);
             diminuto_contract((0 <= degrees) && (degrees <= 90));
             diminuto_contract((0 <= minutes) && (minutes <= 59));
             diminuto_contract((0 <= seconds) && (seconds <= 59));
             diminuto_contract((0 <= thousandths) && (thousandths <= 999));
-            fprintf(fp, " %2d%lc%02d'%02d.%03d\"%c,", degrees, DIMINUTO_UNICODE_DEGREE, minutes, seconds, thousandths, (direction < 0) ? 'S' : 'N');
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_unsigned(bp, degrees);
+            bp = render_right(here, bp, 2);
+            bp = render_wide(bp, DIMINUTO_UNICODE_DEGREE);
+            bp = render_zeros(bp, minutes, 2);
+            bp = render_char(bp, '\'');
+            bp = render_zeros(bp, seconds, 2);
+            bp = render_char(bp, '.');
+            bp = render_zeros(bp, thousandths, 3);
+            bp = render_char(bp, '"');
+            bp = render_char(bp, (direction < 0) ? 'S' : 'N');
+            bp = render_char(bp, ',');
 
             hazer_format_nanominutes2position(pa[system].lon_nanominutes, &degrees, &minutes, &seconds, &thousandths, &direction);
             diminuto_contract((0 <= degrees) && (degrees <= 180));
             diminuto_contract((0 <= minutes) && (minutes <= 59));
             diminuto_contract((0 <= seconds) && (seconds <= 59));
             diminuto_contract((0 <= thousandths) && (thousandths <= 999));
-            fprintf(fp, " %3d%lc%02d'%02d.%03d\"%c", degrees, DIMINUTO_UNICODE_DEGREE, minutes, seconds, thousandths, (direction < 0) ? 'W' : 'E');
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_unsigned(bp, degrees);
+            bp = render_right(here, bp, 3);
+            bp = render_wide(bp, DIMINUTO_UNICODE_DEGREE);
+            bp = render_zeros(bp, minutes, 2);
+            bp = render_char(bp, '\'');
+            bp = render_zeros(bp, seconds, 2);
+            bp = render_char(bp, '.');
+            bp = render_zeros(bp, thousandths, 3);
+            bp = render_char(bp, '"');
+            bp = render_char(bp, (direction < 0) ? 'W' : 'E');
+
+            bp = render_char(bp, ' ');
 
-            fputc(' ', fp);
+            /*
+             * There are 6000 nanominutes in a ten millionth of a degree.
+             */
 
-            hazer_format_nanominutes2degrees(pa[system].lat_nanominutes, &degrees, &tenmillionths);
-            diminuto_contract((-90 <= degrees) && (degrees <= 90));
-            diminuto_contract((0 <= tenmillionths) && (tenmillionths <= 9999999));
-            fprintf(fp, " %4d.%07llu,", degrees, (diminuto_llu_t)tenmillionths);
+            diminuto_contract((-5400000000000LL <= pa[system].lat_nanominutes) && (pa[system].lat_nanominutes <= 5400000000000LL));
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_fixed(bp, pa[system].lat_nanominutes / 6000, 7);
+            bp = render_right(here, bp, 4 + 1 + 7);
+            bp = render_char(bp, ',');
 
-            hazer_format_nanominutes2degrees(pa[system].lon_nanominutes, &degrees, &tenmillionths);
-            diminuto_contract((-180 <= degrees) && (degrees <= 180));
-            fprintf(fp, " %4d.%07llu", degrees, (diminuto_llu_t)tenmillionths);
-            diminuto_contract((0 <= tenmillionths) && (tenmillionths <= 9999999));
+            diminuto_contract((-10800000000000LL <= pa[system].lon_nanominutes) && (pa[system].lon_nanominutes <= 10800000000000LL));
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_fixed(bp, pa[system].lon_nanominutes / 6000, 7);
+            bp = render_right(here, bp, 4 + 1 + 7);
 
-            fprintf(fp, " %cq", HAZER_QUALITY_NAME[pa[system].quality]);
+            bp = render_char(bp, ' ');
+            bp = render_char(bp, HAZER_QUALITY_NAME[pa[system].quality]);
+            bp = render_char(bp, 'q');
 
-            fprintf(fp, " %cs", HAZER_SAFETY_NAME[pa[system].safety]);
+            bp = render_char(bp, ' ');
+            bp = render_char(bp, HAZER_SAFETY_NAME[pa[system].safety]);
+            bp = render_char(bp, 's');
 
-            fprintf(fp, "%1s", "");
+            bp = render_left(bp, "", 1);
 
-            fprintf(fp, " %-8.8s", HAZER_SYSTEM_NAME[system]);
+            bp = render_char(bp, ' ');
+            bp = render_left(bp, HAZER_SYSTEM_NAME[system], 8);
 
-            fputc('\n', fp);
+            bp = render_char(bp, '\n');
+
+            fwrite(line, bp - line, 1, fp);
 
         }
     }
 
     {
         int64_t millimeters = 0;
-        int64_t meters = 0;
-        uint64_t thousandths = 0;
+        char line[LINE];
+        char * bp = (char *)0;
+        char * here = (char *)0;
 
         for (system = 0; system < HAZER_SYSTEM_TOTAL; ++system) {
 
@@ -606,15 +652,17 @@ void print_positions(FILE * fp, const hazer_positions_t pa, hazer_system_t ss, i
             if (pa[system].timeout == 0) { continue; }
             if (pa[system].utc_nanoseconds == HAZER_NANOSECONDS_UNSET) { continue; }
 
-            fputs("ALT", fp);
+            bp = render_string(line, "ALT");
 
             millimeters = pa[system].alt_millimeters;
 
-            fprintf(fp, " %10.2lf'", millimeters * 3.2808 / 1000.0);
+            bp += snprintf(bp, sizeof(line) - (bp - line), " %10.2lf'", millimeters * 3.2808 / 1000.0);
 
-            meters = millimeters / 1000LL;
-            thousandths = abs64(millimeters) % 1000LLU;
-            fprintf(fp, " %6lld.%03llum MSL", (diminuto_lld_t)meters, (diminuto_llu_t)thousandths);
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_fixed(bp, millimeters, 3);
+            bp = render_right(here, bp, 6 + 1 + 3);
+            bp = render_string(bp, "m MSL");
 
             /*
              * NMEA 0183 4.11 p. 86 "GGA", Note 3
@@ -625,25 +673,31 @@ void print_positions(FILE * fp, const hazer_positions_t pa, hazer_system_t ss, i
 
             millimeters -= pa[system].sep_millimeters;
 
-            fprintf(fp, " %10.2lf'", millimeters * 3.2808 / 1000.0);
+            bp += snprintf(bp, sizeof(line) - (bp - line), " %10.2lf'", millimeters * 3.2808 / 1000.0);
 
-            meters = millimeters / 1000LL;
-            thousandths = abs64(millimeters) % 1000LLU;
-            fprintf(fp, " %6lld.%03llum WGS", (diminuto_lld_t)meters, (diminuto_llu_t)thousandths);
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_fixed(bp, millimeters, 3);
+            bp = render_right(here, bp, 6 + 1 + 3);
+            bp = render_string(bp, "m WGS");
 
-            fprintf(fp, "%11s", "");
+            bp = render_left(bp, "", 11);
 
-            fprintf(fp, " %-8.8s", HAZER_SYSTEM_NAME[system]);
+            bp = render_char(bp, ' ');
+            bp = render_left(bp, HAZER_SYSTEM_NAME[system], 8);
 
-            fputc('\n', fp);
+            bp = render_char(bp, '\n');
+
+            fwrite(line, bp - line, 1, fp);
 
         }
     }
 
     {
-        int64_t degrees = 0;
-        uint64_t billionths = 0;
         const char * compass = (const char *)0;
+        char line[LINE];
+        char * bp = (char *)0;
+        char * here = (char *)0;
 
         for (system = 0; system < HAZER_SYSTEM_TOTAL; ++system) {
 
@@ -651,38 +705,50 @@ void print_positions(FILE * fp, const hazer_positions_t pa, hazer_system_t ss, i
             if (pa[system].timeout == 0) { continue; }
             if (pa[system].utc_nanoseconds == HAZER_NANOSECONDS_UNSET) { continue; }
 
-            fputs("COG", fp);
+            bp = render_string(line, "COG");
 
             diminuto_contract((0LL <= pa[system].cog_nanodegrees) && (pa[system].cog_nanodegrees <= 360000000000LL));
 
             compass = hazer_format_nanodegrees2compass16(pa[system].cog_nanodegrees);
             diminuto_contract(compass != (const char *)0);
             diminuto_contract(strlen(compass) <= 4);
-            fprintf(fp, " %-3s", compass);
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_string(bp, compass);
+            bp = render_left(bp, "", 3 - (bp - here));
 
-            degrees = pa[system].cog_nanodegrees / 1000000000LL;
-            billionths = abs64(pa[system].cog_nanodegrees) % 1000000000LLU;
-            fprintf(fp, " %4lld.%09llu%lcT", (diminuto_lld_t)degrees, (diminuto_llu_t)billionths, DIMINUTO_UNICODE_DEGREE);
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_fixed(bp, pa[system].cog_nanodegrees, 9);
+            bp = render_right(here, bp, 4 + 1 + 9);
+            bp = render_wide(bp, DIMINUTO_UNICODE_DEGREE);
+            bp = render_char(bp, 'T');
 
-            degrees = pa[system].mag_nanodegrees / 1000000000LL;
-            billionths = abs64(pa[system].mag_nanodegrees) % 1000000000LLU;
-            fprintf(fp, " %4lld.%09llu%lcM", (diminuto_lld_t)degrees, (diminuto_llu_t)billionths, DIMINUTO_UNICODE_DEGREE);
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_fixed(bp, pa[system].mag_nanodegrees, 9);
+            bp = render_right(here, bp, 4 + 1 + 9);
+            bp = render_wide(bp, DIMINUTO_UNICODE_DEGREE);
+            bp = render_char(bp, 'M');
 
-            fprintf(fp, "%29s", "");
+            bp = render_left(bp, "", 29);
 
-            fprintf(fp, " %-8.8s", HAZER_SYSTEM_NAME[system]);
+            bp = render_char(bp, ' ');
+            bp = render_left(bp, HAZER_SYSTEM_NAME[system], 8);
 
-            fputc('\n', fp);
+            bp = render_char(bp, '\n');
+
+            fwrite(line, bp - line, 1, fp);
 
         }
     }
 
     {
         double milesperhour = 0.0;
-        int64_t knots = 0;
-        int64_t kilometersperhour = 0;
-        uint64_t thousandths = 0;
         double meterspersecond = 0.0;
+        char line[LINE];
+        char * bp = (char *)0;
+        char * here = (char *)0;
 
         for (system = 0; system < HAZER_SYSTEM_TOTAL; ++system) {
 
@@ -690,31 +756,38 @@ void print_positions(FILE * fp, const hazer_positions_t pa, hazer_system_t ss, i
             if (pa[system].timeout == 0) { continue; }
             if (pa[system].utc_nanoseconds == HAZER_NANOSECONDS_UNSET) { continue; }
 
-            fputs("SOG", fp);
+            bp = render_string(line, "SOG");
 
             milesperhour = pa[system].sog_microknots;
             milesperhour *= 1.150779;
             milesperhour /= 1000000.0;
-            fprintf(fp, " %11.3lfmph", milesperhour);
+            bp += snprintf(bp, sizeof(line) - (bp - line), " %11.3lfmph", milesperhour);
 
-            knots = pa[system].sog_microknots / 1000000LL;
-            thousandths = (abs64(pa[system].sog_microknots) % 1000000LLU) / 1000LLU;
-            fprintf(fp, " %7lld.%03lluknots", (diminuto_lld_t)knots, (diminuto_llu_t)thousandths);
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_fixed(bp, pa[system].sog_microknots / 1000LL, 3);
+            bp = render_right(here, bp, 7 + 1 + 3);
+            bp = render_string(bp, "knots");
 
-            kilometersperhour = pa[system].sog_millimetersperhour / 1000000LL;
-            thousandths = (abs64(pa[system].sog_millimetersperhour) % 1000000LLU) / 1000LLU;
-            fprintf(fp, " %7lld.%03llukph", (diminuto_lld_t)kilometersperhour, (diminuto_llu_t)thousandths);
+            bp = render_char(bp, ' ');
+            here = bp;
+            bp = render_fixed(bp, pa[system].sog_millimetersperhour / 1000LL, 3);
+            bp = render_right(here, bp, 7 + 1 + 3);
+            bp = render_string(bp, "kph");
 
             meterspersecond = pa[system].sog_millimetersperhour;
             meterspersecond /= 1000.0;
             meterspersecond /= 3600.0;
-            fprintf(fp, " %11.3lfm/s", meterspersecond);
+            bp += snprintf(bp, sizeof(line) - (bp - line), " %11.3lfm/s", meterspersecond);
 
-            fprintf(fp, "%5s", "");
+            bp = render_left(bp, "", 5);
 
-            fprintf(fp, " %-8.8s", HAZER_SYSTEM_NAME[system]);
+            bp = render_char(bp, ' ');
+            bp = render_left(bp, HAZER_SYSTEM_NAME[system], 8);
 
-            fputc('\n', fp);
+            bp = render_char(bp, '\n');
+
+            fwrite(line, bp - line, 1, fp);
 
         }
     }
@@ -812,64 +885,122 @@ void print_corrections(FILE * fp, const yodel_base_t * bp, const yodel_rover_t *
 
 void print_solution(FILE * fp, const yodel_solution_t * sp)
 {
-    int32_t decimaldegrees = 0;
     uint32_t degrees = 0;
     uint32_t minutes = 0;
     uint32_t seconds = 0;
-    uint64_t billionths = 0;
-    int direction = 0;
-    int32_t meters = 0;
     uint32_t tenthousandths = 0;
+    int direction = 0;
+    char line[LINE];
+    char * bp = (char *)0;
+    char * here = (char *)0;
+
+    /*
+     * Positions are in 10^-7 degrees plus a high precision part in 10^-9
+     * degrees, altitudes are in millimeters plus a high precision part in
+     * 10^-4 meters, and accuracies are in 10^-4 meters.
+     */
 
     if (sp->timeout != 0) {
 
-        fputs("HPP", fp);
+        bp = render_string(line, "HPP");
 
-        yodel_format_hppos2degrees(sp->payload.lat, sp->payload.latHp, &decimaldegrees, &billionths);
-        fprintf(fp, " %4d.%09llu,", decimaldegrees, (diminuto_llu_t)billionths);
+        bp = render_char(bp, ' ');
+        here = bp;
+        bp = render_fixed(bp, ((int64_t)sp->payload.lat * 100) + sp->payload.latHp, 9);
+        bp = render_right(here, bp, 4 + 1 + 9);
+        bp = render_char(bp, ',');
 
-        yodel_format_hppos2degrees(sp->payload.lon, sp->payload.lonHp, &decimaldegrees, &billionths);
-        fprintf(fp, " %4d.%09llu", decimaldegrees, (diminuto_llu_t)billionths);
+        bp = render_char(bp, ' ');
+        here = bp;
+        bp = render_fixed(bp, ((int64_t)sp->payload.lon * 100) + sp->payload.lonHp, 9);
+        bp = render_right(here, bp, 4 + 1 + 9);
 
-        yodel_format_hpacc2accuracy(sp->payload.hAcc, &meters, &tenthousandths);
-        fprintf(fp, " %lc%6lld.%04llum", DIMINUTO_UNICODE_PLUSMINUS, (diminuto_lld_t)meters, (diminuto_llu_t)tenthousandths);
+        bp = render_char(bp, ' ');
+        bp = render_wide(bp, DIMINUTO_UNICODE_PLUSMINUS);
+        here = bp;
+        bp = render_fixed(bp, sp->payload.hAcc, 4);
+        bp = render_right(here, bp, 6 + 1 + 4);
+        bp = render_char(bp, 'm');
 
-        fprintf(fp, "%22s", "");
+        bp = render_left(bp, "", 22);
 
-        fprintf(fp, " %-8.8s", "GNSS");
+        bp = render_char(bp, ' ');
+        bp = render_left(bp, "GNSS", 8);
 
-        fputc('\n', fp);
+        bp = render_char(bp, '\n');
 
-        fputs("HPA", fp);
+        fwrite(line, bp - line, 1, fp);
 
-        yodel_format_hpalt2aaltitude(sp->payload.hMSL, sp->payload.hMSLHp, &meters, &tenthousandths);
-        fprintf(fp, " %6lld.%04llum MSL", (diminuto_lld_t)meters, (diminuto_llu_t)tenthousandths);
+        bp = render_string(line, "HPA");
 
-        yodel_format_hpalt2aaltitude(sp->payload.height, sp->payload.heightHp, &meters, &tenthousandths);
-        fprintf(fp, " %6lld.%04llum GEO", (diminuto_lld_t)meters, (diminuto_llu_t)tenthousandths);
+        bp = render_char(bp, ' ');
+        here = bp;
+        bp = render_fixed(bp, ((int64_t)sp->payload.hMSL * 10) + sp->payload.hMSLHp, 4);
+        bp = render_right(here, bp, 6 + 1 + 4);
+        bp = render_string(bp, "m MSL");
 
-        yodel_format_hpacc2accuracy(sp->payload.vAcc, &meters, &tenthousandths);
-        fprintf(fp, " %lc%6lld.%04llum", DIMINUTO_UNICODE_PLUSMINUS, (diminuto_lld_t)meters, (diminuto_llu_t)tenthousandths);
+        bp = render_char(bp, ' ');
+        here = bp;
+        bp = render_fixed(bp, ((int64_t)sp->payload.height * 10) + sp->payload.heightHp, 4);
+        bp = render_right(here, bp, 6 + 1 + 4);
+        bp = render_string(bp, "m GEO");
 
-        fprintf(fp, "%19s", "");
+        bp = render_char(bp, ' ');
+        bp = render_wide(bp, DIMINUTO_UNICODE_PLUSMINUS);
+        here = bp;
+        bp = render_fixed(bp, sp->payload.vAcc, 4);
+        bp = render_right(here, bp, 6 + 1 + 4);
+        bp = render_char(bp, 'm');
 
-        fprintf(fp, " %-8.8s", "GNSS");
+        bp = render_left(bp, "", 19);
 
-        fputc('\n', fp);
+        bp = render_char(bp, ' ');
+        bp = render_left(bp, "GNSS", 8);
+
+        bp = render_char(bp, '\n');
 
-        fputs("NGS", fp);
+        fwrite(line, bp - line, 1, fp);
+
+        bp = render_string(line, "NGS");
 
         yodel_format_hppos2position(sp->payload.lat, sp->payload.latHp, &degrees, &minutes, &seconds, &tenthousandths, &direction);
-        fprintf(fp, " %3u %02u %02u.%05u(%c)", degrees, minutes, seconds, tenthousandths, (direction < 0) ? 'S' : 'N');
+        bp = render_char(bp, ' ');
+        here = bp;
+        bp = render_unsigned(bp, degrees);
+        bp = render_right(here, bp, 3);
+        bp = render_char(bp, ' ');
+        bp = render_zeros(bp, minutes, 2);
+        bp = render_char(bp, ' ');
+        bp = render_zeros(bp, seconds, 2);
+        bp = render_char(bp, '.');
+        bp = render_zeros(bp, tenthousandths, 5);
+        bp = render_char(bp, '(');
+        bp = render_char(bp, (direction < 0) ? 'S' : 'N');
+        bp = render_char(bp, ')');
 
         yodel_format_hppos2position(sp->payload.lon, sp->payload.lonHp, &degrees, &minutes, &seconds, &tenthousandths, &direction);
-        fprintf(fp, " %3u %02u %02u.%05u(%c)", degrees, minutes, seconds, tenthousandths, (direction < 0) ? 'W' : 'E');
+        bp = render_char(bp, ' ');
+        here = bp;
+        bp = render_unsigned(bp, degrees);
+        bp = render_right(here, bp, 3);
+        bp = render_char(bp, ' ');
+        bp = render_zeros(bp, minutes, 2);
+        bp = render_char(bp, ' ');
+        bp = render_zeros(bp, seconds, 2);
+        bp = render_char(bp, '.');
+        bp = render_zeros(bp, tenthousandths, 5);
+        bp = render_char(bp, '(');
+        bp = render_char(bp, (direction < 0) ? 'W' : 'E');
+        bp = render_char(bp, ')');
 
-        fprintf(fp, "%29s", "");
+        bp = render_left(bp, "", 29);
 
-        fprintf(fp, " %-8.8s", "GNSS");
+        bp = render_char(bp, ' ');
+        bp = render_left(bp, "GNSS", 8);
 
-        fputc('\n', fp);
+        bp = render_char(bp, '\n');
+
+        fwrite(line, bp - line, 1, fp);
 
     }
 }
@@ -969,3 +1100,44 @@ void print_posveltim(FILE * fp, const yodel_posveltim_t * sp)
 
     }
 }
+
+void print_pulse(FILE * fp, const pulse_statistics_t * sp, pulse_source_t source)
+{
+    const char * name = (const char *)0;
+
+    if (sp->count > 0) {
+
+        switch (source) {
+        case PULSE_SOURCE_PPS:
+            name = "PPSAPI";
+            break;
+        case PULSE_SOURCE_GPIO:
+            name = "GPIO";
+            break;
+        case PULSE_SOURCE_DCD:
+            name = "DCD";
+            break;
+        case PULSE_SOURCE_SIMULATED:
+            name = "SIMULATE";
+            break;
+        default:
+            name = "UNKNOWN";
+            break;
+        }
+
+        fputs("PPS", fp);
+
+        fprintf(fp, " %+14.9lfoffset", (double)sp->offset / PULSE_SECOND);
+
+        fprintf(fp, " %12.9lfjitter", pulse_jitter(sp) / PULSE_SECOND);
+
+        fprintf(fp, " %13.9lfperiod", (double)sp->period / PULSE_SECOND);
+
+        fprintf(fp, " %6llu", (unsigned long long)sp->count);
+
+        fprintf(fp, " %-8.8s", name);
+
+        fputc('\n', fp);
+
+    }
+}
@@ -106,4 +106,13 @@ extern void print_odometer(FILE * fp, const yodel_odometer_t * sp);
  */
 extern void print_posveltim(FILE * fp, const yodel_posveltim_t * sp);
 
+/**
+ * Print the offset and jitter of the 1PPS edges from the UTC seconds they
+ * mark, if any have been measured.
+ * @param fp points to the FILE stream.
+ * @param sp points to the pulse statistics.
+ * @param source is how the most recent edge was captured.
+ */
+extern void print_pulse(FILE * fp, const pulse_statistics_t * sp, pulse_source_t source);
+
 #endif
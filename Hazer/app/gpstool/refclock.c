@@ -0,0 +1,97 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This implements the gpstool NTP reference clock.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include "com/diag/diminuto/diminuto_log.h"
+#include "refclock.h"
+
+int refclock_init(refclock_t * rp, int unit)
+{
+    int rc = -1;
+
+    rp->second = 0;
+    rp->sequence = 0;
+    rp->times = 0;
+    rp->pulses = 0;
+
+    if ((rp->gnss = ntpshm_unit(unit)) == (ntpshm_time_t *)0) {
+        diminuto_perror("refclock_init: ntpshm_unit");
+    } else if ((rp->pps = ntpshm_unit(unit + 1)) == (ntpshm_time_t *)0) {
+        diminuto_perror("refclock_init: ntpshm_unit");
+        rp->gnss = ntpshm_detach(rp->gnss);
+    } else {
+        rc = 0;
+    }
+
+    return rc;
+}
+
+int refclock_time(refclock_t * rp, pulse_nanoseconds_t utc, pulse_nanoseconds_t received)
+{
+    int result = 0;
+    ntpshm_sample_t sample = NTPSHM_SAMPLE_INITIALIZER;
+
+    if (rp->gnss == (ntpshm_time_t *)0) {
+        /* Do nothing. */
+    } else if ((utc / PULSE_SECOND) == rp->second) {
+        /* Do nothing. */
+    } else {
+        rp->second = utc / PULSE_SECOND;
+        sample.clock = utc;
+        sample.receive = received;
+        sample.leap = NTPSHM_LEAP_NONE;
+        sample.precision = REFCLOCK_PRECISION_GNSS;
+        ntpshm_post(rp->gnss, &sample);
+        rp->times += 1;
+        result = !0;
+    }
+
+    return result;
+}
+
+int refclock_pulse(refclock_t * rp, const pulse_statistics_t * sp, const pulse_ring_t * ep)
+{
+    int result = 0;
+    const pulse_edge_t * pp = (const pulse_edge_t *)0;
+    ntpshm_sample_t sample = NTPSHM_SAMPLE_INITIALIZER;
+
+    if (rp->pps == (ntpshm_time_t *)0) {
+        /* Do nothing. */
+    } else if (sp->count == 0) {
+        /* Do nothing. */
+    } else if (sp->sequence == rp->sequence) {
+        /* Do nothing. */
+    } else if ((pp = pulse_ring_get(ep, ep->sequence - sp->sequence)) == (const pulse_edge_t *)0) {
+        /* Do nothing. */
+    } else if (pp->sequence != sp->sequence) {
+        /* Do nothing. */
+    } else {
+        rp->sequence = sp->sequence;
+        sample.clock = pp->realtime - sp->offset;
+        sample.receive = pp->realtime;
+        sample.leap = NTPSHM_LEAP_NONE;
+        sample.precision = REFCLOCK_PRECISION_PPS;
+        ntpshm_post(rp->pps, &sample);
+        rp->pulses += 1;
+        result = !0;
+    }
+
+    return result;
+}
+
+void refclock_fini(refclock_t * rp)
+{
+    if (rp->gnss != (ntpshm_time_t *)0) {
+        rp->gnss = ntpshm_detach(rp->gnss);
+    }
+    if (rp->pps != (ntpshm_time_t *)0) {
+        rp->pps = ntpshm_detach(rp->pps);
+    }
+}
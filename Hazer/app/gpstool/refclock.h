@@ -0,0 +1,89 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_GPSTOOL_REFCLOCK_
+#define _H_COM_DIAG_HAZER_GPSTOOL_REFCLOCK_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This declares the gpstool NTP reference clock.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The reference clock feeds ntpd or chronyd through a pair of NTP SHM
+ * segments, the way gpsd does, so that no other daemon has to read the
+ * GNSS receiver. The first unit carries the coarse time of each new
+ * second reported by the receiver, paired with the system time at which
+ * the report was received; the second unit carries each measured 1PPS
+ * edge, paired with the UTC second that it marks.
+ */
+
+#include <stdint.h>
+#include "com/diag/hazer/ntpshm.h"
+#include "com/diag/hazer/pulse.h"
+
+enum RefclockConstants {
+    REFCLOCK_PRECISION_GNSS     = -1,   /* ~500ms (serial latency). */
+    REFCLOCK_PRECISION_PPS      = -20,  /* ~1us. */
+};
+
+/**
+ * This structure describes the reference clock.
+ */
+typedef struct Refclock {
+    ntpshm_time_t * gnss;           /* Coarse GNSS time segment. */
+    ntpshm_time_t * pps;            /* 1PPS segment. */
+    pulse_nanoseconds_t second;     /* Last GNSS second published. */
+    uint32_t sequence;              /* Last 1PPS edge published. */
+    uint64_t times;                 /* GNSS samples published. */
+    uint64_t pulses;                /* 1PPS samples published. */
+} refclock_t;
+
+/**
+ * @define REFCLOCK_INITIALIZER
+ * Initialize a Refclock structure.
+ */
+#define REFCLOCK_INITIALIZER \
+    { \
+        (ntpshm_time_t *)0, \
+        (ntpshm_time_t *)0, \
+        0, \
+        0, \
+        0, \
+        0, \
+    }
+
+/**
+ * Attach to the NTP SHM segments for the unit and the unit after it.
+ * @param rp points to the reference clock.
+ * @param unit is the unit number of the GNSS time segment.
+ * @return 0 for success, <0 for error.
+ */
+extern int refclock_init(refclock_t * rp, int unit);
+
+/**
+ * Publish the GNSS time if it is a second that has not yet been published.
+ * @param rp points to the reference clock.
+ * @param utc is the UTC time in nanoseconds since the POSIX epoch.
+ * @param received is the system time at which it was received.
+ * @return true if a sample was published.
+ */
+extern int refclock_time(refclock_t * rp, pulse_nanoseconds_t utc, pulse_nanoseconds_t received);
+
+/**
+ * Publish the most recently measured 1PPS edge if it has not yet been
+ * published.
+ * @param rp points to the reference clock.
+ * @param sp points to the 1PPS statistics.
+ * @param ep points to the 1PPS ring.
+ * @return true if a sample was published.
+ */
+extern int refclock_pulse(refclock_t * rp, const pulse_statistics_t * sp, const pulse_ring_t * ep);
+
+/**
+ * Detach from the NTP SHM segments.
+ * @param rp points to the reference clock.
+ */
+extern void refclock_fini(refclock_t * rp);
+
+#endif
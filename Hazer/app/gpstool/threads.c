@@ -16,6 +16,7 @@
 #include "com/diag/diminuto/diminuto_line.h"
 #include "com/diag/diminuto/diminuto_mux.h"
 #include "constants.h"
+#include "edge.h"
 #include "globals.h"
 #include "threads.h"
 #include "types.h"
@@ -28,6 +29,8 @@ void * dcdpoller(void * argp)
     int rc = -1;
     int nowpps = 0;
     int waspps = 0;
+    pulse_nanoseconds_t realtime = 0;
+    pulse_nanoseconds_t monotonic = 0;
 
     pollerp = (poller_t *)argp;
 
@@ -41,6 +44,7 @@ void * dcdpoller(void * argp)
         }
         rc = diminuto_serial_wait(pollerp->ppsfd);
         if (rc < 0) { break; }
+        edge_stamp(&realtime, &monotonic);
         rc = diminuto_serial_status(pollerp->ppsfd);
         if (rc < 0) { break; }
         nowpps = !!rc;
@@ -55,6 +59,7 @@ void * dcdpoller(void * argp)
                 pollerp->onepps %= MODULO;  /* 0..(MODULO-1) */
                 pollerp->onepps += 1;       /* 1..MODULO */
                 pollerp->onehz = 0;         /* 0..TOLERANCE */
+                pulse_ring_put(&(pollerp->edges), realtime, monotonic, PULSE_SOURCE_DCD);
             DIMINUTO_CRITICAL_SECTION_END;
         } else {
             if (pollerp->strobefd >= 0) {
@@ -78,6 +83,8 @@ void * gpiopoller(void * argp)
     int fd = -1;
     int nowpps = 0;
     int waspps = 0;
+    pulse_nanoseconds_t realtime = 0;
+    pulse_nanoseconds_t monotonic = 0;
 
     pollerp = (poller_t *)argp;
 
@@ -99,7 +106,12 @@ void * gpiopoller(void * argp)
             fd = diminuto_mux_ready_read(&mux);
             if (fd < 0) { break; }
             diminuto_contract(fd == pollerp->ppsfd);
-            rc = diminuto_line_read(pollerp->ppsfd);
+            /*
+             * Read the edge event ourselves rather than just the line
+             * value so that we get the timestamp the kernel took when
+             * the edge interrupted it.
+             */
+            rc = edge_gpio(pollerp->ppsfd, &realtime, &monotonic);
             if (rc < 0) { break; }
             nowpps = !!rc;
             /*
@@ -118,6 +130,7 @@ void * gpiopoller(void * argp)
                     pollerp->onepps %= MODULO;  /* 0..(MODULO-1) */
                     pollerp->onepps += 1;       /* 1..MODULO */
                     pollerp->onehz = 0;         /* 0..TOLERANCE */
+                    pulse_ring_put(&(pollerp->edges), realtime, monotonic, PULSE_SOURCE_GPIO);
                 DIMINUTO_CRITICAL_SECTION_END;
             } else {
                 if (pollerp->strobefd >= 0) {
@@ -136,18 +149,58 @@ void * gpiopoller(void * argp)
     return xc;
 }
 
-void * timerservice(void * argp)
+void * ppspoller(void * argp)
 {
-    void * xc = (void *)0;
+    void * xc = (void *)1;
     poller_t * pollerp = (poller_t *)0;
+    int done = 0;
+    int rc = -1;
+    unsigned long asserts = 0;
+    unsigned long clears = 0;
+    pulse_nanoseconds_t realtime = 0;
+    pulse_nanoseconds_t monotonic = 0;
 
     pollerp = (poller_t *)argp;
 
+    while (!0) {
+        DIMINUTO_COHERENT_SECTION_BEGIN;
+            done = pollerp->done;
+        DIMINUTO_COHERENT_SECTION_END;
+        if (done) {
+            xc = (void *)0;
+            break;
+        }
+        rc = edge_pps_fetch(pollerp->ppsfd, &asserts, &clears, &realtime, &monotonic);
+        if (rc < 0) { break; }
+        if (rc == 1) {
+            if (pollerp->strobefd >= 0) {
+                rc = diminuto_line_set(pollerp->strobefd);
+                if (rc < 0) { break; }
+            }
+            DIMINUTO_CRITICAL_SECTION_BEGIN(&Mutex);
+                pollerp->onepps %= MODULO;  /* 0..(MODULO-1) */
+                pollerp->onepps += 1;       /* 1..MODULO */
+                pollerp->onehz = 0;         /* 0..TOLERANCE */
+                pulse_ring_put(&(pollerp->edges), realtime, monotonic, PULSE_SOURCE_PPS);
+            DIMINUTO_CRITICAL_SECTION_END;
+        } else if (rc == 2) {
+            if (pollerp->strobefd >= 0) {
+                rc = diminuto_line_clear(pollerp->strobefd);
+                if (rc < 0) { break; }
+            }
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    return xc;
+}
+
+void pollertick(poller_t * pollerp)
+{
     DIMINUTO_CRITICAL_SECTION_BEGIN(&Mutex);
         if (pollerp->onehz < TOLERANCE) {
             pollerp->onehz += 1;            /* 0..TOLERANCE */
         }
     DIMINUTO_CRITICAL_SECTION_END;
-
-    return xc;
 }
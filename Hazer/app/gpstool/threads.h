@@ -12,6 +12,8 @@
  * @details
  */
 
+#include "types.h"
+
 /**
  * Implement a thread that polls for the data carrier detect (DCD) state for
  * 1PPS.
@@ -29,11 +31,20 @@ extern void * dcdpoller(void * argp);
 extern void * gpiopoller(void * argp);
 
 /**
- * Implements a timer that helsp us determine if we have lost our One Pulse
- * Per Second (1PPS) signal.
- * @param argp points to the timer context.
- * @return the value of the timer service.
+ * Implement a thread that waits for 1PPS assert events from the kernel
+ * PPS API (e.g. /dev/pps0), which timestamps each edge in its interrupt
+ * handler.
+ * @param argp points to the thread context.
+ * @return the final value of the thread.
+ */
+extern void * ppspoller(void * argp);
+
+/**
+ * Called by the main thread once a second when its one hertz periodic
+ * timer fires, this helps us determine if we have lost our One Pulse Per
+ * Second (1PPS) signal. The poller threads reset the count on every pulse.
+ * @param pollerp points to the poller context.
  */
-extern void * timerservice(void * argp);
+extern void pollertick(poller_t * pollerp);
 
 #endif
@@ -30,16 +30,3 @@ int time_expired(seconds_t * wasp, seconds_t seconds)
 
     return result;
 }
-
-void time_countdown(hazer_expiry_t * ep, seconds_t seconds)
-{
-    if (*ep == 0) {
-        /* Do nothing. */
-    } else if (seconds <= 0) {
-        /* Do nothing. */
-    } else if (*ep <= seconds) {
-        *ep = 0;
-    } else {
-        *ep -= seconds;
-    }
-}
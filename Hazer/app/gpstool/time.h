@@ -27,13 +27,4 @@
  */
 extern int time_expired(seconds_t * wasp, seconds_t seconds);
 
-/**
- * Count down an expiration fields in the database. This doesn't return
- * anything because the expiration field is interrogated separately by
- * the appropriate print function.
- * @param ep points to the expiration field to count down.
- * @param seconds is the number of seconds to count down.
- */
-extern void time_countdown(hazer_expiry_t * ep, seconds_t seconds);
-
 #endif
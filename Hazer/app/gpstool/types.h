@@ -16,6 +16,7 @@
 #include "com/diag/diminuto/diminuto_types.h"
 #include "com/diag/diminuto/diminuto_list.h"
 #include "com/diag/hazer/hazer.h"
+#include "com/diag/hazer/pulse.h"
 #include "com/diag/hazer/yodel.h"
 #include "com/diag/hazer/tumbleweed.h"
 
@@ -374,11 +375,12 @@ typedef union TumbleweedUpdates {
  ******************************************************************************/
 
 /**
- * The Poller structure is used by periodic DCD or GPIO poller threads to
- * communicate with the main program about the assertion of the 1Hz 1PPS
- * signal from certain GPS receivers which are so-equipped. The volatile
- * declaration is used to suggest to the compiler that it doesn't optimize
- * use of these variables out since they can be altered by other threads.
+ * The Poller structure is used by periodic DCD, GPIO, or PPS API poller
+ * threads to communicate with the main program about the assertion of the
+ * 1Hz 1PPS signal from certain GPS receivers which are so-equipped. The
+ * volatile declaration is used to suggest to the compiler that it doesn't
+ * optimize use of these variables out since they can be altered by other
+ * threads. The ring of timestamped edges is only accessed under the mutex.
  */
 typedef struct Poller {
     int ppsfd;
@@ -386,6 +388,7 @@ typedef struct Poller {
     volatile int onepps;
     volatile int onehz;
     volatile int done;
+    pulse_ring_t edges;
 } poller_t;
 
 /**
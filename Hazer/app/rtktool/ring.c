@@ -0,0 +1,114 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This implements the rtktool broadcast ring.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <string.h>
+#include "ring.h"
+
+void ring_init(ring_t * rp)
+{
+    int ii = 0;
+
+    for (ii = 0; ii < RING_SLOTS; ++ii) {
+        rp->slot[ii].sequence = 0;
+        rp->slot[ii].length = 0;
+        rp->slot[ii].origin = -1;
+    }
+
+    __atomic_store_n(&(rp->head), 0, __ATOMIC_RELEASE);
+}
+
+uint64_t ring_head(const ring_t * rp)
+{
+    return __atomic_load_n(&(rp->head), __ATOMIC_ACQUIRE);
+}
+
+void ring_publish(ring_t * rp, const void * buffer, ssize_t length, int origin)
+{
+    uint64_t head = 0;
+    ring_slot_t * sp = (ring_slot_t *)0;
+
+    if (length > sizeof(sp->buffer)) {
+        length = sizeof(sp->buffer);
+    }
+
+    head = __atomic_load_n(&(rp->head), __ATOMIC_RELAXED);
+    sp = &(rp->slot[head & (RING_SLOTS - 1)]);
+
+    /*
+     * The sequence number of the slot holding datagram N is 2N+2 once it
+     * is written, and 2N+1 while it is being written.
+     */
+
+    __atomic_store_n(&(sp->sequence), (head * 2) + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy(&(sp->buffer), buffer, length);
+    sp->length = length;
+    sp->origin = origin;
+    __atomic_store_n(&(sp->sequence), (head * 2) + 2, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&(rp->head), head + 1, __ATOMIC_RELEASE);
+}
+
+int ring_consume(const ring_t * rp, uint64_t * cursorp, datagram_buffer_t * bufferp, ssize_t * lengthp, int * originp, uint64_t * overrunsp)
+{
+    int result = 0;
+    uint64_t head = 0;
+    uint64_t before = 0;
+    uint64_t after = 0;
+    const ring_slot_t * sp = (const ring_slot_t *)0;
+    ssize_t length = 0;
+
+    while (!0) {
+
+        head = __atomic_load_n(&(rp->head), __ATOMIC_ACQUIRE);
+        if (*cursorp >= head) {
+            break;
+        }
+
+        if ((head - *cursorp) > RING_SLOTS) {
+            *overrunsp += (head - *cursorp) - RING_SLOTS;
+            *cursorp = head - RING_SLOTS;
+        }
+
+        sp = &(rp->slot[*cursorp & (RING_SLOTS - 1)]);
+
+        before = __atomic_load_n(&(sp->sequence), __ATOMIC_ACQUIRE);
+        if (before != ((*cursorp * 2) + 2)) {
+            *overrunsp += 1;
+            *cursorp += 1;
+            continue;
+        }
+
+        length = sp->length;
+        if (length > sizeof(*bufferp)) {
+            length = sizeof(*bufferp);
+        }
+        memcpy(bufferp, (const void *)&(sp->buffer), length);
+        *lengthp = length;
+        *originp = sp->origin;
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&(sp->sequence), __ATOMIC_RELAXED);
+
+        *cursorp += 1;
+
+        if (after != before) {
+            *overrunsp += 1;
+            continue;
+        }
+
+        result = !0;
+        break;
+
+    }
+
+    return result;
+}
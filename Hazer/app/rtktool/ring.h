@@ -0,0 +1,85 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_RTKTOOL_RING_
+#define _H_COM_DIAG_HAZER_RTKTOOL_RING_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This declares and defines the rtktool broadcast ring.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The broadcast ring carries base corrections from the worker that
+ * received them to every other worker. There is one producer at a time
+ * (only the worker that owns the base publishes) and any number of
+ * consumers, each of which keeps its own cursor; nothing is ever dequeued,
+ * the producer just overwrites the oldest slot. Each slot is guarded by
+ * its own sequence lock, so neither the producer nor the consumers ever
+ * block or take a lock. A consumer that falls more than a ring behind,
+ * or whose slot is overwritten while it copies it, skips ahead and counts
+ * the corrections it missed as overruns.
+ */
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "com/diag/hazer/datagram.h"
+
+/**
+ * This is the number of slots in the ring. It must be a power of two.
+ */
+#define RING_SLOTS (16)
+
+/**
+ * This is one slot in the ring.
+ */
+typedef struct RingSlot {
+    uint64_t sequence;              /* Odd while being written. */
+    ssize_t length;                 /* Length of the datagram in bytes. */
+    int origin;                     /* Index of the publishing worker. */
+    datagram_buffer_t buffer;       /* Datagram including its header. */
+} ring_slot_t;
+
+/**
+ * This is the ring.
+ */
+typedef struct Ring {
+    uint64_t head;                  /* Number of datagrams ever published. */
+    ring_slot_t slot[RING_SLOTS];
+} ring_t;
+
+/**
+ * Initialize a ring so that it is empty.
+ * @param rp points to the ring.
+ */
+extern void ring_init(ring_t * rp);
+
+/**
+ * Return the position at which a new consumer should start.
+ * @param rp points to the ring.
+ * @return the current head of the ring.
+ */
+extern uint64_t ring_head(const ring_t * rp);
+
+/**
+ * Publish a datagram to the ring. Only one thread may publish at a time.
+ * @param rp points to the ring.
+ * @param buffer points to the datagram.
+ * @param length is the length of the datagram in bytes.
+ * @param origin is the index of the publishing worker.
+ */
+extern void ring_publish(ring_t * rp, const void * buffer, ssize_t length, int origin);
+
+/**
+ * Copy the next datagram, if any, out of the ring and advance the cursor.
+ * @param rp points to the ring.
+ * @param cursorp points to the consumer's cursor.
+ * @param bufferp points to where the datagram is copied.
+ * @param lengthp points to where the length is stored.
+ * @param originp points to where the index of the publisher is stored.
+ * @param overrunsp points to the consumer's count of missed datagrams.
+ * @return !0 if a datagram was copied, 0 if the consumer is caught up.
+ */
+extern int ring_consume(const ring_t * rp, uint64_t * cursorp, datagram_buffer_t * bufferp, ssize_t * lengthp, int * originp, uint64_t * overrunsp);
+
+#endif
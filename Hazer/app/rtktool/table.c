@@ -0,0 +1,364 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This implements the rtktool client table.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "table.h"
+
+/*******************************************************************************
+ * HELPERS
+ ******************************************************************************/
+
+static unsigned int table_power(unsigned int minimum)
+{
+    unsigned int power = 1;
+
+    while (power < minimum) {
+        power <<= 1;
+    }
+
+    return power;
+}
+
+/*
+ * FNV-1a over the address words and the port.
+ */
+static uint32_t table_hash(const diminuto_ipv6_t * addressp, diminuto_port_t port)
+{
+    uint32_t hash = 2166136261U;
+    int ii = 0;
+
+    for (ii = 0; ii < 8; ++ii) {
+        hash = (hash ^ (addressp->u16[ii] >> 8)) * 16777619U;
+        hash = (hash ^ (addressp->u16[ii] & 0xff)) * 16777619U;
+    }
+    hash = (hash ^ (port >> 8)) * 16777619U;
+    hash = (hash ^ (port & 0xff)) * 16777619U;
+
+    return hash;
+}
+
+static inline link_t * table_spoke(table_t * tp, long deadline)
+{
+    return &(tp->spoke[deadline & (tp->spokes - 1)]);
+}
+
+static inline void table_link(table_t * tp, client_t * cp)
+{
+    link_t * sp = table_spoke(tp, cp->deadline);
+
+    cp->link.next = sp;
+    cp->link.prev = sp->prev;
+    sp->prev->next = &(cp->link);
+    sp->prev = &(cp->link);
+}
+
+static inline void table_unlink(client_t * cp)
+{
+    if (cp->link.next != (link_t *)0) {
+        cp->link.prev->next = cp->link.next;
+        cp->link.next->prev = cp->link.prev;
+        cp->link.next = cp->link.prev = (link_t *)0;
+    }
+}
+
+/*******************************************************************************
+ * LIFECYCLE
+ ******************************************************************************/
+
+table_t * table_init(table_t * tp, unsigned int clients, long timeout, long now)
+{
+    table_t * result = (table_t *)0;
+    unsigned int ii = 0;
+
+    memset(tp, 0, sizeof(*tp));
+
+    tp->clients = clients;
+    tp->slots = table_power(clients * 2);
+    tp->spokes = table_power(timeout + 2);
+    tp->timeout = timeout;
+    tp->now = now;
+
+    if ((tp->pool = (client_t *)calloc(tp->clients, sizeof(client_t))) == (client_t *)0) {
+        /* Do nothing. */
+    } else if ((tp->slot = (int32_t *)malloc(tp->slots * sizeof(int32_t))) == (int32_t *)0) {
+        /* Do nothing. */
+    } else if ((tp->spoke = (link_t *)malloc(tp->spokes * sizeof(link_t))) == (link_t *)0) {
+        /* Do nothing. */
+    } else if ((tp->rover = (client_t **)malloc(tp->clients * sizeof(client_t *))) == (client_t **)0) {
+        /* Do nothing. */
+    } else {
+        for (ii = 0; ii < tp->slots; ++ii) {
+            tp->slot[ii] = -1;
+        }
+        for (ii = 0; ii < tp->spokes; ++ii) {
+            tp->spoke[ii].next = tp->spoke[ii].prev = &(tp->spoke[ii]);
+        }
+        tp->free.next = (link_t *)0;
+        for (ii = tp->clients; ii > 0; --ii) {
+            tp->pool[ii - 1].link.next = tp->free.next;
+            tp->free.next = &(tp->pool[ii - 1].link);
+        }
+        result = tp;
+    }
+
+    if (result == (table_t *)0) {
+        table_fini(tp);
+    }
+
+    return result;
+}
+
+void table_fini(table_t * tp)
+{
+    free(tp->rover);
+    free(tp->spoke);
+    free(tp->slot);
+    free(tp->pool);
+    memset(tp, 0, sizeof(*tp));
+}
+
+/*******************************************************************************
+ * HASH TABLE
+ ******************************************************************************/
+
+client_t * table_find(table_t * tp, const diminuto_ipv6_t * addressp, diminuto_port_t port)
+{
+    client_t * result = (client_t *)0;
+    client_t * cp = (client_t *)0;
+    uint32_t hash = 0;
+    unsigned int index = 0;
+
+    hash = table_hash(addressp, port);
+    tp->lookups += 1;
+
+    for (index = hash & (tp->slots - 1); tp->slot[index] >= 0; index = (index + 1) & (tp->slots - 1)) {
+        tp->probes += 1;
+        cp = &(tp->pool[tp->slot[index]]);
+        if (cp->hash != hash) {
+            /* Do nothing. */
+        } else if (cp->port != port) {
+            /* Do nothing. */
+        } else if (memcmp(&(cp->address), addressp, sizeof(cp->address)) != 0) {
+            /* Do nothing. */
+        } else {
+            result = cp;
+            break;
+        }
+    }
+
+    return result;
+}
+
+client_t * table_insert(table_t * tp, const diminuto_ipv6_t * addressp, diminuto_port_t port, class_t classification, long now)
+{
+    client_t * cp = (client_t *)0;
+    unsigned int index = 0;
+
+    if (tp->free.next != (link_t *)0) {
+
+        cp = (client_t *)(tp->free.next);
+        tp->free.next = cp->link.next;
+        cp->link.next = cp->link.prev = (link_t *)0;
+
+        cp->address = *addressp;
+        cp->port = port;
+        cp->classification = classification;
+        cp->sequence = 0;
+        cp->errors = 0;
+        cp->subscription.rules = 0;
+        subscription_reset(&(cp->state));
+        cp->hash = table_hash(addressp, port);
+
+        for (index = cp->hash & (tp->slots - 1); tp->slot[index] >= 0; index = (index + 1) & (tp->slots - 1)) {
+            /* Do nothing. */
+        }
+        tp->slot[index] = cp - tp->pool;
+        cp->slot = index;
+
+        if (classification == ROVER) {
+            cp->rover = tp->rovers++;
+            tp->rover[cp->rover] = cp;
+        } else {
+            cp->rover = -1;
+        }
+
+        cp->last = now;
+        cp->deadline = now + tp->timeout + 1;
+        table_link(tp, cp);
+
+        tp->active += 1;
+
+    }
+
+    return cp;
+}
+
+void table_remove(table_t * tp, client_t * cp)
+{
+    unsigned int hole = 0;
+    unsigned int index = 0;
+    unsigned int home = 0;
+    client_t * mp = (client_t *)0;
+
+    table_unlink(cp);
+
+    /*
+     * Backward shift deletion: move each following entry in the probe run
+     * into the hole unless its home slot lies cyclically between the hole
+     * and where it is now, in which case moving it would make it unfindable.
+     */
+
+    hole = cp->slot;
+    tp->slot[hole] = -1;
+    for (index = (hole + 1) & (tp->slots - 1); tp->slot[index] >= 0; index = (index + 1) & (tp->slots - 1)) {
+        mp = &(tp->pool[tp->slot[index]]);
+        home = mp->hash & (tp->slots - 1);
+        if (((index - home) & (tp->slots - 1)) >= ((index - hole) & (tp->slots - 1))) {
+            tp->slot[hole] = tp->slot[index];
+            tp->slot[index] = -1;
+            mp->slot = hole;
+            hole = index;
+        }
+    }
+    cp->slot = -1;
+
+    if (cp->rover >= 0) {
+        tp->rovers -= 1;
+        mp = tp->rover[tp->rovers];
+        tp->rover[cp->rover] = mp;
+        mp->rover = cp->rover;
+        cp->rover = -1;
+    }
+
+    cp->link.next = tp->free.next;
+    tp->free.next = &(cp->link);
+
+    tp->active -= 1;
+}
+
+/*******************************************************************************
+ * TIMER WHEEL
+ ******************************************************************************/
+
+void table_touch(table_t * tp, client_t * cp, long now)
+{
+    if (cp->last != now) {
+        table_unlink(cp);
+        cp->last = now;
+        cp->deadline = now + tp->timeout + 1;
+        table_link(tp, cp);
+    }
+}
+
+client_t * table_expire(table_t * tp, long now)
+{
+    client_t * result = (client_t *)0;
+    link_t * sp = (link_t *)0;
+    link_t * lp = (link_t *)0;
+
+    /*
+     * If we fell more than a full revolution behind, every spoke gets
+     * visited exactly once.
+     */
+
+    if ((now - tp->now) > tp->spokes) {
+        tp->now = now - tp->spokes;
+    }
+
+    while (tp->now < now) {
+        sp = table_spoke(tp, tp->now + 1);
+        for (lp = sp->next; lp != sp; lp = lp->next) {
+            if (((client_t *)lp)->deadline <= now) {
+                result = (client_t *)lp;
+                break;
+            }
+        }
+        if (result != (client_t *)0) {
+            table_unlink(result);
+            break;
+        }
+        tp->now += 1;
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+ * AUDIT
+ ******************************************************************************/
+
+unsigned int table_audit(const table_t * tp)
+{
+    unsigned int problems = 0;
+    unsigned int index = 0;
+    unsigned int active = 0;
+    unsigned int rovers = 0;
+    unsigned int ii = 0;
+    const client_t * cp = (const client_t *)0;
+    const link_t * lp = (const link_t *)0;
+
+    for (ii = 0; ii < tp->slots; ++ii) {
+        if (tp->slot[ii] < 0) {
+            continue;
+        }
+        active += 1;
+        cp = &(tp->pool[tp->slot[ii]]);
+        if (cp->slot != ii) {
+            problems += 1;
+        }
+        if (cp->hash != table_hash(&(cp->address), cp->port)) {
+            problems += 1;
+        }
+        for (index = cp->hash & (tp->slots - 1); index != ii; index = (index + 1) & (tp->slots - 1)) {
+            if (tp->slot[index] < 0) {
+                problems += 1;
+                break;
+            }
+        }
+        if (cp->classification == ROVER) {
+            rovers += 1;
+            if ((cp->rover < 0) || (cp->rover >= tp->rovers) || (tp->rover[cp->rover] != cp)) {
+                problems += 1;
+            }
+        }
+        if (cp->deadline != (cp->last + tp->timeout + 1)) {
+            problems += 1;
+        }
+        if (cp->link.next == (link_t *)0) {
+            problems += 1;
+        } else if ((cp->link.next->prev != &(cp->link)) || (cp->link.prev->next != &(cp->link))) {
+            problems += 1;
+        }
+    }
+
+    if (active != tp->active) {
+        problems += 1;
+    }
+
+    if (rovers != tp->rovers) {
+        problems += 1;
+    }
+
+    for (lp = tp->free.next; lp != (const link_t *)0; lp = lp->next) {
+        active += 1;
+        if (active > tp->clients) {
+            problems += 1;
+            break;
+        }
+    }
+
+    if (active != tp->clients) {
+        problems += 1;
+    }
+
+    return problems;
+}
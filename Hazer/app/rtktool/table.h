@@ -0,0 +1,121 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_RTKTOOL_TABLE_
+#define _H_COM_DIAG_HAZER_RTKTOOL_TABLE_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This declares and defines the rtktool client table.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The client table holds every client the router knows about in a pool
+ * allocated once at start up, so that no memory is allocated or freed
+ * as clients come and go. Clients are found by address and port in an
+ * open addressing hash table with linear probing, sized to at least twice
+ * the pool so that probe sequences stay short; deletion shifts entries
+ * back rather than leaving tombstones. Each client is also linked into a
+ * timer wheel by the second in which it will expire, so that aging clients
+ * touches only those that are due. Rovers are additionally kept in a dense
+ * array so that forwarding a correction does not have to walk the pool.
+ */
+
+#include <stdint.h>
+#include "types.h"
+
+/**
+ * This is the default number of clients in the pool.
+ */
+#define TABLE_CLIENTS (16384)
+
+/**
+ * This is the client table.
+ */
+typedef struct Table {
+    client_t * pool;                /* Preallocated clients. */
+    link_t free;                    /* Free list (next only). */
+    int32_t * slot;                 /* Hash table of pool indices or <0. */
+    link_t * spoke;                 /* Timer wheel sentinels. */
+    client_t ** rover;              /* Dense array of rovers. */
+    unsigned int clients;           /* Size of the pool. */
+    unsigned int slots;             /* Size of the hash table (power of two). */
+    unsigned int spokes;            /* Size of the wheel (power of two). */
+    unsigned int active;            /* Clients in use. */
+    unsigned int rovers;            /* Rovers in use. */
+    long timeout;                   /* Client timeout in seconds. */
+    long now;                       /* Last second the wheel was advanced to. */
+    uint64_t lookups;               /* Hash table lookups. */
+    uint64_t probes;                /* Hash table slots examined. */
+} table_t;
+
+/**
+ * Allocate and initialize a client table.
+ * @param tp points to the table.
+ * @param clients is the number of clients in the pool.
+ * @param timeout is the client timeout in seconds.
+ * @param now is the current elapsed time in seconds.
+ * @return a pointer to the table or NULL if allocation failed.
+ */
+extern table_t * table_init(table_t * tp, unsigned int clients, long timeout, long now);
+
+/**
+ * Release the storage held by a client table.
+ * @param tp points to the table.
+ */
+extern void table_fini(table_t * tp);
+
+/**
+ * Find a client by address and port.
+ * @param tp points to the table.
+ * @param addressp points to the address.
+ * @param port is the port.
+ * @return a pointer to the client or NULL if it is not in the table.
+ */
+extern client_t * table_find(table_t * tp, const diminuto_ipv6_t * addressp, diminuto_port_t port);
+
+/**
+ * Add a client that is not already in the table. Its sequence number and
+ * error count are zero, and it is treated as having been heard from now.
+ * @param tp points to the table.
+ * @param addressp points to the address.
+ * @param port is the port.
+ * @param classification is the class of the client.
+ * @param now is the current elapsed time in seconds.
+ * @return a pointer to the client or NULL if the pool is exhausted.
+ */
+extern client_t * table_insert(table_t * tp, const diminuto_ipv6_t * addressp, diminuto_port_t port, class_t classification, long now);
+
+/**
+ * Note that a client has been heard from, postponing its expiration.
+ * @param tp points to the table.
+ * @param cp points to the client.
+ * @param now is the current elapsed time in seconds.
+ */
+extern void table_touch(table_t * tp, client_t * cp, long now);
+
+/**
+ * Remove a client from the table and return it to the pool.
+ * @param tp points to the table.
+ * @param cp points to the client.
+ */
+extern void table_remove(table_t * tp, client_t * cp);
+
+/**
+ * Return the next client that has not been heard from for more than the
+ * timeout. The client is still in the table; the caller is expected to
+ * remove it. Call repeatedly until it returns NULL.
+ * @param tp points to the table.
+ * @param now is the current elapsed time in seconds.
+ * @return a pointer to an expired client or NULL if there are no more.
+ */
+extern client_t * table_expire(table_t * tp, long now);
+
+/**
+ * Check the consistency of the table.
+ * @param tp points to the table.
+ * @return 0 if the table is consistent, or the number of problems found.
+ */
+extern unsigned int table_audit(const table_t * tp);
+
+#endif
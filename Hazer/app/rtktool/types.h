@@ -4,7 +4,7 @@
 
 /**
  * @file
- * @copyright Copyright 2019 Digital Aggregates Corporation, Colorado, USA.
+ * @copyright Copyright 2019-2024 Digital Aggregates Corporation, Colorado, USA.
  * @note Licensed under the terms in LICENSE.txt.
  * @brief These are the type definitions for the rtktool RTK router.
  * @author Chip Overclock <mailto:coverclock@diag.com>
@@ -12,10 +12,11 @@
  * @details
  */
 
-#include "com/diag/diminuto/diminuto_tree.h"
+#include <stdint.h>
 #include "com/diag/diminuto/diminuto_ipc6.h"
 #include "com/diag/diminuto/diminuto_time.h"
 #include "com/diag/hazer/datagram.h"
+#include "com/diag/hazer/subscription.h"
 
 /**
  * Clients of the router can be in one of two classes: a stationary base
@@ -28,22 +29,39 @@ typedef enum Class {
     ROVER   = 'R',
 } class_t;
 
+/**
+ * This links a client into a circular doubly-linked list in the expiry
+ * wheel, or (using only the next pointer) into the free list.
+ */
+typedef struct Link {
+    struct Link * next;
+    struct Link * prev;
+} link_t;
+
 /**
  * This structure describes the state we have to maintain about clients.
+ * Clients live in a preallocated pool owned by the client table.
  */
 typedef struct Client {
-    diminuto_tree_t node;
-    long last;
+    link_t link;                    /* Must be first. */
+    long last;                      /* Elapsed seconds when last heard from. */
+    long deadline;                  /* Elapsed seconds when it expires. */
+    uint32_t hash;                  /* Hash of address and port. */
+    int32_t slot;                   /* Index in the hash table. */
+    int32_t rover;                  /* Index in the rover array or <0. */
     datagram_sequence_t sequence;
     class_t classification;
     diminuto_ipv6_t address;
     diminuto_port_t port;
+    unsigned int errors;
+    subscription_t subscription;    /* RTCM messages this rover wants. */
+    subscription_state_t state;     /* When each was last forwarded. */
 } client_t;
 
 /**
  * @def CLIENT_INITIALIZER
  * This is how we can statically initialize the client structure.
  */
-#define CLIENT_INITIALIZER { DIMINUTO_TREE_NULLINIT, 0, 0, CLASSIFICATION, { 0, }, 0, }
+#define CLIENT_INITIALIZER { { (link_t *)0, (link_t *)0, }, 0, 0, 0, -1, -1, 0, CLASS, { 0, }, 0, 0, SUBSCRIPTION_INITIALIZER, { { 0, }, }, }
 
 #endif
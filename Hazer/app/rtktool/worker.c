@@ -0,0 +1,660 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2019-2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This implements the rtktool workers.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include "com/diag/diminuto/diminuto_assert.h"
+#include "com/diag/diminuto/diminuto_dump.h"
+#include "com/diag/diminuto/diminuto_frequency.h"
+#include "com/diag/diminuto/diminuto_hangup.h"
+#include "com/diag/diminuto/diminuto_interrupter.h"
+#include "com/diag/diminuto/diminuto_ipc6.h"
+#include "com/diag/diminuto/diminuto_log.h"
+#include "com/diag/diminuto/diminuto_terminator.h"
+#include "com/diag/hazer/tumbleweed.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include "worker.h"
+
+/*******************************************************************************
+ * HELPERS
+ ******************************************************************************/
+
+/*
+ * Create a dual stack datagram socket bound to the rendezvous port that
+ * other sockets may also bind to, so that the kernel spreads the
+ * incoming datagrams across them.
+ */
+static int worker_socket(diminuto_port_t port)
+{
+    int sock = -1;
+    int value = 0;
+    struct sockaddr_in6 address = { 0, };
+
+    address.sin6_family = AF_INET6;
+    address.sin6_addr = in6addr_any;
+    address.sin6_port = htons(port);
+
+    if ((sock = socket(AF_INET6, SOCK_DGRAM, 0)) < 0) {
+        diminuto_perror("worker_socket: socket");
+    } else if ((value = 0), (setsockopt(sock, IPPROTO_IPV6, IPV6_V6ONLY, &value, sizeof(value)) < 0)) {
+        diminuto_perror("worker_socket: IPV6_V6ONLY");
+        (void)close(sock);
+        sock = -1;
+    } else if ((value = !0), (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &value, sizeof(value)) < 0)) {
+        diminuto_perror("worker_socket: SO_REUSEPORT");
+        (void)close(sock);
+        sock = -1;
+    } else if (bind(sock, (struct sockaddr *)&address, sizeof(address)) < 0) {
+        diminuto_perror("worker_socket: bind");
+        (void)close(sock);
+        sock = -1;
+    } else {
+        /* Do nothing. */
+    }
+
+    return sock;
+}
+
+/*
+ * Send a correction to the destinations collected so far with a single
+ * system call (barring errors).
+ */
+static void worker_flush(worker_t * wp, const datagram_buffer_t * bufferp, ssize_t total)
+{
+    router_t * rp = wp->routerp;
+    client_t * thee = (client_t *)0;
+    diminuto_ipv6_buffer_t ipv6 = { 0, };
+    diminuto_sticks_t before = 0;
+    diminuto_sticks_t latency = 0;
+    ssize_t result = 0;
+    unsigned int ii = 0;
+
+    before = diminuto_time_elapsed();
+    result = datagram_fanout_send(&(wp->fanout), wp->sock, bufferp, total);
+    latency = diminuto_time_elapsed() - before;
+    if ((wp->fanouts == 0) || (latency < wp->shortest)) { wp->shortest = latency; }
+    if ((wp->fanouts == 0) || (latency > wp->longest)) { wp->longest = latency; }
+    wp->elapsed += latency;
+    wp->fanouts += 1;
+    DIMINUTO_LOG_DEBUG("Datagram Fanout [%zd] %zd/%u %lldns", total, result, wp->fanout.count, (long long)((latency * 1000000000LL) / rp->frequency));
+
+    for (ii = 0; ii < wp->fanout.count; ++ii) {
+        thee = wp->destination[ii];
+        if (wp->fanout.error[ii] == 0) {
+            DIMINUTO_LOG_DEBUG("Datagram Sent [%s]:%d [%zd]", diminuto_ipc6_address2string(thee->address, ipv6, sizeof(ipv6)), thee->port, total);
+        } else {
+            thee->errors += 1;
+            DIMINUTO_LOG_WARNING("Datagram Error [%s]:%d (%d) \"%s\" %u", diminuto_ipc6_address2string(thee->address, ipv6, sizeof(ipv6)), thee->port, wp->fanout.error[ii], strerror(wp->fanout.error[ii]), thee->errors);
+        }
+    }
+
+    datagram_fanout_reset(&(wp->fanout));
+}
+
+/*
+ * Forward a correction to every rover in this worker's shard that
+ * subscribes to its message number and is due for another one.
+ */
+static void worker_fanout(worker_t * wp, const datagram_buffer_t * bufferp, ssize_t total, int number, long now)
+{
+    client_t * thee = (client_t *)0;
+    unsigned int rover = 0;
+    int index = 0;
+
+    for (rover = 0; rover < wp->table.rovers; ++rover) {
+        thee = wp->table.rover[rover];
+        if (!subscription_admit(&(thee->subscription), &(thee->state), number, now)) {
+            wp->filtered += 1;
+            continue;
+        }
+        index = datagram_fanout_add(&(wp->fanout), thee->address.u16, thee->port);
+        wp->destination[index] = thee;
+        if (wp->fanout.count >= DATAGRAM_FANOUT) {
+            worker_flush(wp, bufferp, total);
+        }
+    }
+
+    if (wp->fanout.count > 0) {
+        worker_flush(wp, bufferp, total);
+    }
+}
+
+/*
+ * Note which of the worker's descriptors are ready. Readiness is edge
+ * triggered, so the socket is remembered as readable until a batch comes
+ * back short, which means that it has been drained.
+ */
+static void worker_ready(loop_t * lp, int fd, uint32_t events, void * context)
+{
+    worker_t * wp = (worker_t *)context;
+    uint64_t value = 0;
+
+    if (fd == wp->sock) {
+        wp->readable = !0;
+    } else if (fd == wp->doorbell) {
+        (void)read(wp->doorbell, &value, sizeof(value));
+    } else {
+        /* Do nothing. */
+    }
+}
+
+/*
+ * Hand a correction to every other worker.
+ */
+static void worker_publish(worker_t * wp, const datagram_buffer_t * bufferp, ssize_t total)
+{
+    router_t * rp = wp->routerp;
+    static const uint64_t ONE = 1;
+    int ii = 0;
+
+    ring_publish(&(rp->ring), bufferp, total, wp->index);
+
+    for (ii = 0; ii < rp->workers; ++ii) {
+        if (ii == wp->index) {
+            continue;
+        }
+        if (write(rp->worker[ii].doorbell, &ONE, sizeof(ONE)) != sizeof(ONE)) {
+            diminuto_perror("worker_publish: write");
+        }
+    }
+}
+
+/*
+ * Release the base if this worker owns it.
+ */
+static void worker_release(worker_t * wp)
+{
+    wp->base = (client_t *)0;
+    __atomic_store_n(&(wp->routerp->owner), -1, __ATOMIC_RELEASE);
+}
+
+/*******************************************************************************
+ * ROUTER
+ ******************************************************************************/
+
+router_t * router_init(router_t * rp, int workers, unsigned int clients, long timeout, int debug, int verbose)
+{
+    router_t * result = (router_t *)0;
+    int ii = 0;
+
+    ring_init(&(rp->ring));
+    rp->frequency = diminuto_frequency();
+    rp->timeout = timeout;
+    rp->clients = clients;
+    rp->workers = workers;
+    rp->subscriptions = (subscription_entry_t *)0;
+    rp->subscribers = 0;
+    rp->owner = -1;
+    rp->done = 0;
+    rp->debug = debug;
+    rp->verbose = verbose;
+
+    if ((rp->worker = (worker_t *)calloc(workers, sizeof(worker_t))) != (worker_t *)0) {
+        for (ii = 0; ii < workers; ++ii) {
+            rp->worker[ii].index = ii;
+            rp->worker[ii].sock = -1;
+            rp->worker[ii].doorbell = -1;
+            rp->worker[ii].loop.epfd = -1;
+        }
+        result = rp;
+    }
+
+    return result;
+}
+
+int router_subscribe(router_t * rp, const char * path)
+{
+    int rc = -1;
+    ssize_t count = 0;
+    unsigned int line = 0;
+
+    if ((count = subscription_load(path, &(rp->subscriptions), &line)) >= 0) {
+        rp->subscribers = count;
+        DIMINUTO_LOG_INFORMATION("Router Subscriptions \"%s\" %zu", path, rp->subscribers);
+        rc = 0;
+    } else if (line > 0) {
+        DIMINUTO_LOG_WARNING("Router Subscriptions \"%s\" line %u invalid", path, line);
+    } else {
+        diminuto_perror(path);
+    }
+
+    return rc;
+}
+
+void router_fini(router_t * rp)
+{
+    free(rp->worker);
+    rp->worker = (worker_t *)0;
+    free(rp->subscriptions);
+    rp->subscriptions = (subscription_entry_t *)0;
+    rp->subscribers = 0;
+}
+
+/*******************************************************************************
+ * WORKER
+ ******************************************************************************/
+
+worker_t * worker_init(router_t * rp, int index, diminuto_port_t port)
+{
+    worker_t * result = (worker_t *)0;
+    worker_t * wp = &(rp->worker[index]);
+    long now = 0;
+
+    wp->routerp = rp;
+    wp->base = (client_t *)0;
+    wp->cursor = ring_head(&(rp->ring));
+
+    datagram_batch_init(&(wp->batch));
+
+    datagram_fanout_init(&(wp->fanout));
+
+    now = diminuto_time_elapsed() / rp->frequency;
+
+    if (rp->workers > 1) {
+        wp->sock = worker_socket(port);
+    } else {
+        wp->sock = diminuto_ipc6_datagram_peer(port);
+    }
+
+    if (wp->sock < 0) {
+        /* Do nothing. */
+    } else if (loop_init(&(wp->loop), 2) != &(wp->loop)) {
+        diminuto_perror("worker_init: loop_init");
+    } else if (loop_register(&(wp->loop), wp->sock, LOOP_READ, worker_ready, wp) < 0) {
+        diminuto_perror("worker_init: loop_register");
+    } else if ((rp->workers > 1) && ((wp->doorbell = eventfd(0, EFD_NONBLOCK)) < 0)) {
+        diminuto_perror("worker_init: eventfd");
+    } else if ((wp->doorbell >= 0) && (loop_register(&(wp->loop), wp->doorbell, LOOP_READ, worker_ready, wp) < 0)) {
+        diminuto_perror("worker_init: loop_register");
+    } else if (table_init(&(wp->table), rp->clients, rp->timeout, now) != &(wp->table)) {
+        /* Do nothing. */
+    } else {
+        DIMINUTO_LOG_INFORMATION("Worker %d (%d) Clients=%u Slots=%u Spokes=%u", wp->index, wp->sock, wp->table.clients, wp->table.slots, wp->table.spokes);
+        result = wp;
+    }
+
+    return result;
+}
+
+void * worker_run(void * arg)
+{
+    worker_t * wp = (worker_t *)arg;
+    router_t * rp = wp->routerp;
+    diminuto_ipv6_buffer_t ipv6 = { 0, };
+    datagram_buffer_t * bufferp = (datagram_buffer_t *)0;
+    const struct sockaddr_storage * sap = (const struct sockaddr_storage *)0;
+    diminuto_ipv6_t address = { 0, };
+    diminuto_port_t port = 0;
+    datagram_sequence_t sequence = 0;
+    class_t classification = CLASS;
+    client_t * thou = (client_t *)0;
+    client_t * thee = (client_t *)0;
+    const char * label = (const char *)0;
+    subscription_t subscription = SUBSCRIPTION_INITIALIZER;
+    const subscription_t * sp = (const subscription_t *)0;
+    ssize_t total = 0;
+    ssize_t size = 0;
+    ssize_t length = 0;
+    unsigned int problems = 0;
+    int expected = -1;
+    int origin = -1;
+    int number = -1;
+    int control = 0;
+    int ready = 0;
+    long now = 0;
+
+    while (!0) {
+
+        /*
+         * Check our signal handlers. Whichever worker notices a signal
+         * tells all of the others.
+         */
+
+        if (__atomic_load_n(&(rp->done), __ATOMIC_ACQUIRE)) {
+            break;
+        }
+
+        if (diminuto_terminator_check()) {
+            DIMINUTO_LOG_NOTICE("SIGTERM");
+            __atomic_store_n(&(rp->done), !0, __ATOMIC_RELEASE);
+            break;
+        }
+
+        if (diminuto_interrupter_check()) {
+            DIMINUTO_LOG_NOTICE("SIGINT");
+            __atomic_store_n(&(rp->done), !0, __ATOMIC_RELEASE);
+            break;
+        }
+
+        if (diminuto_hangup_check()) {
+            diminuto_log_mask ^= DIMINUTO_LOG_MASK_DEBUG;
+        }
+
+        /*
+         * Wait until our socket needs to be serviced... or we time out.
+         * If the socket wasn't drained the last time through, there's no
+         * point in waiting.
+         */
+
+        if (wp->readable) {
+            /* Do nothing. */
+        } else if ((ready = loop_wait(&(wp->loop), 1000)) >= 0) {
+            /* Do nothing. */
+        } else if (errno == EINTR) {
+            continue;
+        } else {
+            diminuto_panic();
+        }
+
+        /*
+         * Get a timestamp.
+         */
+
+        now = diminuto_time_elapsed() / rp->frequency;
+
+        /*
+         * Forward any corrections published by other workers to our own
+         * rovers. The doorbell just wakes us up; the ring is checked
+         * every time through the loop regardless.
+         */
+
+        if (rp->workers > 1) {
+            while (ring_consume(&(rp->ring), &(wp->cursor), &(wp->relay), &total, &origin, &(wp->overruns))) {
+                if (origin == wp->index) {
+                    continue;
+                }
+                wp->relayed += 1;
+                number = tumbleweed_message(wp->relay.payload.buffers.rtcm, total - sizeof(wp->relay.header));
+                worker_fanout(wp, &(wp->relay), total, number, now);
+            }
+        }
+
+        /*
+         * Service the socket. Up to a batch of datagrams waiting on it is
+         * received at once, and then each datagram in the batch is
+         * processed in the order in which it arrived. A REJECT moves on to
+         * the next one. A short batch means the socket has been drained.
+         */
+
+        if (wp->readable) {
+            if (datagram_batch_receive(&(wp->batch), wp->sock) < DATAGRAM_BATCH) {
+                wp->readable = 0;
+            }
+        }
+
+        while ((bufferp = datagram_batch_next(&(wp->batch), &total, &sap)) != (datagram_buffer_t *)0) {
+
+            /*
+             * Identify the sender of the next datagram in the batch.
+             */
+
+            if (datagram_batch_identify(sap, address.u16, &port) < 0) {
+                DIMINUTO_LOG_ERROR("Datagram Family [%zd]", total);
+                continue;
+            }
+
+            if (total < sizeof(bufferp->header)) {
+                DIMINUTO_LOG_ERROR("Datagram Length [%s]:%d [%zd]", diminuto_ipc6_address2string(address, ipv6, sizeof(ipv6)), port, total);
+                continue;
+            }
+
+            DIMINUTO_LOG_DEBUG("Datagram Received [%s]:%d [%zd]", diminuto_ipc6_address2string(address, ipv6, sizeof(ipv6)), port, total);
+
+            if (rp->verbose) {
+                fprintf(stderr, "Datagram [%s]:%d [%zd]\n", diminuto_ipc6_address2string(address, ipv6, sizeof(ipv6)), port, total);
+                diminuto_dump(stderr, bufferp, total);
+            }
+
+            /*
+             * See if we know about this client. A client we don't know
+             * about starts out expecting sequence number zero, but isn't
+             * added to the table unless its datagram is acceptable.
+             */
+
+            if ((thou = table_find(&(wp->table), &address, port)) == (client_t *)0) {
+                sequence = 0; /* RESET */
+            } else {
+                sequence = thou->sequence;
+            }
+
+            /*
+             * Validate the datagram. This is more complicated than it looks.
+             * I'd really like to add end-to-end encryption to this data
+             * stream. But to do so, I either have to have this utility be a
+             * man-in-the-middle, decrypting and reencrypting the stream, or
+             * else distribute the datagram without validation. I don't like
+             * either option.
+             */
+
+            if ((size = datagram_validate(&sequence, &(bufferp->header), total, &(wp->outoforder), &(wp->missing))) < 0) {
+                DIMINUTO_LOG_NOTICE("Datagram Order {%lu} {%lu} [%s]:%d", (unsigned long)sequence, (unsigned long)ntohl(bufferp->header.sequence), diminuto_ipc6_address2string(address, ipv6, sizeof(ipv6)), port);
+                continue; /* REJECT */
+            } else if ((length = tumbleweed_validate(bufferp->payload.buffers.rtcm, size)) < TUMBLEWEED_RTCM_SHORTEST) {
+                DIMINUTO_LOG_WARNING("Datagram Data [%zd] 0x%02x [%s]:%d", length, bufferp->payload.data[0], diminuto_ipc6_address2string(address, ipv6, sizeof(ipv6)), port);
+                continue; /* REJECT */
+            } else {
+                /* Do nothing. */
+            }
+
+            /*
+             * Determine this client's classification. A control message
+             * carrying a subscription is longer than a keepalive, but it
+             * comes from a rover all the same.
+             */
+
+            number = tumbleweed_message(bufferp->payload.buffers.rtcm, length);
+            control = (number == SUBSCRIPTION_NUMBER) && (subscription_decode(bufferp->payload.buffers.rtcm, length, &subscription) == 0);
+
+            if (control) {
+                classification = ROVER;
+                label = "rover";
+            } else if (length > TUMBLEWEED_RTCM_SHORTEST) {
+                classification = BASE;
+                label = "base";
+            } else {
+                classification = ROVER;
+                label = "rover";
+            }
+
+            /*
+             * If this client's classification has changed, we reject it.
+             * If it's in fact legitimate (somehow), its existing entry will
+             * eventually time out, be removed, and can be registered anew on
+             * reception of a subsequent datagram.
+             */
+
+            if (thou == (client_t *)0) {
+                /* Do nothing. */
+            } else if (classification != thou->classification) {
+                DIMINUTO_LOG_WARNING("Client Change %s [%s]:%d", label, diminuto_ipc6_address2string(address, ipv6, sizeof(ipv6)), port);
+                continue; /* REJECT */
+            } else {
+                /* Do nothing. */
+            }
+
+            /*
+             * If this is a base, but we already have a base, we reject it.
+             * Again, the existing base will time out if it is no longer
+             * sending, we'll remove it, and the new one can be reregistered.
+             * Note that we log a pretender base at DEBUG level since otherwise
+             * it can flood the log. The base may belong to another worker,
+             * so a new base has to be claimed for this worker atomically.
+             */
+
+            if (classification != BASE) {
+                /* Do nothing. */
+            } else if (wp->base != (client_t *)0) {
+                if (wp->base != thou) {
+                    DIMINUTO_LOG_DEBUG("Client Conflict %s [%s]:%d", label, diminuto_ipc6_address2string(address, ipv6, sizeof(ipv6)), port);
+                    continue; /* REJECT */
+                }
+            } else if ((expected = -1), !__atomic_compare_exchange_n(&(rp->owner), &expected, wp->index, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                DIMINUTO_LOG_DEBUG("Client Conflict %s [%s]:%d %d", label, diminuto_ipc6_address2string(address, ipv6, sizeof(ipv6)), port, expected);
+                continue; /* REJECT */
+            } else {
+                /* Do nothing. */
+            }
+
+            /*
+             * If this a new client, add it to the table. If the table is
+             * full, we reject it; some existing client will eventually time
+             * out and make room.
+             */
+
+            if (thou != (client_t *)0) {
+                /* Do nothing. */
+            } else if ((thou = table_insert(&(wp->table), &address, port, classification, now)) == (client_t *)0) {
+                DIMINUTO_LOG_WARNING("Client Full %s [%s]:%d %u", label, diminuto_ipc6_address2string(address, ipv6, sizeof(ipv6)), port, wp->table.active);
+                if ((classification == BASE) && (wp->base == (client_t *)0)) {
+                    worker_release(wp);
+                }
+                continue; /* REJECT */
+            } else {
+                DIMINUTO_LOG_NOTICE("Client New %s [%s]:%d ", label, diminuto_ipc6_address2string(thou->address, ipv6, sizeof(ipv6)), thou->port);
+                if (thou->classification == BASE) {
+                    wp->base = thou;
+                    DIMINUTO_LOG_NOTICE("Client Set %s [%s]:%d %d", label, diminuto_ipc6_address2string(thou->address, ipv6, sizeof(ipv6)), thou->port, wp->index);
+                } else if ((sp = subscription_lookup(rp->subscriptions, rp->subscribers, thou->address.u16, thou->port)) != (const subscription_t *)0) {
+                    thou->subscription = *sp;
+                    DIMINUTO_LOG_NOTICE("Client Subscribe %s [%s]:%d %u file", label, diminuto_ipc6_address2string(thou->address, ipv6, sizeof(ipv6)), thou->port, thou->subscription.rules);
+                } else {
+                    /* Do nothing. */
+                }
+                if (rp->debug) {
+                    fprintf(stderr, "Client [%s]:%d [%zd] %p %u %d %d %d\n", diminuto_ipc6_address2string(thou->address, ipv6, sizeof(ipv6)), thou->port, total, thou, wp->table.active, thou->slot, thou->rover, wp->index);
+                    diminuto_dump(stderr, &(thou->address), sizeof(thou->address));
+                    diminuto_dump(stderr, &(thou->port), sizeof(thou->port));
+                }
+            }
+
+            /*
+             * Cannot REJECT after this point.
+             */
+
+            thou->sequence = sequence;
+
+            /*
+             * A control message replaces whatever subscription the rover
+             * had, and starts its intervals over. It is never forwarded.
+             */
+
+            if (control) {
+                thou->subscription = subscription;
+                subscription_reset(&(thou->state));
+                wp->subscribed += 1;
+                DIMINUTO_LOG_NOTICE("Client Subscribe %s [%s]:%d %u message", label, diminuto_ipc6_address2string(thou->address, ipv6, sizeof(ipv6)), thou->port, thou->subscription.rules);
+            }
+
+            /*
+             * If this is a base, forward the datagram to all rovers, ours
+             * directly and everyone else's through the ring. Note
+             * that if it is truly a new base, its sequence numbers will
+             * likely be behind that of the old base, and all of the rovers
+             * will need to be restarted manually. But it is also possible
+             * that the base is the same and some darn NATting firewall just
+             * changed the client's address, in which case the sequence
+             * numbers are fine. (Rover clients that are truly mobile may
+             * see their IPv4 addresses change as they switch from cell site
+             * to cell site. But it can happen to non-mobile rovers and even
+             * stationary bases, because of a particular cell site becoming
+             * overloaded and the network deciding to switch a client to a
+             * different, perhaps slightly more distant, cell site.)
+             */
+
+            if (thou->classification == BASE) {
+                worker_fanout(wp, bufferp, total, number, now);
+                if (rp->workers > 1) {
+                    worker_publish(wp, bufferp, total);
+                }
+            }
+
+            if (rp->debug) {
+                problems = table_audit(&(wp->table));
+                diminuto_contract(problems == 0);
+            }
+
+            /*
+             * Timestamp the client now that we know that the client and its
+             * datagram are valid. If we haven't heard from a client within the
+             * timeout period, we'll remove it. As a useful side effect, if a
+             * client gets restarted such that its sequence numbers are
+             * unexpected, or if a client changes classifications from base to
+             * rover or vice versa, we will eventually remove it and reregister
+             * its connection as a new one.
+             */
+
+            table_touch(&(wp->table), thou, now);
+
+        }
+
+        /*
+         * Remove every client, rover or base (so we need to check if it's a
+         * base), that we haven't heard from within the timeout period. The
+         * table's timer wheel only visits those clients that are due.
+         */
+
+        while ((thee = table_expire(&(wp->table), now)) != (client_t *)0) {
+            DIMINUTO_LOG_NOTICE("Client Old %s [%s]:%d %u", (thee->classification == BASE) ? "base" : (thee->classification == ROVER) ? "rover" : "unknown", diminuto_ipc6_address2string(thee->address, ipv6, sizeof(ipv6)), thee->port, thee->errors);
+            if (thee == wp->base) {
+                worker_release(wp);
+            }
+            table_remove(&(wp->table), thee);
+        }
+
+    }
+
+    return (void *)0;
+}
+
+void worker_report(const worker_t * wp)
+{
+    const router_t * rp = wp->routerp;
+
+    DIMINUTO_LOG_INFORMATION("Worker %d Counters OutOfOrder=%u Missing=%u", wp->index, wp->outoforder, wp->missing);
+
+    DIMINUTO_LOG_INFORMATION("Worker %d Batches Packets=%llu Wakeups=%llu Maximum=%u", wp->index, (unsigned long long)wp->batch.packets, (unsigned long long)wp->batch.wakeups, wp->batch.maximum);
+
+    DIMINUTO_LOG_INFORMATION("Worker %d Fanouts Packets=%llu Errors=%llu Calls=%llu Fanouts=%llu", wp->index, (unsigned long long)wp->fanout.packets, (unsigned long long)wp->fanout.errors, (unsigned long long)wp->fanout.calls, (unsigned long long)wp->fanouts);
+
+    DIMINUTO_LOG_INFORMATION("Worker %d Subscriptions Filtered=%llu Subscribed=%llu", wp->index, (unsigned long long)wp->filtered, (unsigned long long)wp->subscribed);
+
+    if (wp->fanouts > 0) {
+        DIMINUTO_LOG_INFORMATION("Worker %d Latency Minimum=%lldns Average=%lldns Maximum=%lldns", wp->index, (long long)((wp->shortest * 1000000000LL) / rp->frequency), (long long)(((wp->elapsed / wp->fanouts) * 1000000000LL) / rp->frequency), (long long)((wp->longest * 1000000000LL) / rp->frequency));
+    }
+
+    if (rp->workers > 1) {
+        DIMINUTO_LOG_INFORMATION("Worker %d Ring Relayed=%llu Overruns=%llu", wp->index, (unsigned long long)wp->relayed, (unsigned long long)wp->overruns);
+    }
+
+    DIMINUTO_LOG_INFORMATION("Worker %d Table Active=%u Rovers=%u Lookups=%llu Probes=%llu", wp->index, wp->table.active, wp->table.rovers, (unsigned long long)wp->table.lookups, (unsigned long long)wp->table.probes);
+}
+
+void worker_fini(worker_t * wp)
+{
+    loop_fini(&(wp->loop));
+
+    if (wp->sock >= 0) {
+        (void)diminuto_ipc_close(wp->sock);
+        wp->sock = -1;
+    }
+
+    if (wp->doorbell >= 0) {
+        (void)close(wp->doorbell);
+        wp->doorbell = -1;
+    }
+
+    table_fini(&(wp->table));
+}
@@ -0,0 +1,153 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_RTKTOOL_WORKER_
+#define _H_COM_DIAG_HAZER_RTKTOOL_WORKER_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This declares and defines the rtktool workers.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A worker is a socket bound to the rendezvous port, the shard of the
+ * client table holding the clients whose datagrams arrive on that socket,
+ * and the loop that services them. Normally there is one worker, run by
+ * the main thread. With more than one, each runs in its own thread with
+ * its own SO_REUSEPORT socket; the kernel spreads clients across the
+ * sockets by hashing their addresses and ports, so a client always
+ * arrives at the same worker and each shard is private to its worker.
+ *
+ * The only state shared among workers is which of them owns the base,
+ * claimed and released atomically so that there is never more than one
+ * base, the broadcast ring on which the owner publishes each correction
+ * after fanning it out to its own rovers, and the flag that tells every
+ * worker to stop. Each worker has an eventfd registered with its
+ * event loop that the owner writes to after publishing, so that the
+ * other workers wake up and fan the correction out to their rovers.
+ *
+ * Each rover may have a subscription, either from the subscription file
+ * when the rover is added to the table, or from a control message the
+ * rover sends in place of a keepalive, which replaces whatever the rover
+ * had before. The message number of a correction is extracted once per
+ * correction, and each rover's subscription is checked against it as the
+ * rovers are added to the fan out.
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include "com/diag/diminuto/diminuto_time.h"
+#include "com/diag/hazer/datagram.h"
+#include "com/diag/hazer/loop.h"
+#include "ring.h"
+#include "table.h"
+#include "types.h"
+
+struct Worker;
+
+/**
+ * This is the state shared by all of the workers.
+ */
+typedef struct Router {
+    ring_t ring;                    /* Corrections for the other workers. */
+    struct Worker * worker;         /* Array of workers. */
+    subscription_entry_t * subscriptions; /* Subscription file entries. */
+    size_t subscribers;             /* Number of subscription file entries. */
+    diminuto_sticks_t frequency;    /* Ticks per second. */
+    long timeout;                   /* Client timeout in seconds. */
+    unsigned int clients;           /* Clients per worker. */
+    int workers;                    /* Number of workers. */
+    int owner;                      /* Worker that owns the base or <0. */
+    int done;                       /* !0 when the workers should stop. */
+    int debug;
+    int verbose;
+} router_t;
+
+/**
+ * This is the state private to each worker.
+ */
+typedef struct Worker {
+    datagram_batch_t batch;         /* Datagrams received from clients. */
+    datagram_fanout_t fanout;       /* Rovers a correction is sent to. */
+    datagram_buffer_t relay;        /* Correction copied from the ring. */
+    client_t * destination[DATAGRAM_FANOUT]; /* Rover for each fan out entry. */
+    table_t table;                  /* This worker's shard of clients. */
+    loop_t loop;                    /* Socket and doorbell. */
+    pthread_t thread;
+    router_t * routerp;
+    client_t * base;                /* Non-NULL if this worker owns the base. */
+    uint64_t cursor;                /* Position in the ring. */
+    uint64_t relayed;               /* Corrections taken from the ring. */
+    uint64_t overruns;              /* Corrections missed in the ring. */
+    uint64_t fanouts;               /* Fan outs performed. */
+    uint64_t filtered;              /* Corrections withheld from rovers. */
+    uint64_t subscribed;            /* Control messages applied. */
+    diminuto_sticks_t shortest;     /* Shortest fan out. */
+    diminuto_sticks_t longest;      /* Longest fan out. */
+    diminuto_sticks_t elapsed;      /* Total time in fan outs. */
+    unsigned int outoforder;
+    unsigned int missing;
+    int index;                      /* Index of this worker. */
+    int sock;                       /* Socket bound to the rendezvous port. */
+    int doorbell;                   /* Eventfd or <0 if only one worker. */
+    int readable;                   /* !0 if the socket may have datagrams. */
+} worker_t;
+
+/**
+ * Initialize the state shared by the workers and allocate the workers.
+ * @param rp points to the router.
+ * @param workers is the number of workers.
+ * @param clients is the number of clients in each shard.
+ * @param timeout is the client timeout in seconds.
+ * @param debug enables debug output.
+ * @param verbose enables verbose output.
+ * @return a pointer to the router or NULL if an error occurred.
+ */
+extern router_t * router_init(router_t * rp, int workers, unsigned int clients, long timeout, int debug, int verbose);
+
+/**
+ * Load the subscription file that is applied to rovers as they are added.
+ * @param rp points to the router.
+ * @param path is the path name of the subscription file.
+ * @return 0 for success, <0 if an error occurred.
+ */
+extern int router_subscribe(router_t * rp, const char * path);
+
+/**
+ * Release the workers and the state shared by them, including the entries
+ * from the subscription file.
+ * @param rp points to the router.
+ */
+extern void router_fini(router_t * rp);
+
+/**
+ * Initialize a worker, including its socket, its multiplexor, and its
+ * shard of the client table.
+ * @param rp points to the router.
+ * @param index is the index of the worker.
+ * @param port is the rendezvous port.
+ * @return a pointer to the worker or NULL if an error occurred.
+ */
+extern worker_t * worker_init(router_t * rp, int index, diminuto_port_t port);
+
+/**
+ * Run a worker until it or another worker is told to stop. This can be
+ * called directly or as the body of a thread.
+ * @param arg points to the worker.
+ * @return NULL.
+ */
+extern void * worker_run(void * arg);
+
+/**
+ * Log the counters of a worker.
+ * @param wp points to the worker.
+ */
+extern void worker_report(const worker_t * wp);
+
+/**
+ * Release the resources held by a worker.
+ * @param wp points to the worker.
+ */
+extern void worker_fini(worker_t * wp);
+
+#endif
@@ -0,0 +1,1154 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Filters and aggregates the records in columnar archives.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * Reads archives written by csv2arc, from the files named on the command
+ * line or from standard input, and writes the records that pass every
+ * filter as the CSV trace, or, if any keys or aggregates are given, one
+ * line of aggregates for each distinct combination of keys.
+ *
+ * A FILTER is a column heading, an operator (<, <=, =, >=, or >), and a
+ * number, like "HAC>1" or "FIX>=3"; or NAM=NAME for the records of one
+ * host. A KEY is a column heading, whose values are grouped by their
+ * integer part, or DAY, the UTC day of the GNSS time. An AGGREGATE is
+ * COUNT, or one of SUM, MIN, MAX, or AVG, a colon, and a column heading,
+ * like "AVG:SAT".
+ *
+ * Each chunk whose zone maps show it has no record that can pass the
+ * numeric filters is skipped without decoding anything. In the chunks
+ * that remain, only the columns that are needed are decoded, each into
+ * an array, and each filter, and, if there are no keys, each aggregate,
+ * is a loop over the arrays. With -i, it lists the zone maps of every
+ * chunk instead.
+ *
+ * USAGE
+ *
+ * arcquery [ -? ] [ -d ] [ -v ] [ -i ] [ -w FILTER ... ] [ -g KEY ... ] [ -a AGGREGATE ... ] [ FILE ... ]
+ *
+ * EXAMPLES
+ *
+ * arcquery -w 'HAC>1' < fleet.arc
+ *
+ * arcquery -g SYS -g DAY -a AVG:SAT fleet.arc
+ *
+ * arcquery -w FIX=3 -w NAM=neon -a COUNT -a MAX:SOG 2023.arc 2024.arc
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "com/diag/hazer/archive.h"
+#include "com/diag/hazer/trace.h"
+
+enum Limits {
+    FILTERS     = 16,                   /* Most filters. */
+    KEYS        = 4,                    /* Most keys. */
+    AGGREGATES  = 8,                    /* Most aggregates. */
+};
+
+/**
+ * This is the pseudo column that is the UTC day of the GNSS time.
+ */
+enum Pseudo {
+    DAY         = ARCHIVE_COLUMNS,
+};
+
+typedef enum Operator {
+    LT,
+    LE,
+    EQ,
+    GE,
+    GT,
+} operator_t;
+
+typedef enum Function {
+    COUNT,
+    SUM,
+    MIN,
+    MAX,
+    AVG,
+} function_t;
+
+static const char * const OPERATORS[] = { "<", "<=", "=", ">=", ">", };
+
+static const char * const FUNCTIONS[] = { "COUNT", "SUM", "MIN", "MAX", "AVG", };
+
+typedef struct Filter {
+    int column;                         /* Column. */
+    operator_t op;                      /* Operator. */
+    double value;                       /* Number compared to. */
+    const char * name;                  /* Name compared to if NAM. */
+} filter_t;
+
+typedef struct Aggregate {
+    function_t function;                /* Function. */
+    int column;                         /* Column, or NAM if COUNT. */
+} aggregate_t;
+
+typedef struct Group {
+    int64_t key[KEYS];                  /* Numeric keys. */
+    char name[TRACE_NAME];              /* Name key. */
+    uint64_t count;                     /* Records. */
+    double sum[AGGREGATES];             /* Sum of each aggregate column. */
+    double minimum[AGGREGATES];         /* Least of each aggregate column. */
+    double maximum[AGGREGATES];         /* Greatest of each aggregate column. */
+} group_t;
+
+/**
+ * This is the query and the state of its evaluation.
+ */
+typedef struct Query {
+    filter_t filter[FILTERS];           /* Filters. */
+    int filters;                        /* Number of filters. */
+    int key[KEYS];                      /* Key columns. */
+    int keys;                           /* Number of keys. */
+    aggregate_t aggregate[AGGREGATES];  /* Aggregates. */
+    int aggregates;                     /* Number of aggregates. */
+    int needed[ARCHIVE_COLUMNS];        /* Columns needed by the query. */
+    uint32_t capacity;                  /* Rows in each array. */
+    double * number[ARCHIVE_COLUMNS];   /* Decoded numeric columns. */
+    int decoded[ARCHIVE_COLUMNS];       /* Column is decoded in chunk. */
+    const char ** names;                /* Decoded names. */
+    int64_t * values;                   /* Scratch values. */
+    int8_t * digits;                    /* Scratch digits. */
+    uint8_t * mask;                     /* Records that pass. */
+    trace_record_t * records;           /* Decoded records. */
+    group_t * group;                    /* Groups. */
+    size_t groups;                      /* Number of groups. */
+    size_t allocated;                   /* Groups allocated. */
+    uint32_t * table;                   /* Hash table of group + 1. */
+    size_t buckets;                     /* Size of table, a power of 2. */
+    size_t last;                        /* Group of the last record. */
+    uint64_t chunks;                    /* Chunks read. */
+    uint64_t skipped;                   /* Chunks skipped by zone maps. */
+    uint64_t total;                     /* Records in chunks read. */
+    uint64_t selected;                  /* Records that passed. */
+} query_t;
+
+static const char * Program = (const char *)0;
+static int Debug = 0;
+static int Verbose = 0;
+
+/*******************************************************************************
+ * PARSING
+ ******************************************************************************/
+
+/**
+ * Return the column with a heading, or DAY.
+ * @param heading points to the heading, which need not be NUL terminated.
+ * @param length is the length of the heading.
+ * @param day is true if DAY is allowed.
+ * @return the column or <0 if there is no such column.
+ */
+static int column(const char * heading, size_t length, int day)
+{
+    int ii = 0;
+
+    for (ii = 0; ii < TRACE_COLUMNS; ++ii) {
+        if ((strlen(trace_heading(ii)) == length) && (strncasecmp(heading, trace_heading(ii), length) == 0)) {
+            return ii;
+        }
+    }
+
+    if (day && (length == 3) && (strncasecmp(heading, "DAY", length) == 0)) {
+        return DAY;
+    }
+
+    return -1;
+}
+
+/**
+ * Parse a filter like HAC>1.
+ * @param fp points to the filter.
+ * @param text points to the text.
+ * @return 0 for success or <0 if it is not a filter.
+ */
+static int filter(filter_t * fp, const char * text)
+{
+    size_t length = 0;
+    char * end = (char *)0;
+    int ii = 0;
+
+    length = strcspn(text, "<=>");
+    if ((fp->column = column(text, length, 0)) < 0) {
+        return -1;
+    }
+    text += length;
+
+    /*
+     * The two character operators are tried first so that "<=" isn't
+     * mistaken for "<".
+     */
+
+    for (ii = LT; ii <= GT; ++ii) {
+        if ((strlen(OPERATORS[ii]) == 2) && (strncmp(text, OPERATORS[ii], 2) == 0)) {
+            break;
+        }
+    }
+    if (ii > GT) {
+        for (ii = LT; ii <= GT; ++ii) {
+            if ((strlen(OPERATORS[ii]) == 1) && (*text == *OPERATORS[ii])) {
+                break;
+            }
+        }
+    }
+    if (ii > GT) {
+        return -1;
+    }
+    fp->op = (operator_t)ii;
+    text += strlen(OPERATORS[fp->op]);
+
+    if (fp->column == TRACE_NAM) {
+        fp->name = text;
+        return (fp->op == EQ) ? 0 : -1;
+    }
+
+    fp->value = strtod(text, &end);
+    if ((end == text) || (*end != '\0')) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Parse an aggregate like AVG:SAT.
+ * @param ap points to the aggregate.
+ * @param text points to the text.
+ * @return 0 for success or <0 if it is not an aggregate.
+ */
+static int aggregate(aggregate_t * ap, const char * text)
+{
+    size_t length = 0;
+    int ii = 0;
+
+    length = strcspn(text, ":");
+
+    for (ii = COUNT; ii <= AVG; ++ii) {
+        if ((strlen(FUNCTIONS[ii]) == length) && (strncasecmp(text, FUNCTIONS[ii], length) == 0)) {
+            break;
+        }
+    }
+    if (ii > AVG) {
+        return -1;
+    }
+    ap->function = (function_t)ii;
+    text += length;
+
+    if (ap->function == COUNT) {
+        ap->column = TRACE_NAM;
+        return (*text == '\0') ? 0 : -1;
+    }
+
+    if (*(text++) != ':') {
+        return -1;
+    }
+
+    if (((ap->column = column(text, strlen(text), 0)) < 0) || (ap->column == TRACE_NAM)) {
+        return -1;
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+ * DECODING
+ ******************************************************************************/
+
+/**
+ * Return a numeric column of a chunk, decoding it if it hasn't been.
+ * @param qp points to the query.
+ * @param cp points to the chunk.
+ * @param col is the column.
+ * @return an array of the values in the column or NULL if an error
+ * occurred.
+ */
+static const double * numbers(query_t * qp, const archive_chunk_t * cp, int col)
+{
+    double * number = qp->number[col];
+    const int64_t * values = qp->values;
+    const int8_t * digits = qp->digits;
+    double divisor = 1.0;
+    uint32_t ii = 0;
+    int jj = 0;
+
+    if (qp->decoded[col]) {
+        return number;
+    }
+
+    if (archive_column(cp, col, qp->values, qp->digits) < 0) {
+        perror(Program);
+        return (const double *)0;
+    }
+
+    /*
+     * Ten to the digits is exact, so dividing by it gives the same double
+     * as trace_number(), in a loop the compiler can vectorize.
+     */
+
+    if (cp->zone[col].digits == ARCHIVE_MIXED) {
+        for (ii = 0; ii < cp->rows; ++ii) {
+            number[ii] = trace_number(values[ii], digits[ii]);
+        }
+    } else if (cp->zone[col].digits > 0) {
+        for (jj = 0; jj < cp->zone[col].digits; ++jj) {
+            divisor *= 10.0;
+        }
+        for (ii = 0; ii < cp->rows; ++ii) {
+            number[ii] = values[ii] / divisor;
+        }
+    } else {
+        for (ii = 0; ii < cp->rows; ++ii) {
+            number[ii] = values[ii];
+        }
+    }
+
+    qp->decoded[col] = !0;
+
+    return number;
+}
+
+/**
+ * Return whether the zone map of a chunk excludes every record from
+ * passing a filter.
+ * @param cp points to the chunk.
+ * @param fp points to the filter.
+ * @return true if no record in the chunk can pass.
+ */
+static int excludes(const archive_chunk_t * cp, const filter_t * fp)
+{
+    int result = 0;
+    const archive_zone_t * zp = &(cp->zone[fp->column]);
+
+    if (fp->column == TRACE_NAM) {
+        /* Do nothing. */
+    } else if (fp->op == LT) {
+        result = !(zp->minimum < fp->value);
+    } else if (fp->op == LE) {
+        result = !archive_overlaps(cp, fp->column, -HUGE_VAL, fp->value);
+    } else if (fp->op == EQ) {
+        result = !archive_overlaps(cp, fp->column, fp->value, fp->value);
+    } else if (fp->op == GE) {
+        result = !archive_overlaps(cp, fp->column, fp->value, HUGE_VAL);
+    } else if (fp->op == GT) {
+        result = !(zp->maximum > fp->value);
+    } else {
+        /* Do nothing. */
+    }
+
+    return result;
+}
+
+/**
+ * Clear the mask of every record in a chunk that doesn't pass a filter.
+ * @param qp points to the query.
+ * @param cp points to the chunk.
+ * @param fp points to the filter.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int apply(query_t * qp, const archive_chunk_t * cp, const filter_t * fp)
+{
+    uint8_t * mask = qp->mask;
+    const double * number = (const double *)0;
+    double value = fp->value;
+    uint32_t rows = cp->rows;
+    uint32_t ii = 0;
+
+    if (fp->column == TRACE_NAM) {
+        for (ii = 0; ii < rows; ++ii) {
+            mask[ii] &= (strcmp(qp->names[ii], fp->name) == 0);
+        }
+        return 0;
+    }
+
+    if ((number = numbers(qp, cp, fp->column)) == (const double *)0) {
+        return -1;
+    }
+
+    switch (fp->op) {
+    case LT:
+        for (ii = 0; ii < rows; ++ii) { mask[ii] &= (number[ii] < value); }
+        break;
+    case LE:
+        for (ii = 0; ii < rows; ++ii) { mask[ii] &= (number[ii] <= value); }
+        break;
+    case EQ:
+        for (ii = 0; ii < rows; ++ii) { mask[ii] &= (number[ii] == value); }
+        break;
+    case GE:
+        for (ii = 0; ii < rows; ++ii) { mask[ii] &= (number[ii] >= value); }
+        break;
+    case GT:
+        for (ii = 0; ii < rows; ++ii) { mask[ii] &= (number[ii] > value); }
+        break;
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+ * AGGREGATING
+ ******************************************************************************/
+
+/**
+ * Return a new group with keys.
+ * @param qp points to the query.
+ * @param key points to the numeric keys.
+ * @param name points to the name key.
+ * @return the index of the group or <0 if an error occurred.
+ */
+static ssize_t create(query_t * qp, const int64_t * key, const char * name)
+{
+    group_t * more = (group_t *)0;
+    group_t * gp = (group_t *)0;
+    int ii = 0;
+
+    if (qp->groups >= qp->allocated) {
+        qp->allocated = (qp->allocated == 0) ? 64 : (qp->allocated * 2);
+        if ((more = (group_t *)realloc(qp->group, qp->allocated * sizeof(group_t))) == (group_t *)0) {
+            perror(Program);
+            return -1;
+        }
+        qp->group = more;
+    }
+
+    gp = &(qp->group[qp->groups]);
+    memset(gp, 0, sizeof(*gp));
+    memcpy(gp->key, key, sizeof(gp->key));
+    strncpy(gp->name, name, sizeof(gp->name) - 1);
+    for (ii = 0; ii < AGGREGATES; ++ii) {
+        gp->minimum[ii] = HUGE_VAL;
+        gp->maximum[ii] = -HUGE_VAL;
+    }
+
+    return qp->groups++;
+}
+
+static size_t hash(const int64_t * key, const char * name)
+{
+    uint64_t value = 14695981039346656037ULL;
+    const uint8_t * here = (const uint8_t *)key;
+    size_t ii = 0;
+
+    for (ii = 0; ii < (KEYS * sizeof(key[0])); ++ii) {
+        value = (value ^ here[ii]) * 1099511628211ULL;
+    }
+    for (here = (const uint8_t *)name; *here != '\0'; ++here) {
+        value = (value ^ *here) * 1099511628211ULL;
+    }
+
+    return value;
+}
+
+static int same(const group_t * gp, const int64_t * key, const char * name)
+{
+    return (memcmp(gp->key, key, sizeof(gp->key)) == 0) && (strncmp(gp->name, name, sizeof(gp->name) - 1) == 0);
+}
+
+/**
+ * Find the group with keys, creating it if there is none.
+ * @param qp points to the query.
+ * @param key points to the numeric keys.
+ * @param name points to the name key.
+ * @return the index of the group or <0 if an error occurred.
+ */
+static ssize_t find(query_t * qp, const int64_t * key, const char * name)
+{
+    ssize_t index = -1;
+    uint32_t * table = (uint32_t *)0;
+    size_t buckets = 0;
+    size_t bucket = 0;
+    size_t ii = 0;
+
+    /*
+     * Records in a row usually belong to the same group.
+     */
+
+    if ((qp->last < qp->groups) && same(&(qp->group[qp->last]), key, name)) {
+        return qp->last;
+    }
+
+    if ((qp->groups * 2) >= qp->buckets) {
+        buckets = (qp->buckets == 0) ? 256 : (qp->buckets * 2);
+        if ((table = (uint32_t *)calloc(buckets, sizeof(table[0]))) == (uint32_t *)0) {
+            perror(Program);
+            return -1;
+        }
+        for (ii = 0; ii < qp->groups; ++ii) {
+            for (bucket = hash(qp->group[ii].key, qp->group[ii].name) & (buckets - 1); table[bucket] != 0; bucket = (bucket + 1) & (buckets - 1)) {
+                continue;
+            }
+            table[bucket] = ii + 1;
+        }
+        free(qp->table);
+        qp->table = table;
+        qp->buckets = buckets;
+    }
+
+    for (bucket = hash(key, name) & (qp->buckets - 1); qp->table[bucket] != 0; bucket = (bucket + 1) & (qp->buckets - 1)) {
+        if (same(&(qp->group[qp->table[bucket] - 1]), key, name)) {
+            index = qp->table[bucket] - 1;
+            break;
+        }
+    }
+
+    if (index >= 0) {
+        /* Do nothing. */
+    } else if ((index = create(qp, key, name)) < 0) {
+        /* Do nothing. */
+    } else {
+        qp->table[bucket] = index + 1;
+    }
+
+    if (index >= 0) {
+        qp->last = index;
+    }
+
+    return index;
+}
+
+/**
+ * Accumulate the records of a chunk that passed into the aggregates.
+ * @param qp points to the query.
+ * @param cp points to the chunk.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int accumulate(query_t * qp, const archive_chunk_t * cp)
+{
+    const uint8_t * mask = qp->mask;
+    const double * key[KEYS];
+    const double * number[AGGREGATES];
+    int64_t keys[KEYS];
+    const char * name = "";
+    group_t * gp = (group_t *)0;
+    ssize_t index = 0;
+    uint32_t rows = cp->rows;
+    uint32_t ii = 0;
+    int jj = 0;
+    uint64_t count = 0;
+    double sum = 0.0;
+    double minimum = 0.0;
+    double maximum = 0.0;
+
+    for (jj = 0; jj < qp->aggregates; ++jj) {
+        if (qp->aggregate[jj].function == COUNT) {
+            number[jj] = (const double *)0;
+        } else if ((number[jj] = numbers(qp, cp, qp->aggregate[jj].column)) == (const double *)0) {
+            return -1;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    /*
+     * Without keys, every aggregate is a loop over its column.
+     */
+
+    if (qp->keys == 0) {
+        gp = &(qp->group[0]);
+        for (ii = 0; ii < rows; ++ii) {
+            count += mask[ii];
+        }
+        gp->count += count;
+        for (jj = 0; jj < qp->aggregates; ++jj) {
+            if (number[jj] == (const double *)0) {
+                continue;
+            }
+            sum = 0.0;
+            minimum = gp->minimum[jj];
+            maximum = gp->maximum[jj];
+            for (ii = 0; ii < rows; ++ii) {
+                sum += mask[ii] ? number[jj][ii] : 0.0;
+            }
+            for (ii = 0; ii < rows; ++ii) {
+                minimum = (mask[ii] && (number[jj][ii] < minimum)) ? number[jj][ii] : minimum;
+                maximum = (mask[ii] && (number[jj][ii] > maximum)) ? number[jj][ii] : maximum;
+            }
+            gp->sum[jj] += sum;
+            gp->minimum[jj] = minimum;
+            gp->maximum[jj] = maximum;
+        }
+        return 0;
+    }
+
+    memset(keys, 0, sizeof(keys));
+
+    for (jj = 0; jj < qp->keys; ++jj) {
+        if (qp->key[jj] == TRACE_NAM) {
+            key[jj] = (const double *)0;
+        } else if ((key[jj] = numbers(qp, cp, (qp->key[jj] == DAY) ? TRACE_TIM : qp->key[jj])) == (const double *)0) {
+            return -1;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    for (ii = 0; ii < rows; ++ii) {
+        if (!mask[ii]) {
+            continue;
+        }
+        for (jj = 0; jj < qp->keys; ++jj) {
+            if (qp->key[jj] == TRACE_NAM) {
+                name = qp->names[ii];
+            } else if (qp->key[jj] == DAY) {
+                keys[jj] = (int64_t)floor(key[jj][ii] / 86400.0);
+            } else {
+                keys[jj] = (int64_t)floor(key[jj][ii]);
+            }
+        }
+        if ((index = find(qp, keys, name)) < 0) {
+            return -1;
+        }
+        gp = &(qp->group[index]);
+        gp->count += 1;
+        for (jj = 0; jj < qp->aggregates; ++jj) {
+            if (number[jj] == (const double *)0) {
+                continue;
+            }
+            gp->sum[jj] += number[jj][ii];
+            if (number[jj][ii] < gp->minimum[jj]) {
+                gp->minimum[jj] = number[jj][ii];
+            }
+            if (number[jj][ii] > gp->maximum[jj]) {
+                gp->maximum[jj] = number[jj][ii];
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * This is the query the groups are sorted for.
+ */
+static const query_t * Sorting = (const query_t *)0;
+
+static int compare(const void * ap, const void * bp)
+{
+    const group_t * aa = (const group_t *)ap;
+    const group_t * bb = (const group_t *)bp;
+    int rc = 0;
+    int ii = 0;
+
+    for (ii = 0; (rc == 0) && (ii < Sorting->keys); ++ii) {
+        if (Sorting->key[ii] == TRACE_NAM) {
+            rc = strncmp(aa->name, bb->name, sizeof(aa->name));
+        } else if (aa->key[ii] < bb->key[ii]) {
+            rc = -1;
+        } else if (aa->key[ii] > bb->key[ii]) {
+            rc = 1;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * Print the aggregates of each group, sorted by their keys.
+ * @param qp points to the query.
+ */
+static void report(query_t * qp)
+{
+    const group_t * gp = (const group_t *)0;
+    size_t ii = 0;
+    int jj = 0;
+    time_t seconds = 0;
+    struct tm datetime;
+
+    for (jj = 0; jj < qp->keys; ++jj) {
+        printf("%s, ", (qp->key[jj] == DAY) ? "DAY" : trace_heading(qp->key[jj]));
+    }
+    for (jj = 0; jj < qp->aggregates; ++jj) {
+        if (qp->aggregate[jj].function == COUNT) {
+            printf("%s%s", (jj > 0) ? ", " : "", FUNCTIONS[COUNT]);
+        } else {
+            printf("%s%s(%s)", (jj > 0) ? ", " : "", FUNCTIONS[qp->aggregate[jj].function], trace_heading(qp->aggregate[jj].column));
+        }
+    }
+    fputc('\n', stdout);
+
+    Sorting = qp;
+    qsort(qp->group, qp->groups, sizeof(qp->group[0]), compare);
+
+    for (ii = 0; ii < qp->groups; ++ii) {
+        gp = &(qp->group[ii]);
+        for (jj = 0; jj < qp->keys; ++jj) {
+            if (qp->key[jj] == TRACE_NAM) {
+                printf("\"%s\", ", gp->name);
+            } else if (qp->key[jj] == DAY) {
+                seconds = gp->key[jj] * 86400;
+                gmtime_r(&seconds, &datetime);
+                printf("%04d-%02d-%02d, ", datetime.tm_year + 1900, datetime.tm_mon + 1, datetime.tm_mday);
+            } else {
+                printf("%lld, ", (long long)gp->key[jj]);
+            }
+        }
+        for (jj = 0; jj < qp->aggregates; ++jj) {
+            if (jj > 0) {
+                fputs(", ", stdout);
+            }
+            if (qp->aggregate[jj].function == COUNT) {
+                printf("%llu", (unsigned long long)gp->count);
+            } else if (gp->count == 0) {
+                printf("%.9lf", 0.0);
+            } else if (qp->aggregate[jj].function == SUM) {
+                printf("%.9lf", gp->sum[jj]);
+            } else if (qp->aggregate[jj].function == MIN) {
+                printf("%.9lf", gp->minimum[jj]);
+            } else if (qp->aggregate[jj].function == MAX) {
+                printf("%.9lf", gp->maximum[jj]);
+            } else {
+                printf("%.9lf", gp->sum[jj] / gp->count);
+            }
+        }
+        fputc('\n', stdout);
+    }
+}
+
+/*******************************************************************************
+ * QUERYING
+ ******************************************************************************/
+
+/**
+ * Make sure the arrays can hold the records of a chunk.
+ * @param qp points to the query.
+ * @param rows is the number of records in the chunk.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int reserve(query_t * qp, uint32_t rows)
+{
+    int ii = 0;
+
+    if (rows <= qp->capacity) {
+        return 0;
+    }
+
+    for (ii = 0; ii < ARCHIVE_COLUMNS; ++ii) {
+        free(qp->number[ii]);
+        qp->number[ii] = (double *)0;
+    }
+    free(qp->names);
+    free(qp->values);
+    free(qp->digits);
+    free(qp->mask);
+    free(qp->records);
+    qp->capacity = 0;
+
+    for (ii = 0; ii < ARCHIVE_COLUMNS; ++ii) {
+        if ((ii != TRACE_NAM) && qp->needed[ii] && ((qp->number[ii] = (double *)malloc(rows * sizeof(double))) == (double *)0)) {
+            break;
+        }
+    }
+
+    if (ii < ARCHIVE_COLUMNS) {
+        /* Do nothing. */
+    } else if ((qp->names = (const char **)malloc(rows * sizeof(qp->names[0]))) == (const char **)0) {
+        /* Do nothing. */
+    } else if ((qp->values = (int64_t *)malloc(rows * sizeof(qp->values[0]))) == (int64_t *)0) {
+        /* Do nothing. */
+    } else if ((qp->digits = (int8_t *)malloc(rows * sizeof(qp->digits[0]))) == (int8_t *)0) {
+        /* Do nothing. */
+    } else if ((qp->mask = (uint8_t *)malloc(rows * sizeof(qp->mask[0]))) == (uint8_t *)0) {
+        /* Do nothing. */
+    } else if ((qp->records = (trace_record_t *)malloc(rows * sizeof(qp->records[0]))) == (trace_record_t *)0) {
+        /* Do nothing. */
+    } else {
+        qp->capacity = rows;
+    }
+
+    if (qp->capacity == 0) {
+        perror(Program);
+        return -1;
+    }
+
+    return 0;
+}
+
+/**
+ * Evaluate the query over a chunk.
+ * @param qp points to the query.
+ * @param cp points to the chunk.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int evaluate(query_t * qp, const archive_chunk_t * cp)
+{
+    int ii = 0;
+    uint32_t jj = 0;
+    uint64_t count = 0;
+    char buffer[TRACE_LINE];
+
+    qp->chunks += 1;
+    qp->total += cp->rows;
+
+    for (ii = 0; ii < qp->filters; ++ii) {
+        if (excludes(cp, &(qp->filter[ii]))) {
+            qp->skipped += 1;
+            return 0;
+        }
+    }
+
+    if (reserve(qp, cp->rows) < 0) {
+        return -1;
+    }
+
+    memset(qp->decoded, 0, sizeof(qp->decoded));
+    memset(qp->mask, 1, cp->rows);
+
+    if (!qp->needed[TRACE_NAM]) {
+        /* Do nothing. */
+    } else if (archive_names(cp, qp->names) < 0) {
+        perror(Program);
+        return -1;
+    } else {
+        /* Do nothing. */
+    }
+
+    for (ii = 0; ii < qp->filters; ++ii) {
+        if (apply(qp, cp, &(qp->filter[ii])) < 0) {
+            return -1;
+        }
+    }
+
+    for (jj = 0; jj < cp->rows; ++jj) {
+        count += qp->mask[jj];
+    }
+    qp->selected += count;
+
+    if (count == 0) {
+        /* Do nothing. */
+    } else if ((qp->keys > 0) || (qp->aggregates > 0)) {
+        if (accumulate(qp, cp) < 0) {
+            return -1;
+        }
+    } else if (archive_records(cp, qp->records) < 0) {
+        perror(Program);
+        return -1;
+    } else {
+        for (jj = 0; jj < cp->rows; ++jj) {
+            if (!qp->mask[jj]) {
+                continue;
+            }
+            if (trace_format(&(qp->records[jj]), buffer, sizeof(buffer)) < 0) {
+                perror(Program);
+                return -1;
+            }
+            if (fputs(buffer, stdout) == EOF) {
+                perror(Program);
+                return -1;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * List the zone maps of a chunk.
+ * @param cp points to the chunk.
+ * @param offset is the offset of the chunk.
+ */
+static void list(const archive_chunk_t * cp, uint64_t offset)
+{
+    static const char * const ENCODINGS[] = { "VARINT", "DELTA", "RUNS", };
+    int ii = 0;
+
+    printf("CHUNK %llu ROWS %lu BYTES %lu\n", (unsigned long long)offset, (unsigned long)cp->rows, (unsigned long)cp->length);
+
+    for (ii = TRACE_NAM; ii < ARCHIVE_COLUMNS; ++ii) {
+        printf("    %s %s ", (ii == ARCHIVE_FLG) ? "FLG" : trace_heading(ii), (cp->zone[ii].encoding < (sizeof(ENCODINGS) / sizeof(ENCODINGS[0]))) ? ENCODINGS[cp->zone[ii].encoding] : "?");
+        if (cp->zone[ii].digits == ARCHIVE_MIXED) {
+            fputs("MIXED", stdout);
+        } else {
+            printf("%d", cp->zone[ii].digits);
+        }
+        printf(" %lu %.9lf %.9lf\n", (unsigned long)cp->zone[ii].length, cp->zone[ii].minimum, cp->zone[ii].maximum);
+    }
+}
+
+/**
+ * Evaluate the query over an archive.
+ * @param qp points to the query.
+ * @param path is the name of the archive.
+ * @param fd is the file descriptor of the archive.
+ * @param index is true to list the zone maps instead.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int query(query_t * qp, const char * path, int fd, int index)
+{
+    int rc = -1;
+    struct stat status;
+    void * base = MAP_FAILED;
+    char * data = (char *)0;
+    char * more = (char *)0;
+    size_t length = 0;
+    size_t size = 0;
+    ssize_t count = 0;
+    uint64_t offset = 0;
+    uint64_t before = 0;
+    const archive_chunk_t * cp = (const archive_chunk_t *)0;
+
+    if (fstat(fd, &status) < 0) {
+        perror(path);
+        return -1;
+    }
+
+    /*
+     * An archive that isn't a file, like a pipe, is read into memory,
+     * which is practical because archives are compact.
+     */
+
+    if (!S_ISREG(status.st_mode)) {
+        /* Do nothing. */
+    } else if (status.st_size == 0) {
+        /* Do nothing. */
+    } else if ((base = mmap((void *)0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        if (Verbose) {
+            perror(path);
+        }
+    } else {
+        data = (char *)base;
+        length = status.st_size;
+    }
+
+    if (base == MAP_FAILED) {
+        do {
+            if ((length + 65536) > size) {
+                size = (size == 0) ? (1 << 20) : (size * 2);
+                if ((more = (char *)realloc(data, size)) == (char *)0) {
+                    perror(Program);
+                    free(data);
+                    return -1;
+                }
+                data = more;
+            }
+            if ((count = read(fd, data + length, size - length)) > 0) {
+                length += count;
+            }
+        } while ((count > 0) || ((count < 0) && (errno == EINTR)));
+        if (count < 0) {
+            perror(path);
+            free(data);
+            return -1;
+        }
+    }
+
+    do {
+
+        if (archive_check(data, length) == (const archive_header_t *)0) {
+            perror(path);
+            break;
+        }
+
+        for (before = offset; (cp = archive_next(data, length, &offset)) != (const archive_chunk_t *)0; before = offset) {
+            if (Debug) {
+                fprintf(stderr, "%s: %s chunk %llu rows %lu bytes %lu\n", Program, path, (unsigned long long)before, (unsigned long)cp->rows, (unsigned long)cp->length);
+            }
+            if (index) {
+                list(cp, (const char *)cp - data);
+            } else if (evaluate(qp, cp) < 0) {
+                break;
+            } else {
+                /* Do nothing. */
+            }
+        }
+
+        if (cp != (const archive_chunk_t *)0) {
+            break;
+        }
+
+        if (offset < length) {
+            errno = EILSEQ;
+            if (Verbose) {
+                perror(path);
+            }
+        }
+
+        rc = 0;
+
+    } while (0);
+
+    if (base != MAP_FAILED) {
+        (void)munmap(base, length);
+    } else {
+        free(data);
+    }
+
+    return rc;
+}
+
+int main(int argc, char *argv[])
+{
+    int xc = 0;
+    int opt = -1;
+    int index = 0;
+    int fd = -1;
+    int ii = 0;
+    query_t * qp = (query_t *)0;
+    struct timespec before = { 0, 0 };
+    struct timespec after = { 0, 0 };
+    double elapsed = 0.0;
+    int64_t zero[KEYS] = { 0, };
+
+    extern char * optarg;
+    extern int optind;
+    extern int opterr;
+    extern int optopt;
+
+    Program = ((Program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : Program + 1;
+
+    if ((qp = (query_t *)calloc(1, sizeof(*qp))) == (query_t *)0) {
+        perror(Program);
+        return 1;
+    }
+
+    while ((opt = getopt(argc, argv, "?a:dg:ivw:")) >= 0) {
+        switch (opt) {
+        case '?':
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -i ] [ -w FILTER ... ] [ -g KEY ... ] [ -a AGGREGATE ... ] [ FILE ... ]\n", Program);
+            fprintf(stderr, "       -?          Print this menu.\n");
+            fprintf(stderr, "       -a AGGREGATE Report COUNT, or SUM, MIN, MAX, or AVG:COLUMN, like AVG:SAT.\n");
+            fprintf(stderr, "       -d          Display debug output.\n");
+            fprintf(stderr, "       -g KEY      Group by COLUMN or by DAY of TIM, like SYS.\n");
+            fprintf(stderr, "       -i          List the zone maps of each chunk instead.\n");
+            fprintf(stderr, "       -v          Display verbose output including chunks skipped.\n");
+            fprintf(stderr, "       -w FILTER   Only COLUMN <, <=, =, >=, or > NUMBER, or NAM=NAME, like HAC>1.\n");
+            return 0;
+            break;
+        case 'a':
+            if ((qp->aggregates >= AGGREGATES) || (aggregate(&(qp->aggregate[qp->aggregates]), optarg) < 0)) {
+                errno = EINVAL;
+                perror(optarg);
+                return 1;
+            }
+            if (qp->aggregate[qp->aggregates].function != COUNT) {
+                qp->needed[qp->aggregate[qp->aggregates].column] = !0;
+            }
+            qp->aggregates += 1;
+            break;
+        case 'd':
+            Debug = !0;
+            break;
+        case 'g':
+            if ((qp->keys >= KEYS) || ((qp->key[qp->keys] = column(optarg, strlen(optarg), !0)) < 0)) {
+                errno = EINVAL;
+                perror(optarg);
+                return 1;
+            }
+            qp->needed[(qp->key[qp->keys] == DAY) ? TRACE_TIM : qp->key[qp->keys]] = !0;
+            qp->keys += 1;
+            break;
+        case 'i':
+            index = !0;
+            break;
+        case 'v':
+            Verbose = !0;
+            break;
+        case 'w':
+            if ((qp->filters >= FILTERS) || (filter(&(qp->filter[qp->filters]), optarg) < 0)) {
+                errno = EINVAL;
+                perror(optarg);
+                return 1;
+            }
+            qp->needed[qp->filter[qp->filters].column] = !0;
+            qp->filters += 1;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -i ] [ -w FILTER ... ] [ -g KEY ... ] [ -a AGGREGATE ... ] [ FILE ... ]\n", Program);
+            return 1;
+            break;
+        }
+    }
+
+    /*
+     * Keys without aggregates count the records in each group, and
+     * aggregates without keys are of a single group of every record.
+     */
+
+    if ((qp->keys > 0) && (qp->aggregates == 0)) {
+        qp->aggregate[qp->aggregates++].function = COUNT;
+    }
+
+    if ((qp->keys == 0) && (qp->aggregates > 0) && (create(qp, zero, "") < 0)) {
+        return 1;
+    }
+
+    if (!index && (qp->keys == 0) && (qp->aggregates == 0)) {
+        for (ii = 0; ii < TRACE_COLUMNS; ++ii) {
+            if (ii > 0) { fputc(' ', stdout); }
+            fputs(trace_heading(ii), stdout);
+            if (ii < (TRACE_COLUMNS - 1)) { fputc(',', stdout); } else { fputc('\n', stdout); }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &before);
+
+    if (optind >= argc) {
+        if (query(qp, "-", fileno(stdin), index) < 0) {
+            xc = 1;
+        }
+    } else {
+        for (ii = optind; ii < argc; ++ii) {
+            if ((fd = open(argv[ii], O_RDONLY)) < 0) {
+                perror(argv[ii]);
+                xc = 1;
+                break;
+            }
+            if (query(qp, argv[ii], fd, index) < 0) {
+                xc = 1;
+            }
+            (void)close(fd);
+            if (xc != 0) {
+                break;
+            }
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &after);
+    elapsed = (after.tv_sec - before.tv_sec) + ((after.tv_nsec - before.tv_nsec) / 1000000000.0);
+
+    if (!index && ((qp->keys > 0) || (qp->aggregates > 0)) && (xc == 0)) {
+        report(qp);
+    }
+
+    if (fflush(stdout) == EOF) {
+        perror(Program);
+        xc = 1;
+    }
+
+    for (ii = 0; ii < ARCHIVE_COLUMNS; ++ii) {
+        free(qp->number[ii]);
+    }
+    free(qp->names);
+    free(qp->values);
+    free(qp->digits);
+    free(qp->mask);
+    free(qp->records);
+    free(qp->group);
+    free(qp->table);
+
+    if (Verbose) {
+        fprintf(stderr, "%s: chunks %llu skipped %llu records %llu selected %llu groups %zu elapsed %.3lfs\n", Program, (unsigned long long)qp->chunks, (unsigned long long)qp->skipped, (unsigned long long)qp->total, (unsigned long long)qp->selected, qp->groups, elapsed);
+    }
+
+    free(qp);
+
+    return xc;
+}
@@ -0,0 +1,339 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Replays an indexed capture file with its original timing.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * Reads a capture written by gpstool -0 and writes the messages in it, each
+ * exactly as it was received, with the same time between them as when they
+ * were received, or sped up by a factor, or as fast as possible. The
+ * messages are written to standard output, for example into a pipe to
+ * gpstool -S -, or, with -P, to a pseudo-terminal whose name is printed on
+ * standard output, so that gpstool -D can read it as if it were a device.
+ * Each message is released at an absolute deadline computed from when the
+ * first was released, so that the time spent writing messages doesn't
+ * accumulate as drift. With -v, how late the messages were released is
+ * reported at the end. The range is in seconds since the capture began.
+ * If the capture on standard input is a file, it is mapped into memory
+ * instead of being read, and its index is used to seek to the beginning of
+ * the range.
+ *
+ * USAGE
+ *
+ * capreplay [ -? ] [ -d ] [ -v ] [ -P ] [ -x SPEED ] [ -b SECONDS ] [ -e SECONDS ] [ -p PROTOCOL ]
+ *
+ * EXAMPLES
+ *
+ * capreplay < data.cap | gpstool -S - -E
+ *
+ * capreplay -x 100 -v < data.cap | gpstool -S - -T data.csv
+ *
+ * capreplay -P < data.cap > pty.txt & gpstool -D $(head -1 pty.txt) -E
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include "com/diag/hazer/capture.h"
+#include "com/diag/hazer/pacer.h"
+
+/**
+ * These are the protocols that can be named on the command line.
+ */
+static const capture_protocol_t PROTOCOLS[] = {
+    CAPTURE_OTHER, CAPTURE_NMEA, CAPTURE_UBX, CAPTURE_RTCM, CAPTURE_CPO,
+};
+
+/**
+ * Open a pseudo-terminal in raw mode.
+ * @param program is the program name.
+ * @param slavep points to where the file descriptor of the slave side,
+ * which is kept open so that what is written is buffered until a reader
+ * opens it, is returned.
+ * @return the file descriptor of the master side or <0 if an error
+ * occurred.
+ */
+static int pseudoterminal(const char * program, int * slavep)
+{
+    int fd = -1;
+    int slave = -1;
+    const char * name = (const char *)0;
+    struct termios termios;
+
+    if ((fd = posix_openpt(O_RDWR | O_NOCTTY)) < 0) {
+        perror("posix_openpt");
+    } else if (grantpt(fd) < 0) {
+        perror("grantpt");
+    } else if (unlockpt(fd) < 0) {
+        perror("unlockpt");
+    } else if ((name = ptsname(fd)) == (const char *)0) {
+        perror("ptsname");
+    } else if ((slave = open(name, O_RDWR | O_NOCTTY)) < 0) {
+        perror(name);
+    } else if (tcgetattr(slave, &termios) < 0) {
+        perror(name);
+    } else {
+        cfmakeraw(&termios);
+        if (tcsetattr(slave, TCSANOW, &termios) < 0) {
+            perror(name);
+        } else {
+            printf("%s\n", name);
+            fflush(stdout);
+            *slavep = slave;
+            return fd;
+        }
+    }
+
+    if (slave >= 0) {
+        (void)close(slave);
+    }
+
+    if (fd >= 0) {
+        (void)close(fd);
+    }
+
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    const char * program = (const char *)0;
+    int opt = -1;
+    int debug = 0;
+    int verbose = 0;
+    int pty = 0;
+    int error = 0;
+    char * end = (char *)0;
+    double seconds = 0.0;
+    double speed = 1.0;
+    int64_t begin = 0;
+    int64_t finish = INT64_MAX;
+    uint32_t key = 0;
+    uint32_t mask = 0;
+    const char * protocol_option = (const char *)0;
+    void * base = (void *)0;
+    capture_image_t image;
+    size_t length = 0;
+    const capture_header_t * hp = (const capture_header_t *)0;
+    const void * data = (const void *)0;
+    capture_record_t record;
+    pacer_t pacer;
+    size_t ii = 0;
+    uint64_t offset = 0;
+    uint64_t skipped = 0;
+    int64_t lateness = 0;
+    int fd = -1;
+    int slave = -1;
+    int pending = 0;
+    int before = 0;
+    struct timespec tick = { 0, 10000000L };
+    int xc = 0;
+
+    extern char * optarg;
+    extern int optind;
+    extern int opterr;
+    extern int optopt;
+
+    program = ((program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : program + 1;
+
+    while ((opt = getopt(argc, argv, "?Pb:de:p:vx:")) >= 0) {
+        switch (opt) {
+        case '?':
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -P ] [ -x SPEED ] [ -b SECONDS ] [ -e SECONDS ] [ -p PROTOCOL ]\n", program);
+            fprintf(stderr, "       -?          Print this menu.\n");
+            fprintf(stderr, "       -P          Write to a Pseudo-terminal whose name is printed instead of standard output.\n");
+            fprintf(stderr, "       -b SECONDS  Begin with messages received SECONDS after the capture began.\n");
+            fprintf(stderr, "       -d          Display debug output.\n");
+            fprintf(stderr, "       -e SECONDS  End with messages received SECONDS after the capture began.\n");
+            fprintf(stderr, "       -p PROTOCOL Only messages of PROTOCOL (NMEA, UBX, RTCM, CPO, OTHER).\n");
+            fprintf(stderr, "       -v          Display verbose output including lateness.\n");
+            fprintf(stderr, "       -x SPEED    Replay SPEED times faster than real time, 0 as fast as possible.\n");
+            return 0;
+            break;
+        case 'P':
+            pty = !0;
+            break;
+        case 'b':
+            seconds = strtod(optarg, &end);
+            if ((end == (char *)0) || (*end != '\0') || (seconds < 0.0)) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            } else {
+                begin = seconds * 1000000000.0;
+            }
+            break;
+        case 'd':
+            debug = !0;
+            break;
+        case 'e':
+            seconds = strtod(optarg, &end);
+            if ((end == (char *)0) || (*end != '\0') || (seconds < 0.0)) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            } else {
+                finish = seconds * 1000000000.0;
+            }
+            break;
+        case 'p':
+            protocol_option = optarg;
+            break;
+        case 'v':
+            verbose = !0;
+            break;
+        case 'x':
+            speed = strtod(optarg, &end);
+            if ((end == (char *)0) || (*end != '\0') || (pacer_init(&pacer, speed) == (pacer_t *)0)) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            }
+            break;
+        default:
+            error = !0;
+            break;
+        }
+    }
+
+    if (protocol_option != (const char *)0) {
+        for (ii = 0; ii < (sizeof(PROTOCOLS) / sizeof(PROTOCOLS[0])); ++ii) {
+            if (strcasecmp(protocol_option, capture_name(PROTOCOLS[ii])) == 0) {
+                break;
+            }
+        }
+        if (ii < (sizeof(PROTOCOLS) / sizeof(PROTOCOLS[0]))) {
+            key = CAPTURE_KEY(PROTOCOLS[ii], 0);
+            mask = CAPTURE_PROTOCOL;
+        } else {
+            errno = EINVAL;
+            perror(protocol_option);
+            error = !0;
+        }
+    }
+
+    if (error) {
+        fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -P ] [ -x SPEED ] [ -b SECONDS ] [ -e SECONDS ] [ -p PROTOCOL ]\n", program);
+        return 1;
+    }
+
+    (void)pacer_init(&pacer, speed);
+
+    /*
+     * A capture that is a file is mapped into memory; anything else, like
+     * a pipe, is read into memory.
+     */
+
+    if (capture_load(&image, stdin, MADV_SEQUENTIAL) == (capture_image_t *)0) {
+        perror(program);
+        return 1;
+    }
+
+    base = image.base;
+    length = image.length;
+
+    if ((hp = capture_check(base, length)) == (const capture_header_t *)0) {
+        perror(program);
+        xc = 1;
+    } else if (!pty) {
+        fd = fileno(stdout);
+    } else if ((fd = pseudoterminal(program, &slave)) < 0) {
+        xc = 1;
+    } else {
+        /* Do nothing. */
+    }
+
+    if (xc == 0) {
+
+        begin += hp->monotonic;
+        finish = (finish > (INT64_MAX - hp->monotonic)) ? INT64_MAX : (finish + hp->monotonic);
+
+        offset = capture_seek(base, length, begin, key, mask, &skipped);
+
+        if (verbose) {
+            fprintf(stderr, "%s: offset %llu skipped %llu speed %g\n", program, (unsigned long long)offset, (unsigned long long)skipped, speed);
+        }
+
+        while ((data = capture_next(base, length, &offset, &record)) != (const void *)0) {
+            if ((record.key >> 24) == CAPTURE_INDEX) {
+                continue;
+            } else if ((record.key >> 24) == CAPTURE_TRAILER) {
+                continue;
+            } else if (record.stamp < begin) {
+                continue;
+            } else if (record.stamp > finish) {
+                break;
+            } else if ((record.key & mask) != (key & mask)) {
+                continue;
+            } else {
+                /* Do nothing. */
+            }
+
+            lateness = pacer_wait(&pacer, record.stamp);
+
+            if (debug) {
+                fprintf(stderr, "%s: stamp %lld length %u key 0x%08x late %lldns\n", program, (long long)record.stamp, record.length, record.key, (long long)lateness);
+            }
+
+            if (pacer_write(fd, data, record.length) < 0) {
+                perror(program);
+                xc = 1;
+                break;
+            }
+        }
+
+        if (verbose) {
+            fprintf(stderr, "%s: messages %llu sleeps %llu late %llu mean %.6lfms p50 %.6lfms p90 %.6lfms p99 %.6lfms p99.9 %.6lfms max %.6lfms\n", program,
+                (unsigned long long)pacer.items, (unsigned long long)pacer.sleeps, (unsigned long long)pacer.late,
+                (pacer.items > 0) ? (pacer.total / 1000000.0 / pacer.items) : 0.0,
+                pacer_percentile(&pacer, 50.0) / 1000000.0, pacer_percentile(&pacer, 90.0) / 1000000.0,
+                pacer_percentile(&pacer, 99.0) / 1000000.0, pacer_percentile(&pacer, 99.9) / 1000000.0,
+                pacer.latest / 1000000.0);
+        }
+
+    }
+
+    /*
+     * Closing the pseudo-terminal before its reader has read everything
+     * would discard what is left, so we wait for the reader to empty it, or
+     * to stop reading for a second.
+     */
+
+    if (slave >= 0) {
+        for (ii = 0, before = -1; ii < 100; ++ii) {
+            if (ioctl(slave, FIONREAD, &pending) < 0) {
+                break;
+            } else if (pending == 0) {
+                break;
+            } else if (pending != before) {
+                before = pending;
+                ii = 0;
+            } else {
+                /* Do nothing. */
+            }
+            (void)nanosleep(&tick, (struct timespec *)0);
+        }
+        (void)close(slave);
+    }
+
+    if ((fd >= 0) && (fd != fileno(stdout))) {
+        (void)close(fd);
+    }
+
+    capture_unload(&image);
+
+    return xc;
+}
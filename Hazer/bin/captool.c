@@ -0,0 +1,393 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Extracts messages from an indexed capture file.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * Filter that reads a capture written by gpstool -0 and writes the messages
+ * received within a range of time, optionally of only one protocol or of
+ * only one type of message, exactly as they were received. The range is in
+ * seconds since the capture began. With -l it lists the messages instead,
+ * and with -i it lists the index. If the capture on standard input is a
+ * file, it is mapped into memory instead of being read, and, if the capture
+ * was closed cleanly, its index is used to skip every block of messages
+ * outside the range or without a message of the protocol or type, without
+ * reading them. A TYPE is the class and ID of a UBX message, the number of
+ * an RTCM message, the sentence of an NMEA message without its talker, or
+ * the ID of a CPO packet.
+ *
+ * USAGE
+ *
+ * captool [ -? ] [ -d ] [ -v ] [ -l | -i ] [ -b SECONDS ] [ -e SECONDS ] [ -p PROTOCOL [ -t TYPE ] ]
+ *
+ * EXAMPLES
+ *
+ * captool -p UBX -t 0x0107 < data.cap > pvt.ubx
+ *
+ * captool -b 60 -e 120 -p RTCM < data.cap > minute.rtcm
+ *
+ * captool -l -p NMEA -t GGA < data.cap
+ *
+ * captool -i < data.cap
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "com/diag/hazer/capture.h"
+
+/**
+ * These are the protocols that can be named on the command line.
+ */
+static const capture_protocol_t PROTOCOLS[] = {
+    CAPTURE_OTHER, CAPTURE_NMEA, CAPTURE_UBX, CAPTURE_RTCM, CAPTURE_CPO,
+};
+
+/**
+ * Format the type of a key.
+ * @param key is the key.
+ * @param buffer points to the buffer.
+ * @param size is the size of the buffer.
+ * @return the buffer.
+ */
+static const char * type2string(uint32_t key, char * buffer, size_t size)
+{
+    uint32_t type = 0;
+
+    type = key & ~CAPTURE_PROTOCOL;
+
+    if (key == CAPTURE_OVERFLOW) {
+        snprintf(buffer, size, "*");
+    } else {
+        switch (key >> 24) {
+        case CAPTURE_NMEA:
+            snprintf(buffer, size, "%c%c%c", (int)((type >> 16) & 0xff), (int)((type >> 8) & 0xff), (int)(type & 0xff));
+            break;
+        case CAPTURE_UBX:
+            snprintf(buffer, size, "0x%04x", (unsigned int)type);
+            break;
+        case CAPTURE_CPO:
+            snprintf(buffer, size, "0x%02x", (unsigned int)type);
+            break;
+        default:
+            snprintf(buffer, size, "%u", (unsigned int)type);
+            break;
+        }
+    }
+
+    return buffer;
+}
+
+/**
+ * Parse the type of a protocol.
+ * @param protocol is the protocol.
+ * @param string points to the type.
+ * @param typep points to where the type is returned.
+ * @return 0 for success or <0 if the type is invalid.
+ */
+static int string2type(capture_protocol_t protocol, const char * string, uint32_t * typep)
+{
+    int rc = -1;
+    char * end = (char *)0;
+    unsigned long type = 0;
+
+    if ((protocol == CAPTURE_NMEA) && (strlen(string) == 3)) {
+        *typep = ((uint32_t)(uint8_t)string[0] << 16) | ((uint32_t)(uint8_t)string[1] << 8) | (uint8_t)string[2];
+        rc = 0;
+    } else if (((type = strtoul(string, &end, 0)) > 0x00ffffffUL) || (end == (char *)0) || (*end != '\0') || (end == string)) {
+        /* Do nothing. */
+    } else {
+        *typep = type;
+        rc = 0;
+    }
+
+    return rc;
+}
+
+int main(int argc, char *argv[])
+{
+    const char * program = (const char *)0;
+    int opt = -1;
+    int debug = 0;
+    int verbose = 0;
+    int list = 0;
+    int index = 0;
+    int error = 0;
+    char * end = (char *)0;
+    double seconds = 0.0;
+    int64_t begin = 0;
+    int64_t finish = INT64_MAX;
+    uint32_t key = 0;
+    uint32_t mask = 0;
+    const char * protocol_option = (const char *)0;
+    const char * type_option = (const char *)0;
+    capture_protocol_t protocol = CAPTURE_OTHER;
+    uint32_t type = 0;
+    void * base = (void *)0;
+    capture_image_t image;
+    size_t length = 0;
+    const capture_header_t * hp = (const capture_header_t *)0;
+    const capture_count_t * counts = (const capture_count_t *)0;
+    const void * data = (const void *)0;
+    capture_record_t record;
+    capture_index_t block;
+    uint64_t * blocks = (uint64_t *)0;
+    size_t count = 0;
+    size_t ii = 0;
+    uint32_t jj = 0;
+    uint64_t offset = 0;
+    uint64_t limit = 0;
+    uint64_t messages = 0;
+    uint64_t skipped = 0;
+    char buffer[16];
+    int xc = 0;
+
+    extern char * optarg;
+    extern int optind;
+    extern int opterr;
+    extern int optopt;
+
+    program = ((program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : program + 1;
+
+    while ((opt = getopt(argc, argv, "?b:de:ilp:t:v")) >= 0) {
+        switch (opt) {
+        case '?':
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -l | -i ] [ -b SECONDS ] [ -e SECONDS ] [ -p PROTOCOL [ -t TYPE ] ]\n", program);
+            fprintf(stderr, "       -?          Print this menu.\n");
+            fprintf(stderr, "       -b SECONDS  Begin with messages received SECONDS after the capture began.\n");
+            fprintf(stderr, "       -d          Display debug output.\n");
+            fprintf(stderr, "       -e SECONDS  End with messages received SECONDS after the capture began.\n");
+            fprintf(stderr, "       -i          List the index instead of writing messages.\n");
+            fprintf(stderr, "       -l          List messages instead of writing them.\n");
+            fprintf(stderr, "       -p PROTOCOL Only messages of PROTOCOL (NMEA, UBX, RTCM, CPO, OTHER).\n");
+            fprintf(stderr, "       -t TYPE     Only messages of TYPE (e.g. GGA, 0x0107, 1005, 0x72).\n");
+            fprintf(stderr, "       -v          Display verbose output.\n");
+            return 0;
+            break;
+        case 'b':
+            seconds = strtod(optarg, &end);
+            if ((end == (char *)0) || (*end != '\0') || (seconds < 0.0)) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            } else {
+                begin = seconds * 1000000000.0;
+            }
+            break;
+        case 'd':
+            debug = !0;
+            break;
+        case 'e':
+            seconds = strtod(optarg, &end);
+            if ((end == (char *)0) || (*end != '\0') || (seconds < 0.0)) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            } else {
+                finish = seconds * 1000000000.0;
+            }
+            break;
+        case 'i':
+            index = !0;
+            break;
+        case 'l':
+            list = !0;
+            break;
+        case 'p':
+            protocol_option = optarg;
+            break;
+        case 't':
+            type_option = optarg;
+            break;
+        case 'v':
+            verbose = !0;
+            break;
+        default:
+            error = !0;
+            break;
+        }
+    }
+
+    if (protocol_option != (const char *)0) {
+        for (ii = 0; ii < (sizeof(PROTOCOLS) / sizeof(PROTOCOLS[0])); ++ii) {
+            if (strcasecmp(protocol_option, capture_name(PROTOCOLS[ii])) == 0) {
+                break;
+            }
+        }
+        if (ii < (sizeof(PROTOCOLS) / sizeof(PROTOCOLS[0]))) {
+            protocol = PROTOCOLS[ii];
+            key = CAPTURE_KEY(protocol, 0);
+            mask = CAPTURE_PROTOCOL;
+        } else {
+            errno = EINVAL;
+            perror(protocol_option);
+            error = !0;
+        }
+    }
+
+    if (type_option == (const char *)0) {
+        /* Do nothing. */
+    } else if (protocol_option == (const char *)0) {
+        errno = EINVAL;
+        perror(type_option);
+        error = !0;
+    } else if (string2type(protocol, type_option, &type) < 0) {
+        errno = EINVAL;
+        perror(type_option);
+        error = !0;
+    } else {
+        key = CAPTURE_KEY(protocol, type);
+        mask = ~(uint32_t)0;
+    }
+
+    if (list && index) {
+        error = !0;
+    }
+
+    if (error) {
+        fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -l | -i ] [ -b SECONDS ] [ -e SECONDS ] [ -p PROTOCOL [ -t TYPE ] ]\n", program);
+        return 1;
+    }
+
+    /*
+     * A capture that is a file is mapped into memory; anything else, like
+     * a pipe, is read into memory.
+     */
+
+    if (capture_load(&image, stdin, MADV_RANDOM) == (capture_image_t *)0) {
+        perror(program);
+        return 1;
+    }
+
+    base = image.base;
+    length = image.length;
+
+    if ((hp = capture_check(base, length)) == (const capture_header_t *)0) {
+        perror(program);
+        xc = 1;
+        goto done;
+    }
+
+    begin += hp->monotonic;
+    finish = (finish > (INT64_MAX - hp->monotonic)) ? INT64_MAX : (finish + hp->monotonic);
+
+    /*
+     * The blocks are found walking back from the trailer, so they are
+     * collected and then visited in order. Without a trailer, the capture
+     * is one big block that is read from the beginning.
+     */
+
+    for (offset = capture_last(base, length); offset > 0; offset = block.previous) {
+        if (capture_index(base, length, offset, &block) == (const capture_count_t *)0) {
+            break;
+        }
+        count += 1;
+    }
+
+    if (count > 0) {
+        if ((blocks = (uint64_t *)malloc(count * sizeof(blocks[0]))) == (uint64_t *)0) {
+            perror(program);
+            xc = 1;
+            goto done;
+        }
+        for (offset = capture_last(base, length), ii = count; ii > 0; offset = block.previous) {
+            (void)capture_index(base, length, offset, &block);
+            blocks[--ii] = offset;
+        }
+    } else if (verbose) {
+        fprintf(stderr, "%s: no index\n", program);
+    }
+
+    if (index) {
+        printf("realtime %lld.%09lld monotonic %lld.%09lld blocks %zu\n", (long long)(hp->realtime / 1000000000LL), (long long)(hp->realtime % 1000000000LL), (long long)(hp->monotonic / 1000000000LL), (long long)(hp->monotonic % 1000000000LL), count);
+        for (ii = 0; ii < count; ++ii) {
+            counts = capture_index(base, length, blocks[ii], &block);
+            printf("block %zu offset %llu first %.9lf last %.9lf records %u types %u\n", ii, (unsigned long long)block.offset, (block.first - hp->monotonic) / 1000000000.0, (block.last - hp->monotonic) / 1000000000.0, block.records, block.types);
+            for (jj = 0; jj < block.types; ++jj) {
+                printf("    %s %s %u\n", (counts[jj].key == CAPTURE_OVERFLOW) ? "*" : capture_name(counts[jj].key >> 24), type2string(counts[jj].key, buffer, sizeof(buffer)), counts[jj].count);
+            }
+        }
+        goto done;
+    }
+
+    for (ii = 0; (ii < count) || ((ii == 0) && (count == 0)); ++ii) {
+
+        if (count == 0) {
+            offset = sizeof(capture_header_t);
+            limit = length;
+        } else {
+            counts = capture_index(base, length, blocks[ii], &block);
+            if (block.first > finish) {
+                break;
+            } else if (block.last < begin) {
+                skipped += block.records;
+                continue;
+            } else if (capture_count(&block, counts, key, mask) == 0) {
+                skipped += block.records;
+                continue;
+            } else {
+                offset = block.offset;
+                limit = blocks[ii];
+            }
+        }
+
+        while ((offset < limit) && ((data = capture_next(base, length, &offset, &record)) != (const void *)0)) {
+            if ((record.key >> 24) == CAPTURE_INDEX) {
+                continue;
+            } else if ((record.key >> 24) == CAPTURE_TRAILER) {
+                continue;
+            } else if (record.stamp < begin) {
+                continue;
+            } else if (record.stamp > finish) {
+                break;
+            } else if ((record.key & mask) != (key & mask)) {
+                continue;
+            } else {
+                /* Do nothing. */
+            }
+
+            if (debug) {
+                fprintf(stderr, "%s: stamp %lld length %u key 0x%08x\n", program, (long long)record.stamp, record.length, record.key);
+            }
+
+            if (list) {
+                printf("%.9lf %s %s %u\n", (record.stamp - hp->monotonic) / 1000000000.0, capture_name(record.key >> 24), type2string(record.key, buffer, sizeof(buffer)), record.length);
+            } else if (fwrite(data, record.length, 1, stdout) != 1) {
+                perror(program);
+                xc = 1;
+                goto done;
+            } else {
+                /* Do nothing. */
+            }
+
+            messages += 1;
+        }
+
+    }
+
+    if (verbose) {
+        fprintf(stderr, "%s: messages %llu skipped %llu\n", program, (unsigned long long)messages, (unsigned long long)skipped);
+    }
+
+done:
+
+    if (fflush(stdout) == EOF) {
+        perror(program);
+        xc = 1;
+    }
+
+    free(blocks);
+
+    capture_unload(&image);
+
+    return xc;
+}
@@ -0,0 +1,317 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Converts a CSV or binary trace to a columnar archive and back again.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * Filter that converts the CSV trace written by gpstool -T, or the binary
+ * trace written by gpstool -T with -3, into a columnar archive that
+ * arcquery can filter and aggregate without rescanning every record, or
+ * with -r converts an archive back into the CSV trace, line for line
+ * exactly as gpstool would have written it. Lines in the CSV that are not
+ * trace records, like the headings, are skipped. If the input is a file, it
+ * is mapped into memory instead of being read. Archives may be
+ * concatenated, for example to add a day of traces to an archive of a
+ * year of them.
+ *
+ * USAGE
+ *
+ * csv2arc [ -? ] [ -d ] [ -v ] [ -r ] [ -n ROWS ]
+ *
+ * EXAMPLES
+ *
+ * csv2arc < data.csv > data.arc
+ *
+ * csv2arc < data.trc >> fleet.arc
+ *
+ * csv2arc -r < data.arc > data.csv
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "com/diag/hazer/archive.h"
+#include "com/diag/hazer/trace.h"
+
+/**
+ * This is the state of the conversion.
+ */
+typedef struct Converter {
+    const char * program;           /* Program name. */
+    int debug;                      /* Display debug output. */
+    int verbose;                    /* Display verbose output. */
+    archive_t archive;              /* Archive being written. */
+} converter_t;
+
+/**
+ * Write a record of the trace to the archive; this is the trace callback.
+ * @param context points to the converter.
+ * @param rp points to the record or is NULL if the line is not a record.
+ * @param line points to the CSV line or is NULL if the trace is binary.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+static int arc(void * context, const trace_record_t * rp, const char * line)
+{
+    converter_t * cp = (converter_t *)context;
+
+    if (cp->debug && (line != (const char *)0)) {
+        fputs(line, stderr);
+    }
+
+    if (rp == (const trace_record_t *)0) {
+        if (cp->verbose) {
+            fprintf(stderr, "%s: skipped: %s", cp->program, line);
+        }
+        return 0;
+    }
+
+    return archive_write(&(cp->archive), rp);
+}
+
+/**
+ * Convert a CSV or binary trace on standard input into an archive on
+ * standard output.
+ * @param cp points to the converter.
+ * @param rows is the most records in a chunk, 0 for the default.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int trc2arc(converter_t * cp, uint32_t rows)
+{
+    int rc = 0;
+
+    if (archive_init(&(cp->archive), stdout, rows) == (archive_t *)0) {
+        perror(cp->program);
+        return -1;
+    }
+
+    if ((rc = trace_input(stdin, arc, cp, (trace_kind_t *)0)) < 0) {
+        perror(cp->program);
+    }
+
+    if (archive_fini(&(cp->archive)) < 0) {
+        perror(cp->program);
+        rc = -1;
+    }
+
+    if (cp->verbose) {
+        fprintf(stderr, "%s: archived %llu records in %llu chunks in %llu bytes\n", cp->program, (unsigned long long)cp->archive.records, (unsigned long long)cp->archive.chunks, (unsigned long long)cp->archive.bytes);
+    }
+
+    return rc;
+}
+
+/**
+ * Convert an archive on standard input into CSV on standard output.
+ * @param cp points to the converter.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int arc2csv(converter_t * cp)
+{
+    int rc = -1;
+    int ii = 0;
+    struct stat status;
+    void * base = MAP_FAILED;
+    char * data = (char *)0;
+    char * more = (char *)0;
+    size_t length = 0;
+    size_t size = 0;
+    size_t count = 0;
+    uint64_t offset = 0;
+    uint64_t records = 0;
+    uint32_t index = 0;
+    const archive_chunk_t * chp = (const archive_chunk_t *)0;
+    trace_record_t * decoded = (trace_record_t *)0;
+    uint32_t capacity = 0;
+    char buffer[TRACE_LINE];
+
+    for (ii = 0; ii < TRACE_COLUMNS; ++ii) {
+        if (ii > 0) { fputc(' ', stdout); }
+        fputs(trace_heading(ii), stdout);
+        if (ii < (TRACE_COLUMNS - 1)) { fputc(',', stdout); } else { fputc('\n', stdout); }
+    }
+
+    if (fstat(fileno(stdin), &status) < 0) {
+        perror(cp->program);
+        return -1;
+    }
+
+    /*
+     * An archive that isn't a file, like a pipe, is read into memory,
+     * which is practical because archives are compact.
+     */
+
+    if (!S_ISREG(status.st_mode)) {
+        /* Do nothing. */
+    } else if (status.st_size == 0) {
+        /* Do nothing. */
+    } else if ((base = mmap((void *)0, status.st_size, PROT_READ, MAP_PRIVATE, fileno(stdin), 0)) == MAP_FAILED) {
+        if (cp->verbose) {
+            perror(cp->program);
+        }
+    } else {
+        data = (char *)base;
+        length = status.st_size;
+    }
+
+    if (base == MAP_FAILED) {
+        do {
+            if ((length + sizeof(buffer)) > size) {
+                size = (size == 0) ? (1 << 20) : (size * 2);
+                if ((more = (char *)realloc(data, size)) == (char *)0) {
+                    perror(cp->program);
+                    free(data);
+                    return -1;
+                }
+                data = more;
+            }
+            count = fread(data + length, 1, size - length, stdin);
+            length += count;
+        } while (count > 0);
+        if (ferror(stdin)) {
+            perror(cp->program);
+            free(data);
+            return -1;
+        }
+    }
+
+    do {
+
+        if (archive_check(data, length) == (const archive_header_t *)0) {
+            perror(cp->program);
+            break;
+        }
+
+        while ((chp = archive_next(data, length, &offset)) != (const archive_chunk_t *)0) {
+            if (chp->rows > capacity) {
+                free(decoded);
+                capacity = chp->rows;
+                if ((decoded = (trace_record_t *)malloc(capacity * sizeof(trace_record_t))) == (trace_record_t *)0) {
+                    perror(cp->program);
+                    break;
+                }
+            }
+            if (archive_records(chp, decoded) < 0) {
+                perror(cp->program);
+                break;
+            }
+            for (index = 0; index < chp->rows; ++index) {
+                if (trace_format(&(decoded[index]), buffer, sizeof(buffer)) < 0) {
+                    perror(cp->program);
+                    break;
+                }
+                if (cp->debug) {
+                    fputs(buffer, stderr);
+                }
+                if (fputs(buffer, stdout) == EOF) {
+                    perror(cp->program);
+                    break;
+                }
+            }
+            if (index < chp->rows) {
+                break;
+            }
+            records += chp->rows;
+        }
+
+        if (chp != (const archive_chunk_t *)0) {
+            break;
+        }
+
+        if (offset < length) {
+            errno = EILSEQ;
+            if (cp->verbose) {
+                perror(cp->program);
+            }
+        }
+
+        if (cp->verbose) {
+            fprintf(stderr, "%s: extracted %llu records from %zu bytes\n", cp->program, (unsigned long long)records, length);
+        }
+
+        rc = 0;
+
+    } while (0);
+
+    free(decoded);
+
+    if (base != MAP_FAILED) {
+        (void)munmap(base, length);
+    } else {
+        free(data);
+    }
+
+    return rc;
+}
+
+int main(int argc, char *argv[])
+{
+    int rc = 0;
+    int opt = -1;
+    int reverse = 0;
+    long rows = 0;
+    char * end = (char *)0;
+    converter_t converter;
+
+    extern char * optarg;
+    extern int optind;
+    extern int opterr;
+    extern int optopt;
+
+    memset(&converter, 0, sizeof(converter));
+
+    converter.program = ((converter.program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : converter.program + 1;
+
+    while ((opt = getopt(argc, argv, "?dn:rv")) >= 0) {
+        switch (opt) {
+        case '?':
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -r ] [ -n ROWS ]\n", converter.program);
+            fprintf(stderr, "       -?          Print this menu.\n");
+            fprintf(stderr, "       -d          Display debug output.\n");
+            fprintf(stderr, "       -n ROWS     Put at most ROWS records in each chunk instead of %d.\n", ARCHIVE_ROWS);
+            fprintf(stderr, "       -r          Convert archive to CSV instead of trace to archive.\n");
+            fprintf(stderr, "       -v          Display verbose output.\n");
+            return 0;
+            break;
+        case 'd':
+            converter.debug = !0;
+            break;
+        case 'n':
+            rows = strtol(optarg, &end, 0);
+            if ((end == (char *)0) || (*end != '\0') || (rows <= 0) || (rows > ARCHIVE_LIMIT)) {
+                errno = EINVAL;
+                perror(optarg);
+                return 1;
+            }
+            break;
+        case 'r':
+            reverse = !0;
+            break;
+        case 'v':
+            converter.verbose = !0;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -r ] [ -n ROWS ]\n", converter.program);
+            return 1;
+            break;
+        }
+    }
+
+    rc = reverse ? arc2csv(&converter) : trc2arc(&converter, rows);
+
+    if (fflush(stdout) == EOF) {
+        perror(converter.program);
+        rc = -1;
+    }
+
+    return (rc < 0) ? 1 : 0;
+}
@@ -17,9 +17,16 @@
  *
  * See tst/unittest-csv2dgm.sh for examples of all the output formats.
  *
+ * The latest datagram can also be saved in an observation file. With -C
+ * the file is committed at most once every so many milliseconds, and with
+ * -S it is synchronized to storage only every so many commits rather than
+ * on every commit as it is by default. Since the input is read a line at a
+ * time, a datagram held back by -C is committed when the next line arrives
+ * after the interval, or at end of file.
+ *
  * USAGE
  * 
- * csv2dgm [ -d ] [ -v ] [ -t ] [ -c | -j | -q | -s | -x | -y ] [ -F FILE ] [ -M MODE ] [ -U HOST:PORT ] [ -D DEVICE [ -b BPS ] [ -
+ * csv2dgm [ -d ] [ -v ] [ -t ] [ -c | -j | -q | -s | -x | -y ] [ -F FILE ] [ -M MODE ] [ -C MILLISECONDS ] [ -S COMMITS ] [ -U HOST:PORT ] [ -D DEVICE [ -b BPS ] [ -
  *
  * EXAMPLE
  *
@@ -41,6 +48,7 @@
 #include "com/diag/diminuto/diminuto_countof.h"
 #include "com/diag/diminuto/diminuto_escape.h"
 #include "com/diag/diminuto/diminuto_fd.h"
+#include "com/diag/diminuto/diminuto_frequency.h"
 #include "com/diag/diminuto/diminuto_interrupter.h"
 #include "com/diag/diminuto/diminuto_ipc.h"
 #include "com/diag/diminuto/diminuto_ipc4.h"
@@ -58,6 +66,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include "com/diag/hazer/observer.h"
 #include <sys/stat.h>
 #include <fcntl.h>
 
@@ -228,13 +237,19 @@ int main(int argc, char * argv[])
     int rc = -1;
     int ii = -1;
     mode_t mode = COM_DIAG_DIMINUTO_OBSERVATION_MODE;
+    long milliseconds = 0;
+    unsigned long every = 1;
+    observer_t observer;
+    observer_t * op = (observer_t *)0;
+    diminuto_sticks_t frequency = 0;
+    diminuto_sticks_t now = 0;
+    diminuto_sticks_t then = 0;
     diminuto_ipc_endpoint_t endpoint = { 0, };
     char * device = (char *)0;
     char * endpointname = (char *)0;
     char * filename = (char *)0;
     char * token[23] = { 0, };
     char * here = (char *)0;
-    char * temp = (char *)0;
     char * end = (char *)0;
     const char * format = (const char *)0;
     FILE * fp = (FILE *)0;
@@ -274,7 +289,7 @@ int main(int argc, char * argv[])
 
         program = ((program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : program + 1;
 
-        while ((opt = getopt(argc, argv, "1278D:F:M:U:b:cedhjmnoqrstvxy")) >= 0) {
+        while ((opt = getopt(argc, argv, "1278C:D:F:M:S:U:b:cedhjmnoqrstvxy")) >= 0) {
             switch (opt) {
             case '1':
                 stopbits = 1;
@@ -288,6 +303,14 @@ int main(int argc, char * argv[])
             case '8':
                 databits = 8;
                 break;
+            case 'C':
+                milliseconds = strtol(optarg, &end, 0);
+                if ((end == (char *)0) || (*end != '\0') || (milliseconds < 0)) {
+                    errno = EINVAL;
+                    diminuto_perror(optarg);
+                    error = !0;
+                }
+                break;
             case 'D':
                 device = optarg;
                 break;
@@ -302,6 +325,14 @@ int main(int argc, char * argv[])
                     error = !0;
                 }
                 break;
+            case 'S':
+                every = strtoul(optarg, &end, 0);
+                if ((end == (char *)0) || (*end != '\0') || (every > 0xffffffffUL)) {
+                    errno = EINVAL;
+                    diminuto_perror(optarg);
+                    error = !0;
+                }
+                break;
             case 'U':
                 endpointname = optarg;
                 break;
@@ -361,14 +392,16 @@ int main(int argc, char * argv[])
                 break;
             default:
             case '?':
-                fprintf(stderr, "usage: %s [ -d ] [ -v ] [ -c | -h | -j | | -q | -s | -x | -y ] [ -t ] [ -D DEVICE [ -b BPS ] [ -7 | -8 ] [ -1 | -2 ] [ -e | -o | -n ] [ -m ] [ -r ] ] [ -F FILE ] [ -M MODE ] [ -U HOST:PORT ]\n", program);
+                fprintf(stderr, "usage: %s [ -d ] [ -v ] [ -c | -h | -j | | -q | -s | -x | -y ] [ -t ] [ -D DEVICE [ -b BPS ] [ -7 | -8 ] [ -1 | -2 ] [ -e | -o | -n ] [ -m ] [ -r ] ] [ -F FILE ] [ -M MODE ] [ -C MILLISECONDS ] [ -S COMMITS ] [ -U HOST:PORT ]\n", program);
                 fprintf(stderr, "       -1              Set DEVICE to 1 stop bit.\n");
                 fprintf(stderr, "       -2              Set DEVICE to 2 stop bits.\n");
                 fprintf(stderr, "       -7              Set DEVICE to 7 data bits.\n");
                 fprintf(stderr, "       -8              Set DEVICE to 8 data bits.\n");
+                fprintf(stderr, "       -C MILLISECONDS Commit FILE at most once every MILLISECONDS.\n");
                 fprintf(stderr, "       -D DEVICE       Write datagram to DEVICE.\n");
                 fprintf(stderr, "       -F FILE         Save latest datagram in observation FILE.\n");
                 fprintf(stderr, "       -M MODE         Set FILE mode to MODE.\n");
+                fprintf(stderr, "       -S COMMITS      Sync FILE to storage every COMMITS commits (default 1, 0 for never).\n");
                 fprintf(stderr, "       -U HOST:PORT    Forward datagrams to HOST:PORT.\n");
                 fprintf(stderr, "       -b BPS          Set DEVICE to BPS bits per second.\n");
                 fprintf(stderr, "       -c              Emit CSV.\n");
@@ -428,19 +461,24 @@ int main(int argc, char * argv[])
             /* Do nothing. */
         } else if (strcmp(filename, "-") == 0) {
             fp = stdout;
-        } else if ((fp = diminuto_observation_create_generic(filename, &temp, mode)) == (FILE *)0) {
+        } else if ((frequency = diminuto_frequency()) <= 0) {
+            diminuto_perror("diminuto_frequency");
+            break;
+        } else if ((op = observer_init(&observer, filename, mode, sizeof(output), (milliseconds * frequency) / 1000, every)) == (observer_t *)0) {
             diminuto_perror(filename);
             break;
         } else {
-            /* Do nothing. */
+            then = diminuto_time_elapsed();
         }
 
         if (!debug) {
             /* Do nothing. */
         } else if (filename == (char *)0) {
             /* Do nothing. */
+        } else if (fp != (FILE *)0) {
+            fprintf(stderr, "%s: file=\"%s\" fd=%d\n", program, filename, fileno(fp));
         } else {
-            fprintf(stderr, "%s: file=\"%s\" mode=0%03o fd=%d\n", program, filename, mode, fileno(fp));
+            fprintf(stderr, "%s: file=\"%s\" mode=0%03o interval=%ldms every=%lu\n", program, filename, mode, milliseconds, every);
         }
 
         if (device == (char *)0) {
@@ -755,7 +793,8 @@ int main(int argc, char * argv[])
             }
 
             /*
-             * Write the output line to the observation file and commit it.
+             * Write the output line to the observation file, which
+             * commits it if it's been long enough since the last commit.
              */
 
             if (fp != (FILE *)0) {
@@ -763,13 +802,10 @@ int main(int argc, char * argv[])
                 fflush(fp);
             }
 
-            if (fp == (FILE *)0) {
-                /* Do nothing. */
-            } else if (fp == stdout) {
+            if (op == (observer_t *)0) {
                 /* Do nothing. */
-            } else if ((fp = diminuto_observation_commit(fp, &temp)) != (FILE *)0) {
-                break;
-            } else if ((fp = diminuto_observation_create_generic(filename, &temp, mode)) == (FILE *)0) {
+            } else if (observer_offer(op, output, length, diminuto_time_elapsed()) < 0) {
+                diminuto_perror(filename);
                 break;
             } else {
                 /* Do nothing. */
@@ -811,12 +847,18 @@ int main(int argc, char * argv[])
             /* Do nothing. */
         }
 
-        if (fp == (FILE *)0) {
-            /* Do nothing. */
-        } else if (fp == stdout) {
-            /* Do nothing. */
-        } else {
-            fp = diminuto_observation_discard(fp, &temp);
+        /*
+         * Commit whatever datagram the observer is still holding, so that
+         * the observation file ends up with the last one.
+         */
+
+        if (op != (observer_t *)0) {
+            if (observer_flush(op) < 0) {
+                diminuto_perror(filename);
+            }
+            now = diminuto_time_elapsed();
+            if (debug) { fprintf(stderr, "%s: offered=%llu commits=%llu syncs=%llu errors=%llu operations=%llu rate=%.3f/s\n", program, (unsigned long long)op->offered, (unsigned long long)op->commits, (unsigned long long)op->syncs, (unsigned long long)op->errors, (unsigned long long)op->operations, (now > then) ? ((double)op->operations * frequency) / (now - then) : 0.0); }
+            observer_fini(op);
         }
 
     } while (0);
@@ -0,0 +1,627 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Converts a trace to KML or GeoJSON to visualize a path.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * Filter that reads the CSV trace written by gpstool -T, or the binary
+ * trace written by gpstool -T with -3, and writes KML XML, or with -g
+ * GeoJSON, that visualizes the path as a line, or with -p as a point for
+ * each record, or with -c as a point for each record at which the fix type
+ * or the number of satellites changed. The kind of trace is detected from
+ * its first octets. Each record is converted as it is read, so the output
+ * streams as the input does, for example from a trace still being written.
+ *
+ * With -t, the line or the points are first simplified with Douglas-Peucker
+ * so that no record left out is farther than the tolerance in meters from
+ * the path through the records that are kept. This has to see the whole
+ * path before it writes any of it, so it keeps the position, and the few
+ * columns written with it, of every record in memory until the input ends.
+ * Changes are never simplified.
+ *
+ * The KML is the same as that written by the csv2kml, csv2kmlpoints, and
+ * csv2kmlchanges scripts that this replaces, but for the snippet that
+ * refers to the tool that wrote it. If the trace on standard input is a
+ * file, it is mapped into memory instead of being read.
+ *
+ * USAGE
+ *
+ * csv2kml [ -? ] [ -d ] [ -v ] [ -c | -p ] [ -g ] [ -t METERS ]
+ *
+ * EXAMPLES
+ *
+ * csv2kml < data.csv > data.kml
+ *
+ * csv2kml -p -t 1.0 < data.trc > points.kml
+ *
+ * csv2kml -g -t 0.5 < data.csv > data.geojson
+ *
+ * REFERENCES
+ *
+ * "OGC KML 2.3", 2015 <http://docs.opengeospatial.org/is/12-007r2/12-007r2.html>
+ *
+ * J. Wernecke, "The KML Handbook", Addison-Wesley, 2009
+ *
+ * H. Butler et al., "The GeoJSON Format", RFC 7946, 2016
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "com/diag/hazer/render.h"
+#include "com/diag/hazer/simplify.h"
+#include "com/diag/hazer/trace.h"
+
+/**
+ * These are the kinds of output.
+ */
+enum Mode {
+    MODE_LINE       = 'l',
+    MODE_POINTS     = 'p',
+    MODE_CHANGES    = 'c',
+};
+
+/**
+ * These are the columns kept for each record when the path is simplified,
+ * which are all of those that are written for a line or for points.
+ */
+static const trace_column_t KEPT[] = {
+    TRACE_NUM, TRACE_LAT, TRACE_LON, TRACE_MSL, TRACE_SOG, TRACE_ROL, TRACE_PIT, TRACE_YAW,
+};
+
+enum {
+    KEPTS = sizeof(KEPT) / sizeof(KEPT[0]),
+    COLUMN = 96,        /* Large enough for any column or timestamp. */
+};
+
+/**
+ * This is what is kept for each record when the path is simplified.
+ */
+typedef struct Vertex {
+    int64_t value[KEPTS];
+    int8_t digits[KEPTS];
+} vertex_t;
+
+/**
+ * This is the state of the conversion.
+ */
+typedef struct Converter {
+    const char * program;           /* Program name. */
+    int debug;                      /* Debug output. */
+    int mode;                       /* MODE_LINE, MODE_POINTS, MODE_CHANGES. */
+    int json;                       /* GeoJSON instead of KML. */
+    int simplifying;                /* Simplify the path. */
+    double tolerance;               /* Tolerance in meters. */
+    int begun;                      /* The beginning has been written. */
+    int changed;                    /* A change has been seen. */
+    long records;                   /* Records read. */
+    long written;                   /* Lines, points or changes written. */
+    trace_record_t previous;        /* Prior change. */
+    simplify_point_t * points;      /* Path to simplify. */
+    vertex_t * vertices;            /* Records kept along with it. */
+    size_t count;                   /* Number of points in the path. */
+    size_t size;                    /* Number of points allocated. */
+} converter_t;
+
+/**
+ * Return the value of a column in a record as a double.
+ * @param rp points to the record.
+ * @param column is the column.
+ * @return the value.
+ */
+static double number(const trace_record_t * rp, trace_column_t column)
+{
+    double value = 0.0;
+    int ii = 0;
+
+    value = rp->value[column];
+    for (ii = 0; ii < rp->digits[column]; ++ii) {
+        value /= 10.0;
+    }
+
+    return value;
+}
+
+/**
+ * Render a column in a record the way gpstool writes it in the CSV, or, for
+ * GeoJSON, as a JSON number, which can't end in a decimal point.
+ * @param cp points to the converter.
+ * @param buffer points to a buffer of COLUMN octets.
+ * @param rp points to the record.
+ * @param column is the column.
+ * @return a pointer to the buffer.
+ */
+static const char * column(const converter_t * cp, char * buffer, const trace_record_t * rp, trace_column_t column)
+{
+    char * here = buffer;
+
+    if ((rp->digits[column] < 0) || (rp->digits[column] > TRACE_DIGITS)) {
+        here = render_signed(here, rp->value[column]);
+    } else {
+        here = render_fixed(here, rp->value[column], rp->digits[column]);
+        if (cp->json && (here[-1] == '.')) {
+            here = render_char(here, '0');
+        }
+    }
+    *here = '\0';
+
+    return buffer;
+}
+
+/**
+ * Render the local clock column of a record as a UTC timestamp with
+ * nanoseconds, in the form used by the scripts that this replaces for KML,
+ * or in ISO 8601 form for GeoJSON.
+ * @param cp points to the converter.
+ * @param buffer points to a buffer of COLUMN octets.
+ * @param rp points to the record.
+ * @return a pointer to the buffer.
+ */
+static const char * timestamp(const converter_t * cp, char * buffer, const trace_record_t * rp)
+{
+    int64_t seconds = 0;
+    int64_t fraction = 0;
+    int64_t scale = 1;
+    int digits = 0;
+    int ii = 0;
+    time_t when = 0;
+    struct tm datetime;
+
+    digits = rp->digits[TRACE_CLK];
+    if ((digits < 0) || (digits > TRACE_DIGITS)) {
+        digits = 0;
+    }
+
+    for (ii = 0; ii < digits; ++ii) {
+        scale *= 10;
+    }
+    seconds = rp->value[TRACE_CLK] / scale;
+    fraction = rp->value[TRACE_CLK] % scale;
+    if (fraction < 0) {
+        seconds -= 1;
+        fraction += scale;
+    }
+    for (ii = digits; ii < 9; ++ii) {
+        fraction *= 10;
+    }
+    for (ii = 9; ii < digits; ++ii) {
+        fraction /= 10;
+    }
+
+    when = seconds;
+    memset(&datetime, 0, sizeof(datetime));
+    (void)gmtime_r(&when, &datetime);
+
+    if (cp->json) {
+        snprintf(buffer, COLUMN, "%04d-%02d-%02dT%02d:%02d:%02d.%09lldZ", datetime.tm_year + 1900, datetime.tm_mon + 1, datetime.tm_mday, datetime.tm_hour, datetime.tm_min, datetime.tm_sec, (long long)fraction);
+    } else {
+        snprintf(buffer, COLUMN, "%04d%02d%02dT%02d%02d%02dZ%09lld", datetime.tm_year + 1900, datetime.tm_mon + 1, datetime.tm_mday, datetime.tm_hour, datetime.tm_min, datetime.tm_sec, (long long)fraction);
+    }
+
+    return buffer;
+}
+
+/**
+ * Return the name of a fix type the way csvfix2str does.
+ * @param rp points to the record.
+ * @return the name.
+ */
+static const char * fix(const trace_record_t * rp)
+{
+    static const char * const NAMES[] = { "NO", "IN", "2D", "3D", "GI", "TM", };
+
+    return ((0 <= rp->value[TRACE_FIX]) && (rp->value[TRACE_FIX] < (int64_t)(sizeof(NAMES) / sizeof(NAMES[0])))) ? NAMES[rp->value[TRACE_FIX]] : "OT";
+}
+
+/**
+ * Write the host name in a record as a JSON string.
+ * @param rp points to the record.
+ */
+static void name(const trace_record_t * rp)
+{
+    const char * here = rp->name;
+
+    fputc('"', stdout);
+    for (here = rp->name; (here < &(rp->name[sizeof(rp->name)])) && (*here != '\0'); ++here) {
+        if ((*here == '"') || (*here == '\\')) {
+            fputc('\\', stdout);
+            fputc(*here, stdout);
+        } else if ((unsigned char)*here < ' ') {
+            fprintf(stdout, "\\u%04x", (unsigned char)*here);
+        } else {
+            fputc(*here, stdout);
+        }
+    }
+    fputc('"', stdout);
+}
+
+/**
+ * Write the beginning of the output, which is named after the first
+ * record.
+ * @param cp points to the converter.
+ * @param rp points to the first record.
+ */
+static void begin(converter_t * cp, const trace_record_t * rp)
+{
+    char time[COLUMN];
+    char lat[COLUMN];
+    char lon[COLUMN];
+    char msl[COLUMN];
+
+    if (cp->json) {
+        fputs("{\"type\": \"FeatureCollection\", \"name\": ", stdout);
+        name(rp);
+        fputs(", \"features\": [\n", stdout);
+        if (cp->mode == MODE_LINE) {
+            fprintf(stdout, "{\"type\": \"Feature\", \"properties\": {\"name\": \"%s\"}, \"geometry\": {\"type\": \"LineString\", \"coordinates\": [\n", timestamp(cp, time, rp));
+        }
+    } else {
+        fputs("<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\"?>\n", stdout);
+        fputs("<kml xmlns=\"http://www.opengis.net/kml/2.2\">\n", stdout);
+        fputs("  <Document>\n", stdout);
+        fprintf(stdout, "    <name><![CDATA[%.*s]]></name>\n", (int)sizeof(rp->name), rp->name);
+        fputs("    <visibility>1</visibility>\n", stdout);
+        fputs("    <open>1</open>\n", stdout);
+        fputs("    <Snippet><![CDATA[See <a href=\"https://github.com/coverclock/com-diag-hazer/blob/master/Hazer/bin/csv2kml.c\">csv2kml</a>]]></Snippet>\n", stdout);
+        if (cp->mode == MODE_LINE) {
+            fputs("    <Folder id=\"Line\">\n", stdout);
+            fputs("      <name>Line</name>\n", stdout);
+            fputs("      <visibility>1</visibility>\n", stdout);
+            fputs("      <open>0</open>\n", stdout);
+            fputs("      <Placemark>\n", stdout);
+            fprintf(stdout, "        <name><![CDATA[%s]]></name>\n", timestamp(cp, time, rp));
+            fputs("        <Snippet></Snippet>\n", stdout);
+            fprintf(stdout, "        <description><![CDATA[%s,%s,%s,]]></description>\n", column(cp, lat, rp, TRACE_LAT), column(cp, lon, rp, TRACE_LON), column(cp, msl, rp, TRACE_MSL));
+            fputs("        <Style>\n", stdout);
+            fputs("          <LineStyle>\n", stdout);
+            fputs("            <color>ff0000e6</color>\n", stdout);
+            fputs("            <width>4</width>\n", stdout);
+            fputs("          </LineStyle>\n", stdout);
+            fputs("        </Style>\n", stdout);
+            fputs("        <LineString>\n", stdout);
+            fputs("          <tessellate>1</tessellate>\n", stdout);
+            fputs("          <altitudeMode>clampToGround</altitudeMode>\n", stdout);
+            fputs("          <coordinates>\n", stdout);
+        } else {
+            fputs("    <Folder id=\"Tracks\">\n", stdout);
+            fputs("      <name>Tracks</name>\n", stdout);
+            fputs("      <visibility>1</visibility>\n", stdout);
+            fputs("      <open>0</open>\n", stdout);
+        }
+    }
+
+    cp->begun = !0;
+}
+
+/**
+ * Write a record as a vertex of the line, a point, or a change.
+ * @param cp points to the converter.
+ * @param rp points to the record.
+ */
+static void emit(converter_t * cp, const trace_record_t * rp)
+{
+    char num[COLUMN];
+    char lat[COLUMN];
+    char lon[COLUMN];
+    char msl[COLUMN];
+    char sat[COLUMN];
+    char sog[COLUMN];
+    char rol[COLUMN];
+    char pit[COLUMN];
+    char yaw[COLUMN];
+
+    column(cp, lat, rp, TRACE_LAT);
+    column(cp, lon, rp, TRACE_LON);
+    column(cp, msl, rp, TRACE_MSL);
+
+    if (cp->mode == MODE_LINE) {
+        if (!cp->json) {
+            fprintf(stdout, "            %s,%s,%s \n", lon, lat, msl);
+        } else if (cp->written > 0) {
+            fprintf(stdout, ",\n[%s, %s, %s]", lon, lat, msl);
+        } else {
+            fprintf(stdout, "[%s, %s, %s]", lon, lat, msl);
+        }
+    } else {
+        column(cp, num, rp, TRACE_NUM);
+        column(cp, sat, rp, TRACE_SAT);
+        column(cp, sog, rp, TRACE_SOG);
+        column(cp, rol, rp, TRACE_ROL);
+        column(cp, pit, rp, TRACE_PIT);
+        column(cp, yaw, rp, TRACE_YAW);
+        if (!cp->json) {
+            fputs("      <Placemark>\n", stdout);
+            fprintf(stdout, "        <name><![CDATA[%s]]></name>\n", num);
+            fputs("        <Snippet></Snippet>\n", stdout);
+            if (cp->mode == MODE_POINTS) {
+                fprintf(stdout, "        <description><![CDATA[%s,%s,%s,%s,]]></description>\n", sog, rol, pit, yaw);
+            } else {
+                fprintf(stdout, "        <description><![CDATA[%s,%s,%s,%s,%s,%s,]]></description>\n", fix(rp), sat, sog, rol, pit, yaw);
+            }
+            fputs("        <Point>\n", stdout);
+            fputs("          <coordinates>\n", stdout);
+            fprintf(stdout, "            %s,%s,%s \n", lon, lat, msl);
+            fputs("          </coordinates>\n", stdout);
+            fputs("        </Point>\n", stdout);
+            fputs("      </Placemark>\n", stdout);
+        } else {
+            if (cp->written > 0) {
+                fputs(",\n", stdout);
+            }
+            fprintf(stdout, "{\"type\": \"Feature\", \"properties\": {\"num\": %s, ", num);
+            if (cp->mode == MODE_CHANGES) {
+                fprintf(stdout, "\"fix\": \"%s\", \"sat\": %s, ", fix(rp), sat);
+            }
+            fprintf(stdout, "\"sog\": %s, \"rol\": %s, \"pit\": %s, \"yaw\": %s}, \"geometry\": {\"type\": \"Point\", \"coordinates\": [%s, %s, %s]}}", sog, rol, pit, yaw, lon, lat, msl);
+        }
+    }
+
+    cp->written += 1;
+}
+
+/**
+ * Write the end of the output.
+ * @param cp points to the converter.
+ */
+static void finish(converter_t * cp)
+{
+    if (cp->json) {
+        if (cp->written > 0) {
+            fputc('\n', stdout);
+        }
+        if (cp->mode == MODE_LINE) {
+            fputs("]}}\n", stdout);
+        }
+        fputs("]}\n", stdout);
+    } else {
+        if (cp->mode == MODE_LINE) {
+            fputs("          </coordinates>\n", stdout);
+            fputs("        </LineString>\n", stdout);
+            fputs("      </Placemark>\n", stdout);
+        }
+        fputs("    </Folder>\n", stdout);
+        fputs("  </Document>\n", stdout);
+        fputs("</kml>\n", stdout);
+    }
+}
+
+/**
+ * Convert a record, or keep it to be simplified.
+ * @param cp points to the converter.
+ * @param rp points to the record.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+static int convert(converter_t * cp, const trace_record_t * rp)
+{
+    size_t size = 0;
+    void * pointer = (void *)0;
+    int ii = 0;
+
+    cp->records += 1;
+
+    if (!cp->begun) {
+        begin(cp, rp);
+    }
+
+    if (cp->mode == MODE_CHANGES) {
+        if (!cp->changed || (rp->value[TRACE_FIX] != cp->previous.value[TRACE_FIX]) || (rp->digits[TRACE_FIX] != cp->previous.digits[TRACE_FIX]) || (rp->value[TRACE_SAT] != cp->previous.value[TRACE_SAT]) || (rp->digits[TRACE_SAT] != cp->previous.digits[TRACE_SAT])) {
+            emit(cp, rp);
+            cp->previous = *rp;
+            cp->changed = !0;
+        }
+    } else if (!cp->simplifying) {
+        emit(cp, rp);
+    } else {
+        if (cp->count >= cp->size) {
+            size = (cp->size == 0) ? 4096 : (cp->size * 2);
+            if ((pointer = realloc(cp->points, size * sizeof(cp->points[0]))) == (void *)0) {
+                return -1;
+            }
+            cp->points = (simplify_point_t *)pointer;
+            if ((pointer = realloc(cp->vertices, size * sizeof(cp->vertices[0]))) == (void *)0) {
+                return -1;
+            }
+            cp->vertices = (vertex_t *)pointer;
+            cp->size = size;
+        }
+        cp->points[cp->count].latitude = number(rp, TRACE_LAT);
+        cp->points[cp->count].longitude = number(rp, TRACE_LON);
+        for (ii = 0; ii < KEPTS; ++ii) {
+            cp->vertices[cp->count].value[ii] = rp->value[KEPT[ii]];
+            cp->vertices[cp->count].digits[ii] = rp->digits[KEPT[ii]];
+        }
+        cp->count += 1;
+    }
+
+    return 0;
+}
+
+/**
+ * Simplify the path that has been kept and write what remains of it.
+ * @param cp points to the converter.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int simplify(converter_t * cp)
+{
+    uint8_t * keep = (uint8_t *)0;
+    ssize_t kept = 0;
+    size_t index = 0;
+    int ii = 0;
+    trace_record_t record;
+
+    if (cp->count == 0) {
+        return 0;
+    }
+
+    if ((keep = (uint8_t *)malloc(cp->count)) == (uint8_t *)0) {
+        perror(cp->program);
+        return -1;
+    }
+
+    if ((kept = simplify_path(cp->points, cp->count, cp->tolerance, keep)) < 0) {
+        perror(cp->program);
+        free(keep);
+        return -1;
+    }
+
+    if (cp->debug) {
+        fprintf(stderr, "%s: simplified %zu points to %zd\n", cp->program, cp->count, kept);
+    }
+
+    trace_record_init(&record, "", 0);
+    for (index = 0; index < cp->count; ++index) {
+        if (!keep[index]) {
+            continue;
+        }
+        for (ii = 0; ii < KEPTS; ++ii) {
+            trace_record_set(&record, KEPT[ii], cp->vertices[index].value[ii], cp->vertices[index].digits[ii]);
+        }
+        emit(cp, &record);
+    }
+
+    free(keep);
+
+    return 0;
+}
+
+/**
+ * Convert a record of the trace; this is the trace callback.
+ * @param context points to the converter.
+ * @param rp points to the record or is NULL if the line is not a record.
+ * @param line points to the CSV line or is NULL if the trace is binary.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int kml(void * context, const trace_record_t * rp, const char * line)
+{
+    converter_t * cp = (converter_t *)context;
+
+    if (!cp->debug) {
+        /* Do nothing. */
+    } else if (line == (const char *)0) {
+        /* Do nothing. */
+    } else {
+        fputs(line, stderr);
+    }
+
+    return (rp == (const trace_record_t *)0) ? 0 : convert(cp, rp);
+}
+
+/**
+ * Convert the trace on standard input.
+ * @param cp points to the converter.
+ * @param verbose is true for verbose output.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int input(converter_t * cp, int verbose)
+{
+    trace_kind_t kind = TRACE_EMPTY;
+
+    if (trace_input(stdin, kml, cp, &kind) < 0) {
+        perror(cp->program);
+        return -1;
+    }
+
+    if (verbose) {
+        fprintf(stderr, "%s: read %s trace\n", cp->program, (kind == TRACE_BINARY) ? "binary" : (kind == TRACE_CSV) ? "CSV" : "empty");
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int xc = 0;
+    int opt = -1;
+    int verbose = 0;
+    char * end = (char *)0;
+    converter_t converter;
+    trace_record_t record;
+
+    extern char * optarg;
+    extern int optind;
+    extern int opterr;
+    extern int optopt;
+
+    memset(&converter, 0, sizeof(converter));
+    converter.mode = MODE_LINE;
+
+    converter.program = ((converter.program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : converter.program + 1;
+
+    while ((opt = getopt(argc, argv, "?cdgpt:v")) >= 0) {
+        switch (opt) {
+        case '?':
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -c | -p ] [ -g ] [ -t METERS ]\n", converter.program);
+            fprintf(stderr, "       -?          Print this menu.\n");
+            fprintf(stderr, "       -d          Display debug output.\n");
+            fprintf(stderr, "       -v          Display verbose output.\n");
+            fprintf(stderr, "       -c          Write a point where the fix or satellites change.\n");
+            fprintf(stderr, "       -p          Write a point for each record instead of a line.\n");
+            fprintf(stderr, "       -g          Write GeoJSON instead of KML.\n");
+            fprintf(stderr, "       -t METERS   Simplify the line or points to a tolerance of METERS.\n");
+            return 0;
+            break;
+        case 'c':
+            converter.mode = MODE_CHANGES;
+            break;
+        case 'd':
+            converter.debug = !0;
+            break;
+        case 'g':
+            converter.json = !0;
+            break;
+        case 'p':
+            converter.mode = MODE_POINTS;
+            break;
+        case 't':
+            converter.tolerance = strtod(optarg, &end);
+            if ((end == (char *)0) || (*end != '\0') || (converter.tolerance < 0.0)) {
+                errno = EINVAL;
+                perror(optarg);
+                return 1;
+            }
+            converter.simplifying = !0;
+            break;
+        case 'v':
+            verbose = !0;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -c | -p ] [ -g ] [ -t METERS ]\n", converter.program);
+            return 1;
+            break;
+        }
+    }
+
+    if (input(&converter, verbose) < 0) {
+        xc = 1;
+    } else if (simplify(&converter) < 0) {
+        xc = 1;
+    } else {
+        if (!converter.begun) {
+            begin(&converter, trace_record_init(&record, "", 0));
+        }
+        finish(&converter);
+    }
+
+    if (fflush(stdout) == EOF) {
+        perror(converter.program);
+        xc = 1;
+    }
+
+    if (verbose) {
+        fprintf(stderr, "%s: read %ld records wrote %ld\n", converter.program, converter.records, converter.written);
+    }
+
+    free(converter.points);
+    free(converter.vertices);
+
+    return xc;
+}
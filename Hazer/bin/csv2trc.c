@@ -0,0 +1,222 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Converts a CSV trace to a binary trace and back again.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * Filter that converts the CSV trace written by gpstool -T into the
+ * binary trace written by gpstool -T with -3, or with -r converts a binary
+ * trace back into the CSV trace, line for line exactly as gpstool would
+ * have written it. Lines in the CSV that are not trace records, like the
+ * headings, are skipped. If the trace on standard input is a file, it is
+ * mapped into memory instead of being read.
+ *
+ * USAGE
+ *
+ * csv2trc [ -? ] [ -d ] [ -v ] [ -r ]
+ *
+ * EXAMPLE
+ *
+ * csv2trc < data.csv > data.trc
+ *
+ * csv2trc -r < data.trc > data.csv
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "com/diag/hazer/trace.h"
+
+/**
+ * This is the state of a conversion.
+ */
+typedef struct Converter {
+    const char * program;
+    int debug;
+    int verbose;
+    long count;
+} converter_t;
+
+/**
+ * Write a trace record from a CSV line to standard output; this is the trace
+ * callback for the conversion to a binary trace.
+ * @param context points to the converter.
+ * @param rp points to the record or is NULL if the line is not a record.
+ * @param line points to the CSV line or is NULL if the trace is binary.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+static int trc(void * context, const trace_record_t * rp, const char * line)
+{
+    converter_t * cp = (converter_t *)context;
+
+    if (cp->debug && (line != (const char *)0)) {
+        fputs(line, stderr);
+    }
+
+    if (rp == (const trace_record_t *)0) {
+        if (cp->verbose) {
+            fprintf(stderr, "%s: skipped: %s", cp->program, line);
+        }
+        return 0;
+    }
+
+    if (fwrite(rp, sizeof(*rp), 1, stdout) < 1) {
+        return -1;
+    }
+
+    cp->count += 1;
+
+    return 0;
+}
+
+/**
+ * Convert CSV on standard input into a binary trace on standard output.
+ * @param cp points to the converter.
+ * @return the number of records or <0 if an error occurred.
+ */
+static long csv2trc(converter_t * cp)
+{
+    trace_header_t header;
+
+    if (fwrite(trace_header_init(&header), sizeof(header), 1, stdout) < 1) {
+        perror(cp->program);
+        return -1;
+    }
+
+    if (trace_input(stdin, trc, cp, (trace_kind_t *)0) < 0) {
+        perror(cp->program);
+        return -1;
+    }
+
+    return cp->count;
+}
+
+/**
+ * Emit a trace record as CSV on standard output; this is the trace callback
+ * for the conversion from a binary trace, which rejects CSV.
+ * @param context points to the converter.
+ * @param rp points to the record.
+ * @param line is NULL if the trace is binary.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+static int csv(void * context, const trace_record_t * rp, const char * line)
+{
+    converter_t * cp = (converter_t *)context;
+    char buffer[TRACE_LINE] = { '\0', };
+
+    if (line != (const char *)0) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (trace_format(rp, buffer, sizeof(buffer)) < 0) {
+        return -1;
+    }
+
+    if (cp->debug) {
+        fputs(buffer, stderr);
+    }
+
+    if (fputs(buffer, stdout) == EOF) {
+        return -1;
+    }
+
+    cp->count += 1;
+
+    return 0;
+}
+
+/**
+ * Convert a binary trace on standard input into CSV on standard output.
+ * @param cp points to the converter.
+ * @return the number of records or <0 if an error occurred.
+ */
+static long trc2csv(converter_t * cp)
+{
+    int ii = 0;
+    trace_kind_t kind = TRACE_EMPTY;
+
+    for (ii = 0; ii < TRACE_COLUMNS; ++ii) {
+        if (ii > 0) { fputc(' ', stdout); }
+        fputs(trace_heading(ii), stdout);
+        if (ii < (TRACE_COLUMNS - 1)) { fputc(',', stdout); } else { fputc('\n', stdout); }
+    }
+
+    if (trace_input(stdin, csv, cp, &kind) < 0) {
+        perror(cp->program);
+        return -1;
+    }
+
+    if (kind == TRACE_EMPTY) {
+        errno = ENODATA;
+        perror(cp->program);
+        return -1;
+    }
+
+    return cp->count;
+}
+
+int main(int argc, char *argv[])
+{
+    const char * program = (const char *)0;
+    int opt = -1;
+    int reverse = 0;
+    long count = 0;
+    converter_t converter;
+
+    extern char * optarg;
+    extern int optind;
+    extern int opterr;
+    extern int optopt;
+
+    program = ((program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : program + 1;
+
+    memset(&converter, 0, sizeof(converter));
+    converter.program = program;
+
+    while ((opt = getopt(argc, argv, "?dvr")) >= 0) {
+        switch (opt) {
+        case '?':
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -r ]\n", program);
+            fprintf(stderr, "       -?          Print this menu.\n");
+            fprintf(stderr, "       -d          Display debug output.\n");
+            fprintf(stderr, "       -v          Display verbose output.\n");
+            fprintf(stderr, "       -r          Convert binary trace to CSV instead of CSV to binary trace.\n");
+            return 0;
+            break;
+        case 'd':
+            converter.debug = !0;
+            break;
+        case 'v':
+            converter.verbose = !0;
+            break;
+        case 'r':
+            reverse = !0;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -r ]\n", program);
+            return 1;
+            break;
+        }
+    }
+
+    count = reverse ? trc2csv(&converter) : csv2trc(&converter);
+
+    if (fflush(stdout) == EOF) {
+        perror(program);
+        count = -1;
+    }
+
+    if (converter.verbose && (count >= 0)) {
+        fprintf(stderr, "%s: converted %ld records\n", program, count);
+    }
+
+    return (count < 0) ? 1 : 0;
+}
@@ -1,7 +1,7 @@
 /* vi: set ts=4 expandtab shiftwidth=4: */
 /**
  * @file
- * @copyright Copyright 2020-2022 Digital Aggregates Corporation, Colorado, USA.
+ * @copyright Copyright 2020-2024 Digital Aggregates Corporation, Colorado, USA.
  * @note Licensed under the terms in LICENSE.txt.
  * @brief Filter that determines the boundaries of the solutions in a CSV file.
  * @author Chip Overclock <mailto:coverclock@diag.com>
@@ -10,196 +10,397 @@
  *
  * ABSTRACT
  *
- * Filter that determines the boundaries of the solutions in a CSV file.
- * Also useful as a model for other code that reads the CSV file.
+ * Filter that determines the boundaries of the solutions in a CSV file,
+ * or in a binary trace file, considering only records with a 3D or better
+ * fix. With -s, it also reports the count, minimum, maximum, mean,
+ * standard deviation, and estimated percentiles of every numeric column
+ * of those records.
+ *
+ * If the input is a file, it is mapped into memory, split at line (or
+ * record) boundaries into a piece for each thread, and each piece is
+ * parsed and accumulated by its own thread. The statistics of the pieces
+ * are then merged: the limits, count, mean, and variance are the same as
+ * if one thread had done it all, but for rounding, and the percentiles are
+ * estimated to within a fraction of a percent of their rank. Input that
+ * isn't a file, like a pipe, is read by one thread.
  *
  * USAGE
  *
- * csvlimits [ -? ] [ -d ] [ -v ]
+ * csvlimits [ -? ] [ -d ] [ -v ] [ -s ] [ -j THREADS ]
  *
- * EXAMPLE
+ * EXAMPLES
  *
  * csvlimits < data.csv
+ *
+ * csvlimits -s -v < data.trc
  */
 
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
-#include <values.h>
+#include <sys/mman.h>
+#include "com/diag/hazer/statistics.h"
+#include "com/diag/hazer/trace.h"
+
+/**
+ * These are the percentiles that are reported.
+ */
+static const double PERCENTILES[] = { 1.0, 5.0, 25.0, 50.0, 75.0, 95.0, 99.0, };
+
+enum {
+    PIECE = 1 << 20,    /* Smallest piece worth a thread of its own. */
+};
+
+/**
+ * This is the work of each thread.
+ */
+typedef struct Worker {
+    pthread_t thread;                           /* Thread. */
+    int started;                                /* Thread was started. */
+    int rc;                                     /* 0 or <0 for an error. */
+    const char * begin;                         /* Beginning of CSV. */
+    const char * end;                           /* End of CSV. */
+    const trace_record_t * records;             /* Records of binary trace. */
+    size_t total;                               /* Number of records. */
+    long lines;                                 /* Lines or records read. */
+    long skipped;                               /* Lines that aren't records. */
+    statistics_t statistics[TRACE_COLUMNS];     /* Statistics of each column. */
+} worker_t;
+
+static const char * Program = (const char *)0;
+static int Debug = 0;
+static int Verbose = 0;
+
+/**
+ * Accumulate a record into the statistics of a worker if it has a 3D or
+ * better fix.
+ * @param wp points to the worker.
+ * @param rp points to the record.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+static int accumulate(worker_t * wp, const trace_record_t * rp)
+{
+    int ii = 0;
+
+    if (rp->value[TRACE_FIX] < 3) {
+        return 0;
+    }
+
+    for (ii = TRACE_NAM + 1; ii < TRACE_COLUMNS; ++ii) {
+        if (statistics_add(&(wp->statistics[ii]), trace_number(rp->value[ii], rp->digits[ii])) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Accumulate a record of the trace if it is one; this is the trace callback.
+ * @param context points to the worker.
+ * @param rp points to the record or is NULL if the line is not a record.
+ * @param line points to the CSV line or is NULL if the trace is binary.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+static int limit(void * context, const trace_record_t * rp, const char * line)
+{
+    worker_t * wp = (worker_t *)context;
+
+    wp->lines += 1;
+
+    if (Debug && (line != (const char *)0)) {
+        fputs(line, stderr);
+    }
+
+    if (rp == (const trace_record_t *)0) {
+        if (Verbose) {
+            fprintf(stderr, "%s: skipped: %s", Program, line);
+        }
+        wp->skipped += 1;
+        return 0;
+    }
+
+    return accumulate(wp, rp);
+}
+
+/**
+ * Accumulate the piece of the input given to a worker.
+ * @param arg points to the worker.
+ * @return NULL.
+ */
+static void * work(void * arg)
+{
+    worker_t * wp = (worker_t *)arg;
+    size_t index = 0;
+
+    if (wp->records == (const trace_record_t *)0) {
+        wp->rc = trace_lines(wp->begin, wp->end - wp->begin, limit, wp);
+    } else {
+        for (index = 0; index < wp->total; ++index) {
+            if ((wp->rc = limit(wp, &(wp->records[index]), (const char *)0)) < 0) {
+                break;
+            }
+        }
+    }
+
+    if (wp->rc < 0) {
+        perror(Program);
+    }
+
+    return (void *)0;
+}
+
+/**
+ * Return the beginning of the line after the one that contains an offset.
+ * @param base points to the beginning of the CSV.
+ * @param length is the length of the CSV in bytes.
+ * @param offset is the offset.
+ * @return the offset of the beginning of the next line.
+ */
+static size_t boundary(const char * base, size_t length, size_t offset)
+{
+    const char * newline = (const char *)0;
+
+    if (offset == 0) {
+        /* Do nothing. */
+    } else if (offset >= length) {
+        offset = length;
+    } else if ((newline = (const char *)memchr(base + offset - 1, '\n', length - offset + 1)) == (const char *)0) {
+        offset = length;
+    } else {
+        offset = newline - base + 1;
+    }
+
+    return offset;
+}
 
 int main(int argc, char *argv[])
 {
-    const char * program = (const char *)0;
+    int xc = 0;
     int opt = -1;
-    int debug = 0;
-    int verbose = 0;
-    char buffer[512] = { '\0', };
-    int count = 0;
-    char * here = (char *)0;
-    char * hostname = (char *)0;
-    int observation = 0;
-    int fix = 0;
-    int system = 0;
-    int satellites = 0;
-    double clock = 0.0;
-    double time = 0.0;
-    double latitude = 0.0;
-    double longitude = 0.0;
-    double haccuracy = 0.0;
-    double msl = 0.0;
-    double geo = 0.0;
-    double vaccuracy = 0.0;
-    double speed = 0.0;
-    double course = 0.0;
-    double roll = 0.0;
-    double pitch = 0.0;
-    double yaw = 0.0;
-    double raccuracy = 0.0;
-    double paccuracy = 0.0;
-    double yaccuracy = 0.0;
-    int observations = 0;
-    double maccuracy = 0.0;
-    double minimum_latitude = MAXDOUBLE;
-    double maximum_latitude = -MAXDOUBLE;
-    double minimum_longitude = MAXDOUBLE;
-    double maximum_longitude = -MAXDOUBLE;
-    double minimum_msl = MAXDOUBLE;
-    double maximum_msl = -MAXDOUBLE;
-    double minimum_geo = MAXDOUBLE;
-    double maximum_geo = -MAXDOUBLE;
-    
+    int statistics = 0;
+    long threads = 0;
+    long ii = 0;
+    int jj = 0;
+    int kk = 0;
+    int rc = 0;
+    char * end = (char *)0;
+    trace_map_t map;
+    int mapped = 0;
+    size_t length = 0;
+    size_t offset = 0;
+    worker_t * workers = (worker_t *)0;
+    statistics_t * sp = (statistics_t *)0;
+    long lines = 0;
+    long skipped = 0;
+    struct timespec before = { 0, 0 };
+    struct timespec after = { 0, 0 };
+    double elapsed = 0.0;
+
     extern char * optarg;
     extern int optind;
     extern int opterr;
     extern int optopt;
 
-    // fprintf(stderr, "%.9lf %.9lf %.9lf\n", MINDOUBLE, -MAXDOUBLE, MAXDOUBLE);
+    Program = ((Program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : Program + 1;
 
-    program = ((program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : program + 1;
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
 
-    while ((opt = getopt(argc, argv, "?dv")) >= 0) {
+    while ((opt = getopt(argc, argv, "?dj:sv")) >= 0) {
         switch (opt) {
         case '?':
-            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ]\n", program);
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -s ] [ -j THREADS ]\n", Program);
+            fprintf(stderr, "       -?          Print this menu.\n");
+            fprintf(stderr, "       -d          Display debug output.\n");
+            fprintf(stderr, "       -j THREADS  Parse with THREADS threads instead of one per core.\n");
+            fprintf(stderr, "       -s          Display the statistics of every column.\n");
+            fprintf(stderr, "       -v          Display verbose output.\n");
             return 0;
             break;
         case 'd':
-            debug = !0;
+            Debug = !0;
+            break;
+        case 'j':
+            threads = strtol(optarg, &end, 0);
+            if ((end == (char *)0) || (*end != '\0') || (threads <= 0)) {
+                errno = EINVAL;
+                perror(optarg);
+                return 1;
+            }
+            break;
+        case 's':
+            statistics = !0;
             break;
         case 'v':
-            verbose = !0;
+            Verbose = !0;
             break;
         default:
-            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ]\n", program);
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -s ] [ -j THREADS ]\n", Program);
             return 1;
             break;
         }
     }
 
-    //fprintf(stderr, "%.9lf %.9lf %.9lf %.9lf\n", minimum_latitude, maximum_latitude, minimum_longitude, maximum_longitude);
-
-    while (fgets(buffer, sizeof(buffer), stdin) != (char *)0) {
-
-        if (debug) {
-            fputs(buffer, stderr);
-        }
+    if (threads <= 0) {
+        threads = 1;
+    }
 
-        // fputs(here, stdout);
+    clock_gettime(CLOCK_MONOTONIC, &before);
 
-        here = buffer;
+    /*
+     * A trace that cannot be mapped, for example because it is a pipe, is
+     * read a line or a record at a time by one thread.
+     */
 
-        if (*here != '"') { 
-            if (verbose) {
-                fprintf(stderr, "%s", here);
-            }
-            continue;
-        }
+    if (trace_map(&map, fileno(stdin)) != (trace_map_t *)0) {
+        mapped = !0;
+        length = map.length;
+        (void)madvise((void *)(map.base), length, MADV_SEQUENTIAL);
+    }
 
-        // fputs(here, stdout);
+    /*
+     * There is no point in a thread for a piece too small to be worth the
+     * overhead of starting it.
+     */
+
+    if (!mapped) {
+        threads = 1;
+    } else if (threads > ((length / PIECE) + 1)) {
+        threads = (length / PIECE) + 1;
+    } else {
+        /* Do nothing. */
+    }
 
-        here += 1;
-        hostname = here;
+    if ((workers = (worker_t *)calloc(threads, sizeof(worker_t))) == (worker_t *)0) {
+        perror(Program);
+        return 1;
+    }
 
-        if ((here = strchr(here, '"')) == (char *)0) {
-            continue;
+    for (ii = 0; ii < threads; ++ii) {
+        for (jj = 0; jj < TRACE_COLUMNS; ++jj) {
+            statistics_init(&(workers[ii].statistics[jj]));
         }
+    }
 
-        // fputs(here, stdout);
-
-        *here = '\0';
-        here += 1;
+    if (!mapped) {
 
-        if (*here != ',') {
-            continue;
+        if ((workers[0].rc = trace_read(stdin, limit, &(workers[0]), (trace_kind_t *)0)) < 0) {
+            perror(Program);
         }
 
-        // fputs(here, stdout);
-
-        here += 1;
-
-        if (*here != ' ') {
-            continue;
+    } else {
+
+        for (ii = 0; ii < threads; ++ii) {
+            if (map.kind == TRACE_BINARY) {
+                workers[ii].records = &(map.records[(map.count * ii) / threads]);
+                workers[ii].total = ((map.count * (ii + 1)) / threads) - ((map.count * ii) / threads);
+            } else if (map.kind == TRACE_CSV) {
+                offset = boundary(map.base, length, (length * ii) / threads);
+                workers[ii].begin = map.base + offset;
+                offset = boundary(map.base, length, (length * (ii + 1)) / threads);
+                workers[ii].end = map.base + offset;
+            } else {
+                /* Do nothing. */
+            }
         }
 
-        // fputs(here, stdout);
-
-        here += 1;
-
-        if (sscanf(here, "%d, %d, %d, %d, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %d, %lf\n", &observation, &fix, &system, &satellites, &clock, &time, &latitude, &longitude, &haccuracy, &msl, &geo, &vaccuracy, &speed, &course, &roll, &pitch, &yaw, &raccuracy, &paccuracy, &yaccuracy, &observations, &maccuracy) != 22) {
-            continue;
+        /*
+         * A piece whose thread can't be created is done by this thread
+         * instead, so the result is the same, only slower.
+         */
+
+        for (ii = 1; ii < threads; ++ii) {
+            if ((rc = pthread_create(&(workers[ii].thread), (pthread_attr_t *)0, work, &(workers[ii]))) == 0) {
+                workers[ii].started = !0;
+            } else if (Verbose) {
+                fprintf(stderr, "%s: thread %ld inline %s\n", Program, ii, strerror(rc));
+            } else {
+                /* Do nothing. */
+            }
         }
 
-        // fputs(here, stdout);
+        (void)work(&(workers[0]));
 
-        if (fix < 3) {
-            continue;
+        for (ii = 1; ii < threads; ++ii) {
+            if (workers[ii].started) {
+                pthread_join(workers[ii].thread, (void **)0);
+            } else {
+                (void)work(&(workers[ii]));
+            }
         }
 
-        count += 1;
+    }
 
-        if (latitude < minimum_latitude) {
-            minimum_latitude = latitude;
-        }
+    /*
+     * The statistics of each piece are merged in order into those of the
+     * first, so the result doesn't depend on which thread finished first.
+     */
 
-        if (latitude > maximum_latitude) {
-            maximum_latitude = latitude;
+    for (ii = 0; ii < threads; ++ii) {
+        if (workers[ii].rc < 0) {
+            xc = 1;
         }
-
-        if (longitude < minimum_longitude) {
-            minimum_longitude = longitude;
+        lines += workers[ii].lines;
+        skipped += workers[ii].skipped;
+        if (Verbose) {
+            fprintf(stderr, "%s: thread %ld lines %ld skipped %ld records %llu\n", Program, ii, workers[ii].lines, workers[ii].skipped, (unsigned long long)workers[ii].statistics[TRACE_NUM].count);
         }
-
-        if (longitude > maximum_longitude) {
-            maximum_longitude = longitude;
+        if (ii == 0) {
+            continue;
         }
-
-        if (msl < minimum_msl) {
-            minimum_msl = msl;
+        for (jj = 0; jj < TRACE_COLUMNS; ++jj) {
+            if (statistics_merge(&(workers[0].statistics[jj]), &(workers[ii].statistics[jj])) < 0) {
+                perror(Program);
+                xc = 1;
+            }
+            statistics_fini(&(workers[ii].statistics[jj]));
         }
+    }
 
-        if (msl > maximum_msl) {
-            maximum_msl = msl;
-        }
+    sp = workers[0].statistics;
 
-        if (geo < minimum_geo) {
-            minimum_geo = geo;
-        }
+    clock_gettime(CLOCK_MONOTONIC, &after);
+    elapsed = (after.tv_sec - before.tv_sec) + ((after.tv_nsec - before.tv_nsec) / 1000000000.0);
 
-        if (geo > maximum_geo) {
-            maximum_geo = geo;
-        }
+    if (Verbose) {
+        fprintf(stderr, "%s: bytes %zu lines %ld skipped %ld threads %ld elapsed %.3lfs %.1lfMB/s\n", Program, length, lines, skipped, threads, elapsed, (elapsed > 0.0) ? (length / elapsed / 1000000.0) : 0.0);
+    }
 
-        if (verbose) {
-            fprintf(stderr, "\"%s\", %d, %d, %d, %d, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %lf, %d, %lf\n", hostname, observation, fix, system, satellites, clock, time, latitude, longitude, haccuracy, msl, geo, vaccuracy, speed, course, roll, pitch, yaw, raccuracy, paccuracy, yaccuracy, observations, maccuracy);
+    if (xc != 0) {
+        /* Do nothing. */
+    } else if (sp[TRACE_NUM].count == 0) {
+        xc = -1;
+    } else {
+        printf("%s: [%llu] %.9lf, %.9lf %.9lf, %.9lf %.9lf %.9lf %.9lf %.9lf\n", Program, (unsigned long long)sp[TRACE_NUM].count, sp[TRACE_LAT].minimum, sp[TRACE_LON].minimum, sp[TRACE_LAT].maximum, sp[TRACE_LON].maximum, sp[TRACE_MSL].minimum, sp[TRACE_MSL].maximum, sp[TRACE_GEO].minimum, sp[TRACE_GEO].maximum);
+        if (statistics) {
+            printf("%s: COL [COUNT] MINIMUM MAXIMUM MEAN DEVIATION", Program);
+            for (kk = 0; kk < (sizeof(PERCENTILES) / sizeof(PERCENTILES[0])); ++kk) {
+                printf(" P%g", PERCENTILES[kk]);
+            }
+            fputc('\n', stdout);
+            for (jj = TRACE_NAM + 1; jj < TRACE_COLUMNS; ++jj) {
+                printf("%s: %s [%llu] %.9lf %.9lf %.9lf %.9lf", Program, trace_heading(jj), (unsigned long long)sp[jj].count, sp[jj].minimum, sp[jj].maximum, sp[jj].mean, sqrt(statistics_variance(&(sp[jj]))));
+                for (kk = 0; kk < (sizeof(PERCENTILES) / sizeof(PERCENTILES[0])); ++kk) {
+                    printf(" %.9lf", statistics_percentile(&(sp[jj]), PERCENTILES[kk]));
+                }
+                fputc('\n', stdout);
+            }
         }
-
     }
 
-    if (count == 0) {
-        return -1;
+    for (jj = 0; jj < TRACE_COLUMNS; ++jj) {
+        statistics_fini(&(workers[0].statistics[jj]));
     }
+    free(workers);
 
-    printf("%s: [%d] %.9lf, %.9lf %.9lf, %.9lf %.9lf %.9lf %.9lf %.9lf\n", program, count, minimum_latitude, minimum_longitude, maximum_latitude, maximum_longitude, minimum_msl, maximum_msl, minimum_geo, maximum_geo);
+    if (mapped) {
+        trace_unmap(&map);
+    }
 
-    return 0;
+    return xc;
 }
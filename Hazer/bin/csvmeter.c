@@ -0,0 +1,383 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Meters the records in a trace out with their original timing.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * Filter that reads the CSV trace written by gpstool -T, or the binary
+ * trace written by gpstool -T with -3, and writes each record as the CSV
+ * line that gpstool wrote, with the same time between records as their
+ * local clock (CLK) column, or sped up by a factor, or as fast as possible.
+ * The lines are written to standard output, for example into a pipe to
+ * csv2dgm, or, with -U, each is sent as a datagram to a UDP endpoint
+ * instead. Each record is released at an absolute deadline computed from
+ * when the first was released, so the time spent reading and writing
+ * records doesn't accumulate as drift, no matter how many records there
+ * are a second. With -v, how late the records were released is reported
+ * at the end. The range is in seconds since the first record in the trace.
+ * If the trace on standard input is a file, it is mapped into memory
+ * instead of being read.
+ *
+ * The local clock of a trace is the real-time clock of the host that wrote
+ * it, which NTP may step backwards. A record whose local clock is earlier
+ * than that of the record before it is treated as if no time passed between
+ * them, so the time since the first record, which is used both for the
+ * range and for pacing, never goes backwards; with -v, how many times this
+ * happened is reported at the end. A step forwards can't be told from a gap
+ * in the trace, and is paced like one.
+ *
+ * This replaces the csvmeter script, which slept for the difference
+ * between successive records and so fell behind at more than a few hertz.
+ *
+ * USAGE
+ *
+ * csvmeter [ -? ] [ -d ] [ -v ] [ -x SPEED ] [ -b SECONDS ] [ -e SECONDS ] [ -U HOST:PORT ]
+ *
+ * EXAMPLES
+ *
+ * csvmeter < data.csv | csv2dgm -U localhost:8080 -j
+ *
+ * csvmeter -x 10 -b 3600 -v < data.trc > /dev/null
+ *
+ * csvmeter -U [::1]:5555 < data.csv
+ */
+
+#include "com/diag/diminuto/diminuto_ipc.h"
+#include "com/diag/diminuto/diminuto_ipc4.h"
+#include "com/diag/diminuto/diminuto_ipc6.h"
+#include "com/diag/diminuto/diminuto_types.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "com/diag/hazer/pacer.h"
+#include "com/diag/hazer/trace.h"
+
+/**
+ * This is the state of the meter.
+ */
+typedef struct Meter {
+    const char * program;           /* Program name. */
+    int debug;                      /* Debug output. */
+    int fd;                         /* Output file descriptor. */
+    int sock;                       /* Output socket or <0 for none. */
+    diminuto_ipc_endpoint_t endpoint; /* Output endpoint if a socket. */
+    int started;                    /* The first record has been seen. */
+    int64_t first;                  /* CLK of the first record in ns. */
+    int64_t previous;               /* Adjusted CLK of the last record in ns. */
+    int64_t adjustment;             /* Sum of steps backwards in ns. */
+    long backwards;                 /* Steps backwards. */
+    int64_t begin;                  /* Beginning of the range in ns. */
+    int64_t finish;                 /* End of the range in ns. */
+    long records;                   /* Records read. */
+    long written;                   /* Records written. */
+    pacer_t pacer;                  /* Pacer. */
+} meter_t;
+
+/**
+ * Return the local clock column of a record in nanoseconds.
+ * @param rp points to the record.
+ * @return the local clock in nanoseconds.
+ */
+static int64_t nanoseconds(const trace_record_t * rp)
+{
+    int64_t value = 0;
+    int ii = 0;
+
+    value = rp->value[TRACE_CLK];
+    if (rp->digits[TRACE_CLK] < 0) {
+        value *= 1000000000LL;
+    } else {
+        for (ii = rp->digits[TRACE_CLK]; ii < 9; ++ii) {
+            value *= 10;
+        }
+        for (ii = 9; ii < rp->digits[TRACE_CLK]; ++ii) {
+            value /= 10;
+        }
+    }
+
+    return value;
+}
+
+/**
+ * Return the time of a record since the first record in nanoseconds, from
+ * its local clock, treating a step backwards as if no time had passed.
+ * @param mp points to the meter.
+ * @param rp points to the record.
+ * @return the time since the first record in nanoseconds.
+ */
+static int64_t elapsed(meter_t * mp, const trace_record_t * rp)
+{
+    int64_t stamp = 0;
+
+    stamp = nanoseconds(rp);
+
+    if (!mp->started) {
+        mp->first = stamp;
+        mp->previous = stamp;
+        mp->started = !0;
+    }
+
+    stamp += mp->adjustment;
+
+    if (stamp < mp->previous) {
+        mp->adjustment += mp->previous - stamp;
+        mp->backwards += 1;
+        stamp = mp->previous;
+    }
+
+    mp->previous = stamp;
+
+    return stamp - mp->first;
+}
+
+/**
+ * Meter out a record if it is in the range.
+ * @param mp points to the meter.
+ * @param rp points to the record.
+ * @return 0 to continue, >0 if the range has ended, or <0 with errno set
+ * if an error occurred.
+ */
+static int release(meter_t * mp, const trace_record_t * rp)
+{
+    int64_t stamp = 0;
+    int64_t lateness = 0;
+    ssize_t length = 0;
+    ssize_t size = 0;
+    char buffer[TRACE_LINE];
+
+    mp->records += 1;
+
+    stamp = elapsed(mp, rp);
+
+    if (stamp < mp->begin) {
+        return 0;
+    }
+
+    if (stamp > mp->finish) {
+        return 1;
+    }
+
+    if ((length = trace_format(rp, buffer, sizeof(buffer))) < 0) {
+        return -1;
+    }
+
+    lateness = pacer_wait(&(mp->pacer), stamp);
+
+    if (mp->debug) {
+        fprintf(stderr, "%s: stamp %lld late %lldns %s", mp->program, (long long)stamp, (long long)lateness, buffer);
+    }
+
+    /*
+     * Send the line as an IPv4 or IPv6 datagram on the socket, or write
+     * it to the output.
+     */
+
+    if (mp->sock < 0) {
+        size = (pacer_write(mp->fd, buffer, length) < 0) ? -1 : length;
+    } else if (mp->endpoint.type == DIMINUTO_IPC_TYPE_IPV4) {
+        size = diminuto_ipc4_datagram_send(mp->sock, buffer, length, mp->endpoint.ipv4, mp->endpoint.udp);
+    } else {
+        size = diminuto_ipc6_datagram_send(mp->sock, buffer, length, mp->endpoint.ipv6, mp->endpoint.udp);
+    }
+
+    if (size == length) {
+        /* Do nothing. */
+    } else if (size < 0) {
+        return -1;
+    } else {
+        /* Should be impossible with UDP. */
+        errno = EIO;
+        return -1;
+    }
+
+    mp->written += 1;
+
+    return 0;
+}
+
+/**
+ * Meter out a record read from the trace, skipping lines that are not
+ * records.
+ * @param context points to the meter.
+ * @param rp points to the record or is NULL.
+ * @param line points to the CSV line or is NULL.
+ * @return 0 to continue, >0 if the range has ended, or <0 if an error
+ * occurred.
+ */
+static int meter(void * context, const trace_record_t * rp, const char * line)
+{
+    return (rp == (const trace_record_t *)0) ? 0 : release((meter_t *)context, rp);
+}
+
+/**
+ * Meter out the trace on standard input.
+ * @param mp points to the meter.
+ * @param verbose is true for verbose output.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int input(meter_t * mp, int verbose)
+{
+    trace_kind_t kind = TRACE_EMPTY;
+
+    if (trace_input(stdin, meter, mp, &kind) < 0) {
+        perror(mp->program);
+        return -1;
+    }
+
+    if (verbose) {
+        fprintf(stderr, "%s: read %s trace backwards %ld\n", mp->program, (kind == TRACE_BINARY) ? "binary" : (kind == TRACE_CSV) ? "CSV" : "empty", mp->backwards);
+    }
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int xc = 0;
+    int opt = -1;
+    int verbose = 0;
+    int error = 0;
+    double seconds = 0.0;
+    double speed = 1.0;
+    const char * endpointname = (const char *)0;
+    char * end = (char *)0;
+    meter_t meter;
+
+    extern char * optarg;
+    extern int optind;
+    extern int opterr;
+    extern int optopt;
+
+    memset(&meter, 0, sizeof(meter));
+    meter.fd = fileno(stdout);
+    meter.sock = -1;
+    meter.finish = INT64_MAX;
+    (void)pacer_init(&(meter.pacer), speed);
+
+    meter.program = ((meter.program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : meter.program + 1;
+
+    while ((opt = getopt(argc, argv, "?U:b:de:vx:")) >= 0) {
+        switch (opt) {
+        case '?':
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -x SPEED ] [ -b SECONDS ] [ -e SECONDS ] [ -U HOST:PORT ]\n", meter.program);
+            fprintf(stderr, "       -?          Print this menu.\n");
+            fprintf(stderr, "       -U HOST:PORT Send each record as a datagram to HOST:PORT instead of standard output.\n");
+            fprintf(stderr, "       -b SECONDS  Begin with records SECONDS after the first.\n");
+            fprintf(stderr, "       -d          Display debug output.\n");
+            fprintf(stderr, "       -e SECONDS  End with records SECONDS after the first.\n");
+            fprintf(stderr, "       -v          Display verbose output including lateness.\n");
+            fprintf(stderr, "       -x SPEED    Meter SPEED times faster than real time, 0 as fast as possible.\n");
+            return 0;
+            break;
+        case 'U':
+            endpointname = optarg;
+            break;
+        case 'b':
+            seconds = strtod(optarg, &end);
+            if ((end == (char *)0) || (*end != '\0') || (seconds < 0.0)) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            } else {
+                meter.begin = seconds * 1000000000.0;
+            }
+            break;
+        case 'd':
+            meter.debug = !0;
+            break;
+        case 'e':
+            seconds = strtod(optarg, &end);
+            if ((end == (char *)0) || (*end != '\0') || (seconds < 0.0)) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            } else {
+                meter.finish = seconds * 1000000000.0;
+            }
+            break;
+        case 'v':
+            verbose = !0;
+            break;
+        case 'x':
+            speed = strtod(optarg, &end);
+            if ((end == (char *)0) || (*end != '\0') || (pacer_init(&(meter.pacer), speed) == (pacer_t *)0)) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            }
+            break;
+        default:
+            error = !0;
+            break;
+        }
+    }
+
+    if (error) {
+        fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -x SPEED ] [ -b SECONDS ] [ -e SECONDS ] [ -U HOST:PORT ]\n", meter.program);
+        return 1;
+    }
+
+    /*
+     * Create a datagram socket with an ephemeral port number.
+     */
+
+    if (endpointname == (const char *)0) {
+        /* Do nothing. */
+    } else if (diminuto_ipc_endpoint(endpointname, &(meter.endpoint)) != 0) {
+        errno = EINVAL;
+        perror(endpointname);
+        return 1;
+    } else if (
+        ((meter.endpoint.type != DIMINUTO_IPC_TYPE_IPV4) &&
+            (meter.endpoint.type != DIMINUTO_IPC_TYPE_IPV6)) ||
+        ((diminuto_ipc4_is_unspecified(&meter.endpoint.ipv4) &&
+            diminuto_ipc6_is_unspecified(&meter.endpoint.ipv6))) ||
+        (meter.endpoint.udp == 0)
+    ) {
+        errno = EINVAL;
+        perror(endpointname);
+        return 1;
+    } else if (meter.endpoint.type == DIMINUTO_IPC_TYPE_IPV4) {
+        meter.sock = diminuto_ipc4_datagram_peer(0);
+    } else {
+        meter.sock = diminuto_ipc6_datagram_peer(0);
+    }
+
+    if (endpointname == (const char *)0) {
+        /* Do nothing. */
+    } else if (meter.sock >= 0) {
+        /* Do nothing. */
+    } else {
+        perror(endpointname);
+        return 1;
+    }
+
+    if (input(&meter, verbose) < 0) {
+        xc = 1;
+    }
+
+    if (verbose) {
+        fprintf(stderr, "%s: records %ld written %ld sleeps %llu late %llu mean %.6lfms p50 %.6lfms p90 %.6lfms p99 %.6lfms p99.9 %.6lfms max %.6lfms\n", meter.program,
+            meter.records, meter.written,
+            (unsigned long long)meter.pacer.sleeps, (unsigned long long)meter.pacer.late,
+            (meter.pacer.items > 0) ? (meter.pacer.total / 1000000.0 / meter.pacer.items) : 0.0,
+            pacer_percentile(&(meter.pacer), 50.0) / 1000000.0, pacer_percentile(&(meter.pacer), 90.0) / 1000000.0,
+            pacer_percentile(&(meter.pacer), 99.0) / 1000000.0, pacer_percentile(&(meter.pacer), 99.9) / 1000000.0,
+            meter.pacer.latest / 1000000.0);
+    }
+
+    if (meter.sock >= 0) {
+        (void)diminuto_ipc_close(meter.sock);
+    }
+
+    return xc;
+}
@@ -0,0 +1,962 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Decodes a large capture into a trace using all of the cores.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * Reads a raw stream of GNSS output, like that saved by gpstool -C, or a
+ * capture written by gpstool -0, and writes a trace with a record for each
+ * message that has a position, attitude, or survey: NMEA GGA and RMC, and
+ * UBX NAV-PVT, NAV-HPPOSLLH, NAV-ATT, and NAV-SVIN. The trace is in the
+ * format of the CSV that gpstool -T writes, or, with -3, of the binary
+ * trace that gpstool -3 writes, but it is NOT what gpstool writes for the
+ * same input. Each record comes from a single message, rather than from the
+ * state that gpstool accumulates over many messages, so that a message is
+ * decoded the same way no matter what came before it. The only output this
+ * tool reproduces is its own: decoding in parallel yields exactly what -j 1
+ * yields. Because its columns don't mean quite what those of gpstool do
+ * (for example the fix of an NMEA record is inferred from that one
+ * sentence), every record is flagged with TRACE_FLAG_MESSAGE, which the CSV
+ * shows as a "#" after the host name, so it can't be mistaken for a record
+ * written by gpstool. The clock column is when the message was received if
+ * the input is a capture, and is missing otherwise.
+ *
+ * The input is split into chunks that are decoded in parallel by a thread
+ * on each core. A raw stream is framed the way gpstool frames it, and each
+ * chunk of it is framed from its beginning as if it were the beginning of
+ * the stream, and a little past its end. Where a chunk and the one after
+ * it first reach the same point at which what framing comes next depends
+ * on nothing before it, they are stitched together, so the output is
+ * exactly what decoding the whole stream with one thread produces. A
+ * capture is split at message boundaries. With -v, the throughput of each
+ * thread in megabytes per second of CPU time is reported at the end.
+ * If the input is a file, it is mapped into memory instead of being read.
+ *
+ * USAGE
+ *
+ * decodetool [ -? ] [ -d ] [ -v ] [ -3 ] [ -j THREADS ] [ -c BYTES ] [ -N NAME ]
+ *
+ * EXAMPLES
+ *
+ * decodetool < week.dat > week.csv
+ *
+ * decodetool -3 -v < week.cap > week.trc
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "com/diag/hazer/capture.h"
+#include "com/diag/hazer/common.h"
+#include "com/diag/hazer/framer.h"
+#include "com/diag/hazer/trace.h"
+
+enum DecodetoolConstants {
+    OVERLAP     = 65536,            /* Octets framed past a chunk's end. */
+    CHUNK       = 16777216,         /* Default octets in a chunk. */
+};
+
+/**
+ * This is a trace record and the offset just past the message it came from.
+ */
+typedef struct Decoded {
+    uint64_t end;
+    trace_record_t record;
+} decoded_t;
+
+/**
+ * This is a chunk of the input and what decoding it produced. A point is
+ * an offset shifted left two bits and or'ed with its framer_event_t kind.
+ */
+typedef struct Chunk {
+    uint64_t begin;                 /* Offset at which framing starts. */
+    uint64_t end;                   /* Offset at which the next chunk starts. */
+    uint64_t limit;                 /* Offset at which framing stopped. */
+    framer_event_t kind;            /* Kind of point at the beginning. */
+    decoded_t * decoded;            /* Records. */
+    size_t count;                   /* Records used. */
+    size_t size;                    /* Records allocated. */
+    uint64_t * points;              /* Points near the beginning and end. */
+    size_t used;                    /* Points used. */
+    size_t allocated;               /* Points allocated. */
+    int done;                       /* !0 when decoded. */
+    int failed;                     /* !0 if decoding failed. */
+} chunk_t;
+
+/**
+ * This is a thread that decodes chunks, and its accounting.
+ */
+typedef struct Worker {
+    pthread_t thread;
+    uint64_t chunks;                /* Chunks decoded. */
+    uint64_t octets;                /* Octets decoded including overlap. */
+    int64_t cpu;                    /* Thread CPU time in ns. */
+} worker_t;
+
+static const char * Program = (const char *)0;
+static char Name[TRACE_NAME] = { '\0', };
+static const uint8_t * Base = (const uint8_t *)0;
+static size_t Length = 0;
+static const capture_header_t * Header = (const capture_header_t *)0;
+static chunk_t * Chunks = (chunk_t *)0;
+static size_t Count = 0;
+static size_t Next = 0;
+static size_t Merged = 0;
+static size_t Window = 0;
+static int Stopping = 0;
+static pthread_mutex_t Mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t Condition = PTHREAD_COND_INITIALIZER;
+
+/**
+ * Decode an NMEA sentence into a trace record as emit_collect() in gpstool
+ * would if the sentence were all it knew.
+ * @param rp points to the record.
+ * @param frame points to the sentence.
+ * @param length is the length of the sentence in bytes.
+ * @return !0 if the sentence produced a record, 0 otherwise.
+ */
+static int decode_nmea(trace_record_t * rp, const void * frame, size_t length)
+{
+    int result = 0;
+    hazer_talker_t talker = HAZER_TALKER_TOTAL;
+    hazer_system_t system = HAZER_SYSTEM_TOTAL;
+    hazer_position_t position = HAZER_POSITION_INITIALIZER;
+    hazer_buffer_t tokenized = HAZER_BUFFER_INITIALIZER;
+    hazer_vector_t vector = HAZER_VECTOR_INITIALIZER;
+    ssize_t count = 0;
+    int rc = -1;
+    int fix = 0;
+
+    if ((talker = hazer_parse_talker(frame, length)) >= HAZER_TALKER_TOTAL) {
+        /* Do nothing. */
+    } else if ((system = hazer_map_talker_to_system(talker)) >= HAZER_SYSTEM_TOTAL) {
+        /* Do nothing. */
+    } else if (length >= sizeof(tokenized)) {
+        /* Do nothing. */
+    } else {
+        memcpy(tokenized, frame, length);
+        tokenized[length] = '\0';
+        count = hazer_tokenize(vector, sizeof(vector) / sizeof(vector[0]), tokenized, length);
+        if (count <= 0) {
+            /* Do nothing. */
+        } else if (hazer_is_nmea_name(frame, length, HAZER_NMEA_SENTENCE_GGA)) {
+            rc = hazer_parse_gga(&position, vector, count);
+        } else if (hazer_is_nmea_name(frame, length, HAZER_NMEA_SENTENCE_RMC)) {
+            rc = hazer_parse_rmc(&position, vector, count);
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    if (rc == 0) {
+
+        position.timeout = 1;
+
+        if ((position.lat_digits == 0) || (position.lon_digits == 0)) {
+            fix = YODEL_UBX_NAV_PVT_fixType_noFix;
+        } else if ((position.alt_digits == 0) || (position.sep_digits == 0)) {
+            fix = YODEL_UBX_NAV_PVT_fixType_2D;
+        } else {
+            fix = YODEL_UBX_NAV_PVT_fixType_3D;
+        }
+
+        trace_record_set(rp, TRACE_FIX, fix, TRACE_INTEGER);
+        trace_record_set(rp, TRACE_SYS, system, TRACE_INTEGER);
+        trace_record_set(rp, TRACE_SAT, position.sat_used, TRACE_INTEGER);
+
+        if (hazer_is_valid_time(&position)) {
+            trace_record_set(rp, TRACE_TIM, position.tot_nanoseconds, 9);
+        }
+
+        if (position.lat_digits > 0) {
+            trace_record_set(rp, TRACE_LAT, position.lat_nanominutes / 6000, 7);
+        }
+
+        if (position.lon_digits > 0) {
+            trace_record_set(rp, TRACE_LON, position.lon_nanominutes / 6000, 7);
+        }
+
+        if (position.alt_digits > 0) {
+            trace_record_set(rp, TRACE_MSL, position.alt_millimeters, 3);
+            if (position.sep_digits > 0) {
+                trace_record_set(rp, TRACE_GEO, position.alt_millimeters + position.sep_millimeters, 3);
+            }
+        }
+
+        if (position.sog_digits > 0) {
+            trace_record_set(rp, TRACE_SOG, position.sog_microknots, 6);
+        }
+
+        if (position.cog_digits > 0) {
+            trace_record_set(rp, TRACE_COG, position.cog_nanodegrees, 9);
+        }
+
+        result = !0;
+
+    }
+
+    return result;
+}
+
+/**
+ * Decode a UBX packet into a trace record as emit_collect() in gpstool
+ * would if the packet were all it knew.
+ * @param rp points to the record.
+ * @param frame points to the packet.
+ * @param length is the length of the packet in bytes.
+ * @return !0 if the packet produced a record, 0 otherwise.
+ */
+static int decode_ubx(trace_record_t * rp, const void * frame, size_t length)
+{
+    int result = 0;
+    yodel_ubx_nav_pvt_t pvt;
+    yodel_ubx_nav_hpposllh_t hpposllh;
+    yodel_ubx_nav_att_t att;
+    yodel_ubx_nav_svin_t svin;
+    struct tm utc;
+    uint8_t mask = YODEL_UBX_NAV_PVT_valid_validDate | YODEL_UBX_NAV_PVT_valid_validTime;
+
+    if (yodel_is_ubx_class_id(frame, length, YODEL_UBX_NAV_PVT_Class, YODEL_UBX_NAV_PVT_Id)) {
+
+        if (yodel_ubx_nav_pvt(&pvt, frame, length) == 0) {
+
+            trace_record_set(rp, TRACE_FIX, pvt.fixType, TRACE_INTEGER);
+            trace_record_set(rp, TRACE_SYS, HAZER_SYSTEM_GNSS, TRACE_INTEGER);
+            trace_record_set(rp, TRACE_SAT, pvt.numSV, TRACE_INTEGER);
+
+            if ((pvt.valid & mask) == mask) {
+                memset(&utc, 0, sizeof(utc));
+                utc.tm_year = pvt.year - 1900;
+                utc.tm_mon = pvt.month - 1;
+                utc.tm_mday = pvt.day;
+                utc.tm_hour = pvt.hour;
+                utc.tm_min = pvt.minute;
+                utc.tm_sec = pvt.sec;
+                trace_record_set(rp, TRACE_TIM, ((int64_t)timegm(&utc) * 1000000000LL) + pvt.nano, 9);
+            }
+
+            /*
+             * Positions are in 10^-7 degrees, altitudes and accuracies in
+             * millimeters, speed in millimeters per second, and heading in
+             * 10^-5 degrees.
+             */
+
+            trace_record_set(rp, TRACE_LAT, pvt.lat, 7);
+            trace_record_set(rp, TRACE_LON, pvt.lon, 7);
+            trace_record_set(rp, TRACE_HAC, pvt.hAcc, 3);
+            trace_record_set(rp, TRACE_MSL, pvt.hMSL, 3);
+            trace_record_set(rp, TRACE_GEO, pvt.height, 3);
+            trace_record_set(rp, TRACE_VAC, pvt.vAcc, 3);
+            trace_record_set(rp, TRACE_SOG, ((int64_t)pvt.gSpeed * 3600000LL) / 1852LL, 6);
+            trace_record_set(rp, TRACE_COG, pvt.headMot, 5);
+
+            result = !0;
+
+        }
+
+    } else if (yodel_is_ubx_class_id(frame, length, YODEL_UBX_NAV_HPPOSLLH_Class, YODEL_UBX_NAV_HPPOSLLH_Id)) {
+
+        if (yodel_ubx_nav_hpposllh(&hpposllh, frame, length) == 0) {
+            trace_record_set(rp, TRACE_SYS, HAZER_SYSTEM_GNSS, TRACE_INTEGER);
+            trace_record_set(rp, TRACE_LAT, ((int64_t)hpposllh.lat * 100) + hpposllh.latHp, 9);
+            trace_record_set(rp, TRACE_LON, ((int64_t)hpposllh.lon * 100) + hpposllh.lonHp, 9);
+            trace_record_set(rp, TRACE_HAC, hpposllh.hAcc, 4);
+            trace_record_set(rp, TRACE_MSL, ((int64_t)hpposllh.hMSL * 10) + hpposllh.hMSLHp, 4);
+            trace_record_set(rp, TRACE_GEO, ((int64_t)hpposllh.height * 10) + hpposllh.heightHp, 4);
+            trace_record_set(rp, TRACE_VAC, hpposllh.vAcc, 4);
+            result = !0;
+        }
+
+    } else if (yodel_is_ubx_class_id(frame, length, YODEL_UBX_NAV_ATT_Class, YODEL_UBX_NAV_ATT_Id)) {
+
+        if (yodel_ubx_nav_att(&att, frame, length) == 0) {
+            trace_record_set(rp, TRACE_ROL, att.roll, 5);
+            trace_record_set(rp, TRACE_PIT, att.pitch, 5);
+            trace_record_set(rp, TRACE_YAW, att.heading, 5);
+            trace_record_set(rp, TRACE_RAC, att.accRoll, 5);
+            trace_record_set(rp, TRACE_PAC, att.accPitch, 5);
+            trace_record_set(rp, TRACE_YAC, att.accHeading, 5);
+            result = !0;
+        }
+
+    } else if (yodel_is_ubx_class_id(frame, length, YODEL_UBX_NAV_SVIN_Class, YODEL_UBX_NAV_SVIN_Id)) {
+
+        if (yodel_ubx_nav_svin(&svin, frame, length) == 0) {
+            trace_record_set(rp, TRACE_OBS, svin.obs, TRACE_INTEGER);
+            trace_record_set(rp, TRACE_MAC, svin.meanAcc, 4);
+            result = !0;
+        }
+
+    } else {
+        /* Do nothing. */
+    }
+
+    return result;
+}
+
+/**
+ * Decode a message and if it produces a trace record add it to a chunk.
+ * @param cp points to the chunk.
+ * @param end is the offset just past the message.
+ * @param protocol is the protocol of the message.
+ * @param frame points to the message.
+ * @param length is the length of the message in bytes.
+ * @return a pointer to the record, NULL if there is none, or NULL with
+ * the chunk marked as failed if memory could not be allocated.
+ */
+static trace_record_t * decode(chunk_t * cp, uint64_t end, capture_protocol_t protocol, const void * frame, size_t length)
+{
+    trace_record_t * result = (trace_record_t *)0;
+    decoded_t * here = (decoded_t *)0;
+    int rc = 0;
+
+    if (cp->count < cp->size) {
+        /* Do nothing. */
+    } else if ((here = (decoded_t *)realloc(cp->decoded, ((cp->size == 0) ? 1024 : (cp->size * 2)) * sizeof(decoded_t))) == (decoded_t *)0) {
+        perror(Program);
+        cp->failed = !0;
+        return result;
+    } else {
+        cp->decoded = here;
+        cp->size = (cp->size == 0) ? 1024 : (cp->size * 2);
+    }
+
+    here = &(cp->decoded[cp->count]);
+    trace_record_init(&(here->record), Name, TRACE_FLAG_MESSAGE);
+
+    if (protocol == CAPTURE_NMEA) {
+        rc = decode_nmea(&(here->record), frame, length);
+    } else if (protocol == CAPTURE_UBX) {
+        rc = decode_ubx(&(here->record), frame, length);
+    } else {
+        /* Do nothing. */
+    }
+
+    if (rc) {
+        here->end = end;
+        cp->count += 1;
+        result = &(here->record);
+    }
+
+    return result;
+}
+
+/**
+ * Remember a point in a chunk.
+ * @param cp points to the chunk.
+ * @param offset is the offset of the point.
+ * @param kind is the kind of the point.
+ */
+static void remember(chunk_t * cp, uint64_t offset, framer_event_t kind)
+{
+    uint64_t * here = (uint64_t *)0;
+
+    if (cp->used < cp->allocated) {
+        /* Do nothing. */
+    } else if ((here = (uint64_t *)realloc(cp->points, ((cp->allocated == 0) ? 4096 : (cp->allocated * 2)) * sizeof(uint64_t))) == (uint64_t *)0) {
+        perror(Program);
+        cp->failed = !0;
+        return;
+    } else {
+        cp->points = here;
+        cp->allocated = (cp->allocated == 0) ? 4096 : (cp->allocated * 2);
+    }
+
+    cp->points[cp->used++] = (offset << 2) | kind;
+}
+
+/**
+ * Frame and decode a chunk of a raw stream from its beginning to a little
+ * past its end, remembering the points near both.
+ * @param cp points to the chunk.
+ */
+static void scan(chunk_t * cp)
+{
+    framer_t framer;
+    framer_event_t event = FRAMER_CONTINUING;
+    capture_protocol_t protocol = CAPTURE_OTHER;
+    const void * frame = (const void *)0;
+    size_t length = 0;
+    uint64_t here = 0;
+    int tail = 0;
+
+    framer_init(&framer, cp->kind);
+    remember(cp, cp->begin, cp->kind);
+
+    for (here = cp->begin; (here < Length) && (!cp->failed); ) {
+        event = framer_machine(&framer, Base[here++]);
+        if (event == FRAMER_CONTINUING) {
+            continue;
+        }
+        if (event == FRAMER_FRAMED) {
+            frame = framer_frame(&framer, &protocol, &length);
+            (void)decode(cp, here, protocol, frame, length);
+        }
+        if (here < (cp->begin + OVERLAP)) {
+            remember(cp, here, event);
+        } else if (here >= cp->end) {
+            remember(cp, here, event);
+            tail = !0;
+        } else {
+            /* Do nothing. */
+        }
+        if (tail && (here >= (cp->end + OVERLAP))) {
+            break;
+        }
+    }
+
+    cp->limit = here;
+}
+
+/**
+ * Decode a chunk of a capture, whose messages are already framed.
+ * @param cp points to the chunk.
+ */
+static void extract(chunk_t * cp)
+{
+    uint64_t offset = 0;
+    const void * data = (const void *)0;
+    capture_record_t record;
+    trace_record_t * rp = (trace_record_t *)0;
+
+    offset = cp->begin;
+    while ((offset < cp->end) && (!cp->failed) && ((data = capture_next(Base, Length, &offset, &record)) != (const void *)0)) {
+        if ((rp = decode(cp, offset, record.key >> 24, data, record.length)) != (trace_record_t *)0) {
+            trace_record_set(rp, TRACE_CLK, Header->realtime + (record.stamp - Header->monotonic), 9);
+        }
+    }
+
+    cp->limit = offset;
+}
+
+/**
+ * Decode chunks until there are no more.
+ * @param arg points to the worker.
+ * @return NULL.
+ */
+static void * work(void * arg)
+{
+    worker_t * wp = (worker_t *)arg;
+    chunk_t * cp = (chunk_t *)0;
+
+    while (!0) {
+
+        pthread_mutex_lock(&Mutex);
+        while ((!Stopping) && (Next < Count) && (Next >= (Merged + Window))) {
+            pthread_cond_wait(&Condition, &Mutex);
+        }
+        cp = ((!Stopping) && (Next < Count)) ? &(Chunks[Next++]) : (chunk_t *)0;
+        pthread_mutex_unlock(&Mutex);
+
+        if (cp == (chunk_t *)0) {
+            break;
+        }
+
+        if (Header != (const capture_header_t *)0) {
+            extract(cp);
+        } else {
+            scan(cp);
+        }
+
+        wp->chunks += 1;
+        wp->octets += cp->limit - cp->begin;
+
+        pthread_mutex_lock(&Mutex);
+        cp->done = !0;
+        pthread_cond_broadcast(&Condition);
+        pthread_mutex_unlock(&Mutex);
+
+    }
+
+    wp->cpu = common_clock(CLOCK_THREAD_CPUTIME_ID);
+
+    return (void *)0;
+}
+
+/**
+ * Wait until a chunk has been decoded.
+ * @param cp points to the chunk.
+ */
+static void await(chunk_t * cp)
+{
+    pthread_mutex_lock(&Mutex);
+    while (!cp->done) {
+        pthread_cond_wait(&Condition, &Mutex);
+    }
+    pthread_mutex_unlock(&Mutex);
+}
+
+/**
+ * Return the first point after the end of a chunk, and after the offset at
+ * which it was joined to the one before it, at which the chunk after it is
+ * in the same state.
+ * @param cp points to the chunk.
+ * @param np points to the chunk after it.
+ * @param from is the offset at which the chunk was joined.
+ * @return the point or 0 if there is none.
+ */
+static uint64_t join(const chunk_t * cp, const chunk_t * np, uint64_t from)
+{
+    size_t ii = 0;
+    size_t jj = 0;
+    uint64_t first = 0;
+
+    first = ((cp->end > from) ? cp->end : from) << 2;
+
+    for (ii = 0; (ii < cp->used) && (cp->points[ii] < first); ++ii) {
+        /* Do nothing. */
+    }
+
+    while ((ii < cp->used) && (jj < np->used)) {
+        if ((cp->points[ii] >> 2) < (np->points[jj] >> 2)) {
+            ++ii;
+        } else if ((cp->points[ii] >> 2) > (np->points[jj] >> 2)) {
+            ++jj;
+        } else if (cp->points[ii] == np->points[jj]) {
+            return cp->points[ii];
+        } else {
+            ++ii;
+            ++jj;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Write the records from a chunk whose messages end after one offset and
+ * no later than another.
+ * @param cp points to the chunk.
+ * @param from is the first offset.
+ * @param to is the last offset.
+ * @param binary is !0 for the binary trace, 0 for the CSV.
+ * @param sequencep points to the sequence number of the last record.
+ * @return 0 for success or <0 if an error occurred.
+ */
+static int emit(chunk_t * cp, uint64_t from, uint64_t to, int binary, int64_t * sequencep)
+{
+    size_t ii = 0;
+    trace_record_t * rp = (trace_record_t *)0;
+    char buffer[TRACE_LINE];
+    ssize_t length = 0;
+
+    for (ii = 0; ii < cp->count; ++ii) {
+        if (cp->decoded[ii].end <= from) {
+            continue;
+        } else if (cp->decoded[ii].end > to) {
+            break;
+        } else {
+            /* Do nothing. */
+        }
+        rp = &(cp->decoded[ii].record);
+        trace_record_set(rp, TRACE_NUM, ++(*sequencep), TRACE_INTEGER);
+        if (binary) {
+            if (fwrite(rp, sizeof(*rp), 1, stdout) < 1) {
+                errno = EIO;
+                perror(Program);
+                return -1;
+            }
+        } else if ((length = trace_format(rp, buffer, sizeof(buffer))) < 0) {
+            perror(Program);
+            return -1;
+        } else if (fwrite(buffer, length, 1, stdout) < 1) {
+            errno = EIO;
+            perror(Program);
+            return -1;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Release what decoding a chunk produced.
+ * @param cp points to the chunk.
+ */
+static void release(chunk_t * cp)
+{
+    free(cp->decoded);
+    cp->decoded = (decoded_t *)0;
+    cp->count = 0;
+    cp->size = 0;
+    free(cp->points);
+    cp->points = (uint64_t *)0;
+    cp->used = 0;
+    cp->allocated = 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int opt = -1;
+    int debug = 0;
+    int verbose = 0;
+    int binary = 0;
+    int error = 0;
+    char * end = (char *)0;
+    long threads = 0;
+    long long chunk = CHUNK;
+    void * base = (void *)0;
+    capture_image_t image;
+    worker_t * workers = (worker_t *)0;
+    chunk_t * cp = (chunk_t *)0;
+    chunk_t * here = (chunk_t *)0;
+    trace_header_t header;
+    capture_record_t record;
+    size_t ii = 0;
+    uint64_t offset = 0;
+    uint64_t from = 0;
+    uint64_t point = 0;
+    uint64_t joined = 0;
+    uint64_t resyncs = 0;
+    uint64_t octets = 0;
+    int64_t sequence = 0;
+    int64_t start = 0;
+    int64_t elapsed = 0;
+    int64_t cpu = 0;
+    int rc = 0;
+    int xc = 0;
+
+    extern char * optarg;
+    extern int optind;
+    extern int opterr;
+    extern int optopt;
+
+    Program = ((Program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : Program + 1;
+
+    if (gethostname(Name, sizeof(Name)) < 0) {
+        strncpy(Name, "localhost", sizeof(Name));
+    }
+    Name[sizeof(Name) - 1] = '\0';
+
+    threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+    while ((opt = getopt(argc, argv, "?3N:c:dj:v")) >= 0) {
+        switch (opt) {
+        case '?':
+            fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -3 ] [ -j THREADS ] [ -c BYTES ] [ -N NAME ]\n", Program);
+            fprintf(stderr, "       -?          Print this menu.\n");
+            fprintf(stderr, "       -3          Write the binary trace instead of the CSV.\n");
+            fprintf(stderr, "       -N NAME     Use NAME instead of the host name in the trace.\n");
+            fprintf(stderr, "       -c BYTES    Decode chunks of BYTES bytes, at least %d.\n", OVERLAP * 2);
+            fprintf(stderr, "       -d          Display debug output.\n");
+            fprintf(stderr, "       -j THREADS  Decode with THREADS threads instead of one per core.\n");
+            fprintf(stderr, "       -v          Display verbose output including throughput.\n");
+            return 0;
+            break;
+        case '3':
+            binary = !0;
+            break;
+        case 'N':
+            strncpy(Name, optarg, sizeof(Name));
+            Name[sizeof(Name) - 1] = '\0';
+            break;
+        case 'c':
+            chunk = strtoll(optarg, &end, 0);
+            if ((end == (char *)0) || (*end != '\0') || (chunk < (OVERLAP * 2))) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            }
+            break;
+        case 'd':
+            debug = !0;
+            break;
+        case 'j':
+            threads = strtol(optarg, &end, 0);
+            if ((end == (char *)0) || (*end != '\0') || (threads <= 0)) {
+                errno = EINVAL;
+                perror(optarg);
+                error = !0;
+            }
+            break;
+        case 'v':
+            verbose = !0;
+            break;
+        default:
+            error = !0;
+            break;
+        }
+    }
+
+    if (error) {
+        fprintf(stderr, "usage: %s [ -? ] [ -d ] [ -v ] [ -3 ] [ -j THREADS ] [ -c BYTES ] [ -N NAME ]\n", Program);
+        return 1;
+    }
+
+    if (threads <= 0) {
+        threads = 1;
+    }
+
+    start = common_clock(CLOCK_MONOTONIC);
+
+    /*
+     * Input that is a file is mapped into memory; anything else, like a
+     * pipe, is read into memory.
+     */
+
+    if (capture_load(&image, stdin, MADV_WILLNEED) == (capture_image_t *)0) {
+        perror(Program);
+        return 1;
+    }
+
+    base = image.base;
+    Length = image.length;
+
+    Base = (const uint8_t *)base;
+
+    hazer_initialize();
+    yodel_initialize();
+    tumbleweed_initialize();
+    calico_initialize();
+
+    /*
+     * A raw stream is split into chunks of the same size, the last of which
+     * takes whatever is left over. A capture is split at the first message
+     * boundary after each chunk's worth of messages.
+     */
+
+    if (Length < sizeof(capture_header_t)) {
+        /* Do nothing. */
+    } else if (memcmp(Base, CAPTURE_MAGIC, sizeof(Header->magic)) != 0) {
+        /* Do nothing. */
+    } else if ((Header = capture_check(Base, Length)) == (const capture_header_t *)0) {
+        perror(Program);
+        xc = 1;
+    } else {
+        /* Do nothing. */
+    }
+
+    do {
+
+        if (xc != 0) {
+            break;
+        }
+
+        if (Header == (const capture_header_t *)0) {
+            Count = (Length / chunk) + ((Length < chunk) ? 1 : 0);
+        } else {
+            Count = 0;
+            offset = sizeof(capture_header_t);
+            from = offset;
+            while (capture_next(Base, Length, &offset, &record) != (const void *)0) {
+                if ((offset - from) >= chunk) {
+                    Count += 1;
+                    from = offset;
+                }
+            }
+            Count += 1;
+        }
+
+        if ((Chunks = (chunk_t *)calloc(Count, sizeof(chunk_t))) == (chunk_t *)0) {
+            perror(Program);
+            xc = 1;
+            break;
+        }
+
+        if (Header == (const capture_header_t *)0) {
+            for (ii = 0; ii < Count; ++ii) {
+                Chunks[ii].begin = ii * chunk;
+                Chunks[ii].end = (ii < (Count - 1)) ? ((ii + 1) * chunk) : Length;
+                Chunks[ii].kind = FRAMER_SCANNING;
+            }
+        } else {
+            ii = 0;
+            offset = sizeof(capture_header_t);
+            Chunks[ii].begin = offset;
+            while (capture_next(Base, Length, &offset, &record) != (const void *)0) {
+                if ((offset - Chunks[ii].begin) >= chunk) {
+                    Chunks[ii].end = offset;
+                    Chunks[++ii].begin = offset;
+                }
+            }
+            Chunks[ii].end = Length;
+        }
+
+        if (threads > Count) {
+            threads = Count;
+        }
+
+        if (debug) {
+            fprintf(stderr, "%s: length %zu chunks %zu threads %ld %s\n", Program, Length, Count, threads, (Header != (const capture_header_t *)0) ? "capture" : "raw");
+        }
+
+        /*
+         * No more chunks are decoded ahead of the one being written than
+         * there are threads to decode them twice over, which bounds how much
+         * memory the records waiting to be written take.
+         */
+
+        Window = threads * 2;
+
+        if ((workers = (worker_t *)calloc(threads, sizeof(worker_t))) == (worker_t *)0) {
+            perror(Program);
+            xc = 1;
+            break;
+        }
+
+        for (ii = 0; ii < threads; ++ii) {
+            if ((rc = pthread_create(&(workers[ii].thread), (pthread_attr_t *)0, work, &(workers[ii]))) != 0) {
+                errno = rc;
+                perror(Program);
+                threads = ii;
+                xc = 1;
+                break;
+            }
+        }
+
+        if (xc != 0) {
+            break;
+        }
+
+        if (binary) {
+            fwrite(trace_header_init(&header), sizeof(header), 1, stdout);
+        } else {
+            for (ii = 0; ii < TRACE_COLUMNS; ++ii) {
+                if (ii > 0) { fputc(' ', stdout); }
+                fputs(trace_heading(ii), stdout);
+                if (ii < (TRACE_COLUMNS - 1)) { fputc(',', stdout); } else { fputc('\n', stdout); }
+            }
+        }
+
+        /*
+         * The chunk being written is decoded correctly from the offset at
+         * which it was joined to the one before it. It is joined to the one
+         * after it at the first point after its end at which they are both
+         * in the same state. If there is no such point in the overlap, the
+         * chunk after it is decoded again from the last point this one
+         * reached, which is slower but still correct.
+         */
+
+        from = 0;
+        joined = (0 << 2) | FRAMER_SCANNING;
+
+        for (ii = 0; ii < Count; ++ii) {
+
+            cp = &(Chunks[ii]);
+            await(cp);
+
+            if (cp->failed) {
+                xc = 1;
+                break;
+            }
+
+            if ((ii == (Count - 1)) || (cp->limit >= Length)) {
+                point = UINT64_MAX;
+            } else if (Header != (const capture_header_t *)0) {
+                point = cp->end;
+                joined = point << 2;
+            } else {
+                here = &(Chunks[ii + 1]);
+                await(here);
+                if ((point = join(cp, here, from)) != 0) {
+                    joined = point;
+                    point >>= 2;
+                } else {
+                    point = cp->points[cp->used - 1];
+                    if ((point >> 2) < from) {
+                        point = joined;
+                    }
+                    joined = point;
+                    release(here);
+                    here->begin = point >> 2;
+                    here->kind = point & 0x3;
+                    if (here->end < here->begin) {
+                        here->end = here->begin;
+                    }
+                    scan(here);
+                    if (here->failed) {
+                        xc = 1;
+                        break;
+                    }
+                    point >>= 2;
+                    resyncs += 1;
+                }
+            }
+
+            if (debug) {
+                fprintf(stderr, "%s: chunk %zu begin %llu end %llu limit %llu records %zu from %llu to %llu\n", Program, ii, (unsigned long long)cp->begin, (unsigned long long)cp->end, (unsigned long long)cp->limit, cp->count, (unsigned long long)from, (unsigned long long)point);
+            }
+
+            if (emit(cp, from, point, binary, &sequence) < 0) {
+                xc = 1;
+                break;
+            }
+
+            release(cp);
+            from = point;
+
+            pthread_mutex_lock(&Mutex);
+            Merged = ii + 1;
+            pthread_cond_broadcast(&Condition);
+            pthread_mutex_unlock(&Mutex);
+
+            if (point == UINT64_MAX) {
+                break;
+            }
+
+        }
+
+    } while (0);
+
+    pthread_mutex_lock(&Mutex);
+    Stopping = !0;
+    pthread_cond_broadcast(&Condition);
+    pthread_mutex_unlock(&Mutex);
+
+    if (workers != (worker_t *)0) {
+        for (ii = 0; ii < threads; ++ii) {
+            pthread_join(workers[ii].thread, (void **)0);
+        }
+    }
+
+    if (fflush(stdout) == EOF) {
+        perror(Program);
+        xc = 1;
+    }
+
+    elapsed = common_clock(CLOCK_MONOTONIC) - start;
+
+    if (verbose) {
+        for (ii = 0; ii < threads; ++ii) {
+            fprintf(stderr, "%s: thread %zu chunks %llu bytes %llu cpu %.3lfs %.1lfMB/s\n", Program, ii,
+                (unsigned long long)workers[ii].chunks, (unsigned long long)workers[ii].octets, workers[ii].cpu / 1000000000.0,
+                (workers[ii].cpu > 0) ? (workers[ii].octets * 1000.0 / workers[ii].cpu) : 0.0);
+            octets += workers[ii].octets;
+            cpu += workers[ii].cpu;
+        }
+        fprintf(stderr, "%s: bytes %zu records %lld resyncs %llu threads %ld elapsed %.3lfs %.1lfMB/s per core %.1lfMB/s\n", Program,
+            Length, (long long)sequence, (unsigned long long)resyncs, threads, elapsed / 1000000000.0,
+            (elapsed > 0) ? (Length * 1000.0 / elapsed) : 0.0, (cpu > 0) ? (octets * 1000.0 / cpu) : 0.0);
+    }
+
+    if (Chunks != (chunk_t *)0) {
+        for (ii = 0; ii < Count; ++ii) {
+            release(&(Chunks[ii]));
+        }
+        free(Chunks);
+    }
+
+    free(workers);
+
+    calico_finalize();
+    tumbleweed_finalize();
+    yodel_finalize();
+    hazer_finalize();
+
+    capture_unload(&image);
+
+    return xc;
+}
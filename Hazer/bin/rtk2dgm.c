@@ -23,14 +23,20 @@
  * The command line flags match what gpstool uses for the same parameters.
  * The 'Y' is supposed to remind you of the word "surveyor".
  *
+ * If a subscription is given, each keepalive is replaced with a control
+ * message carrying it, asking the router to forward only the listed RTCM
+ * message numbers, each no more often than its interval in seconds.
+ *
  * USAGE
  *
- * rtk2dgm [ -Y HOST:PORT ] [ -y SECONDS ]
+ * rtk2dgm [ -Y HOST:PORT ] [ -s NUMBER[:SECONDS][,...] ] [ -y SECONDS ]
  * 
  * EXAMPLE
  *
  * rtk2dgm -Y eljefe:tumbleweed -y 1
  *
+ * rtk2dgm -Y eljefe:tumbleweed -y 1 -s 1005:10,1074,1084,1094,1230:10
+ *
  * REFERENCES
  *
  * https://github.com/coverclock/com-diag-codex
@@ -50,6 +56,7 @@
 #include "com/diag/diminuto/diminuto_terminator.h"
 #include "com/diag/diminuto/diminuto_time.h"
 #include "com/diag/diminuto/diminuto_types.h"
+#include "com/diag/hazer/subscription.h"
 #include "com/diag/hazer/tumbleweed.h"
 #include <errno.h>
 #include <stdio.h>
@@ -86,7 +93,7 @@ typedef uint32_t sequence_t;
 
 typedef struct Request {
     sequence_t header;
-    const uint8_t payload[6];
+    uint8_t payload[SUBSCRIPTION_LONGEST];
 } request_t;
 
 typedef struct Response {
@@ -113,6 +120,9 @@ int main(int argc, char * argv[])
     diminuto_ticks_t then = 0;
     diminuto_ticks_t now = 0;
     request_t request = { 0, { 0xd3, 0x00, 0x00, 0x47, 0xea, 0x4b } };
+    size_t length = sizeof(request.header) + 6;
+    subscription_t subscription = SUBSCRIPTION_INITIALIZER;
+    ssize_t encoded = 0;
     response_t response = { 0, { 0, } };
     sequence_t sending = 0;
     sequence_t received = 0;
@@ -145,7 +155,7 @@ int main(int argc, char * argv[])
 
         program = ((program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : program + 1;
 
-        while ((opt = getopt(argc, argv, "?Y:t:y:")) >= 0) {
+        while ((opt = getopt(argc, argv, "?Y:s:t:y:")) >= 0) {
             switch (opt) {
             case 'Y':
                 if (diminuto_ipc_endpoint(optarg, &endpoint) != 0) {
@@ -178,6 +188,17 @@ int main(int argc, char * argv[])
                     break;
                 }
                 break;
+            case 's':
+                if (subscription_parse(optarg, &subscription) < 0) {
+                    diminuto_perror(optarg);
+                    error = true;
+                } else if ((encoded = subscription_encode(&subscription, &request.payload, sizeof(request.payload))) < 0) {
+                    diminuto_perror(optarg);
+                    error = true;
+                } else {
+                    length = sizeof(request.header) + encoded;
+                }
+                break;
             case 't':
                 number = strtol(optarg, &end, 0);
                 if ((end == (char *)0) || (*end != '\0') || (number <= 0)) {
@@ -199,7 +220,7 @@ int main(int argc, char * argv[])
                 }
                 break;
             default:
-                fprintf(stderr, "usage: %s [ -? ] [ -Y HOST:PORT ] [ -t MILLISECONDS ] [ -y SECONDS ]\n", program);
+                fprintf(stderr, "usage: %s [ -? ] [ -Y HOST:PORT ] [ -s NUMBER[:SECONDS][,...] ] [ -t MILLISECONDS ] [ -y SECONDS ]\n", program);
                 error = true;
                 break;
             }
@@ -236,7 +257,7 @@ int main(int argc, char * argv[])
 
         then = diminuto_time_elapsed() - period;
 
-        diminuto_contract(tumbleweed_validate(&request.payload, sizeof(request.payload)));
+        diminuto_contract(tumbleweed_validate(&request.payload, length - sizeof(request.header)) == (length - sizeof(request.header)));
 
         /*
          * WORK LOOP
@@ -300,8 +321,8 @@ int main(int argc, char * argv[])
                     fprintf(stderr, "%s: port! (%d!=%d)\n", program, port, endpoint.udp);
                     error = true;
                 }
-                if (bytes <= sizeof(request_t)) { /* Smallest RTCM message. */
-                    fprintf(stderr, "%s: size! (%zd<=%zu)\n", program, bytes, sizeof(request_t));
+                if (bytes <= (sizeof(sequence_t) + TUMBLEWEED_RTCM_SHORTEST)) { /* Smallest RTCM message. */
+                    fprintf(stderr, "%s: size! (%zd<=%zu)\n", program, bytes, sizeof(sequence_t) + TUMBLEWEED_RTCM_SHORTEST);
                     error = true;
                 }
                 validity = tumbleweed_validate(&response.payload, bytes - sizeof(sequence_t));
@@ -337,12 +358,12 @@ int main(int argc, char * argv[])
                 request.header = htobe32(sending);
                 switch (endpoint.type) {
                 case DIMINUTO_IPC_TYPE_IPV4:
-                    bytes = diminuto_ipc4_datagram_send(sock, &request, sizeof(request), endpoint.ipv4, endpoint.udp);
-                    diminuto_contract(bytes == sizeof(request));
+                    bytes = diminuto_ipc4_datagram_send(sock, &request, length, endpoint.ipv4, endpoint.udp);
+                    diminuto_contract(bytes == length);
                     break;
                 case DIMINUTO_IPC_TYPE_IPV6:
-                    bytes = diminuto_ipc6_datagram_send(sock, &request, sizeof(request), endpoint.ipv6, endpoint.udp);
-                    diminuto_contract(bytes == sizeof(request));
+                    bytes = diminuto_ipc6_datagram_send(sock, &request, length, endpoint.ipv6, endpoint.udp);
+                    diminuto_contract(bytes == length);
                     break;
                 default:
                     diminuto_panic();
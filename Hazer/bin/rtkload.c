@@ -0,0 +1,504 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Simulates many Tumbleweed rovers, and a base, against a router.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * Generates load for a Tumbleweed router (rtktool). Each simulated rover
+ * is a UDP socket of its own, so the router sees it as a distinct client,
+ * that sends the same empty RTK keepalive that rtk2dgm sends, with its own
+ * Hazer datagram sequence number, every period; the keepalives of all of
+ * the rovers are staggered evenly across the period. Optionally, a
+ * simulated base sends a correction at a fixed rate; each correction is
+ * a valid RTCM message that carries the time at which it was sent, so that
+ * when the router forwards it to the rovers the latency through the router
+ * can be measured. Once a second a line of statistics is emitted to standard
+ * error: the number of keepalives and corrections sent, the number of
+ * corrections received by all rovers together (ideally the number of
+ * rovers times the number of corrections), the number lost or out of order,
+ * and the minimum, average, and maximum latency in microseconds. Since the
+ * rovers register with the router as they send their first keepalives, the
+ * full load is reached only after the first period.
+ *
+ * Each rover needs a file descriptor, so the soft limit on open files is
+ * raised to the hard limit if necessary.
+ *
+ * USAGE
+ *
+ * rtkload [ -Y HOST:PORT ] [ -n ROVERS ] [ -y SECONDS ] [ -b HERTZ ] [ -z BYTES ] [ -s SECONDS ] [ -t MILLISECONDS ]
+ *
+ * EXAMPLE
+ *
+ * rtktool -p :21010 -t 30 -n 16384 &
+ *
+ * rtkload -Y localhost:21010 -n 10000 -y 25 -b 1 -s 120
+ */
+
+/*******************************************************************************
+ * DEPENDENCIES
+ ******************************************************************************/
+
+#include "com/diag/diminuto/diminuto_assert.h"
+#include "com/diag/diminuto/diminuto_frequency.h"
+#include "com/diag/diminuto/diminuto_ipc.h"
+#include "com/diag/diminuto/diminuto_ipc4.h"
+#include "com/diag/diminuto/diminuto_ipc6.h"
+#include "com/diag/diminuto/diminuto_log.h"
+#include "com/diag/diminuto/diminuto_terminator.h"
+#include "com/diag/diminuto/diminuto_time.h"
+#include "com/diag/diminuto/diminuto_types.h"
+#include "com/diag/hazer/datagram.h"
+#include "com/diag/hazer/tumbleweed.h"
+#include <errno.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+/*
+ * CONSTANTS
+ */
+
+enum Constants {
+    EVENTS      = 1024,     /* Maximum events per epoll_wait(2). */
+    RESERVED    = 16,       /* File descriptors not used by rovers. */
+    NUMBER      = 4095,     /* RTCM message number of the corrections. */
+    OVERHEAD    = TUMBLEWEED_RTCM_SUMMED + TUMBLEWEED_RTCM_NUMBER + sizeof(uint64_t) + TUMBLEWEED_RTCM_CRC,
+};
+
+/*
+ * TYPES
+ */
+
+typedef struct Rover {
+    diminuto_sticks_t due;          /* When the next keepalive is sent. */
+    datagram_sequence_t sending;    /* Sequence number of keepalives. */
+    datagram_sequence_t expected;   /* Expected sequence of corrections. */
+    int sock;
+    int first;
+} rover_t;
+
+typedef struct Statistics {
+    unsigned long keepalives;
+    unsigned long corrections;
+    unsigned long received;
+    unsigned int missing;
+    unsigned int outoforder;
+    unsigned long invalid;
+    diminuto_sticks_t shortest;
+    diminuto_sticks_t longest;
+    diminuto_sticks_t total;
+} statistics_t;
+
+/*
+ * HELPERS
+ */
+
+static ssize_t sendto_router(const diminuto_ipc_endpoint_t * ep, int sock, const void * buffer, size_t size)
+{
+    ssize_t bytes = -1;
+
+    switch (ep->type) {
+    case DIMINUTO_IPC_TYPE_IPV4:
+        bytes = diminuto_ipc4_datagram_send(sock, buffer, size, ep->ipv4, ep->udp);
+        break;
+    case DIMINUTO_IPC_TYPE_IPV6:
+        bytes = diminuto_ipc6_datagram_send(sock, buffer, size, ep->ipv6, ep->udp);
+        break;
+    default:
+        diminuto_panic();
+        break;
+    }
+
+    return bytes;
+}
+
+/*
+ * MAIN
+ */
+
+int main(int argc, char * argv[])
+{
+    extern char * optarg;
+    int xc = 1;
+    const char * program = (const char *)0;
+    int opt = -1;
+    bool error = false;
+    char * end = (char *)0;
+    const char * endpointname = (const char *)0;
+    long number = 0;
+    long rovers = 1;
+    long bytes = 128;
+    long duration = 0;
+    long hertz = 0;
+    diminuto_sticks_t frequency = 0;
+    diminuto_sticks_t period  = 25000000000LL; /* 25s (from SIP) */
+    diminuto_sticks_t interval = 0;
+    long timeout = 10; /* milliseconds */
+    diminuto_sticks_t start = 0;
+    diminuto_sticks_t now = 0;
+    diminuto_sticks_t report = 0;
+    diminuto_sticks_t correct = 0;
+    diminuto_sticks_t latency = 0;
+    diminuto_sticks_t stamp = 0;
+    static const uint8_t KEEPALIVE[] = { 0xd3, 0x00, 0x00, 0x47, 0xea, 0x4b };
+    static datagram_buffer_t request;
+    static datagram_buffer_t response;
+    static datagram_buffer_t keepalive;
+    datagram_sequence_t sending = 0;
+    diminuto_ipc_endpoint_t endpoint = { 0, };
+    rover_t * rover = (rover_t *)0;
+    rover_t * rp = (rover_t *)0;
+    statistics_t statistics = { 0, };
+    statistics_t totals = { 0, };
+    struct epoll_event event = { 0, };
+    struct epoll_event events[EVENTS];
+    struct rlimit limit = { 0, };
+    uint8_t * bp = (uint8_t *)0;
+    size_t length = 0;
+    ssize_t size = -1;
+    ssize_t validity = -1;
+    long cursor = 0;
+    long ii = 0;
+    int nfds = 0;
+    int epfd = -1;
+    int base = -1;
+    int rc = 0;
+    diminuto_endpoint_buffer_t buffer = { '\0', };
+
+    do {
+
+        diminuto_log_setmask();
+
+        /*
+         * PARSE
+         */
+
+        program = ((program = strrchr(argv[0], '/')) == (char *)0) ? argv[0] : program + 1;
+
+        while ((opt = getopt(argc, argv, "?Y:b:n:s:t:y:z:")) >= 0) {
+            switch (opt) {
+            case 'Y':
+                if (diminuto_ipc_endpoint(optarg, &endpoint) != 0) {
+                    diminuto_perror(optarg);
+                    error = true;
+                } else if (
+                        ((endpoint.type != DIMINUTO_IPC_TYPE_IPV4) &&
+                            (endpoint.type != DIMINUTO_IPC_TYPE_IPV6)) ||
+                        ((diminuto_ipc4_is_unspecified(&endpoint.ipv4) &&
+                            diminuto_ipc6_is_unspecified(&endpoint.ipv6))) ||
+                        (endpoint.udp == 0)) {
+                    errno = EINVAL;
+                    diminuto_perror(optarg);
+                    error = true;
+                } else {
+                    endpointname = optarg;
+                }
+                break;
+            case 'b':
+                hertz = strtol(optarg, &end, 0);
+                if ((end == (char *)0) || (*end != '\0') || (hertz < 0)) {
+                    errno = EINVAL;
+                    diminuto_perror(optarg);
+                    error = true;
+                }
+                break;
+            case 'n':
+                rovers = strtol(optarg, &end, 0);
+                if ((end == (char *)0) || (*end != '\0') || (rovers < 0)) {
+                    errno = EINVAL;
+                    diminuto_perror(optarg);
+                    error = true;
+                }
+                break;
+            case 's':
+                duration = strtol(optarg, &end, 0);
+                if ((end == (char *)0) || (*end != '\0') || (duration < 0)) {
+                    errno = EINVAL;
+                    diminuto_perror(optarg);
+                    error = true;
+                }
+                break;
+            case 't':
+                timeout = strtol(optarg, &end, 0);
+                if ((end == (char *)0) || (*end != '\0') || (timeout <= 0)) {
+                    errno = EINVAL;
+                    diminuto_perror(optarg);
+                    error = true;
+                }
+                break;
+            case 'y':
+                number = strtol(optarg, &end, 0);
+                if ((end == (char *)0) || (*end != '\0') || (number <= 0)) {
+                    errno = EINVAL;
+                    diminuto_perror(optarg);
+                    error = true;
+                } else {
+                    period = diminuto_frequency_units2ticks(number, 1 /* Hz: seconds */);
+                }
+                break;
+            case 'z':
+                bytes = strtol(optarg, &end, 0);
+                if ((end == (char *)0) || (*end != '\0') || (bytes < OVERHEAD) || (bytes > TUMBLEWEED_RTCM_LONGEST)) {
+                    errno = EINVAL;
+                    diminuto_perror(optarg);
+                    error = true;
+                }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [ -? ] [ -Y HOST:PORT ] [ -n ROVERS ] [ -y SECONDS ] [ -b HERTZ ] [ -z BYTES ] [ -s SECONDS ] [ -t MILLISECONDS ]\n", program);
+                error = true;
+                break;
+            }
+        }
+
+        if (error) {
+            /* Do nothing. */
+        } else if (endpointname != (const char *)0) {
+            /* Do nothing. */
+        } else {
+            errno = EINVAL;
+            diminuto_perror("-Y HOST:PORT");
+            error = true;
+        }
+
+        if (error) {
+            break;
+        }
+
+        frequency = diminuto_frequency();
+        if (hertz > 0) {
+            interval = frequency / hertz;
+        }
+
+        fprintf(stderr, "%s: endpoint=\"%s\"=%s rovers=%ld period=%lldticks base=%ldHz bytes=%ld duration=%lds\n", program, endpointname, diminuto_ipc_endpoint2string(&endpoint, buffer, sizeof(buffer)), rovers, (diminuto_lld_t)period, hertz, bytes, duration);
+
+        /*
+         * INITIALIZE
+         */
+
+        rc = getrlimit(RLIMIT_NOFILE, &limit);
+        diminuto_contract(rc == 0);
+        if (limit.rlim_cur < (rovers + RESERVED)) {
+            limit.rlim_cur = limit.rlim_max;
+            if (setrlimit(RLIMIT_NOFILE, &limit) < 0) {
+                diminuto_perror("setrlimit");
+            }
+        }
+        if (limit.rlim_cur < (rovers + RESERVED)) {
+            errno = EMFILE;
+            diminuto_perror("RLIMIT_NOFILE");
+            break;
+        }
+
+        rc = diminuto_terminator_install(0);
+        diminuto_contract(rc >= 0);
+
+        epfd = epoll_create1(0);
+        diminuto_contract(epfd >= 0);
+
+        if (rovers > 0) {
+            rover = (rover_t *)calloc(rovers, sizeof(rover_t));
+            diminuto_contract(rover != (rover_t *)0);
+        }
+
+        start = diminuto_time_elapsed();
+
+        for (ii = 0; ii < rovers; ++ii) {
+            rp = &(rover[ii]);
+            rp->sock = (endpoint.type == DIMINUTO_IPC_TYPE_IPV4) ? diminuto_ipc4_datagram_peer(0) : diminuto_ipc6_datagram_peer(0);
+            diminuto_contract(rp->sock >= 0);
+            rc = diminuto_ipc_set_nonblocking(rp->sock, !0);
+            diminuto_contract(rc >= 0);
+            event.events = EPOLLIN;
+            event.data.u32 = ii;
+            rc = epoll_ctl(epfd, EPOLL_CTL_ADD, rp->sock, &event);
+            diminuto_contract(rc == 0);
+            rp->due = start + ((period * ii) / rovers);
+            rp->first = !0;
+        }
+
+        if (interval > 0) {
+            base = (endpoint.type == DIMINUTO_IPC_TYPE_IPV4) ? diminuto_ipc4_datagram_peer(0) : diminuto_ipc6_datagram_peer(0);
+            diminuto_contract(base >= 0);
+        }
+
+        /*
+         * The correction is an RTCM frame of the requested size whose
+         * message number is followed by the time it was sent.
+         */
+
+        bp = request.payload.data;
+        length = bytes - TUMBLEWEED_RTCM_SHORTEST;
+        memset(bp, 0, bytes);
+        bp[0] = 0xd3;
+        bp[1] = (length >> 8) & 0x03;
+        bp[2] = length & 0xff;
+        bp[3] = (NUMBER >> 4) & 0xff;
+        bp[4] = (NUMBER << 4) & 0xf0;
+
+        memcpy(keepalive.payload.data, KEEPALIVE, sizeof(KEEPALIVE));
+
+        report = start + frequency;
+        correct = start;
+
+        /*
+         * WORK LOOP
+         */
+
+        for (;;) {
+
+            /*
+             * WAIT
+             */
+
+            nfds = epoll_wait(epfd, events, EVENTS, timeout);
+            diminuto_contract((nfds >= 0) || ((nfds < 0) && (errno == EINTR)));
+
+            /*
+             * CHECK
+             */
+
+            if (diminuto_terminator_check()) {
+                xc = 0;
+                break;
+            }
+
+            now = diminuto_time_elapsed();
+
+            /*
+             * RECEIVE
+             */
+
+            for (ii = 0; ii < nfds; ++ii) {
+                rp = &(rover[events[ii].data.u32]);
+                while ((size = recv(rp->sock, &response, sizeof(response), 0)) > 0) {
+                    if (size <= sizeof(response.header)) {
+                        statistics.invalid += 1;
+                        continue;
+                    }
+                    if (rp->first) {
+                        rp->expected = ntohl(response.header.sequence);
+                        rp->first = 0;
+                    }
+                    if ((validity = datagram_validate(&(rp->expected), &(response.header), size, &statistics.outoforder, &statistics.missing)) < 0) {
+                        continue;
+                    }
+                    if ((validity = tumbleweed_validate(response.payload.data, validity)) < OVERHEAD) {
+                        statistics.invalid += 1;
+                        continue;
+                    }
+                    memcpy(&stamp, &(response.payload.data[TUMBLEWEED_RTCM_SUMMED + TUMBLEWEED_RTCM_NUMBER]), sizeof(stamp));
+                    latency = now - stamp;
+                    if ((statistics.received == 0) || (latency < statistics.shortest)) { statistics.shortest = latency; }
+                    if ((statistics.received == 0) || (latency > statistics.longest)) { statistics.longest = latency; }
+                    statistics.total += latency;
+                    statistics.received += 1;
+                }
+                diminuto_contract((size >= 0) || (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == ECONNREFUSED));
+            }
+
+            /*
+             * KEEPALIVES
+             *
+             * The rovers are due in round-robin order, so only those that
+             * are actually due are visited.
+             */
+
+            for (ii = 0; (ii < rovers) && (rover[cursor].due <= now); ++ii) {
+                rp = &(rover[cursor]);
+                datagram_stamp(&(keepalive.header), &(rp->sending));
+                size = sendto_router(&endpoint, rp->sock, &keepalive, sizeof(keepalive.header) + sizeof(KEEPALIVE));
+                diminuto_contract(size == (sizeof(keepalive.header) + sizeof(KEEPALIVE)));
+                statistics.keepalives += 1;
+                rp->due += period;
+                cursor = (cursor + 1) % rovers;
+            }
+
+            /*
+             * CORRECTIONS
+             */
+
+            if ((base >= 0) && (now >= correct)) {
+                datagram_stamp(&(request.header), &sending);
+                stamp = diminuto_time_elapsed();
+                memcpy(&(bp[TUMBLEWEED_RTCM_SUMMED + TUMBLEWEED_RTCM_NUMBER]), &stamp, sizeof(stamp));
+                diminuto_contract(tumbleweed_checksum_buffer(bp, bytes, &(bp[bytes - 3]), &(bp[bytes - 2]), &(bp[bytes - 1])) != (const void *)0);
+                size = sendto_router(&endpoint, base, &request, sizeof(request.header) + bytes);
+                diminuto_contract(size == (sizeof(request.header) + bytes));
+                statistics.corrections += 1;
+                correct += interval;
+            }
+
+            /*
+             * REPORT
+             */
+
+            if (now >= report) {
+                fprintf(stderr, "%s: %lds keepalives=%lu corrections=%lu received=%lu missing=%u outoforder=%u invalid=%lu latency=%lld/%lld/%lldus\n",
+                    program,
+                    (long)((now - start) / frequency),
+                    statistics.keepalives,
+                    statistics.corrections,
+                    statistics.received,
+                    statistics.missing,
+                    statistics.outoforder,
+                    statistics.invalid,
+                    (diminuto_lld_t)((statistics.shortest * 1000000LL) / frequency),
+                    (diminuto_lld_t)((statistics.received > 0) ? ((statistics.total / statistics.received) * 1000000LL) / frequency : 0),
+                    (diminuto_lld_t)((statistics.longest * 1000000LL) / frequency));
+                totals.keepalives += statistics.keepalives;
+                totals.corrections += statistics.corrections;
+                totals.received += statistics.received;
+                totals.missing += statistics.missing;
+                totals.outoforder += statistics.outoforder;
+                totals.invalid += statistics.invalid;
+                memset(&statistics, 0, sizeof(statistics));
+                report += frequency;
+            }
+
+            if ((duration > 0) && ((now - start) >= (duration * frequency))) {
+                xc = 0;
+                break;
+            }
+
+        }
+
+        fprintf(stderr, "%s: total keepalives=%lu corrections=%lu received=%lu expected=%lu missing=%u outoforder=%u invalid=%lu\n", program, totals.keepalives, totals.corrections, totals.received, totals.corrections * rovers, totals.missing, totals.outoforder, totals.invalid);
+
+    } while (false);
+
+    /*
+     * FINALIZE
+     */
+
+    if (base >= 0) {
+        base = diminuto_ipc_close(base);
+        diminuto_contract(base < 0);
+    }
+
+    for (ii = 0; (rover != (rover_t *)0) && (ii < rovers); ++ii) {
+        if (rover[ii].sock >= 0) {
+            rover[ii].sock = diminuto_ipc_close(rover[ii].sock);
+        }
+    }
+
+    free(rover);
+
+    if (epfd >= 0) {
+        (void)close(epfd);
+    }
+
+    exit(xc);
+}
@@ -0,0 +1,163 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is a benchmark of the Render module against printf(3).
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ *
+ * ABSTRACT
+ *
+ * This is an experiment to measure how much faster it is to render the
+ * fixed point fields of a CSV trace record with the Render module, as
+ * trace_format() does, than with snprintf(3) a field at a time, as
+ * emit_trace() in gpstool used to. Both produce the same lines, which are
+ * compared as they are formatted.
+ *
+ * USAGE
+ *
+ * renderbenchmark [ RECORDS ]
+ *
+ * EXAMPLE
+ *
+ * $ renderbenchmark 1000000
+ * records 1000000 snprintf 3.662us render 0.954us speedup 3.84
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "com/diag/hazer/trace.h"
+
+/**
+ * These are the digits of each column of the trace record, as gpstool
+ * emits them.
+ */
+static const int DIGITS[TRACE_COLUMNS] = {
+    TRACE_INTEGER, TRACE_INTEGER, TRACE_INTEGER, TRACE_INTEGER, TRACE_INTEGER,
+    9, 9, 9, 9, 4, 4, 4, 4, 6, 9, 5, 5, 5, 5, 5, 5, TRACE_INTEGER, 4,
+};
+
+/**
+ * Format a trace record the way gpstool used to, with snprintf(3) a field
+ * at a time.
+ * @param rp points to the record.
+ * @param buffer points to the buffer.
+ * @param size is the size of the buffer.
+ * @return the length of the line.
+ */
+static size_t reference(const trace_record_t * rp, char * buffer, size_t size)
+{
+    size_t length = 0;
+    int ii = 0;
+    int64_t value = 0;
+    uint64_t magnitude = 0;
+    uint64_t power = 0;
+    int jj = 0;
+
+    length += snprintf(buffer + length, size - length, "\"%s\"", rp->name);
+
+    for (ii = TRACE_NUM; ii < TRACE_COLUMNS; ++ii) {
+        value = rp->value[ii];
+        if (rp->digits[ii] < 0) {
+            length += snprintf(buffer + length, size - length, ", %lld", (long long)value);
+        } else {
+            for (power = 1, jj = 0; jj < rp->digits[ii]; ++jj) { power *= 10; }
+            magnitude = (value < 0) ? -(uint64_t)value : (uint64_t)value;
+            if (rp->digits[ii] == 0) {
+                length += snprintf(buffer + length, size - length, ", %s%llu.", (value < 0) ? "-" : "", (unsigned long long)magnitude);
+            } else {
+                length += snprintf(buffer + length, size - length, ", %s%llu.%0*llu", (value < 0) ? "-" : "", (unsigned long long)(magnitude / power), rp->digits[ii], (unsigned long long)(magnitude % power));
+            }
+        }
+    }
+
+    length += snprintf(buffer + length, size - length, "\n");
+
+    return length;
+}
+
+/**
+ * Return the elapsed time in nanoseconds between two times.
+ * @param begin points to the earlier time.
+ * @param end points to the later time.
+ * @return the elapsed time in nanoseconds.
+ */
+static int64_t elapsed(const struct timespec * begin, const struct timespec * end)
+{
+    return ((int64_t)(end->tv_sec - begin->tv_sec) * 1000000000LL) + (end->tv_nsec - begin->tv_nsec);
+}
+
+int main(int argc, char * argv[])
+{
+    long records = 1000000;
+    long ii = 0;
+    int jj = 0;
+    trace_record_t * rp = (trace_record_t *)0;
+    char expected[TRACE_LINE] = { '\0', };
+    char actual[TRACE_LINE] = { '\0', };
+    size_t length = 0;
+    ssize_t rc = 0;
+    struct timespec begin;
+    struct timespec end;
+    int64_t before = 0;
+    int64_t after = 0;
+    volatile size_t total = 0;
+
+    if (argc > 1) {
+        records = strtol(argv[1], (char **)0, 0);
+    }
+
+    if (records <= 0) {
+        errno = EINVAL;
+        perror(argv[0]);
+        return 1;
+    }
+
+    if ((rp = (trace_record_t *)malloc(records * sizeof(*rp))) == (trace_record_t *)0) {
+        perror(argv[0]);
+        return 1;
+    }
+
+    srandom(1);
+
+    for (ii = 0; ii < records; ++ii) {
+        trace_record_init(&(rp[ii]), "neon", 0);
+        for (jj = TRACE_NUM; jj < TRACE_COLUMNS; ++jj) {
+            trace_record_set(&(rp[ii]), jj, ((((int64_t)random() << 31) ^ random()) % 1000000000000LL) - 500000000000LL, DIGITS[jj]);
+        }
+    }
+
+    for (ii = 0; ii < records; ++ii) {
+        length = reference(&(rp[ii]), expected, sizeof(expected));
+        rc = trace_format(&(rp[ii]), actual, sizeof(actual));
+        if ((rc != length) || (strcmp(expected, actual) != 0)) {
+            fprintf(stderr, "%s: mismatch: %s%s", argv[0], expected, actual);
+            return 1;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (ii = 0; ii < records; ++ii) {
+        total += reference(&(rp[ii]), expected, sizeof(expected));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    before = elapsed(&begin, &end);
+
+    clock_gettime(CLOCK_MONOTONIC, &begin);
+    for (ii = 0; ii < records; ++ii) {
+        total += trace_format(&(rp[ii]), actual, sizeof(actual));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    after = elapsed(&begin, &end);
+
+    printf("records %ld snprintf %.3lfus render %.3lfus speedup %.2lf\n", records, before / 1000.0 / records, after / 1000.0 / records, (after > 0) ? (double)before / after : 0.0);
+
+    free(rp);
+
+    return 0;
+}
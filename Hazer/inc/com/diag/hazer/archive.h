@@ -0,0 +1,260 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_ARCHIVE_
+#define _H_COM_DIAG_HAZER_ARCHIVE_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for the columnar trace archive format.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * An archive file holds the same records as a CSV or binary trace, but
+ * stored by column instead of by row, in chunks of up to a few thousand
+ * records, so that a query that filters or aggregates a few columns
+ * reads and decodes only those columns, and only in the chunks that might
+ * have records it wants.
+ *
+ * The file begins with a header that identifies the format, its version,
+ * its byte order, and the most records in a chunk. Each chunk follows as a
+ * chunk header and the encoded columns. The chunk header has the number of
+ * records in the chunk, the length of the chunk, and for each column its
+ * zone map, the least and greatest value in the chunk, along with where
+ * its data is and how it is encoded. A reader compares a filter with the
+ * zone maps to skip every chunk that can't have a record that passes it
+ * without decoding anything. The sequence of chunks is restartable: a
+ * header encountered where a chunk header is expected is skipped, so
+ * archives can be concatenated into one, and a partial chunk at the end,
+ * perhaps because the file is still being written, is ignored.
+ *
+ * Each numeric column is, as in the binary trace, a signed integer scaled
+ * by a power of ten along with its number of decimal digits. If all of the
+ * records in a chunk have the same number of digits in a column, which
+ * is typical, it is kept once in the chunk header; otherwise a byte per
+ * record precedes the values. The values are each encoded either as a
+ * zigzag varint, which is compact for small values like the fix type or the
+ * number of satellites, or as a zigzag varint of the difference from the
+ * value before it, which is compact for slowly changing values like the
+ * clocks and the position; the writer chooses whichever is smaller for each
+ * column in each chunk. The host name is encoded as runs of records that
+ * have the same name, and the record flags are kept as an extra column.
+ *
+ * Chunks are written in the byte order of the host that wrote them, and
+ * padded to a multiple of eight bytes so that every chunk header is
+ * aligned when the file is mapped into memory.
+ *
+ * REFERENCES
+ *
+ * D. Abadi, S. Madden, M. Ferreira, "Integrating Compression and Execution
+ * in Column-Oriented Database Systems", SIGMOD, 2006
+ *
+ * G. Moerkotte, "Small Materialized Aggregates: A Light Weight Index
+ * Structure for Data Warehousing", VLDB, 1998
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+#include "com/diag/hazer/trace.h"
+
+/*******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+/**
+ * These are the columns of an archive that aren't columns of a trace.
+ */
+enum ArchiveColumn {
+    ARCHIVE_FLG     = TRACE_COLUMNS,        /* Record flags. */
+    ARCHIVE_COLUMNS,                        /* Number of columns. */
+};
+
+/**
+ * These are the encodings of a column in a chunk.
+ */
+typedef enum ArchiveEncoding {
+    ARCHIVE_VARINT  = 0,        /* Zigzag varint of each value. */
+    ARCHIVE_DELTA   = 1,        /* Zigzag varint of each difference. */
+    ARCHIVE_RUNS    = 2,        /* Varint count and NUL terminated name. */
+} archive_encoding_t;
+
+enum ArchiveConstants {
+    ARCHIVE_VERSION = 1,        /* Version of the chunk layout. */
+    ARCHIVE_ORDER   = 0x0102,   /* Byte order mark. */
+    ARCHIVE_ROWS    = 4096,     /* Default most records in a chunk. */
+    ARCHIVE_LIMIT   = 1 << 20,  /* Largest most records in a chunk. */
+    ARCHIVE_MIXED   = -128,     /* Digits that vary within a chunk. */
+    ARCHIVE_ALIGN   = 8,        /* Alignment of each chunk. */
+    ARCHIVE_VARINTS = 10,       /* Most bytes in a varint. */
+};
+
+/**
+ * This is the magic number at the beginning of an archive file.
+ */
+#define ARCHIVE_MAGIC "HZAR"
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * This is the header at the beginning of an archive file.
+ */
+typedef struct ArchiveHeader {
+    char magic[4];                  /* ARCHIVE_MAGIC without its NUL. */
+    uint16_t version;               /* ARCHIVE_VERSION. */
+    uint16_t order;                 /* ARCHIVE_ORDER in host byte order. */
+    uint16_t columns;               /* ARCHIVE_COLUMNS. */
+    uint16_t size;                  /* Size of each chunk header in bytes. */
+    uint32_t rows;                  /* Most records in a chunk. */
+} archive_header_t;
+
+/**
+ * This is the zone map and location of a column in a chunk. The zone map
+ * of the host name is zero.
+ */
+typedef struct ArchiveZone {
+    double minimum;                 /* Least value in the chunk. */
+    double maximum;                 /* Greatest value in the chunk. */
+    uint32_t offset;                /* Offset of data from chunk header. */
+    uint32_t length;                /* Length of data in bytes. */
+    uint8_t encoding;               /* ARCHIVE_VARINT, DELTA, or RUNS. */
+    int8_t digits;                  /* Digits, TRACE_INTEGER, or MIXED. */
+    uint16_t reserved[3];           /* Zero. */
+} archive_zone_t;
+
+/**
+ * This is the header of each chunk, which is followed by its data.
+ */
+typedef struct ArchiveChunk {
+    uint32_t rows;                  /* Records in the chunk. */
+    uint32_t length;                /* Length including header and pad. */
+    archive_zone_t zone[ARCHIVE_COLUMNS];
+} archive_chunk_t;
+
+/**
+ * This is the state of an archive being written.
+ */
+typedef struct Archive {
+    FILE * fp;                      /* Stream being written. */
+    uint32_t rows;                  /* Most records in a chunk. */
+    uint32_t count;                 /* Records in the chunk. */
+    uint64_t records;               /* Records written. */
+    uint64_t chunks;                /* Chunks written. */
+    uint64_t bytes;                 /* Bytes written. */
+    trace_record_t * buffer;        /* Records in the chunk. */
+    uint8_t * data;                 /* Encoded chunk. */
+} archive_t;
+
+/*******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Start writing an archive file by writing its header.
+ * @param ap points to the archive.
+ * @param fp points to the stream, which is positioned at its beginning.
+ * @param rows is the most records in a chunk, 0 for ARCHIVE_ROWS.
+ * @return a pointer to the archive or NULL with errno set if an error
+ * occurred.
+ */
+extern archive_t * archive_init(archive_t * ap, FILE * fp, uint32_t rows);
+
+/**
+ * Write a record to an archive file. The chunk being accumulated is
+ * encoded and written when it is full.
+ * @param ap points to the archive.
+ * @param rp points to the record.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+extern int archive_write(archive_t * ap, const trace_record_t * rp);
+
+/**
+ * Encode and write the chunk being accumulated, if it has any records, so
+ * that a reader can see every record written so far.
+ * @param ap points to the archive.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+extern int archive_flush(archive_t * ap);
+
+/**
+ * Finish writing an archive file by writing the chunk being accumulated
+ * and releasing memory. The stream is flushed but not closed.
+ * @param ap points to the archive.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+extern int archive_fini(archive_t * ap);
+
+/**
+ * Check the header of an archive file that is in memory, for example
+ * because it has been mapped into memory.
+ * @param base points to the beginning of the file.
+ * @param length is the length of the file in bytes.
+ * @return a pointer to the header or NULL with errno set if the file is
+ * not an archive file this code can read.
+ */
+extern const archive_header_t * archive_check(const void * base, size_t length);
+
+/**
+ * Return the next chunk in an archive file that is in memory, skipping
+ * the header of any archive file concatenated to it.
+ * @param base points to the beginning of the file.
+ * @param length is the length of the file in bytes.
+ * @param offsetp points to the offset of the chunk, which is advanced past
+ * it, and which is zero to begin.
+ * @return a pointer to the chunk header or NULL if there are no more
+ * chunks, or the rest of the file is not an archive this code can read.
+ */
+extern const archive_chunk_t * archive_next(const void * base, size_t length, uint64_t * offsetp);
+
+/**
+ * Return true if the zone map of a column in a chunk admits that the
+ * chunk may have a record whose value in the column is within a range.
+ * @param cp points to the chunk header.
+ * @param column is the column.
+ * @param minimum is the least value in the range.
+ * @param maximum is the greatest value in the range.
+ * @return true if the chunk may have such a record, false if it can't.
+ */
+static inline int archive_overlaps(const archive_chunk_t * cp, int column, double minimum, double maximum)
+{
+    return (cp->zone[column].minimum <= maximum) && (minimum <= cp->zone[column].maximum);
+}
+
+/**
+ * Decode a numeric column, or the flags, of a chunk.
+ * @param cp points to the chunk header, which is followed by its data.
+ * @param column is the column.
+ * @param values points to an array of at least as many values as the
+ * chunk has records.
+ * @param digits points to an array of at least as many digits as the
+ * chunk has records.
+ * @return the number of records or <0 with errno set if the column is
+ * invalid or its data is corrupt.
+ */
+extern ssize_t archive_column(const archive_chunk_t * cp, int column, int64_t * values, int8_t * digits);
+
+/**
+ * Decode the host names of a chunk. The names are not copied; each is a
+ * pointer into the chunk.
+ * @param cp points to the chunk header, which is followed by its data.
+ * @param names points to an array of at least as many pointers as the
+ * chunk has records.
+ * @return the number of records or <0 with errno set if the data is
+ * corrupt.
+ */
+extern ssize_t archive_names(const archive_chunk_t * cp, const char ** names);
+
+/**
+ * Decode every column of a chunk into trace records.
+ * @param cp points to the chunk header, which is followed by its data.
+ * @param records points to an array of at least as many records as the
+ * chunk has.
+ * @return the number of records or <0 with errno set if the data is
+ * corrupt.
+ */
+extern ssize_t archive_records(const archive_chunk_t * cp, trace_record_t * records);
+
+#endif
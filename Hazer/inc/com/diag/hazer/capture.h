@@ -0,0 +1,322 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_CAPTURE_
+#define _H_COM_DIAG_HAZER_CAPTURE_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for the indexed capture format.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A capture file holds the framed messages received from a GNSS device or
+ * from the network, each exactly as it was received, along with the
+ * monotonic time at which it was received, its protocol, and its type.
+ * Unlike a raw catenate file, a capture preserves the arrival timing of
+ * the messages, so a replay can reproduce it; and unlike the CSV trace,
+ * it preserves the messages themselves.
+ *
+ * The file begins with a header that identifies the format and records
+ * the real time corresponding to a monotonic time, so that receive times
+ * can be converted to UTC. Each message follows as a record header and the
+ * message itself. Every so often (an interval of receive time) the
+ * messages since the last index record are summarized in an index record:
+ * their offset in the file, their first and last receive times, and how
+ * many of each type of message there are. Each index record points back
+ * to the one before it, and when the file is closed a trailer record at
+ * its very end points to the last one. So a reader can find any receive
+ * time, and skip every block that has no messages of the type it wants,
+ * by following the chain of index records back from the end, without
+ * reading the messages. A file that has no trailer, because the program
+ * writing it didn't exit cleanly, can still be read from the beginning.
+ *
+ * A type is a key that combines the protocol and the message type within
+ * the protocol: the class and ID of a UBX message, the number of an RTCM
+ * message, the sentence of an NMEA message (without its talker), and the
+ * ID of a CPO packet. Records are written in the byte order of the host
+ * that wrote them, which the header identifies, and the data of each is
+ * padded to a multiple of eight bytes so that every record header and
+ * index is aligned when the file is mapped into memory.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+/*******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+/**
+ * These are the protocols of the messages in a capture, and the kinds of
+ * records that aren't messages.
+ */
+typedef enum CaptureProtocol {
+    CAPTURE_OTHER   = 0,        /* Anything else. */
+    CAPTURE_NMEA    = 1,        /* NMEA 0183 sentence. */
+    CAPTURE_UBX     = 2,        /* u-blox UBX packet. */
+    CAPTURE_RTCM    = 3,        /* RTCM 10403 message. */
+    CAPTURE_CPO     = 4,        /* Garmin CPO packet. */
+    CAPTURE_INDEX   = 0xfe,     /* Index record. */
+    CAPTURE_TRAILER = 0xff,     /* Trailer record. */
+} capture_protocol_t;
+
+enum CaptureConstants {
+    CAPTURE_VERSION = 1,        /* Version of the record layout. */
+    CAPTURE_ORDER   = 0x0102,   /* Byte order mark. */
+    CAPTURE_TYPES   = 64,       /* Most types counted in a block. */
+    CAPTURE_ALIGN   = 8,        /* Alignment of each record. */
+};
+
+/**
+ * This is the magic number at the beginning of a capture file.
+ */
+#define CAPTURE_MAGIC "HZCP"
+
+/**
+ * This is the default interval between index records in nanoseconds.
+ */
+#define CAPTURE_INTERVAL (10000000000LL)
+
+/**
+ * This is the mask that selects the protocol of a key.
+ */
+#define CAPTURE_PROTOCOL (0xff000000UL)
+
+/**
+ * This is the key under which a block counts the messages whose types
+ * didn't fit in its index. It matches every key, so a block with any
+ * such messages is never skipped.
+ */
+#define CAPTURE_OVERFLOW (0xffffffffUL)
+
+/**
+ * @def CAPTURE_KEY
+ * Make a key from a protocol @a _PROTOCOL_ and a type @a _TYPE_.
+ */
+#define CAPTURE_KEY(_PROTOCOL_, _TYPE_) ((((uint32_t)(_PROTOCOL_)) << 24) | (((uint32_t)(_TYPE_)) & 0x00ffffffUL))
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * This is the header at the beginning of a capture file.
+ */
+typedef struct CaptureHeader {
+    char magic[4];                  /* CAPTURE_MAGIC without its NUL. */
+    uint16_t version;               /* CAPTURE_VERSION. */
+    uint16_t order;                 /* CAPTURE_ORDER in host byte order. */
+    int64_t realtime;               /* CLOCK_REALTIME ns at ... */
+    int64_t monotonic;              /* ... this CLOCK_MONOTONIC ns. */
+} capture_header_t;
+
+/**
+ * This is the header of each record, which is followed by its data.
+ */
+typedef struct CaptureRecord {
+    int64_t stamp;                  /* CLOCK_MONOTONIC ns when received. */
+    uint32_t length;                /* Length of the data in bytes. */
+    uint32_t key;                   /* Protocol and type. */
+} capture_record_t;
+
+/**
+ * This is the count of one type of message in a block.
+ */
+typedef struct CaptureCount {
+    uint32_t key;                   /* Protocol and type. */
+    uint32_t count;                 /* Messages of this type. */
+} capture_count_t;
+
+/**
+ * This is the data of an index record, which is followed by its counts.
+ */
+typedef struct CaptureIndex {
+    int64_t first;                  /* Receive time of the first message. */
+    int64_t last;                   /* Receive time of the last message. */
+    uint64_t offset;                /* Offset of the first message. */
+    uint64_t previous;              /* Offset of the prior index or 0. */
+    uint32_t records;               /* Messages in the block. */
+    uint32_t types;                 /* Counts that follow. */
+} capture_index_t;
+
+/**
+ * This is the data of the trailer record.
+ */
+typedef struct CaptureTrailer {
+    uint64_t index;                 /* Offset of the last index or 0. */
+    uint64_t records;               /* Messages in the file. */
+} capture_trailer_t;
+
+/**
+ * This is the state of a capture being written.
+ */
+typedef struct Capture {
+    FILE * fp;                      /* Stream being written. */
+    uint64_t offset;                /* Bytes written. */
+    int64_t interval;               /* Receive time per block in ns. */
+    uint64_t previous;              /* Offset of the last index or 0. */
+    uint64_t records;               /* Messages written. */
+    capture_index_t block;          /* Block being accumulated. */
+    capture_count_t count[CAPTURE_TYPES];
+} capture_t;
+
+/**
+ * This is a capture, or any other input, loaded into memory.
+ */
+typedef struct CaptureImage {
+    void * base;                    /* Beginning of the input. */
+    size_t length;                  /* Length of the input in bytes. */
+    int mapped;                     /* !0 if mapped, 0 if allocated. */
+} capture_image_t;
+
+/*******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Return the current monotonic time in nanoseconds, suitable as the receive
+ * time of a message.
+ * @return the current monotonic time in nanoseconds.
+ */
+extern int64_t capture_now(void);
+
+/**
+ * Return the key of a framed message.
+ * @param protocol is the protocol of the message.
+ * @param data points to the message.
+ * @param length is the length of the message in bytes.
+ * @return the key, which is just the protocol if the type can't be found.
+ */
+extern uint32_t capture_key(capture_protocol_t protocol, const void * data, size_t length);
+
+/**
+ * Return the name of a protocol.
+ * @param protocol is the protocol.
+ * @return the name.
+ */
+extern const char * capture_name(capture_protocol_t protocol);
+
+/**
+ * Start writing a capture file by writing its header.
+ * @param cp points to the capture.
+ * @param fp points to the stream, which is positioned at its beginning.
+ * @param interval is the receive time covered by each index record in ns.
+ * @return a pointer to the capture or NULL with errno set if an error
+ * occurred.
+ */
+extern capture_t * capture_init(capture_t * cp, FILE * fp, int64_t interval);
+
+/**
+ * Write a message to a capture file. An index record is written first if
+ * the message is received after the block being accumulated has covered
+ * the interval.
+ * @param cp points to the capture.
+ * @param stamp is the monotonic time in ns when the message was received.
+ * @param protocol is the protocol of the message.
+ * @param data points to the message.
+ * @param length is the length of the message in bytes.
+ * @return the length or <0 with errno set if an error occurred.
+ */
+extern ssize_t capture_write(capture_t * cp, int64_t stamp, capture_protocol_t protocol, const void * data, size_t length);
+
+/**
+ * Finish writing a capture file by writing the index record for the block
+ * being accumulated and the trailer. The stream is flushed but not closed.
+ * @param cp points to the capture.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+extern int capture_fini(capture_t * cp);
+
+/**
+ * Check the header of a capture file that is in memory, for example because
+ * it has been mapped into memory.
+ * @param base points to the beginning of the file.
+ * @param length is the length of the file in bytes.
+ * @return a pointer to the header or NULL with errno set if the file is
+ * not a capture file this code can read.
+ */
+extern const capture_header_t * capture_check(const void * base, size_t length);
+
+/**
+ * Return the next record in a capture file that is in memory. A partial
+ * record at the end, perhaps because the file is still being written, is
+ * ignored.
+ * @param base points to the beginning of the file.
+ * @param length is the length of the file in bytes.
+ * @param offsetp points to the offset of the record, which is advanced
+ * past it.
+ * @param rp points to where the record header is copied.
+ * @return a pointer to the data of the record or NULL if there are no
+ * more records.
+ */
+extern const void * capture_next(const void * base, size_t length, uint64_t * offsetp, capture_record_t * rp);
+
+/**
+ * Return the offset of the last index record in a capture file that is in
+ * memory, according to its trailer.
+ * @param base points to the beginning of the file.
+ * @param length is the length of the file in bytes.
+ * @return the offset or 0 if the file has no trailer or no index.
+ */
+extern uint64_t capture_last(const void * base, size_t length);
+
+/**
+ * Return an index record in a capture file that is in memory.
+ * @param base points to the beginning of the file.
+ * @param length is the length of the file in bytes.
+ * @param offset is the offset of the index record.
+ * @param ip points to where the index is copied.
+ * @return a pointer to its counts or NULL if it isn't an index record.
+ */
+extern const capture_count_t * capture_index(const void * base, size_t length, uint64_t offset, capture_index_t * ip);
+
+/**
+ * Return how many messages in a block have a key, or, if the mask is
+ * CAPTURE_PROTOCOL, have the protocol of a key. Messages counted under
+ * CAPTURE_OVERFLOW are always included.
+ * @param ip points to the index of the block.
+ * @param counts points to the counts of the block.
+ * @param key is the key.
+ * @param mask selects the bits of the key that are compared.
+ * @return the number of messages.
+ */
+extern uint64_t capture_count(const capture_index_t * ip, const capture_count_t * counts, uint32_t key, uint32_t mask);
+
+/**
+ * Return the offset at which to start reading a capture file that is in
+ * memory to find the messages received at or after a time, and that match
+ * a key, by following its index records back from its trailer. Only blocks
+ * that end before the time, or have no matching messages, are skipped.
+ * @param base points to the beginning of the file.
+ * @param length is the length of the file in bytes.
+ * @param stamp is the monotonic time in ns.
+ * @param key is the key.
+ * @param mask selects the bits of the key that are compared, 0 for all keys.
+ * @param skippedp points to where the number of messages skipped is
+ * returned.
+ * @return the offset, which is just past the header if the file has no
+ * trailer.
+ */
+extern uint64_t capture_seek(const void * base, size_t length, int64_t stamp, uint32_t key, uint32_t mask, uint64_t * skippedp);
+
+/**
+ * Load all of a stream into memory: a regular file is mapped into memory,
+ * and anything else, like a pipe, is read into allocated memory.
+ * @param ip points to the image.
+ * @param fp points to the stream.
+ * @param advice is the madvise(2) advice for a mapping, e.g. MADV_RANDOM.
+ * @return a pointer to the image or NULL with errno set if an error
+ * occurred.
+ */
+extern capture_image_t * capture_load(capture_image_t * ip, FILE * fp, int advice);
+
+/**
+ * Release an image returned by capture_load().
+ * @param ip points to the image.
+ */
+extern void capture_unload(capture_image_t * ip);
+
+#endif
@@ -4,7 +4,7 @@
 
 /**
  * @file
- * @copyright Copyright 2020-2023 Digital Aggregates Corporation, Colorado, USA.
+ * @copyright Copyright 2020-2024 Digital Aggregates Corporation, Colorado, USA.
  * @note Licensed under the terms in LICENSE.txt.
  * @brief Common facilities for other stuff.
  * @author Chip Overclock <mailto:coverclock@diag.com>
@@ -13,6 +13,7 @@
  */
 
 #include <stdint.h>
+#include <time.h>
 #include <wchar.h>
 
 #if !defined(COMMON_DEGREE_VALUE)
@@ -61,4 +62,18 @@ static inline int64_t common_abs64(int64_t x)
 #   define abs64 common_abs64
 #endif
 
+/**
+ * Return the time of a clock in nanoseconds.
+ * @param clock is the clock, for example CLOCK_MONOTONIC.
+ * @return the time in nanoseconds.
+ */
+static inline int64_t common_clock(clockid_t clock)
+{
+    struct timespec now;
+
+    clock_gettime(clock, &now);
+
+    return ((int64_t)now.tv_sec * 1000000000LL) + now.tv_nsec;
+}
+
 #endif
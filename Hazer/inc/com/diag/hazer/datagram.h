@@ -27,6 +27,8 @@
 #include <stdint.h>
 #include <stddef.h>
 #include <arpa/inet.h>
+#include <sys/types.h>
+#include <sys/socket.h>
 #include "com/diag/hazer/hazer.h"
 #include "com/diag/hazer/yodel.h"
 #include "com/diag/hazer/tumbleweed.h"
@@ -104,4 +106,368 @@ ssize_t datagram_validate(datagram_sequence_t * expectedp, datagram_header_t * h
  */
 void datagram_stamp(datagram_header_t * buffer, datagram_sequence_t * expectedp);
 
+/*******************************************************************************
+ * DATAGRAM BATCH
+ ******************************************************************************/
+
+enum DatagramBatchConstants {
+    DATAGRAM_BATCH  = 16,   /* Maximum datagrams received per system call. */
+};
+
+/**
+ * A batch is an array of datagram buffers filled by a single recvmmsg(2),
+ * each with its received length and the address of its sender, and
+ * the counters needed to see how well that system call is amortized.
+ * Datagrams are consumed from the batch in the order in which they
+ * were received, so they can be sequenced with datagram_validate() just
+ * as if they had been received one at a time.
+ */
+typedef struct DatagramBatch {
+    datagram_buffer_t buffer[DATAGRAM_BATCH];
+    struct sockaddr_storage address[DATAGRAM_BATCH];
+    ssize_t length[DATAGRAM_BATCH];
+    unsigned int received;      /* Datagrams in the current batch. */
+    unsigned int consumed;      /* Datagrams consumed from the current batch. */
+    unsigned int maximum;       /* Largest batch received. */
+    uint64_t wakeups;           /* Batches received. */
+    uint64_t packets;           /* Datagrams received. */
+} datagram_batch_t;
+
+/**
+ * Initialize a batch.
+ * @param bp points to the batch.
+ */
+void datagram_batch_init(datagram_batch_t * bp);
+
+/**
+ * Receive as many datagrams as are waiting on a socket, up to the size
+ * of the batch, with a single non-blocking system call. Any datagrams
+ * not yet consumed from the previous batch are discarded. Each datagram
+ * is NUL terminated, like those received by gpstool one at a time.
+ * @param bp points to the batch.
+ * @param fd is the socket.
+ * @return the number of datagrams received, 0 if none, <0 for error.
+ */
+int datagram_batch_receive(datagram_batch_t * bp, int fd);
+
+/**
+ * Return the number of datagrams in the batch not yet consumed.
+ * @param bp points to the batch.
+ * @return the number of datagrams pending.
+ */
+static inline unsigned int datagram_batch_pending(const datagram_batch_t * bp) {
+    return bp->received - bp->consumed;
+}
+
+/**
+ * Consume the next datagram in the batch. The buffer remains valid until
+ * the next call to datagram_batch_receive().
+ * @param bp points to the batch.
+ * @param lengthp points to where the received length (not including the
+ * terminating NUL) is stored.
+ * @param addressp if not NULL points to where a pointer to the sender's
+ * address is stored.
+ * @return a pointer to the buffer or NULL if the batch is exhausted.
+ */
+datagram_buffer_t * datagram_batch_next(datagram_batch_t * bp, ssize_t * lengthp, const struct sockaddr_storage ** addressp);
+
+/**
+ * Extract the IPv6 address, as eight sixteen-bit words in host byte order
+ * (an IPv4 sender is returned as an IPv4-mapped IPv6 address), and the
+ * port from a sender's address.
+ * @param sap points to the sender's address.
+ * @param address is the array into which the address is stored.
+ * @param portp points to where the port is stored.
+ * @return 0 for success, <0 if the address family is not IPv4 or IPv6.
+ */
+int datagram_batch_identify(const struct sockaddr_storage * sap, uint16_t address[8], uint16_t * portp);
+
+
+/*******************************************************************************
+ * DATAGRAM FANOUT
+ ******************************************************************************/
+
+enum DatagramFanoutConstants {
+    DATAGRAM_FANOUT = 64,   /* Maximum destinations sent per system call. */
+};
+
+/**
+ * A fanout is a vector of destinations to which the same datagram is sent
+ * with a single sendmmsg(2), and the error (if any) for each destination
+ * from the most recent send. Destinations are IPv6 addresses; IPv4
+ * destinations are IPv4-mapped IPv6 addresses, so the socket must be
+ * an IPv6 socket, like those used by rtktool.
+ */
+typedef struct DatagramFanout {
+    struct sockaddr_in6 address[DATAGRAM_FANOUT];
+    int error[DATAGRAM_FANOUT]; /* Zero or the errno for each destination. */
+    unsigned int count;         /* Destinations in the vector. */
+    uint64_t calls;             /* System calls made. */
+    uint64_t packets;           /* Datagrams successfully sent. */
+    uint64_t errors;            /* Datagrams that could not be sent. */
+} datagram_fanout_t;
+
+/**
+ * Initialize a fanout, including its counters.
+ * @param fp points to the fanout.
+ */
+void datagram_fanout_init(datagram_fanout_t * fp);
+
+/**
+ * Empty the vector of destinations of a fanout without affecting its
+ * counters.
+ * @param fp points to the fanout.
+ */
+static inline void datagram_fanout_reset(datagram_fanout_t * fp) {
+    fp->count = 0;
+}
+
+/**
+ * Append a destination to a fanout.
+ * @param fp points to the fanout.
+ * @param address is the IPv6 address as eight sixteen-bit words in host
+ * byte order.
+ * @param port is the port in host byte order.
+ * @return the index of the destination, or <0 if the vector is full.
+ */
+int datagram_fanout_add(datagram_fanout_t * fp, const uint16_t address[8], uint16_t port);
+
+/**
+ * Send the same datagram to every destination in a fanout, using as few
+ * system calls as possible. A destination that fails is recorded in the
+ * error vector and skipped, and the send resumes with the next one. The
+ * vector of destinations is left intact so the caller can examine the
+ * error for each.
+ * @param fp points to the fanout.
+ * @param fd is an IPv6 datagram socket.
+ * @param buffer points to the datagram.
+ * @param length is the length of the datagram in bytes.
+ * @return the number of destinations to which the datagram was sent.
+ */
+int datagram_fanout_send(datagram_fanout_t * fp, int fd, const void * buffer, size_t length);
+
+
+/*******************************************************************************
+ * DATAGRAM FRAMES
+ ******************************************************************************/
+
+/**
+ * A batched datagram carries several frames (NMEA sentences, UBX packets,
+ * RTCM messages, or CPO packets), typically all of those from one epoch,
+ * instead of just one, to save the per-packet overhead of IP, UDP, and
+ * (for cellular links) radio wakeups. After the usual sequence number
+ * header, its payload is a mark octet that cannot begin any of the
+ * supported frames, a count of frames, and then for each frame its
+ * length as two octets in network byte order followed by the frame.
+ * The sequence number applies to the datagram as a whole, so each frame
+ * unpacked from it carries the same one. A batch of one frame is sent
+ * as an ordinary datagram, so single-frame receivers understand it.
+ */
+enum DatagramFramesConstants {
+    DATAGRAM_FRAMES_MARK        = 0xfe, /* First octet of a batched payload. */
+    DATAGRAM_FRAMES_PREAMBLE    = 2,    /* Mark and count octets. */
+    DATAGRAM_FRAMES_PREFIX      = 2,    /* Length octets before each frame. */
+    DATAGRAM_FRAMES_MAXIMUM     = 255,  /* Most frames in a datagram. */
+    DATAGRAM_FRAMES_MTU         = 1472, /* Ethernet MTU less IPv4 and UDP. */
+    DATAGRAM_FRAMES_WINDOW      = 10,   /* Default milliseconds a frame waits. */
+};
+
+/**
+ * A packer accumulates frames into a batched datagram up to a budget in
+ * bytes, typically the path MTU less the IP and UDP headers.
+ */
+typedef struct DatagramPacker {
+    datagram_buffer_t buffer;   /* Datagram being packed. */
+    size_t budget;              /* Largest datagram including the header. */
+    size_t length;              /* Payload packed so far. */
+    unsigned int count;         /* Frames packed so far. */
+    uint64_t frames;            /* Frames packed. */
+    uint64_t datagrams;         /* Datagrams finished. */
+} datagram_packer_t;
+
+/**
+ * Initialize a packer, including its counters.
+ * @param pp points to the packer.
+ * @param budget is the largest datagram, including the header, in bytes;
+ * it is limited to what the buffer can hold.
+ */
+void datagram_packer_init(datagram_packer_t * pp, size_t budget);
+
+/**
+ * Append a frame to a packer.
+ * @param pp points to the packer.
+ * @param frame points to the frame.
+ * @param length is the length of the frame in bytes.
+ * @return 0 for success, or <0 if the frame doesn't fit, in which case the
+ * caller should finish the datagram and try again, or, if the packer is
+ * already empty, send the frame in an ordinary datagram.
+ */
+int datagram_packer_append(datagram_packer_t * pp, const void * frame, size_t length);
+
+/**
+ * Return the number of frames packed but not yet finished.
+ * @param pp points to the packer.
+ * @return the number of frames pending.
+ */
+static inline unsigned int datagram_packer_pending(const datagram_packer_t * pp) {
+    return pp->count;
+}
+
+/**
+ * Finish the datagram in a packer, stamp it with the next sequence number,
+ * and empty the packer. A single frame is finished as an ordinary datagram.
+ * The datagram remains valid until the next frame is appended.
+ * @param pp points to the packer.
+ * @param expectedp points to the expected sequence number.
+ * @return the length of the datagram including the header, or 0 if the
+ * packer was empty.
+ */
+size_t datagram_packer_finish(datagram_packer_t * pp, datagram_sequence_t * expectedp);
+
+/**
+ * An unpacker extracts the frames from a batched datagram one at a time,
+ * each into a buffer of its own that is laid out (and NUL terminated) just
+ * like an ordinary datagram carrying that frame.
+ */
+typedef struct DatagramUnpacker {
+    datagram_buffer_t buffer;   /* Current frame as an ordinary datagram. */
+    const uint8_t * payload;    /* Payload of the batched datagram. */
+    size_t size;                /* Size of that payload. */
+    size_t offset;              /* Offset of the next frame in that payload. */
+    unsigned int remaining;     /* Frames not yet unpacked. */
+    uint64_t frames;            /* Frames unpacked. */
+    uint64_t datagrams;         /* Batched datagrams started. */
+} datagram_unpacker_t;
+
+/**
+ * Initialize an unpacker, including its counters.
+ * @param up points to the unpacker.
+ */
+void datagram_unpacker_init(datagram_unpacker_t * up);
+
+/**
+ * Start unpacking a datagram if it is a well formed batched datagram. The
+ * datagram must remain valid until all of its frames are unpacked.
+ * @param up points to the unpacker.
+ * @param datagram points to the received datagram.
+ * @param length is the length of the datagram including the header.
+ * @return the number of frames, or 0 if it isn't a batched datagram.
+ */
+int datagram_unpacker_start(datagram_unpacker_t * up, const datagram_header_t * datagram, size_t length);
+
+/**
+ * Return the number of frames not yet unpacked.
+ * @param up points to the unpacker.
+ * @return the number of frames pending.
+ */
+static inline unsigned int datagram_unpacker_pending(const datagram_unpacker_t * up) {
+    return up->remaining;
+}
+
+/**
+ * Unpack the next frame. The buffer remains valid until the next call.
+ * @param up points to the unpacker.
+ * @param lengthp points to where the length of the frame (not including
+ * the header or the terminating NUL) is stored.
+ * @return a pointer to the buffer or NULL if there are no more frames.
+ */
+datagram_buffer_t * datagram_unpacker_next(datagram_unpacker_t * up, ssize_t * lengthp);
+
+
+/*******************************************************************************
+ * DATAGRAM REORDER
+ ******************************************************************************/
+
+enum DatagramReorderConstants {
+    DATAGRAM_REORDER        = 16,   /* Most datagrams held for reordering. */
+    DATAGRAM_REORDER_DEPTHS = 8,    /* Bins in the reorder depth histogram. */
+};
+
+/**
+ * A reorder buffer is an optional alternative to datagram_validate() for
+ * links (like LTE, or VPNs over several paths) that often deliver
+ * datagrams slightly out of order. Instead of discarding a datagram that
+ * arrives after one with a later sequence number, datagrams that arrive
+ * ahead of a gap are held, up to a number of slots and for at most a
+ * delay, and released in sequence order as soon as the gap fills. If the
+ * gap doesn't fill in time, or the slots are all in use, it is given up
+ * on and counted as missing, just as datagram_validate() would have.
+ * Datagrams behind the expected sequence number (including duplicates)
+ * are still discarded and counted as out of order. The reorder depth of
+ * a datagram is how many datagrams with later sequence numbers arrived
+ * before it; a histogram of depths shows how much reordering the link
+ * does, and so how many slots are useful. Times and delays are in
+ * whatever units the caller uses, typically Diminuto ticks.
+ */
+typedef struct DatagramReorder {
+    datagram_buffer_t buffer[DATAGRAM_REORDER];
+    ssize_t length[DATAGRAM_REORDER];
+    int64_t arrival[DATAGRAM_REORDER];
+    datagram_sequence_t sequence[DATAGRAM_REORDER];
+    uint8_t occupied[DATAGRAM_REORDER];
+    uint64_t histogram[DATAGRAM_REORDER_DEPTHS]; /* Last bin is that or more. */
+    uint64_t reordered;         /* Datagrams that arrived out of order. */
+    uint64_t expired;           /* Gaps given up on. */
+    int64_t delay;              /* Longest a datagram is held. */
+    unsigned int slots;         /* Slots in use, or 0 if disabled. */
+    unsigned int held;          /* Datagrams being held. */
+} datagram_reorder_t;
+
+/**
+ * Initialize a reorder buffer, including its counters.
+ * @param rp points to the reorder buffer.
+ * @param slots is the most datagrams held (limited to DATAGRAM_REORDER),
+ * or 0 to disable reordering.
+ * @param delay is the longest a datagram is held.
+ */
+void datagram_reorder_init(datagram_reorder_t * rp, unsigned int slots, int64_t delay);
+
+/**
+ * Insert a received datagram into a reorder buffer. This should only be
+ * done once datagram_reorder_next() has released all that it can, so
+ * that there is a free slot.
+ * @param rp points to the reorder buffer.
+ * @param datagram points to the received datagram.
+ * @param length is the length of the datagram including the header.
+ * @param now is the current time.
+ * @param expectedp points to the expected sequence number.
+ * @param outoforderp points to the Out Of Order counter.
+ * @return the size of the payload or <0 if the datagram was discarded.
+ */
+ssize_t datagram_reorder_insert(datagram_reorder_t * rp, const datagram_header_t * datagram, ssize_t length, int64_t now, datagram_sequence_t * expectedp, unsigned int * outoforderp);
+
+/**
+ * Release the next datagram in sequence order, if there is one, either
+ * because it is the expected one, or because the gap before it has been
+ * given up on. The buffer (NUL terminated like those in a batch) remains
+ * valid until the next call to datagram_reorder_insert().
+ * @param rp points to the reorder buffer.
+ * @param lengthp points to where the length of the datagram including
+ * the header (but not the NUL) is stored.
+ * @param now is the current time.
+ * @param expectedp points to the expected sequence number.
+ * @param missingp points to the Missing counter.
+ * @return a pointer to the datagram or NULL if none can be released yet.
+ */
+datagram_buffer_t * datagram_reorder_next(datagram_reorder_t * rp, ssize_t * lengthp, int64_t now, datagram_sequence_t * expectedp, unsigned int * missingp);
+
+/**
+ * Return true if datagram_reorder_next() would release a datagram.
+ * @param rp points to the reorder buffer.
+ * @param expected is the expected sequence number.
+ * @param now is the current time.
+ * @return !0 if a datagram can be released, 0 otherwise.
+ */
+int datagram_reorder_ready(const datagram_reorder_t * rp, datagram_sequence_t expected, int64_t now);
+
+/**
+ * Return how long until the oldest datagram being held is released
+ * whether or not the gap before it fills.
+ * @param rp points to the reorder buffer.
+ * @param now is the current time.
+ * @return the time remaining, 0 if it can be released now, or <0 if no
+ * datagram is being held.
+ */
+int64_t datagram_reorder_remaining(const datagram_reorder_t * rp, int64_t now);
+
 #endif
@@ -0,0 +1,118 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_FRAMER_
+#define _H_COM_DIAG_HAZER_FRAMER_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for framing a raw stream of GNSS output.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A framer runs the NMEA, UBX, RTCM, and CPO state machines over a raw
+ * stream of octets, one octet at a time, and synchronizes with and frames
+ * the messages in the stream exactly the way gpstool does: after a frame,
+ * only the state machine whose protocol the next octet begins is started;
+ * otherwise, or if every state machine has stopped, they are all started.
+ *
+ * Besides each frame, the framer reports the points in the stream at which
+ * its state depends on nothing that came before: just after a frame, and
+ * whenever every state machine is waiting for the beginning of a frame.
+ * Two framers that reach the same such point, of the same kind, at the
+ * same offset in the same stream, from then on produce the same frames no
+ * matter where in the stream either of them started. This is what allows
+ * a stream to be split into pieces that are framed independently and then
+ * stitched back together into exactly what framing the whole stream from
+ * its beginning would have produced.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include "com/diag/hazer/hazer.h"
+#include "com/diag/hazer/yodel.h"
+#include "com/diag/hazer/tumbleweed.h"
+#include "com/diag/hazer/calico.h"
+#include "com/diag/hazer/capture.h"
+
+/*******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+/**
+ * These are the events that a framer reports after each octet. The
+ * values of FRAMER_SCANNING and FRAMER_FRAMED are also the kinds of points
+ * at which the state of a framer depends on nothing that came before.
+ */
+typedef enum FramerEvent {
+    FRAMER_CONTINUING   = 0,    /* In the middle of a frame. */
+    FRAMER_SCANNING     = 1,    /* Waiting for the beginning of a frame. */
+    FRAMER_FRAMED       = 2,    /* Completed a frame. */
+} framer_event_t;
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * This is a framer.
+ */
+typedef struct Framer {
+    hazer_state_t nmea_state;
+    yodel_state_t ubx_state;
+    tumbleweed_state_t rtcm_state;
+    calico_state_t cpo_state;
+    hazer_context_t nmea_context;
+    yodel_context_t ubx_context;
+    tumbleweed_context_t rtcm_context;
+    calico_context_t cpo_context;
+    capture_protocol_t protocol;    /* Protocol of the last frame. */
+    size_t length;                  /* Length of the last frame in bytes. */
+    const uint8_t * frame;          /* Last frame. */
+    int framed;                     /* !0 if the last octet ended a frame. */
+    hazer_buffer_t nmea_buffer;
+    yodel_buffer_t ubx_buffer;
+    tumbleweed_buffer_t rtcm_buffer;
+    calico_buffer_t cpo_buffer;
+} framer_t;
+
+/*******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Initialize a framer so that it is at a point of a kind, which is
+ * FRAMER_SCANNING at the beginning of a stream, or the kind of a point
+ * reported by another framer at which this one is to pick up.
+ * @param fp points to the framer.
+ * @param kind is FRAMER_SCANNING or FRAMER_FRAMED.
+ * @return a pointer to the framer.
+ */
+extern framer_t * framer_init(framer_t * fp, framer_event_t kind);
+
+/**
+ * Run a framer over the next octet in a stream.
+ * @param fp points to the framer.
+ * @param ch is the octet.
+ * @return FRAMER_FRAMED if the octet completed a frame, FRAMER_SCANNING if
+ * the framer is waiting for the beginning of a frame, or FRAMER_CONTINUING
+ * otherwise.
+ */
+extern framer_event_t framer_machine(framer_t * fp, uint8_t ch);
+
+/**
+ * Return the frame most recently completed by a framer, which is valid
+ * until the next octet is run through it.
+ * @param fp points to the framer.
+ * @param protocolp points to where the protocol is returned.
+ * @param lengthp points to where the length in bytes is returned.
+ * @return a pointer to the frame.
+ */
+static inline const void * framer_frame(const framer_t * fp, capture_protocol_t * protocolp, size_t * lengthp)
+{
+    *protocolp = fp->protocol;
+    *lengthp = fp->length;
+    return fp->frame;
+}
+
+#endif
@@ -0,0 +1,158 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_LOOP_
+#define _H_COM_DIAG_HAZER_LOOP_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for an epoll(7) based event loop.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * An event loop is an epoll(7) instance plus a callback, and a context
+ * for the callback, for each registered file descriptor. Waiting on the
+ * loop calls the callback for each descriptor that became ready, so the
+ * cost of a wakeup depends on how many descriptors are ready, not on how
+ * many are registered, and there is no limit like FD_SETSIZE on the
+ * descriptors themselves.
+ *
+ * Readiness is edge triggered: a callback is called when a descriptor
+ * becomes readable or writable, not for as long as it is. So descriptors
+ * should be non-blocking, and a callback should read (or write) until
+ * the descriptor returns EAGAIN, or else remember that it didn't. A
+ * callback may register, modify, or unregister any descriptor, including
+ * its own; if it unregisters a descriptor for which another event is
+ * pending in the same wakeup, that event is discarded, even if the
+ * descriptor has since been reused and registered again.
+ */
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * These are the events for which a descriptor can be registered, and
+ * which are passed to its callback.
+ */
+enum LoopEvents {
+    LOOP_READ   = EPOLLIN | EPOLLRDHUP,     /* Readable, or closed by peer. */
+    LOOP_WRITE  = EPOLLOUT,                 /* Writable. */
+    LOOP_ERROR  = EPOLLERR | EPOLLHUP,      /* Always reported. */
+};
+
+struct Loop;
+
+/**
+ * This is the type of a callback.
+ * @param lp points to the loop.
+ * @param fd is the descriptor that is ready.
+ * @param events is the set of events that occurred.
+ * @param context is the context with which the descriptor was registered.
+ */
+typedef void (loop_callback_t)(struct Loop * lp, int fd, uint32_t events, void * context);
+
+/**
+ * This is what is registered for each descriptor.
+ */
+typedef struct LoopHandler {
+    loop_callback_t * callback;
+    void * context;
+    uint32_t events;                /* Events registered for. */
+    uint32_t generation;            /* Distinguishes reuses of a descriptor. */
+} loop_handler_t;
+
+/**
+ * This is an event loop.
+ */
+typedef struct Loop {
+    struct epoll_event * event;     /* Events returned by a wakeup. */
+    loop_handler_t * handler;       /* Handlers indexed by descriptor. */
+    uint64_t wakeups;               /* Wakeups with at least one event. */
+    uint64_t dispatches;            /* Callbacks called. */
+    int events;                     /* Size of the event array. */
+    int handlers;                   /* Size of the handler array. */
+    int registered;                 /* Descriptors registered. */
+    int epfd;                       /* epoll(7) descriptor. */
+} loop_t;
+
+/*******************************************************************************
+ * LIFECYCLE
+ ******************************************************************************/
+
+/**
+ * Initialize an event loop.
+ * @param lp points to the loop.
+ * @param events is the most events returned by a single wakeup.
+ * @return a pointer to the loop or NULL with errno set if an error occurred.
+ */
+extern loop_t * loop_init(loop_t * lp, int events);
+
+/**
+ * Release the resources held by an event loop. The registered descriptors
+ * are not closed.
+ * @param lp points to the loop.
+ */
+extern void loop_fini(loop_t * lp);
+
+/*******************************************************************************
+ * REGISTRATION
+ ******************************************************************************/
+
+/**
+ * Register a descriptor with an event loop.
+ * @param lp points to the loop.
+ * @param fd is the descriptor, which should be non-blocking.
+ * @param events is LOOP_READ, LOOP_WRITE, or both.
+ * @param callback points to the callback.
+ * @param context is passed to the callback.
+ * @return 0 for success, <0 with errno set if an error occurred.
+ */
+extern int loop_register(loop_t * lp, int fd, uint32_t events, loop_callback_t * callback, void * context);
+
+/**
+ * Change the events for which a registered descriptor is registered.
+ * @param lp points to the loop.
+ * @param fd is the descriptor.
+ * @param events is LOOP_READ, LOOP_WRITE, or both.
+ * @return 0 for success, <0 with errno set if an error occurred.
+ */
+extern int loop_modify(loop_t * lp, int fd, uint32_t events);
+
+/**
+ * Unregister a descriptor. This must be done before the descriptor is
+ * closed.
+ * @param lp points to the loop.
+ * @param fd is the descriptor.
+ * @return 0 for success, <0 with errno set if an error occurred.
+ */
+extern int loop_unregister(loop_t * lp, int fd);
+
+/**
+ * Return true if a descriptor is registered.
+ * @param lp points to the loop.
+ * @param fd is the descriptor.
+ * @return !0 if the descriptor is registered, 0 otherwise.
+ */
+static inline int loop_registered(const loop_t * lp, int fd) {
+    return (fd >= 0) && (fd < lp->handlers) && (lp->handler[fd].callback != (loop_callback_t *)0);
+}
+
+/*******************************************************************************
+ * DISPATCHING
+ ******************************************************************************/
+
+/**
+ * Wait for descriptors to become ready and call their callbacks.
+ * @param lp points to the loop.
+ * @param milliseconds is the longest to wait, 0 for not at all, or <0 for
+ * forever.
+ * @return the number of callbacks called, 0 if none, or <0 with errno set
+ * if an error occurred (including EINTR if a signal was caught).
+ */
+extern int loop_wait(loop_t * lp, int milliseconds);
+
+#endif
@@ -24,7 +24,7 @@
  * @param rsp points to the RTCM state.
  * @param csp points to the CPO state.
  */
-void machine_start_all(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
+static inline void machine_start_all(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
     *nsp = HAZER_STATE_START;
     *usp = YODEL_STATE_START;
     *rsp = TUMBLEWEED_STATE_START;
@@ -38,7 +38,7 @@ void machine_start_all(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_stat
  * @param rsp points to the RTCM state.
  * @param csp points to the CPO state.
  */
-void machine_start_nmea(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
+static inline void machine_start_nmea(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
     *nsp = HAZER_STATE_START;
     *usp = YODEL_STATE_STOP;
     *rsp = TUMBLEWEED_STATE_STOP;
@@ -52,7 +52,7 @@ void machine_start_nmea(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_sta
  * @param rsp points to the RTCM state.
  * @param csp points to the CPO state.
  */
-void machine_start_ubx(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
+static inline void machine_start_ubx(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
     *nsp = HAZER_STATE_STOP;
     *usp = YODEL_STATE_START;
     *rsp = TUMBLEWEED_STATE_STOP;
@@ -66,7 +66,7 @@ void machine_start_ubx(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_stat
  * @param rsp points to the RTCM state.
  * @param csp points to the CPO state.
  */
-void machine_start_rtcm(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
+static inline void machine_start_rtcm(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
     *nsp = HAZER_STATE_STOP;
     *usp = YODEL_STATE_STOP;
     *rsp = TUMBLEWEED_STATE_START;
@@ -80,7 +80,7 @@ void machine_start_rtcm(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_sta
  * @param rsp points to the RTCM state.
  * @param csp points to the CPO state.
  */
-void machine_start_cpo(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
+static inline void machine_start_cpo(hazer_state_t * nsp, yodel_state_t * usp, tumbleweed_state_t * rsp, calico_state_t * csp) {
     *nsp = HAZER_STATE_STOP;
     *usp = YODEL_STATE_STOP;
     *rsp = TUMBLEWEED_STATE_STOP;
@@ -0,0 +1,155 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_NTPSHM_
+#define _H_COM_DIAG_HAZER_NTPSHM_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for feeding time to NTP through shared memory.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @see ntpd refclock_shm.c
+ * @see chrony refclock_shm.c
+ * @details
+ * The NTP Shared Memory module publishes time samples to ntpd or chronyd
+ * through the System V shared memory segments used by their SHM reference
+ * clock driver, the same interface gpsd uses. Each sample pairs the time
+ * according to the GNSS receiver (the "clock" time) with the system time
+ * at which that time was valid (the "receive" time). Conventionally unit
+ * 0 carries the coarse time from NMEA or UBX and unit 1 the 1PPS edges.
+ *
+ * Samples are written using the mode 1 protocol: the writer increments
+ * count before and after updating the sample and sets valid last, so a
+ * reader that sees count change while it copies the sample, or that
+ * finds valid clear, knows to discard what it read. Units 0 and 1 are
+ * created readable only by their owner, as ntpd expects; higher units are
+ * created readable by everyone so unprivileged programs can use them.
+ *
+ * e.g. chrony.conf:
+ *
+ * refclock SHM 0 refid GNSS precision 1e-1 offset 0.0 delay 0.2 noselect
+ * refclock SHM 1 refid PPS precision 1e-7 lock GNSS
+ */
+
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include "com/diag/hazer/pulse.h"
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+enum NtpshmConstants {
+    NTPSHM_KEY          = 0x4e545030,   /* "NTP0" */
+    NTPSHM_MODE         = 1,            /* Count and valid protocol. */
+    NTPSHM_PUBLIC       = 2,            /* First world readable unit. */
+};
+
+/**
+ * This is the layout of the NTP SHM segment shared with ntpd and chronyd.
+ * The layout is fixed by those daemons and must not be changed.
+ */
+typedef struct NtpshmTime {
+    int mode;
+    volatile int count;
+    time_t clockTimeStampSec;
+    int clockTimeStampUSec;
+    time_t receiveTimeStampSec;
+    int receiveTimeStampUSec;
+    int leap;
+    int precision;
+    int nsamples;
+    volatile int valid;
+    unsigned clockTimeStampNSec;
+    unsigned receiveTimeStampNSec;
+    int dummy[8];
+} ntpshm_time_t;
+
+/**
+ * These are the NTP leap second indicators.
+ */
+typedef enum NtpshmLeap {
+    NTPSHM_LEAP_NONE        = 0,
+    NTPSHM_LEAP_INSERT      = 1,
+    NTPSHM_LEAP_DELETE      = 2,
+    NTPSHM_LEAP_UNSYNC      = 3,
+} ntpshm_leap_t;
+
+/**
+ * This is one sample as published or as read back.
+ */
+typedef struct NtpshmSample {
+    pulse_nanoseconds_t clock;      /* GNSS time since the POSIX epoch. */
+    pulse_nanoseconds_t receive;    /* System time since the POSIX epoch. */
+    int leap;                       /* ntpshm_leap_t. */
+    int precision;                  /* Log2 seconds e.g. -20 for ~1us. */
+} ntpshm_sample_t;
+
+/**
+ * @def NTPSHM_SAMPLE_INITIALIZER
+ * Initialize a NtpshmSample structure.
+ */
+#define NTPSHM_SAMPLE_INITIALIZER \
+    { 0, 0, NTPSHM_LEAP_NONE, 0, }
+
+/*******************************************************************************
+ * SEGMENTS
+ ******************************************************************************/
+
+/**
+ * Return the System V IPC key used by the NTP SHM driver for a unit.
+ * @param unit is the unit number (0, 1, ...).
+ * @return the key.
+ */
+static inline key_t ntpshm_key(int unit) {
+    return (key_t)(NTPSHM_KEY + unit);
+}
+
+/**
+ * Attach to, creating if necessary, the NTP SHM segment with the specified
+ * key, and initialize it for the mode 1 protocol.
+ * @param key is the System V IPC key, e.g. from ntpshm_key().
+ * @param mode is the permission mode used if the segment is created.
+ * @return a pointer to the segment or NULL for error.
+ */
+extern ntpshm_time_t * ntpshm_attach(key_t key, int mode);
+
+/**
+ * Attach to, creating if necessary, the NTP SHM segment for a unit, with
+ * permissions following the convention used by ntpd.
+ * @param unit is the unit number (0, 1, ...).
+ * @return a pointer to the segment or NULL for error.
+ */
+extern ntpshm_time_t * ntpshm_unit(int unit);
+
+/**
+ * Detach from a NTP SHM segment. The segment itself persists.
+ * @param tp points to the segment.
+ * @return NULL for success, the original pointer for error.
+ */
+extern ntpshm_time_t * ntpshm_detach(ntpshm_time_t * tp);
+
+/*******************************************************************************
+ * SAMPLES
+ ******************************************************************************/
+
+/**
+ * Publish a sample using the mode 1 count and valid protocol.
+ * @param tp points to the segment.
+ * @param sp points to the sample.
+ */
+extern void ntpshm_post(ntpshm_time_t * tp, const ntpshm_sample_t * sp);
+
+/**
+ * Read a sample using the mode 1 count and valid protocol, the way ntpd
+ * and chronyd do, including clearing valid once the sample is consumed.
+ * @param tp points to the segment.
+ * @param sp points to where the sample is stored.
+ * @return 0 for success, <0 with errno set to EAGAIN if there was no valid
+ * sample or it changed while it was being read.
+ */
+extern int ntpshm_read(ntpshm_time_t * tp, ntpshm_sample_t * sp);
+
+#endif
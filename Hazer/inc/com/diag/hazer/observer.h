@@ -0,0 +1,107 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_OBSERVER_
+#define _H_COM_DIAG_HAZER_OBSERVER_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for rate limited observation files.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * An observation file always holds the latest of a series of datagrams,
+ * and is replaced atomically (by writing a temporary file in the same
+ * directory and renaming it) so that a reader never sees a partial one.
+ * Doing that for every datagram costs a create, a write, a close, and a
+ * rename several times a second, which wears out flash storage like the
+ * SD cards in Raspberry Pis. An observer instead keeps a copy of the
+ * latest datagram and commits it to the file at most once per interval;
+ * a datagram that arrives too soon is held, replacing any datagram held
+ * before it, until the interval expires, so the latest datagram is always
+ * committed eventually. Optionally only every Nth commit is synchronized
+ * to the storage device. Times and intervals are in whatever units the
+ * caller uses, typically Diminuto ticks.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/**
+ * This is an observer.
+ */
+typedef struct Observer {
+    char * path;                    /* Path name of the observation file. */
+    char * temp;                    /* Path name of the temporary file. */
+    char * data;                    /* Latest datagram. */
+    size_t size;                    /* Largest datagram in bytes. */
+    size_t length;                  /* Length of the latest datagram. */
+    int64_t interval;               /* Least time between commits. */
+    int64_t then;                   /* Time of the last commit. */
+    unsigned int every;             /* Synchronize every Nth commit or 0. */
+    mode_t mode;                    /* Mode of the observation file. */
+    int dirty;                      /* !0 if the latest isn't committed. */
+    int primed;                     /* !0 once there has been a commit. */
+    uint64_t offered;               /* Datagrams offered. */
+    uint64_t commits;               /* Commits performed. */
+    uint64_t syncs;                 /* Commits synchronized. */
+    uint64_t operations;            /* File system operations performed. */
+    uint64_t errors;                /* Commits that failed. */
+} observer_t;
+
+/**
+ * Initialize an observer.
+ * @param op points to the observer.
+ * @param path is the path name of the observation file.
+ * @param mode is the mode of the observation file.
+ * @param size is the largest datagram in bytes.
+ * @param interval is the least time between commits, 0 for no limit.
+ * @param every synchronizes every Nth commit, 0 for never.
+ * @return a pointer to the observer or NULL if an error occurred.
+ */
+extern observer_t * observer_init(observer_t * op, const char * path, mode_t mode, size_t size, int64_t interval, unsigned int every);
+
+/**
+ * Release the resources held by an observer. A datagram that has not been
+ * committed is not committed.
+ * @param op points to the observer.
+ */
+extern void observer_fini(observer_t * op);
+
+/**
+ * Offer the latest datagram to an observer, which commits it if the
+ * interval has expired and holds it otherwise.
+ * @param op points to the observer.
+ * @param buffer points to the datagram.
+ * @param length is the length of the datagram in bytes.
+ * @param now is the current time.
+ * @return >0 if committed, 0 if held, <0 with errno set if an error occurred.
+ */
+extern int observer_offer(observer_t * op, const void * buffer, size_t length, int64_t now);
+
+/**
+ * Commit the held datagram, if there is one, if the interval has expired.
+ * @param op points to the observer.
+ * @param now is the current time.
+ * @return >0 if committed, 0 if not, <0 with errno set if an error occurred.
+ */
+extern int observer_poll(observer_t * op, int64_t now);
+
+/**
+ * Commit the held datagram, if there is one, regardless of the interval.
+ * @param op points to the observer.
+ * @return >0 if committed, 0 if not, <0 with errno set if an error occurred.
+ */
+extern int observer_flush(observer_t * op);
+
+/**
+ * Return how long until a held datagram can be committed.
+ * @param op points to the observer.
+ * @param now is the current time.
+ * @return the time remaining, 0 if it can be committed now, or <0 if no
+ * datagram is being held.
+ */
+extern int64_t observer_remaining(const observer_t * op, int64_t now);
+
+#endif
@@ -0,0 +1,137 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_PACER_
+#define _H_COM_DIAG_HAZER_PACER_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for pacing recorded data to its original timing.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A pacer releases recorded items, like the messages in a capture or the
+ * records in a trace, at the times at which they were recorded, relative
+ * to the first, optionally sped up by a factor, or as fast as possible.
+ *
+ * Each item's deadline is computed from its recorded time and the time at
+ * which the first item was released, not from the time the prior item was
+ * released, and the pacer sleeps until that absolute deadline with
+ * clock_nanosleep(2) using TIMER_ABSTIME. So the time taken to process an
+ * item, and the time the kernel takes to wake the pacer, delay only that
+ * one item; they don't accumulate into drift the way they would if the
+ * pacer slept for the difference between consecutive items. An item whose
+ * deadline has already passed is released immediately.
+ *
+ * How late each item is released, after its deadline, is kept in a
+ * log-linear histogram from which percentiles of the lateness can be
+ * estimated to within about three percent. When items are released as
+ * fast as possible, there are no deadlines, so no lateness is kept.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+enum PacerConstants {
+    PACER_SHIFT     = 4,                        /* Log2 of linear buckets. */
+    PACER_LINEAR    = 1 << PACER_SHIFT,         /* Linear buckets per power. */
+    PACER_BUCKETS   = (64 - PACER_SHIFT + 1) * PACER_LINEAR,
+};
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * This is a pacer.
+ */
+typedef struct Pacer {
+    double speed;                   /* Speed up factor or 0 for no pacing. */
+    int64_t first;                  /* Recorded time of the first item in ns. */
+    int64_t start;                  /* Monotonic time it was released in ns. */
+    int started;                    /* !0 once the first item is released. */
+    uint64_t items;                 /* Items released. */
+    uint64_t sleeps;                /* Items that were waited for. */
+    uint64_t late;                  /* Items whose deadline had passed. */
+    uint64_t latest;                /* Most late an item was released in ns. */
+    uint64_t total;                 /* Sum of how late items were in ns. */
+    uint64_t bucket[PACER_BUCKETS]; /* Histogram of how late items were. */
+} pacer_t;
+
+/*******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Initialize a pacer.
+ * @param pp points to the pacer.
+ * @param speed is the factor by which recorded time is sped up, for
+ * example 1.0 for real time or 100.0 for one hundred times faster, or 0.0
+ * to release items as fast as possible.
+ * @return a pointer to the pacer or NULL with errno set if the speed is
+ * invalid.
+ */
+extern pacer_t * pacer_init(pacer_t * pp, double speed);
+
+/**
+ * Return the deadline of an item: the monotonic time at which it should be
+ * released. The first item establishes the relationship between recorded
+ * time and monotonic time.
+ * @param pp points to the pacer.
+ * @param stamp is the recorded time of the item in ns.
+ * @return the deadline in ns.
+ */
+extern int64_t pacer_deadline(pacer_t * pp, int64_t stamp);
+
+/**
+ * Account for how late an item was released. This is done by
+ * pacer_wait(), but may also be done by a caller that waits by other
+ * means, for example in a poll(2) with a timeout.
+ * @param pp points to the pacer.
+ * @param lateness is how late the item was in ns.
+ */
+extern void pacer_account(pacer_t * pp, uint64_t lateness);
+
+/**
+ * Wait until the deadline of an item, and account for how late it is.
+ * Recorded times that go backwards are released immediately.
+ * @param pp points to the pacer.
+ * @param stamp is the recorded time of the item in ns.
+ * @return how late the item is in ns.
+ */
+extern int64_t pacer_wait(pacer_t * pp, int64_t stamp);
+
+/**
+ * Write all of an item once it is released, continuing after a write(2)
+ * that is interrupted or that writes only part of it, so that a reader
+ * like a pipe or a pseudo-terminal gets the whole item at its deadline.
+ * @param fd is the file descriptor.
+ * @param data points to the item.
+ * @param length is the length of the item in bytes.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+extern int pacer_write(int fd, const void * data, size_t length);
+
+/**
+ * Restart a pacer so that the next item is released immediately and
+ * becomes the new first item, for example after a seek or a pause.
+ * @param pp points to the pacer.
+ */
+static inline void pacer_restart(pacer_t * pp)
+{
+    pp->started = 0;
+}
+
+/**
+ * Return an estimate of a percentile of how late items were released.
+ * @param pp points to the pacer.
+ * @param percentile is the percentile from 0.0 to 100.0.
+ * @return the estimate in ns.
+ */
+extern uint64_t pacer_percentile(const pacer_t * pp, double percentile);
+
+#endif
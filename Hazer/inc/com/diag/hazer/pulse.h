@@ -0,0 +1,173 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_PULSE_
+#define _H_COM_DIAG_HAZER_PULSE_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for measuring One Pulse Per Second (1PPS) edges.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The Pulse module keeps a ring of the most recent 1PPS edges, each
+ * timestamped with both the real-time and the monotonic clocks as close
+ * to the edge as the capture mechanism allows (the kernel PPS API, a
+ * GPIO character device event, or the return from a DCD wait), and
+ * measures the offset of those edges from the UTC second that the GNSS
+ * receiver says they mark (from UBX-TIM-TP or from NMEA). The jitter is
+ * the standard deviation of the offset, computed incrementally using
+ * Welford's algorithm. Nothing here depends on how the edges or the UTC
+ * times are acquired, so the module can be driven by a simulator.
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * Times are kept as signed nanoseconds since the epoch of their clock.
+ */
+typedef int64_t pulse_nanoseconds_t;
+
+/**
+ * These are the mechanisms by which an edge may have been captured.
+ */
+typedef enum PulseSource {
+    PULSE_SOURCE_NONE       = '?',
+    PULSE_SOURCE_PPS        = 'P',  /* Kernel PPS API (/dev/ppsN). */
+    PULSE_SOURCE_GPIO       = 'G',  /* GPIO character device event. */
+    PULSE_SOURCE_DCD        = 'D',  /* Serial Data Carrier Detect wait. */
+    PULSE_SOURCE_SIMULATED  = 'S',  /* Edge simulator. */
+} pulse_source_t;
+
+/**
+ * This describes one captured edge.
+ */
+typedef struct PulseEdge {
+    pulse_nanoseconds_t realtime;   /* CLOCK_REALTIME at the edge. */
+    pulse_nanoseconds_t monotonic;  /* CLOCK_MONOTONIC at the edge. */
+    uint32_t sequence;              /* Edge sequence number (1..). */
+    uint8_t source;                 /* pulse_source_t. */
+    uint8_t unused[3];
+} pulse_edge_t;
+
+enum PulseConstants {
+    PULSE_EDGES = 16,                           /* Must be a power of two. */
+};
+
+/**
+ * This is one second in nanoseconds.
+ */
+static const pulse_nanoseconds_t PULSE_SECOND = 1000000000LL;
+
+/**
+ * This is the ring of the most recent edges.
+ */
+typedef struct PulseRing {
+    pulse_edge_t edge[PULSE_EDGES];
+    uint32_t sequence;                  /* Total edges ever captured. */
+} pulse_ring_t;
+
+/**
+ * @def PULSE_RING_INITIALIZER
+ * Initialize a PulseRing structure.
+ */
+#define PULSE_RING_INITIALIZER \
+    { { { 0, }, }, 0, }
+
+/**
+ * These are the running offset and jitter statistics.
+ */
+typedef struct PulseStatistics {
+    pulse_nanoseconds_t offset;     /* Most recent offset. */
+    pulse_nanoseconds_t minimum;    /* Minimum offset. */
+    pulse_nanoseconds_t maximum;    /* Maximum offset. */
+    pulse_nanoseconds_t period;     /* Most recent edge to edge interval. */
+    double mean;                    /* Mean offset (Welford). */
+    double m2;                      /* Sum of squared differences (Welford). */
+    uint64_t count;                 /* Number of offsets measured. */
+    uint32_t sequence;              /* Sequence of the last edge measured. */
+} pulse_statistics_t;
+
+/**
+ * @def PULSE_STATISTICS_INITIALIZER
+ * Initialize a PulseStatistics structure.
+ */
+#define PULSE_STATISTICS_INITIALIZER \
+    { 0, 0, 0, 0, 0.0, 0.0, 0, 0, }
+
+/*******************************************************************************
+ * RING
+ ******************************************************************************/
+
+/**
+ * Add an edge to the ring, overwriting the oldest edge if it is full.
+ * @param rp points to the ring.
+ * @param realtime is the CLOCK_REALTIME timestamp of the edge.
+ * @param monotonic is the CLOCK_MONOTONIC timestamp of the edge.
+ * @param source indicates how the edge was captured.
+ * @return the sequence number assigned to the edge.
+ */
+extern uint32_t pulse_ring_put(pulse_ring_t * rp, pulse_nanoseconds_t realtime, pulse_nanoseconds_t monotonic, pulse_source_t source);
+
+/**
+ * Return a pointer to an edge in the ring.
+ * @param rp points to the ring.
+ * @param age is zero for the most recent edge, one for the one before, etc.
+ * @return a pointer to the edge or NULL if there is no such edge.
+ */
+extern const pulse_edge_t * pulse_ring_get(const pulse_ring_t * rp, unsigned int age);
+
+/**
+ * Return a pointer to the edge in the ring whose real-time timestamp is
+ * nearest to the specified time, if it is within the specified window.
+ * @param rp points to the ring.
+ * @param realtime is the time of interest.
+ * @param window is the maximum absolute difference allowed.
+ * @return a pointer to the edge or NULL if there is no such edge.
+ */
+extern const pulse_edge_t * pulse_ring_nearest(const pulse_ring_t * rp, pulse_nanoseconds_t realtime, pulse_nanoseconds_t window);
+
+/*******************************************************************************
+ * STATISTICS
+ ******************************************************************************/
+
+/**
+ * Measure the offset of the edge that marks the specified UTC second,
+ * which is the edge within half a second of it, and fold it into the
+ * statistics. An edge is measured at most once, no matter how many
+ * times its second is reported.
+ * @param sp points to the statistics.
+ * @param rp points to the ring.
+ * @param utc is the UTC time, in nanoseconds since the POSIX epoch, that
+ * the receiver says an edge marks.
+ * @return 0 if an edge was measured, <0 otherwise.
+ */
+extern int pulse_measure(pulse_statistics_t * sp, const pulse_ring_t * rp, pulse_nanoseconds_t utc);
+
+/**
+ * Measure the oldest edge in the ring that is newer than the last edge
+ * measured, and fold it into the statistics. The UTC second it marks is
+ * found by counting whole seconds from a UTC time that the receiver says
+ * some edge marks, which may be an earlier or later edge, or one that
+ * hasn't happened yet. Calling this until it fails measures every edge in
+ * the ring once, in order, no matter how many arrived since the last call.
+ * @param sp points to the statistics.
+ * @param rp points to the ring.
+ * @param utc is the UTC time, in nanoseconds since the POSIX epoch, that
+ * the receiver says an edge marks.
+ * @return 0 if an edge was measured, <0 otherwise.
+ */
+extern int pulse_measure_next(pulse_statistics_t * sp, const pulse_ring_t * rp, pulse_nanoseconds_t utc);
+
+/**
+ * Return the jitter, the standard deviation of the measured offsets.
+ * @param sp points to the statistics.
+ * @return the jitter in nanoseconds.
+ */
+extern double pulse_jitter(const pulse_statistics_t * sp);
+
+#endif
@@ -0,0 +1,126 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_RENDER_
+#define _H_COM_DIAG_HAZER_RENDER_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for rendering integers into text without stdio.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The render functions append text to a buffer and return a pointer
+ * past what they appended, so that a whole line can be built up in a buffer
+ * on the stack and written with a single call. They do no bounds checking;
+ * the caller sizes the buffer for the worst case, for which the RENDER
+ * constants are provided. Integers are converted two decimal digits at a
+ * time using a table, which needs half the divisions of converting them
+ * one digit at a time and none of the format parsing of printf(3).
+ *
+ * Fixed point numbers are integers scaled by a power of ten, like the
+ * nanominutes, millimeters, microknots, and nanodegrees used elsewhere in
+ * Hazer, and are rendered with their sign even when their integral part is
+ * zero.
+ */
+
+#include <stdint.h>
+#include <wchar.h>
+
+/**
+ * These are the most bytes appended by the integer render functions.
+ */
+enum RenderConstants {
+    RENDER_DIGITS   = 20,                       /* Digits in UINT64_MAX. */
+    RENDER_POWERS   = 19,                       /* Powers of ten in uint64_t. */
+    RENDER_INTEGER  = 1 + RENDER_DIGITS,        /* Sign and digits. */
+    RENDER_FIXED    = 1 + RENDER_DIGITS + 1,    /* Sign, digits, and point. */
+};
+
+/**
+ * Append an unsigned integer.
+ * @param bp points to where it is appended.
+ * @param value is the integer.
+ * @return a pointer past what was appended.
+ */
+extern char * render_unsigned(char * bp, uint64_t value);
+
+/**
+ * Append a signed integer.
+ * @param bp points to where it is appended.
+ * @param value is the integer.
+ * @return a pointer past what was appended.
+ */
+extern char * render_signed(char * bp, int64_t value);
+
+/**
+ * Append an unsigned integer with leading zeros to at least a minimum
+ * width, like "%0*llu".
+ * @param bp points to where it is appended.
+ * @param value is the integer.
+ * @param width is the minimum width in digits, at most RENDER_DIGITS.
+ * @return a pointer past what was appended.
+ */
+extern char * render_zeros(char * bp, uint64_t value, int width);
+
+/**
+ * Append a fixed point number as its sign if it is negative, its integral
+ * part, a decimal point, and its fractional part with leading zeros, like
+ * "%lld.%0*llu". A number with no digits ends in the decimal point.
+ * @param bp points to where it is appended.
+ * @param value is the number scaled by ten to the digits.
+ * @param digits is the number of decimal digits, at most RENDER_POWERS.
+ * @return a pointer past what was appended.
+ */
+extern char * render_fixed(char * bp, int64_t value, int digits);
+
+/**
+ * Right justify what was appended since a prior point by inserting leading
+ * spaces to at least a minimum width, like "%*s".
+ * @param begin points to the prior point.
+ * @param bp points past what was appended since.
+ * @param width is the minimum width.
+ * @return a pointer past the justified text.
+ */
+extern char * render_right(char * begin, char * bp, int width);
+
+/**
+ * Append a string truncated or padded with trailing spaces to exactly a
+ * width, like "%-*.*s".
+ * @param bp points to where it is appended.
+ * @param string points to the string.
+ * @param width is the width.
+ * @return a pointer past what was appended.
+ */
+extern char * render_left(char * bp, const char * string, int width);
+
+/**
+ * Append a string, like stpcpy(3).
+ * @param bp points to where it is appended.
+ * @param string points to the string.
+ * @return a pointer past what was appended.
+ */
+extern char * render_string(char * bp, const char * string);
+
+/**
+ * Append a wide character as a multibyte sequence in the current locale,
+ * like "%lc". Nothing is appended if it cannot be represented.
+ * @param bp points to where it is appended, with room for MB_LEN_MAX bytes.
+ * @param wc is the wide character.
+ * @return a pointer past what was appended.
+ */
+extern char * render_wide(char * bp, wint_t wc);
+
+/**
+ * Append a character.
+ * @param bp points to where it is appended.
+ * @param ch is the character.
+ * @return a pointer past what was appended.
+ */
+static inline char * render_char(char * bp, char ch)
+{
+    *(bp++) = ch;
+    return bp;
+}
+
+#endif
@@ -0,0 +1,87 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_SIMPLIFY_
+#define _H_COM_DIAG_HAZER_SIMPLIFY_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for simplifying a path of geographic points.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A path, like the positions in a trace, is simplified with the
+ * Douglas-Peucker algorithm: the first and last points are kept, then the
+ * point farthest from the line between them is kept if it is farther than
+ * a tolerance, and the same is done to the two pieces on either side of
+ * it, until no point is farther than the tolerance from the piece of the
+ * path it lies in. A vehicle driving straight at ten hertz produces a
+ * great many points that a straight line describes to within a meter;
+ * simplification keeps only as many points as the shape of the path
+ * needs, no matter how often it was sampled.
+ *
+ * Distances are in meters, from a point to the segment between two others,
+ * computed in an equirectangular projection centered on the beginning of
+ * the segment. Over the distances between points in a trace this differs
+ * from the distance on the WGS84 ellipsoid by far less than any tolerance
+ * that makes sense.
+ *
+ * REFERENCES
+ *
+ * D. Douglas, T. Peucker, "Algorithms for the reduction of the number of
+ * points required to represent a digitized line or its caricature", The
+ * Canadian Cartographer, 10.2, 1973, pp. 112-122
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/*******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+/**
+ * This is the WGS84 semi-major axis in meters.
+ */
+#define SIMPLIFY_RADIUS (6378137.0)
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * This is a point on a path.
+ */
+typedef struct SimplifyPoint {
+    double latitude;    /* Decimal degrees. */
+    double longitude;   /* Decimal degrees. */
+} simplify_point_t;
+
+/*******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Return the distance from a point to the segment between two others.
+ * @param pp points to the point.
+ * @param ap points to the beginning of the segment.
+ * @param bp points to the end of the segment.
+ * @return the distance in meters.
+ */
+extern double simplify_distance(const simplify_point_t * pp, const simplify_point_t * ap, const simplify_point_t * bp);
+
+/**
+ * Simplify a path by marking the points that are kept. The first and last
+ * points are always kept.
+ * @param points points to the array of points in the path.
+ * @param count is the number of points in the array.
+ * @param tolerance is the tolerance in meters.
+ * @param keep points to an array of count flags that are set to !0 for
+ * each point that is kept and 0 for each one that is not.
+ * @return the number of points kept or <0 with errno set if an error
+ * occurred.
+ */
+extern ssize_t simplify_path(const simplify_point_t * points, size_t count, double tolerance, uint8_t * keep);
+
+#endif
@@ -0,0 +1,149 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_SNAPSHOT_
+#define _H_COM_DIAG_HAZER_SNAPSHOT_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for sharing the current fix through shared memory.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The Snapshot module lets gpstool publish its current view of the world
+ * (the NMEA positions, the active satellites, a summary of the satellites
+ * in view, and the UBX high precision solution, position/velocity/time
+ * solution, and attitude) in a POSIX shared memory region, so that local
+ * consumers can get the latest epoch without tailing and reparsing the
+ * trace CSV or the observation file.
+ *
+ * The region is guarded by a sequence lock. The single writer makes the
+ * sequence number odd, updates the fix in place, and makes it even again.
+ * A reader copies the fix between two reads of the sequence number and
+ * retries if the number was odd or changed. Readers never block the writer
+ * and make no system calls. The region carries a magic number, a version,
+ * and its size, all checked when a reader maps it, so that a reader built
+ * against a different layout fails to open it rather than misreading it.
+ *
+ * Timeouts are copied as is; a field whose timeout is zero has expired.
+ * Label pointers are meaningless outside the writer and are always NULL.
+ */
+
+#include <stdint.h>
+#include "com/diag/hazer/hazer.h"
+#include "com/diag/hazer/yodel.h"
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+enum SnapshotConstants {
+    SNAPSHOT_MAGIC      = 0x485a5353,   /* "HZSS" */
+    SNAPSHOT_VERSION    = 1,            /* Increment when the layout changes. */
+    SNAPSHOT_TRIES      = 1000,         /* Reader retries before giving up. */
+};
+
+/**
+ * This is the default name of the shared memory region.
+ */
+#define SNAPSHOT_NAME "/com-diag-hazer-gpstool"
+
+/**
+ * This summarizes the satellites in view for one signal of one system.
+ */
+typedef struct SnapshotBand {
+    uint8_t visible;                /* Number of satellites in view. */
+    uint8_t channels;               /* Number of channels used in view. */
+    hazer_expiry_t timeout;         /* Timeout in application-defined units. */
+    uint8_t unused[1];
+} snapshot_band_t;
+
+/**
+ * This is the fix as published by the writer and copied by a reader.
+ */
+typedef struct SnapshotFix {
+    hazer_positions_t positions;
+    hazer_actives_t actives;
+    snapshot_band_t views[HAZER_SYSTEM_TOTAL][HAZER_GNSS_SIGNALS];
+    yodel_ubx_nav_hpposllh_t solution;      /* UBX-NAV-HPPOSLLH. */
+    yodel_ubx_nav_pvt_t posveltim;          /* UBX-NAV-PVT. */
+    yodel_ubx_nav_att_t attitude;           /* UBX-NAV-ATT. */
+    hazer_expiry_t solution_timeout;
+    hazer_expiry_t posveltim_timeout;
+    hazer_expiry_t attitude_timeout;
+    uint8_t unused[5];
+} snapshot_fix_t;
+
+/**
+ * This is the layout of the shared memory region.
+ */
+typedef struct SnapshotRegion {
+    uint32_t magic;                 /* SNAPSHOT_MAGIC. */
+    uint32_t version;               /* SNAPSHOT_VERSION. */
+    uint32_t size;                  /* sizeof(snapshot_region_t). */
+    uint32_t sequence;              /* Odd while an update is in progress. */
+    snapshot_fix_t fix;
+} snapshot_region_t;
+
+/*******************************************************************************
+ * WRITER
+ ******************************************************************************/
+
+/**
+ * Create (or reuse) and map a shared memory region for writing.
+ * @param name is the POSIX shared memory name, e.g. SNAPSHOT_NAME.
+ * @return a pointer to the region or NULL for error.
+ */
+extern snapshot_region_t * snapshot_create(const char * name);
+
+/**
+ * Begin an update. The writer may then modify the fix in place.
+ * @param rp points to the region.
+ */
+extern void snapshot_begin(snapshot_region_t * rp);
+
+/**
+ * End an update, publishing the modified fix.
+ * @param rp points to the region.
+ */
+extern void snapshot_end(snapshot_region_t * rp);
+
+/**
+ * Unmap and unlink a shared memory region created by the writer.
+ * @param rp points to the region.
+ * @param name is the POSIX shared memory name.
+ * @return NULL for success, the original pointer for error.
+ */
+extern snapshot_region_t * snapshot_destroy(snapshot_region_t * rp, const char * name);
+
+/*******************************************************************************
+ * READER
+ ******************************************************************************/
+
+/**
+ * Map an existing shared memory region for reading.
+ * @param name is the POSIX shared memory name, e.g. SNAPSHOT_NAME.
+ * @return a pointer to the region or NULL for error, with errno set to
+ * EPROTO if the region has the wrong magic number, version, or size.
+ */
+extern const snapshot_region_t * snapshot_open(const char * name);
+
+/**
+ * Copy a consistent fix out of the region.
+ * @param rp points to the region.
+ * @param fp points to where the fix is copied.
+ * @param sequencep if not NULL points to where the sequence number of the
+ * copied fix is stored; it changes every time a new fix is published.
+ * @return 0 for success, <0 with errno set to EAGAIN if no consistent copy
+ * could be made in SNAPSHOT_TRIES attempts.
+ */
+extern int snapshot_read(const snapshot_region_t * rp, snapshot_fix_t * fp, uint32_t * sequencep);
+
+/**
+ * Unmap a shared memory region mapped by a reader.
+ * @param rp points to the region.
+ * @return NULL for success, the original pointer for error.
+ */
+extern const snapshot_region_t * snapshot_close(const snapshot_region_t * rp);
+
+#endif
@@ -0,0 +1,132 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_STATISTICS_
+#define _H_COM_DIAG_HAZER_STATISTICS_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for mergeable statistics of a series of values.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A statistics object accumulates the count, minimum, maximum, mean, and
+ * variance of a series of values in a single pass, using Welford's method
+ * so that the variance doesn't suffer from the cancellation that summing
+ * squares does, along with a sketch from which percentiles can be
+ * estimated. Two statistics objects accumulated over different parts of a
+ * series, for example by different threads, can be merged into one that
+ * is the same as, or for the sketch about the same as, if it had been
+ * accumulated over the whole series.
+ *
+ * The sketch is a stack of compactors. Values go into the lowest level;
+ * when a level fills, it is sorted and every other value in it is moved
+ * to the next level up, where each value stands for twice as many, and the
+ * rest are discarded. Which half survives alternates from one compaction
+ * to the next so that the errors tend to cancel. Only a few thousand
+ * values are kept no matter how long the series, and the rank of a
+ * percentile is typically within a fraction of a percent of the truth.
+ * Unlike a histogram, the sketch needs no prior knowledge of the range of
+ * the values, and is as accurate for latitudes that differ in the seventh
+ * decimal place as it is for the local clock.
+ *
+ * REFERENCES
+ *
+ * B. Welford, "Note on a method for calculating corrected sums of squares
+ * and products", Technometrics, 4.3, 1962, pp. 419-420
+ *
+ * T. Chan, G. Golub, R. LeVeque, "Updating Formulae and a Pairwise
+ * Algorithm for Computing Sample Variances", STAN-CS-79-773, 1979
+ *
+ * G. Manku, S. Rajagopalan, B. Lindsay, "Approximate Medians and other
+ * Quantiles in One Pass and with Limited Memory", SIGMOD, 1998
+ *
+ * Z. Karnin, K. Lang, E. Liberty, "Optimal Quantile Approximation in
+ * Streams", FOCS, 2016
+ */
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+enum StatisticsConstants {
+    STATISTICS_CAPACITY = 512,      /* Values per level; must be even. */
+    STATISTICS_LEVELS   = 64,       /* Levels, enough for 2^64 values. */
+};
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * These are the statistics of a series of values.
+ */
+typedef struct Statistics {
+    uint64_t count;                         /* Number of values. */
+    double minimum;                         /* Least value. */
+    double maximum;                         /* Greatest value. */
+    double mean;                            /* Running mean. */
+    double m2;                              /* Sum of squared differences. */
+    double * level[STATISTICS_LEVELS];      /* Values each worth 2^level. */
+    uint16_t items[STATISTICS_LEVELS];      /* Number of values in a level. */
+    uint8_t parity[STATISTICS_LEVELS];      /* Half that survives next. */
+} statistics_t;
+
+/*******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Initialize statistics.
+ * @param sp points to the statistics.
+ * @return a pointer to the statistics.
+ */
+extern statistics_t * statistics_init(statistics_t * sp);
+
+/**
+ * Release the memory held by statistics.
+ * @param sp points to the statistics.
+ */
+extern void statistics_fini(statistics_t * sp);
+
+/**
+ * Add a value to statistics.
+ * @param sp points to the statistics.
+ * @param value is the value.
+ * @return 0 for success or <0 with errno set if memory could not be
+ * allocated.
+ */
+extern int statistics_add(statistics_t * sp, double value);
+
+/**
+ * Merge statistics into other statistics. The statistics merged from are
+ * unchanged.
+ * @param sp points to the statistics merged into.
+ * @param that points to the statistics merged from.
+ * @return 0 for success or <0 with errno set if memory could not be
+ * allocated.
+ */
+extern int statistics_merge(statistics_t * sp, const statistics_t * that);
+
+/**
+ * Return the sample variance of the values.
+ * @param sp points to the statistics.
+ * @return the variance or 0 if there are fewer than two values.
+ */
+static inline double statistics_variance(const statistics_t * sp)
+{
+    return (sp->count > 1) ? (sp->m2 / (sp->count - 1)) : 0.0;
+}
+
+/**
+ * Return an estimate of a percentile of the values. The zeroth and the
+ * hundredth percentiles are exactly the minimum and the maximum.
+ * @param sp points to the statistics.
+ * @param percentile is the percentile from 0.0 to 100.0.
+ * @return the estimate or 0 if there are no values.
+ */
+extern double statistics_percentile(const statistics_t * sp, double percentile);
+
+#endif
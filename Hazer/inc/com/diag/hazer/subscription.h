@@ -0,0 +1,174 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_SUBSCRIPTION_
+#define _H_COM_DIAG_HAZER_SUBSCRIPTION_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for filtering RTCM corrections per rover.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A subscription is the list of RTCM message numbers a rover wants to
+ * receive from a router, each with the minimum number of seconds between
+ * two messages of that number; zero means every one. An empty subscription
+ * means every message, which is how rovers have always been served.
+ *
+ * A rover can send its subscription to the router as a control message:
+ * an RTCM message with the proprietary message number SUBSCRIPTION_NUMBER
+ * whose body is, after the twelve bit message number and four bits of
+ * zero, the four octet tag SUBSCRIPTION_TAG (which distinguishes it from
+ * any other proprietary message a base might send with the same number),
+ * a one octet count of rules, and that many rules, each a sixteen bit
+ * message number and a sixteen bit interval in seconds, both in network
+ * byte order. Alternatively the router can read subscriptions
+ * from a file, one per line, each the address of the rover, the port of
+ * the rover (zero for any port), and its rules, separated by white space:
+ *
+ *     # ADDRESS PORT NUMBER[:SECONDS] ...
+ *     192.168.1.10 0 1005:10 1230:10
+ *     2001:db8::1 21010 1005:10 1074 1094 1230:10
+ *
+ * A rule is NUMBER[:SECONDS]. A rover's command line can give the same
+ * rules separated by commas, e.g. 1005:10,1074,1094,1230:10.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+enum SubscriptionConstants {
+    SUBSCRIPTION_NUMBER     = 4095,     /* RTCM number of control messages. */
+    SUBSCRIPTION_RULES      = 16,       /* Maximum rules per subscription. */
+    SUBSCRIPTION_LONGEST    = 3 + 2 + 4 + 1 + (SUBSCRIPTION_RULES * 4) + 3,
+};
+
+/**
+ * @def SUBSCRIPTION_TAG
+ * This tag follows the message number in a control message.
+ */
+#define SUBSCRIPTION_TAG "HZSB"
+
+/**
+ * This is one rule in a subscription.
+ */
+typedef struct SubscriptionRule {
+    uint16_t number;                /* RTCM message number. */
+    uint16_t interval;              /* Minimum seconds between messages. */
+} subscription_rule_t;
+
+/**
+ * This is a subscription.
+ */
+typedef struct Subscription {
+    unsigned int rules;             /* Zero means every message. */
+    subscription_rule_t rule[SUBSCRIPTION_RULES];
+} subscription_t;
+
+/**
+ * @def SUBSCRIPTION_INITIALIZER
+ * Initialize a subscription so that it admits every message.
+ */
+#define SUBSCRIPTION_INITIALIZER { 0, { { 0, 0, }, }, }
+
+/**
+ * This is the state a router keeps for each subscriber: when it last
+ * forwarded a message for each rule.
+ */
+typedef struct SubscriptionState {
+    long forwarded[SUBSCRIPTION_RULES];   /* Seconds, or <0 if never. */
+} subscription_state_t;
+
+/**
+ * This is one line of a subscription file.
+ */
+typedef struct SubscriptionEntry {
+    uint16_t address[8];            /* IPv6 (or IPv4-mapped) address. */
+    uint16_t port;                  /* Port or zero for any port. */
+    subscription_t subscription;
+} subscription_entry_t;
+
+/*******************************************************************************
+ * RULES
+ ******************************************************************************/
+
+/**
+ * Parse rules separated by commas or white space, e.g. "1005:10,1230".
+ * @param string is the string.
+ * @param sp points to the subscription, to which the rules are added.
+ * @return 0 for success, <0 with errno set if a rule is invalid or there
+ * are too many.
+ */
+extern int subscription_parse(const char * string, subscription_t * sp);
+
+/**
+ * Reset the state of a subscriber so that nothing has been forwarded.
+ * @param tp points to the state.
+ */
+extern void subscription_reset(subscription_state_t * tp);
+
+/**
+ * Decide whether a message is forwarded to a subscriber, and if it is,
+ * note that it was.
+ * @param sp points to the subscription.
+ * @param tp points to the state of the subscriber.
+ * @param number is the RTCM message number.
+ * @param now is the current time in seconds.
+ * @return !0 if the message is forwarded, 0 otherwise.
+ */
+extern int subscription_admit(const subscription_t * sp, subscription_state_t * tp, int number, long now);
+
+/*******************************************************************************
+ * CONTROL MESSAGES
+ ******************************************************************************/
+
+/**
+ * Encode a subscription as an RTCM control message, including its CRC.
+ * @param sp points to the subscription.
+ * @param buffer points to where the message is stored.
+ * @param size is the size of the buffer in bytes.
+ * @return the length of the message or <0 if the buffer is too small.
+ */
+extern ssize_t subscription_encode(const subscription_t * sp, void * buffer, size_t size);
+
+/**
+ * Decode an RTCM control message that has already been validated.
+ * @param buffer points to the message.
+ * @param length is the length of the message in bytes.
+ * @param sp points to where the subscription is stored.
+ * @return 0 for success, <0 if the message is not a valid control message.
+ */
+extern int subscription_decode(const void * buffer, size_t length, subscription_t * sp);
+
+/*******************************************************************************
+ * FILES
+ ******************************************************************************/
+
+/**
+ * Load a subscription file.
+ * @param path is the path name of the file.
+ * @param entriesp points to where a pointer to a dynamically allocated
+ * array of entries is stored; the caller frees it.
+ * @param linep points to where the number of the line in error is stored,
+ * or zero if the error isn't in a line, or is NULL.
+ * @return the number of entries or <0 with errno set if an error occurred.
+ */
+extern ssize_t subscription_load(const char * path, subscription_entry_t ** entriesp, unsigned int * linep);
+
+/**
+ * Find the subscription for a rover. An entry with a port of zero matches
+ * any port; an entry with a matching port is preferred.
+ * @param entries points to the array of entries.
+ * @param count is the number of entries.
+ * @param address is the address of the rover.
+ * @param port is the port of the rover.
+ * @return a pointer to the subscription or NULL if there is none.
+ */
+extern const subscription_t * subscription_lookup(const subscription_entry_t * entries, size_t count, const uint16_t address[8], uint16_t port);
+
+#endif
@@ -0,0 +1,312 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_TRACE_
+#define _H_COM_DIAG_HAZER_TRACE_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for the binary trace format.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A binary trace file holds the same columns as the CSV trace that gpstool
+ * writes with -T, but as fixed size records that need no formatting to
+ * write and no parsing to read, and which can be accessed in place by
+ * mapping the file into memory. The file begins with a header that
+ * identifies the format, its version, its byte order, and the size of the
+ * records that follow it, and is followed by any number of records.
+ *
+ * Each numeric column is kept as a signed integer scaled by a power of ten
+ * along with the number of decimal digits it has (or TRACE_INTEGER if it is
+ * an integer), exactly as gpstool would have formatted it. So a record can
+ * be converted to the CSV line that gpstool would have written, and a CSV
+ * line can be converted to a record, without any loss of precision. A
+ * missing column is zero with no digits, which is what the CSV calls "0.".
+ *
+ * Records are written in the byte order of the host that wrote them; the
+ * header allows a reader to detect a file written by a host with a
+ * different byte order.
+ *
+ * The flags of a record are encoded in the CSV as characters at the end of
+ * the host name: "#" if the record was decoded from a single message, as
+ * decodetool does, instead of from the state gpstool accumulates over many
+ * messages, and then "!" if a SIGHUP was received.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+/*******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+/**
+ * These are the columns of a trace record, in the order in which they
+ * appear in the CSV.
+ */
+typedef enum TraceColumn {
+    TRACE_NAM   = 0,    /* Host name (string, not numeric). */
+    TRACE_NUM,          /* Sequence number. */
+    TRACE_FIX,          /* Fix type. */
+    TRACE_SYS,          /* GNSS system. */
+    TRACE_SAT,          /* Satellites used. */
+    TRACE_CLK,          /* Local clock seconds. */
+    TRACE_TIM,          /* GNSS time seconds. */
+    TRACE_LAT,          /* Latitude degrees. */
+    TRACE_LON,          /* Longitude degrees. */
+    TRACE_HAC,          /* Horizontal accuracy meters. */
+    TRACE_MSL,          /* Altitude above Mean Sea Level meters. */
+    TRACE_GEO,          /* Altitude above the WGS84 ellipsoid meters. */
+    TRACE_VAC,          /* Vertical accuracy meters. */
+    TRACE_SOG,          /* Speed Over Ground knots. */
+    TRACE_COG,          /* Course Over Ground degrees. */
+    TRACE_ROL,          /* Roll degrees. */
+    TRACE_PIT,          /* Pitch degrees. */
+    TRACE_YAW,          /* Yaw degrees. */
+    TRACE_RAC,          /* Roll accuracy degrees. */
+    TRACE_PAC,          /* Pitch accuracy degrees. */
+    TRACE_YAC,          /* Yaw accuracy degrees. */
+    TRACE_OBS,          /* Survey observations. */
+    TRACE_MAC,          /* Survey mean accuracy meters. */
+    TRACE_COLUMNS,      /* Number of columns. */
+} trace_column_t;
+
+enum TraceConstants {
+    TRACE_VERSION   = 1,        /* Version of the record layout. */
+    TRACE_ORDER     = 0x0102,   /* Byte order mark. */
+    TRACE_NAME      = 64,       /* Largest host name including NUL. */
+    TRACE_DIGITS    = 18,       /* Most decimal digits in a column. */
+    TRACE_INTEGER   = -1,       /* Digits of an integer column. */
+    TRACE_LINE      = 640,      /* Large enough for any CSV line. */
+};
+
+/**
+ * These are the bits in the flags of a trace record.
+ */
+enum TraceFlags {
+    TRACE_FLAG_HANGUP   = (1 << 0),     /* A SIGHUP was received. */
+    TRACE_FLAG_MESSAGE  = (1 << 1),     /* Decoded from a single message. */
+};
+
+/**
+ * This is the magic number at the beginning of a trace file.
+ */
+#define TRACE_MAGIC "HZTR"
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * This is the header at the beginning of a trace file.
+ */
+typedef struct TraceHeader {
+    char magic[4];                  /* TRACE_MAGIC without its NUL. */
+    uint16_t version;               /* TRACE_VERSION. */
+    uint16_t order;                 /* TRACE_ORDER in host byte order. */
+    uint16_t size;                  /* Size of each record in bytes. */
+    uint16_t columns;               /* TRACE_COLUMNS. */
+    uint32_t reserved;              /* Zero. */
+} trace_header_t;
+
+/**
+ * This is a trace record. The value and digits of the TRACE_NAM column
+ * are unused.
+ */
+typedef struct TraceRecord {
+    int64_t value[TRACE_COLUMNS];   /* Value scaled by ten to the digits. */
+    int8_t digits[TRACE_COLUMNS];   /* Decimal digits or TRACE_INTEGER. */
+    uint8_t flags;                  /* TRACE_FLAG bits. */
+    char name[TRACE_NAME];          /* Host name, NUL terminated. */
+} trace_record_t;
+
+/**
+ * This is the kind of trace that was read.
+ */
+typedef enum TraceKind {
+    TRACE_EMPTY     = 0,            /* There was nothing to read. */
+    TRACE_CSV       = 'C',          /* CSV lines written by gpstool -T. */
+    TRACE_BINARY    = 'B',          /* Binary trace written with -T and -3. */
+} trace_kind_t;
+
+/**
+ * A trace callback is called for every line of a CSV trace, with the record
+ * parsed from it or NULL if the line is not a record (for example the
+ * headings), and for every record of a binary trace, with a NULL line.
+ * @param context is the context given to the reader.
+ * @param rp points to the record or is NULL.
+ * @param line points to the NUL terminated line or is NULL.
+ * @return 0 to continue, >0 to stop, or <0 to stop because of an error.
+ */
+typedef int (trace_callback_t)(void * context, const trace_record_t * rp, const char * line);
+
+/**
+ * This describes a CSV or binary trace file mapped into memory.
+ */
+typedef struct TraceMap {
+    const char * base;              /* Beginning of the file. */
+    size_t length;                  /* Length of the file in bytes. */
+    const trace_record_t * records; /* First record if binary or NULL. */
+    size_t count;                   /* Number of records if binary. */
+    trace_kind_t kind;              /* Kind of trace. */
+} trace_map_t;
+
+/*******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Return the CSV heading of a column.
+ * @param column is the column.
+ * @return the heading or "" if the column is invalid.
+ */
+extern const char * trace_heading(trace_column_t column);
+
+/**
+ * Initialize a trace file header.
+ * @param hp points to the header.
+ * @return a pointer to the header.
+ */
+extern trace_header_t * trace_header_init(trace_header_t * hp);
+
+/**
+ * Check a trace file header for a format, version, byte order, and record
+ * size that this code can read.
+ * @param hp points to the header.
+ * @return 0 if it can be read, <0 with errno set otherwise.
+ */
+extern int trace_header_check(const trace_header_t * hp);
+
+/**
+ * Return the records in a trace file that is in memory, for example
+ * because it has been mapped into memory. A partial record at the end,
+ * perhaps because the file is still being written, is ignored.
+ * @param base points to the beginning of the file.
+ * @param length is the length of the file in bytes.
+ * @param countp points to where the number of records is returned.
+ * @return a pointer to the first record or NULL with errno set if the
+ * file is not a trace file this code can read.
+ */
+extern const trace_record_t * trace_records(const void * base, size_t length, size_t * countp);
+
+/**
+ * Initialize a trace record in which every column is missing.
+ * @param rp points to the record.
+ * @param name is the host name, which is truncated if necessary.
+ * @param flags are the TRACE_FLAG bits.
+ * @return a pointer to the record.
+ */
+extern trace_record_t * trace_record_init(trace_record_t * rp, const char * name, uint8_t flags);
+
+/**
+ * Set a column in a trace record.
+ * @param rp points to the record.
+ * @param column is the column.
+ * @param value is the value scaled by ten to the digits.
+ * @param digits is the number of decimal digits or TRACE_INTEGER.
+ */
+static inline void trace_record_set(trace_record_t * rp, trace_column_t column, int64_t value, int digits)
+{
+    rp->value[column] = value;
+    rp->digits[column] = digits;
+}
+
+/**
+ * Return a column value as a double. This is the same double as parsing
+ * the column as formatted, since ten to the digits is exact.
+ * @param value is the value scaled by ten to the digits.
+ * @param digits is the number of decimal digits or TRACE_INTEGER.
+ * @return the value.
+ */
+extern double trace_number(int64_t value, int digits);
+
+/**
+ * Format a trace record as the CSV line, including the terminating
+ * newline, that gpstool would have written.
+ * @param rp points to the record.
+ * @param buffer points to the buffer.
+ * @param size is the size of the buffer in bytes, at least TRACE_LINE.
+ * @return the length of the line not including its NUL or <0 with errno
+ * set if the buffer is too small or a column has invalid digits.
+ */
+extern ssize_t trace_format(const trace_record_t * rp, char * buffer, size_t size);
+
+/**
+ * Parse a CSV line written by gpstool into a trace record.
+ * @param rp points to the record.
+ * @param line points to the NUL terminated line.
+ * @return 0 for success, <0 with errno set if the line is not a record,
+ * for example because it is the headings.
+ */
+extern int trace_parse(trace_record_t * rp, const char * line);
+
+/**
+ * Map a CSV or binary trace file into memory. Binary traces are recognized
+ * by their header, which is shorter than any CSV line.
+ * @param mp points to the map.
+ * @param fd is the file descriptor of the file.
+ * @return a pointer to the map, or NULL with errno set if the file is not a
+ * regular file, or could not be mapped, or is a binary trace with a header
+ * this code cannot read; the caller may read it with trace_read() instead.
+ */
+extern trace_map_t * trace_map(trace_map_t * mp, int fd);
+
+/**
+ * Release a map returned by trace_map().
+ * @param mp points to the map.
+ */
+extern void trace_unmap(trace_map_t * mp);
+
+/**
+ * Call a callback for every CSV line in memory, including a last line that
+ * has no newline. A line too long to be a record is truncated, so that it
+ * does not parse and is passed to the callback as a line that is not a
+ * record.
+ * @param data points to the lines.
+ * @param length is the length of the lines in bytes.
+ * @param callback is the callback.
+ * @param context is passed to the callback.
+ * @return 0 when done, or the first non-zero value returned by the callback.
+ */
+extern int trace_lines(const char * data, size_t length, trace_callback_t * callback, void * context);
+
+/**
+ * Call a callback for every line or record in a CSV or binary trace file
+ * that is mapped into memory.
+ * @param mp points to the map.
+ * @param callback is the callback.
+ * @param context is passed to the callback.
+ * @return 0 when done, or the first non-zero value returned by the callback.
+ */
+extern int trace_mapped(const trace_map_t * mp, trace_callback_t * callback, void * context);
+
+/**
+ * Call a callback for every line or record in a CSV or binary trace read
+ * from a stream. CSV is read a line at a time, so that a trace still being
+ * written, and read through a pipe, is passed on as it arrives.
+ * @param fp points to the stream.
+ * @param callback is the callback.
+ * @param context is passed to the callback.
+ * @param kindp points to where the kind of trace is returned, or is NULL.
+ * @return 0 at the end of the stream, the first non-zero value returned by
+ * the callback, or <0 with errno set if the stream could not be read.
+ */
+extern int trace_read(FILE * fp, trace_callback_t * callback, void * context, trace_kind_t * kindp);
+
+/**
+ * Call a callback for every line or record in a CSV or binary trace on a
+ * stream, mapping it into memory if it is a regular file and reading it
+ * otherwise.
+ * @param fp points to the stream.
+ * @param callback is the callback.
+ * @param context is passed to the callback.
+ * @param kindp points to where the kind of trace is returned, or is NULL.
+ * @return 0 when done, the first non-zero value returned by the callback,
+ * or <0 with errno set if the trace could not be read.
+ */
+extern int trace_input(FILE * fp, trace_callback_t * callback, void * context, trace_kind_t * kindp);
+
+#endif
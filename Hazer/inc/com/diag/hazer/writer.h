@@ -0,0 +1,185 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+#ifndef _H_COM_DIAG_HAZER_WRITER_
+#define _H_COM_DIAG_HAZER_WRITER_
+
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief Common facilities for writing output files in the background.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A writer moves the write(2) system calls for an output file out of the
+ * thread that produces the output and into a background thread of its
+ * own, so that a write that stalls, as writes to the SD cards in Raspberry
+ * Pis occasionally do for hundreds of milliseconds, stalls only the writer
+ * and not the processing of input. Each output file has its own writer, so
+ * that a stall on one file doesn't hold up another.
+ *
+ * The producer appends data into the buffer it is filling. The buffer is
+ * handed off to the writer thread when it is full (size), when the oldest
+ * data in it has waited for the latency (time), or when the producer
+ * flushes it (epoch), and the producer starts filling the next buffer.
+ * Filled buffers are passed through a ring that has a single producer and
+ * a single consumer, each of which only advances its own index, so neither
+ * takes a lock; an eventfd wakes the writer thread when a buffer is handed
+ * off. With two buffers the writer is double buffered: one is filled while
+ * the other is written.
+ *
+ * ORDERING: Data is written to the file in exactly the order in which it
+ * was appended. An append is never split between buffers, so if the writer
+ * falls so far behind that every buffer is waiting to be written, which is
+ * the only way the producer can't append, whole appends are dropped (and
+ * counted) rather than blocking the producer. Writers for different files
+ * are independent, so there is no ordering between files.
+ *
+ * CRASH SAFETY: Buffers are written with write(2) and are not synchronized
+ * to the storage device, just as stdio would have. When the writer is
+ * finalized, everything appended is written before it returns. If the
+ * process dies without finalizing the writer, the data appended since the
+ * last hand off, plus any buffers not yet written, are lost; the latency
+ * bounds how old that data can be. A partial write only happens at the end
+ * of the file, so everything before it is intact.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <sys/types.h>
+
+/*******************************************************************************
+ * CONSTANTS
+ ******************************************************************************/
+
+enum WriterConstants {
+    WRITER_SLOTS    = 2,            /* Default buffers: double buffered. */
+    WRITER_SIZE     = 65536,        /* Default bytes per buffer. */
+};
+
+/**
+ * This is the default latency in nanoseconds.
+ */
+#define WRITER_LATENCY (1000000000LL)
+
+/*******************************************************************************
+ * TYPES
+ ******************************************************************************/
+
+/**
+ * This is one buffer in the ring.
+ */
+typedef struct WriterSlot {
+    char * data;                    /* Storage for the buffer. */
+    size_t length;                  /* Bytes in the buffer. */
+} writer_slot_t;
+
+/**
+ * This is a writer. The counters maintained by the writer thread may be
+ * read at any time, and are final once the writer has been finalized.
+ */
+typedef struct Writer {
+    FILE * fp;                      /* Stream whose file is written. */
+    writer_slot_t * slot;           /* Ring of buffers. */
+    char * storage;                 /* Storage for all of the buffers. */
+    size_t size;                    /* Bytes of storage per buffer. */
+    unsigned int slots;             /* Number of buffers in the ring. */
+    int64_t latency;                /* Longest wait before hand off in ns. */
+    int64_t then;                   /* When the filling buffer began in ns. */
+    uint64_t head;                  /* Buffers handed off (producer). */
+    uint64_t tail;                  /* Buffers written (writer thread). */
+    int doorbell;                   /* eventfd that wakes the writer thread. */
+    int done;                       /* !0 when the writer thread should exit. */
+    int running;                    /* !0 while the writer thread exists. */
+    pthread_t thread;               /* Writer thread. */
+    uint64_t appended;              /* Bytes appended. */
+    uint64_t dropped;               /* Bytes dropped. */
+    uint64_t drops;                 /* Appends dropped. */
+    uint64_t handoffs;              /* Buffers handed off. */
+    uint64_t deepest;               /* Most buffers waiting at a hand off. */
+    uint64_t written;               /* Bytes written (writer thread). */
+    uint64_t stalled;               /* Total ns in write(2) (writer thread). */
+    uint64_t longest;               /* Longest ns in write(2) (writer thread). */
+    uint64_t errors;                /* Buffers failed (writer thread). */
+    int error;                      /* Latest errno (writer thread). */
+} writer_t;
+
+/*******************************************************************************
+ * FUNCTIONS
+ ******************************************************************************/
+
+/**
+ * Initialize a writer for the file underlying a stream and start its
+ * thread. The stream shouldn't be written through stdio while the writer
+ * exists. The writer thread blocks all signals.
+ * @param wp points to the writer.
+ * @param fp points to the stream.
+ * @param slots is the number of buffers, at least two.
+ * @param size is the size of each buffer in bytes.
+ * @param latency is the longest data waits before hand off in ns, 0 for
+ * no limit.
+ * @return a pointer to the writer or NULL with errno set if an error
+ * occurred.
+ */
+extern writer_t * writer_init(writer_t * wp, FILE * fp, unsigned int slots, size_t size, int64_t latency);
+
+/**
+ * Hand off the buffer being filled, stop the writer thread after it has
+ * written everything handed off to it, and release the resources held by
+ * the writer. The stream is not closed.
+ * @param wp points to the writer.
+ * @return 0 if every buffer was written, <0 with errno set otherwise.
+ */
+extern int writer_fini(writer_t * wp);
+
+/**
+ * Append data to the buffer being filled, handing the buffer off first if
+ * the data won't fit in it. The data is dropped if no buffer is free.
+ * @param wp points to the writer.
+ * @param data points to the data.
+ * @param length is the length of the data in bytes.
+ * @return the length or <0 with errno set if the data was dropped.
+ */
+extern ssize_t writer_append(writer_t * wp, const void * data, size_t length);
+
+/**
+ * Hand off the buffer being filled if it isn't empty, for example at the
+ * end of an epoch.
+ * @param wp points to the writer.
+ * @return >0 if it was handed off, 0 if it was empty, <0 with errno set if
+ * an error occurred.
+ */
+extern int writer_flush(writer_t * wp);
+
+/**
+ * Hand off the buffer being filled if its oldest data has waited for the
+ * latency. This is called periodically so that data isn't held
+ * indefinitely when little is being appended.
+ * @param wp points to the writer.
+ * @return >0 if it was handed off, 0 if not, <0 with errno set if an error
+ * occurred.
+ */
+extern int writer_service(writer_t * wp);
+
+/**
+ * Return the number of buffers handed off and not yet written.
+ * @param wp points to the writer.
+ * @return the depth of the ring.
+ */
+extern unsigned int writer_depth(const writer_t * wp);
+
+/**
+ * Return an unbuffered stream that appends everything written to it to
+ * the writer, so that code that writes to a stream can use a writer
+ * unchanged. Each call that writes to the stream is one append. Data that
+ * is dropped is still reported as written, so that a stall doesn't put the
+ * stream in an error state; the drop is counted in the writer, and closing
+ * the stream fails with ENOBUFS. Closing the stream finalizes the writer
+ * and closes the stream passed to writer_init().
+ * @param wp points to the writer.
+ * @return the stream or NULL with errno set if an error occurred.
+ */
+extern FILE * writer_stream(writer_t * wp);
+
+#endif
@@ -1421,7 +1421,7 @@ enum YodelUbxNavTimeutcConstants {
 };
 
 /**
- * UBX-NAV-TIMEUTC (0x01, 0x21) [16] carries the UTC time solution.
+ * UBX-NAV-TIMEUTC (0x01, 0x21) [20] carries the UTC time solution.
  * Ublox 8 R24, p. 400.
  */
 typedef struct YodelUbxNavTimeutc {
@@ -1444,7 +1444,25 @@ typedef struct YodelUbxNavTimeutc {
 #define YODEL_UBX_NAV_TIMEUTC_INITIALIZER \
     { 0, }
 
-#if 0
+/**
+ * UBX-NAV-TIMEUTC.valid masks.
+ * Ublox 8 R24, p. 400.
+ */
+enum YodelUbxNavTimeutcValidMasks {
+    YODEL_UBX_NAV_TIMEUTC_valid_validTOW_MASK   = 0x1,
+    YODEL_UBX_NAV_TIMEUTC_valid_validWKN_MASK   = 0x1,
+    YODEL_UBX_NAV_TIMEUTC_valid_validUTC_MASK   = 0x1,
+};
+
+/**
+ * UBX-NAV-TIMEUTC.valid left shifts.
+ */
+enum YodelUbxNavTimeutcValidShifts {
+    YODEL_UBX_NAV_TIMEUTC_valid_validTOW_SHIFT  = 0,
+    YODEL_UBX_NAV_TIMEUTC_valid_validWKN_SHIFT  = 1,
+    YODEL_UBX_NAV_TIMEUTC_valid_validUTC_SHIFT  = 2,
+};
+
 /**
  * Process a possible UBX-NAV-TIMEUTC message.
  * If <0 is returned, errno is set to >0 if the sentence is malformed.
@@ -1454,7 +1472,6 @@ typedef struct YodelUbxNavTimeutc {
  * @return 0 if the message was valid, <0 otherwise.
  */
 extern int yodel_ubx_nav_timeutc(yodel_ubx_nav_timeutc_t * mp, const void * buffer, ssize_t length);
-#endif
 
 /*******************************************************************************
  * PROCESSING UBX-NAV-CLOCK MESSAGES
@@ -1527,7 +1544,30 @@ typedef struct YodelUbxTimTp {
 #define YODEL_UBX_TIM_TP_INITIALIZER \
     { 0, }
 
-#if 0
+/**
+ * UBX-TIM-TP.flags masks.
+ */
+enum YodelUbxTimTpFlagsMasks {
+    YODEL_UBX_TIM_TP_flags_timeBase_MASK        = 0x1,
+    YODEL_UBX_TIM_TP_flags_utc_MASK             = 0x1,
+};
+
+/**
+ * UBX-TIM-TP.flags left shifts.
+ */
+enum YodelUbxTimTpFlagsShifts {
+    YODEL_UBX_TIM_TP_flags_timeBase_SHIFT       = 0,
+    YODEL_UBX_TIM_TP_flags_utc_SHIFT            = 1,
+};
+
+/**
+ * UBX-TIM-TP.flags timeBase values.
+ */
+enum YodelUbxTimTpFlagsTimeBase {
+    YODEL_UBX_TIM_TP_flags_timeBase_GNSS        = 0,
+    YODEL_UBX_TIM_TP_flags_timeBase_UTC         = 1,
+};
+
 /**
  * Process a possible UBX-TIM-TP message.
  * If <0 is returned, errno is set to >0 if the sentence is malformed.
@@ -1536,8 +1576,7 @@ typedef struct YodelUbxTimTp {
  * @param length is the length of the header, payload, and checksum in bytes.
  * @return 0 if the message was valid, <0 otherwise.
  */
-extern int int yodel_ubx_tim_tp(yodel_ubx_tim_tp_t * mp, const void * buffer, ssize_t length);
-#endif
+extern int yodel_ubx_tim_tp(yodel_ubx_tim_tp_t * mp, const void * buffer, ssize_t length);
 
 /*******************************************************************************
  * PROCESSING UBX-RXM-RAWX MESSAGES
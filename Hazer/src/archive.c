@@ -0,0 +1,557 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Archive module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "com/diag/hazer/archive.h"
+
+/*******************************************************************************
+ * ENCODING
+ ******************************************************************************/
+
+static inline uint64_t archive_zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline int64_t archive_zagzig(uint64_t value)
+{
+    return (int64_t)((value >> 1) ^ (~(value & 1) + 1));
+}
+
+static inline size_t archive_varint_size(uint64_t value)
+{
+    size_t size = 1;
+
+    while (value >= 0x80) {
+        value >>= 7;
+        size += 1;
+    }
+
+    return size;
+}
+
+static inline uint8_t * archive_varint_put(uint8_t * here, uint64_t value)
+{
+    while (value >= 0x80) {
+        *(here++) = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    *(here++) = (uint8_t)value;
+
+    return here;
+}
+
+/**
+ * Decode a varint.
+ * @param here points to the varint.
+ * @param end points just past the data.
+ * @param valuep points to where the value is returned.
+ * @return a pointer past the varint or NULL if it is truncated or too long.
+ */
+static inline const uint8_t * archive_varint_get(const uint8_t * here, const uint8_t * end, uint64_t * valuep)
+{
+    uint64_t value = 0;
+    int shift = 0;
+
+    while ((here < end) && (shift < 64)) {
+        value |= ((uint64_t)(*here & 0x7f)) << shift;
+        if ((*(here++) & 0x80) == 0) {
+            *valuep = value;
+            return here;
+        }
+        shift += 7;
+    }
+
+    return (const uint8_t *)0;
+}
+
+/**
+ * Encode a numeric column, or the flags, of the records in the chunk being
+ * accumulated, choosing whichever encoding is smaller.
+ * @param ap points to the archive.
+ * @param column is the column.
+ * @param zp points to the zone map of the column.
+ * @param here points to where the data is encoded.
+ * @return a pointer past the data.
+ */
+static uint8_t * archive_encode(const archive_t * ap, int column, archive_zone_t * zp, uint8_t * here)
+{
+    const trace_record_t * rp = ap->buffer;
+    int64_t value = 0;
+    int64_t previous = 0;
+    double number = 0.0;
+    size_t varint = 0;
+    size_t delta = 0;
+    uint32_t ii = 0;
+
+    zp->digits = (column == ARCHIVE_FLG) ? TRACE_INTEGER : rp[0].digits[column];
+
+    for (ii = 0; ii < ap->count; ++ii) {
+        if (column == ARCHIVE_FLG) {
+            value = rp[ii].flags;
+        } else {
+            value = rp[ii].value[column];
+            if (rp[ii].digits[column] != zp->digits) {
+                zp->digits = ARCHIVE_MIXED;
+            }
+        }
+        number = (column == ARCHIVE_FLG) ? value : trace_number(value, rp[ii].digits[column]);
+        if ((ii == 0) || (number < zp->minimum)) {
+            zp->minimum = number;
+        }
+        if ((ii == 0) || (number > zp->maximum)) {
+            zp->maximum = number;
+        }
+        varint += archive_varint_size(archive_zigzag(value));
+        delta += archive_varint_size(archive_zigzag((int64_t)((uint64_t)value - (uint64_t)previous)));
+        previous = value;
+    }
+
+    zp->encoding = (delta < varint) ? ARCHIVE_DELTA : ARCHIVE_VARINT;
+
+    if (zp->digits == ARCHIVE_MIXED) {
+        for (ii = 0; ii < ap->count; ++ii) {
+            *(here++) = (uint8_t)rp[ii].digits[column];
+        }
+    }
+
+    /*
+     * Differences are computed modulo two to the sixty-fourth, so that
+     * they can't overflow and still decode to exactly the same values.
+     */
+
+    for (ii = 0, previous = 0; ii < ap->count; ++ii) {
+        value = (column == ARCHIVE_FLG) ? rp[ii].flags : rp[ii].value[column];
+        if (zp->encoding == ARCHIVE_DELTA) {
+            here = archive_varint_put(here, archive_zigzag((int64_t)((uint64_t)value - (uint64_t)previous)));
+        } else {
+            here = archive_varint_put(here, archive_zigzag(value));
+        }
+        previous = value;
+    }
+
+    return here;
+}
+
+/**
+ * Encode the host names of the records in the chunk being accumulated.
+ * @param ap points to the archive.
+ * @param zp points to the zone map of the column.
+ * @param here points to where the data is encoded.
+ * @return a pointer past the data.
+ */
+static uint8_t * archive_encode_names(const archive_t * ap, archive_zone_t * zp, uint8_t * here)
+{
+    const trace_record_t * rp = ap->buffer;
+    uint32_t ii = 0;
+    uint32_t jj = 0;
+    size_t length = 0;
+
+    zp->encoding = ARCHIVE_RUNS;
+    zp->digits = TRACE_INTEGER;
+
+    for (ii = 0; ii < ap->count; ii = jj) {
+        for (jj = ii + 1; jj < ap->count; ++jj) {
+            if (strncmp(rp[ii].name, rp[jj].name, sizeof(rp[ii].name)) != 0) {
+                break;
+            }
+        }
+        here = archive_varint_put(here, jj - ii);
+        length = strnlen(rp[ii].name, sizeof(rp[ii].name) - 1);
+        memcpy(here, rp[ii].name, length);
+        here += length;
+        *(here++) = '\0';
+    }
+
+    return here;
+}
+
+/*******************************************************************************
+ * WRITING
+ ******************************************************************************/
+
+archive_t * archive_init(archive_t * ap, FILE * fp, uint32_t rows)
+{
+    archive_t * result = (archive_t *)0;
+    archive_header_t header;
+
+    memset(ap, 0, sizeof(*ap));
+    ap->fp = fp;
+    ap->rows = (rows == 0) ? ARCHIVE_ROWS : rows;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, ARCHIVE_MAGIC, sizeof(header.magic));
+    header.version = ARCHIVE_VERSION;
+    header.order = ARCHIVE_ORDER;
+    header.columns = ARCHIVE_COLUMNS;
+    header.size = sizeof(archive_chunk_t);
+    header.rows = ap->rows;
+
+    /*
+     * The encoded chunk can be no larger than a digit and the longest
+     * varint for every value of every column, and the longest varint and
+     * name for every record.
+     */
+
+    if (ap->rows > ARCHIVE_LIMIT) {
+        errno = EINVAL;
+    } else if ((ap->buffer = (trace_record_t *)malloc(ap->rows * sizeof(trace_record_t))) == (trace_record_t *)0) {
+        /* Do nothing. */
+    } else if ((ap->data = (uint8_t *)malloc(sizeof(archive_chunk_t) + (ap->rows * ((ARCHIVE_COLUMNS * (1 + ARCHIVE_VARINTS)) + TRACE_NAME)) + ARCHIVE_ALIGN)) == (uint8_t *)0) {
+        /* Do nothing. */
+    } else if (fwrite(&header, sizeof(header), 1, fp) < 1) {
+        /* Do nothing. */
+    } else {
+        ap->bytes = sizeof(header);
+        result = ap;
+    }
+
+    if (result == (archive_t *)0) {
+        free(ap->buffer);
+        free(ap->data);
+        ap->buffer = (trace_record_t *)0;
+        ap->data = (uint8_t *)0;
+    }
+
+    return result;
+}
+
+int archive_flush(archive_t * ap)
+{
+    int rc = 0;
+    archive_chunk_t * cp = (archive_chunk_t *)0;
+    uint8_t * here = (uint8_t *)0;
+    int ii = 0;
+
+    if (ap->count > 0) {
+
+        cp = (archive_chunk_t *)ap->data;
+        memset(cp, 0, sizeof(*cp));
+        cp->rows = ap->count;
+        here = ap->data + sizeof(*cp);
+
+        for (ii = 0; ii < ARCHIVE_COLUMNS; ++ii) {
+            cp->zone[ii].offset = here - ap->data;
+            if (ii == TRACE_NAM) {
+                here = archive_encode_names(ap, &(cp->zone[ii]), here);
+            } else {
+                here = archive_encode(ap, ii, &(cp->zone[ii]), here);
+            }
+            cp->zone[ii].length = (here - ap->data) - cp->zone[ii].offset;
+        }
+
+        while (((here - ap->data) % ARCHIVE_ALIGN) != 0) {
+            *(here++) = '\0';
+        }
+        cp->length = here - ap->data;
+
+        if (fwrite(ap->data, cp->length, 1, ap->fp) < 1) {
+            rc = -1;
+        } else {
+            ap->bytes += cp->length;
+            ap->chunks += 1;
+            ap->count = 0;
+        }
+
+    }
+
+    return rc;
+}
+
+int archive_write(archive_t * ap, const trace_record_t * rp)
+{
+    int rc = 0;
+
+    ap->buffer[ap->count++] = *rp;
+    ap->records += 1;
+
+    if (ap->count >= ap->rows) {
+        rc = archive_flush(ap);
+    }
+
+    return rc;
+}
+
+int archive_fini(archive_t * ap)
+{
+    int rc = 0;
+
+    if (archive_flush(ap) < 0) {
+        rc = -1;
+    } else if (fflush(ap->fp) == EOF) {
+        rc = -1;
+    } else {
+        /* Do nothing. */
+    }
+
+    free(ap->buffer);
+    free(ap->data);
+    ap->buffer = (trace_record_t *)0;
+    ap->data = (uint8_t *)0;
+
+    return rc;
+}
+
+/*******************************************************************************
+ * READING
+ ******************************************************************************/
+
+const archive_header_t * archive_check(const void * base, size_t length)
+{
+    const archive_header_t * result = (const archive_header_t *)0;
+    const archive_header_t * hp = (const archive_header_t *)base;
+
+    if (length < sizeof(*hp)) {
+        errno = ENODATA;
+    } else if (memcmp(hp->magic, ARCHIVE_MAGIC, sizeof(hp->magic)) != 0) {
+        errno = EINVAL;
+    } else if (hp->order != ARCHIVE_ORDER) {
+        errno = EPROTO;
+    } else if (hp->version != ARCHIVE_VERSION) {
+        errno = EPROTO;
+    } else if (hp->columns != ARCHIVE_COLUMNS) {
+        errno = EPROTO;
+    } else if (hp->size != sizeof(archive_chunk_t)) {
+        errno = EPROTO;
+    } else if ((hp->rows == 0) || (hp->rows > ARCHIVE_LIMIT)) {
+        errno = EPROTO;
+    } else {
+        result = hp;
+    }
+
+    return result;
+}
+
+const archive_chunk_t * archive_next(const void * base, size_t length, uint64_t * offsetp)
+{
+    const archive_chunk_t * result = (const archive_chunk_t *)0;
+    const archive_chunk_t * cp = (const archive_chunk_t *)0;
+    const uint8_t * here = (const uint8_t *)0;
+
+    /*
+     * A chunk header can't be mistaken for a file header, since the magic
+     * number, as the number of records in a chunk, would be far larger
+     * than ARCHIVE_LIMIT.
+     */
+
+    while (*offsetp < length) {
+        here = (const uint8_t *)base + *offsetp;
+        if ((length - *offsetp) < sizeof(archive_header_t)) {
+            break;
+        } else if (memcmp(here, ARCHIVE_MAGIC, sizeof(((archive_header_t *)0)->magic)) == 0) {
+            if (archive_check(here, length - *offsetp) == (const archive_header_t *)0) {
+                break;
+            }
+            *offsetp += sizeof(archive_header_t);
+        } else if (*offsetp == 0) {
+            errno = EINVAL;
+            break;
+        } else if ((length - *offsetp) < sizeof(archive_chunk_t)) {
+            break;
+        } else {
+            cp = (const archive_chunk_t *)here;
+            if ((cp->rows == 0) || (cp->rows > ARCHIVE_LIMIT)) {
+                errno = EILSEQ;
+            } else if ((cp->length < sizeof(*cp)) || ((cp->length % ARCHIVE_ALIGN) != 0)) {
+                errno = EILSEQ;
+            } else if (cp->length > (length - *offsetp)) {
+                /* Do nothing. */
+            } else {
+                *offsetp += cp->length;
+                result = cp;
+            }
+            break;
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Return the data of a column in a chunk.
+ * @param cp points to the chunk header.
+ * @param column is the column.
+ * @param endp points to where a pointer past the data is returned.
+ * @return a pointer to the data or NULL with errno set if it is not within
+ * the chunk.
+ */
+static const uint8_t * archive_data(const archive_chunk_t * cp, int column, const uint8_t ** endp)
+{
+    const uint8_t * result = (const uint8_t *)0;
+    const archive_zone_t * zp = (const archive_zone_t *)0;
+
+    if ((column < 0) || (column >= ARCHIVE_COLUMNS)) {
+        errno = EINVAL;
+    } else if (((zp = &(cp->zone[column]))->offset < sizeof(*cp)) || (zp->offset > cp->length) || (zp->length > (cp->length - zp->offset))) {
+        errno = EILSEQ;
+    } else {
+        result = (const uint8_t *)cp + zp->offset;
+        *endp = result + zp->length;
+    }
+
+    return result;
+}
+
+/**
+ * Decode a numeric column, or the flags, of a chunk into arrays that may
+ * be interleaved with other data, like the columns of trace records.
+ * @param cp points to the chunk header.
+ * @param column is the column.
+ * @param values points to the first value.
+ * @param vstride is the distance in bytes between values.
+ * @param digits points to the first digits.
+ * @param dstride is the distance in bytes between digits.
+ * @return the number of records or <0 with errno set if an error occurred.
+ */
+static ssize_t archive_decode(const archive_chunk_t * cp, int column, void * values, size_t vstride, void * digits, size_t dstride)
+{
+    const archive_zone_t * zp = (const archive_zone_t *)0;
+    const uint8_t * here = (const uint8_t *)0;
+    const uint8_t * end = (const uint8_t *)0;
+    uint64_t encoded = 0;
+    int64_t value = 0;
+    uint32_t ii = 0;
+
+    if (column == TRACE_NAM) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if ((here = archive_data(cp, column, &end)) == (const uint8_t *)0) {
+        return -1;
+    }
+
+    zp = &(cp->zone[column]);
+
+    if (zp->digits != ARCHIVE_MIXED) {
+        for (ii = 0; ii < cp->rows; ++ii) {
+            *(int8_t *)((uint8_t *)digits + (ii * dstride)) = zp->digits;
+        }
+    } else if ((end - here) < cp->rows) {
+        errno = EILSEQ;
+        return -1;
+    } else {
+        for (ii = 0; ii < cp->rows; ++ii) {
+            *(int8_t *)((uint8_t *)digits + (ii * dstride)) = (int8_t)*(here++);
+        }
+    }
+
+    for (ii = 0; ii < cp->rows; ++ii) {
+        if ((here = archive_varint_get(here, end, &encoded)) == (const uint8_t *)0) {
+            errno = EILSEQ;
+            return -1;
+        }
+        if (zp->encoding == ARCHIVE_DELTA) {
+            value = (int64_t)((uint64_t)value + (uint64_t)archive_zagzig(encoded));
+        } else {
+            value = archive_zagzig(encoded);
+        }
+        *(int64_t *)((uint8_t *)values + (ii * vstride)) = value;
+    }
+
+    return cp->rows;
+}
+
+ssize_t archive_column(const archive_chunk_t * cp, int column, int64_t * values, int8_t * digits)
+{
+    return archive_decode(cp, column, values, sizeof(values[0]), digits, sizeof(digits[0]));
+}
+
+ssize_t archive_names(const archive_chunk_t * cp, const char ** names)
+{
+    const uint8_t * here = (const uint8_t *)0;
+    const uint8_t * end = (const uint8_t *)0;
+    const uint8_t * nul = (const uint8_t *)0;
+    uint64_t run = 0;
+    uint32_t ii = 0;
+
+    if ((here = archive_data(cp, TRACE_NAM, &end)) == (const uint8_t *)0) {
+        return -1;
+    }
+
+    while (ii < cp->rows) {
+        if ((here = archive_varint_get(here, end, &run)) == (const uint8_t *)0) {
+            break;
+        } else if ((run == 0) || (run > (cp->rows - ii))) {
+            break;
+        } else if ((nul = (const uint8_t *)memchr(here, '\0', end - here)) == (const uint8_t *)0) {
+            break;
+        } else {
+            while ((run--) > 0) {
+                names[ii++] = (const char *)here;
+            }
+            here = nul + 1;
+        }
+    }
+
+    if (ii < cp->rows) {
+        errno = EILSEQ;
+        return -1;
+    }
+
+    return cp->rows;
+}
+
+ssize_t archive_records(const archive_chunk_t * cp, trace_record_t * records)
+{
+    ssize_t rc = -1;
+    const char ** names = (const char **)0;
+    uint32_t ii = 0;
+    int jj = 0;
+
+    if ((names = (const char **)malloc(cp->rows * sizeof(names[0]))) == (const char **)0) {
+        return -1;
+    }
+
+    do {
+
+        if (archive_names(cp, names) < 0) {
+            break;
+        }
+
+        for (ii = 0; ii < cp->rows; ++ii) {
+            trace_record_init(&(records[ii]), names[ii], 0);
+        }
+
+        for (jj = TRACE_NAM + 1; jj < TRACE_COLUMNS; ++jj) {
+            if (archive_decode(cp, jj, &(records[0].value[jj]), sizeof(records[0]), &(records[0].digits[jj]), sizeof(records[0])) < 0) {
+                break;
+            }
+        }
+        if (jj < TRACE_COLUMNS) {
+            break;
+        }
+
+        /*
+         * The flags are decoded into the unused value and digits of the
+         * host name column, which are then restored.
+         */
+
+        if (archive_decode(cp, ARCHIVE_FLG, &(records[0].value[TRACE_NAM]), sizeof(records[0]), &(records[0].digits[TRACE_NAM]), sizeof(records[0])) < 0) {
+            break;
+        }
+        for (ii = 0; ii < cp->rows; ++ii) {
+            records[ii].flags = (uint8_t)records[ii].value[TRACE_NAM];
+            records[ii].value[TRACE_NAM] = 0;
+            records[ii].digits[TRACE_NAM] = TRACE_INTEGER;
+        }
+
+        rc = cp->rows;
+
+    } while (0);
+
+    free(names);
+
+    return rc;
+}
@@ -0,0 +1,530 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Capture module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "com/diag/hazer/capture.h"
+#include "com/diag/hazer/common.h"
+
+/**
+ * This is the padding written after data that isn't aligned.
+ */
+static const uint8_t PADDING[CAPTURE_ALIGN] = { 0, };
+
+/**
+ * Return a length rounded up to the alignment of a record.
+ * @param length is the length in bytes.
+ * @return the aligned length in bytes.
+ */
+static inline size_t capture_align(size_t length)
+{
+    return (length + (CAPTURE_ALIGN - 1)) & ~(size_t)(CAPTURE_ALIGN - 1);
+}
+
+int64_t capture_now(void)
+{
+    return common_clock(CLOCK_MONOTONIC);
+}
+
+uint32_t capture_key(capture_protocol_t protocol, const void * data, size_t length)
+{
+    uint32_t type = 0;
+    const uint8_t * bp = (const uint8_t *)0;
+    const uint8_t * comma = (const uint8_t *)0;
+
+    bp = (const uint8_t *)data;
+
+    switch (protocol) {
+
+    case CAPTURE_NMEA:
+        /*
+         * The sentence is the three characters before the first comma,
+         * which leaves out the talker, so GPGGA and GNGGA are both GGA.
+         */
+        if ((comma = (const uint8_t *)memchr(bp, ',', length)) == (const uint8_t *)0) {
+            /* Do nothing. */
+        } else if ((comma - bp) < 4) {
+            /* Do nothing. */
+        } else {
+            type = ((uint32_t)comma[-3] << 16) | ((uint32_t)comma[-2] << 8) | comma[-1];
+        }
+        break;
+
+    case CAPTURE_UBX:
+        /*
+         * Sync, sync, class, ID.
+         */
+        if (length >= 4) {
+            type = ((uint32_t)bp[2] << 8) | bp[3];
+        }
+        break;
+
+    case CAPTURE_RTCM:
+        /*
+         * Preamble, two bytes of length, then the twelve bit message number.
+         */
+        if (length >= 5) {
+            type = ((uint32_t)bp[3] << 4) | (bp[4] >> 4);
+        }
+        break;
+
+    case CAPTURE_CPO:
+        /*
+         * DLE, ID.
+         */
+        if (length >= 2) {
+            type = bp[1];
+        }
+        break;
+
+    default:
+        break;
+
+    }
+
+    return CAPTURE_KEY(protocol, type);
+}
+
+const char * capture_name(capture_protocol_t protocol)
+{
+    const char * name = "OTHER";
+
+    switch (protocol) {
+    case CAPTURE_NMEA:      name = "NMEA";      break;
+    case CAPTURE_UBX:       name = "UBX";       break;
+    case CAPTURE_RTCM:      name = "RTCM";      break;
+    case CAPTURE_CPO:       name = "CPO";       break;
+    case CAPTURE_INDEX:     name = "INDEX";     break;
+    case CAPTURE_TRAILER:   name = "TRAILER";   break;
+    default:                                    break;
+    }
+
+    return name;
+}
+
+/**
+ * Write a record to a capture file.
+ * @param cp points to the capture.
+ * @param stamp is the receive time in ns.
+ * @param key is the key.
+ * @param prefix points to data that precedes the data, or NULL.
+ * @param prefixed is the length of the prefix in bytes.
+ * @param data points to the data.
+ * @param length is the length of the data in bytes.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+static int capture_record(capture_t * cp, int64_t stamp, uint32_t key, const void * prefix, size_t prefixed, const void * data, size_t length)
+{
+    int rc = -1;
+    capture_record_t record;
+    size_t padding = 0;
+
+    record.stamp = stamp;
+    record.length = prefixed + length;
+    record.key = key;
+    padding = capture_align(record.length) - record.length;
+
+    if (fwrite(&record, sizeof(record), 1, cp->fp) != 1) {
+        /* Do nothing. */
+    } else if ((prefixed > 0) && (fwrite(prefix, prefixed, 1, cp->fp) != 1)) {
+        /* Do nothing. */
+    } else if ((length > 0) && (fwrite(data, length, 1, cp->fp) != 1)) {
+        /* Do nothing. */
+    } else if ((padding > 0) && (fwrite(PADDING, padding, 1, cp->fp) != 1)) {
+        /* Do nothing. */
+    } else {
+        cp->offset += sizeof(record) + record.length + padding;
+        rc = 0;
+    }
+
+    return rc;
+}
+
+/**
+ * Write the index record for the block being accumulated, if it isn't
+ * empty, and start a new block.
+ * @param cp points to the capture.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+static int capture_block(capture_t * cp)
+{
+    int rc = 0;
+    uint64_t offset = 0;
+
+    if (cp->block.records > 0) {
+        offset = cp->offset;
+        cp->block.previous = cp->previous;
+        if ((rc = capture_record(cp, cp->block.last, CAPTURE_KEY(CAPTURE_INDEX, 0), &(cp->block), sizeof(cp->block), cp->count, cp->block.types * sizeof(cp->count[0]))) == 0) {
+            cp->previous = offset;
+        }
+    }
+
+    memset(&(cp->block), 0, sizeof(cp->block));
+    cp->block.offset = cp->offset;
+
+    return rc;
+}
+
+capture_t * capture_init(capture_t * cp, FILE * fp, int64_t interval)
+{
+    capture_t * result = (capture_t *)0;
+    capture_header_t header;
+
+    memset(cp, 0, sizeof(*cp));
+    cp->fp = fp;
+    cp->interval = interval;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.order = CAPTURE_ORDER;
+    header.realtime = common_clock(CLOCK_REALTIME);
+    header.monotonic = capture_now();
+
+    if (interval <= 0) {
+        errno = EINVAL;
+    } else if (fwrite(&header, sizeof(header), 1, fp) != 1) {
+        /* Do nothing. */
+    } else {
+        cp->offset = sizeof(header);
+        cp->block.offset = cp->offset;
+        result = cp;
+    }
+
+    return result;
+}
+
+ssize_t capture_write(capture_t * cp, int64_t stamp, capture_protocol_t protocol, const void * data, size_t length)
+{
+    ssize_t rc = -1;
+    uint32_t key = 0;
+    unsigned int ii = 0;
+
+    key = capture_key(protocol, data, length);
+
+    if (length > UINT32_MAX) {
+        errno = EMSGSIZE;
+    } else if ((cp->block.records > 0) && ((stamp - cp->block.first) >= cp->interval) && (capture_block(cp) < 0)) {
+        /* Do nothing. */
+    } else if (capture_record(cp, stamp, key, (const void *)0, 0, data, length) < 0) {
+        /* Do nothing. */
+    } else {
+        if (cp->block.records == 0) {
+            cp->block.first = stamp;
+        }
+        cp->block.last = stamp;
+        cp->block.records += 1;
+        cp->records += 1;
+
+        /*
+         * The last slot is kept for the overflow, so that a block whose
+         * types didn't all fit is never skipped.
+         */
+
+        for (ii = 0; ii < cp->block.types; ++ii) {
+            if (cp->count[ii].key == key) {
+                break;
+            }
+        }
+        if (ii < cp->block.types) {
+            /* Do nothing. */
+        } else if (ii < (CAPTURE_TYPES - 1)) {
+            cp->count[ii].key = key;
+            cp->count[ii].count = 0;
+            cp->block.types += 1;
+        } else {
+            for (ii = 0; ii < cp->block.types; ++ii) {
+                if (cp->count[ii].key == CAPTURE_OVERFLOW) {
+                    break;
+                }
+            }
+            if (ii == cp->block.types) {
+                cp->count[ii].key = CAPTURE_OVERFLOW;
+                cp->count[ii].count = 0;
+                cp->block.types += 1;
+            }
+        }
+        cp->count[ii].count += 1;
+
+        rc = length;
+    }
+
+    return rc;
+}
+
+int capture_fini(capture_t * cp)
+{
+    int rc = -1;
+    capture_trailer_t trailer;
+    int64_t last = 0;
+
+    last = cp->block.last;
+
+    if (capture_block(cp) < 0) {
+        /* Do nothing. */
+    } else {
+        trailer.index = cp->previous;
+        trailer.records = cp->records;
+        if (capture_record(cp, last, CAPTURE_KEY(CAPTURE_TRAILER, 0), (const void *)0, 0, &trailer, sizeof(trailer)) < 0) {
+            /* Do nothing. */
+        } else if (fflush(cp->fp) == EOF) {
+            /* Do nothing. */
+        } else {
+            rc = 0;
+        }
+    }
+
+    return rc;
+}
+
+const capture_header_t * capture_check(const void * base, size_t length)
+{
+    const capture_header_t * result = (const capture_header_t *)0;
+    const capture_header_t * hp = (const capture_header_t *)0;
+
+    hp = (const capture_header_t *)base;
+
+    if (length < sizeof(capture_header_t)) {
+        errno = ENODATA;
+    } else if (memcmp(hp->magic, CAPTURE_MAGIC, sizeof(hp->magic)) != 0) {
+        errno = EINVAL;
+    } else if (hp->order != CAPTURE_ORDER) {
+        errno = EPROTO;
+    } else if (hp->version != CAPTURE_VERSION) {
+        errno = EPROTO;
+    } else {
+        result = hp;
+    }
+
+    return result;
+}
+
+const void * capture_next(const void * base, size_t length, uint64_t * offsetp, capture_record_t * rp)
+{
+    const void * result = (const void *)0;
+    const uint8_t * bp = (const uint8_t *)0;
+    uint64_t offset = 0;
+
+    bp = (const uint8_t *)base;
+    offset = *offsetp;
+
+    if (offset < sizeof(capture_header_t)) {
+        /* Do nothing. */
+    } else if ((offset + sizeof(*rp)) > length) {
+        /* Do nothing. */
+    } else {
+        memcpy(rp, bp + offset, sizeof(*rp));
+        offset += sizeof(*rp);
+        if ((length - offset) < capture_align(rp->length)) {
+            /* Do nothing. */
+        } else {
+            result = bp + offset;
+            *offsetp = offset + capture_align(rp->length);
+        }
+    }
+
+    return result;
+}
+
+uint64_t capture_last(const void * base, size_t length)
+{
+    uint64_t result = 0;
+    uint64_t offset = 0;
+    capture_record_t record;
+    capture_trailer_t trailer;
+    const void * data = (const void *)0;
+
+    if (length < (sizeof(capture_header_t) + sizeof(record) + sizeof(trailer))) {
+        /* Do nothing. */
+    } else {
+        offset = length - sizeof(record) - capture_align(sizeof(trailer));
+        if ((data = capture_next(base, length, &offset, &record)) == (const void *)0) {
+            /* Do nothing. */
+        } else if (record.key != CAPTURE_KEY(CAPTURE_TRAILER, 0)) {
+            /* Do nothing. */
+        } else if (record.length != sizeof(trailer)) {
+            /* Do nothing. */
+        } else {
+            memcpy(&trailer, data, sizeof(trailer));
+            if (trailer.index < length) {
+                result = trailer.index;
+            }
+        }
+    }
+
+    return result;
+}
+
+const capture_count_t * capture_index(const void * base, size_t length, uint64_t offset, capture_index_t * ip)
+{
+    const capture_count_t * result = (const capture_count_t *)0;
+    capture_record_t record;
+    const uint8_t * data = (const uint8_t *)0;
+    uint64_t here = 0;
+
+    /*
+     * Each index must point back before itself, so that a damaged file
+     * can't make a walk back through the indices loop.
+     */
+
+    here = offset;
+
+    if ((data = (const uint8_t *)capture_next(base, length, &here, &record)) == (const uint8_t *)0) {
+        /* Do nothing. */
+    } else if (record.key != CAPTURE_KEY(CAPTURE_INDEX, 0)) {
+        /* Do nothing. */
+    } else if (record.length < sizeof(*ip)) {
+        /* Do nothing. */
+    } else {
+        memcpy(ip, data, sizeof(*ip));
+        if (record.length != (sizeof(*ip) + (ip->types * sizeof(capture_count_t)))) {
+            /* Do nothing. */
+        } else if (ip->previous >= offset) {
+            /* Do nothing. */
+        } else {
+            result = (const capture_count_t *)(data + sizeof(*ip));
+        }
+    }
+
+    return result;
+}
+
+uint64_t capture_count(const capture_index_t * ip, const capture_count_t * counts, uint32_t key, uint32_t mask)
+{
+    uint64_t result = 0;
+    uint32_t ii = 0;
+
+    for (ii = 0; ii < ip->types; ++ii) {
+        if (counts[ii].key == CAPTURE_OVERFLOW) {
+            result += counts[ii].count;
+        } else if ((counts[ii].key & mask) == (key & mask)) {
+            result += counts[ii].count;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    return result;
+}
+
+uint64_t capture_seek(const void * base, size_t length, int64_t stamp, uint32_t key, uint32_t mask, uint64_t * skippedp)
+{
+    uint64_t result = 0;
+    uint64_t offset = 0;
+    uint64_t total = 0;
+    uint64_t kept = 0;
+    int found = 0;
+    const capture_count_t * counts = (const capture_count_t *)0;
+    capture_index_t index;
+
+    /*
+     * Walking back, the total is of the blocks from this one to the end.
+     * Once a block ends before the time, so do all the blocks before it.
+     */
+
+    if ((offset = capture_last(base, length)) == 0) {
+        result = sizeof(capture_header_t);
+    } else {
+        result = length;
+        while ((offset > 0) && ((counts = capture_index(base, length, offset, &index)) != (const capture_count_t *)0)) {
+            total += index.records;
+            if (found) {
+                /* Do nothing. */
+            } else if (index.last < stamp) {
+                found = !0;
+            } else if (capture_count(&index, counts, key, mask) > 0) {
+                result = index.offset;
+                kept = total;
+            } else {
+                /* Do nothing. */
+            }
+            offset = index.previous;
+        }
+    }
+
+    *skippedp = total - kept;
+
+    return result;
+}
+
+capture_image_t * capture_load(capture_image_t * ip, FILE * fp, int advice)
+{
+    struct stat status;
+    void * base = MAP_FAILED;
+    char * here = (char *)0;
+    size_t size = 0;
+    size_t rc = 0;
+    int error = 0;
+
+    memset(ip, 0, sizeof(*ip));
+
+    if (fstat(fileno(fp), &status) < 0) {
+        return (capture_image_t *)0;
+    }
+
+    if (!S_ISREG(status.st_mode)) {
+        /* Do nothing. */
+    } else if (status.st_size == 0) {
+        /* Do nothing. */
+    } else if ((base = mmap((void *)0, status.st_size, PROT_READ, MAP_PRIVATE, fileno(fp), 0)) == MAP_FAILED) {
+        /* Do nothing. */
+    } else {
+        ip->base = base;
+        ip->length = status.st_size;
+        ip->mapped = !0;
+        (void)madvise(ip->base, ip->length, advice);
+        return ip;
+    }
+
+    /*
+     * Anything that can't be mapped is read into memory that is doubled
+     * in size whenever it fills.
+     */
+
+    do {
+        if (ip->length == size) {
+            size = (size == 0) ? 65536 : (size * 2);
+            if ((here = (char *)realloc(ip->base, size)) == (char *)0) {
+                error = errno;
+                capture_unload(ip);
+                errno = error;
+                return (capture_image_t *)0;
+            }
+            ip->base = here;
+        }
+        ip->length += (rc = fread((char *)(ip->base) + ip->length, 1, size - ip->length, fp));
+    } while (rc > 0);
+
+    if (ferror(fp)) {
+        capture_unload(ip);
+        errno = EIO;
+        return (capture_image_t *)0;
+    }
+
+    return ip;
+}
+
+void capture_unload(capture_image_t * ip)
+{
+    if (ip->base == (void *)0) {
+        /* Do nothing. */
+    } else if (ip->mapped) {
+        (void)munmap(ip->base, ip->length);
+    } else {
+        free(ip->base);
+    }
+
+    memset(ip, 0, sizeof(*ip));
+}
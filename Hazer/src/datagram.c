@@ -1,7 +1,7 @@
 /* vi: set ts=4 expandtab shiftwidth=4: */
 /**
  * @file
- * @copyright Copyright 2019-2020 Digital Aggregates Corporation, Colorado, USA.
+ * @copyright Copyright 2019-2024 Digital Aggregates Corporation, Colorado, USA.
  * @note Licensed under the terms in LICENSE.txt.
  * @brief This is the implementation of the Datagram module.
  * @author Chip Overclock <mailto:coverclock@diag.com>
@@ -9,8 +9,17 @@
  * @details
  */
 
+#include <errno.h>
+#include <string.h>
+#include <netinet/in.h>
 #include "com/diag/hazer/datagram.h"
 
+/**
+ * A sequence number that is this far or farther ahead of another is
+ * considered to be behind it instead.
+ */
+static const datagram_sequence_t THRESHOLD = ((datagram_sequence_t)1) << ((sizeof(datagram_sequence_t) * 8) - 1);
+
 /**
  * Check to see if this datagram came out of order.
  * @param expectedp points to the expected sequence number.
@@ -25,7 +34,6 @@ ssize_t datagram_validate(datagram_sequence_t * expectedp, datagram_header_t * h
     ssize_t result = -1;
     datagram_sequence_t actual = 0;
     datagram_sequence_t gap = 0;
-    static const datagram_sequence_t THRESHOLD = ((datagram_sequence_t)1) << ((sizeof(datagram_sequence_t) * 8) - 1);
 
     // (EXPECTED < ACTUAL) if (0 < (ACTUAL - EXPECTED) < THRESHOLD)
 
@@ -58,3 +66,634 @@ void datagram_stamp(datagram_header_t * buffer, datagram_sequence_t * expectedp)
     buffer->sequence = htonl(*expectedp);
     *expectedp += 1;
 }
+
+/**
+ * Initialize a batch.
+ * @param bp points to the batch.
+ */
+void datagram_batch_init(datagram_batch_t * bp)
+{
+    bp->received = 0;
+    bp->consumed = 0;
+    bp->maximum = 0;
+    bp->wakeups = 0;
+    bp->packets = 0;
+}
+
+/**
+ * Receive as many datagrams as are waiting on a socket, up to the size
+ * of the batch, with a single non-blocking system call.
+ * @param bp points to the batch.
+ * @param fd is the socket.
+ * @return the number of datagrams received, 0 if none, <0 for error.
+ */
+int datagram_batch_receive(datagram_batch_t * bp, int fd)
+{
+    int rc = -1;
+    int ii = 0;
+    struct iovec vector[DATAGRAM_BATCH];
+    struct mmsghdr message[DATAGRAM_BATCH];
+
+    bp->received = 0;
+    bp->consumed = 0;
+
+    memset(message, 0, sizeof(message));
+    for (ii = 0; ii < DATAGRAM_BATCH; ++ii) {
+        vector[ii].iov_base = &(bp->buffer[ii]);
+        vector[ii].iov_len = sizeof(bp->buffer[ii]) - 1; /* Room for NUL. */
+        message[ii].msg_hdr.msg_name = &(bp->address[ii]);
+        message[ii].msg_hdr.msg_namelen = sizeof(bp->address[ii]);
+        message[ii].msg_hdr.msg_iov = &(vector[ii]);
+        message[ii].msg_hdr.msg_iovlen = 1;
+    }
+
+    if ((rc = recvmmsg(fd, message, DATAGRAM_BATCH, MSG_DONTWAIT, (struct timespec *)0)) < 0) {
+        if ((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+            rc = 0;
+        }
+    } else if (rc == 0) {
+        /* Do nothing. */
+    } else {
+        for (ii = 0; ii < rc; ++ii) {
+            bp->length[ii] = message[ii].msg_len;
+            ((uint8_t *)&(bp->buffer[ii]))[bp->length[ii]] = '\0';
+        }
+        bp->received = rc;
+        bp->wakeups += 1;
+        bp->packets += rc;
+        if (rc > bp->maximum) {
+            bp->maximum = rc;
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * Consume the next datagram in the batch.
+ * @param bp points to the batch.
+ * @param lengthp points to where the received length is stored.
+ * @param addressp if not NULL points to where a pointer to the sender's
+ * address is stored.
+ * @return a pointer to the buffer or NULL if the batch is exhausted.
+ */
+datagram_buffer_t * datagram_batch_next(datagram_batch_t * bp, ssize_t * lengthp, const struct sockaddr_storage ** addressp)
+{
+    datagram_buffer_t * result = (datagram_buffer_t *)0;
+
+    if (bp->consumed < bp->received) {
+        result = &(bp->buffer[bp->consumed]);
+        *lengthp = bp->length[bp->consumed];
+        if (addressp != (const struct sockaddr_storage **)0) {
+            *addressp = &(bp->address[bp->consumed]);
+        }
+        bp->consumed += 1;
+    }
+
+    return result;
+}
+
+/**
+ * Extract the IPv6 address and the port from a sender's address.
+ * @param sap points to the sender's address.
+ * @param address is the array into which the address is stored.
+ * @param portp points to where the port is stored.
+ * @return 0 for success, <0 if the address family is not IPv4 or IPv6.
+ */
+int datagram_batch_identify(const struct sockaddr_storage * sap, uint16_t address[8], uint16_t * portp)
+{
+    int rc = -1;
+    const struct sockaddr_in6 * s6p = (const struct sockaddr_in6 *)0;
+    const struct sockaddr_in * s4p = (const struct sockaddr_in *)0;
+    uint32_t ipv4 = 0;
+    int ii = 0;
+
+    if (sap->ss_family == AF_INET6) {
+        s6p = (const struct sockaddr_in6 *)sap;
+        for (ii = 0; ii < 8; ++ii) {
+            address[ii] = (s6p->sin6_addr.s6_addr[ii * 2] << 8) | s6p->sin6_addr.s6_addr[(ii * 2) + 1];
+        }
+        *portp = ntohs(s6p->sin6_port);
+        rc = 0;
+    } else if (sap->ss_family == AF_INET) {
+        s4p = (const struct sockaddr_in *)sap;
+        ipv4 = ntohl(s4p->sin_addr.s_addr);
+        for (ii = 0; ii < 5; ++ii) {
+            address[ii] = 0;
+        }
+        address[5] = 0xffff;
+        address[6] = ipv4 >> 16;
+        address[7] = ipv4 & 0xffff;
+        *portp = ntohs(s4p->sin_port);
+        rc = 0;
+    } else {
+        errno = EAFNOSUPPORT;
+    }
+
+    return rc;
+}
+
+/**
+ * Initialize a fanout, including its counters.
+ * @param fp points to the fanout.
+ */
+void datagram_fanout_init(datagram_fanout_t * fp)
+{
+    fp->count = 0;
+    fp->calls = 0;
+    fp->packets = 0;
+    fp->errors = 0;
+}
+
+/**
+ * Append a destination to a fanout.
+ * @param fp points to the fanout.
+ * @param address is the IPv6 address in host byte order.
+ * @param port is the port in host byte order.
+ * @return the index of the destination, or <0 if the vector is full.
+ */
+int datagram_fanout_add(datagram_fanout_t * fp, const uint16_t address[8], uint16_t port)
+{
+    int index = -1;
+    struct sockaddr_in6 * s6p = (struct sockaddr_in6 *)0;
+    int ii = 0;
+
+    if (fp->count < DATAGRAM_FANOUT) {
+        index = fp->count++;
+        s6p = &(fp->address[index]);
+        memset(s6p, 0, sizeof(*s6p));
+        s6p->sin6_family = AF_INET6;
+        s6p->sin6_port = htons(port);
+        for (ii = 0; ii < 8; ++ii) {
+            s6p->sin6_addr.s6_addr[ii * 2] = address[ii] >> 8;
+            s6p->sin6_addr.s6_addr[(ii * 2) + 1] = address[ii] & 0xff;
+        }
+        fp->error[index] = 0;
+    }
+
+    return index;
+}
+
+/**
+ * Send the same datagram to every destination in a fanout.
+ * @param fp points to the fanout.
+ * @param fd is an IPv6 datagram socket.
+ * @param buffer points to the datagram.
+ * @param length is the length of the datagram in bytes.
+ * @return the number of destinations to which the datagram was sent.
+ */
+int datagram_fanout_send(datagram_fanout_t * fp, int fd, const void * buffer, size_t length)
+{
+    int sent = 0;
+    int rc = -1;
+    unsigned int ii = 0;
+    unsigned int next = 0;
+    struct iovec vector = { 0, };
+    struct mmsghdr message[DATAGRAM_FANOUT];
+
+    vector.iov_base = (void *)buffer;
+    vector.iov_len = length;
+
+    memset(message, 0, sizeof(message));
+    for (ii = 0; ii < fp->count; ++ii) {
+        message[ii].msg_hdr.msg_name = &(fp->address[ii]);
+        message[ii].msg_hdr.msg_namelen = sizeof(fp->address[ii]);
+        message[ii].msg_hdr.msg_iov = &vector;
+        message[ii].msg_hdr.msg_iovlen = 1;
+        fp->error[ii] = 0;
+    }
+
+    /*
+     * sendmmsg(2) stops at the first destination that fails. It returns
+     * the number sent before it if that is not zero, otherwise -1 with
+     * errno set for the failing destination itself. Either way the
+     * failing destination is next; if it was not reported, the next call
+     * will report it.
+     */
+
+    while (next < fp->count) {
+        fp->calls += 1;
+        if ((rc = sendmmsg(fd, &(message[next]), fp->count - next, 0)) > 0) {
+            sent += rc;
+            next += rc;
+        } else if (rc == 0) {
+            break;
+        } else if (errno == EINTR) {
+            /* Do nothing. */
+        } else {
+            fp->error[next] = errno;
+            fp->errors += 1;
+            next += 1;
+        }
+    }
+
+    fp->packets += sent;
+
+    return sent;
+}
+
+/**
+ * Initialize a packer, including its counters.
+ * @param pp points to the packer.
+ * @param budget is the largest datagram including the header in bytes.
+ */
+void datagram_packer_init(datagram_packer_t * pp, size_t budget)
+{
+    static const size_t LIMIT = sizeof(datagram_header_t) + sizeof(pp->buffer.payload.data) - 1 /* Room for NUL. */;
+
+    pp->budget = (budget < LIMIT) ? budget : LIMIT;
+    pp->length = 0;
+    pp->count = 0;
+    pp->frames = 0;
+    pp->datagrams = 0;
+}
+
+/**
+ * Append a frame to a packer.
+ * @param pp points to the packer.
+ * @param frame points to the frame.
+ * @param length is the length of the frame in bytes.
+ * @return 0 for success, or <0 if the frame doesn't fit.
+ */
+int datagram_packer_append(datagram_packer_t * pp, const void * frame, size_t length)
+{
+    int rc = -1;
+    size_t length0 = 0;
+    uint8_t * here = (uint8_t *)0;
+
+    length0 = (pp->count == 0) ? DATAGRAM_FRAMES_PREAMBLE : pp->length;
+
+    if (length == 0) {
+        /* Do nothing. */
+    } else if (length > 0xffff) {
+        /* Do nothing. */
+    } else if (pp->count >= DATAGRAM_FRAMES_MAXIMUM) {
+        /* Do nothing. */
+    } else if ((sizeof(datagram_header_t) + length0 + DATAGRAM_FRAMES_PREFIX + length) > pp->budget) {
+        /* Do nothing. */
+    } else {
+        here = &(pp->buffer.payload.data[length0]);
+        here[0] = (length >> 8) & 0xff;
+        here[1] = length & 0xff;
+        memcpy(&(here[DATAGRAM_FRAMES_PREFIX]), frame, length);
+        pp->length = length0 + DATAGRAM_FRAMES_PREFIX + length;
+        pp->count += 1;
+        pp->frames += 1;
+        rc = 0;
+    }
+
+    return rc;
+}
+
+/**
+ * Finish the datagram in a packer, stamp it, and empty the packer.
+ * @param pp points to the packer.
+ * @param expectedp points to the expected sequence number.
+ * @return the length of the datagram including the header or 0 if empty.
+ */
+size_t datagram_packer_finish(datagram_packer_t * pp, datagram_sequence_t * expectedp)
+{
+    size_t result = 0;
+    uint8_t * data = pp->buffer.payload.data;
+
+    if (pp->count == 0) {
+        /* Do nothing. */
+    } else if (pp->count == 1) {
+        result = pp->length - DATAGRAM_FRAMES_PREAMBLE - DATAGRAM_FRAMES_PREFIX;
+        memmove(&(data[0]), &(data[DATAGRAM_FRAMES_PREAMBLE + DATAGRAM_FRAMES_PREFIX]), result);
+        result += sizeof(datagram_header_t);
+    } else {
+        data[0] = DATAGRAM_FRAMES_MARK;
+        data[1] = pp->count;
+        result = sizeof(datagram_header_t) + pp->length;
+    }
+
+    if (result > 0) {
+        datagram_stamp(&(pp->buffer.header), expectedp);
+        pp->datagrams += 1;
+    }
+
+    pp->length = 0;
+    pp->count = 0;
+
+    return result;
+}
+
+/**
+ * Initialize an unpacker, including its counters.
+ * @param up points to the unpacker.
+ */
+void datagram_unpacker_init(datagram_unpacker_t * up)
+{
+    up->payload = (const uint8_t *)0;
+    up->size = 0;
+    up->offset = 0;
+    up->remaining = 0;
+    up->frames = 0;
+    up->datagrams = 0;
+}
+
+/**
+ * Start unpacking a datagram if it is a well formed batched datagram.
+ * @param up points to the unpacker.
+ * @param datagram points to the received datagram.
+ * @param length is the length of the datagram including the header.
+ * @return the number of frames, or 0 if it isn't a batched datagram.
+ */
+int datagram_unpacker_start(datagram_unpacker_t * up, const datagram_header_t * datagram, size_t length)
+{
+    const uint8_t * payload = datagram->data;
+    size_t size = 0;
+    size_t offset = DATAGRAM_FRAMES_PREAMBLE;
+    size_t frame = 0;
+    unsigned int count = 0;
+    unsigned int ii = 0;
+
+    up->remaining = 0;
+
+    if (length < (sizeof(datagram_header_t) + DATAGRAM_FRAMES_PREAMBLE)) {
+        return 0;
+    }
+
+    size = length - sizeof(datagram_header_t);
+
+    if (payload[0] != DATAGRAM_FRAMES_MARK) {
+        return 0;
+    }
+
+    if ((count = payload[1]) == 0) {
+        return 0;
+    }
+
+    /*
+     * Every length must be plausible and the frames must exactly fill the
+     * payload, otherwise this is some other kind of datagram (or a
+     * truncated one) and is left for the caller to deal with as a whole.
+     */
+
+    for (ii = 0; ii < count; ++ii) {
+        if ((offset + DATAGRAM_FRAMES_PREFIX) > size) {
+            return 0;
+        }
+        frame = (payload[offset] << 8) | payload[offset + 1];
+        if (frame == 0) {
+            return 0;
+        }
+        if (frame > (sizeof(up->buffer.payload.data) - 1)) {
+            return 0;
+        }
+        offset += DATAGRAM_FRAMES_PREFIX + frame;
+        if (offset > size) {
+            return 0;
+        }
+    }
+
+    if (offset != size) {
+        return 0;
+    }
+
+    up->buffer.header = *datagram;
+    up->payload = payload;
+    up->size = size;
+    up->offset = DATAGRAM_FRAMES_PREAMBLE;
+    up->remaining = count;
+    up->datagrams += 1;
+
+    return count;
+}
+
+/**
+ * Unpack the next frame.
+ * @param up points to the unpacker.
+ * @param lengthp points to where the length of the frame is stored.
+ * @return a pointer to the buffer or NULL if there are no more frames.
+ */
+datagram_buffer_t * datagram_unpacker_next(datagram_unpacker_t * up, ssize_t * lengthp)
+{
+    datagram_buffer_t * result = (datagram_buffer_t *)0;
+    size_t length = 0;
+
+    if (up->remaining > 0) {
+        length = (up->payload[up->offset] << 8) | up->payload[up->offset + 1];
+        memcpy(up->buffer.payload.data, &(up->payload[up->offset + DATAGRAM_FRAMES_PREFIX]), length);
+        up->buffer.payload.data[length] = '\0';
+        up->offset += DATAGRAM_FRAMES_PREFIX + length;
+        up->remaining -= 1;
+        up->frames += 1;
+        *lengthp = length;
+        result = &(up->buffer);
+    }
+
+    return result;
+}
+
+/**
+ * Initialize a reorder buffer, including its counters.
+ * @param rp points to the reorder buffer.
+ * @param slots is the most datagrams held or 0 to disable reordering.
+ * @param delay is the longest a datagram is held.
+ */
+void datagram_reorder_init(datagram_reorder_t * rp, unsigned int slots, int64_t delay)
+{
+    memset(rp->occupied, 0, sizeof(rp->occupied));
+    memset(rp->histogram, 0, sizeof(rp->histogram));
+    rp->reordered = 0;
+    rp->expired = 0;
+    rp->delay = (delay > 0) ? delay : 0;
+    rp->slots = (slots < DATAGRAM_REORDER) ? slots : DATAGRAM_REORDER;
+    rp->held = 0;
+}
+
+/**
+ * Insert a received datagram into a reorder buffer.
+ * @param rp points to the reorder buffer.
+ * @param datagram points to the received datagram.
+ * @param length is the length of the datagram including the header.
+ * @param now is the current time.
+ * @param expectedp points to the expected sequence number.
+ * @param outoforderp points to the Out Of Order counter.
+ * @return the size of the payload or <0 if the datagram was discarded.
+ */
+ssize_t datagram_reorder_insert(datagram_reorder_t * rp, const datagram_header_t * datagram, ssize_t length, int64_t now, datagram_sequence_t * expectedp, unsigned int * outoforderp)
+{
+    datagram_sequence_t actual = 0;
+    datagram_sequence_t ahead = 0;
+    unsigned int depth = 0;
+    unsigned int ii = 0;
+    int slot = -1;
+
+    if (length < sizeof(datagram_header_t)) {
+        return -1;
+    }
+
+    if (length > (sizeof(rp->buffer[0]) - 1)) {
+        length = sizeof(rp->buffer[0]) - 1;
+    }
+
+    actual = ntohl(datagram->sequence);
+    ahead = actual - *expectedp;
+
+    if (ahead >= THRESHOLD) {
+        *outoforderp += 1;
+        return -1;
+    }
+
+    /*
+     * The depth is the number of datagrams already held that are further
+     * ahead than this one, that is, that arrived early relative to it.
+     */
+
+    for (ii = 0; ii < rp->slots; ++ii) {
+        if (!rp->occupied[ii]) {
+            if (slot < 0) {
+                slot = ii;
+            }
+        } else if (rp->sequence[ii] == actual) {
+            *outoforderp += 1;
+            return -1;
+        } else if ((datagram_sequence_t)(rp->sequence[ii] - *expectedp) > ahead) {
+            depth += 1;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    if (slot < 0) {
+        *outoforderp += 1;
+        return -1;
+    }
+
+    rp->histogram[(depth < DATAGRAM_REORDER_DEPTHS) ? depth : (DATAGRAM_REORDER_DEPTHS - 1)] += 1;
+    if (depth > 0) {
+        rp->reordered += 1;
+    }
+
+    memcpy(&(rp->buffer[slot]), datagram, length);
+    ((uint8_t *)&(rp->buffer[slot]))[length] = '\0';
+    rp->length[slot] = length;
+    rp->arrival[slot] = now;
+    rp->sequence[slot] = actual;
+    rp->occupied[slot] = !0;
+    rp->held += 1;
+
+    return length - sizeof(datagram_header_t);
+}
+
+/**
+ * Find the slot of the datagram to release next, if any.
+ * @param rp points to the reorder buffer.
+ * @param expected is the expected sequence number.
+ * @param now is the current time.
+ * @return the slot or <0 if none can be released yet.
+ */
+static int datagram_reorder_find(const datagram_reorder_t * rp, datagram_sequence_t expected, int64_t now)
+{
+    int nearest = -1;
+    int oldest = -1;
+    unsigned int ii = 0;
+
+    if (rp->held == 0) {
+        return -1;
+    }
+
+    for (ii = 0; ii < rp->slots; ++ii) {
+        if (!rp->occupied[ii]) {
+            continue;
+        }
+        if (rp->sequence[ii] == expected) {
+            return ii;
+        }
+        if ((nearest < 0) || ((datagram_sequence_t)(rp->sequence[ii] - expected) < (datagram_sequence_t)(rp->sequence[nearest] - expected))) {
+            nearest = ii;
+        }
+        if ((oldest < 0) || (rp->arrival[ii] < rp->arrival[oldest])) {
+            oldest = ii;
+        }
+    }
+
+    /*
+     * The gap in front of the nearest datagram is given up on if the
+     * buffer is full or the oldest datagram has been held long enough.
+     */
+
+    if (rp->held >= rp->slots) {
+        return nearest;
+    }
+
+    if ((now - rp->arrival[oldest]) >= rp->delay) {
+        return nearest;
+    }
+
+    return -1;
+}
+
+/**
+ * Release the next datagram in sequence order, if there is one.
+ * @param rp points to the reorder buffer.
+ * @param lengthp points to where the length of the datagram is stored.
+ * @param now is the current time.
+ * @param expectedp points to the expected sequence number.
+ * @param missingp points to the Missing counter.
+ * @return a pointer to the datagram or NULL if none can be released yet.
+ */
+datagram_buffer_t * datagram_reorder_next(datagram_reorder_t * rp, ssize_t * lengthp, int64_t now, datagram_sequence_t * expectedp, unsigned int * missingp)
+{
+    datagram_buffer_t * result = (datagram_buffer_t *)0;
+    datagram_sequence_t gap = 0;
+    int slot = -1;
+
+    if ((slot = datagram_reorder_find(rp, *expectedp, now)) >= 0) {
+        gap = rp->sequence[slot] - *expectedp;
+        if (gap > 0) {
+            *missingp += gap;
+            rp->expired += 1;
+        }
+        *expectedp = rp->sequence[slot] + 1;
+        rp->occupied[slot] = 0;
+        rp->held -= 1;
+        *lengthp = rp->length[slot];
+        result = &(rp->buffer[slot]);
+    }
+
+    return result;
+}
+
+/**
+ * Return true if datagram_reorder_next() would release a datagram.
+ * @param rp points to the reorder buffer.
+ * @param expected is the expected sequence number.
+ * @param now is the current time.
+ * @return !0 if a datagram can be released, 0 otherwise.
+ */
+int datagram_reorder_ready(const datagram_reorder_t * rp, datagram_sequence_t expected, int64_t now)
+{
+    return (datagram_reorder_find(rp, expected, now) >= 0);
+}
+
+/**
+ * Return how long until the oldest datagram being held is released.
+ * @param rp points to the reorder buffer.
+ * @param now is the current time.
+ * @return the time remaining, 0 if now, or <0 if none is being held.
+ */
+int64_t datagram_reorder_remaining(const datagram_reorder_t * rp, int64_t now)
+{
+    int64_t result = -1;
+    int64_t elapsed = 0;
+    unsigned int ii = 0;
+
+    for (ii = 0; ii < rp->slots; ++ii) {
+        if (!rp->occupied[ii]) {
+            /* Do nothing. */
+        } else if ((elapsed = now - rp->arrival[ii]) >= rp->delay) {
+            result = 0;
+            break;
+        } else if ((result < 0) || ((rp->delay - elapsed) < result)) {
+            result = rp->delay - elapsed;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,128 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Framer module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The logic here must track that in the input loop of gpstool, so that a
+ * stream framed here is framed the same way gpstool would have framed it.
+ */
+
+#include "com/diag/hazer/framer.h"
+#include "com/diag/hazer/machine.h"
+
+framer_t * framer_init(framer_t * fp, framer_event_t kind)
+{
+    machine_start_all(&(fp->nmea_state), &(fp->ubx_state), &(fp->rtcm_state), &(fp->cpo_state));
+    fp->protocol = CAPTURE_OTHER;
+    fp->length = 0;
+    fp->frame = (const uint8_t *)0;
+    fp->framed = (kind == FRAMER_FRAMED);
+
+    return fp;
+}
+
+framer_event_t framer_machine(framer_t * fp, uint8_t ch)
+{
+    framer_event_t event = FRAMER_CONTINUING;
+
+    /*
+     * Right after a frame, we expect the next one to begin immediately, so
+     * only the state machine for its protocol is started. If it doesn't
+     * begin, we have lost sync and start all of them.
+     */
+
+    if (!fp->framed) {
+        /* Do nothing. */
+    } else if (hazer_is_nmea(ch)) {
+        machine_start_nmea(&(fp->nmea_state), &(fp->ubx_state), &(fp->rtcm_state), &(fp->cpo_state));
+    } else if (yodel_is_ubx(ch)) {
+        machine_start_ubx(&(fp->nmea_state), &(fp->ubx_state), &(fp->rtcm_state), &(fp->cpo_state));
+    } else if (tumbleweed_is_rtcm(ch)) {
+        machine_start_rtcm(&(fp->nmea_state), &(fp->ubx_state), &(fp->rtcm_state), &(fp->cpo_state));
+    } else if (calico_is_cpo(ch)) {
+        machine_start_cpo(&(fp->nmea_state), &(fp->ubx_state), &(fp->rtcm_state), &(fp->cpo_state));
+    } else {
+        machine_start_all(&(fp->nmea_state), &(fp->ubx_state), &(fp->rtcm_state), &(fp->cpo_state));
+    }
+
+    fp->framed = 0;
+
+    /*
+     * The state machines are run in the same order as in gpstool, and the
+     * first one to complete a frame keeps the octet from the rest.
+     */
+
+    if (fp->nmea_state != HAZER_STATE_STOP) {
+        fp->nmea_state = hazer_machine(fp->nmea_state, ch, fp->nmea_buffer, sizeof(fp->nmea_buffer), &(fp->nmea_context));
+        if (fp->nmea_state == HAZER_STATE_END) {
+            fp->protocol = CAPTURE_NMEA;
+            fp->length = hazer_size(&(fp->nmea_context)) - 1;
+            fp->frame = fp->nmea_buffer;
+            fp->framed = !0;
+        }
+    }
+
+    if (fp->framed) {
+        /* Do nothing. */
+    } else if (fp->ubx_state != YODEL_STATE_STOP) {
+        fp->ubx_state = yodel_machine(fp->ubx_state, ch, fp->ubx_buffer, sizeof(fp->ubx_buffer), &(fp->ubx_context));
+        if (fp->ubx_state == YODEL_STATE_END) {
+            fp->protocol = CAPTURE_UBX;
+            fp->length = yodel_size(&(fp->ubx_context)) - 1;
+            fp->frame = fp->ubx_buffer;
+            fp->framed = !0;
+        }
+    } else {
+        /* Do nothing. */
+    }
+
+    if (fp->framed) {
+        /* Do nothing. */
+    } else if (fp->rtcm_state != TUMBLEWEED_STATE_STOP) {
+        fp->rtcm_state = tumbleweed_machine(fp->rtcm_state, ch, fp->rtcm_buffer, sizeof(fp->rtcm_buffer), &(fp->rtcm_context));
+        if (fp->rtcm_state == TUMBLEWEED_STATE_END) {
+            fp->protocol = CAPTURE_RTCM;
+            fp->length = tumbleweed_size(&(fp->rtcm_context)) - 1;
+            fp->frame = fp->rtcm_buffer;
+            fp->framed = !0;
+        }
+    } else {
+        /* Do nothing. */
+    }
+
+    if (fp->framed) {
+        /* Do nothing. */
+    } else if (fp->cpo_state != CALICO_STATE_STOP) {
+        fp->cpo_state = calico_machine(fp->cpo_state, ch, fp->cpo_buffer, sizeof(fp->cpo_buffer), &(fp->cpo_context));
+        if (fp->cpo_state == CALICO_STATE_END) {
+            fp->protocol = CAPTURE_CPO;
+            fp->length = calico_size(&(fp->cpo_context)) - 1;
+            fp->frame = fp->cpo_buffer;
+            fp->framed = !0;
+        }
+    } else {
+        /* Do nothing. */
+    }
+
+    /*
+     * If every state machine has given up, or they are all still waiting
+     * for the beginning of a frame, nothing that came before matters.
+     */
+
+    if (fp->framed) {
+        event = FRAMER_FRAMED;
+    } else {
+        if (machine_is_stalled(fp->nmea_state, fp->ubx_state, fp->rtcm_state, fp->cpo_state)) {
+            machine_start_all(&(fp->nmea_state), &(fp->ubx_state), &(fp->rtcm_state), &(fp->cpo_state));
+        }
+        if ((fp->nmea_state == HAZER_STATE_START) && (fp->ubx_state == YODEL_STATE_START) && (fp->rtcm_state == TUMBLEWEED_STATE_START) && (fp->cpo_state == CALICO_STATE_START)) {
+            event = FRAMER_SCANNING;
+        }
+    }
+
+    return event;
+}
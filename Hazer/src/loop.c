@@ -0,0 +1,209 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Loop module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "com/diag/hazer/loop.h"
+
+/*******************************************************************************
+ * LIFECYCLE
+ ******************************************************************************/
+
+loop_t * loop_init(loop_t * lp, int events)
+{
+    loop_t * result = (loop_t *)0;
+
+    memset(lp, 0, sizeof(*lp));
+    lp->epfd = -1;
+
+    if (events <= 0) {
+        events = 1;
+    }
+
+    if ((lp->event = (struct epoll_event *)calloc(events, sizeof(struct epoll_event))) == (struct epoll_event *)0) {
+        /* Do nothing. */
+    } else if ((lp->epfd = epoll_create1(EPOLL_CLOEXEC)) < 0) {
+        free(lp->event);
+        lp->event = (struct epoll_event *)0;
+    } else {
+        lp->events = events;
+        result = lp;
+    }
+
+    return result;
+}
+
+void loop_fini(loop_t * lp)
+{
+    if (lp->epfd >= 0) {
+        (void)close(lp->epfd);
+        lp->epfd = -1;
+    }
+
+    free(lp->event);
+    lp->event = (struct epoll_event *)0;
+    lp->events = 0;
+
+    free(lp->handler);
+    lp->handler = (loop_handler_t *)0;
+    lp->handlers = 0;
+    lp->registered = 0;
+}
+
+/*******************************************************************************
+ * REGISTRATION
+ ******************************************************************************/
+
+/**
+ * Encode a descriptor and the generation of its handler as the user data
+ * of an epoll event.
+ * @param lp points to the loop.
+ * @param fd is the descriptor.
+ * @return the user data.
+ */
+static uint64_t loop_data(const loop_t * lp, int fd)
+{
+    return (((uint64_t)lp->handler[fd].generation) << 32) | (uint32_t)fd;
+}
+
+int loop_register(loop_t * lp, int fd, uint32_t events, loop_callback_t * callback, void * context)
+{
+    int rc = -1;
+    int handlers = 0;
+    loop_handler_t * temporary = (loop_handler_t *)0;
+    struct epoll_event event = { 0, };
+
+    if ((fd < 0) || (callback == (loop_callback_t *)0)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    if (loop_registered(lp, fd)) {
+        errno = EEXIST;
+        return -1;
+    }
+
+    /*
+     * The handler array is indexed by descriptor, and grows (doubling) to
+     * accommodate the largest descriptor registered so far.
+     */
+
+    if (fd >= lp->handlers) {
+        handlers = (lp->handlers > 0) ? lp->handlers : 64;
+        while (fd >= handlers) {
+            handlers *= 2;
+        }
+        if ((temporary = (loop_handler_t *)realloc(lp->handler, handlers * sizeof(loop_handler_t))) == (loop_handler_t *)0) {
+            return -1;
+        }
+        memset(&(temporary[lp->handlers]), 0, (handlers - lp->handlers) * sizeof(loop_handler_t));
+        lp->handler = temporary;
+        lp->handlers = handlers;
+    }
+
+    lp->handler[fd].generation += 1;
+
+    event.events = events | EPOLLET;
+    event.data.u64 = loop_data(lp, fd);
+
+    if (epoll_ctl(lp->epfd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        /* Do nothing. */
+    } else {
+        lp->handler[fd].callback = callback;
+        lp->handler[fd].context = context;
+        lp->handler[fd].events = events;
+        lp->registered += 1;
+        rc = 0;
+    }
+
+    return rc;
+}
+
+int loop_modify(loop_t * lp, int fd, uint32_t events)
+{
+    int rc = -1;
+    struct epoll_event event = { 0, };
+
+    if (!loop_registered(lp, fd)) {
+        errno = ENOENT;
+    } else if (events == lp->handler[fd].events) {
+        rc = 0;
+    } else {
+        event.events = events | EPOLLET;
+        event.data.u64 = loop_data(lp, fd);
+        if (epoll_ctl(lp->epfd, EPOLL_CTL_MOD, fd, &event) < 0) {
+            /* Do nothing. */
+        } else {
+            lp->handler[fd].events = events;
+            rc = 0;
+        }
+    }
+
+    return rc;
+}
+
+int loop_unregister(loop_t * lp, int fd)
+{
+    int rc = -1;
+    struct epoll_event event = { 0, };
+
+    if (!loop_registered(lp, fd)) {
+        errno = ENOENT;
+    } else {
+        rc = epoll_ctl(lp->epfd, EPOLL_CTL_DEL, fd, &event);
+        lp->handler[fd].callback = (loop_callback_t *)0;
+        lp->handler[fd].context = (void *)0;
+        lp->handler[fd].events = 0;
+        lp->registered -= 1;
+    }
+
+    return rc;
+}
+
+/*******************************************************************************
+ * DISPATCHING
+ ******************************************************************************/
+
+int loop_wait(loop_t * lp, int milliseconds)
+{
+    int result = 0;
+    int ready = 0;
+    int ii = 0;
+    int fd = -1;
+    uint32_t generation = 0;
+    loop_handler_t * hp = (loop_handler_t *)0;
+
+    if ((ready = epoll_wait(lp->epfd, lp->event, lp->events, milliseconds)) < 0) {
+        result = -1;
+    } else if (ready == 0) {
+        /* Do nothing. */
+    } else {
+        lp->wakeups += 1;
+        for (ii = 0; ii < ready; ++ii) {
+            fd = (int)(lp->event[ii].data.u64 & 0xffffffff);
+            generation = (uint32_t)(lp->event[ii].data.u64 >> 32);
+            if (!loop_registered(lp, fd)) {
+                continue;
+            }
+            hp = &(lp->handler[fd]);
+            if (hp->generation != generation) {
+                continue;
+            }
+            (*(hp->callback))(lp, fd, lp->event[ii].events, hp->context);
+            result += 1;
+        }
+        lp->dispatches += result;
+    }
+
+    return result;
+}
@@ -0,0 +1,98 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the NTP Shared Memory module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "com/diag/hazer/ntpshm.h"
+
+ntpshm_time_t * ntpshm_attach(key_t key, int mode)
+{
+    ntpshm_time_t * tp = (ntpshm_time_t *)0;
+    void * pointer = (void *)0;
+    int id = -1;
+
+    if ((id = shmget(key, sizeof(ntpshm_time_t), IPC_CREAT | mode)) < 0) {
+        /* Do nothing. */
+    } else if ((pointer = shmat(id, (const void *)0, 0)) == (void *)-1) {
+        /* Do nothing. */
+    } else {
+        tp = (ntpshm_time_t *)pointer;
+        tp->valid = 0;
+        __sync_synchronize();
+        tp->mode = NTPSHM_MODE;
+        tp->nsamples = 3;
+    }
+
+    return tp;
+}
+
+ntpshm_time_t * ntpshm_unit(int unit)
+{
+    return ntpshm_attach(ntpshm_key(unit), (unit < NTPSHM_PUBLIC) ? 0600 : 0666);
+}
+
+ntpshm_time_t * ntpshm_detach(ntpshm_time_t * tp)
+{
+    if (shmdt(tp) == 0) {
+        tp = (ntpshm_time_t *)0;
+    }
+
+    return tp;
+}
+
+void ntpshm_post(ntpshm_time_t * tp, const ntpshm_sample_t * sp)
+{
+    tp->valid = 0;
+    tp->count += 1;
+    __sync_synchronize();
+    tp->clockTimeStampSec = sp->clock / PULSE_SECOND;
+    tp->clockTimeStampNSec = sp->clock % PULSE_SECOND;
+    tp->clockTimeStampUSec = tp->clockTimeStampNSec / 1000;
+    tp->receiveTimeStampSec = sp->receive / PULSE_SECOND;
+    tp->receiveTimeStampNSec = sp->receive % PULSE_SECOND;
+    tp->receiveTimeStampUSec = tp->receiveTimeStampNSec / 1000;
+    tp->leap = sp->leap;
+    tp->precision = sp->precision;
+    __sync_synchronize();
+    tp->count += 1;
+    tp->valid = 1;
+}
+
+int ntpshm_read(ntpshm_time_t * tp, ntpshm_sample_t * sp)
+{
+    int rc = -1;
+    int count = 0;
+    ntpshm_time_t copy;
+
+    count = tp->count;
+    __sync_synchronize();
+    memcpy(&copy, tp, sizeof(copy));
+    __sync_synchronize();
+
+    if (!copy.valid) {
+        errno = EAGAIN;
+    } else if (copy.mode != NTPSHM_MODE) {
+        errno = EAGAIN;
+    } else if (tp->count != count) {
+        errno = EAGAIN;
+    } else {
+        sp->clock = (copy.clockTimeStampSec * PULSE_SECOND) + copy.clockTimeStampNSec;
+        sp->receive = (copy.receiveTimeStampSec * PULSE_SECOND) + copy.receiveTimeStampNSec;
+        sp->leap = copy.leap;
+        sp->precision = copy.precision;
+        tp->valid = 0;
+        rc = 0;
+    }
+
+    return rc;
+}
@@ -0,0 +1,217 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Observer module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "com/diag/hazer/observer.h"
+
+/**
+ * This is appended to the observation file path name to make the template
+ * for the temporary file.
+ */
+static const char SUFFIX[] = "-XXXXXX";
+
+observer_t * observer_init(observer_t * op, const char * path, mode_t mode, size_t size, int64_t interval, unsigned int every)
+{
+    observer_t * result = (observer_t *)0;
+    size_t length = 0;
+
+    memset(op, 0, sizeof(*op));
+
+    op->mode = mode;
+    op->size = size;
+    op->interval = (interval > 0) ? interval : 0;
+    op->every = every;
+
+    length = strlen(path);
+
+    if ((op->path = strdup(path)) == (char *)0) {
+        /* Do nothing. */
+    } else if ((op->temp = (char *)malloc(length + sizeof(SUFFIX))) == (char *)0) {
+        /* Do nothing. */
+    } else if ((op->data = (char *)malloc(size)) == (char *)0) {
+        /* Do nothing. */
+    } else {
+        result = op;
+    }
+
+    if (result == (observer_t *)0) {
+        observer_fini(op);
+    }
+
+    return result;
+}
+
+void observer_fini(observer_t * op)
+{
+    free(op->data);
+    op->data = (char *)0;
+    free(op->temp);
+    op->temp = (char *)0;
+    free(op->path);
+    op->path = (char *)0;
+    op->dirty = 0;
+}
+
+/**
+ * Write the held datagram to a temporary file and rename it to be the
+ * observation file.
+ * @param op points to the observer.
+ * @return >0 for success, <0 with errno set if an error occurred.
+ */
+static int observer_commit(observer_t * op)
+{
+    int rc = -1;
+    int fd = -1;
+    int error = 0;
+    ssize_t written = 0;
+    size_t offset = 0;
+
+    strcpy(op->temp, op->path);
+    strcat(op->temp, SUFFIX);
+
+    do {
+
+        op->operations += 1;
+        if ((fd = mkstemp(op->temp)) < 0) {
+            error = errno;
+            break;
+        }
+
+        op->operations += 1;
+        if (fchmod(fd, op->mode) < 0) {
+            error = errno;
+            break;
+        }
+
+        while (offset < op->length) {
+            op->operations += 1;
+            if ((written = write(fd, op->data + offset, op->length - offset)) > 0) {
+                offset += written;
+            } else if ((written < 0) && (errno == EINTR)) {
+                continue;
+            } else {
+                error = (written < 0) ? errno : EIO;
+                break;
+            }
+        }
+        if (error != 0) {
+            break;
+        }
+
+        if ((op->every > 0) && (((op->commits + 1) % op->every) == 0)) {
+            op->operations += 1;
+            if (fsync(fd) < 0) {
+                error = errno;
+                break;
+            }
+            op->syncs += 1;
+        }
+
+        op->operations += 1;
+        rc = close(fd);
+        fd = -1;
+        if (rc < 0) {
+            error = errno;
+            break;
+        }
+
+        op->operations += 1;
+        if ((rc = rename(op->temp, op->path)) < 0) {
+            error = errno;
+            break;
+        }
+
+        rc = 1;
+
+    } while (0);
+
+    if (error != 0) {
+        if (fd >= 0) {
+            (void)close(fd);
+        }
+        (void)unlink(op->temp);
+        op->errors += 1;
+        errno = error;
+        rc = -1;
+    } else {
+        op->commits += 1;
+    }
+
+    /*
+     * Even a failed commit discards the held datagram (and, in the caller,
+     * restarts the interval), so that a file system that is full or
+     * read-only isn't retried for every datagram.
+     */
+
+    op->dirty = 0;
+
+    return rc;
+}
+
+int64_t observer_remaining(const observer_t * op, int64_t now)
+{
+    int64_t result = -1;
+
+    if (!op->dirty) {
+        /* Do nothing. */
+    } else if (!op->primed) {
+        result = 0;
+    } else if ((now - op->then) >= op->interval) {
+        result = 0;
+    } else {
+        result = op->interval - (now - op->then);
+    }
+
+    return result;
+}
+
+int observer_poll(observer_t * op, int64_t now)
+{
+    int rc = 0;
+
+    if (observer_remaining(op, now) == 0) {
+        rc = observer_commit(op);
+        op->then = now;
+        op->primed = !0;
+    }
+
+    return rc;
+}
+
+int observer_offer(observer_t * op, const void * buffer, size_t length, int64_t now)
+{
+    if (length > op->size) {
+        length = op->size;
+    }
+
+    memcpy(op->data, buffer, length);
+    op->length = length;
+    op->dirty = !0;
+    op->offered += 1;
+
+    return observer_poll(op, now);
+}
+
+int observer_flush(observer_t * op)
+{
+    int rc = 0;
+
+    if (op->dirty) {
+        rc = observer_commit(op);
+    }
+
+    return rc;
+}
@@ -0,0 +1,195 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Pacer module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "com/diag/hazer/pacer.h"
+#include "com/diag/hazer/common.h"
+
+/**
+ * Return the histogram bucket of a value. Values less than the number of
+ * linear buckets have a bucket each; above that, each power of two is
+ * divided into the same number of linear buckets.
+ * @param value is the value.
+ * @return the bucket.
+ */
+static unsigned int pacer_bucket(uint64_t value)
+{
+    unsigned int bucket = 0;
+    unsigned int power = 0;
+
+    if (value < PACER_LINEAR) {
+        bucket = value;
+    } else {
+        power = 63 - __builtin_clzll(value);
+        bucket = ((power - PACER_SHIFT + 1) * PACER_LINEAR) + ((value >> (power - PACER_SHIFT)) & (PACER_LINEAR - 1));
+    }
+
+    return bucket;
+}
+
+/**
+ * Return the value in the middle of a histogram bucket.
+ * @param bucket is the bucket.
+ * @return the value.
+ */
+static uint64_t pacer_value(unsigned int bucket)
+{
+    uint64_t value = 0;
+    unsigned int shift = 0;
+
+    if (bucket < PACER_LINEAR) {
+        value = bucket;
+    } else {
+        shift = (bucket / PACER_LINEAR) - 1;
+        value = ((uint64_t)(PACER_LINEAR + (bucket % PACER_LINEAR)) << shift) + (((uint64_t)1 << shift) / 2);
+    }
+
+    return value;
+}
+
+pacer_t * pacer_init(pacer_t * pp, double speed)
+{
+    pacer_t * result = (pacer_t *)0;
+
+    memset(pp, 0, sizeof(*pp));
+
+    if (!(speed >= 0.0)) {
+        errno = EINVAL;
+    } else {
+        pp->speed = speed;
+        result = pp;
+    }
+
+    return result;
+}
+
+int64_t pacer_deadline(pacer_t * pp, int64_t stamp)
+{
+    int64_t deadline = 0;
+
+    if (!pp->started) {
+        pp->first = stamp;
+        pp->start = common_clock(CLOCK_MONOTONIC);
+        pp->started = !0;
+        deadline = pp->start;
+    } else if (pp->speed == 0.0) {
+        deadline = pp->start;
+    } else if (stamp <= pp->first) {
+        deadline = pp->start;
+    } else {
+        deadline = pp->start + (int64_t)((stamp - pp->first) / pp->speed);
+    }
+
+    return deadline;
+}
+
+void pacer_account(pacer_t * pp, uint64_t lateness)
+{
+    pp->total += lateness;
+    if (lateness > pp->latest) {
+        pp->latest = lateness;
+    }
+    pp->bucket[pacer_bucket(lateness)] += 1;
+}
+
+int64_t pacer_wait(pacer_t * pp, int64_t stamp)
+{
+    int64_t deadline = 0;
+    int64_t now = 0;
+    int64_t lateness = 0;
+    struct timespec until;
+
+    deadline = pacer_deadline(pp, stamp);
+
+    pp->items += 1;
+
+    if (pp->speed == 0.0) {
+        /* Do nothing. */
+    } else {
+        if ((now = common_clock(CLOCK_MONOTONIC)) < deadline) {
+            until.tv_sec = deadline / 1000000000LL;
+            until.tv_nsec = deadline % 1000000000LL;
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, (struct timespec *)0) == EINTR) {
+                /* Do nothing. */
+            }
+            pp->sleeps += 1;
+            now = common_clock(CLOCK_MONOTONIC);
+        } else if (now > deadline) {
+            pp->late += 1;
+        } else {
+            /* Do nothing. */
+        }
+        lateness = (now > deadline) ? (now - deadline) : 0;
+        pacer_account(pp, lateness);
+    }
+
+    return lateness;
+}
+
+int pacer_write(int fd, const void * data, size_t length)
+{
+    const char * bp = (const char *)0;
+    ssize_t rc = 0;
+
+    for (bp = (const char *)data; length > 0; bp += rc, length -= rc) {
+        if ((rc = write(fd, bp, length)) > 0) {
+            /* Do nothing. */
+        } else if ((rc < 0) && (errno == EINTR)) {
+            rc = 0;
+        } else {
+            if (rc == 0) {
+                errno = EIO;
+            }
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+uint64_t pacer_percentile(const pacer_t * pp, double percentile)
+{
+    uint64_t result = 0;
+    uint64_t count = 0;
+    uint64_t rank = 0;
+    uint64_t sum = 0;
+    unsigned int ii = 0;
+
+    for (ii = 0; ii < PACER_BUCKETS; ++ii) {
+        count += pp->bucket[ii];
+    }
+
+    if (count > 0) {
+        rank = (uint64_t)(((percentile / 100.0) * count) + 0.5);
+        if (rank < 1) {
+            rank = 1;
+        } else if (rank > count) {
+            rank = count;
+        } else {
+            /* Do nothing. */
+        }
+        for (ii = 0; ii < PACER_BUCKETS; ++ii) {
+            sum += pp->bucket[ii];
+            if (sum >= rank) {
+                result = pacer_value(ii);
+                break;
+            }
+        }
+        if (result > pp->latest) {
+            result = pp->latest;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,141 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Pulse module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <math.h>
+#include "com/diag/hazer/pulse.h"
+
+uint32_t pulse_ring_put(pulse_ring_t * rp, pulse_nanoseconds_t realtime, pulse_nanoseconds_t monotonic, pulse_source_t source)
+{
+    pulse_edge_t * ep = (pulse_edge_t *)0;
+
+    rp->sequence += 1;
+    if (rp->sequence == 0) {
+        rp->sequence = 1;
+    }
+
+    ep = &(rp->edge[rp->sequence & (PULSE_EDGES - 1)]);
+    ep->realtime = realtime;
+    ep->monotonic = monotonic;
+    ep->sequence = rp->sequence;
+    ep->source = source;
+
+    return rp->sequence;
+}
+
+const pulse_edge_t * pulse_ring_get(const pulse_ring_t * rp, unsigned int age)
+{
+    const pulse_edge_t * ep = (const pulse_edge_t *)0;
+    uint32_t sequence = 0;
+
+    if (age >= PULSE_EDGES) {
+        /* Do nothing. */
+    } else if (rp->sequence == 0) {
+        /* Do nothing. */
+    } else if ((sequence = rp->sequence - age) == 0) {
+        /* Do nothing. */
+    } else if (rp->edge[sequence & (PULSE_EDGES - 1)].sequence != sequence) {
+        /* Do nothing. */
+    } else {
+        ep = &(rp->edge[sequence & (PULSE_EDGES - 1)]);
+    }
+
+    return ep;
+}
+
+const pulse_edge_t * pulse_ring_nearest(const pulse_ring_t * rp, pulse_nanoseconds_t realtime, pulse_nanoseconds_t window)
+{
+    const pulse_edge_t * result = (const pulse_edge_t *)0;
+    const pulse_edge_t * ep = (const pulse_edge_t *)0;
+    pulse_nanoseconds_t difference = 0;
+    pulse_nanoseconds_t best = 0;
+    unsigned int age = 0;
+
+    for (age = 0; age < PULSE_EDGES; ++age) {
+        if ((ep = pulse_ring_get(rp, age)) == (const pulse_edge_t *)0) {
+            break;
+        }
+        difference = ep->realtime - realtime;
+        if (difference < 0) {
+            difference = -difference;
+        }
+        if (difference > window) {
+            /* Do nothing. */
+        } else if ((result == (const pulse_edge_t *)0) || (difference < best)) {
+            result = ep;
+            best = difference;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    return result;
+}
+
+int pulse_measure(pulse_statistics_t * sp, const pulse_ring_t * rp, pulse_nanoseconds_t utc)
+{
+    int rc = -1;
+    const pulse_edge_t * ep = (const pulse_edge_t *)0;
+    const pulse_edge_t * pp = (const pulse_edge_t *)0;
+    double delta = 0.0;
+
+    if ((ep = pulse_ring_nearest(rp, utc, PULSE_SECOND / 2)) == (const pulse_edge_t *)0) {
+        /* Do nothing. */
+    } else if (ep->sequence == sp->sequence) {
+        /* Do nothing. */
+    } else {
+        sp->sequence = ep->sequence;
+        sp->offset = ep->realtime - utc;
+        if ((sp->count == 0) || (sp->offset < sp->minimum)) {
+            sp->minimum = sp->offset;
+        }
+        if ((sp->count == 0) || (sp->offset > sp->maximum)) {
+            sp->maximum = sp->offset;
+        }
+        sp->count += 1;
+        delta = sp->offset - sp->mean;
+        sp->mean += delta / sp->count;
+        sp->m2 += delta * (sp->offset - sp->mean);
+        if (((pp = pulse_ring_get(rp, rp->sequence - ep->sequence + 1)) != (const pulse_edge_t *)0) && (pp->sequence == (ep->sequence - 1))) {
+            sp->period = ep->monotonic - pp->monotonic;
+        }
+        rc = 0;
+    }
+
+    return rc;
+}
+
+int pulse_measure_next(pulse_statistics_t * sp, const pulse_ring_t * rp, pulse_nanoseconds_t utc)
+{
+    int rc = -1;
+    const pulse_edge_t * ep = (const pulse_edge_t *)0;
+    pulse_nanoseconds_t seconds = 0;
+    unsigned int age = 0;
+
+    for (age = PULSE_EDGES; (rc < 0) && (age > 0); --age) {
+        if ((ep = pulse_ring_get(rp, age - 1)) == (const pulse_edge_t *)0) {
+            /* Do nothing. */
+        } else if ((int32_t)(ep->sequence - sp->sequence) <= 0) {
+            /* Do nothing. */
+        } else {
+            seconds = ep->realtime - utc;
+            seconds += (seconds < 0) ? -(PULSE_SECOND / 2) : (PULSE_SECOND / 2);
+            seconds /= PULSE_SECOND;
+            rc = pulse_measure(sp, rp, utc + (seconds * PULSE_SECOND));
+        }
+    }
+
+    return rc;
+}
+
+double pulse_jitter(const pulse_statistics_t * sp)
+{
+    return (sp->count > 1) ? sqrt(sp->m2 / (sp->count - 1)) : 0.0;
+}
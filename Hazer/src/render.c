@@ -0,0 +1,212 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Render module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <string.h>
+#include <wchar.h>
+#include "com/diag/hazer/render.h"
+
+/**
+ * These are the two digit decimal representations of 0 through 99.
+ */
+static const char PAIRS[200] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * These are the powers of ten that fit in a uint64_t.
+ */
+static const uint64_t POWERS[RENDER_POWERS + 1] = {
+    1ULL,
+    10ULL,
+    100ULL,
+    1000ULL,
+    10000ULL,
+    100000ULL,
+    1000000ULL,
+    10000000ULL,
+    100000000ULL,
+    1000000000ULL,
+    10000000000ULL,
+    100000000000ULL,
+    1000000000000ULL,
+    10000000000000ULL,
+    100000000000000ULL,
+    1000000000000000ULL,
+    10000000000000000ULL,
+    100000000000000000ULL,
+    1000000000000000000ULL,
+    10000000000000000000ULL,
+};
+
+/**
+ * Convert an unsigned integer into digits at the end of a scratch buffer.
+ * @param end points past the end of the scratch buffer.
+ * @param value is the integer.
+ * @return a pointer to the first digit.
+ */
+static inline char * render_digits(char * end, uint64_t value)
+{
+    const char * pp = (const char *)0;
+
+    while (value >= 100) {
+        pp = &(PAIRS[(value % 100) * 2]);
+        value /= 100;
+        *(--end) = pp[1];
+        *(--end) = pp[0];
+    }
+
+    if (value >= 10) {
+        pp = &(PAIRS[value * 2]);
+        *(--end) = pp[1];
+        *(--end) = pp[0];
+    } else {
+        *(--end) = '0' + value;
+    }
+
+    return end;
+}
+
+char * render_unsigned(char * bp, uint64_t value)
+{
+    char scratch[RENDER_DIGITS];
+    char * end = &(scratch[sizeof(scratch)]);
+    char * here = (char *)0;
+    size_t length = 0;
+
+    here = render_digits(end, value);
+    length = end - here;
+    memcpy(bp, here, length);
+
+    return bp + length;
+}
+
+char * render_signed(char * bp, int64_t value)
+{
+    if (value < 0) {
+        *(bp++) = '-';
+        bp = render_unsigned(bp, -(uint64_t)value);
+    } else {
+        bp = render_unsigned(bp, value);
+    }
+
+    return bp;
+}
+
+char * render_zeros(char * bp, uint64_t value, int width)
+{
+    char scratch[RENDER_DIGITS];
+    char * end = &(scratch[sizeof(scratch)]);
+    char * here = (char *)0;
+    size_t length = 0;
+
+    here = render_digits(end, value);
+    length = end - here;
+
+    if (width > RENDER_DIGITS) {
+        width = RENDER_DIGITS;
+    }
+
+    while (length < width) {
+        *(--here) = '0';
+        length += 1;
+    }
+
+    memcpy(bp, here, length);
+
+    return bp + length;
+}
+
+char * render_fixed(char * bp, int64_t value, int digits)
+{
+    uint64_t magnitude = 0;
+
+    if (value < 0) {
+        *(bp++) = '-';
+        magnitude = -(uint64_t)value;
+    } else {
+        magnitude = value;
+    }
+
+    if (digits <= 0) {
+        bp = render_unsigned(bp, magnitude);
+        *(bp++) = '.';
+    } else {
+        bp = render_unsigned(bp, magnitude / POWERS[digits]);
+        *(bp++) = '.';
+        bp = render_zeros(bp, magnitude % POWERS[digits], digits);
+    }
+
+    return bp;
+}
+
+char * render_right(char * begin, char * bp, int width)
+{
+    size_t length = 0;
+    size_t pad = 0;
+
+    length = bp - begin;
+
+    if (length < width) {
+        pad = width - length;
+        memmove(begin + pad, begin, length);
+        memset(begin, ' ', pad);
+        bp += pad;
+    }
+
+    return bp;
+}
+
+char * render_left(char * bp, const char * string, int width)
+{
+    int ii = 0;
+
+    for (ii = 0; (ii < width) && (string[ii] != '\0'); ++ii) {
+        *(bp++) = string[ii];
+    }
+
+    for (; ii < width; ++ii) {
+        *(bp++) = ' ';
+    }
+
+    return bp;
+}
+
+char * render_string(char * bp, const char * string)
+{
+    size_t length = 0;
+
+    length = strlen(string);
+    memcpy(bp, string, length);
+
+    return bp + length;
+}
+
+char * render_wide(char * bp, wint_t wc)
+{
+    mbstate_t state;
+    size_t length = 0;
+
+    memset(&state, 0, sizeof(state));
+
+    if ((length = wcrtomb(bp, (wchar_t)wc, &state)) != (size_t)-1) {
+        bp += length;
+    }
+
+    return bp;
+}
@@ -0,0 +1,134 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Simplify module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The recursion of Douglas-Peucker is replaced with a stack of the pieces
+ * of the path still to be examined, so a path of a million points that
+ * simplifies badly doesn't overflow the real stack.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "com/diag/hazer/simplify.h"
+
+double simplify_distance(const simplify_point_t * pp, const simplify_point_t * ap, const simplify_point_t * bp)
+{
+    double scale = 0.0;
+    double bx = 0.0;
+    double by = 0.0;
+    double px = 0.0;
+    double py = 0.0;
+    double length = 0.0;
+    double fraction = 0.0;
+
+    /*
+     * Longitudes are measured the short way around, so a segment that
+     * crosses the antimeridian isn't taken to go around the world.
+     */
+
+    scale = SIMPLIFY_RADIUS * M_PI / 180.0;
+
+    bx = remainder(bp->longitude - ap->longitude, 360.0) * cos(ap->latitude * M_PI / 180.0) * scale;
+    by = (bp->latitude - ap->latitude) * scale;
+    px = remainder(pp->longitude - ap->longitude, 360.0) * cos(ap->latitude * M_PI / 180.0) * scale;
+    py = (pp->latitude - ap->latitude) * scale;
+
+    length = (bx * bx) + (by * by);
+    if (length > 0.0) {
+        fraction = ((px * bx) + (py * by)) / length;
+        if (fraction < 0.0) {
+            fraction = 0.0;
+        } else if (fraction > 1.0) {
+            fraction = 1.0;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    return hypot(px - (fraction * bx), py - (fraction * by));
+}
+
+ssize_t simplify_path(const simplify_point_t * points, size_t count, double tolerance, uint8_t * keep)
+{
+    ssize_t kept = 0;
+    size_t (*stack)[2] = (size_t (*)[2])0;
+    size_t depth = 0;
+    size_t first = 0;
+    size_t last = 0;
+    size_t farthest = 0;
+    size_t ii = 0;
+    double distance = 0.0;
+    double maximum = 0.0;
+
+    memset(keep, 0, count);
+
+    if (count <= 2) {
+        memset(keep, !0, count);
+        return count;
+    }
+
+    /*
+     * The pieces on the stack never overlap except at their ends, and each
+     * has at least one point between its ends, so there are never more of
+     * them than there are points.
+     */
+
+    if ((stack = (size_t (*)[2])malloc(count * sizeof(stack[0]))) == (size_t (*)[2])0) {
+        return -1;
+    }
+
+    keep[0] = !0;
+    keep[count - 1] = !0;
+    kept = 2;
+
+    stack[depth][0] = 0;
+    stack[depth][1] = count - 1;
+    depth += 1;
+
+    while (depth > 0) {
+
+        depth -= 1;
+        first = stack[depth][0];
+        last = stack[depth][1];
+
+        maximum = -1.0;
+        farthest = first;
+        for (ii = first + 1; ii < last; ++ii) {
+            distance = simplify_distance(&(points[ii]), &(points[first]), &(points[last]));
+            if (distance > maximum) {
+                maximum = distance;
+                farthest = ii;
+            }
+        }
+
+        if (maximum <= tolerance) {
+            continue;
+        }
+
+        keep[farthest] = !0;
+        kept += 1;
+
+        if ((farthest - first) > 1) {
+            stack[depth][0] = first;
+            stack[depth][1] = farthest;
+            depth += 1;
+        }
+
+        if ((last - farthest) > 1) {
+            stack[depth][0] = farthest;
+            stack[depth][1] = last;
+            depth += 1;
+        }
+
+    }
+
+    free(stack);
+
+    return kept;
+}
@@ -0,0 +1,145 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Snapshot module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "com/diag/hazer/snapshot.h"
+
+snapshot_region_t * snapshot_create(const char * name)
+{
+    snapshot_region_t * rp = (snapshot_region_t *)0;
+    void * pointer = MAP_FAILED;
+    int fd = -1;
+
+    if ((fd = shm_open(name, O_RDWR | O_CREAT, 0644)) < 0) {
+        /* Do nothing. */
+    } else if (ftruncate(fd, sizeof(snapshot_region_t)) < 0) {
+        /* Do nothing. */
+    } else if ((pointer = mmap((void *)0, sizeof(snapshot_region_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        /* Do nothing. */
+    } else {
+        rp = (snapshot_region_t *)pointer;
+        __atomic_store_n(&(rp->sequence), 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        memset(&(rp->fix), 0, sizeof(rp->fix));
+        rp->magic = SNAPSHOT_MAGIC;
+        rp->version = SNAPSHOT_VERSION;
+        rp->size = sizeof(snapshot_region_t);
+        __atomic_store_n(&(rp->sequence), 2, __ATOMIC_RELEASE);
+    }
+
+    if (fd >= 0) {
+        (void)close(fd);
+    }
+
+    return rp;
+}
+
+void snapshot_begin(snapshot_region_t * rp)
+{
+    __atomic_store_n(&(rp->sequence), rp->sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void snapshot_end(snapshot_region_t * rp)
+{
+    int ii = 0;
+
+    for (ii = 0; ii < HAZER_SYSTEM_TOTAL; ++ii) {
+        rp->fix.positions[ii].label = (const char *)0;
+        rp->fix.actives[ii].label = (const char *)0;
+    }
+
+    __atomic_store_n(&(rp->sequence), rp->sequence + 1, __ATOMIC_RELEASE);
+}
+
+snapshot_region_t * snapshot_destroy(snapshot_region_t * rp, const char * name)
+{
+    if (munmap(rp, sizeof(snapshot_region_t)) == 0) {
+        (void)shm_unlink(name);
+        rp = (snapshot_region_t *)0;
+    }
+
+    return rp;
+}
+
+const snapshot_region_t * snapshot_open(const char * name)
+{
+    const snapshot_region_t * rp = (const snapshot_region_t *)0;
+    void * pointer = MAP_FAILED;
+    struct stat status = { 0, };
+    int fd = -1;
+
+    if ((fd = shm_open(name, O_RDONLY, 0)) < 0) {
+        /* Do nothing. */
+    } else if (fstat(fd, &status) < 0) {
+        /* Do nothing. */
+    } else if (status.st_size != sizeof(snapshot_region_t)) {
+        errno = EPROTO;
+    } else if ((pointer = mmap((void *)0, sizeof(snapshot_region_t), PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED) {
+        /* Do nothing. */
+    } else if ((((const snapshot_region_t *)pointer)->magic != SNAPSHOT_MAGIC) || (((const snapshot_region_t *)pointer)->version != SNAPSHOT_VERSION) || (((const snapshot_region_t *)pointer)->size != sizeof(snapshot_region_t))) {
+        (void)munmap(pointer, sizeof(snapshot_region_t));
+        errno = EPROTO;
+    } else {
+        rp = (const snapshot_region_t *)pointer;
+    }
+
+    if (fd >= 0) {
+        (void)close(fd);
+    }
+
+    return rp;
+}
+
+int snapshot_read(const snapshot_region_t * rp, snapshot_fix_t * fp, uint32_t * sequencep)
+{
+    int rc = -1;
+    int tries = 0;
+    uint32_t before = 0;
+    uint32_t after = 0;
+
+    for (tries = 0; tries < SNAPSHOT_TRIES; ++tries) {
+        before = __atomic_load_n(&(rp->sequence), __ATOMIC_ACQUIRE);
+        if ((before & 1) != 0) {
+            continue;
+        }
+        memcpy(fp, (const void *)&(rp->fix), sizeof(*fp));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        after = __atomic_load_n(&(rp->sequence), __ATOMIC_RELAXED);
+        if (after == before) {
+            if (sequencep != (uint32_t *)0) {
+                *sequencep = before;
+            }
+            rc = 0;
+            break;
+        }
+    }
+
+    if (rc < 0) {
+        errno = EAGAIN;
+    }
+
+    return rc;
+}
+
+const snapshot_region_t * snapshot_close(const snapshot_region_t * rp)
+{
+    if (munmap((void *)rp, sizeof(snapshot_region_t)) == 0) {
+        rp = (const snapshot_region_t *)0;
+    }
+
+    return rp;
+}
@@ -0,0 +1,225 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Statistics module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "com/diag/hazer/statistics.h"
+
+/**
+ * This is a value in the sketch and the number of values it stands for.
+ */
+typedef struct StatisticsWeighted {
+    double value;
+    uint64_t weight;
+} statistics_weighted_t;
+
+static int statistics_compare(const void * ap, const void * bp)
+{
+    double aa = *(const double *)ap;
+    double bb = *(const double *)bp;
+
+    return (aa < bb) ? -1 : (aa > bb) ? 1 : 0;
+}
+
+static int statistics_compare_weighted(const void * ap, const void * bp)
+{
+    return statistics_compare(&(((const statistics_weighted_t *)ap)->value), &(((const statistics_weighted_t *)bp)->value));
+}
+
+/**
+ * Put a value into a level of the sketch, compacting the level into the
+ * one above it if it is full.
+ * @param sp points to the statistics.
+ * @param level is the level.
+ * @param value is the value.
+ * @return 0 for success or <0 with errno set if an error occurred.
+ */
+static int statistics_insert(statistics_t * sp, int level, double value)
+{
+    int rc = 0;
+    int ii = 0;
+    double * values = (double *)0;
+
+    if (level >= STATISTICS_LEVELS) {
+        errno = EOVERFLOW;
+        return -1;
+    }
+
+    if (sp->level[level] != (double *)0) {
+        /* Do nothing. */
+    } else if ((sp->level[level] = (double *)malloc(STATISTICS_CAPACITY * sizeof(double))) == (double *)0) {
+        return -1;
+    } else {
+        /* Do nothing. */
+    }
+
+    values = sp->level[level];
+    values[sp->items[level]++] = value;
+
+    if (sp->items[level] >= STATISTICS_CAPACITY) {
+        qsort(values, STATISTICS_CAPACITY, sizeof(values[0]), statistics_compare);
+        sp->items[level] = 0;
+        for (ii = sp->parity[level]; ii < STATISTICS_CAPACITY; ii += 2) {
+            if ((rc = statistics_insert(sp, level + 1, values[ii])) < 0) {
+                break;
+            }
+        }
+        sp->parity[level] = !sp->parity[level];
+    }
+
+    return rc;
+}
+
+statistics_t * statistics_init(statistics_t * sp)
+{
+    memset(sp, 0, sizeof(*sp));
+
+    return sp;
+}
+
+void statistics_fini(statistics_t * sp)
+{
+    int ii = 0;
+
+    for (ii = 0; ii < STATISTICS_LEVELS; ++ii) {
+        free(sp->level[ii]);
+    }
+
+    statistics_init(sp);
+}
+
+int statistics_add(statistics_t * sp, double value)
+{
+    double delta = 0.0;
+
+    if (sp->count == 0) {
+        sp->minimum = value;
+        sp->maximum = value;
+    } else if (value < sp->minimum) {
+        sp->minimum = value;
+    } else if (value > sp->maximum) {
+        sp->maximum = value;
+    } else {
+        /* Do nothing. */
+    }
+
+    sp->count += 1;
+    delta = value - sp->mean;
+    sp->mean += delta / sp->count;
+    sp->m2 += delta * (value - sp->mean);
+
+    return statistics_insert(sp, 0, value);
+}
+
+int statistics_merge(statistics_t * sp, const statistics_t * that)
+{
+    int rc = 0;
+    int ii = 0;
+    int jj = 0;
+    uint64_t count = 0;
+    double delta = 0.0;
+
+    if (that->count == 0) {
+        return 0;
+    }
+
+    if (sp->count == 0) {
+        sp->minimum = that->minimum;
+        sp->maximum = that->maximum;
+    } else {
+        if (that->minimum < sp->minimum) {
+            sp->minimum = that->minimum;
+        }
+        if (that->maximum > sp->maximum) {
+            sp->maximum = that->maximum;
+        }
+    }
+
+    count = sp->count + that->count;
+    delta = that->mean - sp->mean;
+    sp->mean += delta * ((double)that->count / count);
+    sp->m2 += that->m2 + (delta * delta * ((double)sp->count * that->count / count));
+    sp->count = count;
+
+    for (ii = 0; (rc == 0) && (ii < STATISTICS_LEVELS); ++ii) {
+        for (jj = 0; (rc == 0) && (jj < that->items[ii]); ++jj) {
+            rc = statistics_insert(sp, ii, that->level[ii][jj]);
+        }
+    }
+
+    return rc;
+}
+
+double statistics_percentile(const statistics_t * sp, double percentile)
+{
+    double result = 0.0;
+    statistics_weighted_t * weighted = (statistics_weighted_t *)0;
+    size_t count = 0;
+    uint64_t total = 0;
+    uint64_t rank = 0;
+    uint64_t cumulative = 0;
+    size_t ii = 0;
+    int jj = 0;
+
+    if (sp->count == 0) {
+        /* Do nothing. */
+    } else if (percentile <= 0.0) {
+        result = sp->minimum;
+    } else if (percentile >= 100.0) {
+        result = sp->maximum;
+    } else {
+
+        for (jj = 0; jj < STATISTICS_LEVELS; ++jj) {
+            count += sp->items[jj];
+        }
+
+        /*
+         * If there isn't memory for the estimate, the median of the range
+         * is better than nothing.
+         */
+
+        if ((weighted = (statistics_weighted_t *)malloc(count * sizeof(weighted[0]))) == (statistics_weighted_t *)0) {
+            return (sp->minimum + sp->maximum) / 2.0;
+        }
+
+        for (jj = 0, ii = 0; jj < STATISTICS_LEVELS; ++jj) {
+            for (count = 0; count < sp->items[jj]; ++count, ++ii) {
+                weighted[ii].value = sp->level[jj][count];
+                weighted[ii].weight = (uint64_t)1 << jj;
+                total += weighted[ii].weight;
+            }
+        }
+        count = ii;
+
+        qsort(weighted, count, sizeof(weighted[0]), statistics_compare_weighted);
+
+        rank = (uint64_t)ceil((percentile / 100.0) * total);
+        if (rank < 1) {
+            rank = 1;
+        }
+
+        result = weighted[count - 1].value;
+        for (ii = 0; ii < count; ++ii) {
+            cumulative += weighted[ii].weight;
+            if (cumulative >= rank) {
+                result = weighted[ii].value;
+                break;
+            }
+        }
+
+        free(weighted);
+
+    }
+
+    return result;
+}
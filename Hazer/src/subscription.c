@@ -0,0 +1,382 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Subscription module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include "com/diag/hazer/subscription.h"
+#include "com/diag/hazer/tumbleweed.h"
+
+/*******************************************************************************
+ * RULES
+ ******************************************************************************/
+
+/**
+ * Add a rule to a subscription, replacing any rule for the same number.
+ * @param sp points to the subscription.
+ * @param number is the RTCM message number.
+ * @param interval is the minimum interval in seconds.
+ * @return 0 for success, <0 if the subscription is full.
+ */
+static int subscription_add(subscription_t * sp, uint16_t number, uint16_t interval)
+{
+    int rc = -1;
+    unsigned int ii = 0;
+
+    for (ii = 0; ii < sp->rules; ++ii) {
+        if (sp->rule[ii].number == number) {
+            break;
+        }
+    }
+
+    if (ii < sp->rules) {
+        sp->rule[ii].interval = interval;
+        rc = 0;
+    } else if (sp->rules < SUBSCRIPTION_RULES) {
+        sp->rule[sp->rules].number = number;
+        sp->rule[sp->rules].interval = interval;
+        sp->rules += 1;
+        rc = 0;
+    } else {
+        errno = E2BIG;
+    }
+
+    return rc;
+}
+
+int subscription_parse(const char * string, subscription_t * sp)
+{
+    int rc = 0;
+    const char * here = string;
+    char * end = (char *)0;
+    unsigned long number = 0;
+    unsigned long interval = 0;
+
+    while (*here != '\0') {
+
+        if ((*here == ',') || (*here == ' ') || (*here == '\t') || (*here == '\n')) {
+            ++here;
+            continue;
+        }
+
+        number = strtoul(here, &end, 10);
+        if ((end == here) || (number > 4095)) {
+            errno = EINVAL;
+            rc = -1;
+            break;
+        }
+        here = end;
+
+        interval = 0;
+        if (*here == ':') {
+            ++here;
+            interval = strtoul(here, &end, 10);
+            if ((end == here) || (interval > 0xffff)) {
+                errno = EINVAL;
+                rc = -1;
+                break;
+            }
+            here = end;
+        }
+
+        if ((*here != '\0') && (*here != ',') && (*here != ' ') && (*here != '\t') && (*here != '\n')) {
+            errno = EINVAL;
+            rc = -1;
+            break;
+        }
+
+        if ((rc = subscription_add(sp, number, interval)) < 0) {
+            break;
+        }
+
+    }
+
+    return rc;
+}
+
+void subscription_reset(subscription_state_t * tp)
+{
+    int ii = 0;
+
+    for (ii = 0; ii < SUBSCRIPTION_RULES; ++ii) {
+        tp->forwarded[ii] = -1;
+    }
+}
+
+int subscription_admit(const subscription_t * sp, subscription_state_t * tp, int number, long now)
+{
+    int result = 0;
+    unsigned int ii = 0;
+
+    if (sp->rules == 0) {
+        result = !0;
+    } else if (number < 0) {
+        result = !0;
+    } else {
+        for (ii = 0; ii < sp->rules; ++ii) {
+            if (sp->rule[ii].number == number) {
+                break;
+            }
+        }
+        if (ii >= sp->rules) {
+            /* Do nothing. */
+        } else if (sp->rule[ii].interval == 0) {
+            result = !0;
+        } else if ((tp->forwarded[ii] < 0) || ((now - tp->forwarded[ii]) >= sp->rule[ii].interval)) {
+            tp->forwarded[ii] = now;
+            result = !0;
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+ * CONTROL MESSAGES
+ ******************************************************************************/
+
+ssize_t subscription_encode(const subscription_t * sp, void * buffer, size_t size)
+{
+    ssize_t result = -1;
+    uint8_t * bp = (uint8_t *)buffer;
+    size_t length = 0;
+    size_t total = 0;
+    size_t offset = 0;
+    unsigned int ii = 0;
+
+    length = TUMBLEWEED_RTCM_NUMBER + (sizeof(SUBSCRIPTION_TAG) - 1) + 1 + (sp->rules * 4);
+    total = TUMBLEWEED_RTCM_SUMMED + length + TUMBLEWEED_RTCM_CRC;
+
+    if (sp->rules > SUBSCRIPTION_RULES) {
+        errno = EINVAL;
+    } else if (total > size) {
+        errno = ENOSPC;
+    } else {
+        bp[TUMBLEWEED_RTCM_PREAMBLE] = 0xd3;
+        bp[TUMBLEWEED_RTCM_LENGTH_MSB] = (length >> 8) & 0x03;
+        bp[TUMBLEWEED_RTCM_LENGTH_LSB] = length & 0xff;
+        bp[TUMBLEWEED_RTCM_NUMBER_MSB] = (SUBSCRIPTION_NUMBER >> 4) & 0xff;
+        bp[TUMBLEWEED_RTCM_NUMBER_LSB] = (SUBSCRIPTION_NUMBER << 4) & 0xf0;
+        offset = TUMBLEWEED_RTCM_NUMBER_LSB + 1;
+        memcpy(&(bp[offset]), SUBSCRIPTION_TAG, sizeof(SUBSCRIPTION_TAG) - 1);
+        offset += sizeof(SUBSCRIPTION_TAG) - 1;
+        bp[offset++] = sp->rules;
+        for (ii = 0; ii < sp->rules; ++ii) {
+            bp[offset++] = sp->rule[ii].number >> 8;
+            bp[offset++] = sp->rule[ii].number & 0xff;
+            bp[offset++] = sp->rule[ii].interval >> 8;
+            bp[offset++] = sp->rule[ii].interval & 0xff;
+        }
+        if (tumbleweed_checksum_buffer(bp, total, &(bp[offset]), &(bp[offset + 1]), &(bp[offset + 2])) != (const void *)0) {
+            result = total;
+        }
+    }
+
+    return result;
+}
+
+int subscription_decode(const void * buffer, size_t length, subscription_t * sp)
+{
+    int rc = -1;
+    const uint8_t * bp = (const uint8_t *)buffer;
+    size_t offset = 0;
+    unsigned int rules = 0;
+    unsigned int ii = 0;
+
+    offset = TUMBLEWEED_RTCM_NUMBER_LSB + 1;
+
+    if (tumbleweed_message(buffer, length) != SUBSCRIPTION_NUMBER) {
+        /* Do nothing. */
+    } else if (length < (offset + (sizeof(SUBSCRIPTION_TAG) - 1) + 1 + TUMBLEWEED_RTCM_CRC)) {
+        /* Do nothing. */
+    } else if (memcmp(&(bp[offset]), SUBSCRIPTION_TAG, sizeof(SUBSCRIPTION_TAG) - 1) != 0) {
+        /* Do nothing. */
+    } else if ((rules = bp[offset + sizeof(SUBSCRIPTION_TAG) - 1]) > SUBSCRIPTION_RULES) {
+        /* Do nothing. */
+    } else if (length != (offset + (sizeof(SUBSCRIPTION_TAG) - 1) + 1 + (rules * 4) + TUMBLEWEED_RTCM_CRC)) {
+        /* Do nothing. */
+    } else {
+        offset += (sizeof(SUBSCRIPTION_TAG) - 1) + 1;
+        sp->rules = 0;
+        for (ii = 0; ii < rules; ++ii) {
+            (void)subscription_add(sp, (bp[offset] << 8) | bp[offset + 1], (bp[offset + 2] << 8) | bp[offset + 3]);
+            offset += 4;
+        }
+        rc = 0;
+    }
+
+    if (rc < 0) {
+        errno = EINVAL;
+    }
+
+    return rc;
+}
+
+/*******************************************************************************
+ * FILES
+ ******************************************************************************/
+
+/**
+ * Convert a printable IPv6 or IPv4 address into eight sixteen bit words in
+ * host byte order, mapping an IPv4 address into the IPv6 address space.
+ * @param string is the printable address.
+ * @param address points to where the address is stored.
+ * @return 0 for success, <0 if the address is invalid.
+ */
+static int subscription_address(const char * string, uint16_t address[8])
+{
+    int rc = 0;
+    struct in6_addr ipv6 = { 0, };
+    struct in_addr ipv4 = { 0, };
+    uint32_t value = 0;
+    int ii = 0;
+
+    if (inet_pton(AF_INET6, string, &ipv6) == 1) {
+        for (ii = 0; ii < 8; ++ii) {
+            address[ii] = (ipv6.s6_addr[ii * 2] << 8) | ipv6.s6_addr[(ii * 2) + 1];
+        }
+    } else if (inet_pton(AF_INET, string, &ipv4) == 1) {
+        value = ntohl(ipv4.s_addr);
+        for (ii = 0; ii < 5; ++ii) {
+            address[ii] = 0;
+        }
+        address[5] = 0xffff;
+        address[6] = value >> 16;
+        address[7] = value & 0xffff;
+    } else {
+        errno = EINVAL;
+        rc = -1;
+    }
+
+    return rc;
+}
+
+ssize_t subscription_load(const char * path, subscription_entry_t ** entriesp, unsigned int * linep)
+{
+    ssize_t result = -1;
+    FILE * fp = (FILE *)0;
+    subscription_entry_t * entries = (subscription_entry_t *)0;
+    subscription_entry_t * here = (subscription_entry_t *)0;
+    void * temporary = (void *)0;
+    char line[512] = { '\0', };
+    char * token = (char *)0;
+    char * save = (char *)0;
+    char * end = (char *)0;
+    unsigned long port = 0;
+    size_t count = 0;
+    size_t limit = 0;
+    unsigned int number = 0;
+    int error = 0;
+
+    if (linep != (unsigned int *)0) {
+        *linep = 0;
+    }
+
+    if ((fp = fopen(path, "r")) == (FILE *)0) {
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), fp) != (char *)0) {
+
+        number += 1;
+
+        if ((token = strchr(line, '#')) != (char *)0) {
+            *token = '\0';
+        }
+
+        if ((token = strtok_r(line, " \t\r\n", &save)) == (char *)0) {
+            continue;
+        }
+
+        if (count >= limit) {
+            limit = (limit == 0) ? 16 : (limit * 2);
+            if ((temporary = realloc(entries, limit * sizeof(*entries))) == (void *)0) {
+                error = errno;
+                break;
+            }
+            entries = (subscription_entry_t *)temporary;
+        }
+
+        here = &(entries[count]);
+        memset(here, 0, sizeof(*here));
+
+        if (subscription_address(token, here->address) < 0) {
+            error = EINVAL;
+            break;
+        }
+
+        if ((token = strtok_r((char *)0, " \t\r\n", &save)) == (char *)0) {
+            error = EINVAL;
+            break;
+        }
+
+        port = strtoul(token, &end, 10);
+        if ((*end != '\0') || (port > 0xffff)) {
+            error = EINVAL;
+            break;
+        }
+        here->port = port;
+
+        while ((token = strtok_r((char *)0, " \t\r\n", &save)) != (char *)0) {
+            if (subscription_parse(token, &(here->subscription)) < 0) {
+                error = errno;
+                break;
+            }
+        }
+        if (error != 0) {
+            break;
+        }
+
+        count += 1;
+
+    }
+
+    (void)fclose(fp);
+
+    if (error != 0) {
+        if (linep != (unsigned int *)0) {
+            *linep = number;
+        }
+        free(entries);
+        errno = error;
+    } else {
+        *entriesp = entries;
+        result = count;
+    }
+
+    return result;
+}
+
+const subscription_t * subscription_lookup(const subscription_entry_t * entries, size_t count, const uint16_t address[8], uint16_t port)
+{
+    const subscription_t * result = (const subscription_t *)0;
+    size_t ii = 0;
+
+    for (ii = 0; ii < count; ++ii) {
+        if (memcmp(entries[ii].address, address, sizeof(entries[ii].address)) != 0) {
+            /* Do nothing. */
+        } else if (entries[ii].port == port) {
+            result = &(entries[ii].subscription);
+            break;
+        } else if ((entries[ii].port == 0) && (result == (const subscription_t *)0)) {
+            result = &(entries[ii].subscription);
+        } else {
+            /* Do nothing. */
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,566 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Trace module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "com/diag/hazer/render.h"
+#include "com/diag/hazer/trace.h"
+
+/**
+ * These are the CSV headings of the columns.
+ */
+static const char * const HEADINGS[TRACE_COLUMNS] = {
+    "NAM",
+    "NUM",
+    "FIX",
+    "SYS",
+    "SAT",
+    "CLK",
+    "TIM",
+    "LAT",
+    "LON",
+    "HAC",
+    "MSL",
+    "GEO",
+    "VAC",
+    "SOG",
+    "COG",
+    "ROL",
+    "PIT",
+    "YAW",
+    "RAC",
+    "PAC",
+    "YAC",
+    "OBS",
+    "MAC",
+};
+
+const char * trace_heading(trace_column_t column)
+{
+    return ((0 <= column) && (column < TRACE_COLUMNS)) ? HEADINGS[column] : "";
+}
+
+trace_header_t * trace_header_init(trace_header_t * hp)
+{
+    memset(hp, 0, sizeof(*hp));
+    memcpy(hp->magic, TRACE_MAGIC, sizeof(hp->magic));
+    hp->version = TRACE_VERSION;
+    hp->order = TRACE_ORDER;
+    hp->size = sizeof(trace_record_t);
+    hp->columns = TRACE_COLUMNS;
+
+    return hp;
+}
+
+int trace_header_check(const trace_header_t * hp)
+{
+    int rc = -1;
+
+    if (memcmp(hp->magic, TRACE_MAGIC, sizeof(hp->magic)) != 0) {
+        errno = EINVAL;
+    } else if (hp->order != TRACE_ORDER) {
+        errno = EPROTO;
+    } else if (hp->version != TRACE_VERSION) {
+        errno = EPROTO;
+    } else if (hp->size != sizeof(trace_record_t)) {
+        errno = EPROTO;
+    } else if (hp->columns != TRACE_COLUMNS) {
+        errno = EPROTO;
+    } else {
+        rc = 0;
+    }
+
+    return rc;
+}
+
+const trace_record_t * trace_records(const void * base, size_t length, size_t * countp)
+{
+    const trace_record_t * result = (const trace_record_t *)0;
+
+    if (length < sizeof(trace_header_t)) {
+        errno = ENODATA;
+    } else if (trace_header_check((const trace_header_t *)base) < 0) {
+        /* Do nothing. */
+    } else {
+        *countp = (length - sizeof(trace_header_t)) / sizeof(trace_record_t);
+        result = (const trace_record_t *)((const uint8_t *)base + sizeof(trace_header_t));
+    }
+
+    return result;
+}
+
+double trace_number(int64_t value, int digits)
+{
+    static const double POWERS[TRACE_DIGITS + 1] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+        1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18,
+    };
+
+    return ((0 < digits) && (digits <= TRACE_DIGITS)) ? (value / POWERS[digits]) : value;
+}
+
+trace_record_t * trace_record_init(trace_record_t * rp, const char * name, uint8_t flags)
+{
+    memset(rp, 0, sizeof(*rp));
+
+    strncpy(rp->name, name, sizeof(rp->name));
+    rp->name[sizeof(rp->name) - 1] = '\0';
+    rp->flags = flags;
+
+    /*
+     * These columns are integers, and when missing the CSV has them
+     * as zero, not as "0.".
+     */
+
+    rp->digits[TRACE_NAM] = TRACE_INTEGER;
+    rp->digits[TRACE_NUM] = TRACE_INTEGER;
+    rp->digits[TRACE_FIX] = TRACE_INTEGER;
+    rp->digits[TRACE_SYS] = TRACE_INTEGER;
+    rp->digits[TRACE_SAT] = TRACE_INTEGER;
+    rp->digits[TRACE_OBS] = TRACE_INTEGER;
+
+    return rp;
+}
+
+ssize_t trace_format(const trace_record_t * rp, char * buffer, size_t size)
+{
+    ssize_t rc = -1;
+    char * here = buffer;
+    size_t length = 0;
+    int ii = 0;
+
+    /*
+     * Each column is at most a comma, a space, a sign, nineteen digits,
+     * and a decimal point, so TRACE_LINE is always large enough.
+     */
+
+    length = strnlen(rp->name, sizeof(rp->name));
+
+    if (size < TRACE_LINE) {
+        errno = E2BIG;
+    } else {
+        *(here++) = '"';
+        memcpy(here, rp->name, length);
+        here += length;
+        if ((rp->flags & TRACE_FLAG_MESSAGE) != 0) {
+            *(here++) = '#';
+        }
+        if ((rp->flags & TRACE_FLAG_HANGUP) != 0) {
+            *(here++) = '!';
+        }
+        *(here++) = '"';
+        for (ii = TRACE_NAM + 1; ii < TRACE_COLUMNS; ++ii) {
+            if ((rp->digits[ii] < TRACE_INTEGER) || (rp->digits[ii] > TRACE_DIGITS)) {
+                errno = EINVAL;
+                break;
+            }
+            *(here++) = ',';
+            *(here++) = ' ';
+            if (rp->digits[ii] < 0) {
+                here = render_signed(here, rp->value[ii]);
+            } else {
+                here = render_fixed(here, rp->value[ii], rp->digits[ii]);
+            }
+        }
+        if (ii == TRACE_COLUMNS) {
+            *(here++) = '\n';
+            *here = '\0';
+            rc = here - buffer;
+        }
+    }
+
+    return rc;
+}
+
+/**
+ * Parse a numeric CSV field into a value scaled by ten to the number of
+ * decimal digits the field has.
+ * @param here points to the field.
+ * @param valuep points to where the value is returned.
+ * @param digitsp points to where the digits or TRACE_INTEGER is returned.
+ * @return a pointer past the field or NULL if it is not a number.
+ */
+static const char * trace_parse_number(const char * here, int64_t * valuep, int8_t * digitsp)
+{
+    const char * result = (const char *)0;
+    uint64_t magnitude = 0;
+    int negative = 0;
+    int digits = TRACE_INTEGER;
+    int count = 0;
+
+    while (*here == ' ') {
+        here += 1;
+    }
+
+    if (*here == '-') {
+        negative = !0;
+        here += 1;
+    }
+
+    for (; *here != '\0'; ++here) {
+        if (('0' <= *here) && (*here <= '9')) {
+            if (magnitude > ((INT64_MAX - (*here - '0')) / 10)) {
+                count = -1;
+                break;
+            }
+            magnitude = (magnitude * 10) + (*here - '0');
+            count += 1;
+            if (digits < 0) {
+                /* Do nothing. */
+            } else if (digits < TRACE_DIGITS) {
+                digits += 1;
+            } else {
+                count = -1;
+                break;
+            }
+        } else if ((*here == '.') && (digits < 0)) {
+            digits = 0;
+        } else {
+            break;
+        }
+    }
+
+    if (count < 0) {
+        /* Do nothing. */
+    } else if ((count == 0) && (digits < 0)) {
+        /* Do nothing. */
+    } else {
+        *valuep = negative ? -(int64_t)magnitude : (int64_t)magnitude;
+        *digitsp = digits;
+        result = here;
+    }
+
+    return result;
+}
+
+int trace_parse(trace_record_t * rp, const char * line)
+{
+    int rc = -1;
+    const char * here = line;
+    const char * end = (const char *)0;
+    size_t length = 0;
+    int ii = 0;
+
+    memset(rp, 0, sizeof(*rp));
+    rp->digits[TRACE_NAM] = TRACE_INTEGER;
+
+    do {
+
+        if (*here != '"') {
+            break;
+        }
+        here += 1;
+
+        if ((end = strchr(here, '"')) == (const char *)0) {
+            break;
+        }
+
+        length = end - here;
+        if ((length > 0) && (here[length - 1] == '!')) {
+            rp->flags |= TRACE_FLAG_HANGUP;
+            length -= 1;
+        }
+        if ((length > 0) && (here[length - 1] == '#')) {
+            rp->flags |= TRACE_FLAG_MESSAGE;
+            length -= 1;
+        }
+        if (length >= sizeof(rp->name)) {
+            break;
+        }
+        memcpy(rp->name, here, length);
+        rp->name[length] = '\0';
+        here = end + 1;
+
+        for (ii = TRACE_NAM + 1; ii < TRACE_COLUMNS; ++ii) {
+            if (*here != ',') {
+                break;
+            }
+            here += 1;
+            if ((here = trace_parse_number(here, &(rp->value[ii]), &(rp->digits[ii]))) == (const char *)0) {
+                break;
+            }
+        }
+        if (ii < TRACE_COLUMNS) {
+            break;
+        }
+
+        while ((*here == ' ') || (*here == '\r') || (*here == '\n')) {
+            here += 1;
+        }
+        if (*here != '\0') {
+            break;
+        }
+
+        rc = 0;
+
+    } while (0);
+
+    if (rc < 0) {
+        errno = EINVAL;
+    }
+
+    return rc;
+}
+
+/**
+ * This is a CSV line being assembled from the pieces in which it was read.
+ */
+typedef struct TraceLine {
+    size_t fill;                    /* Octets in the line so far. */
+    int truncated;                  /* Discarding the rest of a long line. */
+    char line[TRACE_LINE];          /* Line being assembled. */
+} trace_line_t;
+
+/*
+ * Terminate the line being assembled, parse it, and call the callback.
+ */
+static int trace_line_call(trace_line_t * lp, trace_callback_t * callback, void * context)
+{
+    trace_record_t record;
+
+    lp->line[lp->fill] = '\0';
+    lp->fill = 0;
+    lp->truncated = 0;
+
+    return (*callback)(context, (trace_parse(&record, lp->line) < 0) ? (const trace_record_t *)0 : &record, lp->line);
+}
+
+/*
+ * Add octets to the line being assembled, calling the callback for every
+ * line that is completed, and carrying a partial line at the end over. A
+ * line too long to be a record keeps its beginning and a newline, which
+ * keeps it from parsing.
+ */
+static int trace_line_carry(trace_line_t * lp, const char * data, size_t length, trace_callback_t * callback, void * context)
+{
+    int rc = 0;
+    const char * here = data;
+    const char * newline = (const char *)0;
+    size_t remaining = length;
+    size_t span = 0;
+
+    while (remaining > 0) {
+
+        newline = (const char *)memchr(here, '\n', remaining);
+        span = (newline == (const char *)0) ? remaining : (newline - here + 1);
+
+        if (lp->truncated) {
+            /* Do nothing. */
+        } else if ((lp->fill + span) < TRACE_LINE) {
+            memcpy(&(lp->line[lp->fill]), here, span);
+            lp->fill += span;
+        } else {
+            if (lp->fill < (TRACE_LINE - 2)) {
+                memcpy(&(lp->line[lp->fill]), here, TRACE_LINE - 2 - lp->fill);
+            }
+            lp->fill = TRACE_LINE - 2;
+            lp->line[lp->fill++] = '\n';
+            lp->truncated = !0;
+        }
+
+        here += span;
+        remaining -= span;
+
+        if (newline == (const char *)0) {
+            break;
+        }
+
+        if ((rc = trace_line_call(lp, callback, context)) != 0) {
+            break;
+        }
+
+    }
+
+    return rc;
+}
+
+/*
+ * Call the callback for a last line that has no newline, giving it one.
+ */
+static int trace_line_flush(trace_line_t * lp, trace_callback_t * callback, void * context)
+{
+    int rc = 0;
+
+    if (lp->fill > 0) {
+        if (lp->truncated) {
+            /* Do nothing. */
+        } else if (lp->fill < (TRACE_LINE - 1)) {
+            lp->line[lp->fill++] = '\n';
+        } else {
+            /* Do nothing. */
+        }
+        rc = trace_line_call(lp, callback, context);
+    }
+
+    return rc;
+}
+
+trace_map_t * trace_map(trace_map_t * mp, int fd)
+{
+    trace_map_t * result = (trace_map_t *)0;
+    struct stat status;
+    void * base = MAP_FAILED;
+    int error = 0;
+
+    memset(mp, 0, sizeof(*mp));
+    mp->kind = TRACE_EMPTY;
+
+    if (fstat(fd, &status) < 0) {
+        /* Do nothing. */
+    } else if (!S_ISREG(status.st_mode)) {
+        errno = ENODEV;
+    } else if (status.st_size == 0) {
+        result = mp;
+    } else if ((base = mmap((void *)0, status.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) == MAP_FAILED) {
+        /* Do nothing. */
+    } else {
+        mp->base = (const char *)base;
+        mp->length = status.st_size;
+        if ((mp->length < sizeof(trace_header_t)) || (memcmp(mp->base, TRACE_MAGIC, sizeof(TRACE_MAGIC) - 1) != 0)) {
+            mp->kind = TRACE_CSV;
+            result = mp;
+        } else if ((mp->records = trace_records(mp->base, mp->length, &(mp->count))) == (const trace_record_t *)0) {
+            error = errno;
+            trace_unmap(mp);
+            errno = error;
+        } else {
+            mp->kind = TRACE_BINARY;
+            result = mp;
+        }
+    }
+
+    return result;
+}
+
+void trace_unmap(trace_map_t * mp)
+{
+    if (mp->base != (const char *)0) {
+        (void)munmap((void *)(mp->base), mp->length);
+    }
+
+    memset(mp, 0, sizeof(*mp));
+    mp->kind = TRACE_EMPTY;
+}
+
+int trace_lines(const char * data, size_t length, trace_callback_t * callback, void * context)
+{
+    int rc = 0;
+    trace_line_t line;
+
+    line.fill = 0;
+    line.truncated = 0;
+
+    if ((rc = trace_line_carry(&line, data, length, callback, context)) == 0) {
+        rc = trace_line_flush(&line, callback, context);
+    }
+
+    return rc;
+}
+
+int trace_mapped(const trace_map_t * mp, trace_callback_t * callback, void * context)
+{
+    int rc = 0;
+    size_t index = 0;
+
+    if (mp->kind == TRACE_BINARY) {
+        for (index = 0; index < mp->count; ++index) {
+            if ((rc = (*callback)(context, &(mp->records[index]), (const char *)0)) != 0) {
+                break;
+            }
+        }
+    } else if (mp->kind == TRACE_CSV) {
+        rc = trace_lines(mp->base, mp->length, callback, context);
+    } else {
+        /* Do nothing. */
+    }
+
+    return rc;
+}
+
+int trace_read(FILE * fp, trace_callback_t * callback, void * context, trace_kind_t * kindp)
+{
+    int rc = 0;
+    size_t length = 0;
+    trace_kind_t kind = TRACE_EMPTY;
+    char buffer[TRACE_LINE];
+    trace_header_t header;
+    trace_record_t record;
+    trace_line_t line;
+
+    /*
+     * A binary trace begins with a header that is shorter than any CSV
+     * line, so the first octets identify the kind of trace; if it is CSV,
+     * they are the beginning of its first line.
+     */
+
+    length = fread(buffer, 1, sizeof(header), fp);
+
+    if (length == 0) {
+        /* Do nothing. */
+    } else if ((length == sizeof(header)) && (memcmp(buffer, TRACE_MAGIC, sizeof(header.magic)) == 0)) {
+        kind = TRACE_BINARY;
+        memcpy(&header, buffer, sizeof(header));
+        if ((rc = trace_header_check(&header)) == 0) {
+            while (fread(&record, sizeof(record), 1, fp) == 1) {
+                if ((rc = (*callback)(context, &record, (const char *)0)) != 0) {
+                    break;
+                }
+            }
+        }
+    } else {
+        kind = TRACE_CSV;
+        line.fill = 0;
+        line.truncated = 0;
+        rc = trace_line_carry(&line, buffer, length, callback, context);
+        while ((rc == 0) && (fgets(buffer, sizeof(buffer), fp) != (char *)0)) {
+            rc = trace_line_carry(&line, buffer, strlen(buffer), callback, context);
+        }
+        if (rc == 0) {
+            rc = trace_line_flush(&line, callback, context);
+        }
+    }
+
+    if ((rc == 0) && ferror(fp)) {
+        if (errno == 0) {
+            errno = EIO;
+        }
+        rc = -1;
+    }
+
+    if (kindp != (trace_kind_t *)0) {
+        *kindp = kind;
+    }
+
+    return rc;
+}
+
+int trace_input(FILE * fp, trace_callback_t * callback, void * context, trace_kind_t * kindp)
+{
+    int rc = 0;
+    trace_map_t map;
+
+    if (trace_map(&map, fileno(fp)) == (trace_map_t *)0) {
+        rc = trace_read(fp, callback, context, kindp);
+    } else {
+        (void)madvise((void *)(map.base), map.length, MADV_SEQUENTIAL);
+        rc = trace_mapped(&map, callback, context);
+        if (kindp != (trace_kind_t *)0) {
+            *kindp = map.kind;
+        }
+        trace_unmap(&map);
+    }
+
+    return rc;
+}
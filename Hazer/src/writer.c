@@ -0,0 +1,395 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the implementation of the Writer module.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include "com/diag/hazer/writer.h"
+#include "com/diag/hazer/common.h"
+
+/**
+ * Ring the doorbell of the writer thread.
+ * @param wp points to the writer.
+ */
+static void writer_ring(writer_t * wp)
+{
+    uint64_t value = 1;
+
+    while ((write(wp->doorbell, &value, sizeof(value)) < 0) && (errno == EINTR)) {
+        /* Do nothing. */
+    }
+}
+
+/**
+ * Hand off the buffer being filled to the writer thread. The caller has
+ * made sure that there is a buffer being filled.
+ * @param wp points to the writer.
+ */
+static void writer_handoff(writer_t * wp)
+{
+    uint64_t depth = 0;
+
+    depth = (wp->head + 1) - __atomic_load_n(&(wp->tail), __ATOMIC_ACQUIRE);
+    if (depth > wp->deepest) {
+        wp->deepest = depth;
+    }
+    wp->handoffs += 1;
+
+    __atomic_store_n(&(wp->head), wp->head + 1, __ATOMIC_RELEASE);
+
+    writer_ring(wp);
+}
+
+/**
+ * Return the buffer being filled, if there is one, which there isn't if
+ * every buffer is waiting to be written.
+ * @param wp points to the writer.
+ * @return a pointer to the buffer or NULL if there is none.
+ */
+static writer_slot_t * writer_filling(writer_t * wp)
+{
+    writer_slot_t * sp = (writer_slot_t *)0;
+
+    if ((wp->head - __atomic_load_n(&(wp->tail), __ATOMIC_ACQUIRE)) < wp->slots) {
+        sp = &(wp->slot[wp->head % wp->slots]);
+    }
+
+    return sp;
+}
+
+/**
+ * Write the buffers handed off to the writer thread until told to stop.
+ * @param argp points to the writer.
+ * @return NULL.
+ */
+static void * writer_run(void * argp)
+{
+    writer_t * wp = (writer_t *)0;
+    writer_slot_t * sp = (writer_slot_t *)0;
+    uint64_t tail = 0;
+    uint64_t value = 0;
+    size_t offset = 0;
+    ssize_t rc = 0;
+    int64_t then = 0;
+    uint64_t elapsed = 0;
+    int fd = -1;
+
+    wp = (writer_t *)argp;
+    fd = fileno(wp->fp);
+    tail = __atomic_load_n(&(wp->tail), __ATOMIC_RELAXED);
+
+    while (!0) {
+
+        /*
+         * The doorbell is a counter, so a hand off that happens after the
+         * ring is found empty still wakes the read. When told to stop, the
+         * head is checked again, since a hand off may have preceded it.
+         */
+
+        if (tail == __atomic_load_n(&(wp->head), __ATOMIC_ACQUIRE)) {
+            if (!__atomic_load_n(&(wp->done), __ATOMIC_ACQUIRE)) {
+                (void)read(wp->doorbell, &value, sizeof(value));
+                continue;
+            } else if (tail == __atomic_load_n(&(wp->head), __ATOMIC_ACQUIRE)) {
+                break;
+            } else {
+                continue;
+            }
+        }
+
+        sp = &(wp->slot[tail % wp->slots]);
+
+        then = common_clock(CLOCK_MONOTONIC);
+
+        for (offset = 0; offset < sp->length; offset += rc) {
+            if ((rc = write(fd, sp->data + offset, sp->length - offset)) > 0) {
+                /* Do nothing. */
+            } else if ((rc < 0) && (errno == EINTR)) {
+                rc = 0;
+            } else {
+                __atomic_store_n(&(wp->error), (rc < 0) ? errno : EIO, __ATOMIC_RELAXED);
+                __atomic_store_n(&(wp->errors), wp->errors + 1, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+
+        elapsed = common_clock(CLOCK_MONOTONIC) - then;
+
+        __atomic_store_n(&(wp->written), wp->written + offset, __ATOMIC_RELAXED);
+        __atomic_store_n(&(wp->stalled), wp->stalled + elapsed, __ATOMIC_RELAXED);
+        if (elapsed > wp->longest) {
+            __atomic_store_n(&(wp->longest), elapsed, __ATOMIC_RELAXED);
+        }
+
+        /*
+         * The buffer is emptied before it is returned to the producer.
+         */
+
+        sp->length = 0;
+        tail += 1;
+        __atomic_store_n(&(wp->tail), tail, __ATOMIC_RELEASE);
+
+    }
+
+    return (void *)0;
+}
+
+writer_t * writer_init(writer_t * wp, FILE * fp, unsigned int slots, size_t size, int64_t latency)
+{
+    writer_t * result = (writer_t *)0;
+    unsigned int ii = 0;
+    sigset_t mask;
+    sigset_t saved;
+    int rc = 0;
+
+    memset(wp, 0, sizeof(*wp));
+    wp->fp = fp;
+    wp->size = size;
+    wp->slots = slots;
+    wp->latency = latency;
+    wp->doorbell = -1;
+
+    if ((slots < 2) || (size == 0) || (latency < 0)) {
+        errno = EINVAL;
+    } else if ((wp->slot = (writer_slot_t *)calloc(slots, sizeof(writer_slot_t))) == (writer_slot_t *)0) {
+        /* Do nothing. */
+    } else if ((wp->storage = (char *)malloc(slots * size)) == (char *)0) {
+        /* Do nothing. */
+    } else if ((wp->doorbell = eventfd(0, EFD_CLOEXEC)) < 0) {
+        /* Do nothing. */
+    } else {
+        for (ii = 0; ii < slots; ++ii) {
+            wp->slot[ii].data = &(wp->storage[ii * size]);
+            wp->slot[ii].length = 0;
+        }
+        /*
+         * The writer thread inherits a mask that blocks every signal, so
+         * that signals are always delivered to some other thread.
+         */
+        sigfillset(&mask);
+        pthread_sigmask(SIG_BLOCK, &mask, &saved);
+        rc = pthread_create(&(wp->thread), (const pthread_attr_t *)0, writer_run, wp);
+        pthread_sigmask(SIG_SETMASK, &saved, (sigset_t *)0);
+        if (rc != 0) {
+            errno = rc;
+        } else {
+            wp->running = !0;
+            result = wp;
+        }
+    }
+
+    if (result == (writer_t *)0) {
+        rc = errno;
+        if (wp->doorbell >= 0) {
+            (void)close(wp->doorbell);
+            wp->doorbell = -1;
+        }
+        free(wp->storage);
+        wp->storage = (char *)0;
+        free(wp->slot);
+        wp->slot = (writer_slot_t *)0;
+        errno = rc;
+    }
+
+    return result;
+}
+
+int writer_fini(writer_t * wp)
+{
+    int rc = 0;
+
+    if (wp->running) {
+        (void)writer_flush(wp);
+        __atomic_store_n(&(wp->done), !0, __ATOMIC_RELEASE);
+        writer_ring(wp);
+        if ((rc = pthread_join(wp->thread, (void **)0)) != 0) {
+            errno = rc;
+            rc = -1;
+        }
+        wp->running = 0;
+    }
+
+    if (wp->doorbell >= 0) {
+        (void)close(wp->doorbell);
+        wp->doorbell = -1;
+    }
+
+    free(wp->storage);
+    wp->storage = (char *)0;
+    free(wp->slot);
+    wp->slot = (writer_slot_t *)0;
+
+    if (rc < 0) {
+        /* Do nothing. */
+    } else if (wp->errors > 0) {
+        errno = wp->error;
+        rc = -1;
+    } else if (wp->dropped > 0) {
+        errno = ENOBUFS;
+        rc = -1;
+    } else {
+        /* Do nothing. */
+    }
+
+    return rc;
+}
+
+ssize_t writer_append(writer_t * wp, const void * data, size_t length)
+{
+    ssize_t rc = -1;
+    writer_slot_t * sp = (writer_slot_t *)0;
+
+    if (!wp->running) {
+        errno = EBADF;
+    } else if (length > wp->size) {
+        errno = EMSGSIZE;
+    } else if ((sp = writer_filling(wp)) == (writer_slot_t *)0) {
+        errno = ENOBUFS;
+    } else if ((sp->length + length) <= wp->size) {
+        rc = length;
+    } else {
+        writer_handoff(wp);
+        if ((sp = writer_filling(wp)) == (writer_slot_t *)0) {
+            errno = ENOBUFS;
+        } else {
+            rc = length;
+        }
+    }
+
+    if (rc < 0) {
+        wp->dropped += length;
+        wp->drops += 1;
+    } else if (length == 0) {
+        /* Do nothing. */
+    } else {
+        if (sp->length == 0) {
+            wp->then = common_clock(CLOCK_MONOTONIC);
+        }
+        memcpy(sp->data + sp->length, data, length);
+        sp->length += length;
+        wp->appended += length;
+        if (sp->length >= wp->size) {
+            writer_handoff(wp);
+        }
+    }
+
+    return rc;
+}
+
+int writer_flush(writer_t * wp)
+{
+    int rc = 0;
+    writer_slot_t * sp = (writer_slot_t *)0;
+
+    if (!wp->running) {
+        errno = EBADF;
+        rc = -1;
+    } else if ((sp = writer_filling(wp)) == (writer_slot_t *)0) {
+        /* Do nothing. */
+    } else if (sp->length == 0) {
+        /* Do nothing. */
+    } else {
+        writer_handoff(wp);
+        rc = 1;
+    }
+
+    return rc;
+}
+
+int writer_service(writer_t * wp)
+{
+    int rc = 0;
+    writer_slot_t * sp = (writer_slot_t *)0;
+
+    if (!wp->running) {
+        errno = EBADF;
+        rc = -1;
+    } else if (wp->latency == 0) {
+        /* Do nothing. */
+    } else if ((sp = writer_filling(wp)) == (writer_slot_t *)0) {
+        /* Do nothing. */
+    } else if (sp->length == 0) {
+        /* Do nothing. */
+    } else if ((common_clock(CLOCK_MONOTONIC) - wp->then) < wp->latency) {
+        /* Do nothing. */
+    } else {
+        writer_handoff(wp);
+        rc = 1;
+    }
+
+    return rc;
+}
+
+unsigned int writer_depth(const writer_t * wp)
+{
+    return __atomic_load_n(&(wp->head), __ATOMIC_ACQUIRE) - __atomic_load_n(&(wp->tail), __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Append what is written to a writer stream.
+ * @param cookie points to the writer.
+ * @param buffer points to the data.
+ * @param size is the length of the data in bytes.
+ * @return the length of the data.
+ */
+static ssize_t writer_cookie_write(void * cookie, const char * buffer, size_t size)
+{
+    (void)writer_append((writer_t *)cookie, buffer, size);
+
+    return size;
+}
+
+/**
+ * Finalize the writer of a writer stream and close its underlying stream.
+ * @param cookie points to the writer.
+ * @return 0 for success, EOF otherwise.
+ */
+static int writer_cookie_close(void * cookie)
+{
+    int rc = 0;
+    writer_t * wp = (writer_t *)0;
+
+    wp = (writer_t *)cookie;
+
+    if (writer_fini(wp) < 0) {
+        rc = EOF;
+    }
+
+    if (fclose(wp->fp) == EOF) {
+        rc = EOF;
+    }
+
+    wp->fp = (FILE *)0;
+
+    return rc;
+}
+
+FILE * writer_stream(writer_t * wp)
+{
+    FILE * fp = (FILE *)0;
+    cookie_io_functions_t functions = {
+        (cookie_read_function_t *)0,
+        writer_cookie_write,
+        (cookie_seek_function_t *)0,
+        writer_cookie_close,
+    };
+
+    if ((fp = fopencookie(wp, "w", functions)) != (FILE *)0) {
+        (void)setvbuf(fp, (char *)0, _IONBF, 0);
+    }
+
+    return fp;
+}
@@ -731,6 +731,52 @@ int yodel_ubx_nav_pvt(yodel_ubx_nav_pvt_t * mp, const void * buffer, ssize_t len
     return rc;
 }
 
+int yodel_ubx_nav_timeutc(yodel_ubx_nav_timeutc_t * mp, const void * buffer, ssize_t length)
+{
+    int rc = -1;
+    const uint8_t * hp = (const uint8_t *)buffer;
+
+    if (hp[YODEL_UBX_CLASS] != YODEL_UBX_NAV_TIMEUTC_Class) {
+        errno = ENOMSG;
+    } else if (hp[YODEL_UBX_ID] != YODEL_UBX_NAV_TIMEUTC_Id) {
+        errno = ENOMSG;
+    } else if (length != (YODEL_UBX_SHORTEST + YODEL_UBX_NAV_TIMEUTC_Length)) {
+        errno = ENODATA;
+    } else {
+        memcpy(mp, &(hp[YODEL_UBX_PAYLOAD]), sizeof(*mp));
+        COM_DIAG_YODEL_LETOH(mp->iTOW);
+        COM_DIAG_YODEL_LETOH(mp->tAcc);
+        COM_DIAG_YODEL_LETOH(mp->nano);
+        COM_DIAG_YODEL_LETOH(mp->year);
+        rc = 0;
+    }
+
+    return rc;
+}
+
+int yodel_ubx_tim_tp(yodel_ubx_tim_tp_t * mp, const void * buffer, ssize_t length)
+{
+    int rc = -1;
+    const uint8_t * hp = (const uint8_t *)buffer;
+
+    if (hp[YODEL_UBX_CLASS] != YODEL_UBX_TIM_TP_Class) {
+        errno = ENOMSG;
+    } else if (hp[YODEL_UBX_ID] != YODEL_UBX_TIM_TP_Id) {
+        errno = ENOMSG;
+    } else if (length != (YODEL_UBX_SHORTEST + YODEL_UBX_TIM_TP_Length)) {
+        errno = ENODATA;
+    } else {
+        memcpy(mp, &(hp[YODEL_UBX_PAYLOAD]), sizeof(*mp));
+        COM_DIAG_YODEL_LETOH(mp->towMS);
+        COM_DIAG_YODEL_LETOH(mp->towSubMS);
+        COM_DIAG_YODEL_LETOH(mp->qErr);
+        COM_DIAG_YODEL_LETOH(mp->week);
+        rc = 0;
+    }
+
+    return rc;
+}
+
 /*******************************************************************************
  *
  ******************************************************************************/
@@ -0,0 +1,235 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Archive unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include "com/diag/hazer/archive.h"
+
+enum {
+    COUNT = 10000,
+    ROWS = 1000,
+};
+
+static trace_record_t records[COUNT];
+static trace_record_t decoded[ROWS];
+static int64_t values[ROWS];
+static int8_t digits[ROWS];
+
+static uint32_t seed = 1;
+
+static int32_t noise(void)
+{
+    seed = (seed * 1103515245UL) + 12345UL;
+    return (int32_t)((seed >> 16) & 0x7fff) - 0x4000;
+}
+
+int main(void)
+{
+    char * buffer = (char *)0;
+    size_t length = 0;
+
+    {
+        assert(sizeof(archive_header_t) % ARCHIVE_ALIGN == 0);
+        assert(sizeof(archive_zone_t) == 32);
+        assert(sizeof(archive_chunk_t) % ARCHIVE_ALIGN == 0);
+    }
+
+    {
+        static char zero[sizeof(archive_chunk_t)];
+
+        errno = 0;
+        assert(archive_check(zero, sizeof(archive_header_t) - 1) == (const archive_header_t *)0);
+        assert(errno == ENODATA);
+        errno = 0;
+        assert(archive_check(zero, sizeof(zero)) == (const archive_header_t *)0);
+        assert(errno == EINVAL);
+    }
+
+    {
+        int64_t clk = 1599145249632000060LL;
+        int64_t lat = 397943071;
+        int64_t lon = -1051533805;
+        size_t ii = 0;
+
+        /*
+         * Records from three hosts, with a hangup now and then, a clock and
+         * position that change slowly, a column whose digits vary, and a
+         * column whose values are as far apart as they can be.
+         */
+
+        for (ii = 0; ii < COUNT; ++ii) {
+            trace_record_init(&(records[ii]), (ii < 2500) ? "neon" : (ii < 7777) ? "tin" : "a-host-name-that-is-sixty-three-characters-long-which-is-largst", ((ii % 1001) == 0) ? TRACE_FLAG_HANGUP : 0);
+            clk += 1000000000LL + noise();
+            lat += noise() / 256;
+            lon += noise() / 256;
+            trace_record_set(&(records[ii]), TRACE_NUM, ii + 2, TRACE_INTEGER);
+            trace_record_set(&(records[ii]), TRACE_FIX, ((ii % 13) == 0) ? 2 : 3, TRACE_INTEGER);
+            trace_record_set(&(records[ii]), TRACE_SAT, 12 + (noise() % 4), TRACE_INTEGER);
+            trace_record_set(&(records[ii]), TRACE_CLK, clk, 9);
+            trace_record_set(&(records[ii]), TRACE_TIM, (clk / 1000000000LL) * 1000000000LL, 9);
+            trace_record_set(&(records[ii]), TRACE_LAT, lat, 7);
+            trace_record_set(&(records[ii]), TRACE_LON, lon, 7);
+            trace_record_set(&(records[ii]), TRACE_HAC, ((ii % 7) == 0) ? 0 : 1234 + noise(), ((ii % 7) == 0) ? 0 : 3);
+            trace_record_set(&(records[ii]), TRACE_MSL, 17001234 + noise(), 4);
+            trace_record_set(&(records[ii]), TRACE_MAC, ((ii % 2) == 0) ? INT64_MIN : INT64_MAX, 0);
+        }
+    }
+
+    {
+        archive_t archive;
+        FILE * fp = (FILE *)0;
+        size_t ii = 0;
+
+        assert((fp = open_memstream(&buffer, &length)) != (FILE *)0);
+        errno = 0;
+        assert(archive_init(&archive, fp, ARCHIVE_LIMIT + 1) == (archive_t *)0);
+        assert(errno == EINVAL);
+        assert(archive_init(&archive, fp, ROWS) == &archive);
+        for (ii = 0; ii < COUNT; ++ii) {
+            assert(archive_write(&archive, &(records[ii])) == 0);
+        }
+        assert(archive_fini(&archive) == 0);
+        assert(archive.records == COUNT);
+        assert(archive.chunks == (COUNT / ROWS));
+        assert(fclose(fp) == 0);
+        assert(archive.bytes == length);
+        fprintf(stderr, "%s: records=%zu bytes=%zu trace=%zu\n", __FILE__, (size_t)COUNT, length, sizeof(trace_header_t) + (COUNT * sizeof(trace_record_t)));
+        assert(length < ((COUNT * sizeof(trace_record_t)) / 4));
+    }
+
+    {
+        const archive_header_t * hp = (const archive_header_t *)0;
+        const archive_chunk_t * cp = (const archive_chunk_t *)0;
+        uint64_t offset = 0;
+        size_t chunks = 0;
+        size_t index = 0;
+        size_t ii = 0;
+        int jj = 0;
+        double number = 0.0;
+
+        assert((hp = archive_check(buffer, length)) != (const archive_header_t *)0);
+        assert(hp->rows == ROWS);
+
+        while ((cp = archive_next(buffer, length, &offset)) != (const archive_chunk_t *)0) {
+            assert(((const char *)cp - buffer) % ARCHIVE_ALIGN == 0);
+            assert(cp->rows == ROWS);
+            assert(archive_records(cp, decoded) == ROWS);
+            assert(memcmp(decoded, &(records[index]), ROWS * sizeof(decoded[0])) == 0);
+            for (jj = TRACE_NAM + 1; jj < TRACE_COLUMNS; ++jj) {
+                assert(archive_column(cp, jj, values, digits) == ROWS);
+                for (ii = 0; ii < ROWS; ++ii) {
+                    assert(values[ii] == records[index + ii].value[jj]);
+                    assert(digits[ii] == records[index + ii].digits[jj]);
+                    number = trace_number(values[ii], digits[ii]);
+                    assert(cp->zone[jj].minimum <= number);
+                    assert(number <= cp->zone[jj].maximum);
+                }
+            }
+            assert(cp->zone[TRACE_CLK].encoding == ARCHIVE_DELTA);
+            assert(cp->zone[TRACE_LAT].encoding == ARCHIVE_DELTA);
+            assert(cp->zone[TRACE_FIX].encoding == ARCHIVE_VARINT);
+            assert(cp->zone[TRACE_CLK].digits == 9);
+            assert(cp->zone[TRACE_HAC].digits == ARCHIVE_MIXED);
+            assert(cp->zone[TRACE_FIX].minimum == 2.0);
+            assert(cp->zone[TRACE_FIX].maximum == 3.0);
+            assert(cp->zone[TRACE_NUM].minimum == (index + 2));
+            assert(cp->zone[TRACE_NUM].maximum == (index + ROWS + 1));
+            assert(cp->zone[ARCHIVE_FLG].maximum == TRACE_FLAG_HANGUP);
+            assert(archive_overlaps(cp, TRACE_NUM, index + 2, index + 2));
+            assert(!archive_overlaps(cp, TRACE_NUM, index + ROWS + 2, 1e9));
+            assert(!archive_overlaps(cp, TRACE_FIX, 4.0, 1e9));
+            errno = 0;
+            assert(archive_column(cp, TRACE_NAM, values, digits) < 0);
+            assert(errno == EINVAL);
+            errno = 0;
+            assert(archive_column(cp, ARCHIVE_COLUMNS, values, digits) < 0);
+            assert(errno == EINVAL);
+            index += cp->rows;
+            chunks += 1;
+        }
+        assert(chunks == (COUNT / ROWS));
+        assert(index == COUNT);
+        assert(offset == length);
+    }
+
+    {
+        char * twice = (char *)0;
+        const archive_chunk_t * cp = (const archive_chunk_t *)0;
+        uint64_t offset = 0;
+        size_t chunks = 0;
+
+        /*
+         * Concatenated archives are one archive, and a partial chunk at
+         * the end is ignored.
+         */
+
+        assert((twice = (char *)malloc(length * 2)) != (char *)0);
+        memcpy(twice, buffer, length);
+        memcpy(twice + length, buffer, length);
+        while ((cp = archive_next(twice, (length * 2) - 1, &offset)) != (const archive_chunk_t *)0) {
+            assert(archive_records(cp, decoded) == ROWS);
+            assert(memcmp(decoded, &(records[(chunks * ROWS) % COUNT]), ROWS * sizeof(decoded[0])) == 0);
+            chunks += 1;
+        }
+        assert(chunks == (((COUNT / ROWS) * 2) - 1));
+        free(twice);
+    }
+
+    {
+        archive_chunk_t * cp = (archive_chunk_t *)0;
+        uint64_t offset = 0;
+        uint32_t saved = 0;
+
+        /*
+         * Data that isn't within its chunk is rejected.
+         */
+
+        assert((cp = (archive_chunk_t *)archive_next(buffer, length, &offset)) != (archive_chunk_t *)0);
+        saved = cp->zone[TRACE_LAT].length;
+        cp->zone[TRACE_LAT].length = cp->length;
+        errno = 0;
+        assert(archive_column(cp, TRACE_LAT, values, digits) < 0);
+        assert(errno == EILSEQ);
+        cp->zone[TRACE_LAT].length = 1;
+        errno = 0;
+        assert(archive_column(cp, TRACE_LAT, values, digits) < 0);
+        assert(errno == EILSEQ);
+        cp->zone[TRACE_LAT].length = saved;
+        saved = cp->zone[TRACE_NAM].length;
+        cp->zone[TRACE_NAM].length = 2;
+        errno = 0;
+        assert(archive_records(cp, decoded) < 0);
+        assert(errno == EILSEQ);
+        cp->zone[TRACE_NAM].length = saved;
+        assert(archive_records(cp, decoded) == ROWS);
+        cp->length += 1;
+        offset = 0;
+        assert(archive_next(buffer, length, &offset) == (const archive_chunk_t *)0);
+        cp->length -= 1;
+
+        offset = sizeof(archive_header_t);
+        buffer[0] = 'X';
+        assert(archive_next(buffer, length, &offset) == cp);
+        offset = 0;
+        errno = 0;
+        assert(archive_next(buffer, length, &offset) == (const archive_chunk_t *)0);
+        assert(errno == EINVAL);
+    }
+
+    free(buffer);
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
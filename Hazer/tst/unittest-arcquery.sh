@@ -0,0 +1,141 @@
+#!/bin/bash
+# Copyright 2024 Digital Aggregates Corporation, Colorado, USA
+# Licensed under the terms in LICENSE.txt
+# Chip Overclock <coverclock@diag.com>
+# https://github.com/coverclock/com-diag-hazer
+
+XC=0
+
+HEADINGS="NAM, NUM, FIX, SYS, SAT, CLK, TIM, LAT, LON, HAC, MSL, GEO, VAC, SOG, COG, ROL, PIT, YAW, RAC, PAC, YAC, OBS, MAC"
+
+CSV=$(mktemp)
+ARC=$(mktemp)
+OUTPUT=$(mktemp)
+ERROR=$(mktemp)
+
+# A week of records from two hosts, thirty seconds apart, in twenty
+# chunks. Only the records in one chunk have a HAC greater than one.
+
+echo "${HEADINGS}" > ${CSV}
+awk 'BEGIN {
+    for (ii = 0; ii < 20000; ++ii) {
+        printf("\"%s\", %d, %d, %d, %d, %d.000000000, %d.000000000, 39.79%05d, -105.15%05d, %s, 1710.%03d, 1688.800, 0., 0.005000, 0., 0., 0., 0., 0., 0., 0., 0, 0.\n", ((int(ii / 500) % 2) == 0) ? "neon" : "tin", ii, ((ii % 10) == 0) ? 2 : 3, ii % 3, 6 + (ii % 7), 1599091200 + (ii * 30), 1599091200 + (ii * 30), ii % 1000, ii % 2000, ((ii >= 12000) && (ii < 13000)) ? "2.500" : "0.500", ii % 1000);
+    }
+}' >> ${CSV}
+csv2arc -n 1000 < ${CSV} > ${ARC}
+
+echo "**********"
+echo "FILTER"
+echo "**********"
+arcquery -v -w 'HAC>1' ${ARC} > ${OUTPUT} 2> ${ERROR}
+cat ${ERROR}
+if [[ "$(tail -n +2 ${OUTPUT})" != "$(awk -F', ' '/^"/ && ($10 > 1)' ${CSV})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ -z "$(grep 'chunks 20 skipped 19 records 20000 selected 1000 ' ${ERROR})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "RANGE"
+echo "**********"
+arcquery -v -w 'NUM>=4321' -w 'NUM<4567' -w 'NAM=tin' -w 'FIX=3' < ${ARC} > ${OUTPUT} 2> ${ERROR}
+cat ${ERROR}
+if [[ "$(tail -n +2 ${OUTPUT})" != "$(awk -F', ' '/^"tin"/ && ($2 >= 4321) && ($2 < 4567) && ($3 == 3)' ${CSV})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ -z "$(grep 'chunks 20 skipped 19 ' ${ERROR})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "AGGREGATE"
+echo "**********"
+EXPECTED="COUNT, SUM(SAT), MIN(LAT), MAX(LAT), AVG(HAC)
+18000, 161996.000000000, 39.790000100, 39.790099900, 0.600000000"
+ACTUAL="$(arcquery -w 'FIX>=3' -a COUNT -a SUM:SAT -a MIN:LAT -a MAX:LAT -a AVG:HAC ${ARC})"
+echo "${ACTUAL}"
+if [[ "${ACTUAL}" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "GROUP"
+echo "**********"
+EXPECTED="$(awk -F', ' '
+BEGIN {
+    for (ii = 0; ii < 7; ++ii) { DATE[18508 + ii] = sprintf("2020-09-%02d", 3 + ii); }
+    print "SYS, DAY, AVG(SAT), COUNT";
+}
+/^"/ && ($3 >= 3) {
+    key = sprintf("%d, %s", $4, DATE[int($7 / 86400)]);
+    count[key] += 1;
+    sum[key] += $5;
+}
+END {
+    for (key in count) { printf("%s, %.9f, %d\n", key, sum[key] / count[key], count[key]) | "sort"; }
+}' ${CSV})"
+ACTUAL="$(cat ${ARC} | arcquery -w 'FIX>=3' -g SYS -g DAY -a AVG:SAT -a COUNT)"
+echo "${ACTUAL}"
+if [[ "${ACTUAL}" != "${EXPECTED}" ]]; then
+    echo "${EXPECTED}"
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+EXPECTED="NAM, COUNT
+\"neon\", 10000
+\"tin\", 10000"
+ACTUAL="$(arcquery -g NAM ${ARC})"
+echo "${ACTUAL}"
+if [[ "${ACTUAL}" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "FILES"
+echo "**********"
+ACTUAL="$(arcquery -a COUNT ${ARC} ${ARC})"
+echo "${ACTUAL}"
+if [[ "${ACTUAL}" != "$(echo -e "COUNT\n40000")" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "INDEX"
+echo "**********"
+arcquery -i ${ARC} > ${OUTPUT}
+head -25 ${OUTPUT}
+if [[ "$(grep -c '^CHUNK ' ${OUTPUT})" != "20" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ -z "$(grep -E "^    NUM DELTA -1 [0-9]+ 12000.000000000 12999.000000000$" ${OUTPUT})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "INVALID"
+echo "**********"
+for QUERY in "-w HAC" "-w HAC>" "-w HAC!1" "-w NAM<tin" "-w XYZ=1" "-a AVG" "-a AVG:NAM" "-a MEDIAN:SAT" "-g DAYS"; do
+    if arcquery ${QUERY} ${ARC} > /dev/null 2>&1; then
+        echo "${QUERY}"
+        echo "FAILED!" 1>&2
+        XC=1
+    fi
+done
+if arcquery < ${CSV} > /dev/null 2>&1; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+rm -f ${CSV} ${ARC} ${OUTPUT} ${ERROR}
+
+exit ${XC}
@@ -0,0 +1,330 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Capture unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "com/diag/hazer/capture.h"
+
+static const char NMEA[] = "$GNGGA,135627.00,3947.65338,N,10509.20216,W,2,12,0.67,1708.6,M,-21.5,M,,0000*4E\r\n";
+static const unsigned char UBXNAVPVT[] = { 0xb5, 0x62, 0x01, 0x07, 0x00, 0x00, 0x08, 0x19 };
+static const unsigned char UBXNAVHPPOSLLH[] = { 0xb5, 0x62, 0x01, 0x14, 0x00, 0x00, 0x15, 0x40 };
+static const unsigned char RTCM1005[] = { 0xd3, 0x00, 0x13, 0x3e, 0xd0, 0x00, 0x03 };
+static const unsigned char CPO[] = { 0x10, 0x72, 0x00, 0x10, 0x03 };
+
+static const unsigned char * const MESSAGE[] = { (const unsigned char *)NMEA, UBXNAVPVT, UBXNAVHPPOSLLH, RTCM1005, CPO, };
+static const size_t LENGTH[] = { sizeof(NMEA) - 1, sizeof(UBXNAVPVT), sizeof(UBXNAVHPPOSLLH), sizeof(RTCM1005), sizeof(CPO), };
+static const capture_protocol_t PROTOCOL[] = { CAPTURE_NMEA, CAPTURE_UBX, CAPTURE_UBX, CAPTURE_RTCM, CAPTURE_CPO, };
+
+int main(void)
+{
+    static char buffer[1 << 20];
+
+    {
+        assert(sizeof(capture_header_t) % CAPTURE_ALIGN == 0);
+        assert(sizeof(capture_record_t) % CAPTURE_ALIGN == 0);
+        assert(sizeof(capture_index_t) % CAPTURE_ALIGN == 0);
+        assert(sizeof(capture_count_t) == 8);
+        assert(sizeof(capture_trailer_t) % CAPTURE_ALIGN == 0);
+    }
+
+    {
+        assert(capture_key(CAPTURE_NMEA, NMEA, sizeof(NMEA) - 1) == CAPTURE_KEY(CAPTURE_NMEA, ('G' << 16) | ('G' << 8) | 'A'));
+        assert(capture_key(CAPTURE_NMEA, "$PUBX,00*33\r\n", 13) == CAPTURE_KEY(CAPTURE_NMEA, ('U' << 16) | ('B' << 8) | 'X'));
+        assert(capture_key(CAPTURE_NMEA, "$GGA", 4) == CAPTURE_KEY(CAPTURE_NMEA, 0));
+        assert(capture_key(CAPTURE_UBX, UBXNAVPVT, sizeof(UBXNAVPVT)) == CAPTURE_KEY(CAPTURE_UBX, 0x0107));
+        assert(capture_key(CAPTURE_UBX, UBXNAVPVT, 3) == CAPTURE_KEY(CAPTURE_UBX, 0));
+        assert(capture_key(CAPTURE_RTCM, RTCM1005, sizeof(RTCM1005)) == CAPTURE_KEY(CAPTURE_RTCM, 1005));
+        assert(capture_key(CAPTURE_CPO, CPO, sizeof(CPO)) == CAPTURE_KEY(CAPTURE_CPO, 0x72));
+        assert(capture_key(CAPTURE_OTHER, CPO, sizeof(CPO)) == CAPTURE_KEY(CAPTURE_OTHER, 0));
+        assert(strcmp(capture_name(CAPTURE_UBX), "UBX") == 0);
+        assert(strcmp(capture_name((capture_protocol_t)99), "OTHER") == 0);
+    }
+
+    {
+        capture_t capture;
+        FILE * fp = (FILE *)0;
+
+        assert((fp = fmemopen(buffer, sizeof(buffer), "w")) != (FILE *)0);
+        errno = 0;
+        assert(capture_init(&capture, fp, 0) == (capture_t *)0);
+        assert(errno == EINVAL);
+        assert(fclose(fp) == 0);
+
+        errno = 0;
+        assert(capture_check(buffer, sizeof(capture_header_t) - 1) == (const capture_header_t *)0);
+        assert(errno == ENODATA);
+        memset(buffer, 0, sizeof(buffer));
+        errno = 0;
+        assert(capture_check(buffer, sizeof(buffer)) == (const capture_header_t *)0);
+        assert(errno == EINVAL);
+    }
+
+    {
+        capture_t capture;
+        FILE * fp = (FILE *)0;
+        size_t length = 0;
+        uint64_t offset = 0;
+        uint64_t skipped = 0;
+        uint64_t records = 0;
+        uint64_t blocks = 0;
+        uint64_t pvts = 0;
+        uint64_t rtcms = 0;
+        const capture_header_t * hp = (const capture_header_t *)0;
+        const capture_count_t * counts = (const capture_count_t *)0;
+        const void * data = (const void *)0;
+        capture_record_t record;
+        capture_index_t index;
+        int64_t stamp = 0;
+        int64_t before = 0;
+        int ii = 0;
+
+        /*
+         * A burst of messages every second for a hundred seconds, where
+         * RTCM is only received during the last ten, in blocks of ten
+         * seconds.
+         */
+
+        assert((fp = fmemopen(buffer, sizeof(buffer), "w")) != (FILE *)0);
+        before = capture_now();
+        assert(capture_init(&capture, fp, 10000000000LL) == &capture);
+
+        for (ii = 0; ii < 500; ++ii) {
+            stamp = 1000000000LL + ((ii / 5) * 1000000000LL) + (ii % 5);
+            if (((ii % 5) == 3) && (ii < 450)) {
+                continue;
+            }
+            assert(capture_write(&capture, stamp, PROTOCOL[ii % 5], MESSAGE[ii % 5], LENGTH[ii % 5]) == LENGTH[ii % 5]);
+        }
+
+        assert(capture.records == 410);
+        assert(capture_fini(&capture) == 0);
+        length = capture.offset;
+        assert(fclose(fp) == 0);
+        assert((length % CAPTURE_ALIGN) == 0);
+
+        assert((hp = capture_check(buffer, length)) == (const capture_header_t *)buffer);
+        assert(hp->monotonic >= before);
+        assert(hp->realtime > 0);
+
+        /*
+         * Reading from the beginning sees every message, each index, and
+         * the trailer at the end.
+         */
+
+        offset = sizeof(capture_header_t);
+        ii = 0;
+        while ((data = capture_next(buffer, length, &offset, &record)) != (const void *)0) {
+            if ((record.key & CAPTURE_PROTOCOL) == CAPTURE_KEY(CAPTURE_INDEX, 0)) {
+                blocks += 1;
+                continue;
+            }
+            if ((record.key & CAPTURE_PROTOCOL) == CAPTURE_KEY(CAPTURE_TRAILER, 0)) {
+                assert(offset == length);
+                continue;
+            }
+            if (((ii % 5) == 3) && (ii < 450)) {
+                ii += 1;
+            }
+            assert(record.length == LENGTH[ii % 5]);
+            assert(memcmp(data, MESSAGE[ii % 5], record.length) == 0);
+            assert(record.key == capture_key(PROTOCOL[ii % 5], MESSAGE[ii % 5], LENGTH[ii % 5]));
+            records += 1;
+            ii += 1;
+        }
+        assert(records == 410);
+        assert(blocks == 10);
+        assert(offset == length);
+
+        /*
+         * A partial record at the end is ignored.
+         */
+
+        offset = length - 8;
+        assert(capture_next(buffer, length - 1, &offset, &record) == (const void *)0);
+        assert(offset == (length - 8));
+
+        /*
+         * The indices walk back from the trailer.
+         */
+
+        records = 0;
+        blocks = 0;
+        offset = capture_last(buffer, length);
+        assert(offset > 0);
+        while (offset > 0) {
+            assert((counts = capture_index(buffer, length, offset, &index)) != (const capture_count_t *)0);
+            assert(index.offset < offset);
+            assert(index.first <= index.last);
+            assert((index.last - index.first) < 10000000000LL);
+            records += index.records;
+            pvts += capture_count(&index, counts, CAPTURE_KEY(CAPTURE_UBX, 0x0107), ~0);
+            rtcms += capture_count(&index, counts, CAPTURE_KEY(CAPTURE_RTCM, 0), CAPTURE_PROTOCOL);
+            assert(capture_count(&index, counts, 0, 0) == index.records);
+            blocks += 1;
+            offset = index.previous;
+        }
+        assert(records == 410);
+        assert(blocks == 10);
+        assert(pvts == 100);
+        assert(rtcms == 10);
+
+        assert(capture_last(buffer, length - 8) == 0);
+        assert(capture_index(buffer, length, sizeof(capture_header_t), &index) == (const capture_count_t *)0);
+
+        /*
+         * Seeking to a time skips the blocks that end before it.
+         */
+
+        offset = capture_seek(buffer, length, 0, 0, 0, &skipped);
+        assert(offset == sizeof(capture_header_t));
+        assert(skipped == 0);
+
+        offset = capture_seek(buffer, length, 55000000000LL, 0, 0, &skipped);
+        assert(skipped == 200);
+        assert(capture_next(buffer, length, &offset, &record) != (const void *)0);
+        assert(record.stamp == 51000000000LL);
+
+        offset = capture_seek(buffer, length, 200000000000LL, 0, 0, &skipped);
+        assert(offset == length);
+        assert(skipped == 410);
+
+        /*
+         * Seeking to a protocol skips the blocks that don't have it.
+         */
+
+        offset = capture_seek(buffer, length, 0, CAPTURE_KEY(CAPTURE_RTCM, 0), CAPTURE_PROTOCOL, &skipped);
+        assert(skipped == 360);
+        while ((data = capture_next(buffer, length, &offset, &record)) != (const void *)0) {
+            if ((record.key & CAPTURE_PROTOCOL) == CAPTURE_KEY(CAPTURE_RTCM, 0)) {
+                break;
+            }
+        }
+        assert(data != (const void *)0);
+        assert(record.key == CAPTURE_KEY(CAPTURE_RTCM, 1005));
+        assert(record.stamp == 91000000003LL);
+
+        offset = capture_seek(buffer, length, 0, CAPTURE_KEY(CAPTURE_UBX, 0x0107), ~0, &skipped);
+        assert(offset == sizeof(capture_header_t));
+        assert(skipped == 0);
+
+        offset = capture_seek(buffer, length, 0, CAPTURE_KEY(CAPTURE_UBX, 0x0a04), ~0, &skipped);
+        assert(offset == length);
+        assert(skipped == 410);
+
+        /*
+         * Without a trailer, because the writer didn't finish, seeking
+         * starts at the beginning.
+         */
+
+        offset = capture_seek(buffer, length - 8, 55000000000LL, 0, 0, &skipped);
+        assert(offset == sizeof(capture_header_t));
+        assert(skipped == 0);
+    }
+
+    {
+        capture_t capture;
+        FILE * fp = (FILE *)0;
+        size_t length = 0;
+        uint64_t offset = 0;
+        const capture_count_t * counts = (const capture_count_t *)0;
+        capture_index_t index;
+        uint32_t type = 0;
+        uint64_t skipped = 0;
+
+        /*
+         * A block with more types than fit in its index counts the rest
+         * under the overflow, which matches any key.
+         */
+
+        assert((fp = fmemopen(buffer, sizeof(buffer), "w")) != (FILE *)0);
+        assert(capture_init(&capture, fp, CAPTURE_INTERVAL) == &capture);
+        for (type = 0; type < 100; ++type) {
+            unsigned char message[] = { 0xb5, 0x62, 0x01, (unsigned char)type, 0x00, 0x00, 0x00, 0x00 };
+            assert(capture_write(&capture, type, CAPTURE_UBX, message, sizeof(message)) == sizeof(message));
+        }
+        assert(capture_fini(&capture) == 0);
+        length = capture.offset;
+        assert(fclose(fp) == 0);
+
+        offset = capture_last(buffer, length);
+        assert((counts = capture_index(buffer, length, offset, &index)) != (const capture_count_t *)0);
+        assert(index.records == 100);
+        assert(index.types == CAPTURE_TYPES);
+        assert(counts[CAPTURE_TYPES - 1].key == CAPTURE_OVERFLOW);
+        assert(counts[CAPTURE_TYPES - 1].count == (100 - (CAPTURE_TYPES - 1)));
+        assert(capture_count(&index, counts, CAPTURE_KEY(CAPTURE_UBX, 0x0101), ~0) == (1 + (100 - (CAPTURE_TYPES - 1))));
+        assert(capture_count(&index, counts, CAPTURE_KEY(CAPTURE_RTCM, 0), CAPTURE_PROTOCOL) == (100 - (CAPTURE_TYPES - 1)));
+        assert(capture_seek(buffer, length, 0, CAPTURE_KEY(CAPTURE_RTCM, 0), CAPTURE_PROTOCOL, &skipped) == sizeof(capture_header_t));
+        assert(skipped == 0);
+    }
+
+    {
+        capture_image_t image;
+        FILE * fp = (FILE *)0;
+        int pipes[2] = { -1, -1, };
+        pid_t pid = -1;
+        int status = -1;
+        static char DATA[200000];
+        size_t ii = 0;
+
+        /*
+         * A file is mapped, and a pipe is read into memory that has to grow
+         * more than once to hold it.
+         */
+
+        for (ii = 0; ii < sizeof(DATA); ++ii) {
+            DATA[ii] = ii % 251;
+        }
+
+        assert((fp = tmpfile()) != (FILE *)0);
+        assert(capture_load(&image, fp, MADV_RANDOM) == &image);
+        assert(!image.mapped);
+        assert(image.length == 0);
+        capture_unload(&image);
+        assert(fwrite(DATA, sizeof(DATA), 1, fp) == 1);
+        assert(fflush(fp) == 0);
+        assert(capture_load(&image, fp, MADV_RANDOM) == &image);
+        assert(image.mapped);
+        assert(image.length == sizeof(DATA));
+        assert(memcmp(image.base, DATA, sizeof(DATA)) == 0);
+        capture_unload(&image);
+        assert(image.base == (void *)0);
+        assert(fclose(fp) == 0);
+
+        assert(pipe(pipes) == 0);
+        assert((pid = fork()) >= 0);
+        if (pid == 0) {
+            (void)close(pipes[0]);
+            assert(write(pipes[1], DATA, sizeof(DATA)) == sizeof(DATA));
+            _exit(0);
+        }
+        (void)close(pipes[1]);
+        assert((fp = fdopen(pipes[0], "r")) != (FILE *)0);
+        assert(capture_load(&image, fp, MADV_RANDOM) == &image);
+        assert(!image.mapped);
+        assert(image.length == sizeof(DATA));
+        assert(memcmp(image.base, DATA, sizeof(DATA)) == 0);
+        capture_unload(&image);
+        assert(fclose(fp) == 0);
+        assert(waitpid(pid, &status, 0) == pid);
+        assert(WIFEXITED(status) && (WEXITSTATUS(status) == 0));
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
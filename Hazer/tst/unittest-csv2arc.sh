@@ -0,0 +1,83 @@
+#!/bin/bash
+# Copyright 2024 Digital Aggregates Corporation, Colorado, USA
+# Licensed under the terms in LICENSE.txt
+# Chip Overclock <coverclock@diag.com>
+# https://github.com/coverclock/com-diag-hazer
+
+XC=0
+
+HEADINGS="NAM, NUM, FIX, SYS, SAT, CLK, TIM, LAT, LON, HAC, MSL, GEO, VAC, SOG, COG, ROL, PIT, YAW, RAC, PAC, YAC, OBS, MAC"
+
+CSV=$(mktemp)
+TRC=$(mktemp)
+ARC=$(mktemp)
+OUTPUT=$(mktemp)
+
+echo "${HEADINGS}" > ${CSV}
+awk 'BEGIN {
+    for (ii = 0; ii < 5000; ++ii) {
+        printf("\"%s%s\", %d, %d, 0, %d, %d.%03d000000, %d.000000000, 39.79%05d, -105.15%05d, %s, 1710.%03d, 1688.800, 0., 0.005000, 0., 0., 0., 0., 0., 0., 0., 0, 0.\n", (ii < 3000) ? "neon" : "tin", ((ii % 777) == 0) ? "!" : "", ii, ((ii % 10) == 0) ? 2 : 3, 8 + (ii % 5), 1599145249 + int(ii / 20), (ii % 20) * 50, 1599145249 + int(ii / 20), ii % 1000, ii % 2000, ((ii % 3) == 0) ? "0." : sprintf("%d.%03d", ii % 4, ii % 1000), ii % 1000);
+    }
+}' >> ${CSV}
+csv2trc < ${CSV} > ${TRC}
+
+echo "**********"
+echo "ROUNDTRIP"
+echo "**********"
+cat ${CSV} | csv2arc -n 1000 | csv2arc -r > ${OUTPUT}
+if ! cmp ${CSV} ${OUTPUT}; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "MAPPED"
+echo "**********"
+csv2arc -v < ${CSV} > ${ARC}
+csv2arc -v -r < ${ARC} > ${OUTPUT}
+ls -l ${CSV} ${TRC} ${ARC}
+if ! cmp ${CSV} ${OUTPUT}; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ $(stat -c %s ${ARC}) -ge $(($(stat -c %s ${CSV}) / 4)) ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "TRACE"
+echo "**********"
+if ! csv2arc < ${TRC} | cmp ${ARC} -; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if ! cat ${TRC} | csv2arc | cmp ${ARC} -; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "CONCATENATED"
+echo "**********"
+(head -3001 ${CSV} | csv2arc; echo "${HEADINGS}" | csv2arc; tail -n +3002 ${CSV} | csv2arc -n 100) > ${OUTPUT}
+if [[ "$(csv2arc -r < ${OUTPUT})" != "$(cat ${CSV})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "INVALID"
+echo "**********"
+if csv2arc -r < ${CSV} > /dev/null 2>&1; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if csv2arc -n 0 < ${CSV} > /dev/null 2>&1; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+rm -f ${CSV} ${TRC} ${ARC} ${OUTPUT}
+
+exit ${XC}
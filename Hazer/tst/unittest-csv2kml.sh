@@ -0,0 +1,125 @@
+#!/bin/bash
+# Copyright 2024 Digital Aggregates Corporation, Colorado, USA
+# Licensed under the terms in LICENSE.txt
+# Chip Overclock <coverclock@diag.com>
+# https://github.com/coverclock/com-diag-hazer
+
+XC=0
+
+HEADINGS="NAM, NUM, FIX, SYS, SAT, CLK, TIM, LAT, LON, HAC, MSL, GEO, VAC, SOG, COG, ROL, PIT, YAW, RAC, PAC, YAC, OBS, MAC"
+
+CSV=$(mktemp)
+TRC=$(mktemp)
+
+echo "${HEADINGS}" > ${CSV}
+for II in $(seq 1 1000); do
+    if [[ ${II} -le 500 ]]; then
+        LAT=$(printf "39.79%03d00" ${II})
+        LON="-105.1500000"
+    else
+        LAT="39.7950000"
+        LON=$(printf "%s105.15%03d00" "-" $((II - 500)))
+    fi
+    FIX=3
+    if [[ ${II} -gt 900 ]]; then
+        FIX=2
+    fi
+    echo "\"test\", ${II}, ${FIX}, 0, 12, 1599145249.632000060, 1599145249.000000000, ${LAT}, ${LON}, 0., 1700.000, 1688.800, 0., 0.005000, 0., 0., 0., 0., 0., 0., 0., 0, 0."
+done >> ${CSV}
+csv2trc < ${CSV} > ${TRC}
+
+echo "**********"
+echo "LINE"
+echo "**********"
+ACTUAL="$(csv2kml < ${CSV})"
+echo "${ACTUAL}" | head -24
+if [[ $(echo "${ACTUAL}" | grep -c -- ',1700.000 $') -ne 1000 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if ! echo "${ACTUAL}" | grep -q '<name><!\[CDATA\[20200903T150049Z632000060\]\]></name>'; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ "$(echo "${ACTUAL}" | tail -1)" != "</kml>" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "TRACE"
+echo "**********"
+if [[ "$(csv2kml < ${TRC})" != "${ACTUAL}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ "$(cat ${TRC} | csv2kml)" != "${ACTUAL}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "SIMPLIFIED"
+echo "**********"
+ACTUAL="$(csv2kml -t 1.0 < ${CSV})"
+echo "${ACTUAL}" | grep -- ',1700.000 $'
+if [[ $(echo "${ACTUAL}" | grep -c -- ',1700.000 $') -ne 3 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "POINTS"
+echo "**********"
+ACTUAL="$(csv2kml -p -t 1.0 < ${CSV})"
+if [[ $(echo "${ACTUAL}" | grep -c '<Point>') -ne 3 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+ACTUAL="$(csv2kml -p < ${CSV})"
+if [[ $(echo "${ACTUAL}" | grep -c '<Point>') -ne 1000 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "CHANGES"
+echo "**********"
+ACTUAL="$(csv2kml -c < ${TRC})"
+echo "${ACTUAL}" | grep '<description>'
+if [[ $(echo "${ACTUAL}" | grep -c '<Point>') -ne 2 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if ! echo "${ACTUAL}" | grep -q '<description><!\[CDATA\[2D,12,0.005000,0.,0.,0.,\]\]></description>'; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "GEOJSON"
+echo "**********"
+ACTUAL="$(csv2kml -g -t 1.0 < ${CSV})"
+echo "${ACTUAL}"
+EXPECTED='{"type": "FeatureCollection", "name": "test", "features": [
+{"type": "Feature", "properties": {"name": "2020-09-03T15:00:49.632000060Z"}, "geometry": {"type": "LineString", "coordinates": [
+[-105.1500000, 39.7900100, 1700.000],
+[-105.1500000, 39.7950000, 1700.000],
+[-105.1550000, 39.7950000, 1700.000]
+]}}
+]}'
+if [[ "${ACTUAL}" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+ACTUAL="$(csv2kml -g -c < ${CSV} | tail -2 | head -1)"
+echo "${ACTUAL}"
+EXPECTED='{"type": "Feature", "properties": {"num": 901, "fix": "2D", "sat": 12, "sog": 0.005000, "rol": 0.0, "pit": 0.0, "yaw": 0.0}, "geometry": {"type": "Point", "coordinates": [-105.1540100, 39.7950000, 1700.000]}}'
+if [[ "${ACTUAL}" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+rm -f ${CSV} ${TRC}
+
+exit ${XC}
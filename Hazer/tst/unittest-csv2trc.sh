@@ -0,0 +1,47 @@
+#!/bin/bash
+# Copyright 2024 Digital Aggregates Corporation, Colorado, USA
+# Licensed under the terms in LICENSE.txt
+# Chip Overclock <coverclock@diag.com>
+# https://github.com/coverclock/com-diag-hazer
+
+XC=0
+
+HEADINGS="NAM, NUM, FIX, SYS, SAT, CLK, TIM, LAT, LON, HAC, MSL, GEO, VAC, SOG, COG, ROL, PIT, YAW, RAC, PAC, YAC, OBS, MAC\n"
+
+INPUT="\"neon\", 2, 3, 0, 11, 1599145249.632000060, 1599145249.000000000, 39.7943071, -105.1533805, 0., 0., 1688.800, 0., 0.005000, 0., 0., 0., 0., 0., 0., 0., 0, 0.\n\"neon!\", 3, 3, 0, 11, 1599145250.632000060, 1599145250.000000000, 39.794307123, -0.153380512, 1.2345, 1700.1234, 1688.8001, 2.3456, 0.005000, 359.123456789, -0.50000, 1.00000, -179.99999, 0.10000, 0.20000, 0.30000, 100, 12.3456\n"
+
+echo "**********"
+echo "ROUNDTRIP"
+echo "**********"
+EXPECTED="$(echo -e -n "${HEADINGS}${INPUT}")"
+ACTUAL="$(echo -e -n "${HEADINGS}${INPUT}" | csv2trc | csv2trc -r)"
+echo "${EXPECTED}"
+echo "${ACTUAL}"
+if [[ "${EXPECTED}" != "${ACTUAL}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "MAPPED"
+echo "**********"
+TEMPORARY=$(mktemp)
+echo -e -n "${INPUT}" | csv2trc > ${TEMPORARY}
+ACTUAL="$(csv2trc -r < ${TEMPORARY})"
+rm -f ${TEMPORARY}
+echo "${EXPECTED}"
+echo "${ACTUAL}"
+if [[ "${EXPECTED}" != "${ACTUAL}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "INVALID"
+echo "**********"
+if echo -e -n "${INPUT}" | csv2trc -r > /dev/null 2>&1; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+exit ${XC}
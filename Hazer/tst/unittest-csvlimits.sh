@@ -0,0 +1,98 @@
+#!/bin/bash
+# Copyright 2024 Digital Aggregates Corporation, Colorado, USA
+# Licensed under the terms in LICENSE.txt
+# Chip Overclock <coverclock@diag.com>
+# https://github.com/coverclock/com-diag-hazer
+
+XC=0
+
+HEADINGS="NAM, NUM, FIX, SYS, SAT, CLK, TIM, LAT, LON, HAC, MSL, GEO, VAC, SOG, COG, ROL, PIT, YAW, RAC, PAC, YAC, OBS, MAC"
+
+CSV=$(mktemp)
+TRC=$(mktemp)
+OUTPUT=$(mktemp)
+
+# Big enough to be split among several threads. Every tenth record has
+# only a 2D fix, so none of the limits fall on one of those.
+
+echo "${HEADINGS}" > ${CSV}
+awk 'BEGIN {
+    for (ii = 0; ii < 20000; ++ii) {
+        printf("\"test\", %d, %d, 0, 12, %d.%03d000000, 1599145249.000000000, 39.79%05d, -105.15%05d, 0., %d.%d00, %d.%d00, 0., 0.005000, 0., 0., 0., 0., 0., 0., 0., 0, 0.\n", ii, ((ii % 10) == 0) ? 2 : 3, 1599145249 + int(ii / 20), (ii % 20) * 50, ii % 1000, ii % 2000, 1700 + int((ii % 100) / 10), ii % 10, 1680 + int((ii % 50) / 10), ii % 10);
+    }
+}' >> ${CSV}
+csv2trc < ${CSV} > ${TRC}
+
+EXPECTED="csvlimits: [18000] 39.790000100, -105.150199900 39.790099900, -105.150000100 1700.100000000 1709.900000000 1680.100000000 1684.900000000"
+
+echo "**********"
+echo "THREADS"
+echo "**********"
+for THREADS in 1 2 4; do
+    ACTUAL="$(csvlimits -v -j ${THREADS} < ${CSV})"
+    echo "${ACTUAL}"
+    if [[ "${ACTUAL}" != "${EXPECTED}" ]]; then
+        echo "FAILED!" 1>&2
+        XC=1
+    fi
+done
+
+echo "**********"
+echo "PIPE"
+echo "**********"
+ACTUAL="$(cat ${CSV} | csvlimits)"
+echo "${ACTUAL}"
+if [[ "${ACTUAL}" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "TRACE"
+echo "**********"
+ACTUAL="$(csvlimits -v -j 3 < ${TRC})"
+echo "${ACTUAL}"
+if [[ "${ACTUAL}" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "STATISTICS"
+echo "**********"
+csvlimits -s -j 4 < ${CSV} > ${OUTPUT}
+cat ${OUTPUT}
+if [[ "$(head -1 ${OUTPUT})" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ "$(grep -c '^csvlimits: [A-Z][A-Z][A-Z] \[' ${OUTPUT})" != "23" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+# The fix is always 3, the median of the altitudes is 1705.0 give or take
+# the estimate, and the deviation of the number is that of a uniform series.
+if [[ -z "$(grep '^csvlimits: FIX \[18000\] 3.000000000 3.000000000 3.000000000 0.000000000 3.000000000 3.000000000 3.000000000 3.000000000 3.000000000 3.000000000 3.000000000$' ${OUTPUT})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ -z "$(awk '($2 == "MSL") && ($11 >= 1704.5) && ($11 <= 1705.5) { print; }' ${OUTPUT})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ -z "$(awk '($2 == "NUM") && ($6 > 9995.0) && ($6 < 10005.0) && ($7 > 5770.0) && ($7 < 5780.0) { print; }' ${OUTPUT})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "EMPTY"
+echo "**********"
+if echo "${HEADINGS}" | csvlimits; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+rm -f ${CSV} ${TRC} ${OUTPUT}
+
+exit ${XC}
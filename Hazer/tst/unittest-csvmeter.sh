@@ -0,0 +1,103 @@
+#!/bin/bash
+# Copyright 2024 Digital Aggregates Corporation, Colorado, USA
+# Licensed under the terms in LICENSE.txt
+# Chip Overclock <coverclock@diag.com>
+# https://github.com/coverclock/com-diag-hazer
+
+XC=0
+
+HEADINGS="NAM, NUM, FIX, SYS, SAT, CLK, TIM, LAT, LON, HAC, MSL, GEO, VAC, SOG, COG, ROL, PIT, YAW, RAC, PAC, YAC, OBS, MAC"
+
+CSV=$(mktemp)
+TRC=$(mktemp)
+OUTPUT=$(mktemp)
+
+echo "${HEADINGS}" > ${CSV}
+for II in $(seq 0 40); do
+    printf "\"test\", %d, 3, 0, 12, %d.%03d000000, 1599145249.000000000, 39.7943071, -105.1533805, 0., 0., 1688.800, 0., 0.005000, 0., 0., 0., 0., 0., 0., 0., 0, 0.\n" ${II} $((1599145249 + (II / 20))) $(((II % 20) * 50))
+done >> ${CSV}
+csv2trc < ${CSV} > ${TRC}
+
+echo "**********"
+echo "PACED"
+echo "**********"
+BEFORE=$(date +%s%N)
+csvmeter -v < ${CSV} > ${OUTPUT}
+AFTER=$(date +%s%N)
+ELAPSED=$(((AFTER - BEFORE) / 1000000))
+echo "${ELAPSED}ms"
+if [[ ${ELAPSED} -lt 2000 ]] || [[ ${ELAPSED} -gt 3000 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ "$(tail -n +2 ${CSV})" != "$(cat ${OUTPUT})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "FASTER"
+echo "**********"
+BEFORE=$(date +%s%N)
+cat ${TRC} | csvmeter -v -x 4 > ${OUTPUT}
+AFTER=$(date +%s%N)
+ELAPSED=$(((AFTER - BEFORE) / 1000000))
+echo "${ELAPSED}ms"
+if [[ ${ELAPSED} -lt 500 ]] || [[ ${ELAPSED} -gt 1500 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ "$(tail -n +2 ${CSV})" != "$(cat ${OUTPUT})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "RANGE"
+echo "**********"
+EXPECTED="$(tail -n +2 ${CSV} | head -31 | tail -11)"
+if [[ "$(csvmeter -x 0 -b 1.0 -e 1.5 < ${CSV})" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ "$(csvmeter -x 0 -b 1.0 -e 1.5 -v < ${TRC})" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+BEFORE=$(date +%s%N)
+csvmeter -b 1.5 < ${TRC} > ${OUTPUT}
+AFTER=$(date +%s%N)
+ELAPSED=$(((AFTER - BEFORE) / 1000000))
+echo "${ELAPSED}ms"
+if [[ ${ELAPSED} -gt 1000 ]] || [[ $(wc -l < ${OUTPUT}) -ne 11 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "BACKWARDS"
+echo "**********"
+echo "${HEADINGS}" > ${CSV}
+for II in $(seq 0 20); do
+    if [[ ${II} -le 10 ]]; then STEP=0; else STEP=100; fi
+    printf "\"test\", %d, 3, 0, 12, %d.%03d000000, 1599145249.000000000, 39.7943071, -105.1533805, 0., 0., 1688.800, 0., 0.005000, 0., 0., 0., 0., 0., 0., 0., 0, 0.\n" ${II} $((1599145249 - STEP + (II / 20))) $(((II % 20) * 50))
+done >> ${CSV}
+csv2trc < ${CSV} > ${TRC}
+BEFORE=$(date +%s%N)
+csvmeter -v < ${TRC} > ${OUTPUT}
+AFTER=$(date +%s%N)
+ELAPSED=$(((AFTER - BEFORE) / 1000000))
+echo "${ELAPSED}ms"
+if [[ ${ELAPSED} -lt 900 ]] || [[ ${ELAPSED} -gt 1500 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+EXPECTED="$(tail -n 5 ${CSV})"
+if [[ "$(csvmeter -x 0 -b 0.75 < ${CSV})" != "${EXPECTED}" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+rm -f ${CSV} ${TRC} ${OUTPUT}
+
+exit ${XC}
@@ -0,0 +1,422 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Datagram unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The batch and fanout tests send datagrams to themselves over the
+ * loopback.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include "com/diag/hazer/datagram.h"
+
+int main(void)
+{
+    {
+        datagram_sequence_t expected = 0;
+        datagram_buffer_t buffer = DATAGRAM_BUFFER_INITIALIZER;
+        datagram_sequence_t sequence = 0;
+        unsigned int outoforder = 0;
+        unsigned int missing = 0;
+
+        datagram_stamp(&buffer.header, &sequence);
+        assert(sequence == 1);
+        assert(datagram_validate(&expected, &buffer.header, sizeof(buffer.header) + 10, &outoforder, &missing) == 10);
+        assert(expected == 1);
+
+        sequence = 5;
+        datagram_stamp(&buffer.header, &sequence);
+        assert(datagram_validate(&expected, &buffer.header, sizeof(buffer.header) + 10, &outoforder, &missing) == 10);
+        assert(expected == 6);
+        assert(missing == 4);
+
+        sequence = 3;
+        datagram_stamp(&buffer.header, &sequence);
+        assert(datagram_validate(&expected, &buffer.header, sizeof(buffer.header) + 10, &outoforder, &missing) < 0);
+        assert(expected == 6);
+        assert(outoforder == 1);
+    }
+
+    {
+        static datagram_batch_t batch;
+        static const int TOTAL = DATAGRAM_BATCH + (DATAGRAM_BATCH / 4);
+        datagram_buffer_t buffer = DATAGRAM_BUFFER_INITIALIZER;
+        datagram_buffer_t * bufferp = (datagram_buffer_t *)0;
+        const struct sockaddr_storage * sap = (const struct sockaddr_storage *)0;
+        struct sockaddr_in sink = { 0, };
+        struct sockaddr_in source = { 0, };
+        socklen_t length = 0;
+        datagram_sequence_t sequence = 0;
+        datagram_sequence_t expected = 0;
+        unsigned int outoforder = 0;
+        unsigned int missing = 0;
+        ssize_t total = 0;
+        uint16_t address[8] = { 0, };
+        uint16_t port = 0;
+        int receiver = -1;
+        int sender = -1;
+        int ii = 0;
+
+        datagram_batch_init(&batch);
+        assert(datagram_batch_pending(&batch) == 0);
+        assert(datagram_batch_next(&batch, &total, &sap) == (datagram_buffer_t *)0);
+
+        receiver = socket(AF_INET, SOCK_DGRAM, 0);
+        assert(receiver >= 0);
+        sink.sin_family = AF_INET;
+        sink.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sink.sin_port = 0;
+        assert(bind(receiver, (struct sockaddr *)&sink, sizeof(sink)) == 0);
+        length = sizeof(sink);
+        assert(getsockname(receiver, (struct sockaddr *)&sink, &length) == 0);
+
+        sender = socket(AF_INET, SOCK_DGRAM, 0);
+        assert(sender >= 0);
+        source.sin_family = AF_INET;
+        source.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        source.sin_port = 0;
+        assert(bind(sender, (struct sockaddr *)&source, sizeof(source)) == 0);
+        length = sizeof(source);
+        assert(getsockname(sender, (struct sockaddr *)&source, &length) == 0);
+
+        assert(datagram_batch_receive(&batch, receiver) == 0);
+        assert(batch.wakeups == 0);
+
+        for (ii = 0; ii < TOTAL; ++ii) {
+            datagram_stamp(&buffer.header, &sequence);
+            snprintf((char *)buffer.payload.data, sizeof(buffer.payload.data), "DATAGRAM%02d", ii);
+            assert(sendto(sender, &buffer, sizeof(buffer.header) + 10, 0, (struct sockaddr *)&sink, sizeof(sink)) == (sizeof(buffer.header) + 10));
+        }
+
+        assert(datagram_batch_receive(&batch, receiver) == DATAGRAM_BATCH);
+        assert(datagram_batch_pending(&batch) == DATAGRAM_BATCH);
+
+        for (ii = 0; ii < DATAGRAM_BATCH; ++ii) {
+            bufferp = datagram_batch_next(&batch, &total, &sap);
+            assert(bufferp != (datagram_buffer_t *)0);
+            assert(total == (sizeof(buffer.header) + 10));
+            assert(datagram_validate(&expected, &(bufferp->header), total, &outoforder, &missing) == 10);
+            assert(bufferp->payload.data[10] == '\0');
+            assert(strncmp((const char *)bufferp->payload.data, "DATAGRAM", 8) == 0);
+            assert(datagram_batch_identify(sap, address, &port) == 0);
+            assert(address[5] == 0xffff);
+            assert(address[6] == 0x7f00);
+            assert(address[7] == 0x0001);
+            assert(port == ntohs(source.sin_port));
+        }
+
+        assert(datagram_batch_next(&batch, &total, &sap) == (datagram_buffer_t *)0);
+
+        assert(datagram_batch_receive(&batch, receiver) == (TOTAL - DATAGRAM_BATCH));
+        while ((bufferp = datagram_batch_next(&batch, &total, (const struct sockaddr_storage **)0)) != (datagram_buffer_t *)0) {
+            assert(datagram_validate(&expected, &(bufferp->header), total, &outoforder, &missing) == 10);
+        }
+
+        assert(expected == TOTAL);
+        assert(outoforder == 0);
+        assert(missing == 0);
+        assert(batch.wakeups == 2);
+        assert(batch.packets == TOTAL);
+        assert(batch.maximum == DATAGRAM_BATCH);
+
+        assert(datagram_batch_receive(&batch, receiver) == 0);
+
+        assert(close(sender) == 0);
+        assert(close(receiver) == 0);
+    }
+
+    {
+        static datagram_fanout_t fanout;
+        static const uint16_t LOOPBACK[8] = { 0, 0, 0, 0, 0, 0xffff, 0x7f00, 0x0001, };
+        datagram_buffer_t buffer = DATAGRAM_BUFFER_INITIALIZER;
+        datagram_buffer_t received = DATAGRAM_BUFFER_INITIALIZER;
+        struct sockaddr_in sink[2] = { { 0, }, };
+        struct sockaddr_in6 source = { 0, };
+        socklen_t length = 0;
+        datagram_sequence_t sequence = 0;
+        int receiver[2] = { -1, -1, };
+        int sender = -1;
+        int ii = 0;
+
+        datagram_fanout_init(&fanout);
+        assert(fanout.count == 0);
+
+        for (ii = 0; ii < DATAGRAM_FANOUT; ++ii) {
+            assert(datagram_fanout_add(&fanout, LOOPBACK, ii + 1) == ii);
+        }
+        assert(datagram_fanout_add(&fanout, LOOPBACK, 0) < 0);
+        datagram_fanout_reset(&fanout);
+        assert(fanout.count == 0);
+
+        for (ii = 0; ii < 2; ++ii) {
+            receiver[ii] = socket(AF_INET, SOCK_DGRAM, 0);
+            assert(receiver[ii] >= 0);
+            sink[ii].sin_family = AF_INET;
+            sink[ii].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            sink[ii].sin_port = 0;
+            assert(bind(receiver[ii], (struct sockaddr *)&(sink[ii]), sizeof(sink[ii])) == 0);
+            length = sizeof(sink[ii]);
+            assert(getsockname(receiver[ii], (struct sockaddr *)&(sink[ii]), &length) == 0);
+        }
+
+        sender = socket(AF_INET6, SOCK_DGRAM, 0);
+        assert(sender >= 0);
+        source.sin6_family = AF_INET6;
+        source.sin6_addr = in6addr_any;
+        source.sin6_port = 0;
+        assert(bind(sender, (struct sockaddr *)&source, sizeof(source)) == 0);
+
+        /*
+         * The destination in the middle has a port of zero, which the
+         * kernel rejects, so the send must skip it and carry on.
+         */
+
+        assert(datagram_fanout_add(&fanout, LOOPBACK, ntohs(sink[0].sin_port)) == 0);
+        assert(datagram_fanout_add(&fanout, LOOPBACK, 0) == 1);
+        assert(datagram_fanout_add(&fanout, LOOPBACK, ntohs(sink[1].sin_port)) == 2);
+
+        datagram_stamp(&buffer.header, &sequence);
+        strcpy((char *)buffer.payload.data, "FANOUT");
+
+        assert(datagram_fanout_send(&fanout, sender, &buffer, sizeof(buffer.header) + 6) == 2);
+        assert(fanout.error[0] == 0);
+        assert(fanout.error[1] == EINVAL);
+        assert(fanout.error[2] == 0);
+        assert(fanout.packets == 2);
+        assert(fanout.errors == 1);
+        assert(fanout.calls == 3);
+        assert(fanout.count == 3);
+
+        for (ii = 0; ii < 2; ++ii) {
+            memset(&received, 0, sizeof(received));
+            assert(recv(receiver[ii], &received, sizeof(received), MSG_DONTWAIT) == (sizeof(buffer.header) + 6));
+            assert(received.header.sequence == buffer.header.sequence);
+            assert(strcmp((const char *)received.payload.data, "FANOUT") == 0);
+        }
+
+        assert(close(sender) == 0);
+        assert(close(receiver[0]) == 0);
+        assert(close(receiver[1]) == 0);
+    }
+
+    {
+        static datagram_packer_t packer;
+        static datagram_unpacker_t unpacker;
+        static const char * FRAME[] = { "$GPGGA,1*00\r\n", "$GPRMC,22*00\r\n", "$GPGSA,333*00\r\n", };
+        datagram_buffer_t * bufferp = (datagram_buffer_t *)0;
+        datagram_sequence_t sequence = 7;
+        datagram_sequence_t expected = 7;
+        unsigned int outoforder = 0;
+        unsigned int missing = 0;
+        size_t length = 0;
+        size_t total = 0;
+        ssize_t size = 0;
+        int ii = 0;
+
+        datagram_packer_init(&packer, DATAGRAM_FRAMES_MTU);
+        datagram_unpacker_init(&unpacker);
+        assert(datagram_packer_pending(&packer) == 0);
+        assert(datagram_packer_finish(&packer, &sequence) == 0);
+        assert(sequence == 7);
+
+        /*
+         * Several frames are packed into one batched datagram.
+         */
+
+        for (ii = 0; ii < 3; ++ii) {
+            length = strlen(FRAME[ii]);
+            assert(datagram_packer_append(&packer, FRAME[ii], length) == 0);
+            total += DATAGRAM_FRAMES_PREFIX + length;
+        }
+        assert(datagram_packer_pending(&packer) == 3);
+        length = datagram_packer_finish(&packer, &sequence);
+        assert(length == (sizeof(datagram_header_t) + DATAGRAM_FRAMES_PREAMBLE + total));
+        assert(sequence == 8);
+        assert(datagram_packer_pending(&packer) == 0);
+        assert(packer.buffer.payload.data[0] == DATAGRAM_FRAMES_MARK);
+
+        assert(datagram_validate(&expected, &packer.buffer.header, length, &outoforder, &missing) > 0);
+        assert(datagram_unpacker_start(&unpacker, &packer.buffer.header, length) == 3);
+        for (ii = 0; ii < 3; ++ii) {
+            assert(datagram_unpacker_pending(&unpacker) == (3 - ii));
+            assert((bufferp = datagram_unpacker_next(&unpacker, &size)) != (datagram_buffer_t *)0);
+            assert(size == strlen(FRAME[ii]));
+            assert(strcmp((const char *)bufferp->payload.data, FRAME[ii]) == 0);
+            assert(bufferp->header.sequence == packer.buffer.header.sequence);
+        }
+        assert(datagram_unpacker_pending(&unpacker) == 0);
+        assert(datagram_unpacker_next(&unpacker, &size) == (datagram_buffer_t *)0);
+        assert(unpacker.frames == 3);
+        assert(unpacker.datagrams == 1);
+
+        /*
+         * A truncated batch isn't a batch.
+         */
+
+        assert(datagram_unpacker_start(&unpacker, &packer.buffer.header, length - 1) == 0);
+        assert(datagram_unpacker_pending(&unpacker) == 0);
+
+        /*
+         * A single frame is sent as an ordinary datagram.
+         */
+
+        length = strlen(FRAME[1]);
+        assert(datagram_packer_append(&packer, FRAME[1], length) == 0);
+        assert(datagram_packer_finish(&packer, &sequence) == (sizeof(datagram_header_t) + length));
+        assert(memcmp(packer.buffer.payload.data, FRAME[1], length) == 0);
+        assert(datagram_unpacker_start(&unpacker, &packer.buffer.header, sizeof(datagram_header_t) + length) == 0);
+        assert(datagram_validate(&expected, &packer.buffer.header, sizeof(datagram_header_t) + length, &outoforder, &missing) == length);
+        assert(expected == 9);
+        assert(missing == 0);
+        assert(outoforder == 0);
+
+        /*
+         * Frames are packed only up to the budget.
+         */
+
+        datagram_packer_init(&packer, sizeof(datagram_header_t) + DATAGRAM_FRAMES_PREAMBLE + (2 * (DATAGRAM_FRAMES_PREFIX + 14)));
+        assert(datagram_packer_append(&packer, FRAME[0], 13) == 0);
+        assert(datagram_packer_append(&packer, FRAME[1], 14) == 0);
+        assert(datagram_packer_append(&packer, FRAME[2], 1) < 0);
+        assert(datagram_packer_pending(&packer) == 2);
+        assert(datagram_packer_finish(&packer, &sequence) == (sizeof(datagram_header_t) + DATAGRAM_FRAMES_PREAMBLE + (2 * DATAGRAM_FRAMES_PREFIX) + 27));
+        assert(datagram_packer_append(&packer, FRAME[2], 15) == 0);
+        assert(datagram_packer_append(&packer, "", 0) < 0);
+
+        datagram_packer_init(&packer, 0);
+        assert(datagram_packer_append(&packer, FRAME[0], 13) < 0);
+    }
+
+    {
+        static datagram_reorder_t reorder;
+        datagram_buffer_t buffer = DATAGRAM_BUFFER_INITIALIZER;
+        datagram_buffer_t * bufferp = (datagram_buffer_t *)0;
+        datagram_sequence_t sequence = 0;
+        datagram_sequence_t expected = 0;
+        unsigned int outoforder = 0;
+        unsigned int missing = 0;
+        ssize_t length = 0;
+        int64_t now = 1000;
+
+        datagram_reorder_init(&reorder, 4, 50);
+        assert(reorder.slots == 4);
+        assert(datagram_reorder_remaining(&reorder, now) < 0);
+        assert(!datagram_reorder_ready(&reorder, expected, now));
+        assert(datagram_reorder_next(&reorder, &length, now, &expected, &missing) == (datagram_buffer_t *)0);
+
+        /*
+         * In order: released immediately.
+         */
+
+        sequence = 0;
+        datagram_stamp(&buffer.header, &sequence);
+        strcpy((char *)buffer.payload.data, "ZERO");
+        assert(datagram_reorder_insert(&reorder, &buffer.header, sizeof(buffer.header) + 4, now, &expected, &outoforder) == 4);
+        assert(datagram_reorder_ready(&reorder, expected, now));
+        assert((bufferp = datagram_reorder_next(&reorder, &length, now, &expected, &missing)) != (datagram_buffer_t *)0);
+        assert(length == (sizeof(buffer.header) + 4));
+        assert(strcmp((const char *)bufferp->payload.data, "ZERO") == 0);
+        assert(expected == 1);
+        assert(datagram_reorder_next(&reorder, &length, now, &expected, &missing) == (datagram_buffer_t *)0);
+
+        /*
+         * 3, 2, 1: held until the gap fills, then released in order.
+         */
+
+        sequence = 3;
+        datagram_stamp(&buffer.header, &sequence);
+        strcpy((char *)buffer.payload.data, "3");
+        assert(datagram_reorder_insert(&reorder, &buffer.header, sizeof(buffer.header) + 1, now, &expected, &outoforder) == 1);
+        assert(!datagram_reorder_ready(&reorder, expected, now));
+        assert(datagram_reorder_remaining(&reorder, now) == 50);
+        assert(datagram_reorder_remaining(&reorder, now + 10) == 40);
+
+        sequence = 2;
+        datagram_stamp(&buffer.header, &sequence);
+        strcpy((char *)buffer.payload.data, "2");
+        assert(datagram_reorder_insert(&reorder, &buffer.header, sizeof(buffer.header) + 1, now + 10, &expected, &outoforder) == 1);
+        assert(datagram_reorder_next(&reorder, &length, now + 10, &expected, &missing) == (datagram_buffer_t *)0);
+
+        sequence = 1;
+        datagram_stamp(&buffer.header, &sequence);
+        strcpy((char *)buffer.payload.data, "1");
+        assert(datagram_reorder_insert(&reorder, &buffer.header, sizeof(buffer.header) + 1, now + 20, &expected, &outoforder) == 1);
+
+        assert((bufferp = datagram_reorder_next(&reorder, &length, now + 20, &expected, &missing)) != (datagram_buffer_t *)0);
+        assert(strcmp((const char *)bufferp->payload.data, "1") == 0);
+        assert((bufferp = datagram_reorder_next(&reorder, &length, now + 20, &expected, &missing)) != (datagram_buffer_t *)0);
+        assert(strcmp((const char *)bufferp->payload.data, "2") == 0);
+        assert((bufferp = datagram_reorder_next(&reorder, &length, now + 20, &expected, &missing)) != (datagram_buffer_t *)0);
+        assert(strcmp((const char *)bufferp->payload.data, "3") == 0);
+        assert(datagram_reorder_next(&reorder, &length, now + 20, &expected, &missing) == (datagram_buffer_t *)0);
+        assert(expected == 4);
+        assert(missing == 0);
+        assert(outoforder == 0);
+        assert(reorder.held == 0);
+        assert(reorder.histogram[0] == 2);
+        assert(reorder.histogram[1] == 1);
+        assert(reorder.histogram[2] == 1);
+        assert(reorder.reordered == 2);
+
+        /*
+         * Late and duplicate datagrams are discarded.
+         */
+
+        sequence = 2;
+        datagram_stamp(&buffer.header, &sequence);
+        assert(datagram_reorder_insert(&reorder, &buffer.header, sizeof(buffer.header) + 1, now + 20, &expected, &outoforder) < 0);
+        assert(outoforder == 1);
+
+        sequence = 6;
+        datagram_stamp(&buffer.header, &sequence);
+        strcpy((char *)buffer.payload.data, "6");
+        assert(datagram_reorder_insert(&reorder, &buffer.header, sizeof(buffer.header) + 1, now + 30, &expected, &outoforder) == 1);
+        sequence = 6;
+        datagram_stamp(&buffer.header, &sequence);
+        assert(datagram_reorder_insert(&reorder, &buffer.header, sizeof(buffer.header) + 1, now + 30, &expected, &outoforder) < 0);
+        assert(outoforder == 2);
+
+        /*
+         * A gap that doesn't fill in time is given up on.
+         */
+
+        assert(datagram_reorder_next(&reorder, &length, now + 79, &expected, &missing) == (datagram_buffer_t *)0);
+        assert(datagram_reorder_remaining(&reorder, now + 80) == 0);
+        assert(datagram_reorder_ready(&reorder, expected, now + 80));
+        assert((bufferp = datagram_reorder_next(&reorder, &length, now + 80, &expected, &missing)) != (datagram_buffer_t *)0);
+        assert(strcmp((const char *)bufferp->payload.data, "6") == 0);
+        assert(expected == 7);
+        assert(missing == 2);
+        assert(reorder.expired == 1);
+
+        /*
+         * A full buffer gives up on the gap right away.
+         */
+
+        for (sequence = 8; sequence < 12; ) {
+            datagram_stamp(&buffer.header, &sequence);
+            assert(datagram_reorder_insert(&reorder, &buffer.header, sizeof(buffer.header) + 1, now + 100, &expected, &outoforder) == 1);
+        }
+        assert(reorder.held == 4);
+        assert(datagram_reorder_ready(&reorder, expected, now + 100));
+        while (datagram_reorder_next(&reorder, &length, now + 100, &expected, &missing) != (datagram_buffer_t *)0) {
+            /* Do nothing. */
+        }
+        assert(expected == 12);
+        assert(missing == 3);
+        assert(reorder.held == 0);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#!/bin/bash
+# Copyright 2024 Digital Aggregates Corporation, Colorado, USA
+# Licensed under the terms in LICENSE.txt
+# Chip Overclock <coverclock@diag.com>
+# https://github.com/coverclock/com-diag-hazer
+
+XC=0
+
+GGA="\$GNGGA,171629.00,3947.65423,N,10509.20101,W,1,12,0.66,1711.8,M,-21.5,M,,*4C\r\n"
+RMC="\$GNRMC,171629.00,A,3947.65423,N,10509.20101,W,0.023,,040619,,,A,V*07\r\n"
+
+INPUT=$(mktemp)
+SEQUENTIAL=$(mktemp)
+PARALLEL=$(mktemp)
+
+for II in $(seq 1 256); do
+    head -c $((RANDOM % 4096)) /dev/urandom
+    for JJ in $(seq 1 32); do
+        echo -e -n "${GGA}${RMC}"
+    done
+done > ${INPUT}
+
+echo "**********"
+echo "CSV"
+echo "**********"
+decodetool -j 1 -N test < ${INPUT} > ${SEQUENTIAL}
+decodetool -j 4 -c 131072 -N test -v < ${INPUT} > ${PARALLEL}
+wc -l ${SEQUENTIAL} ${PARALLEL}
+if [[ $(wc -l < ${SEQUENTIAL}) -le 1 ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if [[ "$(tail -n +2 ${SEQUENTIAL} | cut -d , -f 1 | sort -u)" != "\"test#\"" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+if ! cmp ${SEQUENTIAL} ${PARALLEL}; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "BINARY"
+echo "**********"
+decodetool -3 -j 1 -N test < ${INPUT} > ${SEQUENTIAL}
+cat ${INPUT} | decodetool -3 -j 4 -c 131072 -N test -v > ${PARALLEL}
+if ! cmp ${SEQUENTIAL} ${PARALLEL}; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+echo "**********"
+echo "ROUNDTRIP"
+echo "**********"
+decodetool -j 1 -N test < ${INPUT} > ${PARALLEL}
+if [[ "$(csv2trc -r < ${SEQUENTIAL})" != "$(cat ${PARALLEL})" ]]; then
+    echo "FAILED!" 1>&2
+    XC=1
+fi
+
+rm -f ${INPUT} ${SEQUENTIAL} ${PARALLEL}
+
+exit ${XC}
@@ -0,0 +1,210 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the gpstool Expiry unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The expiry timer wheel is part of gpstool rather than the library, so
+ * the Makefile links this test with app/gpstool/expiry.c.
+ */
+
+#include <stdio.h>
+#include <assert.h>
+#include "../app/gpstool/expiry.h"
+
+enum {
+    ENTRIES = 8,
+};
+
+static expiry_wheel_t wheel;
+
+int main(void)
+{
+    {
+        expiry_init(&wheel, 1000);
+        assert(wheel.now == 1000);
+        assert(wheel.armed == 0);
+        assert(expiry_advance(&wheel, 999) == 0);
+        assert(wheel.now == 1000);
+        assert(expiry_advance(&wheel, 1000) == 0);
+        assert(wheel.now == 1000);
+    }
+
+    {
+        expiry_entry_t entry = EXPIRY_ENTRY_INITIALIZER;
+        hazer_expiry_t timeout = 0;
+
+        /*
+         * Arm.
+         */
+
+        expiry_init(&wheel, 1000);
+        expiry_arm(&wheel, &entry, &timeout, 5);
+        assert(timeout == 5);
+        assert(wheel.armed == 1);
+        assert(entry.deadline == 1005);
+        assert(expiry_advance(&wheel, 1004) == 0);
+        assert(timeout == 5);
+        assert(wheel.armed == 1);
+        assert(expiry_advance(&wheel, 1005) == 1);
+        assert(timeout == 0);
+        assert(wheel.armed == 0);
+        assert(entry.next == (expiry_entry_t *)0);
+        assert(entry.prev == (expiry_entry_t *)0);
+        assert(expiry_advance(&wheel, 1010) == 0);
+    }
+
+    {
+        expiry_entry_t entry = EXPIRY_ENTRY_INITIALIZER;
+        hazer_expiry_t timeout = 0;
+
+        /*
+         * Re-arm before and after expiry.
+         */
+
+        expiry_init(&wheel, 2000);
+        expiry_arm(&wheel, &entry, &timeout, 3);
+        assert(expiry_advance(&wheel, 2002) == 0);
+        expiry_arm(&wheel, &entry, &timeout, 10);
+        assert(timeout == 10);
+        assert(wheel.armed == 1);
+        assert(expiry_advance(&wheel, 2003) == 0);
+        assert(timeout == 10);
+        assert(expiry_advance(&wheel, 2011) == 0);
+        assert(expiry_advance(&wheel, 2012) == 1);
+        assert(timeout == 0);
+        expiry_arm(&wheel, &entry, &timeout, 1);
+        assert(timeout == 1);
+        assert(wheel.armed == 1);
+        assert(expiry_advance(&wheel, 2013) == 1);
+        assert(timeout == 0);
+        assert(wheel.armed == 0);
+    }
+
+    {
+        expiry_entry_t entry = EXPIRY_ENTRY_INITIALIZER;
+        hazer_expiry_t timeout = 0;
+
+        /*
+         * Zero or negative is stale immediately, and disarms.
+         */
+
+        expiry_init(&wheel, 3000);
+        expiry_arm(&wheel, &entry, &timeout, 7);
+        assert(wheel.armed == 1);
+        expiry_arm(&wheel, &entry, &timeout, 0);
+        assert(timeout == 0);
+        assert(wheel.armed == 0);
+        assert(entry.next == (expiry_entry_t *)0);
+        expiry_arm(&wheel, &entry, &timeout, -1);
+        assert(timeout == 0);
+        assert(wheel.armed == 0);
+        assert(expiry_advance(&wheel, 3010) == 0);
+    }
+
+    {
+        expiry_entry_t entry = EXPIRY_ENTRY_INITIALIZER;
+        hazer_expiry_t timeout = 0;
+
+        /*
+         * Disarm leaves the field as it is.
+         */
+
+        expiry_init(&wheel, 4000);
+        expiry_arm(&wheel, &entry, &timeout, 7);
+        expiry_disarm(&wheel, &entry);
+        assert(timeout == 7);
+        assert(wheel.armed == 0);
+        expiry_disarm(&wheel, &entry);
+        assert(wheel.armed == 0);
+        assert(expiry_advance(&wheel, 4007) == 0);
+        assert(timeout == 7);
+    }
+
+    {
+        expiry_entry_t entry = EXPIRY_ENTRY_INITIALIZER;
+        hazer_expiry_t timeout = 0;
+
+        /*
+         * Clamp to the largest timeout the wheel can hold.
+         */
+
+        expiry_init(&wheel, 5000);
+        expiry_arm(&wheel, &entry, &timeout, EXPIRY_SLOTS);
+        assert(timeout == (EXPIRY_SLOTS - 1));
+        assert(entry.deadline == (5000 + EXPIRY_SLOTS - 1));
+        expiry_arm(&wheel, &entry, &timeout, 100000);
+        assert(timeout == (EXPIRY_SLOTS - 1));
+        assert(wheel.armed == 1);
+        assert(expiry_advance(&wheel, 5000 + EXPIRY_SLOTS - 2) == 0);
+        assert(timeout == (EXPIRY_SLOTS - 1));
+        assert(expiry_advance(&wheel, 5000 + EXPIRY_SLOTS - 1) == 1);
+        assert(timeout == 0);
+    }
+
+    {
+        expiry_entry_t entry[ENTRIES] = { EXPIRY_ENTRY_INITIALIZER, };
+        hazer_expiry_t timeout[ENTRIES] = { 0, };
+        seconds_t start = 0;
+        seconds_t now = 0;
+        unsigned int expired = 0;
+        int ii = 0;
+
+        /*
+         * Advance one second at a time over the wrap of the wheel, with
+         * entries in the slots on both sides of it.
+         */
+
+        start = (EXPIRY_SLOTS * 10) - 3;
+        expiry_init(&wheel, start);
+        for (ii = 0; ii < ENTRIES; ++ii) {
+            expiry_arm(&wheel, &(entry[ii]), &(timeout[ii]), ii + 1);
+        }
+        assert(wheel.armed == ENTRIES);
+        for (now = start + 1; now <= (start + ENTRIES); ++now) {
+            assert(expiry_advance(&wheel, now) == 1);
+            for (ii = 0; ii < ENTRIES; ++ii) {
+                assert((timeout[ii] == 0) == ((start + ii + 1) <= now));
+            }
+        }
+        assert(wheel.armed == 0);
+
+        /*
+         * Advance over the wrap in one step.
+         */
+
+        for (ii = 0; ii < ENTRIES; ++ii) {
+            expiry_arm(&wheel, &(entry[ii]), &(timeout[ii]), (ii * 37) + 1);
+        }
+        now = wheel.now + (EXPIRY_SLOTS / 2);
+        expired = expiry_advance(&wheel, now);
+        for (ii = 0; ii < ENTRIES; ++ii) {
+            assert((timeout[ii] == 0) == (((ii * 37) + 1) <= (EXPIRY_SLOTS / 2)));
+        }
+        assert(expired == (ENTRIES - wheel.armed));
+        assert(expired == 4);
+
+        /*
+         * Fall more than a full revolution behind.
+         */
+
+        for (ii = 0; ii < ENTRIES; ++ii) {
+            expiry_arm(&wheel, &(entry[ii]), &(timeout[ii]), EXPIRY_SLOTS - 1 - ii);
+        }
+        assert(wheel.armed == ENTRIES);
+        now = wheel.now + (EXPIRY_SLOTS * 3) + 1;
+        assert(expiry_advance(&wheel, now) == ENTRIES);
+        assert(wheel.now == now);
+        assert(wheel.armed == 0);
+        for (ii = 0; ii < ENTRIES; ++ii) {
+            assert(timeout[ii] == 0);
+        }
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
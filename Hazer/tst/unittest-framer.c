@@ -0,0 +1,201 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Framer unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include "com/diag/hazer/framer.h"
+
+static const char * SENTENCES[] = {
+    "$GNRMC,171629.00,A,3947.65423,N,10509.20101,W,0.023,,040619,,,A,V*07\r\n",
+    "$GNGGA,171629.00,3947.65423,N,10509.20101,W,1,12,0.66,1711.8,M,-21.5,M,,*4C\r\n",
+    "$GPGSV,3,3,11,19,34,221,37,28,69,002,38,30,56,146,47,1*52\r\n",
+};
+
+static const uint8_t RTCM[] = { 0xd3, 0x00, 0x00, 0x47, 0xea, 0x4b, };
+
+enum {
+    SIZE = 16384,
+};
+
+static uint8_t stream[SIZE];
+static framer_event_t expected[SIZE];
+static capture_protocol_t protocols[SIZE];
+static size_t lengths[SIZE];
+
+static uint32_t seed = 1;
+
+static uint8_t noise(void)
+{
+    seed = (seed * 1103515245UL) + 12345UL;
+    return (seed >> 16) & 0xff;
+}
+
+int main(void)
+{
+    uint8_t ubx[6 + 92 + 2] = { 0xb5, 0x62, 0x01, 0x07, 92, 0, };
+    size_t length = 0;
+    size_t frames[CAPTURE_CPO + 1] = { 0, };
+    size_t inserted[CAPTURE_CPO + 1] = { 0, };
+    size_t ii = 0;
+    size_t jj = 0;
+    size_t kk = 0;
+    size_t mm = 0;
+    size_t start = 0;
+    size_t worst = 0;
+    const uint8_t * pp = (const uint8_t *)0;
+    const void * fp = (const void *)0;
+    uint8_t ch = 0;
+    framer_t framer;
+    framer_event_t event = FRAMER_CONTINUING;
+    capture_protocol_t protocol = CAPTURE_OTHER;
+
+    /*
+     * Build a stream of complete frames, damaged frames, and noise. The
+     * noise before each complete frame is free of the octets that begin a
+     * frame, and each damaged frame is cut short or overwritten with zeros,
+     * so every complete frame must be found.
+     */
+
+    for (ii = 0; ii < 92; ++ii) {
+        ubx[6 + ii] = noise();
+    }
+    pp = (const uint8_t *)yodel_checksum_buffer(ubx, sizeof(ubx), &ubx[sizeof(ubx) - 2], &ubx[sizeof(ubx) - 1]);
+    assert(pp == &ubx[sizeof(ubx) - 2]);
+
+    while (!0) {
+        kk = noise() % 8;
+        if ((length + 8 + kk + sizeof(ubx) + 128) > sizeof(stream)) { break; }
+        for (ii = 0; ii < kk; ++ii) {
+            do { ch = noise(); } while ((ch == '$') || (ch == '!') || (ch == 0xb5) || (ch == 0xd3) || (ch == 0x10));
+            stream[length++] = ch;
+        }
+        switch (noise() % 6) {
+        case 0:
+        case 1:
+            pp = (const uint8_t *)SENTENCES[mm++ % (sizeof(SENTENCES) / sizeof(SENTENCES[0]))];
+            memcpy(&stream[length], pp, strlen((const char *)pp));
+            length += strlen((const char *)pp);
+            inserted[CAPTURE_NMEA] += 1;
+            break;
+        case 2:
+            memcpy(&stream[length], ubx, sizeof(ubx));
+            length += sizeof(ubx);
+            inserted[CAPTURE_UBX] += 1;
+            break;
+        case 3:
+            memcpy(&stream[length], RTCM, sizeof(RTCM));
+            length += sizeof(RTCM);
+            inserted[CAPTURE_RTCM] += 1;
+            break;
+        case 4:
+            pp = (const uint8_t *)SENTENCES[0];
+            kk = noise() % strlen((const char *)pp);
+            memcpy(&stream[length], pp, kk);
+            length += kk;
+            stream[length++] = 0x00;
+            break;
+        case 5:
+            kk = noise() % sizeof(ubx);
+            memcpy(&stream[length], ubx, kk);
+            memset(&stream[length + kk], 0, sizeof(ubx) - kk);
+            length += sizeof(ubx);
+            break;
+        }
+    }
+
+    fprintf(stderr, "%s: length=%zu NMEA=%zu UBX=%zu RTCM=%zu\n", __FILE__, length, inserted[CAPTURE_NMEA], inserted[CAPTURE_UBX], inserted[CAPTURE_RTCM]);
+
+    /*
+     * Frame the whole stream from its beginning.
+     */
+
+    {
+        assert(framer_init(&framer, FRAMER_SCANNING) == &framer);
+
+        for (ii = 0; ii < length; ++ii) {
+            event = framer_machine(&framer, stream[ii]);
+            expected[ii] = event;
+            if (event == FRAMER_FRAMED) {
+                fp = framer_frame(&framer, &protocol, &kk);
+                assert(fp != (const void *)0);
+                assert(kk <= (ii + 1));
+                assert(memcmp(fp, &stream[ii + 1 - kk], kk) == 0);
+                protocols[ii] = protocol;
+                lengths[ii] = kk;
+                frames[protocol] += 1;
+            }
+        }
+
+        assert(frames[CAPTURE_NMEA] == inserted[CAPTURE_NMEA]);
+        assert(frames[CAPTURE_UBX] == inserted[CAPTURE_UBX]);
+        assert(frames[CAPTURE_RTCM] == inserted[CAPTURE_RTCM]);
+        assert(frames[CAPTURE_CPO] == 0);
+    }
+
+    /*
+     * Frame the stream from every offset. Once a framer that starts late
+     * reaches a point that the framer that started at the beginning also
+     * reached, it must find exactly the same frames from then on. It gets
+     * there within about the length of the longest frame it might mistake
+     * for one.
+     */
+
+    {
+        for (start = 0; start < length; ++start) {
+            framer_init(&framer, FRAMER_SCANNING);
+            for (ii = start; ii < length; ++ii) {
+                event = framer_machine(&framer, stream[ii]);
+                if ((event != FRAMER_CONTINUING) && (event == expected[ii])) { break; }
+            }
+            if (ii >= length) {
+                continue;
+            }
+            if ((ii - start) > worst) {
+                worst = ii - start;
+            }
+            for (jj = ii + 1; (jj < length) && (jj <= (ii + sizeof(stream) / 8)); ++jj) {
+                event = framer_machine(&framer, stream[jj]);
+                assert(event == expected[jj]);
+                if (event == FRAMER_FRAMED) {
+                    framer_frame(&framer, &protocol, &kk);
+                    assert(protocol == protocols[jj]);
+                    assert(kk == lengths[jj]);
+                }
+            }
+        }
+
+        fprintf(stderr, "%s: worst=%zu\n", __FILE__, worst);
+        assert(worst < sizeof(yodel_buffer_t));
+    }
+
+    /*
+     * A framer that picks up just after a frame must find the same frames.
+     */
+
+    {
+        for (ii = 0; ii < length; ++ii) {
+            if (expected[ii] == FRAMER_FRAMED) { break; }
+        }
+        assert(ii < length);
+        framer_init(&framer, FRAMER_FRAMED);
+        for (jj = ii + 1; jj < length; ++jj) {
+            event = framer_machine(&framer, stream[jj]);
+            assert(event == expected[jj]);
+        }
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
@@ -0,0 +1,205 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Loop unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "com/diag/hazer/loop.h"
+
+typedef struct Tally {
+    int calls;
+    int fd;
+    uint32_t events;
+    ssize_t bytes;
+    int unregister;
+} tally_t;
+
+static void callback(loop_t * lp, int fd, uint32_t events, void * context)
+{
+    tally_t * tp = (tally_t *)context;
+    char buffer[64];
+    ssize_t rc = 0;
+
+    tp->calls += 1;
+    tp->fd = fd;
+    tp->events = events;
+
+    if ((events & LOOP_READ) != 0) {
+        while ((rc = read(fd, buffer, sizeof(buffer))) > 0) {
+            tp->bytes += rc;
+        }
+    }
+
+    if (tp->unregister >= 0) {
+        assert(loop_unregister(lp, tp->unregister) == 0);
+    }
+}
+
+int main(void)
+{
+    {
+        loop_t loop;
+
+        assert(loop_init(&loop, 8) == &loop);
+        assert(loop.epfd >= 0);
+        assert(loop.registered == 0);
+        assert(!loop_registered(&loop, 0));
+        assert(loop_wait(&loop, 0) == 0);
+        loop_fini(&loop);
+        assert(loop.epfd < 0);
+    }
+
+    {
+        loop_t loop;
+        int sv[2] = { -1, -1, };
+        tally_t tally = { 0, -1, 0, 0, -1, };
+
+        assert(loop_init(&loop, 8) == &loop);
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+        assert(fcntl(sv[0], F_SETFL, O_NONBLOCK) == 0);
+
+        assert(loop_register(&loop, sv[0], LOOP_READ, callback, &tally) == 0);
+        assert(loop_registered(&loop, sv[0]));
+        assert(loop.registered == 1);
+        errno = 0;
+        assert(loop_register(&loop, sv[0], LOOP_READ, callback, &tally) < 0);
+        assert(errno == EEXIST);
+
+        assert(loop_wait(&loop, 0) == 0);
+
+        assert(write(sv[1], "ABCDEF", 6) == 6);
+        assert(loop_wait(&loop, 1000) == 1);
+        assert(tally.calls == 1);
+        assert(tally.fd == sv[0]);
+        assert((tally.events & EPOLLIN) != 0);
+        assert(tally.bytes == 6);
+
+        /*
+         * Edge triggered: nothing new, so nothing happens.
+         */
+
+        assert(loop_wait(&loop, 0) == 0);
+        assert(tally.calls == 1);
+
+        /*
+         * Writable is reported once when it is added.
+         */
+
+        assert(loop_modify(&loop, sv[0], LOOP_READ | LOOP_WRITE) == 0);
+        assert(loop_wait(&loop, 1000) == 1);
+        assert(tally.calls == 2);
+        assert((tally.events & EPOLLOUT) != 0);
+        assert(loop_wait(&loop, 0) == 0);
+
+        /*
+         * Closing the peer is reported as readable.
+         */
+
+        assert(close(sv[1]) == 0);
+        assert(loop_wait(&loop, 1000) == 1);
+        assert(tally.calls == 3);
+        assert((tally.events & (EPOLLRDHUP | EPOLLHUP)) != 0);
+
+        assert(loop_unregister(&loop, sv[0]) == 0);
+        assert(!loop_registered(&loop, sv[0]));
+        assert(loop.registered == 0);
+        errno = 0;
+        assert(loop_unregister(&loop, sv[0]) < 0);
+        assert(errno == ENOENT);
+        errno = 0;
+        assert(loop_modify(&loop, sv[0], LOOP_READ) < 0);
+        assert(errno == ENOENT);
+
+        assert(close(sv[0]) == 0);
+        assert(loop.dispatches == 3);
+        loop_fini(&loop);
+    }
+
+    {
+        loop_t loop;
+        int sv[2][2] = { { -1, -1, }, { -1, -1, }, };
+        tally_t tally[2] = { { 0, -1, 0, 0, -1, }, { 0, -1, 0, 0, -1, }, };
+
+        /*
+         * A callback that unregisters another descriptor that is ready in
+         * the same wakeup discards the other descriptor's event.
+         */
+
+        assert(loop_init(&loop, 8) == &loop);
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv[0]) == 0);
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, sv[1]) == 0);
+        assert(fcntl(sv[0][0], F_SETFL, O_NONBLOCK) == 0);
+        assert(fcntl(sv[1][0], F_SETFL, O_NONBLOCK) == 0);
+
+        tally[0].unregister = sv[1][0];
+        tally[1].unregister = sv[0][0];
+        assert(loop_register(&loop, sv[0][0], LOOP_READ, callback, &tally[0]) == 0);
+        assert(loop_register(&loop, sv[1][0], LOOP_READ, callback, &tally[1]) == 0);
+
+        assert(write(sv[0][1], "A", 1) == 1);
+        assert(write(sv[1][1], "B", 1) == 1);
+        assert(loop_wait(&loop, 1000) == 1);
+        assert((tally[0].calls + tally[1].calls) == 1);
+        assert(loop.registered == 1);
+
+        assert(close(sv[0][0]) == 0);
+        assert(close(sv[0][1]) == 0);
+        assert(close(sv[1][0]) == 0);
+        assert(close(sv[1][1]) == 0);
+        loop_fini(&loop);
+    }
+
+    {
+        loop_t loop;
+        int fd[512];
+        int ii = 0;
+        tally_t tally = { 0, -1, 0, 0, -1, };
+
+        /*
+         * The handler array grows to accommodate large descriptors.
+         */
+
+        assert(loop_init(&loop, 4) == &loop);
+        for (ii = 0; ii < (sizeof(fd) / sizeof(fd[0])); ii += 2) {
+            assert(pipe(&(fd[ii])) == 0);
+            assert(fcntl(fd[ii], F_SETFL, O_NONBLOCK) == 0);
+            assert(loop_register(&loop, fd[ii], LOOP_READ, callback, &tally) == 0);
+        }
+        assert(loop.registered == (sizeof(fd) / sizeof(fd[0]) / 2));
+        assert(loop.handlers > fd[(sizeof(fd) / sizeof(fd[0])) - 2]);
+
+        for (ii = 0; ii < (sizeof(fd) / sizeof(fd[0])); ii += 2) {
+            assert(write(fd[ii + 1], "X", 1) == 1);
+        }
+
+        while (tally.calls < (sizeof(fd) / sizeof(fd[0]) / 2)) {
+            assert(loop_wait(&loop, 1000) > 0);
+        }
+        assert(tally.bytes == (sizeof(fd) / sizeof(fd[0]) / 2));
+        assert(loop_wait(&loop, 0) == 0);
+
+        for (ii = 0; ii < (sizeof(fd) / sizeof(fd[0])); ii += 2) {
+            assert(loop_unregister(&loop, fd[ii]) == 0);
+            assert(close(fd[ii]) == 0);
+            assert(close(fd[ii + 1]) == 0);
+        }
+        assert(loop.registered == 0);
+        loop_fini(&loop);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
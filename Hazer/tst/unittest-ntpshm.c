@@ -0,0 +1,103 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the NTP Shared Memory unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * This uses a segment with a key of its own so that it neither needs
+ * privileges nor disturbs an NTP daemon that might be reading the real ones.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <stddef.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include "com/diag/hazer/ntpshm.h"
+
+int main(void)
+{
+    {
+        assert(ntpshm_key(0) == 0x4e545030);
+        assert(ntpshm_key(1) == 0x4e545031);
+        assert(offsetof(ntpshm_time_t, mode) == 0);
+        assert(offsetof(ntpshm_time_t, count) == sizeof(int));
+    }
+
+    {
+        ntpshm_time_t * tp = (ntpshm_time_t *)0;
+        ntpshm_sample_t sample = NTPSHM_SAMPLE_INITIALIZER;
+        ntpshm_sample_t readback = NTPSHM_SAMPLE_INITIALIZER;
+        key_t key = 0;
+        int count = 0;
+
+        key = (key_t)(0x48415a00 ^ getpid());
+        tp = ntpshm_attach(key, 0600);
+        assert(tp != (ntpshm_time_t *)0);
+        assert(tp->mode == NTPSHM_MODE);
+        assert(tp->valid == 0);
+
+        errno = 0;
+        assert(ntpshm_read(tp, &readback) < 0);
+        assert(errno == EAGAIN);
+
+        /*
+         * 2024-02-03T04:05:06.000000000Z received 123.456789ms late.
+         */
+
+        sample.clock = 1706933106000000000LL;
+        sample.receive = sample.clock + 123456789LL;
+        sample.leap = NTPSHM_LEAP_NONE;
+        sample.precision = -20;
+
+        count = tp->count;
+        ntpshm_post(tp, &sample);
+        assert(tp->count == (count + 2));
+        assert(tp->valid == 1);
+        assert(tp->clockTimeStampSec == 1706933106);
+        assert(tp->clockTimeStampUSec == 0);
+        assert(tp->clockTimeStampNSec == 0);
+        assert(tp->receiveTimeStampSec == 1706933106);
+        assert(tp->receiveTimeStampUSec == 123456);
+        assert(tp->receiveTimeStampNSec == 123456789);
+
+        assert(ntpshm_read(tp, &readback) == 0);
+        assert(readback.clock == sample.clock);
+        assert(readback.receive == sample.receive);
+        assert(readback.leap == sample.leap);
+        assert(readback.precision == sample.precision);
+        assert(tp->valid == 0);
+
+        /*
+         * A sample is consumed by reading it.
+         */
+
+        errno = 0;
+        assert(ntpshm_read(tp, &readback) < 0);
+        assert(errno == EAGAIN);
+
+        /*
+         * A writer that has started but not finished an update leaves
+         * valid clear.
+         */
+
+        ntpshm_post(tp, &sample);
+        tp->valid = 0;
+        tp->count += 1;
+        errno = 0;
+        assert(ntpshm_read(tp, &readback) < 0);
+        assert(errno == EAGAIN);
+
+        assert(ntpshm_detach(tp) == (ntpshm_time_t *)0);
+        assert(shmctl(shmget(key, 0, 0), IPC_RMID, (struct shmid_ds *)0) == 0);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
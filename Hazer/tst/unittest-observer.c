@@ -0,0 +1,168 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Observer unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "com/diag/hazer/observer.h"
+
+static size_t slurp(const char * path, char * buffer, size_t size)
+{
+    FILE * fp = (FILE *)0;
+    size_t length = 0;
+
+    assert((fp = fopen(path, "r")) != (FILE *)0);
+    length = fread(buffer, 1, size, fp);
+    assert(fclose(fp) == 0);
+
+    return length;
+}
+
+int main(void)
+{
+    char directory[] = "/tmp/unittest-observer-XXXXXX";
+    char path[sizeof(directory) + 16];
+    char buffer[64];
+    struct stat status;
+
+    assert(mkdtemp(directory) != (char *)0);
+    snprintf(path, sizeof(path), "%s/observation", directory);
+
+    {
+        observer_t observer;
+
+        assert(observer_init(&observer, path, 0644, 8, 0, 0) == &observer);
+        assert(observer_remaining(&observer, 0) < 0);
+        assert(observer_flush(&observer) == 0);
+        assert(observer_poll(&observer, 0) == 0);
+
+        /*
+         * With no interval every datagram is committed.
+         */
+
+        assert(observer_offer(&observer, "ONE", 3, 0) > 0);
+        assert(slurp(path, buffer, sizeof(buffer)) == 3);
+        assert(memcmp(buffer, "ONE", 3) == 0);
+        assert(observer_offer(&observer, "TWO", 3, 0) > 0);
+        assert(slurp(path, buffer, sizeof(buffer)) == 3);
+        assert(memcmp(buffer, "TWO", 3) == 0);
+
+        /*
+         * Datagrams are truncated to the size.
+         */
+
+        assert(observer_offer(&observer, "THREEFOURFIVE", 13, 0) > 0);
+        assert(slurp(path, buffer, sizeof(buffer)) == 8);
+        assert(memcmp(buffer, "THREEFOU", 8) == 0);
+
+        assert(stat(path, &status) == 0);
+        assert((status.st_mode & 0777) == 0644);
+
+        assert(observer.offered == 3);
+        assert(observer.commits == 3);
+        assert(observer.syncs == 0);
+        assert(observer.errors == 0);
+        assert(observer.operations > 0);
+
+        observer_fini(&observer);
+        assert(unlink(path) == 0);
+    }
+
+    {
+        observer_t observer;
+
+        assert(observer_init(&observer, path, 0600, 16, 100, 3) == &observer);
+
+        /*
+         * The first datagram is committed immediately.
+         */
+
+        assert(observer_offer(&observer, "A", 1, 1000) > 0);
+        assert(slurp(path, buffer, sizeof(buffer)) == 1);
+        assert(buffer[0] == 'A');
+        assert(observer_remaining(&observer, 1000) < 0);
+
+        /*
+         * Datagrams within the interval are held, each replacing the last.
+         */
+
+        assert(observer_offer(&observer, "B", 1, 1010) == 0);
+        assert(observer_offer(&observer, "C", 1, 1050) == 0);
+        assert(observer_remaining(&observer, 1050) == 50);
+        assert(observer_poll(&observer, 1099) == 0);
+        assert(slurp(path, buffer, sizeof(buffer)) == 1);
+        assert(buffer[0] == 'A');
+
+        /*
+         * The latest is committed when the interval expires.
+         */
+
+        assert(observer_remaining(&observer, 1100) == 0);
+        assert(observer_poll(&observer, 1100) > 0);
+        assert(slurp(path, buffer, sizeof(buffer)) == 1);
+        assert(buffer[0] == 'C');
+        assert(observer_poll(&observer, 2000) == 0);
+
+        /*
+         * A datagram after a quiet period is committed immediately, and
+         * every third commit is synchronized.
+         */
+
+        assert(observer_offer(&observer, "D", 1, 2000) > 0);
+        assert(observer.syncs == 1);
+        assert(observer_offer(&observer, "E", 1, 2001) == 0);
+        assert(observer_flush(&observer) > 0);
+        assert(slurp(path, buffer, sizeof(buffer)) == 1);
+        assert(buffer[0] == 'E');
+        assert(observer_flush(&observer) == 0);
+
+        assert(stat(path, &status) == 0);
+        assert((status.st_mode & 0777) == 0600);
+
+        assert(observer.offered == 5);
+        assert(observer.commits == 4);
+        assert(observer.syncs == 1);
+        assert(observer.errors == 0);
+
+        observer_fini(&observer);
+        assert(unlink(path) == 0);
+    }
+
+    {
+        observer_t observer;
+        char missing[sizeof(path) + 16];
+
+        /*
+         * A commit that fails discards the datagram and leaves no temporary
+         * file behind.
+         */
+
+        snprintf(missing, sizeof(missing), "%s/missing/observation", directory);
+        assert(observer_init(&observer, missing, 0644, 16, 0, 0) == &observer);
+        errno = 0;
+        assert(observer_offer(&observer, "F", 1, 0) < 0);
+        assert(errno == ENOENT);
+        assert(observer_remaining(&observer, 0) < 0);
+        assert(observer.commits == 0);
+        assert(observer.errors == 1);
+        observer_fini(&observer);
+    }
+
+    assert(rmdir(directory) == 0);
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
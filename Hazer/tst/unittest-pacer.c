@@ -0,0 +1,170 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Pacer unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include "com/diag/hazer/pacer.h"
+
+static int64_t now(void)
+{
+    struct timespec here;
+
+    clock_gettime(CLOCK_MONOTONIC, &here);
+
+    return ((int64_t)here.tv_sec * 1000000000LL) + here.tv_nsec;
+}
+
+int main(void)
+{
+    {
+        pacer_t pacer;
+
+        errno = 0;
+        assert(pacer_init(&pacer, -1.0) == (pacer_t *)0);
+        assert(errno == EINVAL);
+        assert(pacer_init(&pacer, 0.0) == &pacer);
+        assert(pacer_percentile(&pacer, 50.0) == 0);
+    }
+
+    {
+        pacer_t pacer;
+        int64_t before = 0;
+        int64_t after = 0;
+        int ii = 0;
+
+        /*
+         * As fast as possible: a thousand seconds go by at once.
+         */
+
+        assert(pacer_init(&pacer, 0.0) == &pacer);
+        before = now();
+        for (ii = 0; ii < 1000; ++ii) {
+            assert(pacer_wait(&pacer, 1000000000LL * ii) == 0);
+        }
+        after = now();
+        assert((after - before) < 1000000000LL);
+        assert(pacer.items == 1000);
+        assert(pacer.sleeps == 0);
+        assert(pacer_percentile(&pacer, 99.0) == 0);
+    }
+
+    {
+        pacer_t pacer;
+        int64_t base = 0;
+        int64_t before = 0;
+        int64_t after = 0;
+        int64_t deadline = 0;
+        int ii = 0;
+
+        /*
+         * A hundred times faster: two seconds of items every 10ms take
+         * twenty milliseconds, and each deadline is measured from the first
+         * item, not from the prior one, even when items are processed
+         * slowly.
+         */
+
+        assert(pacer_init(&pacer, 100.0) == &pacer);
+        base = 123456789000LL;
+        before = now();
+        for (ii = 0; ii <= 200; ++ii) {
+            (void)pacer_wait(&pacer, base + (10000000LL * ii));
+            if ((ii % 50) == 0) {
+                struct timespec busy = { 0, 50000 };
+                (void)nanosleep(&busy, (struct timespec *)0);
+            }
+        }
+        after = now();
+        assert(pacer.items == 201);
+        assert(pacer.sleeps > 0);
+        assert((after - before) >= 20000000LL);
+        assert((after - before) < 1000000000LL);
+        deadline = pacer_deadline(&pacer, base + 1000000000LL);
+        assert(deadline == (pacer.start + 10000000LL));
+        deadline = pacer_deadline(&pacer, base - 1000000000LL);
+        assert(deadline == pacer.start);
+        assert(pacer_percentile(&pacer, 0.0) <= pacer_percentile(&pacer, 50.0));
+        assert(pacer_percentile(&pacer, 50.0) <= pacer_percentile(&pacer, 99.0));
+        assert(pacer_percentile(&pacer, 100.0) <= pacer.latest);
+
+        /*
+         * Restarting makes the next item the first.
+         */
+
+        pacer_restart(&pacer);
+        before = now();
+        assert(pacer_wait(&pacer, 0) >= 0);
+        assert(pacer.first == 0);
+        assert(pacer.start >= before);
+        assert(pacer.items == 202);
+    }
+
+    {
+        pacer_t pacer;
+        uint64_t value = 0;
+        uint64_t estimate = 0;
+        int ii = 0;
+
+        /*
+         * The percentiles are estimated from the histogram to within a few
+         * percent, whatever their magnitude.
+         */
+
+        for (value = 1; value < 1000000000000ULL; value = (value * 3) + 1) {
+            assert(pacer_init(&pacer, 1.0) == &pacer);
+            for (ii = 0; ii < 99; ++ii) {
+                pacer_account(&pacer, value);
+            }
+            pacer_account(&pacer, value * 10);
+            estimate = pacer_percentile(&pacer, 50.0);
+            assert(estimate >= (value - (value / 32)));
+            assert(estimate <= (value + (value / 32)));
+            assert(pacer_percentile(&pacer, 99.0) == estimate);
+            assert(pacer_percentile(&pacer, 100.0) >= ((value * 10) - (value * 10 / 32)));
+            assert(pacer_percentile(&pacer, 100.0) <= pacer.latest);
+            assert(pacer.latest == (value * 10));
+            assert(pacer.total == ((value * 99) + (value * 10)));
+        }
+
+        assert(pacer_init(&pacer, 1.0) == &pacer);
+        pacer_account(&pacer, UINT64_MAX);
+        assert(pacer_percentile(&pacer, 50.0) >= (UINT64_MAX - (UINT64_MAX / 32)));
+    }
+
+    {
+        static const char DATA[] = "$GNGGA,000000.00,,,,,0,00,99.99,,,,,,*56\r\n";
+        char buffer[sizeof(DATA)];
+        int fds[2] = { -1, -1 };
+
+        /*
+         * An item is written whole, and a write that fails is reported.
+         */
+
+        assert(pipe(fds) == 0);
+        assert(pacer_write(fds[1], DATA, sizeof(DATA) - 1) == 0);
+        assert(pacer_write(fds[1], DATA, 0) == 0);
+        assert(read(fds[0], buffer, sizeof(buffer)) == (sizeof(DATA) - 1));
+        assert(memcmp(buffer, DATA, sizeof(DATA) - 1) == 0);
+        assert(close(fds[1]) == 0);
+        errno = 0;
+        assert(pacer_write(fds[1], DATA, sizeof(DATA) - 1) < 0);
+        assert(errno == EBADF);
+        assert(close(fds[0]) == 0);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
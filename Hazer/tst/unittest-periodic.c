@@ -0,0 +1,147 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the gpstool Periodic unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The periodic timers are part of gpstool rather than the library, so the
+ * Makefile links this test with app/gpstool/periodic.c. The last part of
+ * the test is a regression test: it runs a loop shaped like the bottom of
+ * the gpstool main loop with input that is always buffered, so that the
+ * loop never reaches its multiplexor, and checks that the bypass and the
+ * one hertz timers still fire.
+ */
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <assert.h>
+#include "../app/gpstool/periodic.h"
+
+static int64_t now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((int64_t)ts.tv_sec * 1000000000LL) + ts.tv_nsec;
+}
+
+int main(void)
+{
+    {
+        periodic_t never = PERIODIC_INITIALIZER;
+        periodic_t always = PERIODIC_INITIALIZER;
+        periodic_t * const timers[] = { &never, &always, };
+
+        assert(periodic_init(&never, -1, 0) < 0);
+        assert(periodic_init(&always, 0, 0) < 0);
+        assert(!periodic_expired(&never));
+        assert(periodic_expired(&always));
+        assert(periodic_expired(&always));
+        assert(periodic_ready(timers, sizeof(timers) / sizeof(timers[0])) < 0);
+        assert(!periodic_service(&never, 0));
+        periodic_fini(&never);
+        periodic_fini(&always);
+    }
+
+    {
+        periodic_t immediate = PERIODIC_INITIALIZER;
+        periodic_t later = PERIODIC_INITIALIZER;
+        periodic_t * const timers[] = { &later, &immediate, };
+        int fd = -1;
+
+        /*
+         * An expired timer stays ready until it is serviced, and only a
+         * service latches an expiration.
+         */
+
+        assert(periodic_init(&immediate, 3600, !0) >= 0);
+        assert(periodic_init(&later, 3600, 0) >= 0);
+        usleep(1000);
+        assert((fd = periodic_ready(timers, 2)) == immediate.fd);
+        assert(periodic_ready(timers, 2) == immediate.fd);
+        assert(!periodic_expired(&immediate));
+        assert(!periodic_service(&later, fd));
+        assert(periodic_service(&immediate, fd));
+        assert(immediate.expirations == 1);
+        assert(periodic_ready(timers, 2) < 0);
+        assert(periodic_service(&immediate, fd));
+        assert(immediate.expirations == 1);
+        assert(periodic_expired(&immediate));
+        assert(!periodic_expired(&immediate));
+        assert(!periodic_expired(&later));
+        periodic_fini(&immediate);
+        periodic_fini(&later);
+        assert(immediate.fd < 0);
+    }
+
+    {
+        periodic_t onehz = PERIODIC_INITIALIZER;
+        periodic_t bypass = PERIODIC_INITIALIZER;
+        periodic_t * const timers[] = { &onehz, &bypass, };
+        int64_t start = 0;
+        int64_t polled = 0;
+        int64_t current = 0;
+        unsigned long consumed = 0;
+        unsigned int renders = 0;
+        unsigned int ticks = 0;
+        int timer_fd = -1;
+        int fd = -1;
+
+        /*
+         * Saturated input: there is always another buffered sentence, so
+         * without asking the timers directly this loop would never render.
+         */
+
+        assert(periodic_init(&onehz, 1, 0) >= 0);
+        assert(periodic_init(&bypass, 1, 0) >= 0);
+
+        start = polled = now();
+        while (((current = now()) - start) < 2500000000LL) {
+
+            timer_fd = -1;
+            if ((current - polled) >= (1000000000LL / PERIODIC_POLLS)) {
+                polled = current;
+                timer_fd = periodic_ready(timers, 2);
+            }
+
+            if (periodic_expired(&bypass)) {
+                renders += 1;
+                continue;
+            } else if (timer_fd >= 0) {
+                fd = timer_fd;
+            } else {
+                consumed += 1;
+                continue;
+            }
+
+            if (periodic_service(&onehz, fd)) {
+                ticks += 1;
+            } else if (periodic_service(&bypass, fd)) {
+                /* Do nothing. */
+            } else {
+                assert(0);
+            }
+
+        }
+
+        fprintf(stderr, "%s: consumed=%lu renders=%u ticks=%u\n", __FILE__, consumed, renders, ticks);
+
+        assert(consumed > 0);
+        assert(renders == 2);
+        assert(ticks == 2);
+        assert(onehz.expirations == 2);
+        assert(bypass.expirations == 2);
+
+        periodic_fini(&onehz);
+        periodic_fini(&bypass);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Pulse unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * This includes a simple edge simulator: a table of edge offsets from the
+ * top of each UTC second, as a 1PPS capture mechanism might have produced
+ * them, which is fed through the ring one edge at a time while the UTC
+ * time that each edge marks is reported the way gpstool reports it.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "com/diag/diminuto/diminuto_countof.h"
+#include "com/diag/hazer/pulse.h"
+
+/*
+ * 2024-01-01T00:00:00Z.
+ */
+static const pulse_nanoseconds_t EPOCH = 1704067200LL * 1000000000LL;
+
+/*
+ * Simulated edge offsets in nanoseconds: a fixed latency of 10us plus or
+ * minus 2us of jitter.
+ */
+static const pulse_nanoseconds_t OFFSET[] = {
+    10000, 12000, 8000, 10000, 12000, 8000, 10000, 12000, 8000, 10000,
+    12000, 8000, 10000, 12000, 8000, 10000, 12000, 8000, 10000, 12000,
+    8000, 10000, 12000, 8000,
+};
+
+int main(void)
+{
+    {
+        assert(sizeof(pulse_nanoseconds_t) == 8);
+        assert(sizeof(pulse_edge_t) == 24);
+        assert((PULSE_EDGES & (PULSE_EDGES - 1)) == 0);
+        assert(PULSE_SECOND == 1000000000LL);
+    }
+
+    {
+        pulse_ring_t ring = PULSE_RING_INITIALIZER;
+        const pulse_edge_t * ep = (const pulse_edge_t *)0;
+
+        assert(pulse_ring_get(&ring, 0) == (const pulse_edge_t *)0);
+        assert(pulse_ring_nearest(&ring, EPOCH, PULSE_SECOND / 2) == (const pulse_edge_t *)0);
+
+        assert(pulse_ring_put(&ring, EPOCH, 1000, PULSE_SOURCE_SIMULATED) == 1);
+        assert(pulse_ring_put(&ring, EPOCH + PULSE_SECOND, 1000 + PULSE_SECOND, PULSE_SOURCE_SIMULATED) == 2);
+
+        assert((ep = pulse_ring_get(&ring, 0)) != (const pulse_edge_t *)0);
+        assert(ep->sequence == 2);
+        assert(ep->realtime == (EPOCH + PULSE_SECOND));
+        assert(ep->source == PULSE_SOURCE_SIMULATED);
+        assert((ep = pulse_ring_get(&ring, 1)) != (const pulse_edge_t *)0);
+        assert(ep->sequence == 1);
+        assert(pulse_ring_get(&ring, 2) == (const pulse_edge_t *)0);
+        assert(pulse_ring_get(&ring, PULSE_EDGES) == (const pulse_edge_t *)0);
+
+        assert((ep = pulse_ring_nearest(&ring, EPOCH + 100, PULSE_SECOND / 2)) != (const pulse_edge_t *)0);
+        assert(ep->sequence == 1);
+        assert((ep = pulse_ring_nearest(&ring, EPOCH + PULSE_SECOND - 100, PULSE_SECOND / 2)) != (const pulse_edge_t *)0);
+        assert(ep->sequence == 2);
+        assert(pulse_ring_nearest(&ring, EPOCH + (3 * PULSE_SECOND), PULSE_SECOND / 2) == (const pulse_edge_t *)0);
+    }
+
+    {
+        pulse_ring_t ring = PULSE_RING_INITIALIZER;
+        unsigned int ii = 0;
+
+        for (ii = 0; ii < (3 * PULSE_EDGES); ++ii) {
+            pulse_ring_put(&ring, EPOCH + (ii * PULSE_SECOND), ii * PULSE_SECOND, PULSE_SOURCE_SIMULATED);
+        }
+
+        assert(ring.sequence == (3 * PULSE_EDGES));
+        assert(pulse_ring_get(&ring, 0)->sequence == (3 * PULSE_EDGES));
+        assert(pulse_ring_get(&ring, PULSE_EDGES - 1)->sequence == ((2 * PULSE_EDGES) + 1));
+        assert(pulse_ring_nearest(&ring, EPOCH, PULSE_SECOND / 2) == (const pulse_edge_t *)0);
+    }
+
+    {
+        pulse_ring_t ring = PULSE_RING_INITIALIZER;
+        pulse_statistics_t stats = PULSE_STATISTICS_INITIALIZER;
+        pulse_nanoseconds_t utc = 0;
+        pulse_nanoseconds_t sum = 0;
+        double mean = 0.0;
+        double variance = 0.0;
+        unsigned int ii = 0;
+
+        assert(pulse_jitter(&stats) == 0.0);
+
+        for (ii = 0; ii < diminuto_countof(OFFSET); ++ii) {
+            utc = EPOCH + (ii * PULSE_SECOND);
+            pulse_ring_put(&ring, utc + OFFSET[ii], 5000 + utc + OFFSET[ii] - EPOCH, PULSE_SOURCE_SIMULATED);
+            /*
+             * The receiver reports the second more than once (e.g. in RMC
+             * and in GGA); the edge must only be measured the first time.
+             */
+            assert(pulse_measure(&stats, &ring, utc) == 0);
+            assert(pulse_measure(&stats, &ring, utc) < 0);
+            assert(stats.offset == OFFSET[ii]);
+            if (ii > 0) {
+                assert(stats.period == (PULSE_SECOND + OFFSET[ii] - OFFSET[ii - 1]));
+            }
+            sum += OFFSET[ii];
+        }
+
+        mean = (double)sum / diminuto_countof(OFFSET);
+        for (ii = 0; ii < diminuto_countof(OFFSET); ++ii) {
+            variance += (OFFSET[ii] - mean) * (OFFSET[ii] - mean);
+        }
+        variance /= (diminuto_countof(OFFSET) - 1);
+
+        fprintf(stderr, "count=%llu offset=%lld minimum=%lld maximum=%lld mean=%f jitter=%f expected=%f\n", (unsigned long long)stats.count, (long long)stats.offset, (long long)stats.minimum, (long long)stats.maximum, stats.mean, pulse_jitter(&stats), sqrt(variance));
+
+        assert(stats.count == diminuto_countof(OFFSET));
+        assert(stats.minimum == 8000);
+        assert(stats.maximum == 12000);
+        assert(fabs(stats.mean - mean) < 0.001);
+        assert(fabs(pulse_jitter(&stats) - sqrt(variance)) < 0.001);
+
+        /*
+         * A UTC time with no edge within half a second is not measured.
+         */
+
+        assert(pulse_measure(&stats, &ring, utc + (2 * PULSE_SECOND)) < 0);
+        assert(stats.count == diminuto_countof(OFFSET));
+    }
+
+    {
+        pulse_ring_t ring = PULSE_RING_INITIALIZER;
+        pulse_statistics_t stats = PULSE_STATISTICS_INITIALIZER;
+        pulse_nanoseconds_t utc = 0;
+        unsigned int ii = 0;
+
+        /*
+         * Several edges arrive between measurements, and the only UTC time
+         * at hand is that of the next edge, which hasn't happened yet. Each
+         * edge is still measured once, oldest first, against its own second.
+         */
+
+        assert(pulse_measure_next(&stats, &ring, EPOCH) < 0);
+
+        for (ii = 0; ii < 3; ++ii) {
+            utc = EPOCH + (ii * PULSE_SECOND);
+            pulse_ring_put(&ring, utc + OFFSET[ii], 5000 + utc + OFFSET[ii] - EPOCH, PULSE_SOURCE_SIMULATED);
+        }
+
+        for (ii = 0; ii < 3; ++ii) {
+            assert(pulse_measure_next(&stats, &ring, EPOCH + (3 * PULSE_SECOND)) == 0);
+            assert(stats.sequence == (ii + 1));
+            assert(stats.offset == OFFSET[ii]);
+        }
+        assert(pulse_measure_next(&stats, &ring, EPOCH + (3 * PULSE_SECOND)) < 0);
+        assert(stats.count == 3);
+
+        /*
+         * An older UTC time works as well, and edges already measured are
+         * not measured again.
+         */
+
+        for (ii = 3; ii < 5; ++ii) {
+            utc = EPOCH + (ii * PULSE_SECOND);
+            pulse_ring_put(&ring, utc + OFFSET[ii], 5000 + utc + OFFSET[ii] - EPOCH, PULSE_SOURCE_SIMULATED);
+        }
+
+        assert(pulse_measure_next(&stats, &ring, EPOCH) == 0);
+        assert(stats.offset == OFFSET[3]);
+        assert(pulse_measure_next(&stats, &ring, EPOCH) == 0);
+        assert(stats.offset == OFFSET[4]);
+        assert(pulse_measure_next(&stats, &ring, EPOCH) < 0);
+        assert(stats.count == 5);
+        assert(stats.period == (PULSE_SECOND + OFFSET[4] - OFFSET[3]));
+    }
+
+    return 0;
+}
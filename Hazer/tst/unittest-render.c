@@ -0,0 +1,148 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Render unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <assert.h>
+#include "com/diag/hazer/render.h"
+
+int main(void)
+{
+    {
+        char buffer[64];
+        char * bp = (char *)0;
+
+        bp = render_unsigned(buffer, 0); *bp = '\0';
+        assert(strcmp(buffer, "0") == 0);
+        bp = render_unsigned(buffer, 9); *bp = '\0';
+        assert(strcmp(buffer, "9") == 0);
+        bp = render_unsigned(buffer, 10); *bp = '\0';
+        assert(strcmp(buffer, "10") == 0);
+        bp = render_unsigned(buffer, 100); *bp = '\0';
+        assert(strcmp(buffer, "100") == 0);
+        bp = render_unsigned(buffer, UINT64_MAX); *bp = '\0';
+        assert(strcmp(buffer, "18446744073709551615") == 0);
+        assert((bp - buffer) == RENDER_DIGITS);
+
+        bp = render_signed(buffer, 0); *bp = '\0';
+        assert(strcmp(buffer, "0") == 0);
+        bp = render_signed(buffer, -1); *bp = '\0';
+        assert(strcmp(buffer, "-1") == 0);
+        bp = render_signed(buffer, INT64_MIN); *bp = '\0';
+        assert(strcmp(buffer, "-9223372036854775808") == 0);
+        bp = render_signed(buffer, INT64_MAX); *bp = '\0';
+        assert(strcmp(buffer, "9223372036854775807") == 0);
+
+        bp = render_zeros(buffer, 0, 0); *bp = '\0';
+        assert(strcmp(buffer, "0") == 0);
+        bp = render_zeros(buffer, 7, 3); *bp = '\0';
+        assert(strcmp(buffer, "007") == 0);
+        bp = render_zeros(buffer, 12345, 3); *bp = '\0';
+        assert(strcmp(buffer, "12345") == 0);
+        bp = render_zeros(buffer, 1, 99); *bp = '\0';
+        assert(strcmp(buffer, "00000000000000000001") == 0);
+
+        bp = render_fixed(buffer, 0, 0); *bp = '\0';
+        assert(strcmp(buffer, "0.") == 0);
+        bp = render_fixed(buffer, -12, 0); *bp = '\0';
+        assert(strcmp(buffer, "-12.") == 0);
+        bp = render_fixed(buffer, 397943071, 7); *bp = '\0';
+        assert(strcmp(buffer, "39.7943071") == 0);
+        bp = render_fixed(buffer, -5, 7); *bp = '\0';
+        assert(strcmp(buffer, "-0.0000005") == 0);
+        bp = render_fixed(buffer, INT64_MIN, RENDER_POWERS); *bp = '\0';
+        assert(strcmp(buffer, "-0.9223372036854775808") == 0);
+        assert((bp - buffer) <= RENDER_FIXED + 1);
+
+        bp = render_fixed(buffer, -5, 1);
+        bp = render_right(buffer, bp, 6); *bp = '\0';
+        assert(strcmp(buffer, "  -0.5") == 0);
+        bp = render_fixed(buffer, -5, 1);
+        bp = render_right(buffer, bp, 2); *bp = '\0';
+        assert(strcmp(buffer, "-0.5") == 0);
+
+        bp = render_left(buffer, "GPS", 8); *bp = '\0';
+        assert(strcmp(buffer, "GPS     ") == 0);
+        bp = render_left(buffer, "GLONASSXYZ", 8); *bp = '\0';
+        assert(strcmp(buffer, "GLONASSX") == 0);
+
+        bp = render_string(buffer, "POS");
+        bp = render_char(bp, ' ');
+        bp = render_string(bp, ""); *bp = '\0';
+        assert(strcmp(buffer, "POS ") == 0);
+    }
+
+    {
+        char buffer[64];
+        char expected[64];
+        char * bp = (char *)0;
+        int ii = 0;
+        int jj = 0;
+        int64_t value = 0;
+        int digits = 0;
+        uint64_t power = 0;
+
+        /*
+         * Compare against printf(3) for many values and precisions.
+         */
+
+        srandom(1);
+
+        for (ii = 0; ii < 1000000; ++ii) {
+            value = ((int64_t)random() << 32) ^ random();
+            value >>= (random() % 63);
+            if ((random() % 2) != 0) { value = -value; }
+            digits = random() % 10;
+            for (power = 1, jj = 0; jj < digits; ++jj) {
+                power *= 10;
+            }
+            if (digits == 0) {
+                snprintf(expected, sizeof(expected), "%s%llu.", (value < 0) ? "-" : "", (unsigned long long)((value < 0) ? -(uint64_t)value : (uint64_t)value));
+            } else {
+                snprintf(expected, sizeof(expected), "%s%llu.%0*llu", (value < 0) ? "-" : "", (unsigned long long)(((value < 0) ? -(uint64_t)value : (uint64_t)value) / power), digits, (unsigned long long)(((value < 0) ? -(uint64_t)value : (uint64_t)value) % power));
+            }
+            bp = render_fixed(buffer, value, digits); *bp = '\0';
+            assert(strcmp(buffer, expected) == 0);
+            snprintf(expected, sizeof(expected), "%lld", (long long)value);
+            bp = render_signed(buffer, value); *bp = '\0';
+            assert(strcmp(buffer, expected) == 0);
+        }
+    }
+
+    {
+        char buffer[64];
+        char * bp = (char *)0;
+
+        /*
+         * In the C locale the degree symbol cannot be represented, but in a
+         * UTF-8 locale it is two bytes.
+         */
+
+        bp = render_string(buffer, "A");
+        bp = render_wide(bp, 0xb0);
+        bp = render_string(bp, "B"); *bp = '\0';
+        assert((strcmp(buffer, "AB") == 0) || (strcmp(buffer, "A\xb0" "B") == 0));
+
+        if (setlocale(LC_ALL, "C.UTF-8") != (char *)0) {
+            bp = render_string(buffer, "A");
+            bp = render_wide(bp, 0xb0);
+            bp = render_string(bp, "B"); *bp = '\0';
+            assert(strcmp(buffer, "A\xc2\xb0" "B") == 0);
+        }
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
@@ -0,0 +1,186 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Simplify unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "com/diag/hazer/simplify.h"
+
+enum {
+    COUNT = 10000,
+};
+
+static simplify_point_t points[COUNT];
+static uint8_t keep[COUNT];
+static uint8_t expected[COUNT];
+
+static uint32_t seed = 1;
+
+static double noise(void)
+{
+    seed = (seed * 1103515245UL) + 12345UL;
+    return (((seed >> 16) & 0x7fff) / 32768.0) - 0.5;
+}
+
+/*
+ * This is the textbook recursive algorithm against which the one in the
+ * module is checked.
+ */
+static void reference(const simplify_point_t * pp, size_t first, size_t last, double tolerance, uint8_t * kp)
+{
+    size_t ii = 0;
+    size_t farthest = first;
+    double distance = 0.0;
+    double maximum = -1.0;
+
+    for (ii = first + 1; ii < last; ++ii) {
+        distance = simplify_distance(&(pp[ii]), &(pp[first]), &(pp[last]));
+        if (distance > maximum) {
+            maximum = distance;
+            farthest = ii;
+        }
+    }
+
+    if (maximum > tolerance) {
+        kp[farthest] = !0;
+        reference(pp, first, farthest, tolerance, kp);
+        reference(pp, farthest, last, tolerance, kp);
+    }
+}
+
+int main(void)
+{
+    static const double METERS = SIMPLIFY_RADIUS * M_PI / 180.0;
+    simplify_point_t aa = { 0.0, 0.0 };
+    simplify_point_t bb = { 0.0, 0.0 };
+    simplify_point_t pp = { 0.0, 0.0 };
+    ssize_t kept = 0;
+    ssize_t count = 0;
+    size_t ii = 0;
+    double tolerance = 0.0;
+    double distance = 0.0;
+
+    {
+        aa.latitude = 39.794; aa.longitude = -105.153;
+        bb.latitude = 39.794; bb.longitude = -105.153;
+        pp.latitude = 40.794; pp.longitude = -105.153;
+        distance = simplify_distance(&pp, &aa, &bb);
+        fprintf(stderr, "%s: degenerate=%.3f\n", __FILE__, distance);
+        assert(fabs(distance - METERS) < 0.001);
+    }
+
+    {
+        aa.latitude = 0.0; aa.longitude = 0.0;
+        bb.latitude = 0.0; bb.longitude = 1.0;
+        pp.latitude = 0.001; pp.longitude = 0.5;
+        distance = simplify_distance(&pp, &aa, &bb);
+        fprintf(stderr, "%s: perpendicular=%.3f\n", __FILE__, distance);
+        assert(fabs(distance - (0.001 * METERS)) < 0.001);
+        pp.latitude = 0.0; pp.longitude = 0.25;
+        assert(simplify_distance(&pp, &aa, &bb) < 0.001);
+        pp.latitude = 0.0; pp.longitude = 1.5;
+        distance = simplify_distance(&pp, &aa, &bb);
+        fprintf(stderr, "%s: beyond=%.3f\n", __FILE__, distance);
+        assert(fabs(distance - (0.5 * METERS)) < 0.001);
+        pp.latitude = 0.0; pp.longitude = -0.5;
+        assert(fabs(simplify_distance(&pp, &aa, &bb) - (0.5 * METERS)) < 0.001);
+    }
+
+    {
+        aa.latitude = 0.0; aa.longitude = 179.9;
+        bb.latitude = 0.0; bb.longitude = -179.9;
+        pp.latitude = 0.001; pp.longitude = 180.0;
+        distance = simplify_distance(&pp, &aa, &bb);
+        fprintf(stderr, "%s: antimeridian=%.3f\n", __FILE__, distance);
+        assert(fabs(distance - (0.001 * METERS)) < 0.001);
+    }
+
+    {
+        assert(simplify_path(points, 0, 1.0, keep) == 0);
+        keep[0] = 0;
+        assert(simplify_path(points, 1, 1.0, keep) == 1);
+        assert(keep[0]);
+        keep[0] = keep[1] = 0;
+        assert(simplify_path(points, 2, 1.0, keep) == 2);
+        assert(keep[0] && keep[1]);
+    }
+
+    /*
+     * A straight line sampled often, wandering by well under a meter,
+     * simplifies to its ends.
+     */
+
+    {
+        for (ii = 0; ii < COUNT; ++ii) {
+            points[ii].latitude = 39.794 + (ii * 0.00001) + (noise() * 0.000001);
+            points[ii].longitude = -105.153 + (ii * 0.00001) + (noise() * 0.000001);
+        }
+        kept = simplify_path(points, COUNT, 1.0, keep);
+        fprintf(stderr, "%s: straight=%zd\n", __FILE__, kept);
+        assert(kept == 2);
+        assert(keep[0]);
+        assert(keep[COUNT - 1]);
+    }
+
+    /*
+     * A square simplifies to its corners.
+     */
+
+    {
+        for (ii = 0; ii < 100; ++ii) {
+            points[ii].latitude = 39.794 + ((ii < 25) ? ii : (ii < 50) ? 25 : (ii < 75) ? (75 - ii) : 0) * 0.0001;
+            points[ii].longitude = -105.153 + ((ii < 25) ? 0 : (ii < 50) ? (ii - 25) : (ii < 75) ? 25 : (100 - ii)) * 0.0001;
+        }
+        points[99] = points[0];
+        kept = simplify_path(points, 100, 0.5, keep);
+        fprintf(stderr, "%s: square=%zd\n", __FILE__, kept);
+        assert(kept == 5);
+        assert(keep[0] && keep[25] && keep[50] && keep[75] && keep[99]);
+    }
+
+    /*
+     * A random walk simplifies to exactly what the recursive algorithm
+     * keeps, and keeps fewer points as the tolerance grows.
+     */
+
+    {
+        points[0].latitude = 39.794;
+        points[0].longitude = -105.153;
+        for (ii = 1; ii < COUNT; ++ii) {
+            points[ii].latitude = points[ii - 1].latitude + (noise() * 0.0001);
+            points[ii].longitude = points[ii - 1].longitude + (noise() * 0.0001);
+        }
+        for (tolerance = 0.0; tolerance <= 100.0; tolerance = (tolerance * 2.0) + 1.0) {
+            kept = simplify_path(points, COUNT, tolerance, keep);
+            memset(expected, 0, sizeof(expected));
+            expected[0] = !0;
+            expected[COUNT - 1] = !0;
+            reference(points, 0, COUNT - 1, tolerance, expected);
+            assert(memcmp(keep, expected, sizeof(keep)) == 0);
+            fprintf(stderr, "%s: tolerance=%.0f kept=%zd\n", __FILE__, tolerance, kept);
+            assert(kept >= 2);
+            assert(kept <= COUNT);
+            if (tolerance > 0.0) {
+                assert(kept <= count);
+            }
+            for (ii = 0, count = 0; ii < COUNT; ++ii) {
+                if (keep[ii]) { count += 1; }
+            }
+            assert(count == kept);
+        }
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
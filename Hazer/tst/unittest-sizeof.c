@@ -12,10 +12,24 @@
 #include <stdio.h>
 #include <errno.h>
 #include "com/diag/hazer/common.h"
+#include "com/diag/hazer/archive.h"
+#include "com/diag/hazer/capture.h"
 #include "com/diag/hazer/coordinates.h"
 #include "com/diag/hazer/datagram.h"
+#include "com/diag/hazer/framer.h"
 #include "com/diag/hazer/hazer.h"
+#include "com/diag/hazer/loop.h"
+#include "com/diag/hazer/ntpshm.h"
+#include "com/diag/hazer/observer.h"
+#include "com/diag/hazer/pacer.h"
+#include "com/diag/hazer/pulse.h"
+#include "com/diag/hazer/simplify.h"
+#include "com/diag/hazer/snapshot.h"
+#include "com/diag/hazer/statistics.h"
+#include "com/diag/hazer/subscription.h"
+#include "com/diag/hazer/trace.h"
 #include "com/diag/hazer/tumbleweed.h"
+#include "com/diag/hazer/writer.h"
 #include "com/diag/hazer/yodel.h"
 #include "./unittest.h"
 
@@ -28,10 +42,27 @@ int main(void)
     hazer_actives_t active;
     hazer_views_t view;
 
+    PRINTSIZEOF(archive_chunk_t);
+    PRINTSIZEOF(archive_header_t);
+    PRINTSIZEOF(archive_t);
+    PRINTSIZEOF(archive_zone_t);
+    PRINTSIZEOF(capture_count_t);
+    PRINTSIZEOF(capture_header_t);
+    PRINTSIZEOF(capture_index_t);
+    PRINTSIZEOF(capture_protocol_t);
+    PRINTSIZEOF(capture_record_t);
+    PRINTSIZEOF(capture_t);
+    PRINTSIZEOF(capture_trailer_t);
     PRINTSIZEOF(coordinates_format_t);
+    PRINTSIZEOF(datagram_batch_t);
     PRINTSIZEOF(datagram_buffer_t);
     PRINTSIZEOF(datagram_header_t);
+    PRINTSIZEOF(datagram_packer_t);
+    PRINTSIZEOF(datagram_reorder_t);
     PRINTSIZEOF(datagram_sequence_t);
+    PRINTSIZEOF(datagram_unpacker_t);
+    PRINTSIZEOF(framer_event_t);
+    PRINTSIZEOF(framer_t);
     PRINTSIZEOF(hazer_action_t);
     PRINTSIZEOF(hazer_active_t);
     PRINTSIZEOF(hazer_band_t);
@@ -47,9 +78,32 @@ int main(void)
     PRINTSIZEOF(hazer_system_t);
     PRINTSIZEOF(hazer_talker_t);
     PRINTSIZEOF(hazer_view_t);
+    PRINTSIZEOF(loop_handler_t);
+    PRINTSIZEOF(loop_t);
+    PRINTSIZEOF(ntpshm_sample_t);
+    PRINTSIZEOF(ntpshm_time_t);
+    PRINTSIZEOF(observer_t);
+    PRINTSIZEOF(pacer_t);
+    PRINTSIZEOF(pulse_edge_t);
+    PRINTSIZEOF(pulse_nanoseconds_t);
+    PRINTSIZEOF(pulse_ring_t);
+    PRINTSIZEOF(pulse_statistics_t);
+    PRINTSIZEOF(simplify_point_t);
+    PRINTSIZEOF(snapshot_band_t);
+    PRINTSIZEOF(snapshot_fix_t);
+    PRINTSIZEOF(snapshot_region_t);
+    PRINTSIZEOF(statistics_t);
+    PRINTSIZEOF(subscription_entry_t);
+    PRINTSIZEOF(subscription_state_t);
+    PRINTSIZEOF(subscription_t);
+    PRINTSIZEOF(trace_column_t);
+    PRINTSIZEOF(trace_header_t);
+    PRINTSIZEOF(trace_record_t);
     PRINTSIZEOF(tumbleweed_action_t);
     PRINTSIZEOF(tumbleweed_context_t);
     PRINTSIZEOF(tumbleweed_state_t);
+    PRINTSIZEOF(writer_slot_t);
+    PRINTSIZEOF(writer_t);
     PRINTSIZEOF(yodel_action_t);
     PRINTSIZEOF(yodel_context_t);
     PRINTSIZEOF(yodel_id_t);
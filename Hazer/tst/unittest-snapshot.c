@@ -0,0 +1,161 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Snapshot unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * A writer thread publishes fixes in which every field it touches carries
+ * the same counter while the main thread reads them back through its own
+ * read-only mapping; any torn copy would show two different counters.
+ */
+
+#include <stdio.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "com/diag/hazer/snapshot.h"
+
+static const uint32_t LIMIT = 100000;
+
+static const int SPIN = 1000;
+
+static char name[64];
+
+static void * writer(void * argp)
+{
+    snapshot_region_t * rp = (snapshot_region_t *)argp;
+    uint32_t counter = 0;
+    int ii = 0;
+    volatile int spin = 0;
+
+    for (counter = 1; counter <= LIMIT; ++counter) {
+        snapshot_begin(rp);
+            for (ii = 0; ii < HAZER_SYSTEM_TOTAL; ++ii) {
+                rp->fix.positions[ii].tot_nanoseconds = counter;
+                rp->fix.positions[ii].label = "LABEL";
+            }
+            rp->fix.posveltim.iTOW = counter;
+            rp->fix.attitude.iTOW = counter;
+        snapshot_end(rp);
+        for (spin = 0; spin < SPIN; ++spin) {
+            /* Give the reader a window between epochs. */
+        }
+    }
+
+    return (void *)0;
+}
+
+int main(void)
+{
+    {
+        assert((sizeof(snapshot_region_t) % 8) == 0);
+        assert((sizeof(snapshot_fix_t) % 8) == 0);
+        assert(sizeof(snapshot_band_t) == 4);
+    }
+
+    snprintf(name, sizeof(name), "/unittest-snapshot-%d", getpid());
+
+    {
+        snapshot_region_t * rp = (snapshot_region_t *)0;
+        const snapshot_region_t * cp = (const snapshot_region_t *)0;
+        snapshot_fix_t fix;
+        uint32_t sequence = 0;
+
+        errno = 0;
+        assert(snapshot_open(name) == (const snapshot_region_t *)0);
+        assert(errno == ENOENT);
+
+        rp = snapshot_create(name);
+        assert(rp != (snapshot_region_t *)0);
+        assert(rp->magic == SNAPSHOT_MAGIC);
+        assert(rp->version == SNAPSHOT_VERSION);
+        assert(rp->size == sizeof(snapshot_region_t));
+        assert((rp->sequence & 1) == 0);
+
+        cp = snapshot_open(name);
+        assert(cp != (const snapshot_region_t *)0);
+        assert(cp != rp);
+
+        assert(snapshot_read(cp, &fix, &sequence) == 0);
+        assert(sequence == rp->sequence);
+        assert(fix.positions[0].tot_nanoseconds == 0);
+
+        /*
+         * An update in progress cannot be read.
+         */
+
+        snapshot_begin(rp);
+        errno = 0;
+        assert(snapshot_read(cp, &fix, (uint32_t *)0) < 0);
+        assert(errno == EAGAIN);
+        snapshot_end(rp);
+        assert(snapshot_read(cp, &fix, (uint32_t *)0) == 0);
+
+        /*
+         * A reader rejects a region with a different layout.
+         */
+
+        rp->version += 1;
+        errno = 0;
+        assert(snapshot_open(name) == (const snapshot_region_t *)0);
+        assert(errno == EPROTO);
+        rp->version -= 1;
+
+        assert(snapshot_close(cp) == (const snapshot_region_t *)0);
+        assert(snapshot_destroy(rp, name) == (snapshot_region_t *)0);
+    }
+
+    {
+        snapshot_region_t * rp = (snapshot_region_t *)0;
+        const snapshot_region_t * cp = (const snapshot_region_t *)0;
+        snapshot_fix_t fix;
+        pthread_t thread;
+        uint32_t sequence = 0;
+        uint32_t prior = 0;
+        uint64_t last = 0;
+        uint64_t reads = 0;
+        uint64_t retries = 0;
+        int ii = 0;
+
+        rp = snapshot_create(name);
+        assert(rp != (snapshot_region_t *)0);
+        cp = snapshot_open(name);
+        assert(cp != (const snapshot_region_t *)0);
+
+        assert(pthread_create(&thread, (const pthread_attr_t *)0, writer, rp) == 0);
+
+        while (last < LIMIT) {
+            if (snapshot_read(cp, &fix, &sequence) < 0) {
+                retries += 1;
+                continue;
+            }
+            reads += 1;
+            assert((sequence & 1) == 0);
+            assert(sequence >= prior);
+            prior = sequence;
+            for (ii = 0; ii < HAZER_SYSTEM_TOTAL; ++ii) {
+                assert(fix.positions[ii].tot_nanoseconds == fix.posveltim.iTOW);
+                assert(fix.positions[ii].label == (const char *)0);
+            }
+            assert(fix.attitude.iTOW == fix.posveltim.iTOW);
+            assert(fix.posveltim.iTOW >= last);
+            last = fix.posveltim.iTOW;
+        }
+
+        assert(pthread_join(thread, (void **)0) == 0);
+        assert(reads > 1);
+
+        fprintf(stderr, "%s: reads=%llu retries=%llu\n", __FILE__, (unsigned long long)reads, (unsigned long long)retries);
+
+        assert(snapshot_close(cp) == (const snapshot_region_t *)0);
+        assert(snapshot_destroy(rp, name) == (snapshot_region_t *)0);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
@@ -0,0 +1,202 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Statistics unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include "com/diag/hazer/statistics.h"
+
+enum {
+    COUNT = 1000000,
+    PARTS = 7,
+};
+
+static double values[COUNT];
+static double sorted[COUNT];
+
+static uint32_t seed = 1;
+
+static double noise(void)
+{
+    seed = (seed * 1103515245UL) + 12345UL;
+    return ((seed >> 1) & 0x7fffffff) / 2147483648.0;
+}
+
+static int compare(const void * ap, const void * bp)
+{
+    double aa = *(const double *)ap;
+    double bb = *(const double *)bp;
+
+    return (aa < bb) ? -1 : (aa > bb) ? 1 : 0;
+}
+
+/*
+ * Return how far, as a fraction of all of the values, the rank of an
+ * estimate is from the rank that was asked for.
+ */
+static double error(double estimate, double percentile)
+{
+    size_t low = 0;
+    size_t high = COUNT;
+    size_t middle = 0;
+
+    while (low < high) {
+        middle = low + ((high - low) / 2);
+        if (sorted[middle] < estimate) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    return fabs(((double)low / COUNT) - (percentile / 100.0));
+}
+
+int main(void)
+{
+    static const double PERCENTILES[] = { 1.0, 5.0, 10.0, 25.0, 50.0, 75.0, 90.0, 95.0, 99.0, 99.9, };
+    statistics_t whole;
+    statistics_t part[PARTS];
+    statistics_t merged;
+    long double sum = 0.0;
+    double mean = 0.0;
+    double variance = 0.0;
+    double estimate = 0.0;
+    double worst = 0.0;
+    size_t ii = 0;
+    size_t jj = 0;
+
+    /*
+     * Values like the local clock in a trace: large, and differing only in
+     * their fractions, which defeats summing squares.
+     */
+
+    for (ii = 0; ii < COUNT; ++ii) {
+        values[ii] = 1599145249.0 + (noise() * 100.0);
+    }
+    memcpy(sorted, values, sizeof(sorted));
+    qsort(sorted, COUNT, sizeof(sorted[0]), compare);
+
+    for (ii = 0, sum = 0.0; ii < COUNT; ++ii) {
+        sum += values[ii];
+    }
+    mean = sum / COUNT;
+    for (ii = 0, sum = 0.0; ii < COUNT; ++ii) {
+        sum += (values[ii] - mean) * (values[ii] - mean);
+    }
+    variance = sum / (COUNT - 1);
+
+    {
+        statistics_init(&whole);
+        assert(whole.count == 0);
+        assert(statistics_variance(&whole) == 0.0);
+        assert(statistics_percentile(&whole, 50.0) == 0.0);
+        assert(statistics_add(&whole, 3.0) == 0);
+        assert(statistics_add(&whole, 1.0) == 0);
+        assert(statistics_add(&whole, 2.0) == 0);
+        assert(whole.count == 3);
+        assert(whole.minimum == 1.0);
+        assert(whole.maximum == 3.0);
+        assert(whole.mean == 2.0);
+        assert(statistics_variance(&whole) == 1.0);
+        assert(statistics_percentile(&whole, 0.0) == 1.0);
+        assert(statistics_percentile(&whole, 50.0) == 2.0);
+        assert(statistics_percentile(&whole, 100.0) == 3.0);
+        statistics_fini(&whole);
+        assert(whole.count == 0);
+    }
+
+    {
+        statistics_init(&whole);
+        for (ii = 0; ii < COUNT; ++ii) {
+            assert(statistics_add(&whole, values[ii]) == 0);
+        }
+        fprintf(stderr, "%s: count=%llu mean=%.9f/%.9f variance=%.9f/%.9f\n", __FILE__, (unsigned long long)whole.count, whole.mean, mean, statistics_variance(&whole), variance);
+        assert(whole.count == COUNT);
+        assert(whole.minimum == sorted[0]);
+        assert(whole.maximum == sorted[COUNT - 1]);
+        assert(fabs(whole.mean - mean) < (mean * 1e-12));
+        assert(fabs(statistics_variance(&whole) - variance) < (variance * 1e-9));
+        for (jj = 0; jj < (sizeof(PERCENTILES) / sizeof(PERCENTILES[0])); ++jj) {
+            estimate = statistics_percentile(&whole, PERCENTILES[jj]);
+            fprintf(stderr, "%s: whole p%g=%.9f error=%.6f\n", __FILE__, PERCENTILES[jj], estimate, error(estimate, PERCENTILES[jj]));
+            if (error(estimate, PERCENTILES[jj]) > worst) {
+                worst = error(estimate, PERCENTILES[jj]);
+            }
+        }
+        assert(worst < 0.005);
+    }
+
+    /*
+     * Statistics accumulated over parts of different sizes and merged are
+     * the same as those accumulated over the whole, but for rounding and
+     * the estimates of the percentiles.
+     */
+
+    {
+        for (jj = 0; jj < PARTS; ++jj) {
+            statistics_init(&(part[jj]));
+        }
+        for (ii = 0; ii < COUNT; ++ii) {
+            jj = (ii < (COUNT / 2)) ? 0 : (1 + (ii % (PARTS - 1)));
+            assert(statistics_add(&(part[jj]), values[ii]) == 0);
+        }
+        statistics_init(&merged);
+        for (jj = 0; jj < PARTS; ++jj) {
+            assert(statistics_merge(&merged, &(part[jj])) == 0);
+        }
+        fprintf(stderr, "%s: count=%llu mean=%.9f variance=%.9f\n", __FILE__, (unsigned long long)merged.count, merged.mean, statistics_variance(&merged));
+        assert(merged.count == COUNT);
+        assert(merged.minimum == whole.minimum);
+        assert(merged.maximum == whole.maximum);
+        assert(fabs(merged.mean - mean) < (mean * 1e-12));
+        assert(fabs(statistics_variance(&merged) - variance) < (variance * 1e-9));
+        worst = 0.0;
+        for (jj = 0; jj < (sizeof(PERCENTILES) / sizeof(PERCENTILES[0])); ++jj) {
+            estimate = statistics_percentile(&merged, PERCENTILES[jj]);
+            fprintf(stderr, "%s: merged p%g=%.9f error=%.6f\n", __FILE__, PERCENTILES[jj], estimate, error(estimate, PERCENTILES[jj]));
+            if (error(estimate, PERCENTILES[jj]) > worst) {
+                worst = error(estimate, PERCENTILES[jj]);
+            }
+        }
+        assert(worst < 0.005);
+        for (jj = 0; jj < PARTS; ++jj) {
+            statistics_fini(&(part[jj]));
+        }
+        statistics_fini(&merged);
+    }
+
+    /*
+     * Merging nothing changes nothing, and merging into nothing copies.
+     */
+
+    {
+        statistics_init(&merged);
+        statistics_init(&(part[0]));
+        assert(statistics_merge(&whole, &(part[0])) == 0);
+        assert(whole.count == COUNT);
+        assert(statistics_merge(&merged, &whole) == 0);
+        assert(merged.count == whole.count);
+        assert(merged.minimum == whole.minimum);
+        assert(merged.maximum == whole.maximum);
+        assert(merged.mean == whole.mean);
+        assert(merged.m2 == whole.m2);
+        assert(statistics_percentile(&merged, 50.0) == statistics_percentile(&whole, 50.0));
+        statistics_fini(&merged);
+        statistics_fini(&whole);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
@@ -0,0 +1,190 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Subscription unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include "com/diag/hazer/subscription.h"
+#include "com/diag/hazer/tumbleweed.h"
+
+int main(void)
+{
+    {
+        subscription_t subscription = SUBSCRIPTION_INITIALIZER;
+
+        assert(subscription_parse("1005:10,1074,1094 1230:5", &subscription) == 0);
+        assert(subscription.rules == 4);
+        assert(subscription.rule[0].number == 1005);
+        assert(subscription.rule[0].interval == 10);
+        assert(subscription.rule[1].number == 1074);
+        assert(subscription.rule[1].interval == 0);
+        assert(subscription.rule[2].number == 1094);
+        assert(subscription.rule[3].number == 1230);
+        assert(subscription.rule[3].interval == 5);
+
+        assert(subscription_parse("1005:20", &subscription) == 0);
+        assert(subscription.rules == 4);
+        assert(subscription.rule[0].interval == 20);
+
+        assert(subscription_parse("4096", &subscription) < 0);
+        assert(subscription_parse("1005:", &subscription) < 0);
+        assert(subscription_parse("1005x", &subscription) < 0);
+        assert(subscription_parse("1005:65536", &subscription) < 0);
+    }
+
+    {
+        subscription_t subscription = SUBSCRIPTION_INITIALIZER;
+        char string[256] = { '\0', };
+        int ii = 0;
+
+        for (ii = 0; ii < SUBSCRIPTION_RULES; ++ii) {
+            snprintf(string, sizeof(string), "%d", 1000 + ii);
+            assert(subscription_parse(string, &subscription) == 0);
+        }
+        assert(subscription.rules == SUBSCRIPTION_RULES);
+        assert(subscription_parse("1000", &subscription) == 0);
+        errno = 0;
+        assert(subscription_parse("2000", &subscription) < 0);
+        assert(errno == E2BIG);
+    }
+
+    {
+        subscription_t subscription = SUBSCRIPTION_INITIALIZER;
+        subscription_state_t state;
+
+        subscription_reset(&state);
+
+        assert(subscription_admit(&subscription, &state, 1005, 0));
+        assert(subscription_admit(&subscription, &state, 1074, 0));
+        assert(subscription_admit(&subscription, &state, 1005, 0));
+
+        assert(subscription_parse("1005:10,1074", &subscription) == 0);
+
+        assert(subscription_admit(&subscription, &state, 1005, 100));
+        assert(!subscription_admit(&subscription, &state, 1005, 101));
+        assert(!subscription_admit(&subscription, &state, 1005, 109));
+        assert(subscription_admit(&subscription, &state, 1005, 110));
+        assert(!subscription_admit(&subscription, &state, 1005, 110));
+        assert(subscription_admit(&subscription, &state, 1074, 110));
+        assert(subscription_admit(&subscription, &state, 1074, 110));
+        assert(!subscription_admit(&subscription, &state, 1094, 110));
+        assert(subscription_admit(&subscription, &state, -1, 110));
+
+        subscription_reset(&state);
+        assert(subscription_admit(&subscription, &state, 1005, 111));
+    }
+
+    {
+        subscription_t subscription = SUBSCRIPTION_INITIALIZER;
+        subscription_t decoded = SUBSCRIPTION_INITIALIZER;
+        uint8_t buffer[SUBSCRIPTION_LONGEST] = { 0, };
+        ssize_t length = 0;
+
+        assert(subscription_parse("1005:10,1074,1094,1230:5", &subscription) == 0);
+        assert((length = subscription_encode(&subscription, buffer, sizeof(buffer))) == (3 + 2 + 4 + 1 + 16 + 3));
+        assert(tumbleweed_validate(buffer, length) == length);
+        assert(tumbleweed_message(buffer, length) == SUBSCRIPTION_NUMBER);
+        assert(subscription_decode(buffer, length, &decoded) == 0);
+        assert(memcmp(&subscription, &decoded, sizeof(subscription)) == 0);
+
+        assert(subscription_encode(&subscription, buffer, length - 1) < 0);
+        assert(subscription_decode(buffer, length - 1, &decoded) < 0);
+        assert(subscription_decode(TUMBLEWEED_KEEPALIVE, sizeof(TUMBLEWEED_KEEPALIVE), &decoded) < 0);
+
+        buffer[6] = 'X';
+        assert(subscription_decode(buffer, length, &decoded) < 0);
+    }
+
+    {
+        subscription_t subscription = SUBSCRIPTION_INITIALIZER;
+        subscription_t decoded = SUBSCRIPTION_INITIALIZER;
+        uint8_t buffer[SUBSCRIPTION_LONGEST] = { 0, };
+        ssize_t length = 0;
+        int ii = 0;
+
+        for (ii = 0; ii < SUBSCRIPTION_RULES; ++ii) {
+            subscription.rule[ii].number = 1000 + ii;
+            subscription.rule[ii].interval = ii;
+        }
+        subscription.rules = SUBSCRIPTION_RULES;
+
+        assert((length = subscription_encode(&subscription, buffer, sizeof(buffer))) == SUBSCRIPTION_LONGEST);
+        assert(tumbleweed_validate(buffer, length) == length);
+        assert(subscription_decode(buffer, length, &decoded) == 0);
+        assert(memcmp(&subscription, &decoded, sizeof(subscription)) == 0);
+    }
+
+    {
+        static const char TEXT[] =
+            "# ADDRESS PORT RULE...\n"
+            "\n"
+            "192.168.1.10 0 1005:10 1230:10\n"
+            "2001:db8::1 21010 1005:10 1074 1094   # Comment.\n"
+            "2001:db8::1 0 1005\n";
+        static const uint16_t ADDRESS4[8] = { 0, 0, 0, 0, 0, 0xffff, 0xc0a8, 0x010a, };
+        static const uint16_t ADDRESS6[8] = { 0x2001, 0x0db8, 0, 0, 0, 0, 0, 1, };
+        static const uint16_t ADDRESS0[8] = { 0x2001, 0x0db8, 0, 0, 0, 0, 0, 2, };
+        char path[] = "/tmp/unittest-subscription-XXXXXX";
+        subscription_entry_t * entries = (subscription_entry_t *)0;
+        const subscription_t * sp = (const subscription_t *)0;
+        ssize_t count = 0;
+        unsigned int line = 0;
+        FILE * fp = (FILE *)0;
+        int fd = -1;
+
+        assert((fd = mkstemp(path)) >= 0);
+        assert((fp = fdopen(fd, "w")) != (FILE *)0);
+        assert(fputs(TEXT, fp) >= 0);
+        assert(fclose(fp) == 0);
+
+        assert((count = subscription_load(path, &entries, &line)) == 3);
+        assert(line == 0);
+
+        assert((sp = subscription_lookup(entries, count, ADDRESS4, 1234)) != (const subscription_t *)0);
+        assert(sp->rules == 2);
+        assert(sp->rule[1].number == 1230);
+
+        assert((sp = subscription_lookup(entries, count, ADDRESS6, 21010)) != (const subscription_t *)0);
+        assert(sp->rules == 3);
+
+        assert((sp = subscription_lookup(entries, count, ADDRESS6, 21011)) != (const subscription_t *)0);
+        assert(sp->rules == 1);
+
+        assert(subscription_lookup(entries, count, ADDRESS0, 21010) == (const subscription_t *)0);
+
+        free(entries);
+
+        assert((fp = fopen(path, "w")) != (FILE *)0);
+        assert(fputs("192.168.1.10 0 1005\nbogus 0 1005\n", fp) >= 0);
+        assert(fclose(fp) == 0);
+
+        errno = 0;
+        assert(subscription_load(path, &entries, &line) < 0);
+        assert(errno == EINVAL);
+        assert(line == 2);
+
+        assert(unlink(path) == 0);
+
+        assert(subscription_load(path, &entries, &line) < 0);
+        assert(errno == ENOENT);
+        assert(line == 0);
+
+        assert(subscription_load(path, &entries, (unsigned int *)0) < 0);
+        assert(errno == ENOENT);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
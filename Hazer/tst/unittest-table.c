@@ -0,0 +1,291 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the rtktool Table unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ * The client table is part of rtktool rather than the library, so the
+ * Makefile links this test with app/rtktool/table.c. Random insert, find,
+ * touch, remove, and expire operations are checked against a simple model
+ * of the table, which is audited along the way. At the end, the table work
+ * that rtktool does for ten thousand rovers each sending a keepalive once
+ * a second is timed on one core. That is the table alone; it does not
+ * include the socket I/O that rtkload exercises against a running router.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <assert.h>
+#include "../app/rtktool/table.h"
+
+enum {
+    CLIENTS = 10000,
+    ADDRESSES = CLIENTS * 2,
+    TIMEOUT = 30,
+    OPERATIONS = 1000000,
+    AUDITS = 997,
+    SECONDS = 60,
+};
+
+typedef struct Model {
+    client_t * clientp;
+    diminuto_ipv6_t address;
+    diminuto_port_t port;
+    long last;
+} model_t;
+
+static model_t model[ADDRESSES];
+
+static model_t * owner[CLIENTS];
+
+static uint32_t seed = 1;
+
+static uint32_t random32(void)
+{
+    seed = (seed * 1103515245UL) + 12345UL;
+    return (seed >> 8) & 0xffffff;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + (ts.tv_nsec / 1000000000.0);
+}
+
+int main(void)
+{
+    table_t table;
+    unsigned int ii = 0;
+
+    {
+        /*
+         * Addresses that differ only a little, and ports that are shared,
+         * so that hashes crowd together.
+         */
+
+        for (ii = 0; ii < ADDRESSES; ++ii) {
+            memset(&(model[ii].address), 0, sizeof(model[ii].address));
+            model[ii].address.u16[0] = 0xfd00;
+            model[ii].address.u16[7] = ii / 4;
+            model[ii].port = 2101 + (ii % 4);
+            model[ii].clientp = (client_t *)0;
+        }
+    }
+
+    {
+        assert(table_init(&table, CLIENTS, TIMEOUT, 0) == &table);
+        assert(table.active == 0);
+        assert(table.rovers == 0);
+        assert((table.slots & (table.slots - 1)) == 0);
+        assert(table.slots >= (CLIENTS * 2));
+        assert(table_audit(&table) == 0);
+        assert(table_find(&table, &(model[0].address), model[0].port) == (client_t *)0);
+        assert(table_expire(&table, TIMEOUT * 10) == (client_t *)0);
+        table_fini(&table);
+    }
+
+    {
+        client_t * cp = (client_t *)0;
+
+        /*
+         * Fill the pool, then overflow it.
+         */
+
+        assert(table_init(&table, CLIENTS, TIMEOUT, 0) == &table);
+        for (ii = 0; ii < CLIENTS; ++ii) {
+            assert((cp = table_insert(&table, &(model[ii].address), model[ii].port, ((ii % 10) == 0) ? BASE : ROVER, 0)) != (client_t *)0);
+        }
+        assert(table.active == CLIENTS);
+        assert(table.rovers == (CLIENTS - (CLIENTS / 10)));
+        assert(table_insert(&table, &(model[CLIENTS].address), model[CLIENTS].port, ROVER, 0) == (client_t *)0);
+        assert(table_audit(&table) == 0);
+        for (ii = 0; ii < CLIENTS; ++ii) {
+            assert((cp = table_find(&table, &(model[ii].address), model[ii].port)) != (client_t *)0);
+            assert(cp->port == model[ii].port);
+            assert(memcmp(&(cp->address), &(model[ii].address), sizeof(cp->address)) == 0);
+        }
+        assert(table_find(&table, &(model[CLIENTS].address), model[CLIENTS].port) == (client_t *)0);
+
+        /*
+         * Nothing expires until the timeout has passed, then everything does.
+         */
+
+        assert(table_expire(&table, TIMEOUT) == (client_t *)0);
+        for (ii = 0; (cp = table_expire(&table, TIMEOUT + 1)) != (client_t *)0; ++ii) {
+            table_remove(&table, cp);
+        }
+        assert(ii == CLIENTS);
+        assert(table.active == 0);
+        assert(table.rovers == 0);
+        assert(table_audit(&table) == 0);
+        table_fini(&table);
+    }
+
+    {
+        client_t * cp = (client_t *)0;
+        model_t * mp = (model_t *)0;
+        long second = 0;
+        unsigned int operation = 0;
+        unsigned int active = 0;
+        unsigned int expired = 0;
+        unsigned int exhausted = 0;
+
+        /*
+         * Random operations against the model, with the clock advancing
+         * now and then, sometimes by more than a revolution of the wheel.
+         */
+
+        assert(table_init(&table, CLIENTS, TIMEOUT, second) == &table);
+
+        for (operation = 0; operation < OPERATIONS; ++operation) {
+
+            mp = &(model[random32() % ADDRESSES]);
+
+            switch (random32() % 8) {
+
+            case 0:
+            case 1:
+                cp = table_find(&table, &(mp->address), mp->port);
+                assert(cp == mp->clientp);
+                if (cp != (client_t *)0) {
+                    /* Do nothing. */
+                } else if ((cp = table_insert(&table, &(mp->address), mp->port, ((random32() % 4) == 0) ? BASE : ROVER, second)) == (client_t *)0) {
+                    assert(active == CLIENTS);
+                    exhausted += 1;
+                } else {
+                    mp->clientp = cp;
+                    mp->last = second;
+                    owner[cp - table.pool] = mp;
+                    active += 1;
+                }
+                break;
+
+            case 2:
+            case 3:
+            case 4:
+                cp = table_find(&table, &(mp->address), mp->port);
+                assert(cp == mp->clientp);
+                if (cp != (client_t *)0) {
+                    table_touch(&table, cp, second);
+                    mp->last = second;
+                }
+                break;
+
+            case 5:
+                if (mp->clientp != (client_t *)0) {
+                    table_remove(&table, mp->clientp);
+                    mp->clientp = (client_t *)0;
+                    active -= 1;
+                }
+                break;
+
+            case 6:
+                if ((random32() % 100000) == 0) {
+                    second += TIMEOUT * 20;
+                } else if ((random32() % 1000) == 0) {
+                    second += 1;
+                } else {
+                    /* Do nothing. */
+                }
+                while ((cp = table_expire(&table, second)) != (client_t *)0) {
+                    mp = owner[cp - table.pool];
+                    assert(mp->clientp == cp);
+                    assert((mp->last + TIMEOUT) < second);
+                    table_remove(&table, cp);
+                    mp->clientp = (client_t *)0;
+                    active -= 1;
+                    expired += 1;
+                }
+                break;
+
+            default:
+                assert(table_find(&table, &(mp->address), mp->port ^ 0x8000) == (client_t *)0);
+                break;
+
+            }
+
+            assert(table.active == active);
+
+            if ((operation % AUDITS) == 0) {
+                assert(table_audit(&table) == 0);
+                for (ii = 0; ii < ADDRESSES; ++ii) {
+                    if (model[ii].clientp == (client_t *)0) {
+                        assert(table_find(&table, &(model[ii].address), model[ii].port) == (client_t *)0);
+                    } else {
+                        assert((model[ii].last + TIMEOUT) >= table.now);
+                        assert(table_find(&table, &(model[ii].address), model[ii].port) == model[ii].clientp);
+                    }
+                }
+            }
+
+        }
+
+        assert(table_audit(&table) == 0);
+        assert(expired > 0);
+        assert(exhausted > 0);
+
+        fprintf(stderr, "%s: operations=%u active=%u expired=%u exhausted=%u seconds=%ld lookups=%llu probes=%llu\n", __FILE__, operation, active, expired, exhausted, second, (unsigned long long)table.lookups, (unsigned long long)table.probes);
+
+        table_fini(&table);
+    }
+
+    {
+        client_t * cp = (client_t *)0;
+        client_t * rp = (client_t *)0;
+        long second = 0;
+        double start = 0.0;
+        double elapsed = 0.0;
+        unsigned long forwarded = 0;
+        unsigned int jj = 0;
+
+        /*
+         * Ten thousand rovers each send a keepalive once a second, and a
+         * base sends a correction that is fanned out to all of them. This
+         * times the table work that rtktool does for that on one core.
+         */
+
+        assert(table_init(&table, CLIENTS + 1, TIMEOUT, second) == &table);
+        assert(table_insert(&table, &(model[CLIENTS].address), model[CLIENTS].port, BASE, second) != (client_t *)0);
+        for (ii = 0; ii < CLIENTS; ++ii) {
+            assert(table_insert(&table, &(model[ii].address), model[ii].port, ROVER, second) != (client_t *)0);
+        }
+        assert(table.rovers == CLIENTS);
+
+        start = now();
+        for (second = 1; second <= SECONDS; ++second) {
+            assert((cp = table_find(&table, &(model[CLIENTS].address), model[CLIENTS].port)) != (client_t *)0);
+            table_touch(&table, cp, second);
+            for (ii = 0; ii < CLIENTS; ++ii) {
+                assert((cp = table_find(&table, &(model[ii].address), model[ii].port)) != (client_t *)0);
+                table_touch(&table, cp, second);
+            }
+            for (jj = 0; jj < table.rovers; ++jj) {
+                rp = table.rover[jj];
+                forwarded += rp->port & 1;
+            }
+            assert(table_expire(&table, second) == (client_t *)0);
+        }
+        elapsed = now() - start;
+
+        assert(forwarded == ((unsigned long)SECONDS * (CLIENTS / 2)));
+        assert(table_audit(&table) == 0);
+        assert(table.active == (CLIENTS + 1));
+        assert(table.probes < (table.lookups * 2));
+
+        fprintf(stderr, "%s: rovers=%u seconds=%u elapsed=%.6fs perrover=%.0fns probes/lookup=%.3f\n", __FILE__, (unsigned int)CLIENTS, (unsigned int)SECONDS, elapsed, (elapsed * 1000000000.0) / ((double)CLIENTS * SECONDS), (double)table.probes / (double)table.lookups);
+
+        table_fini(&table);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
@@ -0,0 +1,424 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Trace unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <unistd.h>
+#include "com/diag/hazer/trace.h"
+
+typedef struct Tally {
+    int records;                    /* Records from CSV lines. */
+    int lines;                      /* CSV lines that were not records. */
+    int binaries;                   /* Records from a binary trace. */
+    int stop;                       /* Stop after this many calls or 0. */
+    int64_t sum;                    /* Sum of the NUM column. */
+} tally_t;
+
+static int tally(void * context, const trace_record_t * rp, const char * line)
+{
+    tally_t * tp = (tally_t *)context;
+
+    if (line == (const char *)0) {
+        assert(rp != (const trace_record_t *)0);
+        tp->binaries += 1;
+    } else if (rp == (const trace_record_t *)0) {
+        assert(line[strlen(line) - 1] == '\n');
+        tp->lines += 1;
+    } else {
+        assert(line[strlen(line) - 1] == '\n');
+        tp->records += 1;
+    }
+
+    if (rp != (const trace_record_t *)0) {
+        tp->sum += rp->value[TRACE_NUM];
+    }
+
+    return ((tp->stop > 0) && ((tp->records + tp->lines + tp->binaries) >= tp->stop)) ? 1 : 0;
+}
+
+int main(void)
+{
+    {
+        assert((sizeof(trace_header_t) % 8) == 0);
+        assert((sizeof(trace_record_t) % 8) == 0);
+        assert(strcmp(trace_heading(TRACE_NAM), "NAM") == 0);
+        assert(strcmp(trace_heading(TRACE_CLK), "CLK") == 0);
+        assert(strcmp(trace_heading(TRACE_MAC), "MAC") == 0);
+        assert(strcmp(trace_heading(TRACE_COLUMNS), "") == 0);
+    }
+
+    {
+        trace_record_t record;
+        char buffer[TRACE_LINE];
+        ssize_t length = 0;
+        int ii = 0;
+        static const char EXPECTED[] = "\"neon\", 0, 0, 0, 0, 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0, 0.\n";
+
+        /*
+         * A record with every column missing formats as gpstool would.
+         */
+
+        assert(trace_record_init(&record, "neon", 0) == &record);
+        assert(trace_format(&record, buffer, sizeof(buffer)) == (sizeof(EXPECTED) - 1));
+        assert(strcmp(buffer, EXPECTED) == 0);
+
+        /*
+         * Long names are truncated.
+         */
+
+        assert(trace_record_init(&record, "0123456789012345678901234567890123456789012345678901234567890123456789", TRACE_FLAG_HANGUP) == &record);
+        assert(strlen(record.name) == (TRACE_NAME - 1));
+        assert((length = trace_format(&record, buffer, sizeof(buffer))) > 0);
+        assert(strncmp(buffer, "\"012345678901234567890123456789012345678901234567890123456789012!\", ", TRACE_NAME + 4) == 0);
+
+        /*
+         * Buffers too small are reported.
+         */
+
+        errno = 0;
+        assert(trace_format(&record, buffer, TRACE_LINE - 1) < 0);
+        assert(errno == E2BIG);
+        assert(trace_format(&record, buffer, TRACE_LINE) == length);
+
+        /*
+         * The largest possible line fits.
+         */
+
+        for (ii = TRACE_NAM + 1; ii < TRACE_COLUMNS; ++ii) {
+            trace_record_set(&record, ii, INT64_MIN, (ii % 2) ? TRACE_INTEGER : TRACE_DIGITS);
+        }
+        assert((length = trace_format(&record, buffer, sizeof(buffer))) < sizeof(buffer));
+        assert(strstr(buffer, ", -9223372036854775808, -9.223372036854775808, ") != (char *)0);
+
+        /*
+         * Invalid digits are reported.
+         */
+
+        trace_record_set(&record, TRACE_MAC, 0, TRACE_DIGITS + 1);
+        errno = 0;
+        assert(trace_format(&record, buffer, sizeof(buffer)) < 0);
+        assert(errno == EINVAL);
+    }
+
+    {
+        trace_record_t record;
+        char buffer[TRACE_LINE];
+        static const char LINE[] = "\"neon!\", 2, 3, 0, 11, 1599145249.632000060, 1599145249.000000000, 39.7943071, -105.1533805, 0., 1708.0000, 1688.800, 0., 0.005000, 359.123456789, -0.50000, 1.00000, -179.99999, 0.10000, 0.20000, 0.30000, 0, 12.3456\n";
+
+        /*
+         * A line round trips exactly.
+         */
+
+        assert(trace_parse(&record, LINE) == 0);
+        assert(strcmp(record.name, "neon") == 0);
+        assert(record.flags == TRACE_FLAG_HANGUP);
+        assert(record.value[TRACE_NUM] == 2);
+        assert(record.digits[TRACE_NUM] == TRACE_INTEGER);
+        assert(record.value[TRACE_CLK] == 1599145249632000060LL);
+        assert(record.digits[TRACE_CLK] == 9);
+        assert(record.value[TRACE_LON] == -1051533805LL);
+        assert(record.digits[TRACE_LON] == 7);
+        assert(record.value[TRACE_HAC] == 0);
+        assert(record.digits[TRACE_HAC] == 0);
+        assert(record.value[TRACE_ROL] == -50000);
+        assert(record.digits[TRACE_ROL] == 5);
+        assert(record.value[TRACE_MAC] == 123456);
+        assert(record.digits[TRACE_MAC] == 4);
+
+        assert(trace_format(&record, buffer, sizeof(buffer)) == (sizeof(LINE) - 1));
+        assert(strcmp(buffer, LINE) == 0);
+    }
+
+    {
+        trace_record_t record;
+        char buffer[TRACE_LINE];
+        static const char MESSAGE[] = "\"neon#\", 2, 3, 0, 11, 0., 1599145249.000000000, 39.7943071, -105.1533805, 0., 1708.0000, 1688.800, 0., 0.005000, 0., 0., 0., 0., 0., 0., 0., 0, 0.\n";
+        static const char BOTH[] = "\"neon#!\", 2, 3, 0, 11, 0., 1599145249.000000000, 39.7943071, -105.1533805, 0., 1708.0000, 1688.800, 0., 0.005000, 0., 0., 0., 0., 0., 0., 0., 0, 0.\n";
+
+        /*
+         * A record decoded from a single message is marked after the name.
+         */
+
+        assert(trace_parse(&record, MESSAGE) == 0);
+        assert(strcmp(record.name, "neon") == 0);
+        assert(record.flags == TRACE_FLAG_MESSAGE);
+        assert(trace_format(&record, buffer, sizeof(buffer)) == (sizeof(MESSAGE) - 1));
+        assert(strcmp(buffer, MESSAGE) == 0);
+
+        assert(trace_parse(&record, BOTH) == 0);
+        assert(strcmp(record.name, "neon") == 0);
+        assert(record.flags == (TRACE_FLAG_MESSAGE | TRACE_FLAG_HANGUP));
+        assert(trace_format(&record, buffer, sizeof(buffer)) == (sizeof(BOTH) - 1));
+        assert(strcmp(buffer, BOTH) == 0);
+    }
+
+    {
+        trace_record_t record;
+
+        /*
+         * Headings and malformed lines are rejected.
+         */
+
+        errno = 0;
+        assert(trace_parse(&record, "NAM, NUM, FIX, SYS, SAT, CLK, TIM, LAT, LON, HAC, MSL, GEO, VAC, SOG, COG, ROL, PIT, YAW, RAC, PAC, YAC, OBS, MAC\n") < 0);
+        assert(errno == EINVAL);
+        assert(trace_parse(&record, "\"neon\", 2, 3, 0, 11\n") < 0);
+        assert(trace_parse(&record, "\"neon\", 2, 3, 0, 11, 1., 2., 3., 4., 5., 6., 7., 8., 9., 10., 11., 12., 13., 14., 15., 16., 0, 17., 18.\n") < 0);
+        assert(trace_parse(&record, "\"neon\", 2, 3, 0, X, 1., 2., 3., 4., 5., 6., 7., 8., 9., 10., 11., 12., 13., 14., 15., 16., 0, 17.\n") < 0);
+        assert(trace_parse(&record, "\"neon\", 2, 3, 0, 11, 99999999999999999999., 2., 3., 4., 5., 6., 7., 8., 9., 10., 11., 12., 13., 14., 15., 16., 0, 17.\n") < 0);
+        assert(trace_parse(&record, "\"neon, 2, 3, 0, 11\n") < 0);
+        assert(trace_parse(&record, "\"neon\", 2, 3, 0, 11, 1., 2., 3., 4., 5., 6., 7., 8., 9., 10., 11., 12., 13., 14., 15., 16., 0, 17.") == 0);
+        assert(record.value[TRACE_MAC] == 17);
+    }
+
+    {
+        /*
+         * Converting to a double is the same as parsing what is formatted.
+         */
+
+        assert(trace_number(397943071, 7) == 39.7943071);
+        assert(trace_number(-1051533805, 7) == -105.1533805);
+        assert(trace_number(1599145249632000060LL, 9) == 1599145249.632000060);
+        assert(trace_number(11, TRACE_INTEGER) == 11.0);
+        assert(trace_number(0, 0) == 0.0);
+    }
+
+    {
+        trace_header_t header;
+        trace_record_t records[3];
+        struct { trace_header_t header; trace_record_t records[3]; } file;
+        const trace_record_t * rp = (const trace_record_t *)0;
+        size_t count = 0;
+
+        /*
+         * A file in memory is checked and its records located.
+         */
+
+        assert(trace_header_init(&header) == &header);
+        assert(trace_header_check(&header) == 0);
+
+        memset(&file, 0, sizeof(file));
+        file.header = header;
+        trace_record_init(&(records[0]), "alpha", 0);
+        trace_record_init(&(records[1]), "beta", 0);
+        trace_record_init(&(records[2]), "gamma", 0);
+        trace_record_set(&(records[2]), TRACE_NUM, 3, TRACE_INTEGER);
+        memcpy(file.records, records, sizeof(records));
+
+        assert((rp = trace_records(&file, sizeof(file), &count)) != (const trace_record_t *)0);
+        assert(count == 3);
+        assert(strcmp(rp[0].name, "alpha") == 0);
+        assert(strcmp(rp[2].name, "gamma") == 0);
+        assert(rp[2].value[TRACE_NUM] == 3);
+
+        assert((rp = trace_records(&file, sizeof(file) - 1, &count)) != (const trace_record_t *)0);
+        assert(count == 2);
+
+        assert((rp = trace_records(&file, sizeof(header), &count)) != (const trace_record_t *)0);
+        assert(count == 0);
+
+        errno = 0;
+        assert(trace_records(&file, sizeof(header) - 1, &count) == (const trace_record_t *)0);
+        assert(errno == ENODATA);
+
+        file.header.order = 0x0201;
+        errno = 0;
+        assert(trace_records(&file, sizeof(file), &count) == (const trace_record_t *)0);
+        assert(errno == EPROTO);
+
+        file.header = header;
+        file.header.magic[0] = 'X';
+        errno = 0;
+        assert(trace_records(&file, sizeof(file), &count) == (const trace_record_t *)0);
+        assert(errno == EINVAL);
+
+        file.header = header;
+        file.header.version = TRACE_VERSION + 1;
+        errno = 0;
+        assert(trace_header_check(&(file.header)) < 0);
+        assert(errno == EPROTO);
+    }
+
+    {
+        static const char CSV[] =
+            "   NAM, NUM, FIX, SYS, SAT, CLK, TIM, LAT, LON, HAC, MSL, GEO, VAC, SOG, COG, ROL, PIT, YAW, RAC, PAC, YAC, OBS, MAC\n"
+            "\"neon\", 1, 3, 0, 12, 1.000000000, 0., 39.7943071, -105.1533805, 1.234, 1700.1234, 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0, 0.\n"
+            "\"neon\", 2, 3, 0, 12, 2.000000000, 0., 39.7943071, -105.1533805, 1.234, 1700.1234, 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0, 0.\n"
+            "\"neon\", 3, 3, 0, 12, 3.000000000, 0., 39.7943071, -105.1533805, 1.234, 1700.1234, 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0, 0.";
+        char junk[TRACE_LINE * 3];
+        trace_header_t header;
+        trace_record_t record;
+        trace_map_t map;
+        trace_kind_t kind = TRACE_EMPTY;
+        tally_t counts;
+        FILE * fp = (FILE *)0;
+        int fds[2] = { -1, -1, };
+        int ii = 0;
+
+        /*
+         * A CSV trace in memory, whose last line has no newline.
+         */
+
+        memset(&counts, 0, sizeof(counts));
+        assert(trace_lines(CSV, sizeof(CSV) - 1, tally, &counts) == 0);
+        assert(counts.records == 3);
+        assert(counts.lines == 1);
+        assert(counts.binaries == 0);
+        assert(counts.sum == 6);
+
+        memset(&counts, 0, sizeof(counts));
+        counts.stop = 2;
+        assert(trace_lines(CSV, sizeof(CSV) - 1, tally, &counts) == 1);
+        assert((counts.records + counts.lines) == 2);
+
+        /*
+         * A line too long to be a record is not one.
+         */
+
+        memset(junk, 'X', sizeof(junk));
+        junk[sizeof(junk) - 1] = '\n';
+        memset(&counts, 0, sizeof(counts));
+        assert(trace_lines(junk, sizeof(junk), tally, &counts) == 0);
+        assert(counts.lines == 1);
+        assert(counts.records == 0);
+
+        assert((fp = tmpfile()) != (FILE *)0);
+        assert(fwrite(junk, sizeof(junk), 1, fp) == 1);
+        assert(fwrite(CSV, sizeof(CSV) - 1, 1, fp) == 1);
+        rewind(fp);
+        memset(&counts, 0, sizeof(counts));
+        assert(trace_read(fp, tally, &counts, &kind) == 0);
+        assert(kind == TRACE_CSV);
+        assert(counts.lines == 2);
+        assert(counts.records == 3);
+        assert(fclose(fp) == 0);
+
+        /*
+         * A CSV trace in a file is mapped, and read if it is a stream.
+         */
+
+        assert((fp = tmpfile()) != (FILE *)0);
+        assert(fwrite(CSV, sizeof(CSV) - 1, 1, fp) == 1);
+        assert(fflush(fp) == 0);
+        rewind(fp);
+        assert(trace_map(&map, fileno(fp)) == &map);
+        assert(map.kind == TRACE_CSV);
+        assert(map.length == (sizeof(CSV) - 1));
+        assert(map.records == (const trace_record_t *)0);
+        memset(&counts, 0, sizeof(counts));
+        assert(trace_mapped(&map, tally, &counts) == 0);
+        assert(counts.records == 3);
+        trace_unmap(&map);
+        assert(map.base == (const char *)0);
+        memset(&counts, 0, sizeof(counts));
+        assert(trace_input(fp, tally, &counts, &kind) == 0);
+        assert(kind == TRACE_CSV);
+        assert(counts.records == 3);
+        assert(counts.lines == 1);
+        memset(&counts, 0, sizeof(counts));
+        kind = TRACE_EMPTY;
+        assert(trace_read(fp, tally, &counts, &kind) == 0);
+        assert(kind == TRACE_CSV);
+        assert(counts.records == 3);
+        assert(counts.lines == 1);
+        assert(counts.sum == 6);
+        assert(fclose(fp) == 0);
+
+        /*
+         * A binary trace in a file is mapped, and read if it is a stream.
+         */
+
+        assert((fp = tmpfile()) != (FILE *)0);
+        assert(fwrite(trace_header_init(&header), sizeof(header), 1, fp) == 1);
+        for (ii = 1; ii <= 4; ++ii) {
+            trace_record_init(&record, "tin", 0);
+            trace_record_set(&record, TRACE_NUM, ii, TRACE_INTEGER);
+            assert(fwrite(&record, sizeof(record), 1, fp) == 1);
+        }
+        assert(fwrite(&record, sizeof(record) / 2, 1, fp) == 1);
+        assert(fflush(fp) == 0);
+        rewind(fp);
+        assert(trace_map(&map, fileno(fp)) == &map);
+        assert(map.kind == TRACE_BINARY);
+        assert(map.count == 4);
+        assert(map.records[3].value[TRACE_NUM] == 4);
+        trace_unmap(&map);
+        memset(&counts, 0, sizeof(counts));
+        assert(trace_input(fp, tally, &counts, &kind) == 0);
+        assert(kind == TRACE_BINARY);
+        assert(counts.binaries == 4);
+        assert(counts.sum == 10);
+        memset(&counts, 0, sizeof(counts));
+        kind = TRACE_EMPTY;
+        assert(trace_read(fp, tally, &counts, &kind) == 0);
+        assert(kind == TRACE_BINARY);
+        assert(counts.binaries == 4);
+        assert(counts.sum == 10);
+        rewind(fp);
+        memset(&counts, 0, sizeof(counts));
+        counts.stop = 3;
+        assert(trace_read(fp, tally, &counts, (trace_kind_t *)0) == 1);
+        assert(counts.binaries == 3);
+
+        /*
+         * A binary trace with a header that cannot be read is an error.
+         */
+
+        rewind(fp);
+        header.order = 0x0201;
+        assert(fwrite(&header, sizeof(header), 1, fp) == 1);
+        assert(fflush(fp) == 0);
+        rewind(fp);
+        errno = 0;
+        assert(trace_map(&map, fileno(fp)) == (trace_map_t *)0);
+        assert(errno == EPROTO);
+        memset(&counts, 0, sizeof(counts));
+        errno = 0;
+        assert(trace_input(fp, tally, &counts, &kind) < 0);
+        assert(errno == EPROTO);
+        assert(counts.binaries == 0);
+        assert(fclose(fp) == 0);
+
+        /*
+         * An empty file, and a pipe, which cannot be mapped.
+         */
+
+        assert((fp = tmpfile()) != (FILE *)0);
+        assert(trace_map(&map, fileno(fp)) == &map);
+        assert(map.kind == TRACE_EMPTY);
+        trace_unmap(&map);
+        kind = TRACE_CSV;
+        assert(trace_input(fp, tally, &counts, &kind) == 0);
+        assert(kind == TRACE_EMPTY);
+        assert(fclose(fp) == 0);
+
+        assert(pipe(fds) == 0);
+        assert(write(fds[1], CSV, sizeof(CSV) - 1) == (sizeof(CSV) - 1));
+        assert(close(fds[1]) == 0);
+        errno = 0;
+        assert(trace_map(&map, fds[0]) == (trace_map_t *)0);
+        assert(errno == ENODEV);
+        assert((fp = fdopen(fds[0], "r")) != (FILE *)0);
+        memset(&counts, 0, sizeof(counts));
+        assert(trace_input(fp, tally, &counts, &kind) == 0);
+        assert(kind == TRACE_CSV);
+        assert(counts.records == 3);
+        assert(counts.lines == 1);
+        assert(fclose(fp) == 0);
+    }
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}
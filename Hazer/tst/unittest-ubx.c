@@ -134,6 +134,8 @@ int main(void)
         assert(sizeof(yodel_ubx_nav_att_t) == YODEL_UBX_NAV_ATT_Length);
         assert(sizeof(yodel_ubx_nav_odo_t) == YODEL_UBX_NAV_ODO_Length);
         assert(sizeof(yodel_ubx_nav_pvt_t) == YODEL_UBX_NAV_PVT_Length);
+        assert(sizeof(yodel_ubx_nav_timeutc_t) == YODEL_UBX_NAV_TIMEUTC_Length);
+        assert(sizeof(yodel_ubx_tim_tp_t) == YODEL_UBX_TIM_TP_Length);
     }
 
     /**************************************************************************/
@@ -374,6 +376,40 @@ int main(void)
         assert(yodel_ubx_rxm_rtcm(&data, message, size) == 0);
     END;
 
+    BEGIN("\\xb5\\x62\\x01\\x21\\x14\\x00\\x00\\x70\\x99\\x14\\x19\\x00\\x00\\x00\\x0c\\xfe\\xff\\xff\\xe8\\x07\\x02\\x03\\x04\\x05\\x06\\x07\\x7e\\xe2");
+        yodel_ubx_nav_timeutc_t data = YODEL_UBX_NAV_TIMEUTC_INITIALIZER;
+        fprintf(stderr, "\"%s\"[%zu]\n", string, length);
+        diminuto_dump(stderr, message, size);
+        assert(yodel_is_ubx_class_id(message, size, YODEL_UBX_NAV_TIMEUTC_Class, YODEL_UBX_NAV_TIMEUTC_Id));
+        assert(yodel_ubx_nav_timeutc(&data, message, size) == 0);
+        assert(data.iTOW == 345600000U);
+        assert(data.tAcc == 25);
+        assert(data.nano == -500);
+        assert(data.year == 2024);
+        assert(data.month == 2);
+        assert(data.day == 3);
+        assert(data.hour == 4);
+        assert(data.min == 5);
+        assert(data.second == 6);
+        assert(((data.valid >> YODEL_UBX_NAV_TIMEUTC_valid_validTOW_SHIFT) & YODEL_UBX_NAV_TIMEUTC_valid_validTOW_MASK) != 0);
+        assert(((data.valid >> YODEL_UBX_NAV_TIMEUTC_valid_validWKN_SHIFT) & YODEL_UBX_NAV_TIMEUTC_valid_validWKN_MASK) != 0);
+        assert(((data.valid >> YODEL_UBX_NAV_TIMEUTC_valid_validUTC_SHIFT) & YODEL_UBX_NAV_TIMEUTC_valid_validUTC_MASK) != 0);
+    END;
+
+    BEGIN("\\xb5\\x62\\x0d\\x01\\x10\\x00\\x00\\x70\\x99\\x14\\x00\\x00\\x00\\x80\\xfb\\xff\\xff\\xff\\xfc\\x08\\x03\\x00\\xba\\x7d");
+        yodel_ubx_tim_tp_t data = YODEL_UBX_TIM_TP_INITIALIZER;
+        fprintf(stderr, "\"%s\"[%zu]\n", string, length);
+        diminuto_dump(stderr, message, size);
+        assert(yodel_is_ubx_class_id(message, size, YODEL_UBX_TIM_TP_Class, YODEL_UBX_TIM_TP_Id));
+        assert(yodel_ubx_tim_tp(&data, message, size) == 0);
+        assert(data.towMS == 345600000U);
+        assert(data.towSubMS == 0x80000000U);
+        assert(data.qErr == -5);
+        assert(data.week == 2300);
+        assert(((data.flags >> YODEL_UBX_TIM_TP_flags_timeBase_SHIFT) & YODEL_UBX_TIM_TP_flags_timeBase_MASK) == YODEL_UBX_TIM_TP_flags_timeBase_UTC);
+        assert(((data.flags >> YODEL_UBX_TIM_TP_flags_utc_SHIFT) & YODEL_UBX_TIM_TP_flags_utc_MASK) != 0);
+    END;
+
     BEGIN("\\xb5b\\n6\\xa8\\0\\0\\x04\\0\\0\\0\\x01\\x05\\xff\\0\\x01\\0\\0\\xec8\\0\\0\\0\\x0e\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\x02\\0\\0H\\x8dV\\x01\\0\\t\\0\\0\\x80\\x1f\\xf2\\x03\\x05\\r\\0\\0\\xc1\\xdc\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\x1b\\0\\0\\0\\0\\x03\\0\\0\\x84\\xf5p\\0\\x014\\0\\0\\xc8\\x03\\0\\0\\0\\0\\0\\0C\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\x01\\x01\\0\\0>\\xff\\xf1\\x03\\0\\0\\0\\0\\x1e\\x1bP\\x01\\x06\\n\\0\\0Py\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0\\0~(");
         yodel_buffer_t temporary;
         yodel_ubx_mon_comms_t data = YODEL_UBX_MON_COMMS_INITIALIZER;
@@ -0,0 +1,254 @@
+/* vi: set ts=4 expandtab shiftwidth=4: */
+/**
+ * @file
+ * @copyright Copyright 2024 Digital Aggregates Corporation, Colorado, USA.
+ * @note Licensed under the terms in LICENSE.txt.
+ * @brief This is the Writer unit test.
+ * @author Chip Overclock <mailto:coverclock@diag.com>
+ * @see Hazer <https://github.com/coverclock/com-diag-hazer>
+ * @details
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include "com/diag/hazer/writer.h"
+
+static size_t slurp(const char * path, char * buffer, size_t size)
+{
+    FILE * fp = (FILE *)0;
+    size_t length = 0;
+
+    assert((fp = fopen(path, "r")) != (FILE *)0);
+    length = fread(buffer, 1, size, fp);
+    assert(fclose(fp) == 0);
+
+    return length;
+}
+
+static void snooze(long milliseconds)
+{
+    struct timespec duration = { milliseconds / 1000, (milliseconds % 1000) * 1000000L };
+
+    while (nanosleep(&duration, &duration) < 0) {
+        assert(errno == EINTR);
+    }
+}
+
+int main(void)
+{
+    char directory[] = "/tmp/unittest-writer-XXXXXX";
+    char path[sizeof(directory) + 16];
+    static char buffer[1 << 20];
+
+    assert(mkdtemp(directory) != (char *)0);
+    snprintf(path, sizeof(path), "%s/output", directory);
+
+    {
+        writer_t writer;
+        FILE * fp = (FILE *)0;
+
+        assert((fp = fopen(path, "w")) != (FILE *)0);
+
+        /*
+         * Invalid parameters.
+         */
+
+        errno = 0;
+        assert(writer_init(&writer, fp, 1, 16, 0) == (writer_t *)0);
+        assert(errno == EINVAL);
+        errno = 0;
+        assert(writer_init(&writer, fp, 2, 0, 0) == (writer_t *)0);
+        assert(errno == EINVAL);
+        errno = 0;
+        assert(writer_init(&writer, fp, 2, 16, -1) == (writer_t *)0);
+        assert(errno == EINVAL);
+        errno = 0;
+        assert(writer_append(&writer, "X", 1) < 0);
+        assert(errno == EBADF);
+
+        assert(fclose(fp) == 0);
+    }
+
+    {
+        writer_t writer;
+        FILE * fp = (FILE *)0;
+        char expected[32];
+        size_t total = 0;
+        size_t length = 0;
+        int ii = 0;
+
+        /*
+         * Everything appended is written in order, whether a buffer is
+         * handed off because it is full, because it is flushed, or because
+         * it is finalized.
+         */
+
+        assert((fp = fopen(path, "w")) != (FILE *)0);
+        assert(writer_init(&writer, fp, 4, 64, 0) == &writer);
+        assert(writer_depth(&writer) == 0);
+        assert(writer_flush(&writer) == 0);
+        assert(writer_service(&writer) == 0);
+
+        for (ii = 0; ii < 10000; ++ii) {
+            length = snprintf(expected, sizeof(expected), "%d\n", ii);
+            while (writer_depth(&writer) >= (writer.slots - 1)) {
+                snooze(1);
+            }
+            assert(writer_append(&writer, expected, length) == length);
+            total += length;
+            if ((ii % 1000) == 0) {
+                assert(writer_flush(&writer) > 0);
+            }
+        }
+
+        errno = 0;
+        assert(writer_append(&writer, buffer, 65) < 0);
+        assert(errno == EMSGSIZE);
+
+        assert(writer_fini(&writer) < 0);
+        assert(errno == ENOBUFS);
+        assert(writer_depth(&writer) == 0);
+        assert(writer.appended == total);
+        assert(writer.written == total);
+        assert(writer.dropped == 65);
+        assert(writer.drops == 1);
+        assert(writer.errors == 0);
+        assert(writer.handoffs > (total / 64));
+        assert(writer.deepest <= writer.slots);
+        assert(fclose(fp) == 0);
+
+        assert(slurp(path, buffer, sizeof(buffer)) == total);
+        for (ii = 0, length = 0; ii < 10000; ++ii) {
+            length += snprintf(expected, sizeof(expected), "%d\n", ii);
+        }
+        assert(length == total);
+        {
+            char * here = buffer;
+            for (ii = 0; ii < 10000; ++ii) {
+                length = snprintf(expected, sizeof(expected), "%d\n", ii);
+                assert(memcmp(here, expected, length) == 0);
+                here += length;
+            }
+        }
+    }
+
+    {
+        writer_t writer;
+        FILE * fp = (FILE *)0;
+
+        /*
+         * A buffer is only handed off for its latency once its oldest data
+         * has waited that long.
+         */
+
+        assert((fp = fopen(path, "w")) != (FILE *)0);
+        assert(writer_init(&writer, fp, 2, 64, 50000000LL) == &writer);
+        assert(writer_service(&writer) == 0);
+        assert(writer_append(&writer, "LATENCY\n", 8) == 8);
+        assert(writer_service(&writer) == 0);
+        snooze(100);
+        assert(writer_append(&writer, "LATER\n", 6) == 6);
+        assert(writer_service(&writer) > 0);
+        assert(writer_service(&writer) == 0);
+        while (writer.written < 14) {
+            snooze(1);
+        }
+        assert(slurp(path, buffer, sizeof(buffer)) == 14);
+        assert(memcmp(buffer, "LATENCY\nLATER\n", 14) == 0);
+        assert(writer_fini(&writer) == 0);
+        assert(fclose(fp) == 0);
+    }
+
+    {
+        writer_t writer;
+        int fds[2] = { -1, -1 };
+        FILE * fp = (FILE *)0;
+        char datum[16];
+        size_t total = 0;
+        size_t length = 0;
+        ssize_t rc = 0;
+        int ii = 0;
+        int jj = 0;
+        int kk = 0;
+
+        /*
+         * When the writer stalls, here because nothing is reading the
+         * pipe, the producer doesn't; it drops whole appends instead. What
+         * is written is still whole appends in order.
+         */
+
+        assert(pipe(fds) == 0);
+        assert((fp = fdopen(fds[1], "w")) != (FILE *)0);
+        assert(writer_init(&writer, fp, 2, 4096, 0) == &writer);
+
+        for (ii = 0; writer.drops == 0; ++ii) {
+            assert(ii < 1000000);
+            snprintf(datum, sizeof(datum), "%014d\n", ii);
+            (void)writer_append(&writer, datum, 15);
+        }
+
+        assert(writer.deepest == 2);
+        assert(writer.dropped == (writer.drops * 15));
+
+        assert(fcntl(fds[0], F_SETFL, O_NONBLOCK) == 0);
+        while ((rc = read(fds[0], buffer + total, sizeof(buffer) - total)) > 0) {
+            total += rc;
+        }
+        assert(writer_fini(&writer) < 0);
+        assert(errno == ENOBUFS);
+        assert(fclose(fp) == 0);
+        while ((rc = read(fds[0], buffer + total, sizeof(buffer) - total)) > 0) {
+            total += rc;
+        }
+        assert(close(fds[0]) == 0);
+
+        assert(total == writer.written);
+        assert(total == writer.appended);
+        assert((total % 15) == 0);
+        assert(((total / 15) + writer.drops) == ii);
+        for (jj = 0, kk = -1; jj < (total / 15); ++jj) {
+            length = strtol(&(buffer[jj * 15]), (char **)0, 10);
+            assert(buffer[(jj * 15) + 14] == '\n');
+            assert((int)length > kk);
+            kk = length;
+        }
+    }
+
+    {
+        writer_t writer;
+        FILE * fp = (FILE *)0;
+        FILE * sp = (FILE *)0;
+
+        /*
+         * A writer stream looks like any other stream, and closing it
+         * closes the underlying stream.
+         */
+
+        assert((fp = fopen(path, "w")) != (FILE *)0);
+        assert(writer_init(&writer, fp, 2, 64, 0) == &writer);
+        assert((sp = writer_stream(&writer)) != (FILE *)0);
+        assert(fprintf(sp, "%s %d\n", "STREAM", 1) == 9);
+        assert(fputc('2', sp) == '2');
+        assert(fwrite("\n", 1, 1, sp) == 1);
+        assert(fflush(sp) == 0);
+        assert(writer.appended == 11);
+        assert(fclose(sp) == 0);
+        assert(writer.written == 11);
+        assert(writer.fp == (FILE *)0);
+        assert(slurp(path, buffer, sizeof(buffer)) == 11);
+        assert(memcmp(buffer, "STREAM 1\n2\n", 11) == 0);
+    }
+
+    assert(unlink(path) == 0);
+    assert(rmdir(directory) == 0);
+
+    fprintf(stderr, "%s: SUCCESS.\n", __FILE__);
+
+    return 0;
+}